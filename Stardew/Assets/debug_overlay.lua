@@ -1,17 +1,55 @@
+-- number of the slowest profiler zones shown
+local NUM_PROFILER_ZONES_SHOWN = 4
+
+function GetProfilerFrameSummary()
+	-- only registered when the engine is built with the profiler
+	if not GetProfilerFrameStats then
+		return ""
+	end
+	local frame = GetProfilerFrameStats()
+	return string.format("frame:%.2fms draws:%d verts:%d entities:%d",
+		frame.frameMs, frame.DrawCalls, frame.VerticesDrawn, frame.EntitiesUpdated)
+end
+
+function GetProfilerZonesSummary()
+	if not GetProfilerZones then
+		return ""
+	end
+	local zones = GetProfilerZones()
+	table.sort(zones, function(a, b) return a.avgMs > b.avgMs end)
+	local summary = ""
+	for i = 1, math.min(#zones, NUM_PROFILER_ZONES_SHOWN) do
+		summary = summary .. string.format("%s:%.2fms ", zones[i].name, zones[i].avgMs)
+	end
+	return summary
+end
+
 function GetDebugOverlayViewModel()
 	return {
 		_debugString = "debug message goes here",
 		_debugStringListener = nil,
+		_profilerFrameString = "",
+		_profilerZonesString = "",
 		OnDebugMessagePublished = function(self, msg)
 			self._debugString = msg
 			OnPropertyChanged(self, "DebugString")
+			self._profilerFrameString = GetProfilerFrameSummary()
+			OnPropertyChanged(self, "ProfilerFrameString")
+			self._profilerZonesString = GetProfilerZonesSummary()
+			OnPropertyChanged(self, "ProfilerZonesString")
 		end,
 		Get_DebugString = function(self)
 			return self._debugString
 		end,
+		Get_ProfilerFrameString = function(self)
+			return self._profilerFrameString
+		end,
+		Get_ProfilerZonesString = function(self)
+			return self._profilerZonesString
+		end,
 		OnXMLUILayerPush = function(self)
 			self._debugStringListener = SubscribeGameFrameworkEvent("DebugMessage", self, self.OnDebugMessagePublished)
 			FireGameFrameworkEvent({vm=self, type="basic"}, "onDebugLayerPushed")
 		end
 	}
-end
\ No newline at end of file
+end
@@ -1,77 +1,52 @@
-#version 440 core
+#version 300 es
+
+// Vertex pulled tilemap chunks. The engine embeds this as tilemapVert in rendering/DrawContext.c,
+// keep the two in sync. Drawn with glDrawArrays(GL_TRIANGLES, 0, chunkSize.x * chunkSize.y * 6)
+// and no vertex buffer.
+
+precision highp float;
+precision highp int;
+precision highp usampler2D;
 
-layout (location = 0) in vec2 pos;
-layout (location = 1) in vec2 uv;
 out vec2 UV;
-uniform mat4 vpMatrix;
-uniform mat4 modelMatrix;
+uniform mat4 vp;
+// first tile of the chunk and its size in tiles
 uniform ivec2 chunkOffset;
 uniform ivec2 chunkSize;
-uniform usampler2D masterTileTexture;
-uniform UVLUT
+uniform vec2 tileSize;
+// layer position
+uniform vec2 origin;
+// R16UI, one texel per tile in the layer
+uniform usampler2D tileIndices;
+// top left uv, bottom right uv per tile index - TILEMAP_UV_TABLE_MAX_TILES entries
+layout(std140) uniform TilemapUVTable
 {
-	vec4 uvs[2048];
-} uvLut;
+	vec4 uvs[1024];
+};
 
-#define TILE_NUM_VERTS 4
-#define NUM_TILE_INDICES 6
+#define NUM_TILE_VERTS 6
 
-vec2 GetUV(int tileIndex, int quadIndex)
-{
-	vec4 uvTLBR = uvLut[tileIndex];
-	switch(quadIndex)
-	{
-	case 0:
-		return vec2(uvTLBR.xy);
-		break;
-	case 1:
-		return vec2(uvTLBR[2], vbTLBR[1]);
-		break;
-	case 2:
-		return vec2(uvTLBR.zw);
-		break;
-	case 3:
-		return vec2(uvTLBR[0], vbTLBR[3]);
-		break;
-	}
-	return vec2(0.0);
-}
+// two triangles, tl tr bl, tr br bl - the same winding as OutputSpriteVertices
+const ivec2 corners[NUM_TILE_VERTS] = ivec2[NUM_TILE_VERTS](
+	ivec2(0, 0), ivec2(1, 0), ivec2(0, 1),
+	ivec2(1, 0), ivec2(1, 1), ivec2(0, 1)
+);
 
 void main()
 {
+	// which tile in the chunk is being drawn?
+	int whichTile = gl_VertexID / NUM_TILE_VERTS;
+	ivec2 corner = corners[gl_VertexID % NUM_TILE_VERTS];
 
-	// vertices and indices that make up two triangles (a quad)
-	// ie one tile in the map
-	vec4 vertices[TILE_NUM_VERTS] = vec4[TILE_NUM_VERTS](
-		vec4(0.0f,  0.0f,   0.0f, 0.0f),
-		vec4(1.0f, 0.0f,   0.0f, 0.0f),
-		vec4(1.0f, 1.0f,  0.0f, 0.0f),
-		vec4(0.0f,  1.0f,  0.0f, 0.0f)
-	);
-	int indices[NUM_TILE_INDICES] = int[NUM_TILE_INDICES](
-	    0, 1, 3,   // first triangle
-        1, 2, 3    // second triangle
-	);
-
-
-	// cycle through indicies
-	int index = indices[int(gl_VertexID % NUM_TILE_INDICES)];
+	// row major within the chunk
+	ivec2 tileXY = chunkOffset + ivec2(whichTile % chunkSize.x, whichTile / chunkSize.x);
 
-	// get base vertex
-	vec4 baseVertex = vertices[index];
+	int tile = int(texelFetch(tileIndices, tileXY, 0).r);
+	vec4 uvTLBR = uvs[tile];
+	UV = mix(uvTLBR.xy, uvTLBR.zw, vec2(corner));
 
-	// which tile in the map is being drawn?
-	int whichTile = gl_VertexID / NUM_TILE_INDICES;
+	vec2 pos = origin + vec2(tileXY + corner) * tileSize;
 
-	// transfrom into x y coords of tile in the chunk
-	ivec2 tilexy = ivec2(int(whichTile / chunkSize.y), int(whichTile % chunkSize.y));
-
-	// translate base vertex by tilexy
-    baseVertex.xy += vec2(tilexy);
-
-
-    int texel = texelFetch(masterTileTexture, tilexy + chunkOffset, 0).r;
-    UV = GetUV(texel, index);
-    gl_Position = vpMatrix * modelMatrix * vec4(baseVertex.xy, 0.0, 1.0);
-
-}
\ No newline at end of file
+	// tile 0 is empty, put it outside the clip volume so its triangles are culled
+	gl_Position = tile == 0 ? vec4(0.0, 0.0, 2.0, 1.0) : vp * vec4(pos, 0.0, 1.0);
+}
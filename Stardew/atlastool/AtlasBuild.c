@@ -0,0 +1,686 @@
+#include "AtlasBuild.h"
+#include "Atlas.h"
+#include "ImageFileRegstry.h"
+#include "WorkerPool.h"
+#include "BinarySerializer.h"
+#include "FileHelpers.h"
+#include "DynArray.h"
+#include <libxml/tree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <direct.h>
+#define MakeDir(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MakeDir(path) mkdir(path, 0755)
+#endif
+
+/* bump when the cache or manifest layout, or how sprites and glyphs are produced, changes */
+#define AB_CACHE_VERSION 1
+#define AB_SPRITE_MAGIC 0x52505341 /* "ASPR" */
+#define AB_GLYPHS_MAGIC 0x594c4741 /* "AGLY" */
+#define AB_MANIFEST_MAGIC 0x4e414d41 /* "AMAN" */
+
+#define AB_MAX_PATH 1024
+
+/* a file the atlas is built from */
+struct BuildInput
+{
+	char* path;
+	u64 hash;
+	bool bReadable;
+};
+
+struct BuildSprite
+{
+	/* the image, index into inputs */
+	int input;
+	int x, y, w, h;
+	u64 key;
+	/* w * h RGBA pixels once prepared, NULL if they couldn't be */
+	u8* pixels;
+	bool bFromCache;
+};
+
+struct BuildFontSize
+{
+	int input;
+	float sizePts;
+	u64 key;
+	bool bLoaded;
+	bool bFromCache;
+	struct AtlasGlyphSet glyphs;
+};
+
+struct AtlasBuild
+{
+	char* outPath;
+	char* cacheDir;
+	u64 settingsHash;
+	struct WorkerPool* pPool;
+	/* inputs[0] is the xml file */
+	VECTOR(struct BuildInput) inputs;
+	VECTOR(struct BuildSprite) sprites;
+	VECTOR(struct BuildFontSize) fontSizes;
+	struct AtlasSourceProvider sources;
+};
+
+struct BuildJob
+{
+	struct AtlasBuild* pBuild;
+	int index;
+};
+
+u64 AB_HashBytes(const void* pData, size_t size, u64 hash)
+{
+	/* FNV-1a */
+	const u8* pBytes = pData;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static void CachePath(const struct AtlasBuild* pBuild, u64 key, const char* extension, char* pOutPath)
+{
+	snprintf(pOutPath, AB_MAX_PATH, "%s/%016llx.%s", pBuild->cacheDir, (unsigned long long)key, extension);
+}
+
+static char* CopyString(const char* str)
+{
+	char* pCopy = malloc(strlen(str) + 1);
+	strcpy(pCopy, str);
+	return pCopy;
+}
+
+static int FindOrAddInput(struct AtlasBuild* pBuild, const char* path)
+{
+	for (int i = 0; i < VectorSize(pBuild->inputs); i++)
+	{
+		if (strcmp(pBuild->inputs[i].path, path) == 0)
+		{
+			return i;
+		}
+	}
+	struct BuildInput input;
+	memset(&input, 0, sizeof(struct BuildInput));
+	input.path = CopyString(path);
+	pBuild->inputs = VectorPush(pBuild->inputs, &input);
+	return VectorSize(pBuild->inputs) - 1;
+}
+
+static bool GetIntProp(xmlNode* pNode, const char* name, int* pOutVal)
+{
+	xmlChar* attribute = xmlGetProp(pNode, name);
+	if (!attribute)
+	{
+		return false;
+	}
+	*pOutVal = atoi(attribute);
+	xmlFree(attribute);
+	return true;
+}
+
+/* sprites missing attributes are left for At_LoadAtlasEx to report */
+static void GatherSprite(struct AtlasBuild* pBuild, xmlNode* pNode)
+{
+	struct BuildSprite sprite;
+	memset(&sprite, 0, sizeof(struct BuildSprite));
+	if (!GetIntProp(pNode, "left", &sprite.x) || !GetIntProp(pNode, "top", &sprite.y) ||
+		!GetIntProp(pNode, "width", &sprite.w) || !GetIntProp(pNode, "height", &sprite.h))
+	{
+		return;
+	}
+	xmlChar* source = xmlGetProp(pNode, "source");
+	if (!source)
+	{
+		return;
+	}
+	sprite.input = FindOrAddInput(pBuild, source);
+	xmlFree(source);
+	pBuild->sprites = VectorPush(pBuild->sprites, &sprite);
+}
+
+static void GatherFont(struct AtlasBuild* pBuild, xmlNode* pNode)
+{
+	xmlChar* source = xmlGetProp(pNode, "source");
+	if (!source)
+	{
+		return;
+	}
+	int input = FindOrAddInput(pBuild, source);
+	xmlFree(source);
+	/* dynamic fonts are rasterised when the game uses them, there's nothing to rasterise up front */
+	xmlChar* dynamic = xmlGetProp(pNode, "dynamic");
+	bool bDynamic = dynamic && strcmp(dynamic, "true") == 0;
+	if (dynamic)
+	{
+		xmlFree(dynamic);
+	}
+	if (bDynamic)
+	{
+		return;
+	}
+	for (xmlNode* pChild = pNode->children; pChild; pChild = pChild->next)
+	{
+		if (pChild->type != XML_ELEMENT_NODE || strcmp(pChild->name, "size") != 0)
+		{
+			continue;
+		}
+		xmlChar* type = xmlGetProp(pChild, "type");
+		xmlChar* val = xmlGetProp(pChild, "val");
+		if (type && val && (strcmp(type, "pts") == 0 || strcmp(type, "pxls") == 0))
+		{
+			struct FontSize size;
+			size.type = strcmp(type, "pts") == 0 ? FOS_Pts : FOS_Pixels;
+			size.val = atof(val);
+			struct BuildFontSize fontSize;
+			memset(&fontSize, 0, sizeof(struct BuildFontSize));
+			fontSize.input = input;
+			fontSize.sizePts = At_FontSizeToPts(&size);
+			pBuild->fontSizes = VectorPush(pBuild->fontSizes, &fontSize);
+		}
+		if (type)
+		{
+			xmlFree(type);
+		}
+		if (val)
+		{
+			xmlFree(val);
+		}
+	}
+}
+
+static void GatherInputs(struct AtlasBuild* pBuild, xmlNode* pRoot)
+{
+	for (xmlNode* pChild = pRoot->children; pChild; pChild = pChild->next)
+	{
+		if (pChild->type != XML_ELEMENT_NODE)
+		{
+			continue;
+		}
+		if (strcmp(pChild->name, "sprite") == 0)
+		{
+			GatherSprite(pBuild, pChild);
+		}
+		else if (strcmp(pChild->name, "font") == 0)
+		{
+			GatherFont(pBuild, pChild);
+		}
+		else if (strcmp(pChild->name, "animation-frames") == 0)
+		{
+			for (xmlNode* pFrame = pChild->children; pFrame; pFrame = pFrame->next)
+			{
+				if (pFrame->type == XML_ELEMENT_NODE && strcmp(pFrame->name, "sprite") == 0)
+				{
+					GatherSprite(pBuild, pFrame);
+				}
+			}
+		}
+	}
+}
+
+static void HashInputJob(void* pArg)
+{
+	struct BuildJob* pJob = pArg;
+	struct BuildInput* pInput = &pJob->pBuild->inputs[pJob->index];
+	int size = 0;
+	char* pData = LoadFile(pInput->path, &size);
+	pInput->bReadable = pData != NULL;
+	pInput->hash = pData ? AB_HashBytes(pData, size, AB_HASH_SEED) : 0;
+	free(pData);
+}
+
+static void ComputeKeys(struct AtlasBuild* pBuild)
+{
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		struct BuildSprite* pSprite = &pBuild->sprites[i];
+		i64 rect[5] = { AB_CACHE_VERSION, pSprite->x, pSprite->y, pSprite->w, pSprite->h };
+		u64 key = AB_HashBytes(&pBuild->inputs[pSprite->input].hash, sizeof(u64), AB_HASH_SEED);
+		pSprite->key = AB_HashBytes(rect, sizeof(rect), key);
+	}
+	for (int i = 0; i < VectorSize(pBuild->fontSizes); i++)
+	{
+		struct BuildFontSize* pSize = &pBuild->fontSizes[i];
+		u64 key = AB_HashBytes(&pBuild->inputs[pSize->input].hash, sizeof(u64), AB_HASH_SEED);
+		i64 version = AB_CACHE_VERSION;
+		key = AB_HashBytes(&version, sizeof(i64), key);
+		pSize->key = AB_HashBytes(&pSize->sizePts, sizeof(float), key);
+	}
+}
+
+struct AtlasBuild* AB_Begin(xmlNode* pRoot, const char* xmlPath, const char* outPath, const char* cacheDir, u64 settingsHash, int numThreads)
+{
+	struct AtlasBuild* pBuild = malloc(sizeof(struct AtlasBuild));
+	memset(pBuild, 0, sizeof(struct AtlasBuild));
+	pBuild->outPath = CopyString(outPath);
+	pBuild->settingsHash = settingsHash;
+	if (cacheDir)
+	{
+		pBuild->cacheDir = CopyString(cacheDir);
+		/* fails harmlessly if it's already there */
+		MakeDir(cacheDir);
+	}
+	pBuild->pPool = WP_Create(numThreads);
+	pBuild->inputs = NEW_VECTOR(struct BuildInput);
+	pBuild->sprites = NEW_VECTOR(struct BuildSprite);
+	pBuild->fontSizes = NEW_VECTOR(struct BuildFontSize);
+
+	FindOrAddInput(pBuild, xmlPath);
+	GatherInputs(pBuild, pRoot);
+
+	int numInputs = VectorSize(pBuild->inputs);
+	struct BuildJob* pJobs = malloc(sizeof(struct BuildJob) * numInputs);
+	for (int i = 0; i < numInputs; i++)
+	{
+		pJobs[i].pBuild = pBuild;
+		pJobs[i].index = i;
+		WP_Submit(pBuild->pPool, &HashInputJob, &pJobs[i]);
+	}
+	WP_WaitIdle(pBuild->pPool);
+	free(pJobs);
+
+	ComputeKeys(pBuild);
+	return pBuild;
+}
+
+static void ManifestPath(const struct AtlasBuild* pBuild, char* pOutPath)
+{
+	CachePath(pBuild, AB_HashBytes(pBuild->outPath, strlen(pBuild->outPath), AB_HASH_SEED), "manifest", pOutPath);
+}
+
+static bool HashFile(const char* path, u64* pOutHash)
+{
+	int size = 0;
+	char* pData = LoadFile(path, &size);
+	if (!pData)
+	{
+		return false;
+	}
+	*pOutHash = AB_HashBytes(pData, size, AB_HASH_SEED);
+	free(pData);
+	return true;
+}
+
+bool AB_IsUpToDate(struct AtlasBuild* pBuild)
+{
+	if (!pBuild->cacheDir)
+	{
+		return false;
+	}
+	char path[AB_MAX_PATH];
+	ManifestPath(pBuild, path);
+	int size = 0;
+	char* pData = LoadFile(path, &size);
+	if (!pData)
+	{
+		return false;
+	}
+	struct BinarySerializer bs;
+	BS_CreateForLoadFromMemory(pData, size, &bs);
+	u32 magic = 0, version = 0, numInputs = 0;
+	u64 settingsHash = 0, outputHash = 0;
+	BS_DeSerializeU32(&magic, &bs);
+	BS_DeSerializeU32(&version, &bs);
+	BS_DeSerializeU64(&settingsHash, &bs);
+	BS_DeSerializeU64(&outputHash, &bs);
+	BS_DeSerializeU32(&numInputs, &bs);
+	bool bUpToDate = !bs.bError && magic == AB_MANIFEST_MAGIC && version == AB_CACHE_VERSION &&
+		settingsHash == pBuild->settingsHash && numInputs == VectorSize(pBuild->inputs);
+	for (u32 i = 0; i < numInputs && bUpToDate; i++)
+	{
+		char* inputPath = NULL;
+		u64 hash = 0;
+		bool bReadable = false;
+		BS_DeSerializeString(&inputPath, &bs);
+		BS_DeSerializeU64(&hash, &bs);
+		BS_DeSerializeBool(&bReadable, &bs);
+		const struct BuildInput* pInput = &pBuild->inputs[i];
+		bUpToDate = !bs.bError && inputPath && strcmp(inputPath, pInput->path) == 0 &&
+			hash == pInput->hash && bReadable == pInput->bReadable;
+		free(inputPath);
+	}
+	BS_Finish(&bs);
+	free(pData);
+
+	/* the output might have been deleted or overwritten since */
+	u64 currentOutputHash = 0;
+	return bUpToDate && HashFile(pBuild->outPath, &currentOutputHash) && currentOutputHash == outputHash;
+}
+
+static void WriteManifest(struct AtlasBuild* pBuild)
+{
+	u64 outputHash = 0;
+	if (!HashFile(pBuild->outPath, &outputHash))
+	{
+		return;
+	}
+	char path[AB_MAX_PATH];
+	ManifestPath(pBuild, path);
+	struct BinarySerializer bs;
+	BS_CreateForSave(path, &bs);
+	BS_SerializeU32(AB_MANIFEST_MAGIC, &bs);
+	BS_SerializeU32(AB_CACHE_VERSION, &bs);
+	BS_SerializeU64(pBuild->settingsHash, &bs);
+	BS_SerializeU64(outputHash, &bs);
+	BS_SerializeU32(VectorSize(pBuild->inputs), &bs);
+	for (int i = 0; i < VectorSize(pBuild->inputs); i++)
+	{
+		BS_SerializeString(pBuild->inputs[i].path, &bs);
+		BS_SerializeU64(pBuild->inputs[i].hash, &bs);
+		BS_SerializeBool(pBuild->inputs[i].bReadable, &bs);
+	}
+	BS_Finish(&bs);
+}
+
+static bool LoadCachedSprite(struct AtlasBuild* pBuild, struct BuildSprite* pSprite)
+{
+	char path[AB_MAX_PATH];
+	CachePath(pBuild, pSprite->key, "sprite", path);
+	int size = 0;
+	char* pData = LoadFile(path, &size);
+	if (!pData)
+	{
+		return false;
+	}
+	struct BinarySerializer bs;
+	BS_CreateForLoadFromMemory(pData, size, &bs);
+	u32 magic = 0;
+	i32 w = 0, h = 0;
+	BS_DeSerializeU32(&magic, &bs);
+	BS_DeSerializeI32(&w, &bs);
+	BS_DeSerializeI32(&h, &bs);
+	size_t numBytes = (size_t)pSprite->w * pSprite->h * CHANNELS_PER_PIXEL;
+	bool bValid = !bs.bError && magic == AB_SPRITE_MAGIC && w == pSprite->w && h == pSprite->h &&
+		BS_BytesRemaining(&bs) == numBytes;
+	if (bValid)
+	{
+		pSprite->pixels = malloc(numBytes);
+		BS_DeSerializeU8Array(pSprite->pixels, numBytes, &bs);
+		pSprite->bFromCache = true;
+	}
+	BS_Finish(&bs);
+	free(pData);
+	return bValid;
+}
+
+static void StoreCachedSprite(struct AtlasBuild* pBuild, const struct BuildSprite* pSprite)
+{
+	char path[AB_MAX_PATH];
+	CachePath(pBuild, pSprite->key, "sprite", path);
+	struct BinarySerializer bs;
+	BS_CreateForSave(path, &bs);
+	BS_SerializeU32(AB_SPRITE_MAGIC, &bs);
+	BS_SerializeI32(pSprite->w, &bs);
+	BS_SerializeI32(pSprite->h, &bs);
+	BS_SerializeU8Array(pSprite->pixels, (size_t)pSprite->w * pSprite->h * CHANNELS_PER_PIXEL, &bs);
+	BS_Finish(&bs);
+}
+
+/* crops every sprite from one image, decoding it only if a sprite isn't cached */
+static void PrepareImageJob(void* pArg)
+{
+	struct BuildJob* pJob = pArg;
+	struct AtlasBuild* pBuild = pJob->pBuild;
+	const struct BuildInput* pInput = &pBuild->inputs[pJob->index];
+	bool bAllCached = true;
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		struct BuildSprite* pSprite = &pBuild->sprites[i];
+		if (pSprite->input == pJob->index && !(pBuild->cacheDir && LoadCachedSprite(pBuild, pSprite)))
+		{
+			bAllCached = false;
+		}
+	}
+	if (bAllCached || !pInput->bReadable)
+	{
+		return;
+	}
+
+	int imageW = 0, imageH = 0;
+	u8* pImage = IR_DecodeImageFile(pInput->path, &imageW, &imageH);
+	if (!pImage)
+	{
+		return;
+	}
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		struct BuildSprite* pSprite = &pBuild->sprites[i];
+		if (pSprite->input != pJob->index || pSprite->pixels)
+		{
+			continue;
+		}
+		if (pSprite->x < 0 || pSprite->y < 0 || pSprite->w <= 0 || pSprite->h <= 0 ||
+			pSprite->x + pSprite->w > imageW || pSprite->y + pSprite->h > imageH)
+		{
+			printf("sprite at %i, %i size %i x %i is outside of %s\n", pSprite->x, pSprite->y, pSprite->w, pSprite->h, pInput->path);
+			continue;
+		}
+		size_t rowBytes = (size_t)pSprite->w * CHANNELS_PER_PIXEL;
+		pSprite->pixels = malloc(rowBytes * pSprite->h);
+		for (int row = 0; row < pSprite->h; row++)
+		{
+			size_t srcOffset = ((size_t)(pSprite->y + row) * imageW + pSprite->x) * CHANNELS_PER_PIXEL;
+			memcpy(&pSprite->pixels[row * rowBytes], &pImage[srcOffset], rowBytes);
+		}
+		if (pBuild->cacheDir)
+		{
+			StoreCachedSprite(pBuild, pSprite);
+		}
+	}
+	IR_FreeDecodedImage(pImage);
+}
+
+static bool LoadCachedGlyphs(struct AtlasBuild* pBuild, struct BuildFontSize* pSize)
+{
+	char path[AB_MAX_PATH];
+	CachePath(pBuild, pSize->key, "glyphs", path);
+	int size = 0;
+	char* pData = LoadFile(path, &size);
+	if (!pData)
+	{
+		return false;
+	}
+	struct BinarySerializer bs;
+	BS_CreateForLoadFromMemory(pData, size, &bs);
+	u32 magic = 0;
+	BS_DeSerializeU32(&magic, &bs);
+	bool bValid = !bs.bError && magic == AB_GLYPHS_MAGIC;
+	memset(&pSize->glyphs, 0, sizeof(struct AtlasGlyphSet));
+	for (int i = 0; i < 256 && bValid; i++)
+	{
+		struct AtlasGlyph* pGlyph = &pSize->glyphs.glyphs[i];
+		BS_DeSerializeBool(&pGlyph->bSet, &bs);
+		if (!pGlyph->bSet)
+		{
+			continue;
+		}
+		BS_DeSerializeI32(&pGlyph->widthPx, &bs);
+		BS_DeSerializeI32(&pGlyph->heightPx, &bs);
+		BS_DeSerializeF32Array(pGlyph->bearing, 2, &bs);
+		BS_DeSerializeF32Array(pGlyph->advance, 2, &bs);
+		size_t numBytes = (size_t)pGlyph->widthPx * pGlyph->heightPx * CHANNELS_PER_PIXEL;
+		bValid = !bs.bError && pGlyph->widthPx >= 0 && pGlyph->heightPx >= 0 && BS_BytesRemaining(&bs) >= numBytes;
+		if (bValid)
+		{
+			pGlyph->pixels = malloc(numBytes ? numBytes : 1);
+			BS_DeSerializeU8Array(pGlyph->pixels, numBytes, &bs);
+		}
+	}
+	bValid = bValid && BS_BytesRemaining(&bs) == 0;
+	if (!bValid)
+	{
+		At_FreeGlyphSet(&pSize->glyphs);
+	}
+	BS_Finish(&bs);
+	free(pData);
+	return bValid;
+}
+
+static void StoreCachedGlyphs(struct AtlasBuild* pBuild, const struct BuildFontSize* pSize)
+{
+	char path[AB_MAX_PATH];
+	CachePath(pBuild, pSize->key, "glyphs", path);
+	struct BinarySerializer bs;
+	BS_CreateForSave(path, &bs);
+	BS_SerializeU32(AB_GLYPHS_MAGIC, &bs);
+	for (int i = 0; i < 256; i++)
+	{
+		const struct AtlasGlyph* pGlyph = &pSize->glyphs.glyphs[i];
+		BS_SerializeBool(pGlyph->bSet, &bs);
+		if (!pGlyph->bSet)
+		{
+			continue;
+		}
+		BS_SerializeI32(pGlyph->widthPx, &bs);
+		BS_SerializeI32(pGlyph->heightPx, &bs);
+		BS_SerializeF32Array(pGlyph->bearing, 2, &bs);
+		BS_SerializeF32Array(pGlyph->advance, 2, &bs);
+		BS_SerializeU8Array(pGlyph->pixels, (size_t)pGlyph->widthPx * pGlyph->heightPx * CHANNELS_PER_PIXEL, &bs);
+	}
+	BS_Finish(&bs);
+}
+
+static void PrepareFontSizeJob(void* pArg)
+{
+	struct BuildJob* pJob = pArg;
+	struct AtlasBuild* pBuild = pJob->pBuild;
+	struct BuildFontSize* pSize = &pBuild->fontSizes[pJob->index];
+	if (pBuild->cacheDir && LoadCachedGlyphs(pBuild, pSize))
+	{
+		pSize->bLoaded = true;
+		pSize->bFromCache = true;
+		return;
+	}
+	const struct BuildInput* pInput = &pBuild->inputs[pSize->input];
+	if (!pInput->bReadable)
+	{
+		return;
+	}
+	pSize->bLoaded = At_RasteriseGlyphSet(pInput->path, pSize->sizePts, &pSize->glyphs);
+	if (!pSize->bLoaded)
+	{
+		At_FreeGlyphSet(&pSize->glyphs);
+		return;
+	}
+	if (pBuild->cacheDir)
+	{
+		StoreCachedGlyphs(pBuild, pSize);
+	}
+}
+
+static const u8* GetSpritePixels(void* pUser, const char* imgPath, int topLeftXPx, int topLeftYPx, int widthPx, int heightPx)
+{
+	struct AtlasBuild* pBuild = pUser;
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		const struct BuildSprite* pSprite = &pBuild->sprites[i];
+		if (pSprite->pixels && pSprite->x == topLeftXPx && pSprite->y == topLeftYPx &&
+			pSprite->w == widthPx && pSprite->h == heightPx &&
+			strcmp(pBuild->inputs[pSprite->input].path, imgPath) == 0)
+		{
+			return pSprite->pixels;
+		}
+	}
+	return NULL;
+}
+
+static const struct AtlasGlyphSet* GetGlyphSet(void* pUser, const char* fontPath, float sizePts)
+{
+	struct AtlasBuild* pBuild = pUser;
+	for (int i = 0; i < VectorSize(pBuild->fontSizes); i++)
+	{
+		const struct BuildFontSize* pSize = &pBuild->fontSizes[i];
+		if (pSize->bLoaded && pSize->sizePts == sizePts && strcmp(pBuild->inputs[pSize->input].path, fontPath) == 0)
+		{
+			return &pSize->glyphs;
+		}
+	}
+	return NULL;
+}
+
+void AB_Prepare(struct AtlasBuild* pBuild)
+{
+	int numInputs = VectorSize(pBuild->inputs);
+	int numFontSizes = VectorSize(pBuild->fontSizes);
+	struct BuildJob* pJobs = malloc(sizeof(struct BuildJob) * (numInputs + numFontSizes));
+	int numJobs = 0;
+	/* font sizes first, rasterising a big font takes longer than cropping an image */
+	for (int i = 0; i < numFontSizes; i++)
+	{
+		pJobs[numJobs].pBuild = pBuild;
+		pJobs[numJobs].index = i;
+		WP_Submit(pBuild->pPool, &PrepareFontSizeJob, &pJobs[numJobs++]);
+	}
+	for (int i = 1; i < numInputs; i++)
+	{
+		pJobs[numJobs].pBuild = pBuild;
+		pJobs[numJobs].index = i;
+		WP_Submit(pBuild->pPool, &PrepareImageJob, &pJobs[numJobs++]);
+	}
+	WP_WaitIdle(pBuild->pPool);
+	free(pJobs);
+
+	int spritesCached = 0, spritesCropped = 0, sizesCached = 0, sizesRasterised = 0;
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		if (pBuild->sprites[i].pixels)
+		{
+			pBuild->sprites[i].bFromCache ? spritesCached++ : spritesCropped++;
+		}
+	}
+	for (int i = 0; i < numFontSizes; i++)
+	{
+		if (pBuild->fontSizes[i].bLoaded)
+		{
+			pBuild->fontSizes[i].bFromCache ? sizesCached++ : sizesRasterised++;
+		}
+	}
+	printf("%i threads: %i sprites cropped, %i from the cache. %i font sizes rasterised, %i from the cache\n",
+		WP_GetNumThreads(pBuild->pPool), spritesCropped, spritesCached, sizesRasterised, sizesCached);
+
+	pBuild->sources.pUser = pBuild;
+	pBuild->sources.GetSpritePixels = &GetSpritePixels;
+	pBuild->sources.GetGlyphSet = &GetGlyphSet;
+}
+
+const struct AtlasSourceProvider* AB_GetSources(struct AtlasBuild* pBuild)
+{
+	return &pBuild->sources;
+}
+
+void AB_Finish(struct AtlasBuild* pBuild, bool bOutputSaved)
+{
+	if (pBuild->cacheDir && bOutputSaved)
+	{
+		WriteManifest(pBuild);
+	}
+	WP_Destroy(pBuild->pPool);
+	for (int i = 0; i < VectorSize(pBuild->inputs); i++)
+	{
+		free(pBuild->inputs[i].path);
+	}
+	for (int i = 0; i < VectorSize(pBuild->sprites); i++)
+	{
+		free(pBuild->sprites[i].pixels);
+	}
+	for (int i = 0; i < VectorSize(pBuild->fontSizes); i++)
+	{
+		if (pBuild->fontSizes[i].bLoaded)
+		{
+			At_FreeGlyphSet(&pBuild->fontSizes[i].glyphs);
+		}
+	}
+	DestoryVector(pBuild->inputs);
+	DestoryVector(pBuild->sprites);
+	DestoryVector(pBuild->fontSizes);
+	free(pBuild->outPath);
+	free(pBuild->cacheDir);
+	free(pBuild);
+}
@@ -0,0 +1,50 @@
+#ifndef ATLAS_BUILD_H
+#define ATLAS_BUILD_H
+
+#include "IntTypes.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct _xmlNode xmlNode;
+struct AtlasSourceProvider;
+
+/*
+	Parallel and incremental atlas builds for AtlasTool.
+
+	AB_Begin reads the atlas xml for the images and font sizes it uses and hashes every input file,
+	on a pool of worker threads. If there's a cache directory it then checks the manifest the last
+	build of the same output wrote: when the xml, every image and font, the tools settings and the
+	output file itself all hash the same the output is up to date and nothing needs building.
+
+	Otherwise AB_Prepare decodes each image once and crops out its sprites, and rasterises each font
+	size, again on the worker threads. With a cache directory every cropped sprite and glyph set is
+	stored there under a hash of its source file contents and rect or size, and later builds load them
+	instead - so changing one sprite only decodes that sprites image. The results are handed to
+	At_LoadAtlasEx through the AtlasSourceProvider, leaving it just packing and blitting.
+
+	AB_Finish records the manifest once the output is saved.
+*/
+
+struct AtlasBuild;
+
+/// <param name="cacheDir"> NULL for a parallel but not incremental build, created if it doesn't exist </param>
+/// <param name="settingsHash"> hash of any settings that change the output, a change forces a rebuild </param>
+/// <param name="numThreads"> 0 for one per CPU </param>
+struct AtlasBuild* AB_Begin(xmlNode* pRoot, const char* xmlPath, const char* outPath, const char* cacheDir, u64 settingsHash, int numThreads);
+
+bool AB_IsUpToDate(struct AtlasBuild* pBuild);
+
+/* decode, crop and rasterise whatever isn't in the cache */
+void AB_Prepare(struct AtlasBuild* pBuild);
+
+/* valid until AB_Finish */
+const struct AtlasSourceProvider* AB_GetSources(struct AtlasBuild* pBuild);
+
+/* writes the manifest if bOutputSaved, then frees the build */
+void AB_Finish(struct AtlasBuild* pBuild, bool bOutputSaved);
+
+u64 AB_HashBytes(const void* pData, size_t size, u64 hash);
+
+#define AB_HASH_SEED 0xcbf29ce484222325ull
+
+#endif
@@ -2,6 +2,8 @@
 #include "Atlas.h"
 #include "DrawContext.h"
 #include "ImageFileRegstry.h"
+#include "AtlasBuild.h"
+#include "Clock.h"
 #include <stdio.h>
 #include <string.h>
 #include <libxml/parser.h>
@@ -11,7 +13,10 @@ struct Args
 {
 	char* xmlPath;
 	char* outPath;
+	struct AtlasSaveOptions saveOptions;
 	struct EndAtlasOptions atlasOptions;
+	char* cacheDir;
+	int numThreads;
 }args;
 
 const char* defaultOutPath = "out.atlas";
@@ -30,6 +35,15 @@ void PrintHelpMsg()
 		"          -iw                            initial atlas width, will grow as sprites are added if there is no room. defaults to 512\n"
 		"          -ih                            initial atlas height, will grow as sprites are added if there is no room. defaults to 512\n"
 		"          -initial-dims-from-sprites     take the atlases initial dims from the larges sprite\n"
+		"          -file-version                  .atlas file version to write, 1 or 2. defaults to the latest, 2\n"
+		"          -compress                      losslessly compress the atlas pixels (QOI), version 2 only\n"
+		"          -palette                       store the atlas pixels as a palette of up to 256 colours and compressed indices,\n"
+		"                                         for pixel art. Falls back to -compress if there are more colours. version 2 only\n"
+		"          -packer                        how to pack the sprites: freespace (default), maxrects or skyline\n"
+		"          -cache                         directory to cache cropped sprites and rasterised fonts in. Sprites and fonts\n"
+		"                                         whose source files haven't changed are loaded from it, and if nothing has\n"
+		"                                         changed since the last build the output isn't rebuilt at all\n"
+		"          -j                             number of threads to decode images and rasterise fonts on. defaults to one per CPU\n"
 	);
 }
 
@@ -44,6 +58,8 @@ int ParseArgs(int argc, char** argv)
 	args.xmlPath = argv[1];
 	args.atlasOptions.initialAtlasHeight = 512;
 	args.atlasOptions.initialAtlasWidth = 512;
+	args.saveOptions.fileVersion = ATLAS_FILE_VERSION_LATEST;
+	args.saveOptions.pixelEncoding = APE_Raw;
 	for (int i = 2; i < argc; i++)
 	{
 		if (strcmp(argv[i], "-o") == 0)
@@ -70,6 +86,34 @@ int ParseArgs(int argc, char** argv)
 		{
 			args.atlasOptions.bUseBiggestSpriteForInitialAtlasSize = true;
 		}
+		else if (strcmp(argv[i], "-file-version") == 0)
+		{
+			args.saveOptions.fileVersion = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-compress") == 0)
+		{
+			args.saveOptions.pixelEncoding = APE_QOI;
+		}
+		else if (strcmp(argv[i], "-palette") == 0)
+		{
+			args.saveOptions.pixelEncoding = APE_Palette;
+		}
+		else if (strcmp(argv[i], "-packer") == 0)
+		{
+			if (!AtP_PackerFromName(argv[i + 1], &args.atlasOptions.packer))
+			{
+				printf("unknown packer %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-cache") == 0)
+		{
+			args.cacheDir = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-j") == 0)
+		{
+			args.numThreads = atoi(argv[i + 1]);
+		}
 	}
 	if (!args.outPath)
 	{
@@ -83,6 +127,21 @@ static hTexture UploadTextureMock(void* src, int channels, int pxWidth, int pxHe
 	return 0;
 }
 
+/* everything besides the inputs that changes the output */
+static u64 HashSettings()
+{
+	u64 hash = AB_HASH_SEED;
+	i64 settings[] = {
+		args.saveOptions.fileVersion,
+		args.saveOptions.pixelEncoding,
+		args.atlasOptions.initialAtlasWidth,
+		args.atlasOptions.initialAtlasHeight,
+		args.atlasOptions.bUseBiggestSpriteForInitialAtlasSize,
+		args.atlasOptions.packer
+	};
+	return AB_HashBytes(settings, sizeof(settings), hash);
+}
+
 int main(int argc, char** argv)
 {
 	int r = ParseArgs(argc, argv);
@@ -98,16 +157,40 @@ int main(int argc, char** argv)
 	At_Init();
 	xmlDoc* pXMLDoc = xmlReadFile(args.xmlPath, NULL, 0);
 	xmlNode* root = xmlDocGetRootElement(pXMLDoc);
+	double startMs = Clk_NowMs();
+	struct AtlasBuild* pBuild = AB_Begin(root, args.xmlPath, args.outPath, args.cacheDir, HashSettings(), args.numThreads);
+	/* the debug bitmap is only written by a real build */
+	if (!args.atlasOptions.outDebugBitmapPath && AB_IsUpToDate(pBuild))
+	{
+		printf("%s is up to date, %.2fms\n", args.outPath, Clk_NowMs() - startMs);
+		AB_Finish(pBuild, false);
+		return 0;
+	}
+	double hashedMs = Clk_NowMs();
+	AB_Prepare(pBuild);
+	args.atlasOptions.pSources = AB_GetSources(pBuild);
+	double preparedMs = Clk_NowMs();
+
 	struct DrawContext dc;
+	memset(&dc, 0, sizeof(struct DrawContext));
 	dc.UploadTexture = &UploadTextureMock;
+	struct AtlasPackStats packStats;
+	args.atlasOptions.pOutPackStats = &packStats;
 	hAtlas atlas = At_LoadAtlasEx(root, &dc, &args.atlasOptions);
 	if (atlas == NULL_HANDLE)
 	{
+		AB_Finish(pBuild, false);
 		return 1;
 	}
+	double builtMs = Clk_NowMs();
+	printf("packed with %s: %ix%i, %.1f%% occupied, %.2fms\n",
+		AtP_PackerName(packStats.packer), packStats.width, packStats.height, packStats.occupancyPercent, packStats.packMs);
 	struct BinarySerializer bs;
 	BS_CreateForSave(args.outPath, &bs);
-	At_SerializeAtlas(&bs, &atlas, &dc);
-	BS_Finish(&bs);
-	return 0;
+	At_SaveAtlasEx(&bs, atlas, &args.saveOptions);
+	bool bSaved = BS_Finish(&bs);
+	AB_Finish(pBuild, bSaved);
+	printf("hash inputs %.2fms, decode and rasterise %.2fms, build %.2fms, save %.2fms\n",
+		hashedMs - startMs, preparedMs - hashedMs, builtMs - preparedMs, Clk_NowMs() - builtMs);
+	return bSaved ? 0 : 1;
 }
\ No newline at end of file
@@ -12,6 +12,9 @@ void AnimatedSprite_OnUpdate(struct AnimatedSprite* pAnimatedSprite, struct Enti
 void AnimatedSprite_GetBoundingBox(struct Entity2D* pEnt, struct AnimatedSprite* pAnimatedSprite, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR);
 void AnimatedSprite_Draw(struct AnimatedSprite* pSpriteComp, struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, struct Transform2D* pCam, VECTOR(Worldspace2DVert)* outVerts, VECTOR(VertIndexT)* outIndices, VertIndexT* pNextIndex);
 void AnimatedSprite_OnDestroy(struct Entity2D* pEnt);
-void AnimatedSprite_SetAnimation(struct GameFrameworkLayer* pLayer, struct AnimatedSprite* pSpriteComp, const char* animName, bool bResetOnFrame, bool bResetTimer);
+/* pEnt is the entity the sprite belongs to, its bounding box is marked dirty */
+void AnimatedSprite_SetAnimation(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt, struct AnimatedSprite* pSpriteComp, const char* animName, bool bResetOnFrame, bool bResetTimer);
+/* animNameHash from HashmapHashKey(animName) */
+void AnimatedSprite_SetAnimationHashed(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt, struct AnimatedSprite* pSpriteComp, const char* animName, u32 animNameHash, bool bResetOnFrame, bool bResetTimer);
 
 #endif
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "IntTypes.h"
 #include "HandleDefs.h"
+#include "AtlasPacker.h"
+#include "GlyphRunCache.h"
 #include <cglm/cglm.h>
 #include <stdbool.h>
 
@@ -73,6 +75,42 @@ struct FontAtlasAdditionSpec
 	char path[MAX_FONT_PATH_SIZE];
 	struct FontSize fontSizes[MAX_NUM_FONT_SIZES];
 	size_t numFontSizes;
+	/*
+		rasterise glyphs when they're first used instead of glyphs 0 to 255 up front, into the atlas's glyph cache.
+		Dynamic fonts cost no atlas space per size and can draw any unicode codepoint the font has
+	*/
+	bool bDynamic;
+};
+
+/* one font sizes glyphs, as At_AddFont rasterises them */
+struct AtlasGlyph
+{
+	bool bSet;
+	int widthPx;
+	int heightPx;
+	vec2 bearing;
+	vec2 advance;
+	/* widthPx * heightPx RGBA pixels */
+	u8* pixels;
+};
+
+struct AtlasGlyphSet
+{
+	struct AtlasGlyph glyphs[256];
+};
+
+/*
+	Lets At_LoadAtlasEx take sprite pixels and glyphs from somewhere other than decoding the images
+	and rasterising the fonts itself - AtlasTool uses it to feed in pixels decoded on worker threads
+	or read from its build cache. Either function can be NULL, or return NULL to fall back to loading
+	that sprite or font size as normal. What they return is copied.
+*/
+struct AtlasSourceProvider
+{
+	void* pUser;
+	/* the widthPx * heightPx RGBA pixels of the sprite, tightly packed */
+	const u8* (*GetSpritePixels)(void* pUser, const char* imgPath, int topLeftXPx, int topLeftYPx, int widthPx, int heightPx);
+	const struct AtlasGlyphSet* (*GetGlyphSet)(void* pUser, const char* fontPath, float sizePts);
 };
 
 void At_Init();
@@ -80,14 +118,61 @@ void At_BeginAtlas();
 
 hSprite At_AddSprite(const char* imgPath, int topLeftXPx, int topRightYPx, int widthPx, int heightPx, const char* name);
 HFont At_AddFont(const struct FontAtlasAdditionSpec* pFontSpec);
+
+/* the size in points a font size is rasterised at */
+float At_FontSizeToPts(const struct FontSize* pSize);
+
+/// <summary>
+/// Rasterise glyphs 0 to 255 of a font as At_AddFont would, safe to call from any thread
+/// </summary>
+/// <returns> false if the font can't be loaded, free pOutSet with At_FreeGlyphSet either way </returns>
+bool At_RasteriseGlyphSet(const char* fontPath, float sizePts, struct AtlasGlyphSet* pOutSet);
+
+void At_FreeGlyphSet(struct AtlasGlyphSet* pSet);
 hAtlas At_EndAtlas(struct DrawContext* pDC);
 
+/*
+	The glyph cache is a region of the atlas texture reserved for dynamic fonts glyphs (see FontAtlasAdditionSpec.bDynamic).
+	Glyphs are shelf packed into it as they're first drawn and the least recently used are evicted when it's full,
+	see GlyphShelfPacker.h. Only atlases with dynamic fonts have one.
+*/
+#define ATLAS_DEFAULT_GLYPH_CACHE_SIZE 512
+
+/* the size of the current atlas's glyph cache, call before At_EndAtlas. ATLAS_DEFAULT_GLYPH_CACHE_SIZE square if not set */
+void At_SetGlyphCacheSize(int widthPx, int heightPx);
+
+struct AtlasGlyphCacheStats
+{
+	/* 0 if the atlas has no glyph cache */
+	int widthPx;
+	int heightPx;
+	/* including glyphs rasterised again after they were evicted */
+	u64 glyphsRasterised;
+	u64 glyphsEvicted;
+	u64 bytesUploaded;
+};
+
+void At_GetGlyphCacheStats(hAtlas atlas, struct AtlasGlyphCacheStats* pOutStats);
+
+/*
+	Changes whenever glyphs are evicted from the glyph cache - vertices output before it changed may
+	use the texture where an evicted glyph was and need outputting again.
+	Also changes when the atlas is bound after a frame where a glyph didn't fit and was drawn empty
+*/
+u32 At_GetGlyphCacheGeneration(hAtlas atlas);
+
 struct EndAtlasOptions
 {
 	int initialAtlasWidth;
 	int initialAtlasHeight;
 	char* outDebugBitmapPath;
 	bool bUseBiggestSpriteForInitialAtlasSize;
+	/* APT_FreeSpaceMerge when zeroed */
+	enum AtlasPackerType packer;
+	/* optional, filled in with how well the sprites packed and how long it took */
+	struct AtlasPackStats* pOutPackStats;
+	/* optional, At_LoadAtlasEx only */
+	const struct AtlasSourceProvider* pSources;
 };
 
 hAtlas At_EndAtlasEx(struct DrawContext* pDC, struct EndAtlasOptions* pOptions);
@@ -95,12 +180,16 @@ void At_DestroyAtlas(hAtlas atlas, struct DrawContext* pDC);
 hSprite At_FindSprite(const char* name, hAtlas atlas);
 AtlasSprite* At_GetSprite(hSprite sprite, hAtlas atlas);
 hTexture At_GetAtlasTexture(hAtlas atlas);
+void At_GetAtlasTextureDims(hAtlas atlas, int* pOutWidth, int* pOutHeight);
 float At_PixelsToPts(float val);
 hAtlas At_LoadAtlas(xmlNode* child0, struct DrawContext* pDC);
 hAtlas At_LoadAtlasEx(xmlNode* child0, struct DrawContext* pDC, struct EndAtlasOptions* pOptions);
 
 hSprite At_TilemapIndexToSprite(hAtlas atlas, TileIndex tileIndex);
 
+/* tile indices 1 to the returned value (inclusive) are valid for At_TilemapIndexToSprite, 0 if the atlas has no tileset */
+int At_GetNumTilesetTiles(hAtlas atlas);
+
 /// <param name="pSerializer">
 /// binary serialzier to load or save
 /// </param>
@@ -110,12 +199,48 @@ hSprite At_TilemapIndexToSprite(hAtlas atlas, TileIndex tileIndex);
 /// </param>
 void At_SerializeAtlas(struct BinarySerializer* pSerializer, hAtlas* atlas, struct DrawContext* pDC);
 
+/* the .atlas file version At_SerializeAtlas saves */
+#define ATLAS_FILE_VERSION_LATEST 2
+
+/// <summary>
+/// Load a binary .atlas file of any version. Version 2 files are memory mapped, the atlas texture is uploaded
+/// straight from the mapping and the atlas keeps it until it's destroyed. Compressed pixels are decoded into
+/// pDC's MapTextureUploadBuffer if it has one
+/// </summary>
+/// <returns> the new atlas, NULL_HANDLE if the file can't be loaded </returns>
+hAtlas At_LoadAtlasFile(const char* path, struct DrawContext* pDC);
+
+/* save in a particular file version, 1 or 2, for when older builds need to read the file */
+void At_SaveAtlasWithVersion(struct BinarySerializer* pSerializer, hAtlas atlas, u32 version);
+
+/* how the pixels are stored in a version 2 .atlas file, version 1 files are always APE_Raw */
+enum AtlasPixelEncoding
+{
+	/* RGBA, uploaded straight from the mapped file */
+	APE_Raw,
+	/* lossless, see Qoi.h */
+	APE_QOI,
+	/* a table of up to 256 colours and an LZ4 compressed index per pixel, for pixel art. Atlases with more colours are saved as APE_QOI */
+	APE_Palette
+};
+
+struct AtlasSaveOptions
+{
+	u32 fileVersion;
+	enum AtlasPixelEncoding pixelEncoding;
+};
+
+void At_SaveAtlasEx(struct BinarySerializer* pSerializer, hAtlas atlas, const struct AtlasSaveOptions* pOptions);
+
 void At_BeginTileset(int beginI);
 void At_EndTileset(int endI);
 
+/* bind the atlas texture, uploading any glyphs rasterised into its glyph cache since it was last bound first */
 void At_SetCurrent(hAtlas atlas, DrawContext* pDC);
 
 struct AtlasAnimation* At_FindAnim(hAtlas atlas, const char* name);
+/* hash from HashmapHashKey(name), so callers that look an animation up often can hash its name once */
+struct AtlasAnimation* At_FindAnimHashed(hAtlas atlas, const char* name, u32 hash);
 
 HFont Fo_FindFont(hAtlas hAtlas, const char* fontName, float sizePts);
 float Fo_CharWidth(hAtlas hAtlas, HFont hFont, char c);
@@ -125,7 +250,30 @@ float Fo_StringHeight(hAtlas hAtlas, HFont hFont, const char* stringVal);
 AtlasSprite* Fo_GetCharSprite(hAtlas hAtlas, HFont hFont, char c);
 float Fo_GetMaxYBearing(hAtlas hAtlas, HFont hFont, const char* str);
 
+/// <summary>
+/// Width, height and bearing of a string, from the glyph run cache (see GlyphRunCache.h) if it's been measured before.
+/// Fo_StringWidth, Fo_StringHeight and Fo_GetMaxYBearing all use this, so asking for all three measures the string once
+/// </summary>
+/// <returns> false if the atlas or font handle is invalid </returns>
+bool Fo_GetGlyphRun(hAtlas hAtlas, HFont hFont, const char* str, struct GlyphRun* pOutRun);
+
+/* the highest any glyph in the font reaches above the baseline */
+float Fo_GetFontMaxYBearing(hAtlas hAtlas, HFont hFont);
+
+/* from the lowest any glyph in the font reaches below the baseline to the highest above it */
+float Fo_GetLineHeight(hAtlas hAtlas, HFont hFont);
+
 bool Fo_TryGetCharBearing(hAtlas hAtlas, HFont hFont, char c, vec2 outBearing);
 bool Fo_TryGetCharAdvance(hAtlas hAtlas, HFont hFont, char c, float* outAdvance);
 
+/*
+	The same for any unicode codepoint, fonts that aren't dynamic only have codepoints 0 to 255.
+	A dynamic fonts glyph is rasterised the first time it's asked for. Fo_GetGlyphSprite puts it in the
+	glyph cache if it isn't, the sprite is valid until the next glyph is rasterised and is empty if there's
+	no room in the cache for it this frame.
+*/
+AtlasSprite* Fo_GetGlyphSprite(hAtlas hAtlas, HFont hFont, u32 codepoint);
+bool Fo_TryGetGlyphBearing(hAtlas hAtlas, HFont hFont, u32 codepoint, vec2 outBearing);
+bool Fo_TryGetGlyphAdvance(hAtlas hAtlas, HFont hFont, u32 codepoint, float* outAdvance);
+
 #endif
\ No newline at end of file
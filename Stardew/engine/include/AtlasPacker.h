@@ -0,0 +1,70 @@
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdbool.h>
+#include "IntTypes.h"
+
+/*
+	Rectangle packing for building atlases.
+
+	Packs a list of rectangles into a bin, growing the bin by doubling its smaller side (width when
+	they're equal) until everything fits. Rectangles are never rotated, sprites are drawn with fixed UVs.
+
+	- APT_FreeSpaceMerge: the original atlas packer. Places each rect in the first free rect it fits,
+	  splits what's left and rebuilds the free list from a bitmap after every placement. Slow, and leaves
+	  gaps, but kept as the default so existing atlases come out the same.
+	- APT_MaxRectsBSSF: MaxRects, best short side fit. Keeps every maximal free rectangle and puts each
+	  rect where it leaves the least space along its shorter side. Packs tightest.
+	- APT_SkylineBL: skyline, bottom left. Only tracks the top edge of the placed rects, so it's the
+	  fastest, but can't fill holes underneath the skyline.
+*/
+
+enum AtlasPackerType
+{
+	APT_FreeSpaceMerge,
+	APT_MaxRectsBSSF,
+	APT_SkylineBL,
+	APT_NumPackerTypes
+};
+
+struct AtlasPackerRect
+{
+	/* in */
+	int w, h;
+	/* out, top left */
+	int x, y;
+};
+
+struct AtlasPackStats
+{
+	enum AtlasPackerType packer;
+	int width;
+	int height;
+	/* area of all the packed rects */
+	u64 usedPixels;
+	/* usedPixels as a percentage of width * height */
+	float occupancyPercent;
+	double packMs;
+};
+
+/// <summary>
+/// Pack rects, in the order given for APT_FreeSpaceMerge, the others sort them first
+/// </summary>
+/// <param name="pInOutW"> initial bin width, set to the final width </param>
+/// <param name="pInOutH"> initial bin height, set to the final height </param>
+/// <param name="pOutStats"> optional </param>
+void AtP_Pack(enum AtlasPackerType packer, struct AtlasPackerRect* pRects, int numRects, int* pInOutW, int* pInOutH, struct AtlasPackStats* pOutStats);
+
+const char* AtP_PackerName(enum AtlasPackerType packer);
+
+/* false if the name isn't one returned by AtP_PackerName */
+bool AtP_PackerFromName(const char* name, enum AtlasPackerType* pOutPacker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
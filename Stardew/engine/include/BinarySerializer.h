@@ -1,23 +1,75 @@
 #ifndef BINARY_SERIALIZER_H
 #define BINARY_SERIALIZER_H
 #ifdef __cplusplus
-extern "c" {
+extern "C" {
 #endif
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 #include "IntTypes.h"
 
+	/*
+		Reads and writes binary files.
+
+		Everything is stored little-endian whatever the host, and reads go through byte loads so
+		the data doesn't need to be aligned. Bools are 1 byte, strings and BS_SerializeBytes blocks
+		are prefixed with a u32 length. The array functions write just the elements, the caller
+		stores the count.
+
+		Saving to a file is streamed: writes go into a BS_STREAM_CHUNK_SIZE buffer that's flushed
+		to the FILE* whenever it fills, so memory use doesn't grow with the file. Saving to memory
+		grows the buffer instead. Loading reads the whole file up front.
+
+		Reading past the end of the data sets bError and reads zeros.
+	*/
+
+#define BS_STREAM_CHUNK_SIZE (64 * 1024)
+
 	struct BinarySerializer
 	{
 		bool bSaving;
+		/* set when a read goes past the end of the data or a write to the file fails */
+		bool bError;
+		/* pFile is closed by BS_Finish */
+		bool bOwnsFile;
+		/* pData is freed by BS_Finish */
+		bool bOwnsData;
+		/* saving: bytes not yet flushed, or everything when saving to memory. loading: the data */
 		char* pData;
-		int pDataSize;
+		/* bytes in pData */
+		size_t dataSize;
+		size_t capacity;
+		/* loading only */
 		char* pReadPtr;
+		/* saving: NULL when saving to memory */
+		FILE* pFile;
+		/* saving: bytes written so far, flushed or not */
+		size_t totalBytesWritten;
 		char* pPath;
 	};
 
 	void BS_CreateForLoad(const char* path, struct BinarySerializer* pOutSerializer);
+	/* pData isn't copied and must outlive the serializer */
+	void BS_CreateForLoadFromMemory(const void* pData, size_t size, struct BinarySerializer* pOutSerializer);
 	void BS_CreateForSave(const char* path, struct BinarySerializer* pOutSerializer);
-	void BS_Finish(struct BinarySerializer* pOutSerializer);
+	/* stream to a file the caller opened, BS_Finish flushes but doesn't close it */
+	void BS_CreateForSaveToFile(FILE* pFile, struct BinarySerializer* pOutSerializer);
+	/* save into a growable buffer, see BS_GetSavedData */
+	void BS_CreateForSaveToMemory(struct BinarySerializer* pOutSerializer);
+
+	/// <summary>
+	/// Flush any buffered writes and release the serializer
+	/// </summary>
+	/// <returns> false if there was an error reading or writing </returns>
+	bool BS_Finish(struct BinarySerializer* pOutSerializer);
+
+	/// <summary>
+	/// The bytes saved by a serializer created with BS_CreateForSaveToMemory, valid until the next write or BS_Finish
+	/// </summary>
+	const char* BS_GetSavedData(struct BinarySerializer* pSerializer, size_t* pOutSize);
+
+	/* loading: bytes left to read */
+	size_t BS_BytesRemaining(struct BinarySerializer* pSerializer);
 
 
 	void BS_SerializeI64(i64 val, struct BinarySerializer* pSerializer);
@@ -34,6 +86,12 @@ extern "c" {
 	void BS_SerializeString(const char* val, struct BinarySerializer* pSerializer);
 	void BS_SerializeBytes(const char* val, u32 len, struct BinarySerializer* pSerializer);
 
+	void BS_SerializeU8Array(const u8* vals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_SerializeU16Array(const u16* vals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_SerializeU32Array(const u32* vals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_SerializeI32Array(const i32* vals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_SerializeF32Array(const float* vals, size_t count, struct BinarySerializer* pSerializer);
+
 
 	void BS_DeSerializeI64(i64* val, struct BinarySerializer* pSerializer);
 	void BS_DeSerializeU64(u64* val, struct BinarySerializer* pSerializer);
@@ -48,9 +106,18 @@ extern "c" {
 	void BS_DeSerializeDouble(double* val, struct BinarySerializer* pSerializer);
 	void BS_DeSerializeString(char** val, struct BinarySerializer* pSerializer);
 	void BS_DeSerializeStringInto(char* buf, struct BinarySerializer* pSerializer);
+	/* raw bytes, no length prefix */
 	void BS_BytesRead(struct BinarySerializer* pSerializer, u32 numBytes, char* pDst);
+	/* raw bytes without copying them, valid until BS_Finish. NULL if there aren't numBytes left */
+	const u8* BS_BytesReadInPlace(struct BinarySerializer* pSerializer, size_t numBytes);
+
+	void BS_DeSerializeU8Array(u8* outVals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_DeSerializeU16Array(u16* outVals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_DeSerializeU32Array(u32* outVals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_DeSerializeI32Array(i32* outVals, size_t count, struct BinarySerializer* pSerializer);
+	void BS_DeSerializeF32Array(float* outVals, size_t count, struct BinarySerializer* pSerializer);
 
 #ifdef __cplusplus
 }
 #endif
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,16 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include "IntTypes.h"
+
+/* a monotonic clock for timing things, the values only mean something relative to each other */
+u64 Clk_NowNs(void);
+double Clk_NowMs(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -3,12 +3,20 @@
 
 #include "DynArray.h"
 #include "DrawContext.h"
+#include <stdbool.h>
 
 struct Entity2D;
 struct GameFrameworkLayer;
 struct InputContext;
 typedef struct InputContext InputContext;
 struct Transform2D;
+struct Entity2DCollection;
+struct ComponentStore;
+struct Sprite;
+struct StaticCollider;
+struct DynamicCollider;
+struct TextSprite;
+struct AnimatedSprite;
 
 void Co_InitComponents(struct Entity2D* entity, struct GameFrameworkLayer* pLayer);
 void Co_UpdateComponents(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, float deltaT);
@@ -24,4 +32,38 @@ void Co_DrawComponents(
     VECTOR(VertIndexT)* outIndices,
     VertIndexT* pNextIndex);
 
+/*
+    Component store (see struct ComponentStore)
+*/
+void Co_InitComponentStore(struct ComponentStore* pStore, bool bEnabled);
+void Co_DestroyComponentStore(struct ComponentStore* pStore);
+
+/* moves the entities components into the store, if it's enabled and the entity uses the default update and draw. Called by Et2D_AddEntity */
+void Co_StoreComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt);
+
+/* removes the entities components from the store if they're in it, components moved to fill the gaps have their owners slots updated */
+void Co_RemoveStoredComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt);
+
+/* copy of pEnt with its components inline, for code that reads components[i].data such as entity serializers */
+void Co_GatherComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, struct Entity2D* pOutEnt);
+
+/* the data of the entities i'th component, in the store or inline */
+void* Co_GetComponentData(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+struct Sprite* Co_GetSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+struct StaticCollider* Co_GetStaticCollider(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+struct DynamicCollider* Co_GetDynamicCollider(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+struct TextSprite* Co_GetTextSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+struct AnimatedSprite* Co_GetAnimatedSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i);
+
+/* update every stored component, a linear pass over each type that has anything to update */
+void Co_UpdateComponentStore(struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer, float deltaT);
+
+/* output vertices for every stored sprite and animated sprite in store order - no culling and no draw order sorting */
+void Co_DrawComponentStore(
+    struct Entity2DCollection* pCollection,
+    struct GameFrameworkLayer* pLayer,
+    VECTOR(Worldspace2DVert)* outVerts,
+    VECTOR(VertIndexT)* outIndices,
+    VertIndexT* pNextIndex);
+
 #endif
\ No newline at end of file
@@ -46,6 +46,18 @@ typedef void(*DestroyUIVertexBufferFn)(HUIVertexBuffer hBuf);
 typedef hTexture(*UploadTextureFn)(void* src, int channels, int pxWidth, int pxHeight);
 typedef void(*DestroyTextureFn)(hTexture tex);
 
+/*
+	Optional, for pixels that have to be decoded before they're uploaded: MapTextureUploadBuffer returns write only memory
+	to decode them into (a mapped pixel unpack buffer in GL) and UploadMappedTexture creates the texture from it,
+	saving a copy. If MapTextureUploadBuffer is NULL decode into memory of your own and use UploadTexture.
+*/
+typedef void*(*MapTextureUploadBufferFn)(int channels, int pxWidth, int pxHeight);
+/* uploads the buffer the last MapTextureUploadBuffer call returned, which isn't valid after */
+typedef hTexture(*UploadMappedTextureFn)();
+
+/* optional, write src to a pxWidth x pxHeight region of a texture with its top left at x, y. Used for dynamic fonts glyphs */
+typedef void(*UpdateTextureRegionFn)(hTexture tex, const void* src, int channels, int x, int y, int pxWidth, int pxHeight);
+
 
 typedef H2DWorldspaceVertexBuffer(*NewWorldspaceVertBufferFn)(int size);
 
@@ -54,6 +66,23 @@ typedef void(*WorldspaceVertexBufferDataFn)(H2DWorldspaceVertexBuffer hBuf, Worl
 typedef void(*DrawWorldspaceVertexBufferFn)(H2DWorldspaceVertexBuffer hBuf, size_t vertexCount, mat4 view);
 typedef void(*DestroyWorldspaceVertexBufferFn)(H2DWorldspaceVertexBuffer hBuf);
 
+/*
+	Vertex pulled tilemaps: a layers tile indices live in a texture, one texel per tile, and a uniform
+	block maps each tile index to its atlas uvs. A chunk is drawn with no vertex buffer at all.
+	These are optional, if NewTileIndexTexture is NULL tile layers are drawn from vertex buffers instead.
+*/
+
+/* the uv table uniform block has room for this many tile indices, the minimum GL ES 3.0 allows (16kb) */
+#define TILEMAP_UV_TABLE_MAX_TILES 1024
+
+typedef hTexture(*NewTileIndexTextureFn)(const TileIndex* tiles, int widthTiles, int heightTiles);
+typedef void(*TileIndexTextureSetTileFn)(hTexture tex, int col, int row, TileIndex tile);
+/* uvs is a top left u, v, bottom right u, v per tile index, numTiles <= TILEMAP_UV_TABLE_MAX_TILES */
+typedef HTilemapUVTable(*NewTilemapUVTableFn)(const float* uvs, int numTiles);
+typedef void(*DestroyTilemapUVTableFn)(HTilemapUVTable hTable);
+/* draw numCols x numRows tiles starting at startCol, startRow - tile 0 is empty and not drawn */
+typedef void(*DrawTilemapChunkFn)(hTexture tileIndices, HTilemapUVTable hTable, int startCol, int startRow, int numCols, int numRows, vec2 tileSizePx, vec2 origin, mat4 view);
+
 
 typedef struct DrawContext
 {
@@ -66,11 +95,20 @@ typedef struct DrawContext
 	SetCurrentAtlasFn SetCurrentAtlas;
 	UploadTextureFn UploadTexture;
 	DestroyTextureFn DestroyTexture;
+	MapTextureUploadBufferFn MapTextureUploadBuffer;
+	UploadMappedTextureFn UploadMappedTexture;
+	UpdateTextureRegionFn UpdateTextureRegion;
 
 	NewWorldspaceVertBufferFn NewWorldspaceVertBuffer;
 	WorldspaceVertexBufferDataFn WorldspaceVertexBufferData;
 	DrawWorldspaceVertexBufferFn DrawWorldspaceVertexBuffer;
 	DestroyWorldspaceVertexBufferFn DestroyWorldspaceVertexBuffer;
+
+	NewTileIndexTextureFn NewTileIndexTexture;
+	TileIndexTextureSetTileFn TileIndexTextureSetTile;
+	NewTilemapUVTableFn NewTilemapUVTable;
+	DestroyTilemapUVTableFn DestroyTilemapUVTable;
+	DrawTilemapChunkFn DrawTilemapChunk;
 }DrawContext;
 
 DrawContext Dr_InitDrawContext();
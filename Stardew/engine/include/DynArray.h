@@ -7,9 +7,33 @@ extern "C"{
 
 #include "IntTypes.h"
 
+#define VECTOR_INITIAL_CAPACITY 8
+
 void* VectorInit(unsigned int itemSize);
+
+/*
+	Vectors whose storage comes from the frame arenas (see FrameArena.h) - no malloc or free.
+	Growing copies into a new arena allocation, DestoryVector is a no-op.
+	A frame vector is valid until the end of the frame, a two frame vector until the end of the next one.
+*/
+void* VectorInitFrame(unsigned int itemSize);
+void* VectorInitTwoFrame(unsigned int itemSize);
+
+/* sets capacity to exactly size if it is larger than the current capacity */
 void* VectorResize(void* vector, unsigned int size);
+
+/* ensures capacity for at least capacity items, growing geometrically so repeated reserves stay amortized O(1) */
+void* VectorReserve(void* vector, unsigned int capacity);
 void* VectorPush(void* vector, void* item);
+
+/* push n contiguous items with one capacity check and one memcpy */
+void* VectorPushN(void* vector, const void* items, unsigned int n);
+
+/*
+	grow the size by n and return, through ppOutItems, a pointer to the first of the n new (uninitialised) items.
+	The returned pointer is only valid until the vector is next grown.
+*/
+void* VectorEmplaceN(void* vector, unsigned int n, void** ppOutItems);
 void* VectorPop(void* vector);
 void* VectorTop(void* vector);
 void* VectorClear(void* vector);
@@ -23,14 +47,23 @@ typedef struct
 	u32 itemSize;
 	u32 capacity;
 	u32 size;
-	u32 _padding;
+	u32 allocator;
 	// 16 byte aligned
 } VectorData;
 
+enum VectorAllocator
+{
+	VA_Heap,
+	VA_Frame,
+	VA_TwoFrame
+};
+
 #define VectorSize(vector) ((((VectorData*)vector) - 1)->size)
 #define VectorData_DEBUG(vector)(((VectorData*)vector) - 1)
 
 #define NEW_VECTOR(a) ((a*)VectorInit(sizeof(a)));
+#define NEW_FRAME_VECTOR(a) ((a*)VectorInitFrame(sizeof(a)))
+#define NEW_TWO_FRAME_VECTOR(a) ((a*)VectorInitTwoFrame(sizeof(a)))
 #define VECTOR(a) a*
 
 #ifdef __cplusplus
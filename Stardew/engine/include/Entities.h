@@ -153,14 +153,41 @@ typedef bool(*Entity2DIterator)(struct Entity2D* pEnt, int i, void* pUser);
 
 void Et2D_IterateEntities(struct Entity2DCollection* pCollection, Entity2DIterator itr, void* pUser);
 
+/* 
+    for calling the per frame handlers - update, post physics and input. Every entity unless the collection uses the component store, 
+    then entities with only stored components and the default handlers are skipped, Co_UpdateComponentStore does their work
+*/
+void Et2D_IterateActiveEntities(struct Entity2DCollection* pCollection, Entity2DIterator itr, void* pUser);
+
 void Et2D_SerializeEntities(struct Entity2DCollection* pCollection, struct BinarySerializer* bs, struct GameLayer2DData* pData, int objectLayer);
 
 void Et2D_DeserializeCommon(struct BinarySerializer* bs, struct Entity2D* pOutEnt);
 void Et2D_SerializeCommon(struct BinarySerializer* bs, struct Entity2D* pInEnt);
 
 void Et2D_InitCollection(struct Entity2DCollection* pCollection);
+
+/* keep the components of entities added from now on in the collections component store, before any entities are added */
+void Et2D_UseComponentStore(struct Entity2DCollection* pCollection);
+
 void Et2D_DestroyCollection(struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer);
 
+/* the entities cached bounding box, refreshed from getBB first if it's dirty */
+void Et2D_GetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR);
+
+void Et2D_MarkBoundingBoxDirty(struct Entity2D* pEnt);
+
+/* 
+    after moving an entity that's in the layers broadphase, marks its bounding box dirty and moves it in the broadphase.
+    In the quadtree it's only relinked if it's left its nodes loose bounds, in the spatial grid if it's changed cells
+*/
+void Et2D_BroadphaseMove(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt);
+
+/* put an entity with bKeepInQuadtree or bKeepInDynamicList in the layers broadphase, see enum Game2DBroadphase. Entity2DOnInit does this */
+void Et2D_AddToBroadphase(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt);
+
+/* Entity2DOnDestroy does this */
+void Et2D_RemoveFromBroadphase(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt);
+
 struct Entity2D
 {
     /* handler functions */
@@ -175,6 +202,20 @@ struct Entity2D
 
     struct Transform2D transform;
     EntityType type;
+
+    /*
+        World space bounding box cached from getBB - culling reads it through Et2D_GetBoundingBox.
+        Set bBBDirty (Et2D_MarkBoundingBoxDirty) after changing anything getBB depends on:
+        the transform, a sprite or an animation frame
+    */
+    vec2 bbTL;
+    vec2 bbBR;
+    bool bBBDirty;
+    /*
+        Set along with bBBDirty, but only cleared when the entity is moved in the layers spatial grid - getting
+        the bounding box clears bBBDirty, which would otherwise leave the grid item where it was
+    */
+    bool bGridStale;
     
     union
     {
@@ -193,6 +234,16 @@ struct Entity2D
     int numComponents;
     struct Component2D components[MAX_COMPONENTS];
 
+    /*
+        Set when the collections component store holds the components data (see Entity2DCollection.h).
+        componentSlots[i] is then component i's index in the store array for its type and components[i].data isn't used
+    */
+    bool bComponentsInStore;
+    int componentSlots[MAX_COMPONENTS];
+
+    /* item in the collections active entities list, NULL_HANDLE if it isn't in it */
+    HDynamicEntityListItem hActiveListRef;
+
     bool bKeepInQuadtree;
 
     /*  */
@@ -204,6 +255,9 @@ struct Entity2D
     /**/
     HDynamicEntityListItem hDynamicListRef;
 
+    /* item in the layers spatial grid, when it's the broadphase */
+    HSpatialGridItem hSpatialGridRef;
+
     /* 
         Which object layer of the scene is it in? 
         Effects the order they are drawn in
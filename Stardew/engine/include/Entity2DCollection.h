@@ -3,6 +3,9 @@
 
 #include "HandleDefs.h"
 #include "ObjectPool.h"
+#include "PagedObjectPool.h"
+#include "DynArray.h"
+#include <stdbool.h>
 
 /*
     Entities that are moving dynamically, we keep in a list so we can cull with brute force.
@@ -25,13 +28,47 @@ struct DynamicEnt2DList
 
 };
 
+/* number of built in component types, enum ComponentType in Entities.h */
+#define NUM_STORED_COMPONENT_TYPES 5
+
+/* the entity a component in the component store belongs to, and its index in the entities components */
+struct ComponentStoreOwner
+{
+    HEntity2D hEnt;
+    int componentIndex;
+};
+
+/*
+    Archetype storage for the built in components. Each component type is packed into an array of its own,
+    indexed by enum ComponentType, so systems can iterate one type linearly (see Co_UpdateComponentStore)
+    instead of walking every entity and switching on each of its components.
+
+    Only entities that use the default update and draw handlers are moved into the store (see Co_StoreComponents),
+    the ones that override them access their components inline. Use Co_GetComponentData and friends to
+    get at an entities component whichever it is.
+*/
+struct ComponentStore
+{
+    bool bEnabled;
+    /* VECTOR(struct Sprite), VECTOR(struct StaticCollider) ... */
+    void* pComponents[NUM_STORED_COMPONENT_TYPES];
+    VECTOR(struct ComponentStoreOwner) pOwners[NUM_STORED_COMPONENT_TYPES];
+};
+
 struct Entity2DCollection
 {
     HEntity2D gEntityListHead;
     HEntity2D gEntityListTail;
     int gNumEnts;
-    OBJECT_POOL(struct Entity2D) pEntityPool;
+    /* paged so that entity pointers stay valid when entities are added, for example by another entities init */
+    PAGED_OBJECT_POOL(struct Entity2D) pEntityPool;
     struct DynamicEnt2DList dynamicEntities;
+    struct ComponentStore componentStore;
+    /*
+        When the component store is in use, the entities Et2D_IterateActiveEntities visits - 
+        all but the ones with stored components and default handlers, which have nothing to do that the stores systems don't
+    */
+    struct DynamicEnt2DList activeEntities;
 };
 
 HDynamicEntityListItem DynL_AddEntity(struct DynamicEnt2DList* pDynList, HEntity2D hEnt);
@@ -0,0 +1,82 @@
+#ifndef ENTITYDRAWORDER_H
+#define ENTITYDRAWORDER_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include "HandleDefs.h"
+#include "IntTypes.h"
+#include <stdbool.h>
+#define VECTOR(a) a*
+
+struct Entity2DCollection;
+
+/*
+    Sorts the visible entities into the order they're drawn in. Each entity gets a 32 bit key, its draw layer
+    in the top bits and its getSortPos quantised below, so getSortPos is called once per entity per frame and
+    the keys can be radix sorted. The last frame's order is kept - this frame's entities are put in it first,
+    which is usually nearly sorted, and insertion sorted, falling back to a radix sort if that's too much work
+*/
+
+/* draw layers above this share the top key */
+#define EDO_KEY_LAYER_BITS 8
+#define EDO_KEY_SORT_POS_BITS (32 - EDO_KEY_LAYER_BITS)
+
+/* sort positions are quantised to 1 / EDO_SORT_POS_STEPS_PER_PX pixels, which leaves a range of about +-2 million pixels */
+#define EDO_SORT_POS_STEPS_PER_PX 4.0f
+
+/* the insertion sort gives up and radix sorts after moving keys this many places per key in total */
+#define EDO_MAX_INSERTION_SHIFTS_PER_KEY 8
+
+struct EntitySortKey
+{
+    u32 key;
+    HEntity2D hEnt;
+};
+
+/* indexed by entity handle */
+struct EntityDrawOrderSlot
+{
+    /* set to frame * 2 when the entity is visible in the current sort, frame * 2 + 1 once it's put in the order */
+    u32 stamp;
+    u32 key;
+};
+
+struct EntityDrawOrder
+{
+    /* the last sorted order */
+    VECTOR(struct EntitySortKey) pKeys;
+    VECTOR(struct EntitySortKey) pScratch;
+    /*
+        Kept here rather than in the entities so the passes over the last order don't touch them.
+        The last order can hold entities destroyed since, whose slots aren't stamped unless reused by a visible entity
+    */
+    VECTOR(struct EntityDrawOrderSlot) pSlots;
+    u32 frame;
+    /* whether the last sort was done by the insertion sort, for benchmarks and the profiler */
+    bool bLastSortCoherent;
+};
+
+void EDO_Init(struct EntityDrawOrder* pOrder);
+
+void EDO_Destroy(struct EntityDrawOrder* pOrder);
+
+u32 EDO_MakeKey(int drawLayer, float sortPos);
+
+/* push a key for each entity, calling getSortPos once for each */
+VECTOR(struct EntitySortKey) EDO_PushKeys(struct Entity2DCollection* pCollection, HEntity2D* pEnts, int numEnts, VECTOR(struct EntitySortKey) pOutKeys);
+
+/* an LSD radix sort a byte at a time, skipping bytes that are the same for every key. pScratch must hold numKeys */
+void EDO_RadixSort(struct EntitySortKey* pKeys, struct EntitySortKey* pScratch, int numKeys);
+
+/* a stable insertion sort, returns false without finishing if it moves keys more than maxShifts places in total */
+bool EDO_InsertionSort(struct EntitySortKey* pKeys, int numKeys, int maxShifts);
+
+/* sort the entities in pEnts into draw order, starting from the last order */
+void EDO_Sort(struct EntityDrawOrder* pOrder, struct Entity2DCollection* pCollection, VECTOR(HEntity2D) pEnts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
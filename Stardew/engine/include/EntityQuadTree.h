@@ -9,12 +9,24 @@ struct GameFrameworkLayer;
 
 struct Entity2DCollection;
 
+/*
+    A loose quadtree - each node's bounds are its quadrant grown by half its size on every side,
+    so an entity is kept in the deepest node its bounding box fits in the loose bounds of and
+    moving entities only need relinking when they leave them (Entity2DQuadTree_Move).
+    Anything outside the root's loose bounds is kept in the root.
+*/
+
+#define ENTITY2DQUADTREE_DEFAULT_MAX_DEPTH 6
+#define ENTITY2DQUADTREE_MAX_DEPTH 16
+
 struct Entity2DQuadTreeInitArgs
 {
     int x;
     int y;
     int w;
     int h;
+    /* 0 for ENTITY2DQUADTREE_DEFAULT_MAX_DEPTH */
+    int maxDepth;
 };
 
 void InitEntity2DQuadtreeSystem();
@@ -23,10 +35,14 @@ HEntity2DQuadtreeNode GetEntity2DQuadTree(struct Entity2DQuadTreeInitArgs* args)
 
 void DestroyEntity2DQuadTree(HEntity2DQuadtreeNode quadTree);
 
-HEntity2DQuadtreeEntityRef Entity2DQuadTree_Insert(struct Entity2DCollection* pCollection, HEntity2DQuadtreeNode quadTree, HEntity2D hEnt, struct GameFrameworkLayer* pLayer, int depth, int maxDepth);
+HEntity2DQuadtreeEntityRef Entity2DQuadTree_Insert(struct Entity2DCollection* pCollection, HEntity2DQuadtreeNode quadTree, HEntity2D hEnt, struct GameFrameworkLayer* pLayer);
+
+/* after the entities bounding box has changed, the ref stays the same */
+void Entity2DQuadTree_Move(HEntity2DQuadtreeEntityRef ref, struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer);
 
 void Entity2DQuadTree_Remove(HEntity2DQuadtreeNode quadTree, HEntity2DQuadtreeEntityRef ent);
 
+/* iterative, pushes the entities whose bounding boxes intersect the region onto outEntities */
 VECTOR(HEntity2D) Entity2DQuadTree_Query(HEntity2DQuadtreeNode quadTree, vec2 regionTL, vec2 regionBR, VECTOR(HEntity2D) outEntities, struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer);
 
 void Entity2DQuadTree_GetDims(HEntity2DQuadtreeNode quadTree, vec2 tl, float* w, float* h);
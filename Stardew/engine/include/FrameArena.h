@@ -0,0 +1,77 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include "IntTypes.h"
+
+/*
+	Linear (bump) allocators for scratch memory that only needs to live for a frame.
+
+	Allocating is a pointer bump, there is no individual free - the whole arena is reset at once.
+	If an allocation doesn't fit it falls back to malloc and the block is freed on the next reset,
+	at which point the arena grows to the high water mark so the same workload fits next frame.
+	In steady state there are no heap allocations at all.
+
+	The engine owns two frame arenas:
+		- the frame arena, reset once per frame in the main loop after drawing.
+		- the two frame arena, double buffered: memory allocated from it in frame N
+		  stays valid until the end of frame N + 1.
+*/
+
+struct ArenaOverflowBlock;
+
+struct LinearArena
+{
+	u8* pMemory;
+	size_t capacity;
+	size_t used;
+	/* most bytes requested between two resets, including any that overflowed to the heap */
+	size_t highWaterMark;
+	/* bytes requested since the last reset, including overflow */
+	size_t requestedThisFrame;
+	u32 numAllocations;
+	u32 numHeapFallbacks;
+	struct ArenaOverflowBlock* pOverflow;
+};
+
+struct FrameArenaStats
+{
+	size_t capacity;
+	size_t bytesUsedLastFrame;
+	size_t highWaterMark;
+	u32 allocationsLastFrame;
+	/* allocations that didn't fit and went to malloc - zero in steady state */
+	u32 heapFallbacksLastFrame;
+};
+
+#define FRAME_ARENA_DEFAULT_CAPACITY (256 * 1024)
+#define FRAME_ARENA_ALIGNMENT 16
+
+void Ar_InitArena(struct LinearArena* pArena, size_t capacity);
+void* Ar_Alloc(struct LinearArena* pArena, size_t size);
+/* frees any overflow blocks and grows to the high water mark if needed */
+void Ar_Reset(struct LinearArena* pArena);
+void Ar_DestroyArena(struct LinearArena* pArena);
+
+void Ar_InitFrameArenas(size_t capacity);
+void Ar_DestroyFrameArenas(void);
+
+/* valid until the end of this frame */
+void* Ar_FrameAlloc(size_t size);
+
+/* valid until the end of the next frame */
+void* Ar_TwoFrameAlloc(size_t size);
+
+/* called once per frame by the main loop */
+void Ar_EndFrame(void);
+
+struct FrameArenaStats Ar_GetFrameArenaStats(void);
+struct FrameArenaStats Ar_GetTwoFrameArenaStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !FRAME_ARENA_H
@@ -12,6 +12,8 @@ extern "C" {
 #include "InputContext.h"
 #include "FreeLookCameraMode.h"
 #include "Entity2DCollection.h"
+#include "SpatialGrid.h"
+#include "EntityDrawOrder.h"
 
 #define MAX_GAME_LAYER_ASSET_FILE_PATH_LEN 128
 
@@ -26,6 +28,7 @@ typedef void (*PreFirstInitFn)(struct GameLayer2DData* pGameLayerData);
 struct GameFrameworkLayer;
 struct DrawContext;
 typedef struct DrawContext DrawContext;
+struct BinarySerializer;
 
 // the real type of this should be hSprite ie u32 but i want to save memory so u16 it is - that 
 // should be enough for anyone - just store the tiles in the first 16 bits worth of indexes
@@ -40,6 +43,7 @@ struct Transform2D
 };
 
 struct TilemapRenderData;
+struct Vert2DTexture;
 struct TilemapLayerRenderData;
 
 enum ObjectLayer2DDrawOrder
@@ -62,6 +66,28 @@ struct TileMapLayer
 	u32 type;
 };
 
+/* how a tile layers tiles are stored in a .tilemap file, written as a u32 before them */
+enum TileLayerCompression
+{
+	/* saving only - whichever of the others is smallest for the layer */
+	TLC_Smallest = 0,
+	/* (run length, tile) u16 pairs, ended by a run of length 0. runs are at most 65535 tiles */
+	TLC_RLE = 1,
+	/* widthTiles * heightTiles u16s */
+	TLC_Uncompressed = 2,
+	/* u32 compressed size then an LZ4 block (see Lz4Block.h) of what TLC_Uncompressed would write */
+	TLC_LZ4 = 3
+};
+
+/* what culls entities and finds them for queries, entities with bKeepInQuadtree or bKeepInDynamicList are kept in it */
+enum Game2DBroadphase
+{
+	/* static entities in a loose quadtree, dynamic list entities culled one by one */
+	G2DBP_Quadtree,
+	/* every entity in a uniform grid over the level - dynamic list entities whose bounding boxes are dirty are moved in it before each query */
+	G2DBP_SpatialGrid
+};
+
 struct TileMap
 {
 	VECTOR(struct TileMapLayer) layers;
@@ -108,11 +134,16 @@ struct GameLayer2DData
 	struct FreeLookCameraModeControls freeLookCtrls;
 
 	/*
-		buffers of vertices and indices populated each frame
+		buffers of entity vertices and indices populated each frame, one object layer at a time.
+		Tile layers are drawn from their own static buffers, see TilemapChunks.h
 	*/
-	VECTOR(struct Worldspace2DVert) pWorldspaceVertices;
+	VECTOR(struct Vert2DTexture) pWorldspaceVertices;
 	VECTOR(VertIndexT) pWorldspaceIndices;
-	H2DWorldspaceVertexBuffer vertexBuffer;
+
+	/*
+		a vertex buffer per object layer, the entities in each are uploaded and drawn between the tile layers either side
+	*/
+	VECTOR(H2DWorldspaceVertexBuffer) objectLayerVertexBuffers;
 
 	/*
 		Path of loaded atlas file
@@ -134,6 +165,11 @@ struct GameLayer2DData
 	*/
 	char debugMsg[256];
 
+	/*
+		id of the "DebugMessage" event, which is fired every frame
+	*/
+	HEvent debugMessageEvent;
+
 	/*
 		Listens for the debug overlay game framework layer being pushed
 	*/
@@ -159,6 +195,27 @@ struct GameLayer2DData
 	*/
 	struct Entity2DCollection entities;
 
+	/*
+		See Game2DLayerOptions
+	*/
+	bool bUseComponentStore;
+
+	/*
+		Which structure culls and queries the entities, see Game2DLayerOptions
+	*/
+	enum Game2DBroadphase broadphase;
+
+	/*
+		Entities grid, when broadphase is G2DBP_SpatialGrid. It covers the same area as the quadtree
+	*/
+	struct SpatialGrid entityGrid;
+	float spatialGridCellSize;
+
+	/*
+		The visible entities last draw order, each frame's sort starts from it
+	*/
+	struct EntityDrawOrder drawOrder;
+
 	/*
 		Game specifi data
 	*/
@@ -183,6 +240,15 @@ struct Game2DLayerOptions
 	const char* atlasFilePath;
 	
 	const char* levelFilePath;
+
+	/* keep entities components in the entity collections component store, see struct ComponentStore */
+	bool bUseComponentStore;
+
+	/* G2DBP_Quadtree by default */
+	enum Game2DBroadphase broadphase;
+
+	/* for G2DBP_SpatialGrid, 0 for SPATIAL_GRID_DEFAULT_CELL_SIZE */
+	float spatialGridCellSize;
 	
 };
 
@@ -190,8 +256,74 @@ void TilemapLayer_GetTLBR(vec2 tl, vec2 br, struct TileMapLayer* pTMLayer);
 
 void Game2DLayer_Get(struct GameFrameworkLayer* pLayer, struct Game2DLayerOptions* pOptions, DrawContext* pDC);
 
+/// <summary>
+/// Output vertices for the tiles of pLayer in the columns [startCol, endCol) and rows [startRow, endRow)
+/// </summary>
+/// <returns> number of non empty tiles output </returns>
+int OutputTilemapLayerTileRange(
+	hAtlas atlas,
+	struct TileMapLayer* pLayer,
+	VECTOR(struct Vert2DTexture)* outVerts,
+	VECTOR(VertIndexT)* outInds,
+	VertIndexT* pNextIndex,
+	int startCol,
+	int endCol,
+	int startRow,
+	int endRow
+);
+
+/// <summary>
+/// Output vertices for the tiles of pLayer that fall within the viewport
+/// </summary>
+void OutputTilemapLayerVertices(
+	hAtlas atlas,
+	struct TileMapLayer* pLayer,
+	VECTOR(struct Vert2DTexture)* outVerts,
+	VECTOR(VertIndexT)* outInds,
+	VertIndexT* pNextIndex,
+	vec2 viewportTL,
+	vec2 viewportBR
+);
+
+/// <summary>
+/// Sort entity handles into the order they're drawn in, by draw layer then each entities getSortPos.
+/// Starts from the last order sorted, see EntityDrawOrder.h
+/// </summary>
+void Game2DLayer_SortEntitiesByDrawOrder(struct GameLayer2DData* pData, VECTOR(HEntity2D) pEnts);
+
+/// <summary>
+/// Push the entities whose cached bounding boxes intersect the region, unsorted. With the quadtree broadphase they're
+/// from the quadtree and the dynamic list, with the spatial grid from the grid after moving the dynamic list entities in it
+/// </summary>
+VECTOR(HEntity2D) Game2DLayer_CullEntities(struct GameLayer2DData* pData, vec2 regionTL, vec2 regionBR, VECTOR(HEntity2D) pOutEntities);
+
+/// <summary>
+/// Push the entities whose cached bounding boxes intersect a circle, for things like tools hitting whatever's in range
+/// </summary>
+VECTOR(HEntity2D) Game2DLayer_QueryEntitiesInRadius(struct GameLayer2DData* pData, vec2 center, float radius, VECTOR(HEntity2D) pOutEntities);
+
+/* tile layers are saved with TLC_Smallest */
 void Game2DLayer_SaveLevelFile(struct GameLayer2DData* pData, const char* outputFilePath);
 
+/// <summary>
+/// Write the compression enum and then the tiles of a tile layer, as they appear in a .tilemap file
+/// </summary>
+void TilemapLayer_SerializeTiles(const struct TileMapLayer* pLayer, enum TileLayerCompression compression, struct BinarySerializer* pBS);
+
+/// <summary>
+/// Read what TilemapLayer_SerializeTiles writes into a newly allocated pLayer->Tiles, widthTiles and heightTiles must be set.
+/// If the data is malformed the tiles are left empty
+/// </summary>
+/// <returns> false if the data was malformed </returns>
+bool TilemapLayer_DeserializeTiles(struct TileMapLayer* pLayer, struct BinarySerializer* pBS);
+
+/// <summary>
+/// Change a tile of a tile layer. Only the chunk of the layer containing the tile is rebuilt, the next time the layer is drawn
+/// </summary>
+void Game2DLayer_SetTile(struct GameLayer2DData* pData, int layerIndex, int col, int row, TileIndex tile);
+
+TileIndex Game2DLayer_GetTile(struct GameLayer2DData* pData, int layerIndex, int col, int row);
+
 void GameLayer2D_OnPush(struct GameFrameworkLayer* pLayer, DrawContext* drawContext, InputContext* inputContext);
 
 void Game2DLayer_OnPop(struct GameFrameworkLayer* pLayer, DrawContext* drawContext, InputContext* inputContext);
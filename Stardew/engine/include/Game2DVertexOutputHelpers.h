@@ -7,6 +7,16 @@ struct _AtlasSprite;
 typedef struct _AtlasSprite AtlasSprite;
 #include "DrawContext.h"
 
+/* write a sprites 4 vertices and 6 indices into space the caller has already made room for, the indices start at base */
+void WriteSpriteQuad(
+	AtlasSprite* pSprite,
+	Worldspace2DVert* pVerts,
+	VertIndexT* pIndices,
+	VertIndexT base,
+	vec2 tlPos,
+	vec2 brPos
+);
+
 void OutputSpriteVerticesBase(
 	AtlasSprite* pSprite,
 	VECTOR(Worldspace2DVert)* pOutVert,
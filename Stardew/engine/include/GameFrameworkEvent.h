@@ -2,6 +2,8 @@
 #define GAMEFRAMEWORKEVENT_H
 
 #include <stdbool.h>
+#include "IntTypes.h"
+#include "HandleDefs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,16 +11,39 @@ extern "C" {
 
 /*
 	Event system used for sending messages between game layers.
+
+	Event names are interned: Ev_RegisterEventName gives each name a small integer id, and
+	firing by id is an array index plus a walk over a contiguous array of listeners.
+	Code that fires an event often should register its name once, at load time, and use Ev_FireEventById.
+
+	Events can also be queued with Ev_QueueEvent, the queue is drained once per frame by GF_EndFrame.
 */
 
 struct GameFrameworkEventListener;
 
 typedef void (*EventListenerFn)(void* pUserData, void* pEventData);
 
+/* returns the id for eventName, registering it if it is new */
+HEvent Ev_RegisterEventName(const char* eventName);
+
 struct GameFrameworkEventListener* Ev_SubscribeEvent(char* eventName, EventListenerFn listenerFn, void* pUser);
+struct GameFrameworkEventListener* Ev_SubscribeEventById(HEvent event, EventListenerFn listenerFn, void* pUser);
 bool Ev_UnsubscribeEvent(struct GameFrameworkEventListener* pListener);
 void* Ev_GetUserData(struct GameFrameworkEventListener* pListener);
 void Ev_FireEvent(char* eventName, void* eventArgs);
+void Ev_FireEventById(HEvent event, void* eventArgs);
+
+/// <summary>
+/// Queue an event to be fired when the queue is next drained.
+/// argsSize bytes are copied from eventArgs - anything they point to must still be valid when the queue is drained.
+/// </summary>
+void Ev_QueueEvent(HEvent event, const void* eventArgs, u32 argsSize);
+
+/// <summary>
+/// Fire all queued events in the order they were queued. Events queued by listeners while draining are fired next drain
+/// </summary>
+void Ev_DrainEventQueue();
+
 void Ev_Init();
 
 #ifdef __cplusplus
@@ -26,5 +51,3 @@ void Ev_Init();
 #endif
 
 #endif
-
-
@@ -16,4 +16,6 @@ bool Ge_PointInAABB(float pointX, float pointY, GeomRect rect);
 
 bool Ge_AABBIntersect(vec2 tl1, vec2 br1, vec2 tl2, vec2 br2);
 
+bool Ge_CircleAABBIntersect(vec2 center, float radius, vec2 tl, vec2 br);
+
 #endif
\ No newline at end of file
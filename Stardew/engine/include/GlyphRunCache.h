@@ -0,0 +1,64 @@
+#ifndef GLYPH_RUN_CACHE_H
+#define GLYPH_RUN_CACHE_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "IntTypes.h"
+#include "HandleDefs.h"
+
+/*
+	Caches the measurements of strings drawn in a font, see Fo_GetGlyphRun.
+
+	UI layout measures the same strings over and over - every layout pass asks each text widget for
+	its width and height, then outputting its vertices asks for its bearing. Each of those walked the
+	string looking up every glyph. Now they share one glyph run per (atlas, font, string), kept in a
+	fixed size least recently used cache.
+
+	Entries are found by a hash of the string but the string itself is compared too, so a collision
+	can't return another strings measurements. Main thread only.
+*/
+
+#define GLYPH_RUN_CACHE_SIZE 1024
+
+struct GlyphRun
+{
+	/* sum of the glyphs x advances */
+	float width;
+	/* highest any glyph reaches above the baseline, 0 or more */
+	float maxYBearing;
+	/* lowest any glyph reaches below the baseline, 0 or less */
+	float minBelowBaseline;
+	/* maxYBearing - minBelowBaseline */
+	float height;
+};
+
+struct GlyphRunCacheStats
+{
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+};
+
+u64 GRC_HashString(const char* str, size_t len);
+
+/* NULL if it isn't cached, otherwise valid until the next GRC_Insert */
+const struct GlyphRun* GRC_Find(hAtlas atlas, HFont font, const char* str, size_t len, u64 hash);
+
+/* evicts the least recently used run if the cache is full */
+void GRC_Insert(hAtlas atlas, HFont font, const char* str, size_t len, u64 hash, const struct GlyphRun* pRun);
+
+/* drop every run measured in an atlas, for when it's destroyed and its handle may be reused */
+void GRC_InvalidateAtlas(hAtlas atlas);
+
+void GRC_Clear();
+
+struct GlyphRunCacheStats GRC_GetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef GLYPH_SHELF_PACKER_H
+#define GLYPH_SHELF_PACKER_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdbool.h>
+#include "IntTypes.h"
+#include "DynArray.h"
+
+/*
+	Packs glyphs into a fixed region of a texture as they're rasterised, for dynamic fonts (see At_AddFont).
+
+	The region is split into shelves - rows the full width of the region, each as tall as the glyph
+	that opened it rounded up to GLYPH_SHELF_HEIGHT_STEP. Glyphs go left to right along the shelf
+	that fits them with the least height to spare.
+
+	When there's no room the least recently used shelf is emptied and reused, every glyph in it is
+	passed to the evicted callback. Shelves used in the current frame are never evicted, so a frame
+	can't evict a glyph it's already output vertices for - GSP_Alloc fails instead.
+*/
+
+#define GLYPH_SHELF_HEIGHT_STEP 4
+#define GLYPH_SHELF_NONE -1
+
+typedef void(*GlyphEvictedFn)(void* pUser, u64 glyph);
+
+struct GlyphShelf
+{
+	int y;
+	int height;
+	/* x of the next glyph, relative to the region */
+	int nextX;
+	u32 lastUsedFrame;
+	/* what was passed to GSP_Alloc for each glyph in the shelf */
+	VECTOR(u64) glyphs;
+};
+
+struct GlyphShelfPacker
+{
+	/* the region, in texture pixels */
+	int x, y, width, height;
+	/* y of the next shelf, relative to the region */
+	int nextShelfY;
+	VECTOR(struct GlyphShelf) shelves;
+	GlyphEvictedFn fnEvicted;
+	void* pUser;
+	u64 numEvictedShelves;
+	u64 numEvictedGlyphs;
+};
+
+void GSP_Init(struct GlyphShelfPacker* pPacker, int x, int y, int width, int height, GlyphEvictedFn fnEvicted, void* pUser);
+
+void GSP_DeInit(struct GlyphShelfPacker* pPacker);
+
+/// <summary>
+/// Find room for a w x h glyph, evicting the least recently used shelf not used in frame if there isn't any
+/// </summary>
+/// <param name="glyph"> passed to the evicted callback if the glyph is evicted later </param>
+/// <param name="pOutX"> top left x in texture pixels </param>
+/// <param name="pOutY"> top left y in texture pixels </param>
+/// <returns> the shelf it's in, for GSP_Touch, GLYPH_SHELF_NONE if there's no room </returns>
+int GSP_Alloc(struct GlyphShelfPacker* pPacker, int w, int h, u32 frame, u64 glyph, int* pOutX, int* pOutY);
+
+/* mark a shelf used in frame */
+void GSP_Touch(struct GlyphShelfPacker* pPacker, int shelf, u32 frame);
+
+/* empty every shelf, the evicted callback isn't called */
+void GSP_Clear(struct GlyphShelfPacker* pPacker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
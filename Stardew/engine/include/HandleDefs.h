@@ -25,6 +25,8 @@ typedef HGeneric HUIVertexBuffer;
 
 typedef HGeneric H2DWorldspaceVertexBuffer;
 
+typedef HGeneric HTilemapUVTable;
+
 typedef HGeneric HFont;
 
 typedef HGeneric HMouseAxisBinding;
@@ -39,6 +41,9 @@ typedef HGeneric HEntity2D;
 
 typedef HGeneric HPhysicsWorld;
 
+typedef HGeneric HEvent;
+#define NULL_HEVENT -1
+
 typedef HGeneric H2DBody;
 
 typedef HGeneric HEntity2DQuadtreeNode;
@@ -47,6 +52,8 @@ typedef HGeneric HEntity2DQuadtreeEntityRef;
 
 typedef HGeneric HDynamicEntityListItem;
 
+typedef HGeneric HSpatialGridItem;
+
 #define NULL_HANDLE -1
 
 
@@ -11,10 +11,25 @@ struct ImageFile
 {
 	char* path;
 	bool bLoaded;
+	/* an IR_LoadImageAsync decode is in flight */
+	bool bLoading;
+	/* the last load failed */
+	bool bLoadFailed;
 	u8* pData;
 	int width, height;
 };
 
+enum ImageLoadState
+{
+	ILS_Unloaded,
+	ILS_Loading,
+	ILS_Loaded,
+	ILS_Failed
+};
+
+/* bLoaded is false if the image couldn't be decoded */
+typedef void(*ImageLoadedFn)(HImage hImage, bool bLoaded, void* pUser);
+
 struct ImageLoadError
 {
 	char* message;
@@ -23,8 +38,11 @@ struct ImageLoadError
 
 HImage IR_RegisterImagePath(const char* path);
 
+/* paths include the registry folder (normally "./Assets/") IR_RegisterImagePath prepends */
 HImage IR_LookupHandleByPath(const char* path);
 
+int IR_GetNumImages();
+
 bool IR_IsImageLoaded(HImage hImage);
 
 u8* IR_GetImageData(HImage img);
@@ -33,6 +51,57 @@ const struct ImageFile* IR_GetImageFile(HImage img);
 
 bool IR_LoadImageSync(HImage hImage, VECTOR(struct ImageLoadError) outErrors);
 
+/* frees a loaded images pixels, IR_GetImageData will load it again */
+void IR_UnloadImage(HImage hImage);
+
+/*
+	Decode an image file to CHANNELS_PER_PIXEL pixels without registering it, safe to call from any thread.
+	NULL if it can't be loaded, free the pixels with IR_FreeDecodedImage
+*/
+u8* IR_DecodeImageFile(const char* path, int* pOutWidth, int* pOutHeight);
+
+void IR_FreeDecodedImage(u8* pData);
+
+/*
+	Asynchronous loading.
+
+	IR_LoadImageAsync queues the image to be decoded on a pool of decode threads and returns
+	straight away. The HImage then works as a future: IR_GetImageLoadState polls it and
+	IR_WaitForImage blocks until it's done. Decoded images are only handed over to the registry by
+	IR_PollImageLoads, which the engine calls on the main thread once a frame, so the registry
+	itself is still only touched from the main thread. onLoaded is called from there too, which
+	makes it the place to upload the image as a texture.
+
+	The synchronous functions wait for an async load of the same image rather than decoding it
+	again.
+*/
+
+/* how many threads decode images, 0 for one per CPU (the default). Waits for loads in flight */
+void IR_SetNumDecodeThreads(int numThreads);
+
+/// <summary>
+/// Start decoding an image on the decode threads
+/// </summary>
+/// <param name="onLoaded"> optional, called from IR_PollImageLoads once the image is loaded or fails to. If it's already loaded it's called from the next IR_PollImageLoads </param>
+/// <returns> false if hImage is out of range </returns>
+bool IR_LoadImageAsync(HImage hImage, ImageLoadedFn onLoaded, void* pUser);
+
+enum ImageLoadState IR_GetImageLoadState(HImage hImage);
+
+/* blocks until an async load of hImage finishes. true if the image is loaded. onLoaded callbacks still wait for IR_PollImageLoads */
+bool IR_WaitForImage(HImage hImage);
+
+/* blocks until every async load finishes, like IR_WaitForImage */
+void IR_WaitForAllImages();
+
+/* hand decoded images to the registry and call their onLoaded callbacks, main thread only */
+void IR_PollImageLoads();
+
+/// <summary>
+/// Register the images listed in a registry json file. Image paths in it, and ones passed to
+/// IR_RegisterImagePath, are relative to the folder the json file is in
+/// </summary>
+/// <param name="jsonPath"> NULL for ./Assets/ImageFiles.json </param>
 void IR_InitImageRegistry(const char* jsonPath);
 
 void IR_DestroyImageRegistry();
@@ -0,0 +1,41 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include "IntTypes.h"
+
+/*
+	A small LZ4 block format compressor and decompressor.
+
+	Produces and reads plain LZ4 blocks (no frame header or checksums), so data compressed here can be
+	read by any LZ4 implementation and vice versa. engine/scripts/ConvertTiled.py has a python port of
+	the compressor for compressing tile layers offline.
+
+	The compressor is greedy with a single entry hash table - fast, but it won't find the best matches.
+	The decompressor checks every length and offset against the buffers, malformed input fails rather
+	than reading or writing out of bounds.
+*/
+
+/* the most bytes compressing srcSize bytes can produce, for sizing the destination */
+size_t Lz_CompressBound(size_t srcSize);
+
+/// <summary>
+/// Compress src into dst as one LZ4 block
+/// </summary>
+/// <returns> compressed size, 0 if dst is too small </returns>
+size_t Lz_CompressBlock(const u8* src, size_t srcSize, u8* dst, size_t dstCapacity);
+
+/// <summary>
+/// Decompress one LZ4 block from src into dst, bytes of dst after the decompressed data may be overwritten too
+/// </summary>
+/// <returns> decompressed size, -1 if the block is malformed or doesn't fit in dstCapacity </returns>
+i64 Lz_DecompressBlock(const u8* src, size_t srcSize, u8* dst, size_t dstCapacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+	Cross platform abstraction for mapping a whole file into memory, read only.
+
+	The pages are read from the file as they're touched and are clean, so the OS can drop them again
+	under memory pressure - mapping a big file and reading part of it doesn't cost the whole file in memory.
+*/
+
+struct MappedFile;
+
+/* NULL if the file can't be opened or mapped */
+struct MappedFile* MappedFile_Open(const char* path);
+
+/* page aligned, valid until MappedFile_Close */
+const void* MappedFile_GetData(const struct MappedFile* pFile);
+
+size_t MappedFile_GetSize(const struct MappedFile* pFile);
+
+void MappedFile_Close(struct MappedFile* pFile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
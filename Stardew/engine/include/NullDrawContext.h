@@ -0,0 +1,44 @@
+#ifndef NULLDRAWCONTEXT_H
+#define NULLDRAWCONTEXT_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "DrawContext.h"
+
+/*
+	A DrawContext that doesn't call GL - it records what would have been sent to the GPU instead.
+	Lets the game framework, Game2D and UI layers run without a window, for benchmarks and CI.
+*/
+
+struct NullDrawCounters
+{
+	u32 drawCalls;
+	/* vertices for UI and tilemap chunk draws, indices for worldspace draws */
+	u64 verticesDrawn;
+	/* vertex, index and texture data passed to the context */
+	u64 bytesUploaded;
+};
+
+struct NullDrawStats
+{
+	struct NullDrawCounters lastFrame;
+	struct NullDrawCounters total;
+	u32 numLiveBuffers;
+	/* what the GL context would have allocated for the live buffers */
+	u64 liveBufferBytes;
+	u32 numTexturesUploaded;
+};
+
+DrawContext Dr_InitNullDrawContext();
+void Dr_DestroyNullDrawContext();
+
+/* call once per frame - moves the current frames counters into lastFrame */
+void Dr_NullDrawContextEndFrame();
+struct NullDrawStats Dr_GetNullDrawStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,16 +2,41 @@
 #define OBJECT_POOL_H
 #ifdef __cplusplus
 extern "C"{
-#endif 
+#endif
 
+#include <stdbool.h>
 #include "IntTypes.h"
+#include "HandleDefs.h"
 
 void* InitObjectPool(int objectSize, int poolInitialSize);
 
+/*
+	A pool whose handles carry a generation count as well as an index - see GetObjectPoolHandle.
+	Plain index functions (GetObjectPoolIndex, FreeObjectPoolIndex) still work on these pools,
+	but bypass the generation check.
+*/
+void* InitGenerationalObjectPool(int objectSize, int poolInitialSize);
+
 void* GetObjectPoolIndex(void* pObjectPool, int* pOutIndex);
 
 void FreeObjectPoolIndex(void* pObjectPool, int indexToFree);
 
+/*
+	Generational handle variants. Only valid on pools created with NEW_GENERATIONAL_OBJECT_POOL.
+
+	The handle packs the slot index into the low OBJECT_POOL_HANDLE_INDEX_BITS bits and the slots
+	generation into the bits above it. Freeing a slot bumps its generation, so any handle
+	still held to the old occupant no longer validates. All O(1).
+*/
+void* GetObjectPoolHandle(void* pObjectPool, HGeneric* pOutHandle);
+
+/* returns false (and does nothing) if the handle is stale, out of range, or already freed */
+bool FreeObjectPoolHandle(void* pObjectPool, HGeneric handle);
+
+bool ObjectPoolHandleValid(void* pObjectPool, HGeneric handle);
+
+bool ObjectPoolIndexOccupied(void* pObjectPool, int index);
+
 void* FreeObjectPool(void* pObjectPool);
 
 struct ObjectPoolData
@@ -20,11 +45,28 @@ struct ObjectPoolData
 	i64 capacity;
 	i64 freeObjectsArraySize;
 	u64* freeObjectIndicessArray;
+	/* one bit per slot, set when the slot is handed out */
+	u64* occupancyBits;
+	/* per slot generation, NULL unless this is a generational pool */
+	u16* generations;
 	// 16 byte aligned
 };
 
+#define OBJECT_POOL_HANDLE_INDEX_BITS 20
+#define OBJECT_POOL_HANDLE_INDEX_MASK ((1 << OBJECT_POOL_HANDLE_INDEX_BITS) - 1)
+/* 11 bits - the sign bit is left clear so NULL_HANDLE can never validate */
+#define OBJECT_POOL_HANDLE_GENERATION_MASK 0x7ff
+#define OBJECT_POOL_MAX_GENERATIONAL_CAPACITY (1 << OBJECT_POOL_HANDLE_INDEX_BITS)
+
+#define ObjectPoolHandleIndex(handle) ((handle) & OBJECT_POOL_HANDLE_INDEX_MASK)
+#define ObjectPoolHandleGeneration(handle) (((handle) >> OBJECT_POOL_HANDLE_INDEX_BITS) & OBJECT_POOL_HANDLE_GENERATION_MASK)
+
 #define OBJECT_POOL(a) a*
 #define NEW_OBJECT_POOL(a, size) ((a*)InitObjectPool(sizeof(a),size))
+#define NEW_GENERATIONAL_OBJECT_POOL(a, size) ((a*)InitGenerationalObjectPool(sizeof(a),size))
+
+/* element access through a generational handle */
+#define ObjectPoolAtHandle(pObjectPool, handle) (&(pObjectPool)[ObjectPoolHandleIndex(handle)])
 
 #define ObjectPoolCapacity(pObjectPool) ((((struct ObjectPoolData*)pObjectPool) - 1)->capacity)
 
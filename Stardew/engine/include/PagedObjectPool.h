@@ -0,0 +1,61 @@
+#ifndef PAGED_OBJECT_POOL_H
+#define PAGED_OBJECT_POOL_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdbool.h>
+#include "IntTypes.h"
+
+/*
+	An object pool made of fixed size blocks behind a block table.
+
+	Unlike OBJECT_POOL, objects never move when the pool grows - growing allocates one new block
+	and appends it to the table, so a pointer into the pool stays valid until its slot is freed
+	and callers don't have to reassign the pool after getting an index.
+
+	Index to pointer is a shift and a mask, see PagedObjectPoolAt.
+
+	Free slots form an intrusive singly linked list (the first 4 bytes of a free slot hold the next free index),
+	each block ends with an occupancy bitmap used to catch double frees.
+*/
+
+struct PagedObjectPool
+{
+	/* size of each slot, at least sizeof(i32) so a free slot can hold its free list link */
+	int objectStride;
+	/* objects per block == 1 << blockShift */
+	int blockShift;
+	int blockMask;
+	int numBlocks;
+	int blockTableCapacity;
+	int numAllocated;
+	int freeListHead;
+	char** ppBlocks;
+};
+
+#define PAGED_OBJECT_POOL_DEFAULT_BLOCK_SHIFT 9
+
+struct PagedObjectPool* InitPagedObjectPool(int objectSize, int blockShift);
+
+/* returns index of a free slot, adding a block if there are none. Never moves existing objects */
+int GetPagedObjectPoolIndex(struct PagedObjectPool* pPool);
+
+void FreePagedObjectPoolIndex(struct PagedObjectPool* pPool, int indexToFree);
+
+bool PagedObjectPoolIndexOccupied(struct PagedObjectPool* pPool, int index);
+
+void* FreePagedObjectPool(struct PagedObjectPool* pPool);
+
+#define PAGED_OBJECT_POOL(a) struct PagedObjectPool*
+#define NEW_PAGED_OBJECT_POOL(a, blockShift) InitPagedObjectPool(sizeof(a), blockShift)
+
+#define PagedObjectPoolCapacity(pPool) ((pPool)->numBlocks << (pPool)->blockShift)
+
+#define PagedObjectPoolAt(a, pPool, index) \
+	((a*)((pPool)->ppBlocks[(index) >> (pPool)->blockShift] + (size_t)((index) & (pPool)->blockMask) * (pPool)->objectStride))
+
+#ifdef __cplusplus
+}
+#endif
+#endif // ! PAGED_OBJECT_POOL_H
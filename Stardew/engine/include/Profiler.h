@@ -0,0 +1,130 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdbool.h>
+#include "IntTypes.h"
+
+/*
+	Scoped CPU profiler.
+
+	Only compiled in when STARDEW_PROFILER is defined (the STARDEW_ENABLE_PROFILER cmake option),
+	otherwise every PROFILE_ macro below expands to nothing.
+
+	PROFILE_ZONE times the statement or block that follows it:
+
+		PROFILE_ZONE("Game2D.OutputVertices")
+		{
+			...
+		}
+
+	Zone names must be string literals, only the pointer is kept. Don't return or break out of a
+	zones block - the end of the zone would be skipped. For spans that aren't a single block use
+	PROFILE_ZONE_BEGIN and PROFILE_ZONE_END.
+
+	Each thread writes its finished zones, with nanosecond timestamps, into its own ring buffer.
+	PROFILE_FRAME_MARK is called once per frame by the main loop: it totals up the zones that
+	finished during the frame (the per zone timings the lua binding reads) and records the frame
+	along with its counters. Prof_ExportChromeTrace writes whatever is still in the ring buffers
+	as chrome about:tracing JSON.
+*/
+
+/* zones per thread kept for export, must be a power of 2 */
+#define PROFILER_RING_BUFFER_SIZE (1 << 16)
+#define PROFILER_MAX_THREADS 16
+#define PROFILER_MAX_ZONE_DEPTH 64
+/* distinct zone names that get per zone timings */
+#define PROFILER_MAX_ZONE_STATS 128
+/* frames kept for export, must be a power of 2 */
+#define PROFILER_MAX_FRAMES 1024
+#define PROFILER_TRACE_PATH "./StardewTrace.json"
+
+enum ProfileCounter
+{
+	PC_DrawCalls,
+	PC_VerticesDrawn,
+	PC_EntitiesUpdated,
+	PC_NumCounters
+};
+
+struct ProfileZoneStats
+{
+	const char* name;
+	/* depth the zone was first seen at, for indenting */
+	u32 depth;
+	u32 lastFrameCalls;
+	/* total time spent in the zone last frame, including child zones */
+	double lastFrameMs;
+	/* moving average of lastFrameMs */
+	double avgMs;
+	double maxMs;
+};
+
+struct ProfileFrameStats
+{
+	u64 frameIndex;
+	double frameMs;
+	u32 counters[PC_NumCounters];
+};
+
+#ifdef STARDEW_PROFILER
+
+void Prof_Init(void);
+void Prof_Shutdown(void);
+
+u64 Prof_NowNs(void);
+
+void Prof_BeginZone(const char* name);
+void Prof_EndZone(void);
+
+void Prof_AddCounter(enum ProfileCounter counter, u32 amount);
+
+/* ends the current frame, called once per frame by the main loop */
+void Prof_FrameMark(void);
+
+/// <summary>
+/// Per zone timings as of the last frame mark, in the order the zones were first seen.
+/// Only valid until the next frame mark
+/// </summary>
+/// <param name="pOutNumZones"> number of zones </param>
+/// <returns> array of zone stats </returns>
+const struct ProfileZoneStats* Prof_GetZoneStats(int* pOutNumZones);
+
+struct ProfileFrameStats Prof_GetLastFrameStats(void);
+
+const char* Prof_GetCounterName(enum ProfileCounter counter);
+
+/// <summary>
+/// Write the zones, frames and counters still in the ring buffers to a chrome about:tracing JSON file.
+/// Call from the main thread, zones other threads are writing at the time may be missed
+/// </summary>
+bool Prof_ExportChromeTrace(const char* path);
+
+/* export to PROFILER_TRACE_PATH at the next frame mark, can be called from an input callback */
+void Prof_RequestExport(void);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) for (int PROFILE_CONCAT(profZone, __LINE__) = (Prof_BeginZone(name), 1); PROFILE_CONCAT(profZone, __LINE__); Prof_EndZone(), PROFILE_CONCAT(profZone, __LINE__) = 0)
+#define PROFILE_ZONE_BEGIN(name) Prof_BeginZone(name)
+#define PROFILE_ZONE_END() Prof_EndZone()
+#define PROFILE_COUNTER_ADD(counter, amount) Prof_AddCounter(counter, amount)
+#define PROFILE_FRAME_MARK() Prof_FrameMark()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_BEGIN(name)
+#define PROFILE_ZONE_END()
+#define PROFILE_COUNTER_ADD(counter, amount)
+#define PROFILE_FRAME_MARK()
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !PROFILER_H
@@ -0,0 +1,39 @@
+#ifndef QOI_H
+#define QOI_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "IntTypes.h"
+
+/*
+	Lossless RGBA image compression using the ops of the QOI format (https://qoiformat.org).
+
+	Only the stream of ops is written, not QOI's header or end marker - whatever stores the data
+	stores the image dimensions. Decoding is a single pass with a 64 entry colour table and no
+	back references into the output, so it can decode into write only memory like a mapped GL buffer.
+	Malformed input fails rather than reading or writing out of bounds.
+*/
+
+/* the most bytes encoding numPixels pixels can produce, for sizing the destination */
+size_t Qoi_EncodeBound(size_t numPixels);
+
+/// <summary>
+/// Encode numPixels RGBA pixels
+/// </summary>
+/// <returns> encoded size, 0 if dst is too small </returns>
+size_t Qoi_Encode(const u8* rgba, size_t numPixels, u8* dst, size_t dstCapacity);
+
+/// <summary>
+/// Decode exactly numPixels RGBA pixels into dst
+/// </summary>
+/// <returns> false if src is malformed or doesn't decode to numPixels pixels </returns>
+bool Qoi_Decode(const u8* src, size_t srcSize, u8* dst, size_t numPixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
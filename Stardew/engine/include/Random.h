@@ -3,6 +3,8 @@
 
 float Ra_FloatBetween(float min, float max);
 unsigned int Ra_SeedFromTime();
+/* for repeatable runs, like benchmarks */
+void Ra_Seed(unsigned int seed);
 unsigned int Ra_RandZeroTo(int maxExclusive);
 
 #endif
\ No newline at end of file
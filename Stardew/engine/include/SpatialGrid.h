@@ -0,0 +1,76 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include "HandleDefs.h"
+#include "IntTypes.h"
+#include <cglm/cglm.h>
+#include <stdbool.h>
+#define VECTOR(a) a*
+#define OBJECT_POOL(a) a*
+
+/*
+    A uniform grid of square cells over a bounded level, an alternative broadphase to the entity quadtree
+    (see Game2DLayerOptions). Each cell keeps a list of the items whose boxes overlap it, items outside
+    the grid go in the cells on its edge. An item's box is stored in the item, so queries don't need the
+    entities themselves - it's updated by SG_Move.
+*/
+
+#define SPATIAL_GRID_DEFAULT_CELL_SIZE 128.0f
+
+struct SpatialGridItem
+{
+    HEntity2D hEnt;
+    vec2 tl;
+    vec2 br;
+    /* the range of cells it's in, inclusive */
+    int cellTLX, cellTLY, cellBRX, cellBRY;
+    /* the last query that visited it, so items in several cells are only tested once */
+    u32 lastQuery;
+};
+
+struct SpatialGrid
+{
+    vec2 tl;
+    float cellSize;
+    int cols;
+    int rows;
+    /* cols * rows, row major, NULL until something is put in them */
+    VECTOR(HSpatialGridItem)* pCells;
+    OBJECT_POOL(struct SpatialGridItem) pItems;
+    u32 queryCounter;
+};
+
+void SG_Init(struct SpatialGrid* pGrid, vec2 tl, float w, float h, float cellSize);
+
+void SG_Destroy(struct SpatialGrid* pGrid);
+
+HSpatialGridItem SG_Insert(struct SpatialGrid* pGrid, HEntity2D hEnt, vec2 tl, vec2 br);
+
+/* update the items box, it's only relinked if the range of cells it overlaps changes */
+void SG_Move(struct SpatialGrid* pGrid, HSpatialGridItem hItem, vec2 tl, vec2 br);
+
+void SG_Remove(struct SpatialGrid* pGrid, HSpatialGridItem hItem);
+
+/* push the entities whose boxes intersect the rectangle */
+VECTOR(HEntity2D) SG_QueryRect(struct SpatialGrid* pGrid, vec2 tl, vec2 br, VECTOR(HEntity2D) pOutEntities);
+
+/* push the entities whose boxes intersect the circle */
+VECTOR(HEntity2D) SG_QueryRadius(struct SpatialGrid* pGrid, vec2 center, float radius, VECTOR(HEntity2D) pOutEntities);
+
+/* tests an entity found in the cells SG_QueryCells searches, pUser is the one passed to it */
+typedef bool(*SpatialGridTestFn)(HEntity2D hEnt, void* pUser);
+
+/*
+    push the entities in the cells the rectangle covers that fnTest accepts, each once - for callers with a
+    newer box for an item than the one it was last moved with, like the Game2D layer's cached bounding boxes
+*/
+VECTOR(HEntity2D) SG_QueryCells(struct SpatialGrid* pGrid, vec2 tl, vec2 br, SpatialGridTestFn fnTest, void* pUser, VECTOR(HEntity2D) pOutEntities);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,42 +3,78 @@
 
 #ifdef __cplusplus
 extern "C" {
-#endif 
+#endif
 
 
 #include <stdbool.h>
+#include "IntTypes.h"
+
+/*
+	Open addressing hashmap with string keys, see StringKeyHashMap.c.
+
+	Values are stored by copy. Pointers to values (and keys returned by the iterator)
+	stay valid until the map next grows, which can happen on any insert.
+*/
 
 struct HashMap
 {
+	/* number of slots, always a power of two */
 	int capacity;
+	/* number of live keys */
 	int size;
 	int valueSize;
-	void* pData;
-	struct KVP* pHead;
-	struct KVP* pEnd;
 	float fLoadFactor;
+
+	/* one byte per slot: empty, deleted, or the low 7 bits of the keys hash */
+	u8* pCtrl;
+	/* per slot index into pEntries */
+	i32* pSlotEntries;
+	/* keys, hashes and values, in insertion order. Deleted entries stay until the next rehash */
+	char* pEntries;
+	int entryStride;
+	int numEntries;
+	int numTombstones;
+
+	/* every key is copied into this one buffer, entries refer to keys by offset */
+	char* pKeySlab;
+	int keySlabSize;
+	int keySlabCapacity;
 };
 
 void HashmapInit(struct HashMap* pMap, int capacity, int valSize);
 void HashmapInitWithLoadFactor(struct HashMap* pMap, int capacity, int valSize, float loadFactor);
-void* HashmapSearch(struct HashMap* pMap, char* key);
 
 /// <summary>
-/// 
+/// The hash used for keys. Lets callers hash a key once, for example at load time,
+/// and then use HashmapSearchHashed
+/// </summary>
+u32 HashmapHashKey(const char* key);
+
+void* HashmapSearch(struct HashMap* pMap, const char* key);
+
+/// <summary>
+/// Search with a hash precomputed by HashmapHashKey. The key is still compared in full
+/// </summary>
+void* HashmapSearchHashed(struct HashMap* pMap, const char* key, u32 hash);
+
+/// <summary>
+///
 /// </summary>
 /// <param name="pMap"></param>
 /// <param name="key"></param>
 /// <param name="pVal"></param>
-/// <returns> true if a new key and inserted, false if an existing key and value overwritten </returns>
-void* HashmapInsert(struct HashMap* pMap, char* key, void* pVal);
-bool HashmapDeleteItem(struct HashMap* pMap, char* key);
+/// <returns> pointer to the inserted value if a new key, NULL if an existing key and value overwritten </returns>
+void* HashmapInsert(struct HashMap* pMap, const char* key, void* pVal);
+void* HashmapInsertHashed(struct HashMap* pMap, const char* key, u32 hash, void* pVal);
+bool HashmapDeleteItem(struct HashMap* pMap, const char* key);
 void HashmapDeInit(struct HashMap* pMap);
 void HashmapPrintEntries(struct HashMap* pMap, const char* hashMapName);
 
+/* iterates keys in insertion order */
 struct HashmapKeyIterator
 {
 	struct HashMap* pHashMap;
-	struct KVP* pOnKVP;
+	int onEntry;
 };
 
 struct HashmapKeyIterator GetKeyIterator(struct HashMap* pHashMap);
@@ -48,4 +84,4 @@ char* NextHashmapKey(struct HashmapKeyIterator*);
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
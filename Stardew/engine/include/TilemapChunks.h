@@ -0,0 +1,93 @@
+#ifndef TILEMAPCHUNKS_H
+#define TILEMAPCHUNKS_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <cglm/types.h>
+#include "IntTypes.h"
+#include "HandleDefs.h"
+#include "DynArray.h"
+
+/*
+	Static vertex buffers for tilemap layers.
+
+	Each tile layer is split into TILEMAP_CHUNK_TILES x TILEMAP_CHUNK_TILES tile chunks. A chunks
+	vertices are built and uploaded once, when the level is loaded, and each frame the chunks
+	that overlap the viewport are drawn straight from their buffers.
+
+	Changing a tile (Game2DLayer_SetTile) marks its chunk dirty and only that chunk is rebuilt,
+	the next time the layer is drawn.
+
+	If the draw context can vertex pull tilemaps (DrawContext.NewTileIndexTexture) and the atlas' tileset
+	fits in a uv table, the layer has no vertex buffers at all - its tile indices are uploaded to a texture
+	and each visible chunk is one DrawTilemapChunk call. Changing a tile is then a single texel write.
+*/
+
+#define TILEMAP_CHUNK_TILES 32
+
+struct TileMapLayer;
+struct DrawContext;
+
+struct TilemapChunk
+{
+	/* NULL_HANDLE until the chunk has a non empty tile */
+	H2DWorldspaceVertexBuffer hVertexBuffer;
+	u32 numIndices;
+	u32 numTiles;
+	bool bDirty;
+};
+
+struct TilemapLayerRenderData
+{
+	/* row major, widthChunks * heightChunks */
+	struct TilemapChunk* pChunks;
+	int widthChunks;
+	int heightChunks;
+	int numDirtyChunks;
+
+	/* the chunks have no vertex buffers, they're drawn from hTileIndexTexture and hUVTable */
+	bool bVertexPulled;
+	hTexture hTileIndexTexture;
+	HTilemapUVTable hUVTable;
+	/* row * widthTiles + col of each tile changed since the last rebuild, vertex pulled layers only */
+	VECTOR(int) pDirtyTiles;
+};
+
+/// <summary>
+/// Build the vertex pulling uv table for an atlas' tileset:
+/// a top left u, v, bottom right u, v per tile index, the same uvs OutputTilemapLayerVertices outputs.
+/// Entry 0, the empty tile, is zeroed.
+/// </summary>
+/// <param name="outUVs"> room for TILEMAP_UV_TABLE_MAX_TILES * 4 floats </param>
+/// <returns>
+/// number of entries written, or 0 if the tileset can't be vertex pulled - too many tiles for the table,
+/// or tiles that aren't tileWidthPx x tileHeightPx
+/// </returns>
+int TilemapLayer_BuildUVTable(hAtlas atlas, int tileWidthPx, int tileHeightPx, float* outUVs);
+
+/// <summary>
+/// Split the layer into chunks and upload every chunks vertices, or its tile index texture if it can be vertex pulled.
+/// Sets pLayer->pRenderData
+/// </summary>
+void TilemapLayer_BuildChunks(struct TileMapLayer* pLayer, hAtlas atlas, struct DrawContext* pDC);
+
+void TilemapLayer_DestroyChunks(struct TileMapLayer* pLayer, struct DrawContext* pDC);
+
+/* the chunk containing the tile is rebuilt the next time TilemapLayer_RebuildDirtyChunks is called */
+void TilemapLayer_MarkTileDirty(struct TileMapLayer* pLayer, int col, int row);
+
+void TilemapLayer_RebuildDirtyChunks(struct TileMapLayer* pLayer, hAtlas atlas, struct DrawContext* pDC);
+
+/// <summary>
+/// Draw the chunks that overlap the viewport
+/// </summary>
+/// <returns> number of tiles drawn </returns>
+int TilemapLayer_DrawVisibleChunks(struct TileMapLayer* pLayer, struct DrawContext* pDC, vec2 viewportTL, vec2 viewportBR, mat4 view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdbool.h>
+
+/*
+	A fixed set of threads running jobs from one shared queue.
+
+	Jobs run in the order they're submitted but may finish in any order, a job must not touch
+	anything another job in flight writes to. WP_Submit and WP_WaitIdle are meant to be called
+	from the thread that created the pool.
+
+	Jobs submitted with an onComplete get it called back by WP_RunCompleted, on whichever thread
+	calls that - typically the main thread once a frame. That's the place to hand results to
+	anything that isn't thread safe, like uploading a texture.
+*/
+
+struct WorkerPool;
+
+typedef void(*WorkerJobFn)(void* pArg);
+
+/* numThreads of 0 or less uses one per CPU */
+struct WorkerPool* WP_Create(int numThreads);
+
+/* waits for queued jobs to finish, then stops the threads. onCompletes not yet run are dropped */
+void WP_Destroy(struct WorkerPool* pPool);
+
+void WP_Submit(struct WorkerPool* pPool, WorkerJobFn fn, void* pArg);
+
+/* once fn(pArg) has run on a worker, onComplete(pArg) runs in the next WP_RunCompleted */
+void WP_SubmitWithCompletion(struct WorkerPool* pPool, WorkerJobFn fn, WorkerJobFn onComplete, void* pArg);
+
+/* blocks until there's an onComplete for WP_RunCompleted to run, or no jobs are left */
+void WP_WaitCompleted(struct WorkerPool* pPool);
+
+/* runs the onComplete of every job finished so far on the calling thread, returns how many ran */
+int WP_RunCompleted(struct WorkerPool* pPool);
+
+/* blocks until every job submitted so far has finished */
+void WP_WaitIdle(struct WorkerPool* pPool);
+
+int WP_GetNumThreads(const struct WorkerPool* pPool);
+
+int WP_GetNumCPUs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -63,6 +63,8 @@ typedef struct XMLUIData
 	int nFocusedWidgets;
 	struct SDTimerPool timerPool;
 	VECTOR(struct WidgetChildrenChangeRequest) pChildrenChangeRequests;
+	/* At_GetGlyphCacheGeneration when the vertices were last output */
+	u32 glyphCacheGeneration;
 }XMLUIData;
 
 
@@ -1,7 +1,9 @@
 #ifndef  MAIN_H
+#define MAIN_H
 
 #include "DrawContext.h"
 #include "InputContext.h"
+#include "NullDrawContext.h"
 
 int Mn_GetScreenWidth();
 int Mn_GetScreenHeight();
@@ -10,4 +12,23 @@ typedef void(*GameInitFn)(InputContext*,DrawContext*);
 
 int EngineStart(int argc, char** argv, GameInitFn init);
 
+struct HeadlessRunStats
+{
+    int numFrames;
+    double initMs;
+    double updateMsTotal;
+    double updateMsMax;
+    double drawMsTotal;
+    double drawMsMax;
+    /* summed over the frames run, not including init */
+    struct NullDrawCounters drawTotals;
+    struct NullDrawStats drawStats;
+};
+
+/// <summary>
+/// Runs the engine without a window or GL context, using the null draw context.
+/// Runs numFrames frames, each one fixed timestep update and a draw, as fast as possible
+/// </summary>
+int EngineStartHeadless(int numFrames, GameInitFn init, struct HeadlessRunStats* pOutStats);
+
 #endif // ! MAIN_H
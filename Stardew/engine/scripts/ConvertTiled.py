@@ -23,7 +23,8 @@ def do_cmd_args():
     parser.add_argument("-a", '--atlas_tool', default=None, help="optional path to atlas tool which will compile an atlas xml file AOT for faster loading")
     parser.add_argument("outputDir", type=str, help="the output directory")
     parser.add_argument("-A", "--assets_folder", default="./Assets")
-    parser.add_argument("-r", "--rle", type=bool, default=False)
+    parser.add_argument("-r", "--rle", type=bool, default=False, help="same as --compression rle")
+    parser.add_argument("-c", "--compression", choices=["none", "rle", "lz4", "smallest"], default="smallest", help="how tile layers are compressed, smallest picks whichever is smallest for each layer")
     parser.add_argument("-bmp", "--atlasBmp", type=str, default=None, help="Optional atlas debug bitmap output path")
     parser.add_argument("-iw", "--atlasIW", type=int, default=512, help="Atlas initial width.")
     parser.add_argument("-ih", "--atlasIH", type=int, default=512, help="Atlas initial height.")
@@ -146,8 +147,8 @@ def run_atlas_tool(path, xmlPath, args):
     print(f"Running Atlas Tool...\n")
     print(binPath)
     print(argsList)
-    print(f"Std Out:\n{result.stdout.decode("utf-8")}\n")
-    print(f"Std Err:\n{result.stderr.decode("utf-8")}\n")
+    print(f"Std Out:\n{result.stdout.decode('utf-8')}\n")
+    print(f"Std Err:\n{result.stderr.decode('utf-8')}\n")
 
 def count_tilemap_layers(layers):
     i = 0
@@ -158,43 +159,124 @@ def count_tilemap_layers(layers):
 
 U16MAX = 65535
 
-class Run:
-    def __init__(self, file, runLen, runVal):
-        self.file = file
-        self.runLen = runLen
-        self.runVal = runVal
-    def write(self):
-        # H == u16
-        self.file.write(struct.pack("H", self.runLen))
-        self.file.write(struct.pack("H", self.runVal))
-
-def build_runs(file, data : list[int], atlas : Atlas, tilesets) -> list[Run]:
-    i = 0
-    runs = []
-    ts = find_tileset(data[i], tilesets)
-    if ts:
-            norm = get_normalized_index(data[i], ts)
-            converted = atlas.get_atlas_index(norm, ts["source"])
-    else:
-        converted = 0
-    currentVal = converted
-    currentCount = 1
-    for i in range(1, len(data)):
-        ts = find_tileset(data[i], tilesets)
+# values of the engines TileLayerCompression enum, written before a tile layers tiles
+TLC_RLE = 1
+TLC_UNCOMPRESSED = 2
+TLC_LZ4 = 3
+
+def convert_tiles(data, atlas : Atlas, tilesets) -> list[int]:
+    "tiled gids to atlas indices, 0 is no tile"
+    converted = []
+    for i in data:
+        ts = find_tileset(i, tilesets)
         if ts:
-            norm = get_normalized_index(data[i], ts)
-            converted = atlas.get_atlas_index(norm, ts["source"])
-        else:
-            converted = 0
-        if converted != currentVal or currentVal == U16MAX:
-            runs.append(Run(file, currentCount, currentVal))
-            currentCount = 1
-            currentVal = converted
+            norm = get_normalized_index(i, ts)
+            converted.append(atlas.get_atlas_index(norm, ts["source"]))
         else:
-            currentCount += 1
+            converted.append(0)
+    return converted
+
+def encode_rle(tiles : list[int]) -> bytes:
+    "(run length, tile) u16 pairs, ended by a run of length 0"
+    out = bytearray()
+    i = 0
+    while i < len(tiles):
+        run_len = 1
+        while i + run_len < len(tiles) and tiles[i + run_len] == tiles[i] and run_len < U16MAX:
+            run_len += 1
+        out += struct.pack("<HH", run_len, tiles[i])
+        i += run_len
     # sentinel value: run of length 0
-    runs.append(Run(file, 0, 0))
-    return runs
+    out += struct.pack("<HH", 0, 0)
+    return bytes(out)
+
+def encode_uncompressed(tiles : list[int]) -> bytes:
+    return struct.pack(f"<{len(tiles)}H", *tiles)
+
+LZ_MIN_MATCH = 4
+LZ_LAST_LITERALS = 5
+LZ_MF_LIMIT = 12
+LZ_MAX_OFFSET = 65535
+LZ_HASH_BITS = 12
+
+def lz4_hash(sequence : int) -> int:
+    return ((sequence * 2654435761) & 0xffffffff) >> (32 - LZ_HASH_BITS)
+
+def lz4_write_length(out : bytearray, length : int):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+def lz4_write_literals(out : bytearray, literals : bytes) -> int:
+    "returns the position of the token so the match length can be or'd in"
+    token_pos = len(out)
+    out.append(min(len(literals), 15) << 4)
+    if len(literals) >= 15:
+        lz4_write_length(out, len(literals) - 15)
+    out += literals
+    return token_pos
+
+def lz4_compress_block(src : bytes) -> bytes:
+    "a port of Lz_CompressBlock in engine/src/core/Lz4Block.c, on a little endian host they give the same bytes"
+    out = bytearray()
+    table = [-1] * (1 << LZ_HASH_BITS)
+    anchor = 0
+    n = len(src)
+    if n > LZ_MF_LIMIT:
+        match_limit = n - LZ_LAST_LITERALS
+        mf_limit = n - LZ_MF_LIMIT
+        ip = 0
+        while ip < mf_limit:
+            sequence = int.from_bytes(src[ip:ip + 4], "little")
+            h = lz4_hash(sequence)
+            ref = table[h]
+            table[h] = ip
+            if ref < 0 or ip - ref > LZ_MAX_OFFSET or src[ref:ref + 4] != src[ip:ip + 4]:
+                ip += 1
+                continue
+            # extend the match backwards into the pending literals, then forwards
+            while ip > anchor and ref > 0 and src[ip - 1] == src[ref - 1]:
+                ip -= 1
+                ref -= 1
+            length = LZ_MIN_MATCH
+            while ip + length < match_limit and src[ip + length] == src[ref + length]:
+                length += 1
+            token_pos = lz4_write_literals(out, src[anchor:ip])
+            out += struct.pack("<H", ip - ref)
+            extra_len = length - LZ_MIN_MATCH
+            out[token_pos] |= min(extra_len, 15)
+            if extra_len >= 15:
+                lz4_write_length(out, extra_len - 15)
+            ip += length
+            anchor = ip
+            if ip - 2 < mf_limit:
+                table[lz4_hash(int.from_bytes(src[ip - 2:ip + 2], "little"))] = ip - 2
+    lz4_write_literals(out, src[anchor:])
+    return bytes(out)
+
+def encode_lz4(tiles : list[int]) -> bytes:
+    "u32 compressed size then an LZ4 block of the uncompressed tiles"
+    block = lz4_compress_block(encode_uncompressed(tiles))
+    return struct.pack("<I", len(block)) + block
+
+def encode_tiles(tiles : list[int], compression : str) -> tuple[int, bytes]:
+    "returns the compression enum value and the encoded tiles"
+    encoded = {
+        TLC_UNCOMPRESSED : encode_uncompressed(tiles)
+    }
+    if compression in ("rle", "smallest"):
+        encoded[TLC_RLE] = encode_rle(tiles)
+    if compression in ("lz4", "smallest"):
+        encoded[TLC_LZ4] = encode_lz4(tiles)
+    if compression == "rle":
+        return TLC_RLE, encoded[TLC_RLE]
+    if compression == "lz4":
+        return TLC_LZ4, encoded[TLC_LZ4]
+    if compression == "none":
+        return TLC_UNCOMPRESSED, encoded[TLC_UNCOMPRESSED]
+    # smallest - ties go to whichever is cheapest to decode
+    return min(encoded.items(), key=lambda item: (len(item[1]), [TLC_UNCOMPRESSED, TLC_RLE, TLC_LZ4].index(item[0])))
 
 def get_tile_layer_tile_dims(data, atlas, tilesets):
     lastW = -1
@@ -220,26 +302,11 @@ def get_tile_layer_tile_dims(data, atlas, tilesets):
     return lastW, lastH
 
 
-def write_rle(f, data, atlas, tilesets):
-    runs = build_runs(f, data, atlas, tilesets)
-    for r in runs:
-        r.write()
-
-def write_uncompressed(f, data, atlas, tilesets):
-    for i in data:
-        ts = find_tileset(i, tilesets)
-        if ts:
-            norm = get_normalized_index(i, ts)
-            converted = atlas.get_atlas_index(norm, ts["source"])
-        else:
-            converted = 0
-        f.write(struct.pack("H", converted))
-
 def write_draw_order_enum(draw_order_text, file):
     if draw_order_text == "topdown":
-        file.write(struct.pack("I", 1))
+        file.write(struct.pack("<I", 1))
     elif draw_order_text == "index":
-        file.write(struct.pack("I", 2))
+        file.write(struct.pack("<I", 2))
     else:
         assert False
 
@@ -269,12 +336,12 @@ def get_static_collider_type(obj):
 def serialize_static_collider_ent(file, obj):
     t = get_static_collider_type(obj)
     if t == EBET_StaticColliderRect:
-        file.write(struct.pack("I", 1))
-        file.write(struct.pack("f", obj["width"]))
-        file.write(struct.pack("f", obj["height"]))
+        file.write(struct.pack("<I", 1))
+        file.write(struct.pack("<f", obj["width"]))
+        file.write(struct.pack("<f", obj["height"]))
     elif t == EBET_StaticColliderCircle:
-        file.write(struct.pack("I", 1))
-        file.write(struct.pack("f", get_tiled_object_custom_prop(obj, "radius")))
+        file.write(struct.pack("<I", 1))
+        file.write(struct.pack("<f", get_tiled_object_custom_prop(obj, "radius")))
     elif t == EBET_StaticColliderPoly:
         assert False
     elif t == EBET_StaticColliderEllipse:
@@ -290,15 +357,15 @@ class EntitySerializer:
         self.get_type_fn = get_type_fn
         self.b_keep_in_quad = b_keep_in_quad
     def serialize_common(self, f, obj):
-        f.write(struct.pack("I", 1)) # version
-        f.write(struct.pack("f", obj["x"]))
-        f.write(struct.pack("f", obj["y"]))
-        f.write(struct.pack("f", 1))
-        f.write(struct.pack("f", 1))
-        f.write(struct.pack("f", obj["rotation"]))
-        f.write(struct.pack("I", 1 if self.b_keep_in_quad else 0))
+        f.write(struct.pack("<I", 1)) # version
+        f.write(struct.pack("<f", obj["x"]))
+        f.write(struct.pack("<f", obj["y"]))
+        f.write(struct.pack("<f", 1))
+        f.write(struct.pack("<f", 1))
+        f.write(struct.pack("<f", obj["rotation"]))
+        f.write(struct.pack("<I", 1 if self.b_keep_in_quad else 0))
     def serialize(self, f, o):
-        f.write(struct.pack("I", self.get_type_fn(o)))
+        f.write(struct.pack("<I", self.get_type_fn(o)))
         self.serialize_common(f, o)
         self.serialze_fn(f , o)
 
@@ -329,53 +396,49 @@ def build_tilemap_binaries(args, parsed_tile_maps, atlas):
         tilesets.reverse()
         with open(binaryPath, "wb") as f:
             # VERSION
-            f.write(struct.pack("I", TILEMAP_FILE_VERSION))
+            f.write(struct.pack("<I", TILEMAP_FILE_VERSION))
             # QUADTREE
-            f.write(struct.pack("f", args.iqtlx))
-            f.write(struct.pack("f", args.iqtly))
-            f.write(struct.pack("f", args.iqbrx))
-            f.write(struct.pack("f", args.iqbry))
+            f.write(struct.pack("<f", args.iqtlx))
+            f.write(struct.pack("<f", args.iqtly))
+            f.write(struct.pack("<f", args.iqbrx))
+            f.write(struct.pack("<f", args.iqbry))
             # NUM LAYERS
             num_tilemap_layers = len(p["layers"])
-            f.write(struct.pack("I", num_tilemap_layers))
+            f.write(struct.pack("<I", num_tilemap_layers))
             layerNum = 0
             for layer in p["layers"]:
                 if "data" in layer:
                     # WRITE 1 FOR TILE LAYER
-                    f.write(struct.pack("I", 1))
+                    f.write(struct.pack("<I", 1))
                     data = layer["data"]
                     tw, th = get_tile_layer_tile_dims(data, atlas, tilesets)
-                    print(f"LAYER {str(layerNum)} TILE WIDTH: {tw} TILE HEIGHT: {th} WIDTH: {layer["width"]} TILES, HEIGHT {layer["height"]} TILES.")
+                    print(f"LAYER {str(layerNum)} TILE WIDTH: {tw} TILE HEIGHT: {th} WIDTH: {layer['width']} TILES, HEIGHT {layer['height']} TILES.")
                     layerNum += 1
                     # INT FIELDS FOR LAYER
-                    f.write(struct.pack("I", layer["width"]))
-                    f.write(struct.pack("I", layer["height"]))
-                    f.write(struct.pack("I", layer["x"]))
-                    f.write(struct.pack("I", layer["y"]))
-                    f.write(struct.pack("I", tw if tw > 0 else 0))
-                    f.write(struct.pack("I", th if th > 0 else 0))
-                    if args.rle:
-                        f.write(struct.pack("I", 1))     # enum value to signify RLE
-                        # RUN LENGTH ENCODED TILES
-                        write_rle(f, data, atlas, tilesets)
-                    else:
-                        f.write(struct.pack("I", 2))     # enum value to signify uncompressed
-                        # UNCOMPRESSED TILES
-                        write_uncompressed(f, data, atlas, tilesets)
+                    f.write(struct.pack("<I", layer["width"]))
+                    f.write(struct.pack("<I", layer["height"]))
+                    f.write(struct.pack("<I", layer["x"]))
+                    f.write(struct.pack("<I", layer["y"]))
+                    f.write(struct.pack("<I", tw if tw > 0 else 0))
+                    f.write(struct.pack("<I", th if th > 0 else 0))
+                    compression, encoded = encode_tiles(convert_tiles(data, atlas, tilesets), "rle" if args.rle else args.compression)
+                    print(f"LAYER COMPRESSION: {compression} {len(encoded)} BYTES")
+                    f.write(struct.pack("<I", compression))
+                    f.write(encoded)
                 else:
                     # WRITE 2 FOR OBJECT LAYER
-                    f.write(struct.pack("I", 2))
+                    f.write(struct.pack("<I", 2))
                     write_draw_order_enum(layer["draworder"], f)
-                    f.write(struct.pack("I", 1))
+                    f.write(struct.pack("<I", 1))
                     num_ents = count_serializable_ents(layer["objects"])
                     print(f"NUM ENTS: {num_ents}")
-                    f.write(struct.pack("I", num_ents))
+                    f.write(struct.pack("<I", num_ents))
                     for o in layer["objects"]:
                         if o["type"] in entity_binary_serializers.keys():
                             serializer =  entity_binary_serializers[o["type"]]
                             serializer.serialize(f, o)
                         else:
-                            print(f"Warning: No serializer for entity type {o["type"]}")
+                            print(f"Warning: No serializer for entity type {o['type']}")
                         pass
 
     print("\n\n")
@@ -6,6 +6,7 @@
 #include "AssertLib.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
@@ -16,8 +17,13 @@
 #include <libxml/tree.h>
 
 #include "BinarySerializer.h"
-#include "BitField2D.h"
+#include "AtlasPacker.h"
 #include "StringKeyHashMap.h"
+#include "MappedFile.h"
+#include "Qoi.h"
+#include "Lz4Block.h"
+#include "GlyphRunCache.h"
+#include "GlyphShelfPacker.h"
 
 FT_Library  gFTLib;
 static int gSpriteId = 1;
@@ -30,6 +36,39 @@ struct AtlasSpriteFontData
 	vec2 advance;
 };
 
+/* a glyph of a dynamic font */
+struct DynamicGlyph
+{
+	/* bSet is false if the font doesn't have the glyph */
+	AtlasSprite sprite;
+	struct AtlasSpriteFontData data;
+	/* the glyph cache shelf its pixels are in, GLYPH_SHELF_NONE if they aren't in the texture */
+	int shelf;
+};
+
+#define DYNAMIC_GLYPH_NONE -1
+
+/*
+	A font size whose glyphs are rasterised the first time they're used, into the atlas's glyph cache,
+	see FontAtlasAdditionSpec.bDynamic. A glyph keeps its metrics once it's been rasterised, only its
+	pixels are evicted from the cache.
+*/
+struct DynamicFont
+{
+	char path[MAX_FONT_PATH_SIZE];
+	/* the size of the fonts face, which is shared between all the sizes added at once */
+	FT_Size ftSize;
+	/* every glyph rasterised so far, in the order they were first used */
+	VECTOR(struct DynamicGlyph) glyphs;
+	/* codepoint -> index into glyphs, DYNAMIC_GLYPH_NONE until it's rasterised */
+	i32 latin1Glyphs[256];
+	/* the same for the rest of unicode, open addressed, capacity is a power of 2 */
+	u32* pOtherCodepoints;
+	i32* pOtherGlyphs;
+	u32 otherCapacity;
+	u32 numOther;
+};
+
 struct AtlasFont
 {
 	struct AtlasSpriteFontData spriteData[256];
@@ -37,12 +76,47 @@ struct AtlasFont
 	char name[MAX_FONT_NAME_SIZE];
 	SHARED_PTR(FT_Face) pFTFace;
 	float fSizePts;
+	/* over every loaded glyph, see ComputeFontMetrics */
+	float maxYBearing;
+	float minBelowBaseline;
+	float lineHeight;
+	/* next font in the atlas with the same name, for Fo_FindFont */
+	HFont nextWithSameName;
+	/* NULL unless the font is dynamic, in which case spriteData and sprites aren't used */
+	struct DynamicFont* pDynamic;
+};
+
+/* a dynamic fonts glyph with its border, waiting to be written to the atlas texture */
+struct PendingGlyphUpload
+{
+	int x, y, w, h;
+	u8* pixels;
+};
+
+#define ATLAS_MAX_PALETTE_COLOURS 256
+
+/* pixels as they're stored in a version 2 .atlas file, pointing into the file */
+struct AtlasEncodedPixels
+{
+	enum AtlasPixelEncoding encoding;
+	const u8* pData;
+	size_t size;
+	/* APE_Palette only, u32 RGBA colours */
+	const u8* pPalette;
+	u32 numColours;
 };
 
 typedef struct
 {
 	bool bActive;
+	/* NULL if a compressed atlas was decoded straight into a texture upload buffer, see GetAtlasBytes */
 	u8* atlasBytes;
+	/*
+		set when the atlas was loaded from a mapped version 2 .atlas file and still uses it -
+		atlasBytes points into it if the pixels are APE_Raw, otherwise they're decoded from encodedPixels when needed
+	*/
+	struct MappedFile* pMappedFile;
+	struct AtlasEncodedPixels encodedPixels;
 	int atlasWidth;
 	int atlasHeight;
 	hTexture texture;
@@ -51,10 +125,30 @@ typedef struct
 	int tilesetIndexBegin;  // inclusive
 	int tilesetIndexEnd;    // exclusive
 	struct HashMap animations; /* holds struct AtlasAnimation objects  */
+	/* font name -> HFont of the first font with that name, see Fo_FindFont */
+	struct HashMap fontIndex;
+	int numIndexedFonts;
+	/* size asked for with At_SetGlyphCacheSize while building, 0 for the default */
+	int requestedGlyphCacheWidth;
+	int requestedGlyphCacheHeight;
+	/* the region of the texture dynamic fonts glyphs are rasterised into, if the atlas has any dynamic fonts */
+	bool bHasGlyphCache;
+	struct GlyphShelfPacker glyphCache;
+	/* glyphs rasterised since the atlas was last bound, uploaded by At_SetCurrent */
+	VECTOR(struct PendingGlyphUpload) pendingGlyphUploads;
+	/* advanced every time the atlas is bound, glyphs used since then aren't evicted */
+	u32 glyphCacheFrame;
+	u32 glyphCacheGeneration;
+	/* a glyph didn't fit in the glyph cache this frame and was drawn empty, bumps the generation when the atlas is next bound */
+	bool bGlyphCacheMissed;
+	u64 glyphsRasterised;
+	u64 glyphBytesUploaded;
 }Atlas;
 
 static VECTOR(Atlas) gAtlases = NULL;
 static int gCurrentAtlasIndex = -1;
+/* set while At_LoadAtlasEx adds sprites and fonts */
+static const struct AtlasSourceProvider* gpSources = NULL;
 
 Atlas* GetCurrentAtlas()
 {
@@ -81,13 +175,138 @@ Atlas* AqcuireAtlas()
 	return VectorTop(gAtlases);
 }
 
+static bool AtlasBytesInMapping(const Atlas* pAtlas)
+{
+	return pAtlas->pMappedFile && pAtlas->encodedPixels.encoding == APE_Raw;
+}
+
+/* dst is write only, it can be a mapped texture upload buffer */
+static bool DecodeAtlasPixels(const struct AtlasEncodedPixels* pPixels, u8* dst, size_t numPixels)
+{
+	switch (pPixels->encoding)
+	{
+	case APE_Raw:
+		if (pPixels->size != numPixels * CHANNELS_PER_PIXEL)
+		{
+			return false;
+		}
+		memcpy(dst, pPixels->pData, pPixels->size);
+		return true;
+	case APE_QOI:
+		return Qoi_Decode(pPixels->pData, pPixels->size, dst, numPixels);
+	case APE_Palette:
+		{
+			u32 palette[ATLAS_MAX_PALETTE_COLOURS];
+			memcpy(palette, pPixels->pPalette, pPixels->numColours * sizeof(u32));
+			u8* pIndices = malloc(numPixels);
+			bool bValid = Lz_DecompressBlock(pPixels->pData, pPixels->size, pIndices, numPixels) == (i64)numPixels;
+			for (size_t i = 0; bValid && i < numPixels; i++)
+			{
+				if (pIndices[i] >= pPixels->numColours)
+				{
+					bValid = false;
+					break;
+				}
+				memcpy(dst + i * CHANNELS_PER_PIXEL, &palette[pIndices[i]], sizeof(u32));
+			}
+			free(pIndices);
+			return bValid;
+		}
+	}
+	return false;
+}
+
+/* the atlas's RGBA pixels, decoding them from the file first if the atlas was loaded without keeping a copy */
+static u8* GetAtlasBytes(Atlas* pAtlas)
+{
+	if (!pAtlas->atlasBytes && pAtlas->pMappedFile)
+	{
+		size_t numPixels = (size_t)pAtlas->atlasWidth * pAtlas->atlasHeight;
+		pAtlas->atlasBytes = malloc(numPixels * CHANNELS_PER_PIXEL);
+		bool bDecoded = DecodeAtlasPixels(&pAtlas->encodedPixels, pAtlas->atlasBytes, numPixels);
+		/* it decoded when it was loaded */
+		EASSERT(bDecoded);
+	}
+	return pAtlas->atlasBytes;
+}
+
+static void InitGlyphCacheFields(Atlas* pAtlas)
+{
+	pAtlas->requestedGlyphCacheWidth = 0;
+	pAtlas->requestedGlyphCacheHeight = 0;
+	pAtlas->bHasGlyphCache = false;
+	memset(&pAtlas->glyphCache, 0, sizeof(struct GlyphShelfPacker));
+	pAtlas->pendingGlyphUploads = NULL;
+	pAtlas->glyphCacheFrame = 1;
+	pAtlas->glyphCacheGeneration = 0;
+	pAtlas->bGlyphCacheMissed = false;
+	pAtlas->glyphsRasterised = 0;
+	pAtlas->glyphBytesUploaded = 0;
+}
+
+static void FlushGlyphUploads(Atlas* pAtlas, DrawContext* pDC)
+{
+	if (!pAtlas->bHasGlyphCache)
+	{
+		return;
+	}
+	for (int i = 0; i < VectorSize(pAtlas->pendingGlyphUploads); i++)
+	{
+		struct PendingGlyphUpload* pUpload = &pAtlas->pendingGlyphUploads[i];
+		if (pDC->UpdateTextureRegion)
+		{
+			pDC->UpdateTextureRegion(pAtlas->texture, pUpload->pixels, CHANNELS_PER_PIXEL, pUpload->x, pUpload->y, pUpload->w, pUpload->h);
+			pAtlas->glyphBytesUploaded += (u64)pUpload->w * pUpload->h * CHANNELS_PER_PIXEL;
+		}
+		free(pUpload->pixels);
+	}
+	pAtlas->pendingGlyphUploads = VectorClear(pAtlas->pendingGlyphUploads);
+	pAtlas->glyphCacheFrame++;
+	if (pAtlas->bGlyphCacheMissed)
+	{
+		/*
+			not when the glyph missed - vertices output that frame read the generation afterwards and
+			would never be output again, with the glyph it couldn't fit drawn empty
+		*/
+		pAtlas->glyphCacheGeneration++;
+		pAtlas->bGlyphCacheMissed = false;
+	}
+}
+
 void At_SetCurrent(hAtlas atlas, DrawContext* pDC)
 {
 	gCurrentAtlasIndex = atlas;
 	Atlas* pAtlas = &gAtlases[atlas];
+	FlushGlyphUploads(pAtlas, pDC);
 	pDC->SetCurrentAtlas(pAtlas->texture);
 }
 
+void At_SetGlyphCacheSize(int widthPx, int heightPx)
+{
+	Atlas* pAtlas = GetCurrentAtlas();
+	pAtlas->requestedGlyphCacheWidth = widthPx;
+	pAtlas->requestedGlyphCacheHeight = heightPx;
+}
+
+void At_GetGlyphCacheStats(hAtlas atlas, struct AtlasGlyphCacheStats* pOutStats)
+{
+	memset(pOutStats, 0, sizeof(struct AtlasGlyphCacheStats));
+	Atlas* pAtlas = &gAtlases[atlas];
+	if (pAtlas->bHasGlyphCache)
+	{
+		pOutStats->widthPx = pAtlas->glyphCache.width;
+		pOutStats->heightPx = pAtlas->glyphCache.height;
+		pOutStats->glyphsEvicted = pAtlas->glyphCache.numEvictedGlyphs;
+	}
+	pOutStats->glyphsRasterised = pAtlas->glyphsRasterised;
+	pOutStats->bytesUploaded = pAtlas->glyphBytesUploaded;
+}
+
+u32 At_GetGlyphCacheGeneration(hAtlas atlas)
+{
+	return gAtlases[atlas].glyphCacheGeneration;
+}
+
 void At_Init()
 {
 	FT_Error error = FT_Init_FreeType(&gFTLib);
@@ -108,12 +327,17 @@ void At_BeginAtlas()
 	Atlas* atlas = AqcuireAtlas();
 	atlas->bActive = true;
 	atlas->atlasBytes = NULL;
+	atlas->pMappedFile = NULL;
+	memset(&atlas->encodedPixels, 0, sizeof(struct AtlasEncodedPixels));
 	atlas->atlasHeight = 0;
 	atlas->atlasWidth = 0;
 	atlas->sprites = NEW_VECTOR(AtlasSprite);
 	atlas->fonts = NEW_VECTOR(struct AtlasFont);
 	atlas->texture = NULL_HANDLE;
 	HashmapInit(&atlas->animations, 64, sizeof(struct AtlasAnimation));
+	HashmapInit(&atlas->fontIndex, 16, sizeof(HFont));
+	atlas->numIndexedFonts = 0;
+	InitGlyphCacheFields(atlas);
 	atlas->tilesetIndexBegin = -1;
 	atlas->tilesetIndexEnd = -1;
 }
@@ -126,6 +350,26 @@ hSprite At_AddSprite(const char* imgPath, int topLeftXPx, int topLeftYPx, int wi
 	{
 		return NULL_HSPRITE;
 	}
+
+	const u8* pSrc = NULL;
+	size_t srcRowBytes = widthPx * CHANNELS_PER_PIXEL;
+	if (gpSources && gpSources->GetSpritePixels)
+	{
+		pSrc = gpSources->GetSpritePixels(gpSources->pUser, imgPath, topLeftXPx, topLeftYPx, widthPx, heightPx);
+	}
+	if (!pSrc)
+	{
+		/* the image stays loaded for the atlases other sprites, At_EndAtlasEx unloads it */
+		const u8* pData = IR_GetImageData(img);
+		if (!pData)
+		{
+			return NULL_HSPRITE;
+		}
+		const struct ImageFile* pImg = IR_GetImageFile(img);
+		srcRowBytes = pImg->width * CHANNELS_PER_PIXEL;
+		pSrc = &pData[(topLeftYPx * srcRowBytes) + (topLeftXPx * CHANNELS_PER_PIXEL)];
+	}
+
 	AtlasSprite sprite;
 	memset(&sprite, 0, sizeof(AtlasSprite));
 	sprite.atlasTopLeftXPx = topLeftXPx;
@@ -134,25 +378,18 @@ hSprite At_AddSprite(const char* imgPath, int topLeftXPx, int topLeftYPx, int wi
 	sprite.heightPx = heightPx;
 	sprite.atlas = gCurrentAtlasIndex;
 	sprite.srcImage = img;
-	size_t sizeOfSpriteData = widthPx * heightPx * CHANNELS_PER_PIXEL;
-	//sprite.individualTileBytes = malloc(sizeOfSpriteData);
 	sprite.name = malloc(strlen(name) + 1);
 	sprite.id = gSpriteId++;
 
 	strcpy(sprite.name, name);
-	
-	u8* pData = IR_GetImageData(img);
-	const struct ImageFile* pImg = IR_GetImageFile(img);
-	sprite.individualTileBytes = pData;
 
-	size_t rowWidth = pImg->width * CHANNELS_PER_PIXEL;
-	size_t startIndex = (topLeftYPx * rowWidth) + (topLeftXPx * CHANNELS_PER_PIXEL);
-	u8* writeStart = pData;
+	size_t rowBytes = widthPx * CHANNELS_PER_PIXEL;
+	sprite.individualTileBytes = malloc(rowBytes * heightPx);
+	u8* writeStart = sprite.individualTileBytes;
 	for (int i = 0; i < heightPx; i++)
 	{
-		size_t startRow = startIndex + i * rowWidth;
-		memcpy(writeStart, &pData[startRow], widthPx * CHANNELS_PER_PIXEL);
-		writeStart += widthPx * CHANNELS_PER_PIXEL;
+		memcpy(writeStart, &pSrc[i * srcRowBytes], rowBytes);
+		writeStart += rowBytes;
 	}
 
 	pAtlas->sprites = VectorPush(pAtlas->sprites, &sprite);
@@ -207,391 +444,415 @@ float At_PixelsToPts(float val)
 	return val;
 }
 
-HFont At_AddFont(const struct FontAtlasAdditionSpec* pFontSpec)
+float At_FontSizeToPts(const struct FontSize* pSize)
 {
-	HFont hFont = NULL_HANDLE;
-	const int dpi = 92;
-	SHARED_PTR(FT_Face) face = SHARED_PTR_NEW(FT_Face, &FaceDtor);      /* handle to face object */
-	Atlas* pAtlas = GetCurrentAtlas();
-	FT_Error error =  FT_New_Face(gFTLib, pFontSpec->path, 0, face);
-	if (error == FT_Err_Unknown_File_Format)
+	return pSize->type == FOS_Pixels ? At_PixelsToPts(pSize->val) : pSize->val;
+}
+
+#define ATLAS_FONT_DPI 92
+
+/* rasterise a glyph of the faces active size, false if the face doesn't have it */
+static bool RasteriseGlyph(FT_Face face, u32 codepoint, struct AtlasGlyph* pOutGlyph)
+{
+	memset(pOutGlyph, 0, sizeof(struct AtlasGlyph));
+	FT_UInt index = FT_Get_Char_Index(face, codepoint);
+	if (index == 0)
 	{
-		/*... the font file could be opened and read, but it appears
-			... that its font format is unsupported*/
-		printf("the font file '%s' could be opened and read, but it appears... that its font format is unsupported\n", pFontSpec->path);
-		return NULL_HANDLE;
+		return false;
 	}
-	else if (error)
+	FT_Error error = FT_Load_Glyph(
+		face,             /* handle to face object */
+		index,             /* glyph index           */
+		FT_LOAD_DEFAULT);  /* load flags, see below */
+	if (error)
 	{
-		/*... another error code means that the font file could not
-			... be opened or read, or that it is broken...*/
-		printf("font file '%s' another error code means that the font file could not... be opened or read, or that it is broken. error code %i\n", pFontSpec->path, error);
-		return NULL_HANDLE;
+		printf("FT_Load_Glyph error\n");
+		return false;
 	}
-	for (int i = 0; i < pFontSpec->numFontSizes; i++)
+	error = FT_Render_Glyph(face->glyph,   /* glyph slot  */
+		FT_RENDER_MODE_NORMAL); /* render mode */
+	if (error)
 	{
-		struct FontSize fs = pFontSpec->fontSizes[i];
-		switch (fs.type)
-		{
-		case FOS_Pixels:
-			{
-				fs.val = At_PixelsToPts(fs.val);
-				fs.type = FOS_Pts;
-				break;
-			}
-		}
-		error = FT_Set_Char_Size(
-			*face,    /* handle to face object         */
-			fs.val * 64,       /* char_width in 1/64 of points  */
-			fs.val * 64,   /* char_height in 1/64 of points */
-			dpi,     /* horizontal device resolution  */
-			dpi);   /* vertical device resolution    */
-		if (error)
-		{
-			printf("FT_Set_Char_Size error");
-			return NULL_HANDLE;
-		}
-		struct AtlasFont font;
-		memset(&font, 0, sizeof(struct AtlasFont));
-		font.fSizePts = fs.val;
-		font.pFTFace = face;
-		Sptr_AddRef(face);
-
-		for (int j = 0; j < 256; j++)
-		{
-			FT_UInt index = FT_Get_Char_Index(*face, j);
-			if (index == 0)
-			{
-				continue;
-			}
-			error = FT_Load_Glyph(
-				*face,             /* handle to face object */
-				index,             /* glyph index           */
-				FT_LOAD_DEFAULT);  /* load flags, see below */
-			if (error)
-			{
-				printf("FT_Load_Glyph error\n");
-				continue;
-			}
-			error = FT_Render_Glyph((*face)->glyph,   /* glyph slot  */
-				FT_RENDER_MODE_NORMAL); /* render mode */
-			if (error)
-			{
-				printf("FT_Render_Glyph error\n");
-				continue;
-			}
-			
-			AtlasSprite* pSprite = &font.sprites[j];
-			pSprite->widthPx = (*face)->glyph->bitmap.width;
-			pSprite->heightPx = (*face)->glyph->bitmap.rows;
-			pSprite->individualTileBytes = FTBitmapToNestableBitmap(&(*face)->glyph->bitmap);
-			pSprite->bSet = true;
-			pSprite->id = gSpriteId++;
-			
-			struct AtlasSpriteFontData* pSpriteData = &font.spriteData[j];
-			pSpriteData->bearing[0] = (*face)->glyph->bitmap_left;
-			pSpriteData->bearing[1] = (*face)->glyph->bitmap_top;
-			pSpriteData->advance[0] = (float)((*face)->glyph->advance.x >> 6);
-			pSpriteData->advance[1] = (float)((*face)->glyph->advance.y >> 6);
-		}
-
-		strcpy(font.name, pFontSpec->name);
-		pAtlas->fonts = VectorPush(pAtlas->fonts, &font);
-		hFont = VectorSize(pAtlas->fonts) - 1;
+		printf("FT_Render_Glyph error\n");
+		return false;
 	}
 
-	return hFont;
+	pOutGlyph->bSet = true;
+	pOutGlyph->widthPx = face->glyph->bitmap.width;
+	pOutGlyph->heightPx = face->glyph->bitmap.rows;
+	pOutGlyph->pixels = FTBitmapToNestableBitmap(&face->glyph->bitmap);
+	pOutGlyph->bearing[0] = face->glyph->bitmap_left;
+	pOutGlyph->bearing[1] = face->glyph->bitmap_top;
+	pOutGlyph->advance[0] = (float)(face->glyph->advance.x >> 6);
+	pOutGlyph->advance[1] = (float)(face->glyph->advance.y >> 6);
+	return true;
 }
 
-int SortFunc(const void* a, const void* b) 
+static bool SetFaceSize(FT_Face face, float sizePts)
 {
-	AtlasSprite* pSprite1 = (AtlasSprite*)a;
-	AtlasSprite* pSprite2 = (AtlasSprite*)b;
-	/*return
-		pSprite1->heightPx > pSprite2->heightPx ? -1 : 0;*/
-	int area1 = pSprite1->heightPx * pSprite1->widthPx;
-	int area2 = pSprite2->heightPx * pSprite2->widthPx;
-	return
-		area1 < area2;
+	FT_Error error = FT_Set_Char_Size(
+		face,    /* handle to face object         */
+		sizePts * 64,       /* char_width in 1/64 of points  */
+		sizePts * 64,   /* char_height in 1/64 of points */
+		ATLAS_FONT_DPI,     /* horizontal device resolution  */
+		ATLAS_FONT_DPI);   /* vertical device resolution    */
+	if (error)
+	{
+		printf("FT_Set_Char_Size error");
+		return false;
+	}
+	return true;
 }
 
-struct AtlasRect
+static bool RasteriseGlyphSet(FT_Face face, float sizePts, struct AtlasGlyphSet* pOutSet)
 {
-	int w, h;
-	int x, y;
-	bool bTaken;
-};
+	memset(pOutSet, 0, sizeof(struct AtlasGlyphSet));
+	if (!SetFaceSize(face, sizePts))
+	{
+		return false;
+	}
+	for (int j = 0; j < 256; j++)
+	{
+		RasteriseGlyph(face, j, &pOutSet->glyphs[j]);
+	}
+	return true;
+}
 
-VECTOR(struct AtlasRect) AddNewFreeSpace(VECTOR(struct AtlasRect) outFreeSpace, int* currentWidth, int* currentHeight)
+static bool OpenFontFace(FT_Library lib, const char* path, FT_Face* pOutFace)
 {
-	if (*currentWidth > *currentHeight)
+	FT_Error error = FT_New_Face(lib, path, 0, pOutFace);
+	if (error == FT_Err_Unknown_File_Format)
 	{
-		int oldHeight = *currentHeight;
-		struct AtlasRect newR;
-		newR.x = 0;
-		newR.y = oldHeight;
-		newR.bTaken = false;
-		*currentHeight *= 2;
-		newR.w = *currentWidth;
-		newR.h = *currentHeight - oldHeight;
-		return VectorPush(outFreeSpace, &newR);
+		/*... the font file could be opened and read, but it appears
+			... that its font format is unsupported*/
+		printf("the font file '%s' could be opened and read, but it appears... that its font format is unsupported\n", path);
+		return false;
 	}
-	else
+	else if (error)
 	{
-		int oldWidth = *currentWidth;
-		struct AtlasRect newR;
-		newR.bTaken = false;
-		newR.y = 0;
-		newR.x = oldWidth;
-		*currentWidth *= 2;
-		newR.w = *currentWidth - oldWidth;
-		newR.h = *currentHeight;
-		return VectorPush(outFreeSpace, &newR);
+		/*... another error code means that the font file could not
+			... be opened or read, or that it is broken...*/
+		printf("font file '%s' another error code means that the font file could not... be opened or read, or that it is broken. error code %i\n", path, error);
+		return false;
+	}
+	return true;
+}
 
+bool At_RasteriseGlyphSet(const char* fontPath, float sizePts, struct AtlasGlyphSet* pOutSet)
+{
+	memset(pOutSet, 0, sizeof(struct AtlasGlyphSet));
+	/* a library per call, FreeType libraries can't be shared between threads */
+	FT_Library lib;
+	if (FT_Init_FreeType(&lib))
+	{
+		printf("Error initialising freetype!!!\n");
+		return false;
+	}
+	FT_Face face;
+	bool bSuccess = false;
+	if (OpenFontFace(lib, fontPath, &face))
+	{
+		bSuccess = RasteriseGlyphSet(face, sizePts, pOutSet);
+		FT_Done_Face(face);
 	}
+	FT_Done_FreeType(lib);
+	return bSuccess;
 }
 
-bool FitsInRect(const AtlasSprite* sprite, const struct AtlasRect* rect)
+void At_FreeGlyphSet(struct AtlasGlyphSet* pSet)
 {
-	return sprite->widthPx <= (rect->w - (ATLAS_SPRITE_BORDER_PXLS * 2)) && 
-		sprite->heightPx <= (rect->h - (ATLAS_SPRITE_BORDER_PXLS * 2));
+	for (int i = 0; i < 256; i++)
+	{
+		free(pSet->glyphs[i].pixels);
+		pSet->glyphs[i].pixels = NULL;
+	}
 }
 
-int FindFittingFreeSpace(const AtlasSprite* sprite, VECTOR(struct AtlasRect) freeSpace)
+static void AddGlyphSetToFont(const struct AtlasGlyphSet* pSet, struct AtlasFont* pFont)
 {
-	for (int j = 0; j < VectorSize(freeSpace); j++)
+	for (int j = 0; j < 256; j++)
 	{
-		struct AtlasRect* rct = &freeSpace[j];
-		if (freeSpace[j].bTaken)
+		const struct AtlasGlyph* pGlyph = &pSet->glyphs[j];
+		if (!pGlyph->bSet)
 		{
 			continue;
 		}
-		if (FitsInRect(sprite, rct))
-		{
-			return j;
-		}
+		AtlasSprite* pSprite = &pFont->sprites[j];
+		pSprite->widthPx = pGlyph->widthPx;
+		pSprite->heightPx = pGlyph->heightPx;
+		size_t size = (size_t)pGlyph->widthPx * pGlyph->heightPx * CHANNELS_PER_PIXEL;
+		pSprite->individualTileBytes = malloc(size);
+		memcpy(pSprite->individualTileBytes, pGlyph->pixels, size);
+		pSprite->bSet = true;
+		pSprite->id = gSpriteId++;
+
+		struct AtlasSpriteFontData* pSpriteData = &pFont->spriteData[j];
+		glm_vec2_copy((float*)pGlyph->bearing, pSpriteData->bearing);
+		glm_vec2_copy((float*)pGlyph->advance, pSpriteData->advance);
 	}
-	return -1;
 }
 
-static int Top(const struct AtlasRect* pRect)    { return pRect->y; }
-static int Bottom(const struct AtlasRect* pRect) { return pRect->y + pRect->h; }
-static int Left(const struct AtlasRect* pRect)   { return pRect->x; }
-static int Right(const struct AtlasRect* pRect)  { return pRect->x + pRect->w; }
-
-struct FreeSpaceRun
+static bool IsCharLoaded(struct AtlasFont* pFont, u8 c)
 {
-	int atlasRectI;
-	int x,y,length;
-};
- 
-struct FreeSpaceRun* FindRunInPrevRow(VECTOR(struct FreeSpaceRun) prevRow, struct FreeSpaceRun* pRun)
+	return pFont->sprites[c].bSet;
+}
+
+/* the extents of the whole font, so a line of text can be laid out without measuring it */
+static void ComputeFontMetrics(struct AtlasFont* pFont)
 {
-	for(int i = 0; i < VectorSize(prevRow); i++)
+	pFont->maxYBearing = 0.0f;
+	pFont->minBelowBaseline = 0.0f;
+	if (pFont->pDynamic)
+	{
+		/* its glyphs haven't been rasterised, so it's what the font says they reach */
+		FT_Size_Metrics* pMetrics = &pFont->pDynamic->ftSize->metrics;
+		pFont->maxYBearing = (float)(pMetrics->ascender >> 6);
+		pFont->minBelowBaseline = (float)(pMetrics->descender >> 6);
+		pFont->lineHeight = pFont->maxYBearing - pFont->minBelowBaseline;
+		return;
+	}
+	for (int c = 0; c < 256; c++)
 	{
-		if(prevRow[i].length == pRun->length && prevRow[i].x == pRun->x)
+		if (!IsCharLoaded(pFont, c))
+		{
+			continue;
+		}
+		float bearingY = pFont->spriteData[c].bearing[1];
+		if (bearingY > pFont->maxYBearing)
+		{
+			pFont->maxYBearing = bearingY;
+		}
+		float belowBaseline = bearingY - (float)pFont->sprites[c].heightPx;
+		if (belowBaseline < pFont->minBelowBaseline)
 		{
-			return &prevRow[i];
+			pFont->minBelowBaseline = belowBaseline;
 		}
 	}
-	return NULL;
+	pFont->lineHeight = pFont->maxYBearing - pFont->minBelowBaseline;
 }
 
-#define MERGE_FREE_SPACES
-
-struct AtlasRect* MergeFreeSpace(struct AtlasRect* pFreeSpace, struct Bitfield2D* pBF, int w, int h)
+static struct DynamicFont* NewDynamicFont(FT_Face face, const char* path, float sizePts)
 {
-	// bitmap based free space merging
-
-
-	// 1.) set the bits where the free space is in the 2d bitfield
-	for(int i=0; i<VectorSize(pFreeSpace); i++)
+	FT_Size size;
+	if (FT_New_Size(face, &size))
+	{
+		printf("FT_New_Size error\n");
+		return NULL;
+	}
+	FT_Activate_Size(size);
+	if (!SetFaceSize(face, sizePts))
 	{
-		struct AtlasRect* pRect = &pFreeSpace[i];
-		if(!pRect->bTaken)
-			Bf2D_SetBitfieldRegion(pBF, pRect->x, pRect->y, pRect->w, pRect->h);
+		FT_Done_Size(size);
+		return NULL;
 	}
+	struct DynamicFont* pDynamic = malloc(sizeof(struct DynamicFont));
+	memset(pDynamic, 0, sizeof(struct DynamicFont));
+	strncpy(pDynamic->path, path, MAX_FONT_PATH_SIZE - 1);
+	pDynamic->ftSize = size;
+	pDynamic->glyphs = NEW_VECTOR(struct DynamicGlyph);
+	for (int i = 0; i < 256; i++)
+	{
+		pDynamic->latin1Glyphs[i] = DYNAMIC_GLYPH_NONE;
+	}
+	return pDynamic;
+}
 
-	// 2.) iterate row by row, for each run in the row either:
-	//      - extend the rect associated with a run in the previous row that matches its width and position by one pixel and associate the rect with this new run
-	//      - add a new free space rect and associate it with this run
-	// different alternatives exist, if there's a run that's bigger than one on the previous row we could extend the previous row and create a new rect from the remainder
-	VECTOR(struct AtlasRect) newFreeSpace = NEW_VECTOR(struct AtlasRect);
-	
-	VECTOR(struct FreeSpaceRun) runs[2];
-	runs[0] = NEW_VECTOR(struct FreeSpaceRun);
-	runs[0] = VectorResize(runs[0], pFreeSpace);
-	runs[1] = NEW_VECTOR(struct FreeSpaceRun);
-	runs[1] = VectorResize(runs[1], pFreeSpace);
-
-	runs[0] = VectorClear(runs[0]);
-	runs[1] = VectorClear(runs[1]);
+/* before the face is released, FT_Done_Face frees its sizes */
+static void FreeDynamicFont(struct DynamicFont* pDynamic)
+{
+	FT_Done_Size(pDynamic->ftSize);
+	DestoryVector(pDynamic->glyphs);
+	free(pDynamic->pOtherCodepoints);
+	free(pDynamic->pOtherGlyphs);
+	free(pDynamic);
+}
 
-	int onRun = 0;
-	int prevRow = 1;
+static u32 OtherGlyphSlot(u32 codepoint, u32 capacity)
+{
+	return (codepoint * 2654435761u) & (capacity - 1);
+}
 
-	for(int row = 0; row < h; row++)
+static i32 FindDynamicGlyph(const struct DynamicFont* pDynamic, u32 codepoint)
+{
+	if (codepoint < 256)
+	{
+		return pDynamic->latin1Glyphs[codepoint];
+	}
+	if (!pDynamic->otherCapacity)
 	{
+		return DYNAMIC_GLYPH_NONE;
+	}
+	for (u32 i = OtherGlyphSlot(codepoint, pDynamic->otherCapacity); pDynamic->pOtherGlyphs[i] != DYNAMIC_GLYPH_NONE; i = (i + 1) & (pDynamic->otherCapacity - 1))
+	{
+		if (pDynamic->pOtherCodepoints[i] == codepoint)
+		{
+			return pDynamic->pOtherGlyphs[i];
+		}
+	}
+	return DYNAMIC_GLYPH_NONE;
+}
 
-		runs[onRun] = VectorClear(runs[onRun]);
-		bool bDoingRun = false;
+static void InsertOtherGlyph(struct DynamicFont* pDynamic, u32 codepoint, i32 glyph)
+{
+	u32 i = OtherGlyphSlot(codepoint, pDynamic->otherCapacity);
+	while (pDynamic->pOtherGlyphs[i] != DYNAMIC_GLYPH_NONE)
+	{
+		i = (i + 1) & (pDynamic->otherCapacity - 1);
+	}
+	pDynamic->pOtherCodepoints[i] = codepoint;
+	pDynamic->pOtherGlyphs[i] = glyph;
+	pDynamic->numOther++;
+}
 
-		// generate runs
-		for(int col = 0; col < w; col++)
+static void AddDynamicGlyphIndex(struct DynamicFont* pDynamic, u32 codepoint, i32 glyph)
+{
+	if (codepoint < 256)
+	{
+		pDynamic->latin1Glyphs[codepoint] = glyph;
+		return;
+	}
+	/* kept under half full */
+	if ((pDynamic->numOther + 1) * 2 > pDynamic->otherCapacity)
+	{
+		u32 oldCapacity = pDynamic->otherCapacity;
+		u32* pOldCodepoints = pDynamic->pOtherCodepoints;
+		i32* pOldGlyphs = pDynamic->pOtherGlyphs;
+		pDynamic->otherCapacity = oldCapacity ? oldCapacity * 2 : 64;
+		pDynamic->pOtherCodepoints = malloc(sizeof(u32) * pDynamic->otherCapacity);
+		pDynamic->pOtherGlyphs = malloc(sizeof(i32) * pDynamic->otherCapacity);
+		pDynamic->numOther = 0;
+		for (u32 i = 0; i < pDynamic->otherCapacity; i++)
 		{
-			if(Bf2D_IsBitSet(pBF, col, row))
-			{
-				if(bDoingRun)
-				{
-					((struct FreeSpaceRun*)VectorTop(runs[onRun]))->length++;
-				}
-				else
-				{
-					struct FreeSpaceRun fsr;
-					fsr.x = col;
-					fsr.y = row;
-					fsr.length = 1;
-					runs[onRun] = VectorPush(runs[onRun], &fsr);
-					bDoingRun = true;
-				}
-			}
-			else
-			{
-				bDoingRun = false;
-			}
+			pDynamic->pOtherGlyphs[i] = DYNAMIC_GLYPH_NONE;
 		}
-
-		// for each run, either add a new free space rect or extend an existing one
-		for(int i = 0; i < VectorSize(runs[onRun]); i++)
+		for (u32 i = 0; i < oldCapacity; i++)
 		{
-			struct FreeSpaceRun* pInPrevRow = FindRunInPrevRow(runs[onRun ? 0 : 1], &runs[onRun][i]);
-			if(pInPrevRow)
-			{
-				newFreeSpace[pInPrevRow->atlasRectI].h++;
-				runs[onRun][i].atlasRectI = pInPrevRow->atlasRectI;
-			}
-			else
+			if (pOldGlyphs[i] != DYNAMIC_GLYPH_NONE)
 			{
-				// add new free space
-				struct AtlasRect r =
-				{
-					.w = runs[onRun][i].length,
-					.h = 1,
-					.x = runs[onRun][i].x,
-					.y = runs[onRun][i].y,
-					.bTaken = false
-				};
-				newFreeSpace = VectorPush(newFreeSpace, &r);
-				runs[onRun][i].atlasRectI = VectorSize(newFreeSpace) - 1;
+				InsertOtherGlyph(pDynamic, pOldCodepoints[i], pOldGlyphs[i]);
 			}
 		}
-
-		// flip runs
-		prevRow = onRun;
-		onRun = onRun ? 0 : 1;
-	}
-	DestoryVector(runs[0]);
-	DestoryVector(runs[1]);
-	int sz = VectorSize(newFreeSpace);
-	printf("%i\n", sz);
-	for(int i=0; i<sz; i++)
-	{
-		printf("x: %i y: %i w: %i h: %i taken: %i\n", newFreeSpace[i].x, newFreeSpace[i].y, newFreeSpace[i].w, newFreeSpace[i].h, newFreeSpace[i].bTaken);
+		free(pOldCodepoints);
+		free(pOldGlyphs);
 	}
-	return newFreeSpace;
+	InsertOtherGlyph(pDynamic, codepoint, glyph);
 }
 
-
-int FreeSpaceSortFunc(const void* a, const void* b)
+/* nothing is rasterised until it's used */
+/* the font takes a reference to face */
+static HFont PushDynamicFont(Atlas* pAtlas, SHARED_PTR(FT_Face) face, const char* name, const char* path, float sizePts)
 {
-	struct AtlasRect* pA = a;
-	struct AtlasRect* pB = b;
-	return pA->w * pA->h > pB->w * pB->h;
+	struct AtlasFont font;
+	memset(&font, 0, sizeof(struct AtlasFont));
+	font.fSizePts = sizePts;
+	font.pDynamic = NewDynamicFont(*face, path, sizePts);
+	if (!font.pDynamic)
+	{
+		return NULL_HANDLE;
+	}
+	font.pFTFace = face;
+	Sptr_AddRef(face);
+	strncpy(font.name, name, MAX_FONT_NAME_SIZE - 1);
+	ComputeFontMetrics(&font);
+	pAtlas->fonts = VectorPush(pAtlas->fonts, &font);
+	return VectorSize(pAtlas->fonts) - 1;
 }
 
-static VECTOR(struct AtlasRect) NestSingleSprite(int* outW, int* outH, AtlasSprite* pSprite, VECTOR(struct AtlasRect) freeSpace, struct Bitfield2D* pBF)
+static HFont AddDynamicFont(const struct FontAtlasAdditionSpec* pFontSpec)
 {
-	size_t sizeofFreespace = VectorSize(freeSpace);
-	int index = FindFittingFreeSpace(pSprite, freeSpace);
-	if (index >= 0)
+	Atlas* pAtlas = GetCurrentAtlas();
+	SHARED_PTR(FT_Face) face = SHARED_PTR_NEW(FT_Face, &FaceDtor);
+	if (!OpenFontFace(gFTLib, pFontSpec->path, face))
 	{
-		struct AtlasRect* rct = &freeSpace[index];
-		rct->bTaken = true;
-
-		/*
-		     we need to split the remaining space into two rectangles and push them into
-			 the free space list like so:
-
-			 <-------- rct->w ------->
-			  _______________________
-			 | sprite |  region 1    |
-			 |________|______________|
-			 |                       |    rect->h
-			 |     region 2          |
-			 |_______________________|
-		
-		*/
-
-		pSprite->atlasTopLeftXPx = rct->x;
-		pSprite->atlasTopLeftYPx = rct->y;
-		int newRightX = rct->x + pSprite->widthPx + (2 * ATLAS_SPRITE_BORDER_PXLS);
-		int newRightY = rct->y;
-		int newW = rct->w - (pSprite->widthPx + (2 * ATLAS_SPRITE_BORDER_PXLS));
-		int newH = pSprite->heightPx + (2 * ATLAS_SPRITE_BORDER_PXLS);
-		struct AtlasRect region1 = { newW, newH, newRightX, newRightY, false };
-
-		newRightX = rct->x;
-		newRightY = rct->y + (pSprite->heightPx + (2 * ATLAS_SPRITE_BORDER_PXLS));
-		newW = rct->w;
-		newH = rct->h - (pSprite->heightPx + (2 * ATLAS_SPRITE_BORDER_PXLS));
-		struct AtlasRect region2 = { newW, newH, newRightX, newRightY, false };
-
-		if (region1.w * region1.h > 1e-4)
-		{
-			freeSpace = VectorPush(freeSpace, &region1);
-		}
-		if (region2.w * region2.h > 1e-4)
-		{
-			freeSpace = VectorPush(freeSpace, &region2);
-		}
-#ifdef MERGE_FREE_SPACES
-		Bf2D_ClearBitField(pBF);
-		void* prevFreeSpace = freeSpace;
-		freeSpace = MergeFreeSpace(freeSpace, pBF, *outW, *outH);
-		DestoryVector(prevFreeSpace);
-#endif
-		return freeSpace;
+		return NULL_HANDLE;
 	}
-	else
+	HFont hFont = NULL_HANDLE;
+	for (int i = 0; i < pFontSpec->numFontSizes; i++)
 	{
-		printf("resizing...\n");
-		int sz = VectorSize(freeSpace);
-		printf("%i\n", sz);
-		for(int i=0; i<sz; i++)
+		HFont hAdded = PushDynamicFont(pAtlas, face, pFontSpec->name, pFontSpec->path, At_FontSizeToPts(&pFontSpec->fontSizes[i]));
+		if (hAdded != NULL_HANDLE)
 		{
-			printf("x: %i y: %i w: %i h: %i taken: %i\n", freeSpace[i].x, freeSpace[i].y, freeSpace[i].w, freeSpace[i].h, freeSpace[i].bTaken);
+			hFont = hAdded;
 		}
-		freeSpace = AddNewFreeSpace(freeSpace, outW, outH);
-#ifdef MERGE_FREE_SPACES
-		Bf2D_ResizeAndClearBitField(pBF, *outW, *outH);
-		void* prevFreeSpace = freeSpace;
-		freeSpace = MergeFreeSpace(freeSpace, pBF, *outW, *outH);
-		DestoryVector(prevFreeSpace);
-#endif
-		// sort from small to big
-		qsort(freeSpace, VectorSize(freeSpace), sizeof(struct AtlasRect), &FreeSpaceSortFunc);
-		return NestSingleSprite(outW, outH, pSprite, freeSpace, pBF);
 	}
+	/* the fonts hold the references now */
+	Sptr_RemoveRef(face);
+	return hFont;
 }
 
-static void NestSprites(int* outW, int* outH, AtlasSprite* sortedSpritesTallestToShortest, int numSprites, struct EndAtlasOptions* pOptions)
+HFont At_AddFont(const struct FontAtlasAdditionSpec* pFontSpec)
+{
+	if (pFontSpec->bDynamic)
+	{
+		return AddDynamicFont(pFontSpec);
+	}
+	HFont hFont = NULL_HANDLE;
+	SHARED_PTR(FT_Face) face = NULL;      /* handle to face object, only opened if a size isn't provided */
+	Atlas* pAtlas = GetCurrentAtlas();
+	for (int i = 0; i < pFontSpec->numFontSizes; i++)
+	{
+		float sizePts = At_FontSizeToPts(&pFontSpec->fontSizes[i]);
+		const struct AtlasGlyphSet* pSet = NULL;
+		struct AtlasGlyphSet rasterised;
+		if (gpSources && gpSources->GetGlyphSet)
+		{
+			pSet = gpSources->GetGlyphSet(gpSources->pUser, pFontSpec->path, sizePts);
+		}
+		if (!pSet)
+		{
+			if (!face)
+			{
+				face = SHARED_PTR_NEW(FT_Face, &FaceDtor);
+				if (!OpenFontFace(gFTLib, pFontSpec->path, face))
+				{
+					return NULL_HANDLE;
+				}
+			}
+			if (!RasteriseGlyphSet(*face, sizePts, &rasterised))
+			{
+				At_FreeGlyphSet(&rasterised);
+				return NULL_HANDLE;
+			}
+			pSet = &rasterised;
+		}
+
+		struct AtlasFont font;
+		memset(&font, 0, sizeof(struct AtlasFont));
+		font.fSizePts = sizePts;
+		if (face)
+		{
+			font.pFTFace = face;
+			Sptr_AddRef(face);
+		}
+		AddGlyphSetToFont(pSet, &font);
+		if (pSet == &rasterised)
+		{
+			At_FreeGlyphSet(&rasterised);
+		}
+
+		strcpy(font.name, pFontSpec->name);
+		ComputeFontMetrics(&font);
+		pAtlas->fonts = VectorPush(pAtlas->fonts, &font);
+		hFont = VectorSize(pAtlas->fonts) - 1;
+	}
+
+	return hFont;
+}
+
+int SortFunc(const void* a, const void* b) 
+{
+	AtlasSprite* pSprite1 = (AtlasSprite*)a;
+	AtlasSprite* pSprite2 = (AtlasSprite*)b;
+	/*return
+		pSprite1->heightPx > pSprite2->heightPx ? -1 : 0;*/
+	int area1 = pSprite1->heightPx * pSprite1->widthPx;
+	int area2 = pSprite2->heightPx * pSprite2->widthPx;
+	return
+		area1 < area2;
+}
+
+static void NestSprites(int* outW, int* outH, AtlasSprite* sortedSpritesTallestToShortest, int numSprites, struct EndAtlasOptions* pOptions)
 {
-	
-	VECTOR(struct AtlasRect) freeSpace = NEW_VECTOR(struct AtlasRect);
-
-	
-	int tallestHeight = sortedSpritesTallestToShortest->heightPx;
-
 	int currentW = 1;
 	int currentH = 1;
 	if (pOptions->bUseBiggestSpriteForInitialAtlasSize)
@@ -604,29 +865,21 @@ static void NestSprites(int* outW, int* outH, AtlasSprite* sortedSpritesTallestT
 		currentW = pOptions->initialAtlasWidth;
 		currentH = pOptions->initialAtlasHeight;
 	}
-	
-	
-	struct AtlasRect r = {
-		.w = currentW,
-		.h = currentH,
-		.x = 0,
-		.y = 0,
-		.bTaken = false
-	};
-	
-	/* used to merge free space blocks */
-	struct Bitfield2D* pBitField = Bf2D_NewBitField(currentW, currentH);
-
-	freeSpace = VectorPush(freeSpace, &r);
 
+	/* packed with their borders */
+	struct AtlasPackerRect* pRects = malloc(sizeof(struct AtlasPackerRect) * numSprites);
+	for (int i = 0; i < numSprites; i++)
+	{
+		pRects[i].w = sortedSpritesTallestToShortest[i].widthPx + (2 * ATLAS_SPRITE_BORDER_PXLS);
+		pRects[i].h = sortedSpritesTallestToShortest[i].heightPx + (2 * ATLAS_SPRITE_BORDER_PXLS);
+	}
+	AtP_Pack(pOptions->packer, pRects, numSprites, &currentW, &currentH, pOptions->pOutPackStats);
 	for (int i = 0; i < numSprites; i++)
 	{
-		bool bFitInEmptySpace = false;
-		AtlasSprite* pSprt = &sortedSpritesTallestToShortest[i];
-		freeSpace = NestSingleSprite(&currentW, &currentH, pSprt, freeSpace, pBitField);
+		sortedSpritesTallestToShortest[i].atlasTopLeftXPx = pRects[i].x;
+		sortedSpritesTallestToShortest[i].atlasTopLeftYPx = pRects[i].y;
 	}
-	Bf2D_FreeBitField(pBitField);
-	DestoryVector(freeSpace);
+	free(pRects);
 	*outW = currentW;
 	*outH = currentH;
 }
@@ -718,12 +971,6 @@ void CopyNestedPositions(Atlas* pAtlasDest, AtlasSprite* spritesCopySrc, int spr
 	}
 }
 
-static bool IsCharLoaded(struct AtlasFont* pFont, char c)
-{
-	return pFont->sprites[c].bSet;
-}
-
-
 static void CalculateSpriteUVs(AtlasSprite* pSprt, int atlasW, int atlasH)
 {
 	pSprt->topLeftUV_U = (float)pSprt->atlasTopLeftXPx / (float)atlasW;
@@ -783,6 +1030,50 @@ static void WriteFontSprites(Atlas* pAtlas, AtlasSprite* outFontSprites)
 	}
 }
 
+static void OnGlyphEvicted(void* pUser, u64 glyph)
+{
+	Atlas* pAtlas = &gAtlases[(hAtlas)(intptr_t)pUser];
+	struct DynamicFont* pDynamic = pAtlas->fonts[(HFont)(glyph >> 32)].pDynamic;
+	pDynamic->glyphs[(u32)glyph].shelf = GLYPH_SHELF_NONE;
+	pAtlas->glyphCacheGeneration++;
+}
+
+static void InitGlyphCache(hAtlas hAtlas, int x, int y, int w, int h)
+{
+	Atlas* pAtlas = &gAtlases[hAtlas];
+	GSP_Init(&pAtlas->glyphCache, x, y, w, h, &OnGlyphEvicted, (void*)(intptr_t)hAtlas);
+	pAtlas->pendingGlyphUploads = NEW_VECTOR(struct PendingGlyphUpload);
+	pAtlas->bHasGlyphCache = true;
+}
+
+static void DeInitGlyphCache(Atlas* pAtlas)
+{
+	if (!pAtlas->bHasGlyphCache)
+	{
+		return;
+	}
+	for (int i = 0; i < VectorSize(pAtlas->pendingGlyphUploads); i++)
+	{
+		free(pAtlas->pendingGlyphUploads[i].pixels);
+	}
+	DestoryVector(pAtlas->pendingGlyphUploads);
+	pAtlas->pendingGlyphUploads = NULL;
+	GSP_DeInit(&pAtlas->glyphCache);
+	pAtlas->bHasGlyphCache = false;
+}
+
+static bool HasDynamicFonts(Atlas* pAtlas)
+{
+	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
+	{
+		if (pAtlas->fonts[i].pDynamic)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 static struct EndAtlasOptions* GetDefaultAtlasOptions()
 {
 	static struct EndAtlasOptions opt =
@@ -790,14 +1081,17 @@ static struct EndAtlasOptions* GetDefaultAtlasOptions()
 		.initialAtlasWidth = 512,
 		.initialAtlasHeight = 512,
 		.outDebugBitmapPath = NULL,
-		.bUseBiggestSpriteForInitialAtlasSize = false
+		.bUseBiggestSpriteForInitialAtlasSize = false,
+		.packer = APT_FreeSpaceMerge,
+		.pOutPackStats = NULL,
+		.pSources = NULL
 	};
 	return &opt;
 }
 
 hAtlas At_EndAtlas(struct DrawContext* pDC)
 {
-	At_EndAtlasEx(pDC, GetDefaultAtlasOptions());
+	return At_EndAtlasEx(pDC, GetDefaultAtlasOptions());
 }
 
 hAtlas At_EndAtlasEx(struct DrawContext* pDC, struct EndAtlasOptions* pOptions)
@@ -809,20 +1103,52 @@ hAtlas At_EndAtlasEx(struct DrawContext* pDC, struct EndAtlasOptions* pOptions)
 	}
 	size_t numSprites = VectorSize(pAtlas->sprites);
 	size_t numSpritesFromFonts = CountTotalSpritesInFonts(pAtlas);
-	if (numSprites + numSpritesFromFonts <= 0)
+	/* the glyph cache is packed like a sprite, to reserve its region */
+	size_t numGlyphCacheSprites = HasDynamicFonts(pAtlas) ? 1 : 0;
+	size_t numToPack = numSprites + numSpritesFromFonts + numGlyphCacheSprites;
+	if (numToPack <= 0)
 	{
 		return NULL_HANDLE;
 	}
-	AtlasSprite* spritesCopy = malloc(sizeof(AtlasSprite) * (numSprites + numSpritesFromFonts));
+	AtlasSprite* spritesCopy = malloc(sizeof(AtlasSprite) * numToPack);
 	if (spritesCopy)
 	{
 		memcpy(spritesCopy, pAtlas->sprites, numSprites * sizeof(AtlasSprite));
 		AtlasSprite* pOutFontSprites = spritesCopy + numSprites;
 		WriteFontSprites(pAtlas, pOutFontSprites);
+		int glyphCacheId = 0;
+		if (numGlyphCacheSprites)
+		{
+			/* glyphs in the cache have their own borders, so the region takes the sprite border too */
+			AtlasSprite* pRegion = &spritesCopy[numToPack - 1];
+			memset(pRegion, 0, sizeof(AtlasSprite));
+			pRegion->widthPx = (pAtlas->requestedGlyphCacheWidth > 0 ? pAtlas->requestedGlyphCacheWidth : ATLAS_DEFAULT_GLYPH_CACHE_SIZE) - 2 * ATLAS_SPRITE_BORDER_PXLS;
+			pRegion->heightPx = (pAtlas->requestedGlyphCacheHeight > 0 ? pAtlas->requestedGlyphCacheHeight : ATLAS_DEFAULT_GLYPH_CACHE_SIZE) - 2 * ATLAS_SPRITE_BORDER_PXLS;
+			pRegion->id = gSpriteId++;
+			glyphCacheId = pRegion->id;
+		}
 
-		qsort(spritesCopy, numSprites + numSpritesFromFonts, sizeof(AtlasSprite), &SortFunc);
+		qsort(spritesCopy, numToPack, sizeof(AtlasSprite), &SortFunc);
 		int w, h;
-		NestSprites(&w, &h, spritesCopy, numSprites + numSpritesFromFonts, pOptions);
+		NestSprites(&w, &h, spritesCopy, numToPack, pOptions);
+
+		int glyphCacheX = 0, glyphCacheY = 0, glyphCacheW = 0, glyphCacheH = 0;
+		if (numGlyphCacheSprites)
+		{
+			/* it isn't a sprite in the atlas, so take it out before copying the positions back */
+			for (size_t i = 0; i < numToPack; i++)
+			{
+				if (spritesCopy[i].id == glyphCacheId)
+				{
+					glyphCacheX = spritesCopy[i].atlasTopLeftXPx;
+					glyphCacheY = spritesCopy[i].atlasTopLeftYPx;
+					glyphCacheW = spritesCopy[i].widthPx + 2 * ATLAS_SPRITE_BORDER_PXLS;
+					glyphCacheH = spritesCopy[i].heightPx + 2 * ATLAS_SPRITE_BORDER_PXLS;
+					spritesCopy[i] = spritesCopy[numToPack - 1];
+					break;
+				}
+			}
+		}
 
 		CopyNestedPositions(pAtlas, spritesCopy, numSprites + numSpritesFromFonts);
 		free(spritesCopy);
@@ -842,6 +1168,9 @@ hAtlas At_EndAtlasEx(struct DrawContext* pDC, struct EndAtlasOptions* pOptions)
 
 			free(pSprite->individualTileBytes);
 			pSprite->individualTileBytes = NULL;
+
+			/* loaded by At_AddSprite */
+			IR_UnloadImage(pSprite->srcImage);
 		}
 
 		for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
@@ -864,6 +1193,10 @@ hAtlas At_EndAtlasEx(struct DrawContext* pDC, struct EndAtlasOptions* pOptions)
 		pAtlas->atlasHeight = h;
 
 		CalculateAtlasUVs(pAtlas);
+		if (numGlyphCacheSprites)
+		{
+			InitGlyphCache(gCurrentAtlasIndex, glyphCacheX, glyphCacheY, glyphCacheW, glyphCacheH);
+		}
 
 		if (pOptions->outDebugBitmapPath)
 		{
@@ -931,7 +1264,17 @@ void At_DestroyAtlas(hAtlas atlas, struct DrawContext* pDC)
 	for (int i = 0; i < VectorSize(gAtlases[atlas].fonts); i++)
 	{
 		struct AtlasFont* pFont = &gAtlases[atlas].fonts[i];
-		Sptr_RemoveRef(pFont->pFTFace);
+		/* its FT_Size belongs to the face, so it goes first */
+		if (pFont->pDynamic)
+		{
+			FreeDynamicFont(pFont->pDynamic);
+			pFont->pDynamic = NULL;
+		}
+		/* fonts loaded from .atlas files don't have a face */
+		if (pFont->pFTFace)
+		{
+			Sptr_RemoveRef(pFont->pFTFace);
+		}
 		for (int j = 0; j < 256; j++)
 		{
 			AtlasSprite* pSprite = &gAtlases[atlas].fonts[i].sprites[j];
@@ -963,8 +1306,20 @@ void At_DestroyAtlas(hAtlas atlas, struct DrawContext* pDC)
 	}
 
 	HashmapDeInit(&gAtlases[atlas].animations);
+	HashmapDeInit(&gAtlases[atlas].fontIndex);
+	GRC_InvalidateAtlas(atlas);
+	DeInitGlyphCache(&gAtlases[atlas]);
 
-	free(gAtlases[atlas].atlasBytes);
+	if (!AtlasBytesInMapping(&gAtlases[atlas]))
+	{
+		free(gAtlases[atlas].atlasBytes);
+	}
+	gAtlases[atlas].atlasBytes = NULL;
+	if (gAtlases[atlas].pMappedFile)
+	{
+		MappedFile_Close(gAtlases[atlas].pMappedFile);
+		gAtlases[atlas].pMappedFile = NULL;
+	}
 }
 
 hSprite At_FindSprite(const char* name, hAtlas atlas)
@@ -1000,6 +1355,14 @@ hTexture At_GetAtlasTexture(hAtlas atlas)
 	return pAtlas->texture;
 }
 
+void At_GetAtlasTextureDims(hAtlas atlas, int* pOutWidth, int* pOutHeight)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK_NO_RETURN(atlas);
+	Atlas* pAtlas = &gAtlases[atlas];
+	*pOutWidth = pAtlas->atlasWidth;
+	*pOutHeight = pAtlas->atlasHeight;
+}
+
 
 static hSprite LoadAtlasSprite(xmlNode* pChild, int onChild)
 {
@@ -1161,6 +1524,11 @@ static void LoadAtlasFont(xmlNode* pChild)
 		}
 		xmlFree(attribute);
 	}
+	if (attribute = xmlGetProp(pChild, "dynamic"))
+	{
+		faas.bDynamic = strcmp(attribute, "true") == 0;
+		xmlFree(attribute);
+	}
 	for (xmlNode* pChildChild = pChild->children; pChildChild; pChildChild = pChildChild->next)
 	{
 		if (pChildChild->type != XML_ELEMENT_NODE)
@@ -1204,9 +1572,49 @@ static void LoadAtlasFont(xmlNode* pChild)
 	printf("done\n");
 }
 
+static void PrefetchSpriteImage(xmlNode* pSpriteNode)
+{
+	xmlChar* attribute = xmlGetProp(pSpriteNode, "source");
+	if (attribute)
+	{
+		HImage img = IR_LookupHandleByPath(attribute);
+		if (img != NULL_HIMAGE)
+		{
+			IR_LoadImageAsync(img, NULL, NULL);
+		}
+		xmlFree(attribute);
+	}
+}
+
+/* start decoding every image the atlas uses so they decode while the first sprites are added */
+static void PrefetchAtlasImages(xmlNode* child0)
+{
+	for (xmlNode* pChild = child0->children; pChild; pChild = pChild->next)
+	{
+		if (pChild->type != XML_ELEMENT_NODE)
+		{
+			continue;
+		}
+		if (strcmp(pChild->name, "sprite") == 0)
+		{
+			PrefetchSpriteImage(pChild);
+		}
+		else if (strcmp(pChild->name, "animation-frames") == 0)
+		{
+			for (xmlNode* pFrame = pChild->children; pFrame; pFrame = pFrame->next)
+			{
+				if (pFrame->type == XML_ELEMENT_NODE && strcmp(pFrame->name, "sprite") == 0)
+				{
+					PrefetchSpriteImage(pFrame);
+				}
+			}
+		}
+	}
+}
+
 hAtlas At_LoadAtlas(xmlNode* child0, DrawContext* pDC)
 {
-	At_LoadAtlasEx(child0, pDC, GetDefaultAtlasOptions());
+	return At_LoadAtlasEx(child0, pDC, GetDefaultAtlasOptions());
 }
 
 hAtlas At_LoadAtlasEx(xmlNode* child0, DrawContext* pDC, struct EndAtlasOptions* pOptions)
@@ -1215,15 +1623,15 @@ hAtlas At_LoadAtlasEx(xmlNode* child0, DrawContext* pDC, struct EndAtlasOptions*
 	xmlChar* attribute = NULL;
 	if (attribute = xmlGetProp(child0, "binary"))
 	{
-		struct BinarySerializer serializer;
-		BS_CreateForLoad(attribute, &serializer);
-		hAtlas newAtlas = -1;
-		At_SerializeAtlas(&serializer, &newAtlas, pDC);
-		BS_Finish(&serializer);
-		return newAtlas;
+		return At_LoadAtlasFile(attribute, pDC);
 	}
 
 	At_BeginAtlas();
+	gpSources = pOptions->pSources;
+	if (!gpSources)
+	{
+		PrefetchAtlasImages(child0);
+	}
 
 	// todo: add proper error handling
 	if (attribute = xmlGetProp(child0, "tilesetStart"))
@@ -1236,6 +1644,19 @@ hAtlas At_LoadAtlasEx(xmlNode* child0, DrawContext* pDC, struct EndAtlasOptions*
 		int i = atoi(attribute);
 		At_EndTileset(i);
 	}
+	int glyphCacheWidth = 0;
+	int glyphCacheHeight = 0;
+	if (attribute = xmlGetProp(child0, "glyphCacheWidth"))
+	{
+		glyphCacheWidth = atoi(attribute);
+		xmlFree(attribute);
+	}
+	if (attribute = xmlGetProp(child0, "glyphCacheHeight"))
+	{
+		glyphCacheHeight = atoi(attribute);
+		xmlFree(attribute);
+	}
+	At_SetGlyphCacheSize(glyphCacheWidth, glyphCacheHeight);
 
 
 	int onChild = 0;
@@ -1260,6 +1681,7 @@ hAtlas At_LoadAtlasEx(xmlNode* child0, DrawContext* pDC, struct EndAtlasOptions*
 			LoadAnimationFrames(pChild, &onChild);
 		}
 	}
+	gpSources = NULL;
 	return At_EndAtlasEx(pDC, pOptions);
 }
 
@@ -1270,6 +1692,16 @@ hSprite At_TilemapIndexToSprite(hAtlas atlas, TileIndex tileIndex)
 	return (tileIndex - 1) + pAtlas->tilesetIndexBegin;
 }
 
+int At_GetNumTilesetTiles(hAtlas atlas)
+{
+	Atlas* pAtlas = &gAtlases[atlas];
+	if (pAtlas->tilesetIndexBegin < 0 || pAtlas->tilesetIndexEnd < pAtlas->tilesetIndexBegin)
+	{
+		return 0;
+	}
+	return pAtlas->tilesetIndexEnd - pAtlas->tilesetIndexBegin;
+}
+
 static void SerializeAtlasSprite(const AtlasSprite* pSprite, struct BinarySerializer* pSerializer)
 {
 	EASSERT(pSerializer->bSaving);
@@ -1290,7 +1722,9 @@ static void SerializeAtlasSprite(const AtlasSprite* pSprite, struct BinarySerial
 
 static void SerializeAtlasFont(const struct AtlasFont* pFont, struct BinarySerializer* pSerializer)
 {
-	BS_SerializeBytes((const char*)pFont->spriteData, sizeof(struct AtlasSpriteFontData) * 256, pSerializer);
+	/* byte size then the floats, same layout as BS_SerializeBytes */
+	BS_SerializeU32(sizeof(struct AtlasSpriteFontData) * 256, pSerializer);
+	BS_SerializeF32Array((const float*)pFont->spriteData, sizeof(struct AtlasSpriteFontData) * 256 / sizeof(float), pSerializer);
 	for (int i = 0; i < 256; i++)
 	{
 		SerializeAtlasSprite(&pFont->sprites[i], pSerializer);
@@ -1302,6 +1736,8 @@ static void SerializeAtlasFont(const struct AtlasFont* pFont, struct BinarySeria
 static void DeserializeAtlasSpriteV1(AtlasSprite* pSprite, struct BinarySerializer* pSerializer)
 {
 	EASSERT(!pSerializer->bSaving);
+	/* fields that aren't in the file, like individualTileBytes, are freed by At_DestroyAtlas */
+	memset(pSprite, 0, sizeof(AtlasSprite));
 	BS_DeSerializeString(&pSprite->name, pSerializer);
 	BS_DeSerializeI32(&pSprite->srcImageTopLeftXPx, pSerializer);
 	BS_DeSerializeI32(&pSprite->srcImageTopLeftYPx, pSerializer);
@@ -1322,7 +1758,7 @@ static void DeserializeAtlasFontV1(struct AtlasFont* pFont, struct BinarySeriali
 	u32 size = 0;
 	BS_DeSerializeU32(&size, pSerializer);
 	EASSERT(size == sizeof(struct AtlasSpriteFontData) * 256);
-	BS_BytesRead(pSerializer, sizeof(struct AtlasSpriteFontData) * 256, (char*)pFont->spriteData);
+	BS_DeSerializeF32Array((float*)pFont->spriteData, sizeof(struct AtlasSpriteFontData) * 256 / sizeof(float), pSerializer);
 	for (int i = 0; i < 256; i++)
 	{
 		DeserializeAtlasSpriteV1(&pFont->sprites[i], pSerializer);
@@ -1399,6 +1835,8 @@ static hAtlas DeserializeAtlasV1(struct BinarySerializer* pSerializer, struct Dr
 	Atlas* pAtlas = AqcuireAtlas();
 	
 	pAtlas->atlasBytes = NULL;
+	pAtlas->pMappedFile = NULL;
+	memset(&pAtlas->encodedPixels, 0, sizeof(struct AtlasEncodedPixels));
 	pAtlas->atlasHeight = 0;
 	pAtlas->atlasWidth = 0;
 	pAtlas->sprites = NEW_VECTOR(AtlasSprite);
@@ -1406,6 +1844,9 @@ static hAtlas DeserializeAtlasV1(struct BinarySerializer* pSerializer, struct Dr
 	pAtlas->texture = NULL_HANDLE;
 	pAtlas->bActive = true;
 	HashmapInit(&pAtlas->animations, 64, sizeof(struct AtlasAnimation));
+	HashmapInit(&pAtlas->fontIndex, 16, sizeof(HFont));
+	pAtlas->numIndexedFonts = 0;
+	InitGlyphCacheFields(pAtlas);
 
 	// width and height
 	BS_DeSerializeI32(&pAtlas->atlasHeight, pSerializer);
@@ -1434,6 +1875,7 @@ static hAtlas DeserializeAtlasV1(struct BinarySerializer* pSerializer, struct Dr
 	{
 		static struct AtlasFont font;
 		DeserializeAtlasFontV1(&font, pSerializer);
+		ComputeFontMetrics(&font);
 		pAtlas->fonts = VectorPush(pAtlas->fonts, &font);
 	}
 
@@ -1450,195 +1892,1243 @@ static hAtlas DeserializeAtlasV1(struct BinarySerializer* pSerializer, struct Dr
 
 }
 
-void At_SerializeAtlas(struct BinarySerializer* pSerializer, hAtlas* atlas, struct DrawContext* pDC)
+static void SerializeAtlasV1(Atlas* pAtlas, struct BinarySerializer* pSerializer)
 {
-	
-	
-	if (pSerializer->bSaving)
-	{
-		ATLAS_HANDLE_BOUNDS_CHECK_NO_RETURN(*atlas);
-		Atlas* pAtlas = &gAtlases[*atlas];
-		// File version: 1
-		BS_SerializeU32(1, pSerializer);
-	
-		// width and height
-		BS_SerializeI32(pAtlas->atlasHeight, pSerializer);
-		BS_SerializeI32(pAtlas->atlasWidth, pSerializer);
-		
-		// tileset begin and end
-		BS_SerializeI32(pAtlas->tilesetIndexBegin, pSerializer);
-		BS_SerializeI32(pAtlas->tilesetIndexEnd, pSerializer);
-
-		// sprites
-		BS_SerializeU32(VectorSize(pAtlas->sprites), pSerializer);
-		for (int i = 0; i < VectorSize(pAtlas->sprites); i++)
-		{
-			SerializeAtlasSprite(&pAtlas->sprites[i], pSerializer);
-		}
+	// File version: 1
+	BS_SerializeU32(1, pSerializer);
 
-		// fonts
-		BS_SerializeU32(VectorSize(pAtlas->fonts), pSerializer);
-		for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
-		{
-			SerializeAtlasFont(&pAtlas->fonts[i], pSerializer);
-		}
+	// width and height
+	BS_SerializeI32(pAtlas->atlasHeight, pSerializer);
+	BS_SerializeI32(pAtlas->atlasWidth, pSerializer);
+	
+	// tileset begin and end
+	BS_SerializeI32(pAtlas->tilesetIndexBegin, pSerializer);
+	BS_SerializeI32(pAtlas->tilesetIndexEnd, pSerializer);
 
-		// animations
-		SerializeAnimations(pAtlas, pSerializer);
+	// sprites
+	BS_SerializeU32(VectorSize(pAtlas->sprites), pSerializer);
+	for (int i = 0; i < VectorSize(pAtlas->sprites); i++)
+	{
+		SerializeAtlasSprite(&pAtlas->sprites[i], pSerializer);
+	}
 
-		BS_SerializeBytes(pAtlas->atlasBytes, pAtlas->atlasWidth * pAtlas->atlasHeight * 4, pSerializer);
+	// fonts - version 1 has no way to store dynamic fonts
+	u32 numStaticFonts = 0;
+	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
+	{
+		numStaticFonts += pAtlas->fonts[i].pDynamic ? 0 : 1;
 	}
-	else
+	if (numStaticFonts != VectorSize(pAtlas->fonts))
 	{
-		u32 version = 0;
-		BS_DeSerializeU32(&version, pSerializer);
-		switch (version)
-		{
-		case 1:
-			*atlas = DeserializeAtlasV1(pSerializer, pDC);
-			break;
-		default:
-			printf("Unknown atlas binary file version number %ui\n", version);
-		}
+		printf("SerializeAtlasV1: %i dynamic fonts not saved, use version 2\n", (int)(VectorSize(pAtlas->fonts) - numStaticFonts));
 	}
-}
-
-HFont Fo_FindFont(hAtlas hAtlas, const char* fontName, float sizePts)
-{
-	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, NULL_HANDLE);
-	Atlas* pAtlas = &gAtlases[hAtlas];
-	HFont matchingName = NULL_HANDLE; // if one with a matching name but not matching size is found then return that
-	
+	BS_SerializeU32(numStaticFonts, pSerializer);
 	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
 	{
-		struct AtlasFont* pFont = &pAtlas->fonts[i];
-		if (strcmp(pFont->name, fontName) == 0)
+		if (!pAtlas->fonts[i].pDynamic)
 		{
-			matchingName = i;
-			if (CompareFloat(pFont->fSizePts, sizePts))
-			{
-				return i;
-			}
+			SerializeAtlasFont(&pAtlas->fonts[i], pSerializer);
 		}
 	}
 
-	return matchingName;
-}
+	// animations
+	SerializeAnimations(pAtlas, pSerializer);
 
-float Fo_CharWidth(hAtlas hAtlas, HFont hFont, char c)
-{
-	return gAtlases[hAtlas].fonts[hFont].sprites[(u8)c].widthPx;
+	BS_SerializeBytes(GetAtlasBytes(pAtlas), pAtlas->atlasWidth * pAtlas->atlasHeight * 4, pSerializer);
 }
 
-float Fo_CharHeight(hAtlas hAtlas, HFont hFont, char c)
+/*
+	.atlas file version 2
+
+	Laid out to be memory mapped: raw pixels are handed to UploadTexture straight from the mapping and everything
+	else is read from fixed size records in place. Compressed pixels are decoded straight into the DrawContext's
+	texture upload buffer if it has one. All values are little endian.
+
+	header, ATLAS_V2_HEADER_SIZE bytes:
+		u32 version (2), u32 number of sections,
+		i32 height, i32 width, i32 tileset begin, i32 tileset end, 8 bytes zero
+	offset table, an ATLAS_V2_SECTION_ENTRY_SIZE entry per section:
+		u32 section type (enum AtlasV2Section), u32 number of records, u64 offset from the start of the file, u64 size
+	then the sections, each starting on an ATLAS_V2_SECTION_ALIGNMENT byte boundary.
+
+	Names are offsets into the strings section of nul terminated strings, ATLAS_V2_NO_NAME for none.
+	Sections of an unknown type are skipped, so new ones can be added without a new version.
+	A file has every section up to AV2_Pixels and then the pixels in one of the encodings of enum AtlasPixelEncoding.
+*/
+#define ATLAS_V2_HEADER_SIZE 32
+#define ATLAS_V2_SECTION_ENTRY_SIZE 24
+#define ATLAS_V2_SECTION_ALIGNMENT 16
+#define ATLAS_V2_NO_NAME 0xffffffff
+/* name, source rect, atlas position, uvs, id, bSet */
+#define ATLAS_V2_SPRITE_RECORD_SIZE (4 + 6 * 4 + 4 * 4 + 4 + 4)
+/* name, size in points, glyph metrics then glyph sprites for each char */
+#define ATLAS_V2_FONT_RECORD_SIZE (4 + 4 + 256 * sizeof(struct AtlasSpriteFontData) + 256 * ATLAS_V2_SPRITE_RECORD_SIZE)
+/* name, fps, first frame, number of frames */
+#define ATLAS_V2_ANIMATION_RECORD_SIZE 16
+
+enum AtlasV2Section
+{
+	AV2_Strings,
+	AV2_Sprites,
+	AV2_Fonts,
+	AV2_Animations,
+	/* i32 sprite handles, the frames of each animation one after the other */
+	AV2_AnimationFrames,
+	/* APE_Raw pixels, RGBA, width * height * 4 bytes */
+	AV2_Pixels,
+	/* APE_QOI pixels, a Qoi_Encode stream */
+	AV2_PixelsQOI,
+	/* APE_Palette colours, RGBA, numRecords of them */
+	AV2_Palette,
+	/* APE_Palette pixels, an LZ4 block of a byte per pixel indexing AV2_Palette */
+	AV2_PixelsIndexed,
+	/* fonts whose glyphs are rasterised when they're used - name, font file path, size in points */
+	AV2_DynamicFonts,
+	/* the region of the texture dynamic fonts glyphs go in - x, y, width, height */
+	AV2_GlyphCache,
+	AV2_NumSectionTypes
+};
+
+/* the sections every file has */
+#define ATLAS_V2_NUM_COMMON_SECTIONS AV2_Pixels
+/* common sections, one or two for the pixels, then the dynamic fonts and glyph cache if there are any */
+#define ATLAS_V2_MAX_SECTIONS (ATLAS_V2_NUM_COMMON_SECTIONS + 4)
+#define ATLAS_V2_DYNAMIC_FONT_RECORD_SIZE 12
+#define ATLAS_V2_GLYPH_CACHE_RECORD_SIZE 16
+#define ATLAS_PALETTE_HASH_BITS 9
+#define ATLAS_PALETTE_HASH_SIZE (1 << ATLAS_PALETTE_HASH_BITS)
+
+struct AtlasV2SectionEntry
+{
+	u32 type;
+	u32 numRecords;
+	u64 offset;
+	u64 size;
+};
+
+static u64 AlignV2Offset(u64 offset)
 {
-	return gAtlases[hAtlas].fonts[hFont].sprites[(u8)c].heightPx;
+	return (offset + ATLAS_V2_SECTION_ALIGNMENT - 1) & ~(u64)(ATLAS_V2_SECTION_ALIGNMENT - 1);
 }
 
-
-float Fo_StringWidth(hAtlas hAtlas, HFont hFont, const char* stringVal)
+/* every name in the atlas in the order SerializeAtlasV2 writes them */
+struct AtlasV2Strings
 {
-	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, 0.0f);
-	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
+	char* pData;
+	u32 size;
+	u32 capacity;
+	u32* pOffsets;
+	int numOffsets;
+	int offsetsCapacity;
+	int onOffset;
+};
 
-	float width = 0.0f;
-	size_t stringLen = strlen(stringVal);
-	struct AtlasFont* pFont = &gAtlases[hAtlas].fonts[hFont];
-	for (int i = 0; i < stringLen; i++)
+static void AddV2String(struct AtlasV2Strings* pStrings, const char* str)
+{
+	if (pStrings->numOffsets == pStrings->offsetsCapacity)
 	{
-		u8 c = (u8)stringVal[i];
-		if (!IsCharLoaded(pFont, c))
-		{
-			continue;
-		}
-		width += pFont->spriteData[c].advance[0]; // x advance
+		pStrings->offsetsCapacity = pStrings->offsetsCapacity ? pStrings->offsetsCapacity * 2 : 256;
+		pStrings->pOffsets = realloc(pStrings->pOffsets, pStrings->offsetsCapacity * sizeof(u32));
+	}
+	if (!str)
+	{
+		pStrings->pOffsets[pStrings->numOffsets++] = ATLAS_V2_NO_NAME;
+		return;
+	}
+	u32 len = strlen(str) + 1;
+	while (pStrings->size + len > pStrings->capacity)
+	{
+		pStrings->capacity = pStrings->capacity ? pStrings->capacity * 2 : 1024;
+		pStrings->pData = realloc(pStrings->pData, pStrings->capacity);
 	}
-	return width;
+	memcpy(pStrings->pData + pStrings->size, str, len);
+	pStrings->pOffsets[pStrings->numOffsets++] = pStrings->size;
+	pStrings->size += len;
 }
 
-float Fo_StringHeight(hAtlas hAtlas, HFont hFont, const char* stringVal)
+static u32 NextV2StringOffset(struct AtlasV2Strings* pStrings)
 {
-	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, 0.0f);
-	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
+	EASSERT(pStrings->onOffset < pStrings->numOffsets);
+	return pStrings->pOffsets[pStrings->onOffset++];
+}
 
-	float minBelowBaseline = 0.0f;
-	float maxAboveBaseline = 0.0f;
-	size_t stringLen = strlen(stringVal);
-	struct AtlasFont* pFont = &gAtlases[hAtlas].fonts[hFont];
-	for (int i = 0; i < stringLen; i++)
-	{
-		u8 c = (u8)stringVal[i];
-		if (!IsCharLoaded(pFont, c))
+static void SerializeAtlasSpriteV2(const AtlasSprite* pSprite, u32 nameOffset, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU32(nameOffset, pSerializer);
+	BS_SerializeI32(pSprite->srcImageTopLeftXPx, pSerializer);
+	BS_SerializeI32(pSprite->srcImageTopLeftYPx, pSerializer);
+	BS_SerializeI32(pSprite->widthPx, pSerializer);
+	BS_SerializeI32(pSprite->heightPx, pSerializer);
+	BS_SerializeI32(pSprite->atlasTopLeftXPx, pSerializer);
+	BS_SerializeI32(pSprite->atlasTopLeftYPx, pSerializer);
+	BS_SerializeFloat(pSprite->topLeftUV_U, pSerializer);
+	BS_SerializeFloat(pSprite->topLeftUV_V, pSerializer);
+	BS_SerializeFloat(pSprite->bottomRightUV_U, pSerializer);
+	BS_SerializeFloat(pSprite->bottomRightUV_V, pSerializer);
+	BS_SerializeI32(pSprite->id, pSerializer);
+	BS_SerializeU32(pSprite->bSet ? 1 : 0, pSerializer);
+}
+
+/*
+	Index every pixel into a palette of at most ATLAS_MAX_PALETTE_COLOURS colours.
+	Returns false if the pixels have more colours than that
+*/
+static bool BuildAtlasPalette(const u8* rgba, size_t numPixels, u8* pOutPalette, u32* pOutNumColours, u8* pOutIndices)
+{
+	/* open addressing, at most half full */
+	u32 keys[ATLAS_PALETTE_HASH_SIZE];
+	i16 indices[ATLAS_PALETTE_HASH_SIZE];
+	memset(indices, 0xff, sizeof(indices));
+	u32 numColours = 0;
+	u32 prevColour = 0;
+	u8 prevIndex = 0;
+	bool bHavePrev = false;
+	for (size_t i = 0; i < numPixels; i++)
+	{
+		u32 colour;
+		memcpy(&colour, rgba + i * CHANNELS_PER_PIXEL, sizeof(u32));
+		/* atlases are mostly long runs of the same colour */
+		if (bHavePrev && colour == prevColour)
 		{
+			pOutIndices[i] = prevIndex;
 			continue;
 		}
-		struct AtlasSpriteFontData* pData = &pFont->spriteData[c];
-		AtlasSprite* pSprite = &pFont->sprites[c];
-
-		if (pData->bearing[1] > maxAboveBaseline)
+		u32 slot = (colour * 2654435761u) >> (32 - ATLAS_PALETTE_HASH_BITS);
+		while (indices[slot] >= 0 && keys[slot] != colour)
 		{
-			maxAboveBaseline = pData->bearing[1];
+			slot = (slot + 1) % ATLAS_PALETTE_HASH_SIZE;
 		}
-
-		
-		float height = (float)pSprite->heightPx;
-		float belowBaseline = pData->bearing[1] - height;
-		if (belowBaseline < minBelowBaseline)
+		if (indices[slot] < 0)
 		{
-			minBelowBaseline = belowBaseline;
+			if (numColours == ATLAS_MAX_PALETTE_COLOURS)
+			{
+				return false;
+			}
+			keys[slot] = colour;
+			indices[slot] = (i16)numColours;
+			memcpy(pOutPalette + numColours * CHANNELS_PER_PIXEL, &colour, sizeof(u32));
+			numColours++;
 		}
+		prevColour = colour;
+		prevIndex = (u8)indices[slot];
+		bHavePrev = true;
+		pOutIndices[i] = prevIndex;
 	}
+	*pOutNumColours = numColours;
+	return true;
+}
 
-	float r = maxAboveBaseline - minBelowBaseline;
-	return r;
+/* the pixel sections for an encoding, the data the sections point to is malloc'd unless it's APE_Raw */
+struct AtlasV2PixelSections
+{
+	int numSections;
+	struct AtlasV2SectionEntry sections[2];
+	u8* pData[2];
+};
+
+static void EncodeAtlasV2Pixels(Atlas* pAtlas, enum AtlasPixelEncoding encoding, struct AtlasV2PixelSections* pOut)
+{
+	memset(pOut, 0, sizeof(struct AtlasV2PixelSections));
+	u8* pRGBA = GetAtlasBytes(pAtlas);
+	size_t numPixels = (size_t)pAtlas->atlasWidth * pAtlas->atlasHeight;
+	if (encoding == APE_Palette)
+	{
+		u8* pPalette = malloc(ATLAS_MAX_PALETTE_COLOURS * CHANNELS_PER_PIXEL);
+		u8* pIndices = malloc(numPixels);
+		u32 numColours = 0;
+		if (BuildAtlasPalette(pRGBA, numPixels, pPalette, &numColours, pIndices))
+		{
+			u8* pCompressed = malloc(Lz_CompressBound(numPixels));
+			size_t compressedSize = Lz_CompressBlock(pIndices, numPixels, pCompressed, Lz_CompressBound(numPixels));
+			free(pIndices);
+			pOut->numSections = 2;
+			pOut->sections[0] = (struct AtlasV2SectionEntry){ AV2_Palette, numColours, 0, (u64)numColours * CHANNELS_PER_PIXEL };
+			pOut->pData[0] = pPalette;
+			pOut->sections[1] = (struct AtlasV2SectionEntry){ AV2_PixelsIndexed, 0, 0, compressedSize };
+			pOut->pData[1] = pCompressed;
+			return;
+		}
+		printf("atlas has more than %i colours, saving it QOI compressed instead of with a palette\n", ATLAS_MAX_PALETTE_COLOURS);
+		free(pPalette);
+		free(pIndices);
+		encoding = APE_QOI;
+	}
+	if (encoding == APE_QOI)
+	{
+		u8* pEncoded = malloc(Qoi_EncodeBound(numPixels));
+		size_t encodedSize = Qoi_Encode(pRGBA, numPixels, pEncoded, Qoi_EncodeBound(numPixels));
+		pOut->numSections = 1;
+		pOut->sections[0] = (struct AtlasV2SectionEntry){ AV2_PixelsQOI, 0, 0, encodedSize };
+		pOut->pData[0] = pEncoded;
+		return;
+	}
+	pOut->numSections = 1;
+	pOut->sections[0] = (struct AtlasV2SectionEntry){ AV2_Pixels, 0, 0, (u64)numPixels * CHANNELS_PER_PIXEL };
+	pOut->pData[0] = pRGBA;
 }
 
-AtlasSprite* Fo_GetCharSprite(hAtlas hAtlas, HFont hFont, char c)
+static void SerializeAtlasV2(Atlas* pAtlas, enum AtlasPixelEncoding encoding, struct BinarySerializer* pSerializer)
 {
-	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, NULL);
-	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
+	int numSprites = VectorSize(pAtlas->sprites);
+	/* dynamic fonts don't have glyph sprites to store, they go in their own section */
+	int numFonts = 0;
+	int numDynamicFonts = 0;
+	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
+	{
+		if (pAtlas->fonts[i].pDynamic)
+		{
+			numDynamicFonts++;
+		}
+		else
+		{
+			numFonts++;
+		}
+	}
+
+	struct AtlasV2Strings strings;
+	memset(&strings, 0, sizeof(struct AtlasV2Strings));
+	for (int i = 0; i < numSprites; i++)
+	{
+		AddV2String(&strings, pAtlas->sprites[i].name);
+	}
+	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
+	{
+		if (pAtlas->fonts[i].pDynamic)
+		{
+			continue;
+		}
+		AddV2String(&strings, pAtlas->fonts[i].name);
+		for (int j = 0; j < 256; j++)
+		{
+			AddV2String(&strings, pAtlas->fonts[i].sprites[j].name);
+		}
+	}
+	u32 numFrames = 0;
+	struct HashmapKeyIterator itr = GetKeyIterator(&pAtlas->animations);
+	char* key = NextHashmapKey(&itr);
+	while (key)
+	{
+		AddV2String(&strings, key);
+		struct AtlasAnimation* pAnim = HashmapSearch(&pAtlas->animations, key);
+		numFrames += VectorSize(pAnim->frames);
+		key = NextHashmapKey(&itr);
+	}
+	for (int i = 0; i < VectorSize(pAtlas->fonts); i++)
+	{
+		if (pAtlas->fonts[i].pDynamic)
+		{
+			AddV2String(&strings, pAtlas->fonts[i].name);
+			AddV2String(&strings, pAtlas->fonts[i].pDynamic->path);
+		}
+	}
+
+	struct AtlasV2PixelSections pixels;
+	EncodeAtlasV2Pixels(pAtlas, encoding, &pixels);
+
+	struct AtlasV2SectionEntry sections[ATLAS_V2_MAX_SECTIONS] = {
+		{ AV2_Strings,         0,                       0, strings.size },
+		{ AV2_Sprites,         numSprites,              0, (u64)numSprites * ATLAS_V2_SPRITE_RECORD_SIZE },
+		{ AV2_Fonts,           numFonts,                0, (u64)numFonts * ATLAS_V2_FONT_RECORD_SIZE },
+		{ AV2_Animations,      pAtlas->animations.size, 0, (u64)pAtlas->animations.size * ATLAS_V2_ANIMATION_RECORD_SIZE },
+		{ AV2_AnimationFrames, numFrames,               0, (u64)numFrames * sizeof(i32) },
+	};
+	int numSections = ATLAS_V2_NUM_COMMON_SECTIONS;
+	for (int i = 0; i < pixels.numSections; i++)
+	{
+		sections[numSections++] = pixels.sections[i];
+	}
+	/* only written when there are dynamic fonts, so atlases without them are saved the same as before */
+	if (numDynamicFonts)
+	{
+		struct AtlasV2SectionEntry dynamicFonts = { AV2_DynamicFonts, numDynamicFonts, 0, (u64)numDynamicFonts * ATLAS_V2_DYNAMIC_FONT_RECORD_SIZE };
+		sections[numSections++] = dynamicFonts;
+	}
+	if (pAtlas->bHasGlyphCache)
+	{
+		struct AtlasV2SectionEntry glyphCache = { AV2_GlyphCache, 1, 0, ATLAS_V2_GLYPH_CACHE_RECORD_SIZE };
+		sections[numSections++] = glyphCache;
+	}
+	u64 offset = ATLAS_V2_HEADER_SIZE + numSections * ATLAS_V2_SECTION_ENTRY_SIZE;
+	for (int i = 0; i < numSections; i++)
+	{
+		sections[i].offset = AlignV2Offset(offset);
+		offset = sections[i].offset + sections[i].size;
+	}
+
+	BS_SerializeU32(2, pSerializer);
+	BS_SerializeU32(numSections, pSerializer);
+	BS_SerializeI32(pAtlas->atlasHeight, pSerializer);
+	BS_SerializeI32(pAtlas->atlasWidth, pSerializer);
+	BS_SerializeI32(pAtlas->tilesetIndexBegin, pSerializer);
+	BS_SerializeI32(pAtlas->tilesetIndexEnd, pSerializer);
+	BS_SerializeU64(0, pSerializer);
+	for (int i = 0; i < numSections; i++)
+	{
+		BS_SerializeU32(sections[i].type, pSerializer);
+		BS_SerializeU32(sections[i].numRecords, pSerializer);
+		BS_SerializeU64(sections[i].offset, pSerializer);
+		BS_SerializeU64(sections[i].size, pSerializer);
+	}
 
-	return &gAtlases[hAtlas].fonts[hFont].sprites[(u8)c];
+	u64 written = ATLAS_V2_HEADER_SIZE + numSections * ATLAS_V2_SECTION_ENTRY_SIZE;
+	for (int i = 0; i < numSections; i++)
+	{
+		for (; written < sections[i].offset; written++)
+		{
+			BS_SerializeU8(0, pSerializer);
+		}
+		switch (sections[i].type)
+		{
+		case AV2_Strings:
+			BS_SerializeU8Array((const u8*)strings.pData, strings.size, pSerializer);
+			break;
+		case AV2_Sprites:
+			for (int j = 0; j < numSprites; j++)
+			{
+				SerializeAtlasSpriteV2(&pAtlas->sprites[j], NextV2StringOffset(&strings), pSerializer);
+			}
+			break;
+		case AV2_Fonts:
+			for (int j = 0; j < VectorSize(pAtlas->fonts); j++)
+			{
+				struct AtlasFont* pFont = &pAtlas->fonts[j];
+				if (pFont->pDynamic)
+				{
+					continue;
+				}
+				BS_SerializeU32(NextV2StringOffset(&strings), pSerializer);
+				BS_SerializeFloat(pFont->fSizePts, pSerializer);
+				BS_SerializeF32Array((const float*)pFont->spriteData, sizeof(struct AtlasSpriteFontData) * 256 / sizeof(float), pSerializer);
+				for (int k = 0; k < 256; k++)
+				{
+					SerializeAtlasSpriteV2(&pFont->sprites[k], NextV2StringOffset(&strings), pSerializer);
+				}
+			}
+			break;
+		case AV2_Animations:
+			{
+				u32 firstFrame = 0;
+				itr = GetKeyIterator(&pAtlas->animations);
+				key = NextHashmapKey(&itr);
+				while (key)
+				{
+					struct AtlasAnimation* pAnim = HashmapSearch(&pAtlas->animations, key);
+					BS_SerializeU32(NextV2StringOffset(&strings), pSerializer);
+					BS_SerializeFloat(pAnim->fps, pSerializer);
+					BS_SerializeU32(firstFrame, pSerializer);
+					BS_SerializeU32(VectorSize(pAnim->frames), pSerializer);
+					firstFrame += VectorSize(pAnim->frames);
+					key = NextHashmapKey(&itr);
+				}
+			}
+			break;
+		case AV2_AnimationFrames:
+			itr = GetKeyIterator(&pAtlas->animations);
+			key = NextHashmapKey(&itr);
+			while (key)
+			{
+				struct AtlasAnimation* pAnim = HashmapSearch(&pAtlas->animations, key);
+				BS_SerializeI32Array(pAnim->frames, VectorSize(pAnim->frames), pSerializer);
+				key = NextHashmapKey(&itr);
+			}
+			break;
+		case AV2_DynamicFonts:
+			for (int j = 0; j < VectorSize(pAtlas->fonts); j++)
+			{
+				struct AtlasFont* pFont = &pAtlas->fonts[j];
+				if (!pFont->pDynamic)
+				{
+					continue;
+				}
+				BS_SerializeU32(NextV2StringOffset(&strings), pSerializer);
+				BS_SerializeU32(NextV2StringOffset(&strings), pSerializer);
+				BS_SerializeFloat(pFont->fSizePts, pSerializer);
+			}
+			break;
+		case AV2_GlyphCache:
+			BS_SerializeI32(pAtlas->glyphCache.x, pSerializer);
+			BS_SerializeI32(pAtlas->glyphCache.y, pSerializer);
+			BS_SerializeI32(pAtlas->glyphCache.width, pSerializer);
+			BS_SerializeI32(pAtlas->glyphCache.height, pSerializer);
+			break;
+		default:
+			/* one of the pixel sections */
+			BS_SerializeU8Array(pixels.pData[i - ATLAS_V2_NUM_COMMON_SECTIONS], sections[i].size, pSerializer);
+			break;
+		}
+		written += sections[i].size;
+	}
+	if (pixels.sections[0].type != AV2_Pixels)
+	{
+		for (int i = 0; i < pixels.numSections; i++)
+		{
+			free(pixels.pData[i]);
+		}
+	}
+	free(strings.pData);
+	free(strings.pOffsets);
 }
 
-float Fo_GetMaxYBearing(hAtlas hAtlas, HFont hFont, const char* str)
+/* NULL if the name is missing or isn't terminated inside the strings section */
+static char* DeserializeV2String(const struct AtlasV2SectionEntry* pStringsSection, const u8* pFile, u32 nameOffset)
+{
+	if (nameOffset == ATLAS_V2_NO_NAME || nameOffset >= pStringsSection->size)
+	{
+		return NULL;
+	}
+	const char* str = (const char*)pFile + pStringsSection->offset + nameOffset;
+	const char* pEnd = memchr(str, '\0', pStringsSection->size - nameOffset);
+	if (!pEnd)
+	{
+		return NULL;
+	}
+	char* copy = malloc(pEnd - str + 1);
+	memcpy(copy, str, pEnd - str + 1);
+	return copy;
+}
+
+static void DeserializeAtlasSpriteV2(AtlasSprite* pSprite, const struct AtlasV2SectionEntry* pStringsSection, const u8* pFile, struct BinarySerializer* pSerializer)
+{
+	memset(pSprite, 0, sizeof(AtlasSprite));
+	u32 nameOffset = 0, bSet = 0;
+	BS_DeSerializeU32(&nameOffset, pSerializer);
+	pSprite->name = DeserializeV2String(pStringsSection, pFile, nameOffset);
+	BS_DeSerializeI32(&pSprite->srcImageTopLeftXPx, pSerializer);
+	BS_DeSerializeI32(&pSprite->srcImageTopLeftYPx, pSerializer);
+	BS_DeSerializeI32(&pSprite->widthPx, pSerializer);
+	BS_DeSerializeI32(&pSprite->heightPx, pSerializer);
+	BS_DeSerializeI32(&pSprite->atlasTopLeftXPx, pSerializer);
+	BS_DeSerializeI32(&pSprite->atlasTopLeftYPx, pSerializer);
+	BS_DeSerializeFloat(&pSprite->topLeftUV_U, pSerializer);
+	BS_DeSerializeFloat(&pSprite->topLeftUV_V, pSerializer);
+	BS_DeSerializeFloat(&pSprite->bottomRightUV_U, pSerializer);
+	BS_DeSerializeFloat(&pSprite->bottomRightUV_V, pSerializer);
+	BS_DeSerializeI32(&pSprite->id, pSerializer);
+	BS_DeSerializeU32(&bSet, pSerializer);
+	pSprite->bSet = bSet != 0;
+}
+
+/* a serializer over just one section of the file */
+static void BeginV2Section(const struct AtlasV2SectionEntry* pSection, const u8* pFile, struct BinarySerializer* pOutSerializer)
+{
+	BS_CreateForLoadFromMemory(pFile + pSection->offset, pSection->size, pOutSerializer);
+}
+
+/*
+	pMappedFile is the mapping pFile is from, the atlas takes ownership of it if it loads. Raw pixels are uploaded
+	and kept straight from the mapping, compressed ones decoded into the DrawContext's upload buffer if it has one.
+	If it's NULL the pixels are copied or decoded out of pFile
+*/
+static hAtlas DeserializeAtlasV2(const u8* pFile, size_t fileSize, struct MappedFile* pMappedFile, struct DrawContext* pDC)
+{
+	struct BinarySerializer bs;
+	BS_CreateForLoadFromMemory(pFile, fileSize, &bs);
+	u32 version = 0, numSections = 0;
+	i32 height = 0, width = 0, tilesetBegin = 0, tilesetEnd = 0;
+	BS_DeSerializeU32(&version, &bs);
+	BS_DeSerializeU32(&numSections, &bs);
+	BS_DeSerializeI32(&height, &bs);
+	BS_DeSerializeI32(&width, &bs);
+	BS_DeSerializeI32(&tilesetBegin, &bs);
+	BS_DeSerializeI32(&tilesetEnd, &bs);
+	u64 reserved = 0;
+	BS_DeSerializeU64(&reserved, &bs);
+	EASSERT(version == 2);
+
+	/* find the sections and check they're all inside the file before creating anything */
+	struct AtlasV2SectionEntry sections[AV2_NumSectionTypes];
+	memset(sections, 0, sizeof(sections));
+	bool bFound[AV2_NumSectionTypes] = { false };
+	bool bValid = width > 0 && height > 0 && fileSize >= ATLAS_V2_HEADER_SIZE + (u64)numSections * ATLAS_V2_SECTION_ENTRY_SIZE;
+	for (u32 i = 0; bValid && i < numSections; i++)
+	{
+		struct AtlasV2SectionEntry entry;
+		BS_DeSerializeU32(&entry.type, &bs);
+		BS_DeSerializeU32(&entry.numRecords, &bs);
+		BS_DeSerializeU64(&entry.offset, &bs);
+		BS_DeSerializeU64(&entry.size, &bs);
+		if (entry.offset > fileSize || entry.size > fileSize - entry.offset || entry.offset % ATLAS_V2_SECTION_ALIGNMENT)
+		{
+			bValid = false;
+		}
+		else if (entry.type < AV2_NumSectionTypes)
+		{
+			sections[entry.type] = entry;
+			bFound[entry.type] = true;
+		}
+	}
+	BS_Finish(&bs);
+	for (int i = 0; bValid && i < ATLAS_V2_NUM_COMMON_SECTIONS; i++)
+	{
+		bValid = bFound[i];
+	}
+	bValid = bValid
+		&& sections[AV2_Sprites].size == (u64)sections[AV2_Sprites].numRecords * ATLAS_V2_SPRITE_RECORD_SIZE
+		&& sections[AV2_Fonts].size == (u64)sections[AV2_Fonts].numRecords * ATLAS_V2_FONT_RECORD_SIZE
+		&& sections[AV2_Animations].size == (u64)sections[AV2_Animations].numRecords * ATLAS_V2_ANIMATION_RECORD_SIZE
+		&& sections[AV2_AnimationFrames].size == (u64)sections[AV2_AnimationFrames].numRecords * sizeof(i32);
+
+	size_t numPixels = (size_t)width * height;
+	struct AtlasEncodedPixels encoded;
+	memset(&encoded, 0, sizeof(struct AtlasEncodedPixels));
+	if (bFound[AV2_Pixels])
+	{
+		encoded.encoding = APE_Raw;
+		encoded.pData = pFile + sections[AV2_Pixels].offset;
+		encoded.size = sections[AV2_Pixels].size;
+		bValid = bValid && encoded.size == numPixels * CHANNELS_PER_PIXEL;
+	}
+	else if (bFound[AV2_PixelsQOI])
+	{
+		encoded.encoding = APE_QOI;
+		encoded.pData = pFile + sections[AV2_PixelsQOI].offset;
+		encoded.size = sections[AV2_PixelsQOI].size;
+	}
+	else if (bFound[AV2_Palette] && bFound[AV2_PixelsIndexed])
+	{
+		encoded.encoding = APE_Palette;
+		encoded.pData = pFile + sections[AV2_PixelsIndexed].offset;
+		encoded.size = sections[AV2_PixelsIndexed].size;
+		encoded.pPalette = pFile + sections[AV2_Palette].offset;
+		encoded.numColours = sections[AV2_Palette].numRecords;
+		bValid = bValid
+			&& encoded.numColours <= ATLAS_MAX_PALETTE_COLOURS
+			&& sections[AV2_Palette].size == (u64)encoded.numColours * CHANNELS_PER_PIXEL;
+	}
+	else
+	{
+		bValid = false;
+	}
+	if (!bValid)
+	{
+		printf("malformed version 2 atlas file\n");
+		return NULL_HANDLE;
+	}
+
+	/* the pixels go first so nothing needs undoing if they don't decode */
+	u8* pAtlasBytes = NULL;
+	hTexture texture = NULL_HANDLE;
+	if (encoded.encoding == APE_Raw)
+	{
+		if (pMappedFile)
+		{
+			/* read only, nothing writes to a loaded atlases pixels */
+			pAtlasBytes = (u8*)encoded.pData;
+		}
+		else
+		{
+			pAtlasBytes = malloc(encoded.size);
+			memcpy(pAtlasBytes, encoded.pData, encoded.size);
+		}
+		texture = pDC->UploadTexture(pAtlasBytes, CHANNELS_PER_PIXEL, width, height);
+	}
+	else
+	{
+		/* with the mapping kept there's no need to keep a decoded copy, GetAtlasBytes can decode the pixels again */
+		u8* pUploadBuffer = pMappedFile && pDC->MapTextureUploadBuffer ? pDC->MapTextureUploadBuffer(CHANNELS_PER_PIXEL, width, height) : NULL;
+		if (pUploadBuffer)
+		{
+			bool bDecoded = DecodeAtlasPixels(&encoded, pUploadBuffer, numPixels);
+			texture = pDC->UploadMappedTexture();
+			if (!bDecoded)
+			{
+				pDC->DestroyTexture(texture);
+				printf("malformed version 2 atlas file pixels\n");
+				return NULL_HANDLE;
+			}
+		}
+		else
+		{
+			pAtlasBytes = malloc(numPixels * CHANNELS_PER_PIXEL);
+			if (!DecodeAtlasPixels(&encoded, pAtlasBytes, numPixels))
+			{
+				free(pAtlasBytes);
+				printf("malformed version 2 atlas file pixels\n");
+				return NULL_HANDLE;
+			}
+			texture = pDC->UploadTexture(pAtlasBytes, CHANNELS_PER_PIXEL, width, height);
+		}
+	}
+
+	Atlas* pAtlas = AqcuireAtlas();
+	pAtlas->bActive = true;
+	pAtlas->atlasHeight = height;
+	pAtlas->atlasWidth = width;
+	pAtlas->tilesetIndexBegin = tilesetBegin;
+	pAtlas->tilesetIndexEnd = tilesetEnd;
+	pAtlas->texture = texture;
+	HashmapInit(&pAtlas->animations, 64, sizeof(struct AtlasAnimation));
+	HashmapInit(&pAtlas->fontIndex, 16, sizeof(HFont));
+	pAtlas->numIndexedFonts = 0;
+	InitGlyphCacheFields(pAtlas);
+	const struct AtlasV2SectionEntry* pStrings = &sections[AV2_Strings];
+
+	u32 numSprites = sections[AV2_Sprites].numRecords;
+	pAtlas->sprites = NEW_VECTOR(AtlasSprite);
+	pAtlas->sprites = VectorResize(pAtlas->sprites, numSprites);
+	BeginV2Section(&sections[AV2_Sprites], pFile, &bs);
+	for (u32 i = 0; i < numSprites; i++)
+	{
+		AtlasSprite sprite;
+		DeserializeAtlasSpriteV2(&sprite, pStrings, pFile, &bs);
+		pAtlas->sprites = VectorPush(pAtlas->sprites, &sprite);
+	}
+	BS_Finish(&bs);
+
+	u32 numFonts = sections[AV2_Fonts].numRecords;
+	pAtlas->fonts = NEW_VECTOR(struct AtlasFont);
+	pAtlas->fonts = VectorResize(pAtlas->fonts, numFonts);
+	BeginV2Section(&sections[AV2_Fonts], pFile, &bs);
+	for (u32 i = 0; i < numFonts; i++)
+	{
+		static struct AtlasFont font;
+		memset(&font, 0, sizeof(struct AtlasFont));
+		u32 nameOffset = 0;
+		BS_DeSerializeU32(&nameOffset, &bs);
+		char* name = DeserializeV2String(pStrings, pFile, nameOffset);
+		if (name)
+		{
+			strncpy(font.name, name, MAX_FONT_NAME_SIZE - 1);
+			free(name);
+		}
+		BS_DeSerializeFloat(&font.fSizePts, &bs);
+		BS_DeSerializeF32Array((float*)font.spriteData, sizeof(struct AtlasSpriteFontData) * 256 / sizeof(float), &bs);
+		for (int j = 0; j < 256; j++)
+		{
+			DeserializeAtlasSpriteV2(&font.sprites[j], pStrings, pFile, &bs);
+		}
+		ComputeFontMetrics(&font);
+		pAtlas->fonts = VectorPush(pAtlas->fonts, &font);
+	}
+	BS_Finish(&bs);
+
+	if (bFound[AV2_DynamicFonts])
+	{
+		/* consecutive sizes of the same font share a face, as At_AddFont made them */
+		SHARED_PTR(FT_Face) face = NULL;
+		char* facePath = NULL;
+		BeginV2Section(&sections[AV2_DynamicFonts], pFile, &bs);
+		for (u32 i = 0; i < sections[AV2_DynamicFonts].numRecords; i++)
+		{
+			u32 nameOffset = 0, pathOffset = 0;
+			float sizePts = 0.0f;
+			BS_DeSerializeU32(&nameOffset, &bs);
+			BS_DeSerializeU32(&pathOffset, &bs);
+			BS_DeSerializeFloat(&sizePts, &bs);
+			char* name = DeserializeV2String(pStrings, pFile, nameOffset);
+			char* path = DeserializeV2String(pStrings, pFile, pathOffset);
+			if (name && path && (!facePath || strcmp(path, facePath) != 0))
+			{
+				if (face)
+				{
+					Sptr_RemoveRef(face);
+				}
+				free(facePath);
+				facePath = path;
+				path = NULL;
+				face = NULL;
+				FT_Face ftFace;
+				if (OpenFontFace(gFTLib, facePath, &ftFace))
+				{
+					face = SHARED_PTR_NEW(FT_Face, &FaceDtor);
+					*face = ftFace;
+				}
+			}
+			if (!name || !face || PushDynamicFont(pAtlas, face, name, facePath, sizePts) == NULL_HANDLE)
+			{
+				printf("skipping dynamic font %i\n", i);
+			}
+			free(name);
+			free(path);
+		}
+		BS_Finish(&bs);
+		if (face)
+		{
+			Sptr_RemoveRef(face);
+		}
+		free(facePath);
+	}
+	if (bFound[AV2_GlyphCache] && sections[AV2_GlyphCache].size == ATLAS_V2_GLYPH_CACHE_RECORD_SIZE)
+	{
+		i32 x = 0, y = 0, w = 0, h = 0;
+		BeginV2Section(&sections[AV2_GlyphCache], pFile, &bs);
+		BS_DeSerializeI32(&x, &bs);
+		BS_DeSerializeI32(&y, &bs);
+		BS_DeSerializeI32(&w, &bs);
+		BS_DeSerializeI32(&h, &bs);
+		BS_Finish(&bs);
+		if (x >= 0 && y >= 0 && w > 0 && h > 0 && x + w <= width && y + h <= height)
+		{
+			InitGlyphCache(gCurrentAtlasIndex, x, y, w, h);
+		}
+	}
+
+	const struct AtlasV2SectionEntry* pFrames = &sections[AV2_AnimationFrames];
+	BeginV2Section(&sections[AV2_Animations], pFile, &bs);
+	for (u32 i = 0; i < sections[AV2_Animations].numRecords; i++)
+	{
+		u32 nameOffset = 0, firstFrame = 0, numFrames = 0;
+		struct AtlasAnimation anim;
+		BS_DeSerializeU32(&nameOffset, &bs);
+		BS_DeSerializeFloat(&anim.fps, &bs);
+		BS_DeSerializeU32(&firstFrame, &bs);
+		BS_DeSerializeU32(&numFrames, &bs);
+		char* name = DeserializeV2String(pStrings, pFile, nameOffset);
+		if (!name || firstFrame > pFrames->numRecords || numFrames > pFrames->numRecords - firstFrame)
+		{
+			printf("skipping malformed atlas animation %i\n", i);
+			free(name);
+			continue;
+		}
+		anim.frames = NEW_VECTOR(hSprite);
+		anim.frames = VectorResize(anim.frames, numFrames);
+		anim.frames = VectorClear(anim.frames);
+		struct BinarySerializer framesBS;
+		BS_CreateForLoadFromMemory(pFile + pFrames->offset + firstFrame * sizeof(i32), numFrames * sizeof(i32), &framesBS);
+		for (u32 j = 0; j < numFrames; j++)
+		{
+			hSprite frame;
+			BS_DeSerializeI32(&frame, &framesBS);
+			anim.frames = VectorPush(anim.frames, &frame);
+		}
+		BS_Finish(&framesBS);
+		HashmapInsert(&pAtlas->animations, name, &anim);
+		free(name);
+	}
+	BS_Finish(&bs);
+
+	pAtlas->atlasBytes = pAtlasBytes;
+	if (pMappedFile && (encoded.encoding == APE_Raw || !pAtlasBytes))
+	{
+		pAtlas->pMappedFile = pMappedFile;
+		pAtlas->encodedPixels = encoded;
+	}
+	else
+	{
+		pAtlas->pMappedFile = NULL;
+		memset(&pAtlas->encodedPixels, 0, sizeof(struct AtlasEncodedPixels));
+		if (pMappedFile)
+		{
+			/* everything's been copied out of it */
+			MappedFile_Close(pMappedFile);
+		}
+	}
+	return gCurrentAtlasIndex;
+}
+
+void At_SaveAtlasWithVersion(struct BinarySerializer* pSerializer, hAtlas atlas, u32 version)
+{
+	struct AtlasSaveOptions options;
+	options.fileVersion = version;
+	options.pixelEncoding = APE_Raw;
+	At_SaveAtlasEx(pSerializer, atlas, &options);
+}
+
+void At_SaveAtlasEx(struct BinarySerializer* pSerializer, hAtlas atlas, const struct AtlasSaveOptions* pOptions)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK_NO_RETURN(atlas);
+	EASSERT(pSerializer->bSaving);
+	switch (pOptions->fileVersion)
+	{
+	case 1:
+		if (pOptions->pixelEncoding != APE_Raw)
+		{
+			printf("version 1 atlas files can't be compressed, saving raw pixels\n");
+		}
+		SerializeAtlasV1(&gAtlases[atlas], pSerializer);
+		break;
+	case 2:
+		SerializeAtlasV2(&gAtlases[atlas], pOptions->pixelEncoding, pSerializer);
+		break;
+	default:
+		printf("can't save atlas file version %u\n", pOptions->fileVersion);
+		break;
+	}
+}
+
+void At_SerializeAtlas(struct BinarySerializer* pSerializer, hAtlas* atlas, struct DrawContext* pDC)
+{
+	if (pSerializer->bSaving)
+	{
+		At_SaveAtlasWithVersion(pSerializer, *atlas, ATLAS_FILE_VERSION_LATEST);
+	}
+	else
+	{
+		const char* pStart = pSerializer->pReadPtr;
+		u32 version = 0;
+		BS_DeSerializeU32(&version, pSerializer);
+		switch (version)
+		{
+		case 1:
+			*atlas = DeserializeAtlasV1(pSerializer, pDC);
+			break;
+		case 2:
+			/* offsets are from the start of the file, which is where the version was */
+			*atlas = DeserializeAtlasV2((const u8*)pStart, pSerializer->dataSize - (pStart - pSerializer->pData), NULL, pDC);
+			pSerializer->pReadPtr = pSerializer->pData + pSerializer->dataSize;
+			break;
+		default:
+			printf("Unknown atlas binary file version number %ui\n", version);
+		}
+	}
+}
+
+hAtlas At_LoadAtlasFile(const char* path, struct DrawContext* pDC)
+{
+	struct MappedFile* pFile = MappedFile_Open(path);
+	if (!pFile)
+	{
+		printf("can't open atlas file %s\n", path);
+		return NULL_HANDLE;
+	}
+	const u8* pData = MappedFile_GetData(pFile);
+	size_t size = MappedFile_GetSize(pFile);
+	hAtlas atlas = NULL_HANDLE;
+	if (size >= sizeof(u32) && (pData[0] | (pData[1] << 8) | (pData[2] << 16) | ((u32)pData[3] << 24)) == 2)
+	{
+		atlas = DeserializeAtlasV2(pData, size, pFile, pDC);
+		if (atlas == NULL_HANDLE)
+		{
+			MappedFile_Close(pFile);
+		}
+		return atlas;
+	}
+
+	/* older versions copy everything out of the file */
+	struct BinarySerializer bs;
+	BS_CreateForLoadFromMemory(pData, size, &bs);
+	At_SerializeAtlas(&bs, &atlas, pDC);
+	BS_Finish(&bs);
+	MappedFile_Close(pFile);
+	return atlas;
+}
+
+/* an empty glyph to draw for a dynamic fonts glyph that won't fit in the glyph cache this frame */
+static AtlasSprite gNonResidentGlyphSprite;
+
+/* find room for a rasterised glyph in the glyph cache and queue its pixels to be uploaded */
+static void PlaceDynamicGlyph(hAtlas hAtlas, HFont hFont, i32 index, const struct AtlasGlyph* pRasterised)
+{
+	Atlas* pAtlas = &gAtlases[hAtlas];
+	/* borders on every side, so a neighbour evicted and replaced later can't bleed in */
+	int w = pRasterised->widthPx + 2 * ATLAS_SPRITE_BORDER_PXLS;
+	int h = pRasterised->heightPx + 2 * ATLAS_SPRITE_BORDER_PXLS;
+	int x = 0, y = 0;
+	u64 key = ((u64)hFont << 32) | (u32)index;
+	int shelf = GSP_Alloc(&pAtlas->glyphCache, w, h, pAtlas->glyphCacheFrame, key, &x, &y);
+	if (shelf == GLYPH_SHELF_NONE)
+	{
+		/* everything in the cache was used this frame, it may fit next frame */
+		pAtlas->bGlyphCacheMissed = true;
+		return;
+	}
+	struct DynamicGlyph* pGlyph = &pAtlas->fonts[hFont].pDynamic->glyphs[index];
+	pGlyph->shelf = shelf;
+	pGlyph->sprite.atlasTopLeftXPx = x + ATLAS_SPRITE_BORDER_PXLS;
+	pGlyph->sprite.atlasTopLeftYPx = y + ATLAS_SPRITE_BORDER_PXLS;
+	CalculateSpriteUVs(&pGlyph->sprite, pAtlas->atlasWidth, pAtlas->atlasHeight);
+
+	struct PendingGlyphUpload upload = { x, y, w, h, NULL };
+	size_t rowBytes = (size_t)w * CHANNELS_PER_PIXEL;
+	upload.pixels = malloc(rowBytes * h);
+	memset(upload.pixels, 0, rowBytes * h);
+	size_t glyphRowBytes = (size_t)pRasterised->widthPx * CHANNELS_PER_PIXEL;
+	for (int row = 0; row < pRasterised->heightPx; row++)
+	{
+		memcpy(upload.pixels + (row + ATLAS_SPRITE_BORDER_PXLS) * rowBytes + ATLAS_SPRITE_BORDER_PXLS * CHANNELS_PER_PIXEL,
+			pRasterised->pixels + row * glyphRowBytes, glyphRowBytes);
+	}
+	pAtlas->pendingGlyphUploads = VectorPush(pAtlas->pendingGlyphUploads, &upload);
+}
+
+/*
+	A dynamic fonts glyph, rasterising it the first time it's asked for.
+	With bResident it's put in the glyph cache too if it isn't already, and marked used this frame
+*/
+static struct DynamicGlyph* GetDynamicGlyph(hAtlas hAtlas, HFont hFont, u32 codepoint, bool bResident)
+{
+	Atlas* pAtlas = &gAtlases[hAtlas];
+	struct AtlasFont* pFont = &pAtlas->fonts[hFont];
+	struct DynamicFont* pDynamic = pFont->pDynamic;
+	struct AtlasGlyph rasterised;
+	bool bRasterised = false;
+	i32 index = FindDynamicGlyph(pDynamic, codepoint);
+	if (index == DYNAMIC_GLYPH_NONE)
+	{
+		struct DynamicGlyph glyph;
+		memset(&glyph, 0, sizeof(struct DynamicGlyph));
+		glyph.shelf = GLYPH_SHELF_NONE;
+		FT_Activate_Size(pDynamic->ftSize);
+		bRasterised = RasteriseGlyph(*pFont->pFTFace, codepoint, &rasterised);
+		if (bRasterised)
+		{
+			glyph.sprite.atlas = hAtlas;
+			glyph.sprite.widthPx = rasterised.widthPx;
+			glyph.sprite.heightPx = rasterised.heightPx;
+			glyph.sprite.bSet = true;
+			glyph.sprite.id = gSpriteId++;
+			glm_vec2_copy(rasterised.bearing, glyph.data.bearing);
+			glm_vec2_copy(rasterised.advance, glyph.data.advance);
+			pAtlas->glyphsRasterised++;
+		}
+		pDynamic->glyphs = VectorPush(pDynamic->glyphs, &glyph);
+		index = VectorSize(pDynamic->glyphs) - 1;
+		AddDynamicGlyphIndex(pDynamic, codepoint, index);
+	}
+
+	struct DynamicGlyph* pGlyph = &pDynamic->glyphs[index];
+	bool bHasPixels = pGlyph->sprite.bSet && pGlyph->sprite.widthPx > 0 && pGlyph->sprite.heightPx > 0;
+	if (bResident && bHasPixels && pAtlas->bHasGlyphCache)
+	{
+		if (pGlyph->shelf != GLYPH_SHELF_NONE)
+		{
+			GSP_Touch(&pAtlas->glyphCache, pGlyph->shelf, pAtlas->glyphCacheFrame);
+		}
+		else
+		{
+			if (!bRasterised)
+			{
+				/* evicted, its metrics are kept but the pixels have to be made again */
+				FT_Activate_Size(pDynamic->ftSize);
+				bRasterised = RasteriseGlyph(*pFont->pFTFace, codepoint, &rasterised);
+				pAtlas->glyphsRasterised++;
+			}
+			if (bRasterised)
+			{
+				PlaceDynamicGlyph(hAtlas, hFont, index, &rasterised);
+			}
+		}
+	}
+	if (bRasterised)
+	{
+		free(rasterised.pixels);
+	}
+	return pGlyph;
+}
+
+/*
+	A glyph's sprite and metrics for either kind of font, the pointers are set even if it returns false.
+	With bResident a dynamic fonts glyph is put in the glyph cache, see GetDynamicGlyph
+*/
+static bool GetGlyph(hAtlas hAtlas, HFont hFont, u32 codepoint, bool bResident, AtlasSprite** ppOutSprite, struct AtlasSpriteFontData** ppOutData)
+{
+	static AtlasSprite emptySprite;
+	static struct AtlasSpriteFontData emptyData;
+	struct AtlasFont* pFont = &gAtlases[hAtlas].fonts[hFont];
+	if (pFont->pDynamic)
+	{
+		struct DynamicGlyph* pGlyph = GetDynamicGlyph(hAtlas, hFont, codepoint, bResident);
+		*ppOutSprite = &pGlyph->sprite;
+		*ppOutData = &pGlyph->data;
+		return pGlyph->sprite.bSet;
+	}
+	if (codepoint >= 256)
+	{
+		*ppOutSprite = &emptySprite;
+		*ppOutData = &emptyData;
+		return false;
+	}
+	*ppOutSprite = &pFont->sprites[codepoint];
+	*ppOutData = &pFont->spriteData[codepoint];
+	return pFont->sprites[codepoint].bSet;
+}
+
+/* fonts can be added after the last lookup, while an atlas is being built */
+static void IndexNewFonts(Atlas* pAtlas)
+{
+	for (int i = pAtlas->numIndexedFonts; i < VectorSize(pAtlas->fonts); i++)
+	{
+		struct AtlasFont* pFont = &pAtlas->fonts[i];
+		pFont->nextWithSameName = NULL_HANDLE;
+		HFont* pFirst = HashmapSearch(&pAtlas->fontIndex, pFont->name);
+		if (!pFirst)
+		{
+			HFont hFont = i;
+			HashmapInsert(&pAtlas->fontIndex, pFont->name, &hFont);
+			continue;
+		}
+		HFont hLast = *pFirst;
+		while (pAtlas->fonts[hLast].nextWithSameName != NULL_HANDLE)
+		{
+			hLast = pAtlas->fonts[hLast].nextWithSameName;
+		}
+		pAtlas->fonts[hLast].nextWithSameName = i;
+	}
+	pAtlas->numIndexedFonts = VectorSize(pAtlas->fonts);
+}
+
+HFont Fo_FindFont(hAtlas hAtlas, const char* fontName, float sizePts)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, NULL_HANDLE);
+	Atlas* pAtlas = &gAtlases[hAtlas];
+	if (pAtlas->numIndexedFonts != VectorSize(pAtlas->fonts))
+	{
+		IndexNewFonts(pAtlas);
+	}
+	HFont matchingName = NULL_HANDLE; // if one with a matching name but not matching size is found then return that
+
+	HFont* pFirst = HashmapSearch(&pAtlas->fontIndex, fontName);
+	for (HFont i = pFirst ? *pFirst : NULL_HANDLE; i != NULL_HANDLE; i = pAtlas->fonts[i].nextWithSameName)
+	{
+		matchingName = i;
+		if (CompareFloat(pAtlas->fonts[i].fSizePts, sizePts))
+		{
+			return i;
+		}
+	}
+
+	return matchingName;
+}
+
+float Fo_CharWidth(hAtlas hAtlas, HFont hFont, char c)
+{
+	AtlasSprite* pSprite = NULL;
+	struct AtlasSpriteFontData* pData = NULL;
+	GetGlyph(hAtlas, hFont, (u8)c, false, &pSprite, &pData);
+	return pSprite->widthPx;
+}
+
+float Fo_CharHeight(hAtlas hAtlas, HFont hFont, char c)
+{
+	AtlasSprite* pSprite = NULL;
+	struct AtlasSpriteFontData* pData = NULL;
+	GetGlyph(hAtlas, hFont, (u8)c, false, &pSprite, &pData);
+	return pSprite->heightPx;
+}
+
+static void MeasureGlyphRun(hAtlas hAtlas, HFont hFont, const char* str, size_t len, struct GlyphRun* pOutRun)
+{
+	float width = 0.0f;
+	float maxAboveBaseline = 0.0f;
+	float minBelowBaseline = 0.0f;
+	for (size_t i = 0; i < len; i++)
+	{
+		AtlasSprite* pSprite = NULL;
+		struct AtlasSpriteFontData* pData = NULL;
+		if (!GetGlyph(hAtlas, hFont, (u8)str[i], false, &pSprite, &pData))
+		{
+			continue;
+		}
+		width += pData->advance[0]; // x advance
+		if (pData->bearing[1] > maxAboveBaseline)
+		{
+			maxAboveBaseline = pData->bearing[1];
+		}
+		float belowBaseline = pData->bearing[1] - (float)pSprite->heightPx;
+		if (belowBaseline < minBelowBaseline)
+		{
+			minBelowBaseline = belowBaseline;
+		}
+	}
+	pOutRun->width = width;
+	pOutRun->maxYBearing = maxAboveBaseline;
+	pOutRun->minBelowBaseline = minBelowBaseline;
+	pOutRun->height = maxAboveBaseline - minBelowBaseline;
+}
+
+bool Fo_GetGlyphRun(hAtlas hAtlas, HFont hFont, const char* str, struct GlyphRun* pOutRun)
 {
 	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, false);
 	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
 
-	float maxBearing = 0.0f;
-	struct AtlasFont* pFont = &gAtlases[hAtlas].fonts[hFont];
-	
 	size_t len = strlen(str);
-	for (int i = 0; i < len; i++)
+	u64 hash = GRC_HashString(str, len);
+	const struct GlyphRun* pCached = GRC_Find(hAtlas, hFont, str, len, hash);
+	if (pCached)
+	{
+		*pOutRun = *pCached;
+		return true;
+	}
+	MeasureGlyphRun(hAtlas, hFont, str, len, pOutRun);
+	GRC_Insert(hAtlas, hFont, str, len, hash, pOutRun);
+	return true;
+}
+
+float Fo_StringWidth(hAtlas hAtlas, HFont hFont, const char* stringVal)
+{
+	struct GlyphRun run;
+	return Fo_GetGlyphRun(hAtlas, hFont, stringVal, &run) ? run.width : 0.0f;
+}
+
+float Fo_StringHeight(hAtlas hAtlas, HFont hFont, const char* stringVal)
+{
+	struct GlyphRun run;
+	return Fo_GetGlyphRun(hAtlas, hFont, stringVal, &run) ? run.height : 0.0f;
+}
+
+AtlasSprite* Fo_GetCharSprite(hAtlas hAtlas, HFont hFont, char c)
+{
+	return Fo_GetGlyphSprite(hAtlas, hFont, (u8)c);
+}
+
+AtlasSprite* Fo_GetGlyphSprite(hAtlas hAtlas, HFont hFont, u32 codepoint)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, NULL);
+	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, NULL);
+
+	if (gAtlases[hAtlas].fonts[hFont].pDynamic)
 	{
-		char c = str[i];
-		if (IsCharLoaded(pFont, c))
+		struct DynamicGlyph* pGlyph = GetDynamicGlyph(hAtlas, hFont, codepoint, true);
+		bool bHasPixels = pGlyph->sprite.widthPx > 0 && pGlyph->sprite.heightPx > 0;
+		if (pGlyph->sprite.bSet && bHasPixels && pGlyph->shelf == GLYPH_SHELF_NONE)
 		{
-			if (pFont->spriteData[c].bearing[1] > maxBearing)
-			{
-				maxBearing = pFont->spriteData[c].bearing[1];
-			}
+			return &gNonResidentGlyphSprite;
 		}
+		return &pGlyph->sprite;
 	}
-	return maxBearing;
+	AtlasSprite* pSprite = NULL;
+	struct AtlasSpriteFontData* pData = NULL;
+	GetGlyph(hAtlas, hFont, codepoint, false, &pSprite, &pData);
+	return pSprite;
+}
+
+float Fo_GetMaxYBearing(hAtlas hAtlas, HFont hFont, const char* str)
+{
+	struct GlyphRun run;
+	return Fo_GetGlyphRun(hAtlas, hFont, str, &run) ? run.maxYBearing : 0.0f;
+}
+
+float Fo_GetFontMaxYBearing(hAtlas hAtlas, HFont hFont)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, 0.0f);
+	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, 0.0f);
+	return gAtlases[hAtlas].fonts[hFont].maxYBearing;
+}
+
+float Fo_GetLineHeight(hAtlas hAtlas, HFont hFont)
+{
+	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, 0.0f);
+	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, 0.0f);
+	return gAtlases[hAtlas].fonts[hFont].lineHeight;
 }
 
 bool Fo_TryGetCharBearing(hAtlas hAtlas, HFont hFont, char c, vec2 outBearing)
+{
+	return Fo_TryGetGlyphBearing(hAtlas, hFont, (u8)c, outBearing);
+}
+
+bool Fo_TryGetCharAdvance(hAtlas hAtlas, HFont hFont, char c, float* outAdvance)
+{
+	return Fo_TryGetGlyphAdvance(hAtlas, hFont, (u8)c, outAdvance);
+}
+
+bool Fo_TryGetGlyphBearing(hAtlas hAtlas, HFont hFont, u32 codepoint, vec2 outBearing)
 {
 	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, false);
 	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
 
-	if (!gAtlases[hAtlas].fonts[hFont].sprites[(u8)c].bSet)
+	AtlasSprite* pSprite = NULL;
+	struct AtlasSpriteFontData* pData = NULL;
+	if (!GetGlyph(hAtlas, hFont, codepoint, false, &pSprite, &pData))
 	{
 		return false;
 	}
-	outBearing[0] = gAtlases[hAtlas].fonts[hFont].spriteData[(u8)c].bearing[0];
-	outBearing[1] = gAtlases[hAtlas].fonts[hFont].spriteData[(u8)c].bearing[1]; 
+	outBearing[0] = pData->bearing[0];
+	outBearing[1] = pData->bearing[1];
 	return true;
 }
 
-bool Fo_TryGetCharAdvance(hAtlas hAtlas, HFont hFont, char c, float* outAdvance)
+bool Fo_TryGetGlyphAdvance(hAtlas hAtlas, HFont hFont, u32 codepoint, float* outAdvance)
 {
 	ATLAS_HANDLE_BOUNDS_CHECK(hAtlas, false);
 	FONT_HANDLE_BOUNDS_CHECK(hAtlas, hFont, false);
@@ -1647,7 +3137,14 @@ bool Fo_TryGetCharAdvance(hAtlas hAtlas, HFont hFont, char c, float* outAdvance)
 	// {
 	// 	return false;
 	// }
-	*outAdvance = gAtlases[hAtlas].fonts[hFont].spriteData[(u8)c].advance[0];
+	AtlasSprite* pSprite = NULL;
+	struct AtlasSpriteFontData* pData = NULL;
+	GetGlyph(hAtlas, hFont, codepoint, false, &pSprite, &pData);
+	if (codepoint >= 256 && !gAtlases[hAtlas].fonts[hFont].pDynamic)
+	{
+		return false;
+	}
+	*outAdvance = pData->advance[0];
 	return true;
 }
 
@@ -1671,3 +3168,8 @@ struct AtlasAnimation* At_FindAnim(hAtlas atlas, const char* name)
 	return (struct AtlasAnimation*)HashmapSearch(&gAtlases[atlas].animations, name);
 }
 
+struct AtlasAnimation* At_FindAnimHashed(hAtlas atlas, const char* name, u32 hash)
+{
+	return (struct AtlasAnimation*)HashmapSearchHashed(&gAtlases[atlas].animations, name, hash);
+}
+
@@ -0,0 +1,693 @@
+#include "AtlasPacker.h"
+#include "DynArray.h"
+#include "BitField2D.h"
+#include "Clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* gPackerNames[APT_NumPackerTypes] =
+{
+	"freespace",
+	"maxrects",
+	"skyline"
+};
+
+const char* AtP_PackerName(enum AtlasPackerType packer)
+{
+	if (packer < 0 || packer >= APT_NumPackerTypes)
+	{
+		return "unknown";
+	}
+	return gPackerNames[packer];
+}
+
+bool AtP_PackerFromName(const char* name, enum AtlasPackerType* pOutPacker)
+{
+	for (int i = 0; i < APT_NumPackerTypes; i++)
+	{
+		if (strcmp(name, gPackerNames[i]) == 0)
+		{
+			*pOutPacker = (enum AtlasPackerType)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* doubles the smaller side, the width if they're the same */
+static void GrowBin(int* pW, int* pH)
+{
+	if (*pW > *pH)
+	{
+		*pH *= 2;
+	}
+	else
+	{
+		*pW *= 2;
+	}
+}
+
+/*
+	Free space merge packer
+*/
+
+struct AtlasRect
+{
+	int w, h;
+	int x, y;
+	bool bTaken;
+};
+
+static VECTOR(struct AtlasRect) AddNewFreeSpace(VECTOR(struct AtlasRect) outFreeSpace, int* currentWidth, int* currentHeight)
+{
+	int oldWidth = *currentWidth;
+	int oldHeight = *currentHeight;
+	GrowBin(currentWidth, currentHeight);
+	struct AtlasRect newR;
+	newR.bTaken = false;
+	if (*currentHeight != oldHeight)
+	{
+		newR.x = 0;
+		newR.y = oldHeight;
+		newR.w = *currentWidth;
+		newR.h = *currentHeight - oldHeight;
+	}
+	else
+	{
+		newR.x = oldWidth;
+		newR.y = 0;
+		newR.w = *currentWidth - oldWidth;
+		newR.h = *currentHeight;
+	}
+	return VectorPush(outFreeSpace, &newR);
+}
+
+static bool FitsInRect(const struct AtlasPackerRect* pRect, const struct AtlasRect* pFree)
+{
+	return pRect->w <= pFree->w && pRect->h <= pFree->h;
+}
+
+static int FindFittingFreeSpace(const struct AtlasPackerRect* pRect, VECTOR(struct AtlasRect) freeSpace)
+{
+	for (int j = 0; j < VectorSize(freeSpace); j++)
+	{
+		if (freeSpace[j].bTaken)
+		{
+			continue;
+		}
+		if (FitsInRect(pRect, &freeSpace[j]))
+		{
+			return j;
+		}
+	}
+	return -1;
+}
+
+struct FreeSpaceRun
+{
+	int atlasRectI;
+	int x,y,length;
+};
+
+static struct FreeSpaceRun* FindRunInPrevRow(VECTOR(struct FreeSpaceRun) prevRow, struct FreeSpaceRun* pRun)
+{
+	for(int i = 0; i < VectorSize(prevRow); i++)
+	{
+		if(prevRow[i].length == pRun->length && prevRow[i].x == pRun->x)
+		{
+			return &prevRow[i];
+		}
+	}
+	return NULL;
+}
+
+static struct AtlasRect* MergeFreeSpace(struct AtlasRect* pFreeSpace, struct Bitfield2D* pBF, int w, int h)
+{
+	// bitmap based free space merging
+
+
+	// 1.) set the bits where the free space is in the 2d bitfield
+	for(int i=0; i<VectorSize(pFreeSpace); i++)
+	{
+		struct AtlasRect* pRect = &pFreeSpace[i];
+		if(!pRect->bTaken)
+			Bf2D_SetBitfieldRegion(pBF, pRect->x, pRect->y, pRect->w, pRect->h);
+	}
+
+	// 2.) iterate row by row, for each run in the row either:
+	//      - extend the rect associated with a run in the previous row that matches its width and position by one pixel and associate the rect with this new run
+	//      - add a new free space rect and associate it with this run
+	// different alternatives exist, if there's a run that's bigger than one on the previous row we could extend the previous row and create a new rect from the remainder
+	VECTOR(struct AtlasRect) newFreeSpace = NEW_VECTOR(struct AtlasRect);
+
+	VECTOR(struct FreeSpaceRun) runs[2];
+	runs[0] = NEW_VECTOR(struct FreeSpaceRun);
+	runs[0] = VectorResize(runs[0], VectorSize(pFreeSpace));
+	runs[1] = NEW_VECTOR(struct FreeSpaceRun);
+	runs[1] = VectorResize(runs[1], VectorSize(pFreeSpace));
+
+	runs[0] = VectorClear(runs[0]);
+	runs[1] = VectorClear(runs[1]);
+
+	int onRun = 0;
+
+	for(int row = 0; row < h; row++)
+	{
+
+		runs[onRun] = VectorClear(runs[onRun]);
+		bool bDoingRun = false;
+
+		// generate runs
+		for(int col = 0; col < w; col++)
+		{
+			if(Bf2D_IsBitSet(pBF, col, row))
+			{
+				if(bDoingRun)
+				{
+					((struct FreeSpaceRun*)VectorTop(runs[onRun]))->length++;
+				}
+				else
+				{
+					struct FreeSpaceRun fsr;
+					fsr.x = col;
+					fsr.y = row;
+					fsr.length = 1;
+					runs[onRun] = VectorPush(runs[onRun], &fsr);
+					bDoingRun = true;
+				}
+			}
+			else
+			{
+				bDoingRun = false;
+			}
+		}
+
+		// for each run, either add a new free space rect or extend an existing one
+		for(int i = 0; i < VectorSize(runs[onRun]); i++)
+		{
+			struct FreeSpaceRun* pInPrevRow = FindRunInPrevRow(runs[onRun ? 0 : 1], &runs[onRun][i]);
+			if(pInPrevRow)
+			{
+				newFreeSpace[pInPrevRow->atlasRectI].h++;
+				runs[onRun][i].atlasRectI = pInPrevRow->atlasRectI;
+			}
+			else
+			{
+				// add new free space
+				struct AtlasRect r =
+				{
+					.w = runs[onRun][i].length,
+					.h = 1,
+					.x = runs[onRun][i].x,
+					.y = runs[onRun][i].y,
+					.bTaken = false
+				};
+				newFreeSpace = VectorPush(newFreeSpace, &r);
+				runs[onRun][i].atlasRectI = VectorSize(newFreeSpace) - 1;
+			}
+		}
+
+		// flip runs
+		onRun = onRun ? 0 : 1;
+	}
+	DestoryVector(runs[0]);
+	DestoryVector(runs[1]);
+	return newFreeSpace;
+}
+
+
+static int FreeSpaceSortFunc(const void* a, const void* b)
+{
+	const struct AtlasRect* pA = a;
+	const struct AtlasRect* pB = b;
+	return pA->w * pA->h > pB->w * pB->h;
+}
+
+static VECTOR(struct AtlasRect) PlaceInFreeSpace(int* outW, int* outH, struct AtlasPackerRect* pRect, VECTOR(struct AtlasRect) freeSpace, struct Bitfield2D* pBF)
+{
+	int index = FindFittingFreeSpace(pRect, freeSpace);
+	if (index >= 0)
+	{
+		struct AtlasRect* rct = &freeSpace[index];
+		rct->bTaken = true;
+
+		/*
+		     we need to split the remaining space into two rectangles and push them into
+			 the free space list like so:
+
+			 <-------- rct->w ------->
+			  _______________________
+			 |  rect  |  region 1    |
+			 |________|______________|
+			 |                       |    rect->h
+			 |     region 2          |
+			 |_______________________|
+
+		*/
+
+		pRect->x = rct->x;
+		pRect->y = rct->y;
+		struct AtlasRect region1 = { rct->w - pRect->w, pRect->h, rct->x + pRect->w, rct->y, false };
+		struct AtlasRect region2 = { rct->w, rct->h - pRect->h, rct->x, rct->y + pRect->h, false };
+
+		if (region1.w * region1.h > 0)
+		{
+			freeSpace = VectorPush(freeSpace, &region1);
+		}
+		if (region2.w * region2.h > 0)
+		{
+			freeSpace = VectorPush(freeSpace, &region2);
+		}
+		Bf2D_ClearBitField(pBF);
+		void* prevFreeSpace = freeSpace;
+		freeSpace = MergeFreeSpace(freeSpace, pBF, *outW, *outH);
+		DestoryVector(prevFreeSpace);
+		return freeSpace;
+	}
+	else
+	{
+		freeSpace = AddNewFreeSpace(freeSpace, outW, outH);
+		Bf2D_ResizeAndClearBitField(pBF, *outW, *outH);
+		void* prevFreeSpace = freeSpace;
+		freeSpace = MergeFreeSpace(freeSpace, pBF, *outW, *outH);
+		DestoryVector(prevFreeSpace);
+		// sort from small to big
+		qsort(freeSpace, VectorSize(freeSpace), sizeof(struct AtlasRect), &FreeSpaceSortFunc);
+		return PlaceInFreeSpace(outW, outH, pRect, freeSpace, pBF);
+	}
+}
+
+static void PackFreeSpaceMerge(struct AtlasPackerRect* pRects, int numRects, int* pInOutW, int* pInOutH)
+{
+	VECTOR(struct AtlasRect) freeSpace = NEW_VECTOR(struct AtlasRect);
+	struct AtlasRect r = { *pInOutW, *pInOutH, 0, 0, false };
+	freeSpace = VectorPush(freeSpace, &r);
+
+	/* used to merge free space blocks */
+	struct Bitfield2D* pBitField = Bf2D_NewBitField(*pInOutW, *pInOutH);
+	for (int i = 0; i < numRects; i++)
+	{
+		freeSpace = PlaceInFreeSpace(pInOutW, pInOutH, &pRects[i], freeSpace, pBitField);
+	}
+	Bf2D_FreeBitField(pBitField);
+	DestoryVector(freeSpace);
+}
+
+/*
+	Sorting for the MaxRects and skyline packers, they place rects in the sorted order and
+	start again in a bigger bin if one doesn't fit
+*/
+
+static const struct AtlasPackerRect* gpSortRects = NULL;
+
+/* tallest first, then widest */
+static int SortIndicesByHeight(const void* a, const void* b)
+{
+	int iA = *(const int*)a;
+	int iB = *(const int*)b;
+	const struct AtlasPackerRect* pA = &gpSortRects[iA];
+	const struct AtlasPackerRect* pB = &gpSortRects[iB];
+	if (pA->h != pB->h)
+	{
+		return pB->h - pA->h;
+	}
+	if (pA->w != pB->w)
+	{
+		return pB->w - pA->w;
+	}
+	return iA - iB;
+}
+
+/* longest side first, then biggest area */
+static int SortIndicesByLongSide(const void* a, const void* b)
+{
+	int iA = *(const int*)a;
+	int iB = *(const int*)b;
+	const struct AtlasPackerRect* pA = &gpSortRects[iA];
+	const struct AtlasPackerRect* pB = &gpSortRects[iB];
+	int longA = pA->w > pA->h ? pA->w : pA->h;
+	int longB = pB->w > pB->h ? pB->w : pB->h;
+	if (longA != longB)
+	{
+		return longB - longA;
+	}
+	int areaA = pA->w * pA->h;
+	int areaB = pB->w * pB->h;
+	if (areaA != areaB)
+	{
+		return areaB - areaA;
+	}
+	return iA - iB;
+}
+
+static int* SortRectIndices(const struct AtlasPackerRect* pRects, int numRects, int(*sortFn)(const void*, const void*))
+{
+	int* pIndices = malloc(sizeof(int) * numRects);
+	for (int i = 0; i < numRects; i++)
+	{
+		pIndices[i] = i;
+	}
+	gpSortRects = pRects;
+	qsort(pIndices, numRects, sizeof(int), sortFn);
+	gpSortRects = NULL;
+	return pIndices;
+}
+
+/*
+	MaxRects, best short side fit
+*/
+
+struct MaxRectsFree
+{
+	int x, y, w, h;
+};
+
+static bool MaxRectsContains(const struct MaxRectsFree* pOuter, const struct MaxRectsFree* pInner)
+{
+	return pInner->x >= pOuter->x && pInner->y >= pOuter->y &&
+		pInner->x + pInner->w <= pOuter->x + pOuter->w &&
+		pInner->y + pInner->h <= pOuter->y + pOuter->h;
+}
+
+/* the parts of pFree not covered by pUsed, as up to 4 maximal rects */
+static VECTOR(struct MaxRectsFree) MaxRectsSplit(VECTOR(struct MaxRectsFree) pOut, const struct MaxRectsFree* pFree, const struct AtlasPackerRect* pUsed)
+{
+	if (pUsed->x > pFree->x)
+	{
+		struct MaxRectsFree left = { pFree->x, pFree->y, pUsed->x - pFree->x, pFree->h };
+		pOut = VectorPush(pOut, &left);
+	}
+	if (pUsed->x + pUsed->w < pFree->x + pFree->w)
+	{
+		struct MaxRectsFree right = { pUsed->x + pUsed->w, pFree->y, pFree->x + pFree->w - (pUsed->x + pUsed->w), pFree->h };
+		pOut = VectorPush(pOut, &right);
+	}
+	if (pUsed->y > pFree->y)
+	{
+		struct MaxRectsFree top = { pFree->x, pFree->y, pFree->w, pUsed->y - pFree->y };
+		pOut = VectorPush(pOut, &top);
+	}
+	if (pUsed->y + pUsed->h < pFree->y + pFree->h)
+	{
+		struct MaxRectsFree bottom = { pFree->x, pUsed->y + pUsed->h, pFree->w, pFree->y + pFree->h - (pUsed->y + pUsed->h) };
+		pOut = VectorPush(pOut, &bottom);
+	}
+	return pOut;
+}
+
+static bool MaxRectsOverlaps(const struct MaxRectsFree* pFree, const struct AtlasPackerRect* pUsed)
+{
+	return pUsed->x < pFree->x + pFree->w && pUsed->x + pUsed->w > pFree->x &&
+		pUsed->y < pFree->y + pFree->h && pUsed->y + pUsed->h > pFree->y;
+}
+
+/*
+	Splits every free rect the placed rect overlaps. Only the rects made by the split need pruning:
+	the others were already maximal, and a split rect is inside the free rect it came from, so it can't
+	contain any of them.
+*/
+static VECTOR(struct MaxRectsFree) MaxRectsPlace(VECTOR(struct MaxRectsFree) freeRects, VECTOR(struct MaxRectsFree)* pSplits, const struct AtlasPackerRect* pUsed)
+{
+	*pSplits = VectorClear(*pSplits);
+	int numFree = VectorSize(freeRects);
+	for (int i = 0; i < numFree;)
+	{
+		if (MaxRectsOverlaps(&freeRects[i], pUsed))
+		{
+			*pSplits = MaxRectsSplit(*pSplits, &freeRects[i], pUsed);
+			freeRects[i] = freeRects[--numFree];
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	int numSplits = VectorSize(*pSplits);
+	for (int i = 0; i < numSplits; i++)
+	{
+		struct MaxRectsFree* pSplit = &(*pSplits)[i];
+		bool bContained = false;
+		for (int j = 0; j < numFree && !bContained; j++)
+		{
+			bContained = MaxRectsContains(&freeRects[j], pSplit);
+		}
+		/* of two identical splits only the first is kept */
+		for (int j = 0; j < numSplits && !bContained; j++)
+		{
+			if (j != i && (*pSplits)[j].w >= 0 && MaxRectsContains(&(*pSplits)[j], pSplit))
+			{
+				bContained = j < i || !MaxRectsContains(pSplit, &(*pSplits)[j]);
+			}
+		}
+		if (bContained)
+		{
+			/* w of -1 marks it as pruned */
+			pSplit->w = -1;
+		}
+	}
+
+	while (VectorSize(freeRects) > numFree)
+	{
+		VectorPop(freeRects);
+	}
+	for (int i = 0; i < numSplits; i++)
+	{
+		if ((*pSplits)[i].w >= 0)
+		{
+			freeRects = VectorPush(freeRects, &(*pSplits)[i]);
+		}
+	}
+	return freeRects;
+}
+
+static bool MaxRectsTryPack(struct AtlasPackerRect* pRects, const int* pOrder, int numRects, int w, int h)
+{
+	VECTOR(struct MaxRectsFree) freeRects = NEW_VECTOR(struct MaxRectsFree);
+	VECTOR(struct MaxRectsFree) splits = NEW_VECTOR(struct MaxRectsFree);
+	struct MaxRectsFree bin = { 0, 0, w, h };
+	freeRects = VectorPush(freeRects, &bin);
+	bool bPacked = true;
+	for (int i = 0; i < numRects; i++)
+	{
+		struct AtlasPackerRect* pRect = &pRects[pOrder[i]];
+		int bestShortSide = 0x7fffffff;
+		int bestLongSide = 0x7fffffff;
+		int bestFree = -1;
+		for (int j = 0; j < VectorSize(freeRects); j++)
+		{
+			const struct MaxRectsFree* pFree = &freeRects[j];
+			if (pRect->w > pFree->w || pRect->h > pFree->h)
+			{
+				continue;
+			}
+			int leftoverX = pFree->w - pRect->w;
+			int leftoverY = pFree->h - pRect->h;
+			int shortSide = leftoverX < leftoverY ? leftoverX : leftoverY;
+			int longSide = leftoverX < leftoverY ? leftoverY : leftoverX;
+			if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+			{
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+				bestFree = j;
+			}
+		}
+		if (bestFree < 0)
+		{
+			bPacked = false;
+			break;
+		}
+		pRect->x = freeRects[bestFree].x;
+		pRect->y = freeRects[bestFree].y;
+		freeRects = MaxRectsPlace(freeRects, &splits, pRect);
+	}
+	DestoryVector(freeRects);
+	DestoryVector(splits);
+	return bPacked;
+}
+
+static void PackMaxRects(struct AtlasPackerRect* pRects, int numRects, int* pInOutW, int* pInOutH)
+{
+	int* pOrder = SortRectIndices(pRects, numRects, &SortIndicesByLongSide);
+	while (!MaxRectsTryPack(pRects, pOrder, numRects, *pInOutW, *pInOutH))
+	{
+		GrowBin(pInOutW, pInOutH);
+	}
+	free(pOrder);
+}
+
+/*
+	Skyline, bottom left
+*/
+
+struct SkylineNode
+{
+	int x, y, w;
+};
+
+/*
+	Placing a rect adds a node and cuts back or removes the ones it covers, so there are at most
+	numRects + 1 nodes
+*/
+struct Skyline
+{
+	struct SkylineNode* pNodes;
+	int numNodes;
+};
+
+/* y to place a rect at the start of node i, -1 if it doesn't fit */
+static int SkylineFitY(const struct Skyline* pSkyline, int i, int w, int h, int binW, int binH)
+{
+	const struct SkylineNode* pNodes = pSkyline->pNodes;
+	if (pNodes[i].x + w > binW)
+	{
+		return -1;
+	}
+	int y = pNodes[i].y;
+	int widthLeft = w;
+	while (widthLeft > 0)
+	{
+		if (pNodes[i].y > y)
+		{
+			y = pNodes[i].y;
+		}
+		if (y + h > binH)
+		{
+			return -1;
+		}
+		widthLeft -= pNodes[i].w;
+		i++;
+	}
+	return y;
+}
+
+static void SkylineRemove(struct Skyline* pSkyline, int i)
+{
+	memmove(&pSkyline->pNodes[i], &pSkyline->pNodes[i + 1], sizeof(struct SkylineNode) * (pSkyline->numNodes - i - 1));
+	pSkyline->numNodes--;
+}
+
+static void SkylineAdd(struct Skyline* pSkyline, int i, const struct AtlasPackerRect* pRect)
+{
+	struct SkylineNode* pNodes = pSkyline->pNodes;
+	memmove(&pNodes[i + 1], &pNodes[i], sizeof(struct SkylineNode) * (pSkyline->numNodes - i));
+	pSkyline->numNodes++;
+	pNodes[i].x = pRect->x;
+	pNodes[i].y = pRect->y + pRect->h;
+	pNodes[i].w = pRect->w;
+
+	/* cut back or remove the nodes the new one covers */
+	for (int j = i + 1; j < pSkyline->numNodes;)
+	{
+		int overlap = pNodes[j - 1].x + pNodes[j - 1].w - pNodes[j].x;
+		if (overlap <= 0)
+		{
+			break;
+		}
+		if (overlap < pNodes[j].w)
+		{
+			pNodes[j].x += overlap;
+			pNodes[j].w -= overlap;
+			break;
+		}
+		SkylineRemove(pSkyline, j);
+	}
+
+	/* merge neighbours at the same height */
+	for (int j = 0; j + 1 < pSkyline->numNodes;)
+	{
+		if (pNodes[j].y == pNodes[j + 1].y)
+		{
+			pNodes[j].w += pNodes[j + 1].w;
+			SkylineRemove(pSkyline, j + 1);
+		}
+		else
+		{
+			j++;
+		}
+	}
+}
+
+static bool SkylineTryPack(struct AtlasPackerRect* pRects, const int* pOrder, int numRects, int w, int h)
+{
+	struct Skyline skyline;
+	skyline.pNodes = malloc(sizeof(struct SkylineNode) * (numRects + 1));
+	skyline.pNodes[0].x = 0;
+	skyline.pNodes[0].y = 0;
+	skyline.pNodes[0].w = w;
+	skyline.numNodes = 1;
+	bool bPacked = true;
+	for (int i = 0; i < numRects; i++)
+	{
+		struct AtlasPackerRect* pRect = &pRects[pOrder[i]];
+		int bestTop = 0x7fffffff;
+		int bestNodeW = 0x7fffffff;
+		int bestNode = -1;
+		for (int j = 0; j < skyline.numNodes; j++)
+		{
+			int y = SkylineFitY(&skyline, j, pRect->w, pRect->h, w, h);
+			if (y < 0)
+			{
+				continue;
+			}
+			int top = y + pRect->h;
+			if (top < bestTop || (top == bestTop && skyline.pNodes[j].w < bestNodeW))
+			{
+				bestTop = top;
+				bestNodeW = skyline.pNodes[j].w;
+				bestNode = j;
+				pRect->x = skyline.pNodes[j].x;
+				pRect->y = y;
+			}
+		}
+		if (bestNode < 0)
+		{
+			bPacked = false;
+			break;
+		}
+		SkylineAdd(&skyline, bestNode, pRect);
+	}
+	free(skyline.pNodes);
+	return bPacked;
+}
+
+static void PackSkyline(struct AtlasPackerRect* pRects, int numRects, int* pInOutW, int* pInOutH)
+{
+	int* pOrder = SortRectIndices(pRects, numRects, &SortIndicesByHeight);
+	while (!SkylineTryPack(pRects, pOrder, numRects, *pInOutW, *pInOutH))
+	{
+		GrowBin(pInOutW, pInOutH);
+	}
+	free(pOrder);
+}
+
+void AtP_Pack(enum AtlasPackerType packer, struct AtlasPackerRect* pRects, int numRects, int* pInOutW, int* pInOutH, struct AtlasPackStats* pOutStats)
+{
+	double startMs = Clk_NowMs();
+	switch (packer)
+	{
+	case APT_MaxRectsBSSF:
+		PackMaxRects(pRects, numRects, pInOutW, pInOutH);
+		break;
+	case APT_SkylineBL:
+		PackSkyline(pRects, numRects, pInOutW, pInOutH);
+		break;
+	case APT_FreeSpaceMerge:
+	default:
+		PackFreeSpaceMerge(pRects, numRects, pInOutW, pInOutH);
+		break;
+	}
+	if (pOutStats)
+	{
+		pOutStats->packMs = Clk_NowMs() - startMs;
+		pOutStats->packer = packer;
+		pOutStats->width = *pInOutW;
+		pOutStats->height = *pInOutH;
+		pOutStats->usedPixels = 0;
+		for (int i = 0; i < numRects; i++)
+		{
+			pOutStats->usedPixels += (u64)pRects[i].w * (u64)pRects[i].h;
+		}
+		pOutStats->occupancyPercent = (float)(100.0 * (double)pOutStats->usedPixels / ((double)*pInOutW * (double)*pInOutH));
+	}
+}
@@ -3,134 +3,327 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include "DynArray.h"
 #include "AssertLib.h"
 
-void BS_CreateForLoad(const char* path, struct BinarySerializer* pOutSerializer)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BS_BIG_ENDIAN_HOST
+#endif
+
+#define BS_INITIAL_MEMORY_CAPACITY 1024
+
+static void InitSerializer(const char* path, struct BinarySerializer* pOutSerializer)
 {
 	memset(pOutSerializer, 0, sizeof(struct BinarySerializer));
+	if (path)
+	{
+		pOutSerializer->pPath = malloc(strlen(path) + 1);
+		strcpy(pOutSerializer->pPath, path);
+	}
+}
+
+void BS_CreateForLoad(const char* path, struct BinarySerializer* pOutSerializer)
+{
+	InitSerializer(path, pOutSerializer);
 	pOutSerializer->bSaving = false;
-	pOutSerializer->pData = LoadFile(path, &pOutSerializer->pDataSize);
+	int size = 0;
+	pOutSerializer->pData = LoadFile(path, &size);
+	pOutSerializer->dataSize = pOutSerializer->pData ? (size_t)size : 0;
+	pOutSerializer->capacity = pOutSerializer->dataSize;
+	pOutSerializer->pReadPtr = pOutSerializer->pData;
+	pOutSerializer->bOwnsData = true;
+	if (!pOutSerializer->pData)
+	{
+		printf("BinarySerializer: can't open %s for reading\n", path);
+		pOutSerializer->bError = true;
+	}
+}
+
+void BS_CreateForLoadFromMemory(const void* pData, size_t size, struct BinarySerializer* pOutSerializer)
+{
+	InitSerializer(NULL, pOutSerializer);
+	pOutSerializer->bSaving = false;
+	pOutSerializer->pData = (char*)pData;
+	pOutSerializer->dataSize = size;
+	pOutSerializer->capacity = size;
 	pOutSerializer->pReadPtr = pOutSerializer->pData;
-	pOutSerializer->pPath = malloc(strlen(path) + 1);
-	strcpy(pOutSerializer->pPath, path);
 }
 
 void BS_CreateForSave(const char* path, struct BinarySerializer* pOutSerializer)
 {
-	memset(pOutSerializer, 0, sizeof(struct BinarySerializer));
-	pOutSerializer->bSaving = true;
-	pOutSerializer->pData = NEW_VECTOR(char);
+	FILE* pFile = fopen(path, "wb");
+	BS_CreateForSaveToFile(pFile, pOutSerializer);
+	pOutSerializer->bOwnsFile = true;
 	pOutSerializer->pPath = malloc(strlen(path) + 1);
 	strcpy(pOutSerializer->pPath, path);
+	if (!pFile)
+	{
+		printf("BinarySerializer: can't open %s for writing\n", path);
+		pOutSerializer->bError = true;
+	}
+}
+
+void BS_CreateForSaveToFile(FILE* pFile, struct BinarySerializer* pOutSerializer)
+{
+	InitSerializer(NULL, pOutSerializer);
+	pOutSerializer->bSaving = true;
+	pOutSerializer->pFile = pFile;
+	pOutSerializer->pData = malloc(BS_STREAM_CHUNK_SIZE);
+	pOutSerializer->capacity = BS_STREAM_CHUNK_SIZE;
+	pOutSerializer->bOwnsData = true;
 }
 
-void BS_Finish(struct BinarySerializer* pOutSerializer)
+void BS_CreateForSaveToMemory(struct BinarySerializer* pOutSerializer)
 {
-	if (pOutSerializer->bSaving)
+	InitSerializer(NULL, pOutSerializer);
+	pOutSerializer->bSaving = true;
+	pOutSerializer->pData = malloc(BS_INITIAL_MEMORY_CAPACITY);
+	pOutSerializer->capacity = BS_INITIAL_MEMORY_CAPACITY;
+	pOutSerializer->bOwnsData = true;
+}
+
+static void WriteToFile(struct BinarySerializer* pSerializer, const void* pSrc, size_t numBytes)
+{
+	if (!pSerializer->pFile || pSerializer->bError)
 	{
-		FILE* pFile = fopen(pOutSerializer->pPath, "wb");
-		fwrite(pOutSerializer->pData, 1, VectorSize(pOutSerializer->pData), pFile);
-		fclose(pFile);
-		DestoryVector(pOutSerializer->pData);
+		return;
 	}
-	else
+	if (fwrite(pSrc, 1, numBytes, pSerializer->pFile) != numBytes)
 	{
-		free(pOutSerializer->pData);
+		printf("BinarySerializer: error writing %s\n", pSerializer->pPath ? pSerializer->pPath : "file");
+		pSerializer->bError = true;
 	}
-	EASSERT(pOutSerializer->pPath);
-	free(pOutSerializer->pPath);
 }
 
-void BS_SerializeI64(i64 val, struct BinarySerializer* pSerializer)
+static void Flush(struct BinarySerializer* pSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(i64); i++)
+	if (pSerializer->dataSize)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		WriteToFile(pSerializer, pSerializer->pData, pSerializer->dataSize);
+		pSerializer->dataSize = 0;
 	}
 }
 
-void BS_SerializeU64(u64 val, struct BinarySerializer* pSerializer)
+static void WriteBytes(struct BinarySerializer* pSerializer, const void* pSrc, size_t numBytes)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(u64); i++)
+	EASSERT(pSerializer->bSaving);
+	if (pSerializer->bError)
+	{
+		/* the file couldn't be opened or written, don't buffer the rest of the save in memory */
+		return;
+	}
+	pSerializer->totalBytesWritten += numBytes;
+	if (pSerializer->dataSize + numBytes <= pSerializer->capacity)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		memcpy(pSerializer->pData + pSerializer->dataSize, pSrc, numBytes);
+		pSerializer->dataSize += numBytes;
+		return;
 	}
+
+	if (pSerializer->pFile)
+	{
+		Flush(pSerializer);
+		if (numBytes >= pSerializer->capacity)
+		{
+			/* big blocks like atlas pixels skip the buffer */
+			WriteToFile(pSerializer, pSrc, numBytes);
+		}
+		else
+		{
+			memcpy(pSerializer->pData, pSrc, numBytes);
+			pSerializer->dataSize = numBytes;
+		}
+		return;
+	}
+
+	size_t newCapacity = pSerializer->capacity * 2;
+	while (newCapacity < pSerializer->dataSize + numBytes)
+	{
+		newCapacity *= 2;
+	}
+	pSerializer->pData = realloc(pSerializer->pData, newCapacity);
+	pSerializer->capacity = newCapacity;
+	memcpy(pSerializer->pData + pSerializer->dataSize, pSrc, numBytes);
+	pSerializer->dataSize += numBytes;
 }
 
-void BS_SerializeI32(i32 val, struct BinarySerializer* pSerializer)
+static void ReadPastEnd(struct BinarySerializer* pSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(i32); i++)
+	if (!pSerializer->bError)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		printf("BinarySerializer: read past the end of %s\n", pSerializer->pPath ? pSerializer->pPath : "data");
 	}
+	pSerializer->bError = true;
+	pSerializer->pReadPtr = pSerializer->pData + pSerializer->dataSize;
 }
 
-void BS_SerializeU32(u32 val, struct BinarySerializer* pSerializer)
+/* returns the bytes to read from, or zeros if there aren't enough left */
+static const u8* ReadBytes(struct BinarySerializer* pSerializer, size_t numBytes)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(u32); i++)
+	static const u8 zeros[8] = { 0 };
+	EASSERT(!pSerializer->bSaving);
+	EASSERT(numBytes <= sizeof(zeros));
+	if (BS_BytesRemaining(pSerializer) < numBytes)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		ReadPastEnd(pSerializer);
+		return zeros;
 	}
+	const u8* pRead = (const u8*)pSerializer->pReadPtr;
+	pSerializer->pReadPtr += numBytes;
+	return pRead;
 }
 
-void BS_SerializeI16(i16 val, struct BinarySerializer* pSerializer)
+/* like ReadBytes but copies out, so works for blocks of any size */
+static void ReadBytesInto(struct BinarySerializer* pSerializer, size_t numBytes, void* pDst)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(i16); i++)
+	EASSERT(!pSerializer->bSaving);
+	size_t remaining = BS_BytesRemaining(pSerializer);
+	if (remaining < numBytes)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		memcpy(pDst, pSerializer->pReadPtr, remaining);
+		memset((char*)pDst + remaining, 0, numBytes - remaining);
+		ReadPastEnd(pSerializer);
+		return;
 	}
+	memcpy(pDst, pSerializer->pReadPtr, numBytes);
+	pSerializer->pReadPtr += numBytes;
 }
 
-void BS_SerializeU16(u16 val, struct BinarySerializer* pSerializer)
+bool BS_Finish(struct BinarySerializer* pOutSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(u16); i++)
+	if (pOutSerializer->bSaving && pOutSerializer->pFile)
+	{
+		Flush(pOutSerializer);
+		if (pOutSerializer->bOwnsFile)
+		{
+			if (fclose(pOutSerializer->pFile) != 0)
+			{
+				pOutSerializer->bError = true;
+			}
+		}
+		else
+		{
+			fflush(pOutSerializer->pFile);
+		}
+	}
+	if (pOutSerializer->bOwnsData)
+	{
+		free(pOutSerializer->pData);
+	}
+	if (pOutSerializer->pPath)
 	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
+		free(pOutSerializer->pPath);
 	}
+	bool bOk = !pOutSerializer->bError;
+	memset(pOutSerializer, 0, sizeof(struct BinarySerializer));
+	return bOk;
+}
+
+const char* BS_GetSavedData(struct BinarySerializer* pSerializer, size_t* pOutSize)
+{
+	EASSERT(pSerializer->bSaving && !pSerializer->pFile);
+	*pOutSize = pSerializer->dataSize;
+	return pSerializer->pData;
+}
+
+size_t BS_BytesRemaining(struct BinarySerializer* pSerializer)
+{
+	EASSERT(!pSerializer->bSaving);
+	return pSerializer->dataSize - (size_t)(pSerializer->pReadPtr - pSerializer->pData);
+}
+
+static void WriteU16LE(u16 val, u8* pOut)
+{
+	pOut[0] = (u8)val;
+	pOut[1] = (u8)(val >> 8);
+}
+
+static void WriteU32LE(u32 val, u8* pOut)
+{
+	pOut[0] = (u8)val;
+	pOut[1] = (u8)(val >> 8);
+	pOut[2] = (u8)(val >> 16);
+	pOut[3] = (u8)(val >> 24);
+}
+
+static u16 ReadU16LE(const u8* pIn)
+{
+	return (u16)(pIn[0] | (pIn[1] << 8));
+}
+
+static u32 ReadU32LE(const u8* pIn)
+{
+	return (u32)pIn[0] | ((u32)pIn[1] << 8) | ((u32)pIn[2] << 16) | ((u32)pIn[3] << 24);
+}
+
+static u64 ReadU64LE(const u8* pIn)
+{
+	return (u64)ReadU32LE(pIn) | ((u64)ReadU32LE(pIn + 4) << 32);
+}
+
+void BS_SerializeI64(i64 val, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU64((u64)val, pSerializer);
+}
+
+void BS_SerializeU64(u64 val, struct BinarySerializer* pSerializer)
+{
+	u8 bytes[8];
+	WriteU32LE((u32)val, bytes);
+	WriteU32LE((u32)(val >> 32), bytes + 4);
+	WriteBytes(pSerializer, bytes, sizeof(bytes));
+}
+
+void BS_SerializeI32(i32 val, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU32((u32)val, pSerializer);
+}
+
+void BS_SerializeU32(u32 val, struct BinarySerializer* pSerializer)
+{
+	u8 bytes[4];
+	WriteU32LE(val, bytes);
+	WriteBytes(pSerializer, bytes, sizeof(bytes));
+}
+
+void BS_SerializeI16(i16 val, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU16((u16)val, pSerializer);
+}
+
+void BS_SerializeU16(u16 val, struct BinarySerializer* pSerializer)
+{
+	u8 bytes[2];
+	WriteU16LE(val, bytes);
+	WriteBytes(pSerializer, bytes, sizeof(bytes));
 }
 
 void BS_SerializeI8(i8 val, struct BinarySerializer* pSerializer)
 {
-	pSerializer->pData = VectorPush(pSerializer->pData, &val);
+	WriteBytes(pSerializer, &val, 1);
 }
 
 void BS_SerializeU8(u8 val, struct BinarySerializer* pSerializer)
 {
-	pSerializer->pData = VectorPush(pSerializer->pData, &val);
+	WriteBytes(pSerializer, &val, 1);
 }
 
 void BS_SerializeBool(bool val, struct BinarySerializer* pSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(bool); i++)
-	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
-	}
+	BS_SerializeU8(val ? 1 : 0, pSerializer);
 }
 
 void BS_SerializeFloat(float val, struct BinarySerializer* pSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(float); i++)
-	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
-	}
+	u32 bits;
+	memcpy(&bits, &val, sizeof(u32));
+	BS_SerializeU32(bits, pSerializer);
 }
 
 void BS_SerializeDouble(double val, struct BinarySerializer* pSerializer)
 {
-	char* pIn = (char*)&val;
-	for (int i = 0; i < sizeof(double); i++)
-	{
-		pSerializer->pData = VectorPush(pSerializer->pData, &pIn[i]);
-	}
+	u64 bits;
+	memcpy(&bits, &val, sizeof(u64));
+	BS_SerializeU64(bits, pSerializer);
 }
 
 void BS_SerializeString(const char* val, struct BinarySerializer* pSerializer)
@@ -140,112 +333,187 @@ void BS_SerializeString(const char* val, struct BinarySerializer* pSerializer)
 		BS_SerializeU32(0, pSerializer);
 		return;
 	}
-	BS_SerializeU32(strlen(val), pSerializer);
-	while (*val)
-	{
-		pSerializer->pData = VectorPush(pSerializer->pData, val++);
-	}
+	u32 len = strlen(val);
+	BS_SerializeU32(len, pSerializer);
+	WriteBytes(pSerializer, val, len);
 }
 
 void BS_SerializeBytes(const char* val, u32 len, struct BinarySerializer* pSerializer)
 {
 	BS_SerializeU32(len, pSerializer);
-	for (int i = 0; i < len; i++)
+	WriteBytes(pSerializer, val, len);
+}
+
+void BS_SerializeU8Array(const u8* vals, size_t count, struct BinarySerializer* pSerializer)
+{
+	WriteBytes(pSerializer, vals, count);
+}
+
+void BS_SerializeU16Array(const u16* vals, size_t count, struct BinarySerializer* pSerializer)
+{
+#ifdef BS_BIG_ENDIAN_HOST
+	for (size_t i = 0; i < count; i++)
+	{
+		BS_SerializeU16(vals[i], pSerializer);
+	}
+#else
+	WriteBytes(pSerializer, vals, count * sizeof(u16));
+#endif
+}
+
+void BS_SerializeU32Array(const u32* vals, size_t count, struct BinarySerializer* pSerializer)
+{
+#ifdef BS_BIG_ENDIAN_HOST
+	for (size_t i = 0; i < count; i++)
 	{
-		BS_SerializeU8((u8)val[i], pSerializer);
+		BS_SerializeU32(vals[i], pSerializer);
 	}
+#else
+	WriteBytes(pSerializer, vals, count * sizeof(u32));
+#endif
+}
+
+void BS_SerializeI32Array(const i32* vals, size_t count, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU32Array((const u32*)vals, count, pSerializer);
+}
+
+void BS_SerializeF32Array(const float* vals, size_t count, struct BinarySerializer* pSerializer)
+{
+	BS_SerializeU32Array((const u32*)vals, count, pSerializer);
 }
 
 void BS_DeSerializeI64(i64* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((i64*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(i64);
+	*val = (i64)ReadU64LE(ReadBytes(pSerializer, sizeof(i64)));
 }
 
 void BS_DeSerializeU64(u64* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((u64*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(u64);
+	*val = ReadU64LE(ReadBytes(pSerializer, sizeof(u64)));
 }
 
 void BS_DeSerializeI32(i32* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((i32*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(i32);
+	*val = (i32)ReadU32LE(ReadBytes(pSerializer, sizeof(i32)));
 }
 
 void BS_DeSerializeU32(u32* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((u32*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(u32);
+	*val = ReadU32LE(ReadBytes(pSerializer, sizeof(u32)));
 }
 
 void BS_DeSerializeI16(i16* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((i16*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(i16);
+	*val = (i16)ReadU16LE(ReadBytes(pSerializer, sizeof(i16)));
 }
 
 void BS_DeSerializeU16(u16* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((u16*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(i16);
+	*val = ReadU16LE(ReadBytes(pSerializer, sizeof(u16)));
 }
 
 void BS_DeSerializeI8(i8* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((i8*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(i8);
+	*val = (i8)*ReadBytes(pSerializer, sizeof(i8));
 }
 
 void BS_DeSerializeU8(u8* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((u8*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(u8);
+	*val = *ReadBytes(pSerializer, sizeof(u8));
 }
 
 void BS_DeSerializeBool(bool* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((bool*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(bool);
+	*val = *ReadBytes(pSerializer, 1) != 0;
 }
 
 void BS_DeSerializeFloat(float* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((float*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(float);
+	u32 bits = ReadU32LE(ReadBytes(pSerializer, sizeof(u32)));
+	memcpy(val, &bits, sizeof(float));
 }
 
 void BS_DeSerializeDouble(double* val, struct BinarySerializer* pSerializer)
 {
-	*val = *((float*)pSerializer->pReadPtr);
-	pSerializer->pReadPtr += sizeof(float);
+	u64 bits = ReadU64LE(ReadBytes(pSerializer, sizeof(u64)));
+	memcpy(val, &bits, sizeof(double));
 }
 
 void BS_DeSerializeStringInto(char* buf, struct BinarySerializer* pSerializer)
 {
 	u32 len = 0;
 	BS_DeSerializeU32(&len, pSerializer);
-	for(int i=0; i<len; i++)
-	{
-		BS_DeSerializeI8(buf++, pSerializer);
-	}
-	*buf = '\0';
+	ReadBytesInto(pSerializer, len, buf);
+	buf[len] = '\0';
 }
 
 void BS_DeSerializeString(char** val, struct BinarySerializer* pSerializer)
 {
 	u32 len = 0;
 	BS_DeSerializeU32(&len, pSerializer);
+	if (len > BS_BytesRemaining(pSerializer))
+	{
+		/* don't trust the length enough to allocate it */
+		ReadPastEnd(pSerializer);
+		len = 0;
+	}
 	*val = malloc(len + 1);
-	memcpy(*val, pSerializer->pReadPtr, len);
+	ReadBytesInto(pSerializer, len, *val);
 	(*val)[len] = '\0';
-	pSerializer->pReadPtr += len;
 }
 
-
 void BS_BytesRead(struct BinarySerializer* pSerializer, u32 numBytes, char* pDst)
 {
-	memcpy(pDst, pSerializer->pReadPtr, numBytes);
+	ReadBytesInto(pSerializer, numBytes, pDst);
+}
+
+const u8* BS_BytesReadInPlace(struct BinarySerializer* pSerializer, size_t numBytes)
+{
+	EASSERT(!pSerializer->bSaving);
+	if (BS_BytesRemaining(pSerializer) < numBytes)
+	{
+		ReadPastEnd(pSerializer);
+		return NULL;
+	}
+	const u8* pRead = (const u8*)pSerializer->pReadPtr;
 	pSerializer->pReadPtr += numBytes;
-}
\ No newline at end of file
+	return pRead;
+}
+
+void BS_DeSerializeU8Array(u8* outVals, size_t count, struct BinarySerializer* pSerializer)
+{
+	ReadBytesInto(pSerializer, count, outVals);
+}
+
+void BS_DeSerializeU16Array(u16* outVals, size_t count, struct BinarySerializer* pSerializer)
+{
+	ReadBytesInto(pSerializer, count * sizeof(u16), outVals);
+#ifdef BS_BIG_ENDIAN_HOST
+	for (size_t i = 0; i < count; i++)
+	{
+		outVals[i] = ReadU16LE((const u8*)&outVals[i]);
+	}
+#endif
+}
+
+void BS_DeSerializeU32Array(u32* outVals, size_t count, struct BinarySerializer* pSerializer)
+{
+	ReadBytesInto(pSerializer, count * sizeof(u32), outVals);
+#ifdef BS_BIG_ENDIAN_HOST
+	for (size_t i = 0; i < count; i++)
+	{
+		outVals[i] = ReadU32LE((const u8*)&outVals[i]);
+	}
+#endif
+}
+
+void BS_DeSerializeI32Array(i32* outVals, size_t count, struct BinarySerializer* pSerializer)
+{
+	BS_DeSerializeU32Array((u32*)outVals, count, pSerializer);
+}
+
+void BS_DeSerializeF32Array(float* outVals, size_t count, struct BinarySerializer* pSerializer)
+{
+	BS_DeSerializeU32Array((u32*)outVals, count, pSerializer);
+}
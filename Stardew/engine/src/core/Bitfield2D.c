@@ -67,4 +67,5 @@ void Bf2D_ResizeAndClearBitField(struct Bitfield2D* pBF, int newW, int newH)
     pBF->h = newH;
     pBF->sizeBytes = (newW * newH) % 8 ? ((newW * newH) / 8) + 1 : (newW * newH) / 8;
     pBF->pData = malloc(pBF->sizeBytes);
+    Bf2D_ClearBitField(pBF);
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "Clock.h"
+#include "PlatformDefs.h"
+
+#if defined(GAME_PLATFORM_WINDOWS_64) || defined(GAME_PLATFORM_WINDOWS_32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+u64 Clk_NowNs(void)
+{
+#if defined(GAME_PLATFORM_WINDOWS_64) || defined(GAME_PLATFORM_WINDOWS_32)
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	u64 seconds = counter.QuadPart / frequency.QuadPart;
+	u64 remainder = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000ull + (remainder * 1000000000ull) / frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+#endif
+}
+
+double Clk_NowMs(void)
+{
+	return (double)Clk_NowNs() / 1000000.0;
+}
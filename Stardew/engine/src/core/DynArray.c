@@ -1,18 +1,47 @@
 #include "DynArray.h"
 #include <string.h>
 #include <stdlib.h> 
+#include "FrameArena.h"
 
 
+static void* AllocVectorStorage(enum VectorAllocator allocator, size_t size)
+{
+	switch (allocator)
+	{
+	case VA_Frame:
+		return Ar_FrameAlloc(size);
+	case VA_TwoFrame:
+		return Ar_TwoFrameAlloc(size);
+	default:
+		return malloc(size);
+	}
+}
 
-void* VectorInit(unsigned int itemSize)
+static void* VectorInitBase(unsigned int itemSize, enum VectorAllocator allocator)
 {
-	VectorData* data = (VectorData*)malloc(sizeof(VectorData) + itemSize);
+	VectorData* data = (VectorData*)AllocVectorStorage(allocator, sizeof(VectorData) + itemSize * VECTOR_INITIAL_CAPACITY);
 	data->itemSize = itemSize;
 	data->size = 0;
-	data->capacity = 1;
+	data->capacity = VECTOR_INITIAL_CAPACITY;
+	data->allocator = allocator;
 	return data + 1;
 }
 
+void* VectorInit(unsigned int itemSize)
+{
+	return VectorInitBase(itemSize, VA_Heap);
+}
+
+void* VectorInitFrame(unsigned int itemSize)
+{
+	return VectorInitBase(itemSize, VA_Frame);
+}
+
+void* VectorInitTwoFrame(unsigned int itemSize)
+{
+	return VectorInitBase(itemSize, VA_TwoFrame);
+}
+
 void* VectorResize(void* vector, unsigned int size)
 {
 	VectorData* pData = ((VectorData*)vector) - 1;
@@ -20,37 +49,71 @@ void* VectorResize(void* vector, unsigned int size)
 	{
 		return vector;
 	}
-	else if (size > pData->capacity)
+	VectorData* pNewAlloc = NULL;
+	if (pData->allocator == VA_Heap)
+	{
+		pNewAlloc = realloc(pData, sizeof(VectorData) + (size_t)pData->itemSize * size);
+	}
+	else
 	{
-		VectorData* pNewAlloc = malloc(sizeof(VectorData) + pData->itemSize * size);
+		/* arena memory can't be resized in place, the old allocation is reclaimed when the arena resets */
+		pNewAlloc = AllocVectorStorage(pData->allocator, sizeof(VectorData) + (size_t)pData->itemSize * size);
 		if (pNewAlloc)
 		{
-			pNewAlloc->size = pData->size;
-			pData->capacity = size;
-			memcpy(pNewAlloc, pData, sizeof(VectorData) + pData->size * pData->itemSize);
-
-			free(pData);
-		}
-		else
-		{
-			return NULL;
+			memcpy(pNewAlloc, pData, sizeof(VectorData) + (size_t)pData->itemSize * pData->size);
 		}
-		
-		return pNewAlloc + 1;
 	}
-	return vector;
+	if (!pNewAlloc)
+	{
+		return NULL;
+	}
+	pNewAlloc->capacity = size;
+	return pNewAlloc + 1;
+}
+
+void* VectorReserve(void* vector, unsigned int capacity)
+{
+	VectorData* pData = ((VectorData*)vector) - 1;
+	if (capacity <= pData->capacity)
+	{
+		return vector;
+	}
+	unsigned int newCapacity = pData->capacity ? pData->capacity * 2 : VECTOR_INITIAL_CAPACITY;
+	while (newCapacity < capacity)
+	{
+		newCapacity *= 2;
+	}
+	return VectorResize(vector, newCapacity);
 }
 
 void* VectorPush(void* vector, void* item)
 {
 	VectorData* pData = ((VectorData*)vector) - 1;
-	if (++pData->size > pData->capacity)
+	if (pData->size == pData->capacity)
 	{
 		vector = VectorResize(vector, pData->capacity * 2);
 		pData = ((VectorData*)vector) - 1;
 	}
-	void* topSpot = VectorTop(vector);
-	memcpy(topSpot, item, pData->itemSize);
+	memcpy((char*)vector + pData->size * pData->itemSize, item, pData->itemSize);
+	pData->size++;
+	return vector;
+}
+
+void* VectorEmplaceN(void* vector, unsigned int n, void** ppOutItems)
+{
+	VectorData* pData = ((VectorData*)vector) - 1;
+	vector = VectorReserve(vector, pData->size + n);
+	pData = ((VectorData*)vector) - 1;
+	*ppOutItems = (char*)vector + pData->size * pData->itemSize;
+	pData->size += n;
+	return vector;
+}
+
+void* VectorPushN(void* vector, const void* items, unsigned int n)
+{
+	void* pDst = NULL;
+	vector = VectorEmplaceN(vector, n, &pDst);
+	memcpy(pDst, items, (size_t)n * (((VectorData*)vector) - 1)->itemSize);
 	return vector;
 }
 
@@ -84,5 +147,8 @@ void* VectorClear(void* vector)
 void DestoryVector(void* vector)
 {
 	VectorData* pData = ((VectorData*)vector) - 1;
-	free(pData);
+	if (pData->allocator == VA_Heap)
+	{
+		free(pData);
+	}
 }
@@ -5,7 +5,7 @@
 
 char* LoadFile(const char* path, int* outSize)
 {
-	FILE* fp = fopen(path, "r");
+	FILE* fp = fopen(path, "rb");
 	if (!fp) return NULL;
 	fseek(fp, 0L, SEEK_END);
 	*outSize = ftell(fp);
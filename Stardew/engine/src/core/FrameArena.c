@@ -0,0 +1,171 @@
+#include "FrameArena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "AssertLib.h"
+
+struct ArenaOverflowBlock
+{
+	struct ArenaOverflowBlock* pNext;
+	size_t _padding;
+	// 16 byte aligned
+};
+
+struct FrameArenaSet
+{
+	struct LinearArena frame;
+	/* double buffered: index onTwoFrameArena is allocated from, the other holds last frames allocations */
+	struct LinearArena twoFrame[2];
+	int onTwoFrameArena;
+	struct FrameArenaStats frameStats;
+	struct FrameArenaStats twoFrameStats;
+	bool bInitialised;
+};
+
+static struct FrameArenaSet gArenas;
+
+#define AlignUp(v, a) (((v) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+void Ar_InitArena(struct LinearArena* pArena, size_t capacity)
+{
+	memset(pArena, 0, sizeof(struct LinearArena));
+	pArena->capacity = AlignUp(capacity, FRAME_ARENA_ALIGNMENT);
+	pArena->pMemory = malloc(pArena->capacity);
+	EASSERT(pArena->pMemory);
+}
+
+void* Ar_Alloc(struct LinearArena* pArena, size_t size)
+{
+	size = AlignUp(size, FRAME_ARENA_ALIGNMENT);
+	pArena->numAllocations++;
+	pArena->requestedThisFrame += size;
+	if (pArena->used + size <= pArena->capacity)
+	{
+		void* p = pArena->pMemory + pArena->used;
+		pArena->used += size;
+		return p;
+	}
+	struct ArenaOverflowBlock* pBlock = malloc(sizeof(struct ArenaOverflowBlock) + size);
+	EASSERT(pBlock);
+	pBlock->pNext = pArena->pOverflow;
+	pArena->pOverflow = pBlock;
+	pArena->numHeapFallbacks++;
+	return pBlock + 1;
+}
+
+void Ar_Reset(struct LinearArena* pArena)
+{
+	if (pArena->requestedThisFrame > pArena->highWaterMark)
+	{
+		pArena->highWaterMark = pArena->requestedThisFrame;
+	}
+	bool bOverflowed = pArena->pOverflow != NULL;
+	while (pArena->pOverflow)
+	{
+		struct ArenaOverflowBlock* pNext = pArena->pOverflow->pNext;
+		free(pArena->pOverflow);
+		pArena->pOverflow = pNext;
+	}
+	if (bOverflowed)
+	{
+		/* grow so that next frame fits - nothing in the arena is live at this point */
+		/* an arena made with capacity 0 would never grow by doubling */
+		size_t newCapacity = pArena->capacity > FRAME_ARENA_ALIGNMENT ? pArena->capacity : FRAME_ARENA_ALIGNMENT;
+		while (newCapacity < pArena->highWaterMark)
+		{
+			newCapacity *= 2;
+		}
+		free(pArena->pMemory);
+		pArena->capacity = newCapacity;
+		pArena->pMemory = malloc(newCapacity);
+		EASSERT(pArena->pMemory);
+	}
+	pArena->used = 0;
+	pArena->requestedThisFrame = 0;
+	pArena->numAllocations = 0;
+	pArena->numHeapFallbacks = 0;
+}
+
+void Ar_DestroyArena(struct LinearArena* pArena)
+{
+	Ar_Reset(pArena);
+	free(pArena->pMemory);
+	memset(pArena, 0, sizeof(struct LinearArena));
+}
+
+void Ar_InitFrameArenas(size_t capacity)
+{
+	EASSERT(!gArenas.bInitialised);
+	memset(&gArenas, 0, sizeof(struct FrameArenaSet));
+	Ar_InitArena(&gArenas.frame, capacity);
+	Ar_InitArena(&gArenas.twoFrame[0], capacity);
+	Ar_InitArena(&gArenas.twoFrame[1], capacity);
+	gArenas.bInitialised = true;
+}
+
+void Ar_DestroyFrameArenas(void)
+{
+	if (!gArenas.bInitialised)
+	{
+		return;
+	}
+	Ar_DestroyArena(&gArenas.frame);
+	Ar_DestroyArena(&gArenas.twoFrame[0]);
+	Ar_DestroyArena(&gArenas.twoFrame[1]);
+	gArenas.bInitialised = false;
+}
+
+static void EnsureInitialised(void)
+{
+	/* lets code that runs without the main loop, such as the tests, use frame allocations */
+	if (!gArenas.bInitialised)
+	{
+		Ar_InitFrameArenas(FRAME_ARENA_DEFAULT_CAPACITY);
+	}
+}
+
+void* Ar_FrameAlloc(size_t size)
+{
+	EnsureInitialised();
+	return Ar_Alloc(&gArenas.frame, size);
+}
+
+void* Ar_TwoFrameAlloc(size_t size)
+{
+	EnsureInitialised();
+	return Ar_Alloc(&gArenas.twoFrame[gArenas.onTwoFrameArena], size);
+}
+
+static struct FrameArenaStats StatsBeforeReset(struct LinearArena* pArena)
+{
+	struct FrameArenaStats stats = {
+		.capacity = pArena->capacity,
+		.bytesUsedLastFrame = pArena->requestedThisFrame,
+		.highWaterMark = pArena->requestedThisFrame > pArena->highWaterMark ? pArena->requestedThisFrame : pArena->highWaterMark,
+		.allocationsLastFrame = pArena->numAllocations,
+		.heapFallbacksLastFrame = pArena->numHeapFallbacks
+	};
+	return stats;
+}
+
+void Ar_EndFrame(void)
+{
+	EnsureInitialised();
+	gArenas.frameStats = StatsBeforeReset(&gArenas.frame);
+	Ar_Reset(&gArenas.frame);
+
+	/* the arena that held last frames allocations becomes this frames, the current one is kept alive for one more frame */
+	gArenas.twoFrameStats = StatsBeforeReset(&gArenas.twoFrame[gArenas.onTwoFrameArena]);
+	gArenas.onTwoFrameArena = !gArenas.onTwoFrameArena;
+	Ar_Reset(&gArenas.twoFrame[gArenas.onTwoFrameArena]);
+}
+
+struct FrameArenaStats Ar_GetFrameArenaStats(void)
+{
+	return gArenas.frameStats;
+}
+
+struct FrameArenaStats Ar_GetTwoFrameArenaStats(void)
+{
+	return gArenas.twoFrameStats;
+}
@@ -18,4 +18,14 @@ bool Ge_AABBIntersect(vec2 tl1, vec2 br1, vec2 tl2, vec2 br2)
 
     // Collision occurs only if both axes overlap
     return xOverlap && yOverlap;
-}
\ No newline at end of file
+}
+
+bool Ge_CircleAABBIntersect(vec2 center, float radius, vec2 tl, vec2 br)
+{
+    // Closest point of the box to the centre
+    float closestX = glm_clamp(center[0], tl[0], br[0]);
+    float closestY = glm_clamp(center[1], tl[1], br[1]);
+    float dx = center[0] - closestX;
+    float dy = center[1] - closestY;
+    return dx * dx + dy * dy <= radius * radius;
+}
@@ -0,0 +1,255 @@
+#include "GlyphRunCache.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* power of 2 */
+#define GLYPH_RUN_CACHE_BUCKETS (GLYPH_RUN_CACHE_SIZE * 2)
+#define NO_ENTRY -1
+
+struct GlyphRunCacheEntry
+{
+	hAtlas atlas;
+	HFont font;
+	u64 hash;
+	/* copy of the string, not NUL terminated */
+	char* str;
+	size_t len;
+	size_t strCapacity;
+	struct GlyphRun run;
+	/* least recently used list, most recent at the head */
+	int prev;
+	int next;
+	/* chain of entries in the same bucket */
+	int nextInBucket;
+	bool bUsed;
+};
+
+static struct GlyphRunCacheEntry gEntries[GLYPH_RUN_CACHE_SIZE];
+static int gBuckets[GLYPH_RUN_CACHE_BUCKETS];
+static int gLRUHead = NO_ENTRY;
+static int gLRUTail = NO_ENTRY;
+static int gNumUsed = 0;
+static bool gbInitialised = false;
+static struct GlyphRunCacheStats gStats;
+
+static void Init()
+{
+	for (int i = 0; i < GLYPH_RUN_CACHE_BUCKETS; i++)
+	{
+		gBuckets[i] = NO_ENTRY;
+	}
+	gLRUHead = NO_ENTRY;
+	gLRUTail = NO_ENTRY;
+	gNumUsed = 0;
+	gbInitialised = true;
+}
+
+u64 GRC_HashString(const char* str, size_t len)
+{
+	/*
+		16 bytes at a time in two independent lanes so the multiplies overlap,
+		UI strings are hashed often enough that a byte at a time shows up
+	*/
+	u64 a = 0xcbf29ce484222325ull ^ (len * 0x9e3779b97f4a7c15ull);
+	u64 b = 0x84222325cbf29ce4ull;
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16)
+	{
+		u64 words[2];
+		memcpy(words, &str[i], 16);
+		a = (a ^ words[0]) * 0x9e3779b97f4a7c15ull;
+		b = (b ^ words[1]) * 0xc2b2ae3d27d4eb4full;
+		a = (a << 31) | (a >> 33);
+		b = (b << 29) | (b >> 35);
+	}
+	/* the tail is read as whole words that overlap bytes already hashed, rather than a byte at a time */
+	u64 tail[2] = { 0, 0 };
+	if (len - i > 8)
+	{
+		memcpy(&tail[0], &str[i], 8);
+		memcpy(&tail[1], &str[len - 8], 8);
+	}
+	else if (len >= 8)
+	{
+		memcpy(&tail[0], &str[len - 8], 8);
+	}
+	else
+	{
+		for (; i < len; i++)
+		{
+			tail[0] = (tail[0] << 8) | (u8)str[i];
+		}
+	}
+	a = (a ^ tail[0]) * 0x9e3779b97f4a7c15ull;
+	b = (b ^ tail[1]) * 0xc2b2ae3d27d4eb4full;
+	u64 hash = a ^ ((b << 32) | (b >> 32));
+	hash ^= hash >> 32;
+	hash *= 0xd6e8feb86659fd93ull;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+static int BucketOf(u64 hash)
+{
+	return (int)(hash & (GLYPH_RUN_CACHE_BUCKETS - 1));
+}
+
+static void LRUUnlink(int i)
+{
+	struct GlyphRunCacheEntry* pEntry = &gEntries[i];
+	if (pEntry->prev != NO_ENTRY)
+	{
+		gEntries[pEntry->prev].next = pEntry->next;
+	}
+	else
+	{
+		gLRUHead = pEntry->next;
+	}
+	if (pEntry->next != NO_ENTRY)
+	{
+		gEntries[pEntry->next].prev = pEntry->prev;
+	}
+	else
+	{
+		gLRUTail = pEntry->prev;
+	}
+	pEntry->prev = NO_ENTRY;
+	pEntry->next = NO_ENTRY;
+}
+
+static void LRUPushHead(int i)
+{
+	gEntries[i].prev = NO_ENTRY;
+	gEntries[i].next = gLRUHead;
+	if (gLRUHead != NO_ENTRY)
+	{
+		gEntries[gLRUHead].prev = i;
+	}
+	gLRUHead = i;
+	if (gLRUTail == NO_ENTRY)
+	{
+		gLRUTail = i;
+	}
+}
+
+static void BucketUnlink(int i)
+{
+	int* pLink = &gBuckets[BucketOf(gEntries[i].hash)];
+	while (*pLink != i)
+	{
+		pLink = &gEntries[*pLink].nextInBucket;
+	}
+	*pLink = gEntries[i].nextInBucket;
+	gEntries[i].nextInBucket = NO_ENTRY;
+}
+
+/* the string allocation is kept for the next run stored in the entry */
+static void RemoveEntry(int i)
+{
+	BucketUnlink(i);
+	LRUUnlink(i);
+	gEntries[i].bUsed = false;
+	gNumUsed--;
+}
+
+const struct GlyphRun* GRC_Find(hAtlas atlas, HFont font, const char* str, size_t len, u64 hash)
+{
+	if (!gbInitialised)
+	{
+		Init();
+	}
+	for (int i = gBuckets[BucketOf(hash)]; i != NO_ENTRY; i = gEntries[i].nextInBucket)
+	{
+		struct GlyphRunCacheEntry* pEntry = &gEntries[i];
+		if (pEntry->hash == hash && pEntry->atlas == atlas && pEntry->font == font &&
+			pEntry->len == len && memcmp(pEntry->str, str, len) == 0)
+		{
+			if (gLRUHead != i)
+			{
+				LRUUnlink(i);
+				LRUPushHead(i);
+			}
+			gStats.hits++;
+			return &pEntry->run;
+		}
+	}
+	gStats.misses++;
+	return NULL;
+}
+
+void GRC_Insert(hAtlas atlas, HFont font, const char* str, size_t len, u64 hash, const struct GlyphRun* pRun)
+{
+	if (!gbInitialised)
+	{
+		Init();
+	}
+	int i = NO_ENTRY;
+	if (gNumUsed == GLYPH_RUN_CACHE_SIZE)
+	{
+		i = gLRUTail;
+		RemoveEntry(i);
+		gStats.evictions++;
+	}
+	else
+	{
+		for (int j = 0; j < GLYPH_RUN_CACHE_SIZE; j++)
+		{
+			if (!gEntries[j].bUsed)
+			{
+				i = j;
+				break;
+			}
+		}
+	}
+
+	struct GlyphRunCacheEntry* pEntry = &gEntries[i];
+	if (pEntry->strCapacity < len)
+	{
+		free(pEntry->str);
+		pEntry->strCapacity = len;
+		pEntry->str = malloc(len);
+	}
+	memcpy(pEntry->str, str, len);
+	pEntry->len = len;
+	pEntry->atlas = atlas;
+	pEntry->font = font;
+	pEntry->hash = hash;
+	pEntry->run = *pRun;
+	pEntry->bUsed = true;
+	int bucket = BucketOf(hash);
+	pEntry->nextInBucket = gBuckets[bucket];
+	gBuckets[bucket] = i;
+	LRUPushHead(i);
+	gNumUsed++;
+}
+
+void GRC_InvalidateAtlas(hAtlas atlas)
+{
+	if (!gbInitialised)
+	{
+		return;
+	}
+	for (int i = 0; i < GLYPH_RUN_CACHE_SIZE; i++)
+	{
+		if (gEntries[i].bUsed && gEntries[i].atlas == atlas)
+		{
+			RemoveEntry(i);
+		}
+	}
+}
+
+void GRC_Clear()
+{
+	for (int i = 0; i < GLYPH_RUN_CACHE_SIZE; i++)
+	{
+		free(gEntries[i].str);
+	}
+	memset(gEntries, 0, sizeof(gEntries));
+	memset(&gStats, 0, sizeof(struct GlyphRunCacheStats));
+	Init();
+}
+
+struct GlyphRunCacheStats GRC_GetStats()
+{
+	return gStats;
+}
@@ -0,0 +1,148 @@
+#include "GlyphShelfPacker.h"
+#include <string.h>
+
+void GSP_Init(struct GlyphShelfPacker* pPacker, int x, int y, int width, int height, GlyphEvictedFn fnEvicted, void* pUser)
+{
+	memset(pPacker, 0, sizeof(struct GlyphShelfPacker));
+	pPacker->x = x;
+	pPacker->y = y;
+	pPacker->width = width;
+	pPacker->height = height;
+	pPacker->fnEvicted = fnEvicted;
+	pPacker->pUser = pUser;
+	pPacker->shelves = NEW_VECTOR(struct GlyphShelf);
+}
+
+void GSP_DeInit(struct GlyphShelfPacker* pPacker)
+{
+	if (!pPacker->shelves)
+	{
+		return;
+	}
+	for (int i = 0; i < VectorSize(pPacker->shelves); i++)
+	{
+		DestoryVector(pPacker->shelves[i].glyphs);
+	}
+	DestoryVector(pPacker->shelves);
+	pPacker->shelves = NULL;
+}
+
+/* the shelf with room for the glyph and the least height to spare, up to maxHeight */
+static int FindBestShelf(struct GlyphShelfPacker* pPacker, int w, int h, int maxHeight)
+{
+	int best = GLYPH_SHELF_NONE;
+	for (int i = 0; i < VectorSize(pPacker->shelves); i++)
+	{
+		struct GlyphShelf* pShelf = &pPacker->shelves[i];
+		if (pShelf->height < h || pShelf->height > maxHeight || pShelf->nextX + w > pPacker->width)
+		{
+			continue;
+		}
+		if (best == GLYPH_SHELF_NONE || pShelf->height < pPacker->shelves[best].height)
+		{
+			best = i;
+		}
+	}
+	return best;
+}
+
+static int AddShelf(struct GlyphShelfPacker* pPacker, int h)
+{
+	int height = (h + GLYPH_SHELF_HEIGHT_STEP - 1) / GLYPH_SHELF_HEIGHT_STEP * GLYPH_SHELF_HEIGHT_STEP;
+	if (pPacker->nextShelfY + height > pPacker->height)
+	{
+		/* the last shelf can be shorter than the step */
+		height = h;
+		if (pPacker->nextShelfY + height > pPacker->height)
+		{
+			return GLYPH_SHELF_NONE;
+		}
+	}
+	struct GlyphShelf shelf;
+	memset(&shelf, 0, sizeof(struct GlyphShelf));
+	shelf.y = pPacker->nextShelfY;
+	shelf.height = height;
+	shelf.glyphs = NEW_VECTOR(u64);
+	pPacker->shelves = VectorPush(pPacker->shelves, &shelf);
+	pPacker->nextShelfY += height;
+	return VectorSize(pPacker->shelves) - 1;
+}
+
+static int EvictLeastRecentlyUsedShelf(struct GlyphShelfPacker* pPacker, int h, u32 frame)
+{
+	int lru = GLYPH_SHELF_NONE;
+	for (int i = 0; i < VectorSize(pPacker->shelves); i++)
+	{
+		struct GlyphShelf* pShelf = &pPacker->shelves[i];
+		if (pShelf->height < h || pShelf->lastUsedFrame == frame)
+		{
+			continue;
+		}
+		if (lru == GLYPH_SHELF_NONE || pShelf->lastUsedFrame < pPacker->shelves[lru].lastUsedFrame)
+		{
+			lru = i;
+		}
+	}
+	if (lru == GLYPH_SHELF_NONE)
+	{
+		return GLYPH_SHELF_NONE;
+	}
+	struct GlyphShelf* pShelf = &pPacker->shelves[lru];
+	for (int i = 0; i < VectorSize(pShelf->glyphs); i++)
+	{
+		pPacker->fnEvicted(pPacker->pUser, pShelf->glyphs[i]);
+	}
+	pPacker->numEvictedShelves++;
+	pPacker->numEvictedGlyphs += VectorSize(pShelf->glyphs);
+	pShelf->glyphs = VectorClear(pShelf->glyphs);
+	pShelf->nextX = 0;
+	return lru;
+}
+
+int GSP_Alloc(struct GlyphShelfPacker* pPacker, int w, int h, u32 frame, u64 glyph, int* pOutX, int* pOutY)
+{
+	if (w > pPacker->width || h > pPacker->height)
+	{
+		return GLYPH_SHELF_NONE;
+	}
+	/* don't waste a tall shelf on a short glyph while there's room for a new shelf */
+	int shelf = FindBestShelf(pPacker, w, h, h + h / 2 + GLYPH_SHELF_HEIGHT_STEP);
+	if (shelf == GLYPH_SHELF_NONE)
+	{
+		shelf = AddShelf(pPacker, h);
+	}
+	if (shelf == GLYPH_SHELF_NONE)
+	{
+		shelf = FindBestShelf(pPacker, w, h, pPacker->height);
+	}
+	if (shelf == GLYPH_SHELF_NONE)
+	{
+		shelf = EvictLeastRecentlyUsedShelf(pPacker, h, frame);
+	}
+	if (shelf == GLYPH_SHELF_NONE)
+	{
+		return GLYPH_SHELF_NONE;
+	}
+	struct GlyphShelf* pShelf = &pPacker->shelves[shelf];
+	*pOutX = pPacker->x + pShelf->nextX;
+	*pOutY = pPacker->y + pShelf->y;
+	pShelf->nextX += w;
+	pShelf->lastUsedFrame = frame;
+	pShelf->glyphs = VectorPush(pShelf->glyphs, &glyph);
+	return shelf;
+}
+
+void GSP_Touch(struct GlyphShelfPacker* pPacker, int shelf, u32 frame)
+{
+	pPacker->shelves[shelf].lastUsedFrame = frame;
+}
+
+void GSP_Clear(struct GlyphShelfPacker* pPacker)
+{
+	for (int i = 0; i < VectorSize(pPacker->shelves); i++)
+	{
+		DestoryVector(pPacker->shelves[i].glyphs);
+	}
+	pPacker->shelves = VectorClear(pPacker->shelves);
+	pPacker->nextShelfY = 0;
+}
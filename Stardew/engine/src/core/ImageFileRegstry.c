@@ -4,15 +4,48 @@
 #include <string.h>
 #include "cJSON.h"
 #include "FileHelpers.h"
+#include "StringKeyHashMap.h"
+#include "WorkerPool.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
+#define IMAGE_REGISTRY_DEFAULT_PATH "./Assets/ImageFiles.json"
+#define IMAGE_REGISTRY_MAX_ROOT_LEN 256
+
 static VECTOR(struct ImageFile) gImageFiles;
 
+/* the folder the registry json is in, registered paths are relative to it */
+static char gRegistryRoot[IMAGE_REGISTRY_MAX_ROOT_LEN] = "./Assets/";
+
+/* path -> HImage */
+static struct HashMap gPathIndex;
+
+/* created by the first IR_LoadImageAsync */
+static struct WorkerPool* gpDecodePool = NULL;
+static int gNumDecodeThreads = 0;
+
+struct ImageDecodeJob
+{
+    HImage hImage;
+    /* owned by the registry, the decode thread only reads it */
+    const char* path;
+    u8* pData;
+    int width, height;
+};
+
+struct ImageLoadWaiter
+{
+    HImage hImage;
+    ImageLoadedFn onLoaded;
+    void* pUser;
+};
+
+static VECTOR(struct ImageLoadWaiter) gLoadWaiters;
+
 HImage IR_RegisterImagePath(const char* path)
 {
-    const char* assetsFolderPath = "./Assets/";
+    const char* assetsFolderPath = gRegistryRoot;
     HImage i = NULL_HIMAGE;
     struct ImageFile imagef;
     memset(&imagef, 0, sizeof(struct ImageFile));
@@ -26,19 +59,23 @@ HImage IR_RegisterImagePath(const char* path)
     sprintf(imagef.path, "%s%s", assetsFolderPath, path);
     gImageFiles = VectorPush(gImageFiles, &imagef);
     i = VectorSize(gImageFiles) - 1;
+    /* a path registered twice keeps looking up the first */
+    if (!HashmapSearch(&gPathIndex, imagef.path))
+    {
+        HashmapInsert(&gPathIndex, imagef.path, &i);
+    }
     return i;
 }
 
 HImage IR_LookupHandleByPath(const char* path)
 {
-    for (int i = 0; i < VectorSize(gImageFiles); i++)
-    {
-        if (strcmp(gImageFiles[i].path, path) == 0)
-        {
-            return i;
-        }
-    }
-    return NULL_HIMAGE;
+    HImage* pHandle = HashmapSearch(&gPathIndex, path);
+    return pHandle ? *pHandle : NULL_HIMAGE;
+}
+
+int IR_GetNumImages()
+{
+    return VectorSize(gImageFiles);
 }
 
 bool IR_IsImageLoaded(HImage hImage)
@@ -58,6 +95,10 @@ u8* IR_GetImageData(HImage img)
         printf("IR_GetImageData hImage %i out of range", img);
         return NULL;
     }
+    if (gImageFiles[img].bLoading)
+    {
+        IR_WaitForImage(img);
+    }
     if (!gImageFiles[img].bLoaded)
     {
         VECTOR(struct ImageLoadError) errors = NEW_VECTOR(struct ImageLoadError);
@@ -95,37 +136,250 @@ bool IR_LoadImageSync(HImage hImage, VECTOR(struct ImageLoadError) outErrors)
         printf("IR_LoadImageSync hImage %i out of range", hImage);
         return false;
     }
+    if (gImageFiles[hImage].bLoading)
+    {
+        return IR_WaitForImage(hImage);
+    }
     struct ImageFile* pIF = &gImageFiles[hImage];
     if (pIF->bLoaded)
     {
         printf("Image %i already loaded!", hImage);
         return false;
     }
-    //stbi_set_flip_vertically_on_load(true);
-    int x, y, n;
-    u8* data = stbi_load(pIF->path, &x, &y, &n, 4);
+    int x, y;
+    u8* data = IR_DecodeImageFile(pIF->path, &x, &y);
     if (!data)
     {
         printf("IR_LoadImageSync stbi_load failed");
+        pIF->bLoadFailed = true;
         return false;
     }
     pIF->pData = data;
     pIF->height = y;
     pIF->width = x;
+    pIF->bLoaded = true;
+    pIF->bLoadFailed = false;
 
     return true;
 }
 
+u8* IR_DecodeImageFile(const char* path, int* pOutWidth, int* pOutHeight)
+{
+    //stbi_set_flip_vertically_on_load(true);
+    int n;
+    return stbi_load(path, pOutWidth, pOutHeight, &n, CHANNELS_PER_PIXEL);
+}
+
+void IR_FreeDecodedImage(u8* pData)
+{
+    stbi_image_free(pData);
+}
+
+void IR_UnloadImage(HImage hImage)
+{
+    if (hImage >= VectorSize(gImageFiles))
+    {
+        printf("IR_UnloadImage hImage %i out of range", hImage);
+        return;
+    }
+    if (gImageFiles[hImage].bLoading)
+    {
+        IR_WaitForImage(hImage);
+    }
+    struct ImageFile* pIF = &gImageFiles[hImage];
+    if (pIF->bLoaded)
+    {
+        stbi_image_free(pIF->pData);
+        pIF->pData = NULL;
+        pIF->bLoaded = false;
+    }
+}
+
+static void DecodeImageJob(void* pArg)
+{
+    struct ImageDecodeJob* pJob = pArg;
+    pJob->pData = IR_DecodeImageFile(pJob->path, &pJob->width, &pJob->height);
+}
+
+/* main thread, from WP_RunCompleted */
+static void FinishImageJob(void* pArg)
+{
+    struct ImageDecodeJob* pJob = pArg;
+    struct ImageFile* pIF = &gImageFiles[pJob->hImage];
+    pIF->bLoading = false;
+    if (pJob->pData)
+    {
+        pIF->pData = pJob->pData;
+        pIF->width = pJob->width;
+        pIF->height = pJob->height;
+        pIF->bLoaded = true;
+        pIF->bLoadFailed = false;
+    }
+    else
+    {
+        printf("IR_LoadImageAsync failed to load %s\n", pIF->path);
+        pIF->bLoadFailed = true;
+    }
+    free(pJob);
+}
+
+static void StopDecodeThreads()
+{
+    if (gpDecodePool)
+    {
+        WP_WaitIdle(gpDecodePool);
+        WP_RunCompleted(gpDecodePool);
+        WP_Destroy(gpDecodePool);
+        gpDecodePool = NULL;
+    }
+}
+
+void IR_SetNumDecodeThreads(int numThreads)
+{
+    StopDecodeThreads();
+    gNumDecodeThreads = numThreads;
+}
+
+bool IR_LoadImageAsync(HImage hImage, ImageLoadedFn onLoaded, void* pUser)
+{
+    if (hImage >= VectorSize(gImageFiles))
+    {
+        printf("IR_LoadImageAsync hImage %i out of range", hImage);
+        return false;
+    }
+    if (onLoaded)
+    {
+        struct ImageLoadWaiter waiter = { hImage, onLoaded, pUser };
+        gLoadWaiters = VectorPush(gLoadWaiters, &waiter);
+    }
+    struct ImageFile* pIF = &gImageFiles[hImage];
+    if (pIF->bLoaded || pIF->bLoading)
+    {
+        return true;
+    }
+    if (!gpDecodePool)
+    {
+        gpDecodePool = WP_Create(gNumDecodeThreads);
+    }
+    struct ImageDecodeJob* pJob = malloc(sizeof(struct ImageDecodeJob));
+    memset(pJob, 0, sizeof(struct ImageDecodeJob));
+    pJob->hImage = hImage;
+    pJob->path = pIF->path;
+    pIF->bLoading = true;
+    WP_SubmitWithCompletion(gpDecodePool, &DecodeImageJob, &FinishImageJob, pJob);
+    return true;
+}
+
+enum ImageLoadState IR_GetImageLoadState(HImage hImage)
+{
+    if (hImage >= VectorSize(gImageFiles))
+    {
+        printf("IR_GetImageLoadState hImage %i out of range", hImage);
+        return ILS_Failed;
+    }
+    const struct ImageFile* pIF = &gImageFiles[hImage];
+    if (pIF->bLoading)
+    {
+        return ILS_Loading;
+    }
+    if (pIF->bLoaded)
+    {
+        return ILS_Loaded;
+    }
+    return pIF->bLoadFailed ? ILS_Failed : ILS_Unloaded;
+}
+
+bool IR_WaitForImage(HImage hImage)
+{
+    if (hImage >= VectorSize(gImageFiles))
+    {
+        printf("IR_WaitForImage hImage %i out of range", hImage);
+        return false;
+    }
+    while (gImageFiles[hImage].bLoading)
+    {
+        WP_WaitCompleted(gpDecodePool);
+        WP_RunCompleted(gpDecodePool);
+    }
+    return gImageFiles[hImage].bLoaded;
+}
+
+void IR_WaitForAllImages()
+{
+    if (gpDecodePool)
+    {
+        WP_WaitIdle(gpDecodePool);
+        WP_RunCompleted(gpDecodePool);
+    }
+}
+
+void IR_PollImageLoads()
+{
+    if (gpDecodePool)
+    {
+        WP_RunCompleted(gpDecodePool);
+    }
+    int numWaiters = VectorSize(gLoadWaiters);
+    if (numWaiters == 0)
+    {
+        return;
+    }
+    /* copied out first, a callback can start another load */
+    struct ImageLoadWaiter* pWaiters = malloc(sizeof(struct ImageLoadWaiter) * numWaiters);
+    memcpy(pWaiters, gLoadWaiters, sizeof(struct ImageLoadWaiter) * numWaiters);
+    gLoadWaiters = VectorClear(gLoadWaiters);
+    int numFinished = 0;
+    for (int i = 0; i < numWaiters; i++)
+    {
+        if (gImageFiles[pWaiters[i].hImage].bLoading)
+        {
+            gLoadWaiters = VectorPush(gLoadWaiters, &pWaiters[i]);
+        }
+        else
+        {
+            pWaiters[numFinished++] = pWaiters[i];
+        }
+    }
+    for (int i = 0; i < numFinished; i++)
+    {
+        const struct ImageLoadWaiter* pWaiter = &pWaiters[i];
+        pWaiter->onLoaded(pWaiter->hImage, gImageFiles[pWaiter->hImage].bLoaded, pWaiter->pUser);
+    }
+    free(pWaiters);
+}
+
+static void SetRegistryRoot(const char* jsonPath)
+{
+    const char* pLastSlash = strrchr(jsonPath, '/');
+    const char* pLastBackslash = strrchr(jsonPath, '\\');
+    if (pLastBackslash && (!pLastSlash || pLastBackslash > pLastSlash))
+    {
+        pLastSlash = pLastBackslash;
+    }
+    size_t rootLen = pLastSlash ? (size_t)(pLastSlash - jsonPath) + 1 : 0;
+    if (rootLen >= IMAGE_REGISTRY_MAX_ROOT_LEN)
+    {
+        printf("IR_InitImageRegistry registry path %s too long", jsonPath);
+        rootLen = 0;
+    }
+    memcpy(gRegistryRoot, jsonPath, rootLen);
+    gRegistryRoot[rootLen] = '\0';
+}
+
 void IR_InitImageRegistry(const char* jsonPath)
 {
+    StopDecodeThreads();
     gImageFiles = NEW_VECTOR(struct ImageFile);
-    int size = 0;
-    char* data = jsonPath;
+    gLoadWaiters = NEW_VECTOR(struct ImageLoadWaiter);
+    HashmapInit(&gPathIndex, 64, sizeof(HImage));
     if (jsonPath == NULL)
     {
-        data = LoadFile("./Assets/ImageFiles.json", &size);
+        jsonPath = IMAGE_REGISTRY_DEFAULT_PATH;
     }
-    
+    SetRegistryRoot(jsonPath);
+    int size = 0;
+    char* data = LoadFile(jsonPath, &size);
+
     if (!data)
     {
         printf("IR_InitImageRegistry can't load config file");
@@ -154,13 +408,16 @@ void IR_InitImageRegistry(const char* jsonPath)
 
 void IR_DestroyImageRegistry()
 {
+    StopDecodeThreads();
     for (int i = 0; i < VectorSize(gImageFiles); i++)
     {
         if (gImageFiles[i].bLoaded)
         {
-            stbi_image_free(gImageFiles->pData);
+            stbi_image_free(gImageFiles[i].pData);
         }
         free(gImageFiles[i].path);
     }
     DestoryVector(gImageFiles);
+    DestoryVector(gLoadWaiters);
+    HashmapDeInit(&gPathIndex);
 }
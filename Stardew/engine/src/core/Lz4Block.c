@@ -0,0 +1,226 @@
+#include "Lz4Block.h"
+#include <string.h>
+#include <stdbool.h>
+#include "AssertLib.h"
+
+#define LZ_MIN_MATCH 4
+/* the last 5 bytes of a block are always literals */
+#define LZ_LAST_LITERALS 5
+/* and the last match starts at least 12 bytes before the end */
+#define LZ_MF_LIMIT 12
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+
+static u32 Read32(const u8* p)
+{
+	u32 v;
+	memcpy(&v, p, sizeof(u32));
+	return v;
+}
+
+static u32 Hash(u32 sequence)
+{
+	return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* lengths of 15 or more continue in extra bytes after the token's nibble */
+static u8* WriteLength(u8* op, size_t len)
+{
+	while (len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (u8)len;
+	return op;
+}
+
+static u8* WriteLiterals(u8* op, u8* pToken, const u8* src, size_t len)
+{
+	*pToken = (u8)((len >= 15 ? 15 : len) << 4);
+	if (len >= 15)
+	{
+		op = WriteLength(op, len - 15);
+	}
+	if (len == 0)
+	{
+		/* src is NULL when compressing empty input */
+		return op;
+	}
+	memcpy(op, src, len);
+	return op + len;
+}
+
+size_t Lz_CompressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t Lz_CompressBlock(const u8* src, size_t srcSize, u8* dst, size_t dstCapacity)
+{
+	if (dstCapacity < Lz_CompressBound(srcSize))
+	{
+		return 0;
+	}
+	EASSERT(srcSize < 0x7fffffff);
+
+	i32 table[LZ_HASH_SIZE];
+	memset(table, 0xff, sizeof(table));
+
+	u8* op = dst;
+	size_t anchor = 0;
+	if (srcSize > LZ_MF_LIMIT)
+	{
+		size_t matchLimit = srcSize - LZ_LAST_LITERALS;
+		size_t mfLimit = srcSize - LZ_MF_LIMIT;
+		size_t ip = 0;
+		while (ip < mfLimit)
+		{
+			u32 sequence = Read32(src + ip);
+			u32 h = Hash(sequence);
+			i64 ref = table[h];
+			table[h] = (i32)ip;
+			if (ref < 0 || ip - ref > LZ_MAX_OFFSET || Read32(src + ref) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			/* extend the match backwards into the pending literals, then forwards */
+			while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+			{
+				ip--;
+				ref--;
+			}
+			size_t len = LZ_MIN_MATCH;
+			while (ip + len < matchLimit && src[ip + len] == src[ref + len])
+			{
+				len++;
+			}
+
+			u8* pToken = op++;
+			op = WriteLiterals(op, pToken, src + anchor, ip - anchor);
+			size_t offset = ip - ref;
+			*op++ = (u8)(offset & 0xff);
+			*op++ = (u8)(offset >> 8);
+			size_t extraLen = len - LZ_MIN_MATCH;
+			*pToken |= (u8)(extraLen >= 15 ? 15 : extraLen);
+			if (extraLen >= 15)
+			{
+				op = WriteLength(op, extraLen - 15);
+			}
+
+			ip += len;
+			anchor = ip;
+			/* the hash of a position in the match helps find the next one */
+			if (ip - 2 < mfLimit)
+			{
+				table[Hash(Read32(src + ip - 2))] = (i32)(ip - 2);
+			}
+		}
+	}
+
+	u8* pToken = op++;
+	op = WriteLiterals(op, pToken, src + anchor, srcSize - anchor);
+	return op - dst;
+}
+
+static bool ReadLength(const u8** pIP, const u8* iend, size_t* pLen)
+{
+	const u8* ip = *pIP;
+	u8 b;
+	do
+	{
+		if (ip >= iend)
+		{
+			return false;
+		}
+		b = *ip++;
+		*pLen += b;
+	} while (b == 255);
+	*pIP = ip;
+	return true;
+}
+
+i64 Lz_DecompressBlock(const u8* src, size_t srcSize, u8* dst, size_t dstCapacity)
+{
+	const u8* ip = src;
+	const u8* iend = src + srcSize;
+	u8* op = dst;
+	u8* oend = dst + dstCapacity;
+	while (ip < iend)
+	{
+		u8 token = *ip++;
+		size_t litLen = token >> 4;
+		if (litLen == 15 && !ReadLength(&ip, iend, &litLen))
+		{
+			return -1;
+		}
+		if (litLen > (size_t)(iend - ip) || litLen > (size_t)(oend - op))
+		{
+			return -1;
+		}
+		if (litLen <= 16 && iend - ip >= 16 && oend - op >= 16)
+		{
+			/* a fixed size copy is a couple of instructions, the extra bytes are overwritten later */
+			memcpy(op, ip, 16);
+		}
+		else
+		{
+			memcpy(op, ip, litLen);
+		}
+		op += litLen;
+		ip += litLen;
+		if (ip == iend)
+		{
+			/* the last sequence is only literals */
+			break;
+		}
+
+		if (iend - ip < 2)
+		{
+			return -1;
+		}
+		size_t offset = ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst))
+		{
+			return -1;
+		}
+		size_t matchLen = token & 15;
+		if (matchLen == 15 && !ReadLength(&ip, iend, &matchLen))
+		{
+			return -1;
+		}
+		matchLen += LZ_MIN_MATCH;
+		if (matchLen > (size_t)(oend - op))
+		{
+			return -1;
+		}
+
+		/*
+			the match can overlap what it's writing (a run), copy it in pieces that don't:
+			each piece is a whole number of periods so the next can be twice the size
+		*/
+		const u8* match = op - offset;
+		if (offset >= 16 && matchLen <= 32 && oend - op >= 32)
+		{
+			memcpy(op, match, 16);
+			memcpy(op + 16, match + 16, 16);
+			op += matchLen;
+			continue;
+		}
+		size_t copied = 0;
+		while (copied < matchLen)
+		{
+			size_t n = matchLen - copied;
+			size_t available = offset + copied;
+			n = n > available ? available : n;
+			memcpy(op + copied, match, n);
+			copied += n;
+		}
+		op += matchLen;
+	}
+	return op - dst;
+}
@@ -0,0 +1,108 @@
+#include "MappedFile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct MappedFile
+{
+	void* pData;
+	size_t size;
+};
+
+struct MappedFile* MappedFile_Open(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	void* pData = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* the mapping keeps its own reference to the file */
+	close(fd);
+	if (pData == MAP_FAILED)
+	{
+		return NULL;
+	}
+	struct MappedFile* pFile = malloc(sizeof(struct MappedFile));
+	pFile->pData = pData;
+	pFile->size = (size_t)st.st_size;
+	return pFile;
+}
+
+void MappedFile_Close(struct MappedFile* pFile)
+{
+	munmap(pFile->pData, pFile->size);
+	free(pFile);
+}
+
+#elif defined(_WIN32)
+
+#include <windows.h>
+
+struct MappedFile
+{
+	void* pData;
+	size_t size;
+};
+
+struct MappedFile* MappedFile_Open(const char* path)
+{
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(hFile);
+		return NULL;
+	}
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (!hMapping)
+	{
+		return NULL;
+	}
+	/* the view keeps the mapping object alive */
+	void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping);
+	if (!pData)
+	{
+		return NULL;
+	}
+	struct MappedFile* pFile = malloc(sizeof(struct MappedFile));
+	pFile->pData = pData;
+	pFile->size = (size_t)size.QuadPart;
+	return pFile;
+}
+
+void MappedFile_Close(struct MappedFile* pFile)
+{
+	UnmapViewOfFile(pFile->pData);
+	free(pFile);
+}
+
+#endif
+
+const void* MappedFile_GetData(const struct MappedFile* pFile)
+{
+	return pFile->pData;
+}
+
+size_t MappedFile_GetSize(const struct MappedFile* pFile)
+{
+	return pFile->size;
+}
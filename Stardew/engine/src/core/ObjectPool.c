@@ -6,35 +6,124 @@
 #include <assert.h>
 #include "IntTypes.h"
 
+/*
+	Memory layout of a pool, all one allocation:
 
-void* InitObjectPool(int objectSize, int poolInitialSize)
+	| ObjectPoolData | objects[capacity] | pad | free indices[capacity] | pad | occupancy bits[capacity / 64] | generations[capacity] |
+
+	The pads round the u64 arrays up to u64 alignment.
+
+	The generations array is only present for generational pools.
+*/
+
+#define OccupancyWords(capacity) (((capacity) + 63) / 64)
+#define AlignUp(v, a) (((v) + ((a) - 1)) & ~((size_t)(a) - 1))
+#define U64_ALIGNMENT sizeof(u64)
+
+static size_t FreeIndicesOffset(i64 objectSize, i64 capacity)
+{
+	return AlignUp(sizeof(struct ObjectPoolData) + objectSize * capacity, U64_ALIGNMENT);
+}
+
+static size_t OccupancyBitsOffset(i64 objectSize, i64 capacity)
+{
+	return AlignUp(FreeIndicesOffset(objectSize, capacity) + sizeof(u64) * capacity, U64_ALIGNMENT);
+}
+
+static size_t PoolAllocSize(i64 objectSize, i64 capacity, bool bGenerational)
+{
+	size_t size = OccupancyBitsOffset(objectSize, capacity)
+		+ sizeof(u64) * OccupancyWords(capacity);
+	if (bGenerational)
+	{
+		size += sizeof(u16) * capacity;
+	}
+	return size;
+}
+
+static void SetPoolPointers(struct ObjectPoolData* pData, bool bGenerational)
+{
+	char* pBase = (char*)pData;
+	pData->freeObjectIndicessArray = (u64*)(pBase + FreeIndicesOffset(pData->objectSize, pData->capacity));
+	pData->occupancyBits = (u64*)(pBase + OccupancyBitsOffset(pData->objectSize, pData->capacity));
+	pData->generations = bGenerational ? (u16*)(pData->occupancyBits + OccupancyWords(pData->capacity)) : NULL;
+}
+
+static bool IsOccupied(struct ObjectPoolData* pData, i64 index)
 {
-	struct ObjectPoolData* pAlloc = malloc(objectSize * poolInitialSize + poolInitialSize * sizeof(u64) + sizeof(struct ObjectPoolData));
+	return (pData->occupancyBits[index >> 6] >> (index & 63)) & 1;
+}
+
+static void SetOccupied(struct ObjectPoolData* pData, i64 index, bool bOccupied)
+{
+	if (bOccupied)
+	{
+		pData->occupancyBits[index >> 6] |= (1ull << (index & 63));
+	}
+	else
+	{
+		pData->occupancyBits[index >> 6] &= ~(1ull << (index & 63));
+	}
+}
+
+static void* InitObjectPoolBase(int objectSize, int poolInitialSize, bool bGenerational)
+{
+	struct ObjectPoolData* pAlloc = malloc(PoolAllocSize(objectSize, poolInitialSize, bGenerational));
 	if (!pAlloc) { assert(false); return NULL; }
-	pAlloc->freeObjectIndicessArray = (u64*)((char*)pAlloc + sizeof(struct ObjectPoolData) + poolInitialSize * objectSize);
 	pAlloc->capacity = poolInitialSize;
 	pAlloc->freeObjectsArraySize = 0;
 	pAlloc->objectSize = objectSize;
+	SetPoolPointers(pAlloc, bGenerational);
 	for (int i = 0; i < poolInitialSize; i++)
 	{
 		pAlloc->freeObjectIndicessArray[pAlloc->freeObjectsArraySize++] = i;
 	}
+	memset(pAlloc->occupancyBits, 0, sizeof(u64) * OccupancyWords(poolInitialSize));
+	if (bGenerational)
+	{
+		memset(pAlloc->generations, 0, sizeof(u16) * poolInitialSize);
+	}
 	return pAlloc + 1;
 }
 
+void* InitObjectPool(int objectSize, int poolInitialSize)
+{
+	return InitObjectPoolBase(objectSize, poolInitialSize, false);
+}
+
+void* InitGenerationalObjectPool(int objectSize, int poolInitialSize)
+{
+	assert(poolInitialSize <= OBJECT_POOL_MAX_GENERATIONAL_CAPACITY);
+	return InitObjectPoolBase(objectSize, poolInitialSize, true);
+}
 
 void* DoubleObjectPoolSize(void* pObjectPool)
 {
 	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
 	assert(pData->freeObjectsArraySize == 0);
-	int oldCapacity = pData->capacity;
-	pData->capacity *= 2;
-	struct ObjectPoolData* pNewData = malloc(pData->objectSize * pData->capacity + sizeof(u64) * pData->capacity + sizeof(struct ObjectPoolData));
-	memcpy(pNewData, pData, pData->objectSize * pData->capacity + sizeof(struct ObjectPoolData));
-	pNewData->freeObjectIndicessArray = (u64*)((char*)pNewData + sizeof(struct ObjectPoolData) + pData->capacity * pData->objectSize);
-	memcpy(pNewData->freeObjectIndicessArray, pData->freeObjectIndicessArray, pData->freeObjectsArraySize * sizeof(u64));
+	bool bGenerational = pData->generations != NULL;
+	i64 oldCapacity = pData->capacity;
+	i64 newCapacity = oldCapacity * 2;
+	if (bGenerational)
+	{
+		assert(newCapacity <= OBJECT_POOL_MAX_GENERATIONAL_CAPACITY);
+	}
+	struct ObjectPoolData* pNewData = malloc(PoolAllocSize(pData->objectSize, newCapacity, bGenerational));
+	if (!pNewData) { assert(false); return NULL; }
+	memcpy(pNewData, pData, sizeof(struct ObjectPoolData) + pData->objectSize * oldCapacity);
+	pNewData->capacity = newCapacity;
+	SetPoolPointers(pNewData, bGenerational);
+
+	/* the pool is full so every old slot is occupied */
+	memset(pNewData->occupancyBits, 0, sizeof(u64) * OccupancyWords(newCapacity));
+	memcpy(pNewData->occupancyBits, pData->occupancyBits, sizeof(u64) * OccupancyWords(oldCapacity));
+	if (bGenerational)
+	{
+		memcpy(pNewData->generations, pData->generations, sizeof(u16) * oldCapacity);
+		memset(pNewData->generations + oldCapacity, 0, sizeof(u16) * (newCapacity - oldCapacity));
+	}
 
-	for(int i=oldCapacity; i < pData->capacity; i++)
+	for (i64 i = oldCapacity; i < newCapacity; i++)
 	{
 		pNewData->freeObjectIndicessArray[pNewData->freeObjectsArraySize++] = i;
 	}
@@ -55,6 +144,7 @@ void* GetObjectPoolIndex(void* pObjectPool, int* pOutIndex)
 	}
 	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
 	*pOutIndex = pData->freeObjectIndicessArray[--pData->freeObjectsArraySize];
+	SetOccupied(pData, *pOutIndex, true);
 	return pObjectPool;
 }
 
@@ -66,19 +156,73 @@ void FreeObjectPoolIndex(void* pObjectPool, int indexToFree)
 		printf("index '%i' out of range", indexToFree);
 		return;
 	}
-	for (int i = 0; i < pData->freeObjectsArraySize; i++)
+	if (!IsOccupied(pData, indexToFree))
 	{
-		if (pData->freeObjectIndicessArray[i] == indexToFree)
-		{
-			printf("index '%i' already free!\n", indexToFree);
-			return;
-		}
+		printf("index '%i' already free!\n", indexToFree);
+		return;
+	}
+	SetOccupied(pData, indexToFree, false);
+	if (pData->generations)
+	{
+		pData->generations[indexToFree] = (pData->generations[indexToFree] + 1) & OBJECT_POOL_HANDLE_GENERATION_MASK;
 	}
 	pData->freeObjectIndicessArray[pData->freeObjectsArraySize++] = indexToFree;
 }
 
+/// <summary>
+/// returns the object pool, possibly resized.
+/// returns a handle packing the index and the slots current generation through pOutHandle
+/// </summary>
+void* GetObjectPoolHandle(void* pObjectPool, HGeneric* pOutHandle)
+{
+	int index = 0;
+	pObjectPool = GetObjectPoolIndex(pObjectPool, &index);
+	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
+	assert(pData->generations);
+	*pOutHandle = ((HGeneric)pData->generations[index] << OBJECT_POOL_HANDLE_INDEX_BITS) | index;
+	return pObjectPool;
+}
+
+bool ObjectPoolHandleValid(void* pObjectPool, HGeneric handle)
+{
+	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
+	assert(pData->generations);
+	if (handle < 0)
+	{
+		return false;
+	}
+	int index = ObjectPoolHandleIndex(handle);
+	if (index >= pData->capacity)
+	{
+		return false;
+	}
+	return IsOccupied(pData, index) && pData->generations[index] == ObjectPoolHandleGeneration(handle);
+}
+
+bool FreeObjectPoolHandle(void* pObjectPool, HGeneric handle)
+{
+	if (!ObjectPoolHandleValid(pObjectPool, handle))
+	{
+		printf("handle '%i' is stale or already free!\n", handle);
+		return false;
+	}
+	FreeObjectPoolIndex(pObjectPool, ObjectPoolHandleIndex(handle));
+	return true;
+}
+
+bool ObjectPoolIndexOccupied(void* pObjectPool, int index)
+{
+	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
+	if (index < 0 || index >= pData->capacity)
+	{
+		return false;
+	}
+	return IsOccupied(pData, index);
+}
+
 void* FreeObjectPool(void* pObjectPool)
 {
 	struct ObjectPoolData* pData = ((struct ObjectPoolData*)pObjectPool) - 1;
 	free(pData);
-}
\ No newline at end of file
+	return NULL;
+}
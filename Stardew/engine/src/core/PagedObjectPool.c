@@ -0,0 +1,116 @@
+#include "PagedObjectPool.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "AssertLib.h"
+
+#define BLOCK_TABLE_INITIAL_CAPACITY 8
+
+static int BlockSize(struct PagedObjectPool* pPool)
+{
+	return 1 << pPool->blockShift;
+}
+
+static u64* BlockOccupancy(struct PagedObjectPool* pPool, int block)
+{
+	return (u64*)(pPool->ppBlocks[block] + (size_t)BlockSize(pPool) * pPool->objectStride);
+}
+
+static i32* FreeLink(struct PagedObjectPool* pPool, int index)
+{
+	return PagedObjectPoolAt(i32, pPool, index);
+}
+
+static void AddBlock(struct PagedObjectPool* pPool)
+{
+	if (pPool->numBlocks == pPool->blockTableCapacity)
+	{
+		/* only the table of block pointers is reallocated, never the blocks themselves */
+		pPool->blockTableCapacity *= 2;
+		pPool->ppBlocks = realloc(pPool->ppBlocks, sizeof(char*) * pPool->blockTableCapacity);
+		EASSERT(pPool->ppBlocks);
+	}
+	int blockSize = BlockSize(pPool);
+	size_t occupancySize = sizeof(u64) * ((blockSize + 63) / 64);
+	char* pBlock = malloc((size_t)blockSize * pPool->objectStride + occupancySize);
+	EASSERT(pBlock);
+	int block = pPool->numBlocks++;
+	pPool->ppBlocks[block] = pBlock;
+	memset(BlockOccupancy(pPool, block), 0, occupancySize);
+
+	/* link the new slots so the lowest index is handed out first */
+	int first = block << pPool->blockShift;
+	for (int i = blockSize - 1; i >= 0; i--)
+	{
+		*FreeLink(pPool, first + i) = pPool->freeListHead;
+		pPool->freeListHead = first + i;
+	}
+}
+
+struct PagedObjectPool* InitPagedObjectPool(int objectSize, int blockShift)
+{
+	EASSERT(blockShift > 0 && blockShift < 24);
+	struct PagedObjectPool* pPool = malloc(sizeof(struct PagedObjectPool));
+	EASSERT(pPool);
+	pPool->objectStride = objectSize < (int)sizeof(i32) ? (int)sizeof(i32) : objectSize;
+	pPool->blockShift = blockShift;
+	pPool->blockMask = (1 << blockShift) - 1;
+	pPool->numBlocks = 0;
+	pPool->blockTableCapacity = BLOCK_TABLE_INITIAL_CAPACITY;
+	pPool->numAllocated = 0;
+	pPool->freeListHead = -1;
+	pPool->ppBlocks = malloc(sizeof(char*) * pPool->blockTableCapacity);
+	AddBlock(pPool);
+	return pPool;
+}
+
+int GetPagedObjectPoolIndex(struct PagedObjectPool* pPool)
+{
+	if (pPool->freeListHead < 0)
+	{
+		AddBlock(pPool);
+	}
+	int index = pPool->freeListHead;
+	pPool->freeListHead = *FreeLink(pPool, index);
+	BlockOccupancy(pPool, index >> pPool->blockShift)[(index & pPool->blockMask) >> 6] |= 1ull << (index & 63);
+	pPool->numAllocated++;
+	return index;
+}
+
+bool PagedObjectPoolIndexOccupied(struct PagedObjectPool* pPool, int index)
+{
+	if (index < 0 || index >= PagedObjectPoolCapacity(pPool))
+	{
+		return false;
+	}
+	return (BlockOccupancy(pPool, index >> pPool->blockShift)[(index & pPool->blockMask) >> 6] >> (index & 63)) & 1;
+}
+
+void FreePagedObjectPoolIndex(struct PagedObjectPool* pPool, int indexToFree)
+{
+	if (indexToFree < 0 || indexToFree >= PagedObjectPoolCapacity(pPool))
+	{
+		printf("index '%i' out of range", indexToFree);
+		return;
+	}
+	if (!PagedObjectPoolIndexOccupied(pPool, indexToFree))
+	{
+		printf("index '%i' already free!\n", indexToFree);
+		return;
+	}
+	BlockOccupancy(pPool, indexToFree >> pPool->blockShift)[(indexToFree & pPool->blockMask) >> 6] &= ~(1ull << (indexToFree & 63));
+	*FreeLink(pPool, indexToFree) = pPool->freeListHead;
+	pPool->freeListHead = indexToFree;
+	pPool->numAllocated--;
+}
+
+void* FreePagedObjectPool(struct PagedObjectPool* pPool)
+{
+	for (int i = 0; i < pPool->numBlocks; i++)
+	{
+		free(pPool->ppBlocks[i]);
+	}
+	free(pPool->ppBlocks);
+	free(pPool);
+	return NULL;
+}
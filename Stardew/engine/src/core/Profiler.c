@@ -0,0 +1,420 @@
+#include "Profiler.h"
+
+#ifdef STARDEW_PROFILER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AssertLib.h"
+#include "PlatformDefs.h"
+#include "Clock.h"
+
+#if defined(GAME_PLATFORM_WINDOWS_64) || defined(GAME_PLATFORM_WINDOWS_32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#define PROF_THREAD_LOCAL __declspec(thread)
+#define PROF_ATOMIC_FETCH_ADD(p, v) ((u32)_InterlockedExchangeAdd((volatile long*)(p), (long)(v)))
+#define PROF_ATOMIC_EXCHANGE(p, v) ((u32)_InterlockedExchange((volatile long*)(p), (long)(v)))
+/* volatile accesses have acquire/release semantics with msvc */
+#define PROF_LOAD_ACQUIRE(p) (*(volatile u64*)(p))
+#define PROF_STORE_RELEASE(p, v) (*(volatile u64*)(p) = (v))
+#else
+#define PROF_THREAD_LOCAL _Thread_local
+#define PROF_ATOMIC_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define PROF_ATOMIC_EXCHANGE(p, v) __atomic_exchange_n((p), (v), __ATOMIC_RELAXED)
+#define PROF_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PROF_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/* weight of the latest frame in a zones moving average */
+#define ZONE_AVG_WEIGHT 0.05
+
+struct ProfileEvent
+{
+	const char* name;
+	u64 startNs;
+	u64 endNs;
+	u32 depth;
+};
+
+struct ProfileOpenZone
+{
+	const char* name;
+	u64 startNs;
+};
+
+struct ProfileThreadBuffer
+{
+	/* ring buffer of finished zones */
+	struct ProfileEvent* pEvents;
+	/* total zones ever written, written by the owning thread only */
+	u64 numWritten;
+	/* how far the frame mark has totalled up, main thread only */
+	u64 numAggregated;
+	struct ProfileOpenZone openZones[PROFILER_MAX_ZONE_DEPTH];
+	u32 depth;
+	u32 threadIndex;
+};
+
+struct ProfileFrame
+{
+	u64 startNs;
+	u64 endNs;
+	u32 counters[PC_NumCounters];
+};
+
+struct ProfilerState
+{
+	bool bInitialised;
+	bool bExportRequested;
+	/* incremented by each Prof_Init so threads know to claim a new buffer */
+	u32 generation;
+	u64 startNs;
+
+	struct ProfileThreadBuffer threads[PROFILER_MAX_THREADS];
+	u32 numThreads;
+
+	struct ProfileFrame frames[PROFILER_MAX_FRAMES];
+	u64 numFrames;
+	u64 frameStartNs;
+	u32 counters[PC_NumCounters];
+
+	struct ProfileZoneStats zoneStats[PROFILER_MAX_ZONE_STATS];
+	u64 zoneNsThisFrame[PROFILER_MAX_ZONE_STATS];
+	u32 zoneCallsThisFrame[PROFILER_MAX_ZONE_STATS];
+	int numZoneStats;
+};
+
+static struct ProfilerState gProfiler;
+
+static PROF_THREAD_LOCAL struct ProfileThreadBuffer* tpThreadBuffer = NULL;
+static PROF_THREAD_LOCAL u32 tThreadBufferGeneration = 0;
+
+static const char* gCounterNames[PC_NumCounters] =
+{
+	"DrawCalls",
+	"VerticesDrawn",
+	"EntitiesUpdated"
+};
+
+u64 Prof_NowNs(void)
+{
+	return Clk_NowNs();
+}
+
+static struct ProfileThreadBuffer* GetThreadBuffer(void)
+{
+	if (!gProfiler.bInitialised)
+	{
+		return NULL;
+	}
+	if (tpThreadBuffer && tThreadBufferGeneration == gProfiler.generation)
+	{
+		return tpThreadBuffer;
+	}
+	tThreadBufferGeneration = gProfiler.generation;
+	u32 index = PROF_ATOMIC_FETCH_ADD(&gProfiler.numThreads, 1);
+	if (index >= PROFILER_MAX_THREADS)
+	{
+		/* too many threads, this ones zones aren't recorded */
+		tpThreadBuffer = NULL;
+		return NULL;
+	}
+	tpThreadBuffer = &gProfiler.threads[index];
+	return tpThreadBuffer;
+}
+
+static u32 NumThreadBuffers(void)
+{
+	return gProfiler.numThreads < PROFILER_MAX_THREADS ? gProfiler.numThreads : PROFILER_MAX_THREADS;
+}
+
+void Prof_Init(void)
+{
+	EASSERT(!gProfiler.bInitialised);
+	u32 generation = gProfiler.generation + 1;
+	memset(&gProfiler, 0, sizeof(struct ProfilerState));
+	gProfiler.generation = generation;
+	for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		gProfiler.threads[i].threadIndex = i;
+		gProfiler.threads[i].pEvents = malloc(sizeof(struct ProfileEvent) * PROFILER_RING_BUFFER_SIZE);
+		EASSERT(gProfiler.threads[i].pEvents);
+	}
+	gProfiler.startNs = Prof_NowNs();
+	gProfiler.frameStartNs = gProfiler.startNs;
+	gProfiler.bInitialised = true;
+	/* the thread that initialises the profiler is thread 0 in the trace */
+	GetThreadBuffer();
+}
+
+void Prof_Shutdown(void)
+{
+	if (!gProfiler.bInitialised)
+	{
+		return;
+	}
+	gProfiler.bInitialised = false;
+	for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		free(gProfiler.threads[i].pEvents);
+		gProfiler.threads[i].pEvents = NULL;
+	}
+}
+
+void Prof_BeginZone(const char* name)
+{
+	struct ProfileThreadBuffer* pBuf = GetThreadBuffer();
+	if (!pBuf)
+	{
+		return;
+	}
+	if (pBuf->depth < PROFILER_MAX_ZONE_DEPTH)
+	{
+		pBuf->openZones[pBuf->depth].name = name;
+		pBuf->openZones[pBuf->depth].startNs = Prof_NowNs();
+	}
+	pBuf->depth++;
+}
+
+void Prof_EndZone(void)
+{
+	u64 endNs = Prof_NowNs();
+	struct ProfileThreadBuffer* pBuf = GetThreadBuffer();
+	if (!pBuf)
+	{
+		return;
+	}
+	if (pBuf->depth == 0)
+	{
+		/* a zone begun before the profiler was initialised */
+		return;
+	}
+	pBuf->depth--;
+	if (pBuf->depth >= PROFILER_MAX_ZONE_DEPTH)
+	{
+		return;
+	}
+	struct ProfileOpenZone* pOpen = &pBuf->openZones[pBuf->depth];
+	struct ProfileEvent* pEvent = &pBuf->pEvents[pBuf->numWritten & (PROFILER_RING_BUFFER_SIZE - 1)];
+	pEvent->name = pOpen->name;
+	pEvent->startNs = pOpen->startNs;
+	pEvent->endNs = endNs;
+	pEvent->depth = pBuf->depth;
+	PROF_STORE_RELEASE(&pBuf->numWritten, pBuf->numWritten + 1);
+}
+
+void Prof_AddCounter(enum ProfileCounter counter, u32 amount)
+{
+	EASSERT(counter >= 0 && counter < PC_NumCounters);
+	PROF_ATOMIC_FETCH_ADD(&gProfiler.counters[counter], amount);
+}
+
+static int FindOrAddZoneStats(const char* name, u32 depth)
+{
+	for (int i = 0; i < gProfiler.numZoneStats; i++)
+	{
+		/* the same literal can have a different address in each translation unit */
+		if (gProfiler.zoneStats[i].name == name || strcmp(gProfiler.zoneStats[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	if (gProfiler.numZoneStats == PROFILER_MAX_ZONE_STATS)
+	{
+		return -1;
+	}
+	int index = gProfiler.numZoneStats++;
+	struct ProfileZoneStats* pStats = &gProfiler.zoneStats[index];
+	memset(pStats, 0, sizeof(struct ProfileZoneStats));
+	pStats->name = name;
+	pStats->depth = depth;
+	return index;
+}
+
+static void AggregateThreadZones(struct ProfileThreadBuffer* pBuf)
+{
+	u64 numWritten = PROF_LOAD_ACQUIRE(&pBuf->numWritten);
+	u64 first = pBuf->numAggregated;
+	if (numWritten - first > PROFILER_RING_BUFFER_SIZE)
+	{
+		/* the ring buffer wrapped since the last frame mark */
+		first = numWritten - PROFILER_RING_BUFFER_SIZE;
+	}
+	for (u64 i = first; i < numWritten; i++)
+	{
+		struct ProfileEvent* pEvent = &pBuf->pEvents[i & (PROFILER_RING_BUFFER_SIZE - 1)];
+		int stats = FindOrAddZoneStats(pEvent->name, pEvent->depth);
+		if (stats < 0)
+		{
+			continue;
+		}
+		gProfiler.zoneNsThisFrame[stats] += pEvent->endNs - pEvent->startNs;
+		gProfiler.zoneCallsThisFrame[stats]++;
+	}
+	pBuf->numAggregated = numWritten;
+}
+
+void Prof_FrameMark(void)
+{
+	if (!gProfiler.bInitialised)
+	{
+		return;
+	}
+	u64 now = Prof_NowNs();
+
+	memset(gProfiler.zoneNsThisFrame, 0, sizeof(gProfiler.zoneNsThisFrame));
+	memset(gProfiler.zoneCallsThisFrame, 0, sizeof(gProfiler.zoneCallsThisFrame));
+	u32 numThreads = NumThreadBuffers();
+	for (u32 i = 0; i < numThreads; i++)
+	{
+		AggregateThreadZones(&gProfiler.threads[i]);
+	}
+	for (int i = 0; i < gProfiler.numZoneStats; i++)
+	{
+		struct ProfileZoneStats* pStats = &gProfiler.zoneStats[i];
+		pStats->lastFrameMs = (double)gProfiler.zoneNsThisFrame[i] / 1000000.0;
+		pStats->lastFrameCalls = gProfiler.zoneCallsThisFrame[i];
+		pStats->avgMs = pStats->avgMs + (pStats->lastFrameMs - pStats->avgMs) * ZONE_AVG_WEIGHT;
+		pStats->maxMs = pStats->lastFrameMs > pStats->maxMs ? pStats->lastFrameMs : pStats->maxMs;
+	}
+
+	struct ProfileFrame* pFrame = &gProfiler.frames[gProfiler.numFrames & (PROFILER_MAX_FRAMES - 1)];
+	pFrame->startNs = gProfiler.frameStartNs;
+	pFrame->endNs = now;
+	for (int i = 0; i < PC_NumCounters; i++)
+	{
+		pFrame->counters[i] = PROF_ATOMIC_EXCHANGE(&gProfiler.counters[i], 0);
+	}
+	gProfiler.numFrames++;
+	gProfiler.frameStartNs = now;
+
+	if (gProfiler.bExportRequested)
+	{
+		gProfiler.bExportRequested = false;
+		if (Prof_ExportChromeTrace(PROFILER_TRACE_PATH))
+		{
+			printf("profiler trace written to %s\n", PROFILER_TRACE_PATH);
+		}
+	}
+}
+
+const struct ProfileZoneStats* Prof_GetZoneStats(int* pOutNumZones)
+{
+	*pOutNumZones = gProfiler.numZoneStats;
+	return gProfiler.zoneStats;
+}
+
+struct ProfileFrameStats Prof_GetLastFrameStats(void)
+{
+	struct ProfileFrameStats stats;
+	memset(&stats, 0, sizeof(struct ProfileFrameStats));
+	if (gProfiler.numFrames == 0)
+	{
+		return stats;
+	}
+	struct ProfileFrame* pFrame = &gProfiler.frames[(gProfiler.numFrames - 1) & (PROFILER_MAX_FRAMES - 1)];
+	stats.frameIndex = gProfiler.numFrames - 1;
+	stats.frameMs = (double)(pFrame->endNs - pFrame->startNs) / 1000000.0;
+	memcpy(stats.counters, pFrame->counters, sizeof(stats.counters));
+	return stats;
+}
+
+const char* Prof_GetCounterName(enum ProfileCounter counter)
+{
+	EASSERT(counter >= 0 && counter < PC_NumCounters);
+	return gCounterNames[counter];
+}
+
+void Prof_RequestExport(void)
+{
+	gProfiler.bExportRequested = true;
+}
+
+static void WriteJSONString(FILE* pFile, const char* str)
+{
+	fputc('"', pFile);
+	for (const char* c = str; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', pFile);
+		}
+		fputc(*c, pFile);
+	}
+	fputc('"', pFile);
+}
+
+/* trace timestamps are in microseconds */
+static double TraceTimeUs(u64 ns)
+{
+	return (double)(ns - gProfiler.startNs) / 1000.0;
+}
+
+static void WriteEventSeparator(FILE* pFile, bool* pbFirst)
+{
+	if (!*pbFirst)
+	{
+		fputs(",\n", pFile);
+	}
+	*pbFirst = false;
+}
+
+bool Prof_ExportChromeTrace(const char* path)
+{
+	if (!gProfiler.bInitialised)
+	{
+		return false;
+	}
+	FILE* pFile = fopen(path, "w");
+	if (!pFile)
+	{
+		printf("Prof_ExportChromeTrace: can't open %s for writing\n", path);
+		return false;
+	}
+	bool bFirst = true;
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", pFile);
+
+	u32 numThreads = NumThreadBuffers();
+	for (u32 i = 0; i < numThreads; i++)
+	{
+		struct ProfileThreadBuffer* pBuf = &gProfiler.threads[i];
+		WriteEventSeparator(pFile, &bFirst);
+		fprintf(pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			pBuf->threadIndex, pBuf->threadIndex == 0 ? "main" : "thread", pBuf->threadIndex);
+
+		u64 numWritten = PROF_LOAD_ACQUIRE(&pBuf->numWritten);
+		u64 first = numWritten > PROFILER_RING_BUFFER_SIZE ? numWritten - PROFILER_RING_BUFFER_SIZE : 0;
+		for (u64 j = first; j < numWritten; j++)
+		{
+			struct ProfileEvent* pEvent = &pBuf->pEvents[j & (PROFILER_RING_BUFFER_SIZE - 1)];
+			WriteEventSeparator(pFile, &bFirst);
+			fputs("{\"name\":", pFile);
+			WriteJSONString(pFile, pEvent->name);
+			fprintf(pFile, ",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				TraceTimeUs(pEvent->startNs), (double)(pEvent->endNs - pEvent->startNs) / 1000.0, pBuf->threadIndex);
+		}
+	}
+
+	u64 firstFrame = gProfiler.numFrames > PROFILER_MAX_FRAMES ? gProfiler.numFrames - PROFILER_MAX_FRAMES : 0;
+	for (u64 i = firstFrame; i < gProfiler.numFrames; i++)
+	{
+		struct ProfileFrame* pFrame = &gProfiler.frames[i & (PROFILER_MAX_FRAMES - 1)];
+		WriteEventSeparator(pFile, &bFirst);
+		fprintf(pFile, "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0,\"args\":{\"frame\":%llu}}",
+			TraceTimeUs(pFrame->startNs), (unsigned long long)i);
+		for (int j = 0; j < PC_NumCounters; j++)
+		{
+			WriteEventSeparator(pFile, &bFirst);
+			fprintf(pFile, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%u}}",
+				gCounterNames[j], TraceTimeUs(pFrame->startNs), pFrame->counters[j]);
+		}
+	}
+
+	fputs("\n]}\n", pFile);
+	fclose(pFile);
+	return true;
+}
+
+#endif
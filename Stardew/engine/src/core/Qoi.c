@@ -0,0 +1,187 @@
+#include "Qoi.h"
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00 /* 00xxxxxx */
+#define QOI_OP_DIFF  0x40 /* 01xxxxxx */
+#define QOI_OP_LUMA  0x80 /* 10xxxxxx */
+#define QOI_OP_RUN   0xc0 /* 11xxxxxx */
+#define QOI_OP_RGB   0xfe /* 11111110 */
+#define QOI_OP_RGBA  0xff /* 11111111 */
+#define QOI_MASK_2   0xc0
+/* runs of 63 and 64 would clash with the RGB and RGBA ops */
+#define QOI_MAX_RUN  62
+
+union QoiPixel
+{
+	struct { u8 r, g, b, a; } rgba;
+	u32 v;
+};
+
+static int Hash(union QoiPixel px)
+{
+	return (px.rgba.r * 3 + px.rgba.g * 5 + px.rgba.b * 7 + px.rgba.a * 11) % 64;
+}
+
+size_t Qoi_EncodeBound(size_t numPixels)
+{
+	/* an RGBA op is the biggest a pixel can get */
+	return numPixels * 5;
+}
+
+size_t Qoi_Encode(const u8* rgba, size_t numPixels, u8* dst, size_t dstCapacity)
+{
+	if (dstCapacity < Qoi_EncodeBound(numPixels))
+	{
+		return 0;
+	}
+	union QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	union QoiPixel prev;
+	prev.v = 0;
+	prev.rgba.a = 255;
+	u8* op = dst;
+	int run = 0;
+	for (size_t i = 0; i < numPixels; i++)
+	{
+		union QoiPixel px;
+		memcpy(&px, rgba + i * 4, sizeof(union QoiPixel));
+		if (px.v == prev.v)
+		{
+			run++;
+			if (run == QOI_MAX_RUN || i == numPixels - 1)
+			{
+				*op++ = QOI_OP_RUN | (run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if (run > 0)
+		{
+			*op++ = QOI_OP_RUN | (run - 1);
+			run = 0;
+		}
+		int hash = Hash(px);
+		if (index[hash].v == px.v)
+		{
+			*op++ = QOI_OP_INDEX | hash;
+		}
+		else
+		{
+			index[hash] = px;
+			if (px.rgba.a == prev.rgba.a)
+			{
+				i8 vr = (i8)(px.rgba.r - prev.rgba.r);
+				i8 vg = (i8)(px.rgba.g - prev.rgba.g);
+				i8 vb = (i8)(px.rgba.b - prev.rgba.b);
+				i8 vgr = vr - vg;
+				i8 vgb = vb - vg;
+				if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+				{
+					*op++ = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+				}
+				else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+				{
+					*op++ = QOI_OP_LUMA | (vg + 32);
+					*op++ = (vgr + 8) << 4 | (vgb + 8);
+				}
+				else
+				{
+					*op++ = QOI_OP_RGB;
+					*op++ = px.rgba.r;
+					*op++ = px.rgba.g;
+					*op++ = px.rgba.b;
+				}
+			}
+			else
+			{
+				*op++ = QOI_OP_RGBA;
+				memcpy(op, &px, sizeof(union QoiPixel));
+				op += sizeof(union QoiPixel);
+			}
+		}
+		prev = px;
+	}
+	return op - dst;
+}
+
+bool Qoi_Decode(const u8* src, size_t srcSize, u8* dst, size_t numPixels)
+{
+	union QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	union QoiPixel px;
+	px.v = 0;
+	px.rgba.a = 255;
+	const u8* ip = src;
+	const u8* const iend = src + srcSize;
+	u8* op = dst;
+	u8* const oend = dst + numPixels * 4;
+	while (op < oend)
+	{
+		if (ip >= iend)
+		{
+			return false;
+		}
+		int b1 = *ip++;
+		if (b1 == QOI_OP_RGB)
+		{
+			if (iend - ip < 3)
+			{
+				return false;
+			}
+			px.rgba.r = ip[0];
+			px.rgba.g = ip[1];
+			px.rgba.b = ip[2];
+			ip += 3;
+		}
+		else if (b1 == QOI_OP_RGBA)
+		{
+			if (iend - ip < 4)
+			{
+				return false;
+			}
+			memcpy(&px, ip, sizeof(union QoiPixel));
+			ip += 4;
+		}
+		else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+		{
+			px = index[b1];
+		}
+		else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+		{
+			px.rgba.r += ((b1 >> 4) & 0x03) - 2;
+			px.rgba.g += ((b1 >> 2) & 0x03) - 2;
+			px.rgba.b += (b1 & 0x03) - 2;
+		}
+		else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+		{
+			if (ip >= iend)
+			{
+				return false;
+			}
+			int b2 = *ip++;
+			int vg = (b1 & 0x3f) - 32;
+			px.rgba.r += vg - 8 + ((b2 >> 4) & 0x0f);
+			px.rgba.g += vg;
+			px.rgba.b += vg - 8 + (b2 & 0x0f);
+		}
+		else
+		{
+			/* a run repeats the previous pixel, which is already in the index */
+			size_t run = (b1 & 0x3f) + 1;
+			if ((size_t)(oend - op) / 4 < run)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < run; i++)
+			{
+				memcpy(op, &px, sizeof(union QoiPixel));
+				op += 4;
+			}
+			continue;
+		}
+		index[Hash(px)] = px;
+		memcpy(op, &px, sizeof(union QoiPixel));
+		op += 4;
+	}
+	return ip == iend;
+}
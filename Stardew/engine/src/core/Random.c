@@ -20,6 +20,11 @@ unsigned int Ra_SeedFromTime()
     return t;
 }
 
+void Ra_Seed(unsigned int seed)
+{
+    srand(seed);
+}
+
 unsigned int Ra_RandZeroTo(int maxExclusive)
 {
     return rand() % maxExclusive;
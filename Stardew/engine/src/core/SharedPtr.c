@@ -39,7 +39,7 @@ void Sptr_RemoveRef(void* pointer)
 	{
 		if (ptr->pDtor)
 		{
-			ptr->pDtor(ptr);
+			ptr->pDtor(pointer);
 		}
 		free(ptr);
 	}
@@ -9,362 +9,365 @@
 
 /*
 
-	A hashmap with linear probing, strings as keys, that uses the djb2 hashing algorithm.
-	
-	Buckets (or KVP) contain the raw hash of the string key.
+	A hashmap with open addressing and strings as keys, laid out like a "swiss table".
 
-	Delete implementation moves a bucket ahead of the "hole" who's hashed index refers to a bucket BEHIND the hole
-	into the "hole". This is then repeated for the new hole recursively (although not actually recursive).
+	Each slot has a control byte: CTRL_EMPTY, CTRL_DELETED, or, if full, the low 7 bits (h2) of the keys hash.
+	Slots are probed a group of 8 control bytes at a time - the group is loaded as a u64 and compared
+	against h2 with bit tricks, so most slots that can't hold the key are rejected without touching them.
+	The high bits of the hash (h1) pick the first group, groups are then probed triangularly which visits
+	every group because the number of groups is a power of two.
 
-	An alternative delete would be to mark the deleted bucket as deleted, so that linear probes skip over it.
-	This would be faster but use more memory, with the deleted cells only usable when the hash map next resizes, effectively.
+	A control byte match is only a hint, the full hash and then the full key string are compared,
+	so two keys with the same hash are still different keys.
 
-	Will resize when load factor reaches a given threshold.
+	Entries (hash, key offset, value) are stored densely in insertion order, which gives ordered
+	iteration for free. A slot holds the index of its entry. Keys are copied into one string slab
+	rather than allocated one by one.
+
+	Delete marks the entry dead and sets its slot to CTRL_DELETED (a tombstone) so probe sequences
+	passing through it are not broken - or straight back to CTRL_EMPTY if its group already has an empty slot,
+	as then no probe sequence can pass through this group anyway.
+
+	Rehashes when live + dead entries reach the load factor. Rehashing drops dead entries, tombstones
+	and unused key bytes, and only doubles the capacity if the live entries need it.
+
+	Group loads assume a little endian target.
 
 */
 
-struct KVP
+#define CTRL_EMPTY ((u8)0x80)
+#define CTRL_DELETED ((u8)0xFE)
+#define GROUP_WIDTH 8
+#define MIN_CAPACITY 8
+
+#define LSBS 0x0101010101010101ull
+#define MSBS 0x8080808080808080ull
+
+struct HashmapEntry
 {
-	struct KVP* pNext;
-	struct KVP* pPrev;
-	char* pKey;
-	unsigned int keyHash;
+	u32 hash;
+	/* offset into pKeySlab, -1 if the entry has been deleted */
+	i32 keyOffset;
+	/* value follows, 8 byte aligned */
 };
 
-unsigned int djb2(char* str)
+u32 HashmapHashKey(const char* key)
 {
-	unsigned int hash = 5381;
-	int c;
-
-	while (c = *(unsigned char*)str++)
+	/* FNV-1a, then murmur3's finaliser so both the low bits (h2) and high bits (h1) are well mixed */
+	u32 hash = 2166136261u;
+	for (const unsigned char* p = (const unsigned char*)key; *p; p++)
 	{
-		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+		hash ^= *p;
+		hash *= 16777619u;
 	}
-
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
 	return hash;
 }
 
-static void HashmapInitBase(struct HashMap* pMap, int capacity, int valSize)
+static u8 H2(u32 hash)
 {
-	memset(pMap, 0, sizeof(struct HashMap));
-	pMap->capacity = capacity;
-	pMap->size = 0;
-	pMap->valueSize = valSize;
-	pMap->pData = malloc(capacity * (sizeof(struct KVP) + valSize));
-	memset(pMap->pData, 0, capacity * (sizeof(struct KVP) + valSize));
-	
+	return hash & 0x7f;
 }
 
-void HashmapInit(struct HashMap* pMap, int capacity, int valSize)
+static u32 H1(u32 hash)
 {
-	HashmapInitBase(pMap, capacity, valSize);
-	pMap->fLoadFactor = STARDEW_HASHMAP_DEFAULT_LOAD_FACTOR;
+	return hash >> 7;
 }
 
-void HashmapInitWithLoadFactor(struct HashMap* pMap, int capacity, int valSize, float loadFactor)
+static int LowestSetByte(u64 mask)
 {
-	HashmapInitBase(pMap, capacity, valSize);
-	pMap->fLoadFactor = loadFactor;
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return (int)(index >> 3);
+#else
+	return __builtin_ctzll(mask) >> 3;
+#endif
 }
 
-static struct KVP* BucketAtIndex(struct HashMap* pMap, int i)
+static u64 LoadGroup(struct HashMap* pMap, int group)
 {
-	return (struct KVP*)((char*)pMap->pData + i * (sizeof(struct KVP) + pMap->valueSize));
+	u64 g;
+	memcpy(&g, pMap->pCtrl + group * GROUP_WIDTH, sizeof(u64));
+	return g;
 }
 
-static int NextIndex(struct HashMap* pMap, int i)
+/* high bit set in each byte that may equal h2 - can give false positives, which the key compare rejects */
+static u64 MatchH2(u64 group, u8 h2)
 {
-	if (++i >= pMap->capacity)
-	{
-		return 0;
-	}
-	return i;
+	u64 x = group ^ (LSBS * h2);
+	return (x - LSBS) & ~x & MSBS;
+}
+
+static u64 MatchEmpty(u64 group)
+{
+	return group & ~(group << 6) & MSBS;
 }
 
-static int GetIndex(struct HashMap* pMap, struct KVP* pKVP)
+static u64 MatchEmptyOrDeleted(u64 group)
 {
-	EASSERT((char*)pMap->pData <= (char*)pKVP);
-	int offset = (char*)pKVP - (char*)pMap->pData;
-	EASSERT(offset % (pMap->valueSize + sizeof(struct KVP)) == 0);
-	return offset / (pMap->valueSize + sizeof(struct KVP));
+	return group & ~(group << 7) & MSBS;
 }
 
-/// <summary>
-/// 
-/// </summary>
-/// <param name="pMap"></param>
-/// <param name="key"></param>
-/// <param name="bReturnVal">
-/// if true, return the value, if false, return the KVP struct
-/// </param>
-/// <returns></returns>
-static void* HashmapSearchBase(struct HashMap* pMap, char* key, bool bReturnVal)
+static struct HashmapEntry* EntryAt(struct HashMap* pMap, int i)
 {
-	unsigned int hash = djb2(key);
-	int index = hash % pMap->capacity;
-	/* linear probe */
-	struct KVP* pKVP = BucketAtIndex(pMap, index);
+	return (struct HashmapEntry*)(pMap->pEntries + (size_t)i * pMap->entryStride);
+}
 
-	while (true)
+static int RoundUpCapacity(int capacity)
+{
+	int c = MIN_CAPACITY;
+	while (c < capacity)
 	{
-		if (pKVP->pKey && pKVP->keyHash == hash)
-		{
-			return bReturnVal ? pKVP + 1 : pKVP;
-		}
-		else if (pKVP->pKey) // pKey set == "there's something in this bucket"
-		{
-			index = NextIndex(pMap, index);
-			pKVP = BucketAtIndex(pMap, index);
-		}
-		else
-		{
-			return NULL;
-		}
+		c *= 2;
 	}
-	return NULL;
+	return c;
+}
+
+static int MaxEntries(struct HashMap* pMap)
+{
+	int max = (int)(pMap->capacity * pMap->fLoadFactor);
+	/* always leave an empty slot so probing terminates */
+	return max >= pMap->capacity ? pMap->capacity - 1 : max;
+}
+
+static void AllocTable(struct HashMap* pMap, int capacity)
+{
+	pMap->capacity = capacity;
+	pMap->pEntries = malloc((size_t)capacity * pMap->entryStride);
+	pMap->pSlotEntries = malloc((size_t)capacity * sizeof(i32));
+	pMap->pCtrl = malloc(capacity);
+	EASSERT(pMap->pEntries && pMap->pSlotEntries && pMap->pCtrl);
+	memset(pMap->pCtrl, CTRL_EMPTY, capacity);
+	pMap->numEntries = 0;
+	pMap->numTombstones = 0;
+}
+
+static void FreeTable(struct HashMap* pMap)
+{
+	free(pMap->pEntries);
+	free(pMap->pSlotEntries);
+	free(pMap->pCtrl);
 }
 
-void* HashmapSearch(struct HashMap* pMap, char* key)
+static void HashmapInitBase(struct HashMap* pMap, int capacity, int valSize, float loadFactor)
 {
-	return HashmapSearchBase(pMap, key, true);
+	EASSERT(loadFactor > 0.0f && loadFactor < 1.0f);
+	memset(pMap, 0, sizeof(struct HashMap));
+	pMap->valueSize = valSize;
+	pMap->fLoadFactor = loadFactor;
+	pMap->entryStride = (sizeof(struct HashmapEntry) + valSize + 7) & ~7;
+	AllocTable(pMap, RoundUpCapacity(capacity));
+	pMap->keySlabCapacity = 256;
+	pMap->pKeySlab = malloc(pMap->keySlabCapacity);
+	EASSERT(pMap->pKeySlab);
 }
 
-struct KVP* HashmapSearchKVP(struct HashMap* pMap, char* key)
+void HashmapInit(struct HashMap* pMap, int capacity, int valSize)
 {
-	return (struct KVP*)HashmapSearchBase(pMap, key, false);
+	HashmapInitBase(pMap, capacity, valSize, STARDEW_HASHMAP_DEFAULT_LOAD_FACTOR);
 }
 
-/// <summary>
-/// insert from the old allocation to the new
-/// </summary>
-/// <param name="pMap">
-/// </param>
-/// <param name="pKVPsrc">
-/// kvp from old allocation
-/// </param>
-/// <param name="pNewAlloc">
-/// New allocation
-/// </param>
-/// <returns>
-/// The KVP inserted into pNewAlloc
-/// </returns>
-struct KVP* InsertKVPIntoNewAlloc(struct HashMap* pMap, struct KVP* pKVPsrc, char* pNewAlloc)
+void HashmapInitWithLoadFactor(struct HashMap* pMap, int capacity, int valSize, float loadFactor)
 {
-	unsigned int hash = pKVPsrc->keyHash;
-	int index = hash % pMap->capacity;
-	void* pAt = pNewAlloc + index * (sizeof(struct KVP) + pMap->valueSize);
-	struct KVP* pKVP = (struct KVP*)pAt;
+	HashmapInitBase(pMap, capacity, valSize, loadFactor);
+}
 
-	while (true)
+/* returns the slot holding key, or -1 */
+static int FindSlot(struct HashMap* pMap, const char* key, u32 hash)
+{
+	int groupMask = pMap->capacity / GROUP_WIDTH - 1;
+	int group = H1(hash) & groupMask;
+	u8 h2 = H2(hash);
+	for (int probe = 1; probe <= groupMask + 1; probe++)
 	{
-		if (pKVP->pKey && pKVP->keyHash != hash)
+		u64 ctrl = LoadGroup(pMap, group);
+		u64 matches = MatchH2(ctrl, h2);
+		while (matches)
 		{
-			// occupied bucket
-			index = NextIndex(pMap, index);
-			pKVP = (struct KVP*)((char*)pNewAlloc + index * (sizeof(struct KVP) + pMap->valueSize));
-		}
-		else
-		{
-			if (pKVP->pKey)
+			int slot = group * GROUP_WIDTH + LowestSetByte(matches);
+			struct HashmapEntry* pEntry = EntryAt(pMap, pMap->pSlotEntries[slot]);
+			if (pEntry->hash == hash && strcmp(pMap->pKeySlab + pEntry->keyOffset, key) == 0)
 			{
-				free(pKVP->pKey);
-				EASSERT(false);
+				return slot;
 			}
-			memset(pKVP, 0, sizeof(struct KVP));
-			pKVP->keyHash = hash;
-			pKVP->pKey = malloc(strlen(pKVPsrc->pKey) + 1);
-			strcpy(pKVP->pKey, pKVPsrc->pKey);
-			memcpy(pKVP + 1, pKVPsrc + 1, pMap->valueSize);
-			return pKVP;
+			matches &= matches - 1;
+		}
+		if (MatchEmpty(ctrl))
+		{
+			return -1;
 		}
+		group = (group + probe) & groupMask;
 	}
-	return pKVP;
+	return -1;
 }
 
-void HashmapPrintEntries(struct HashMap* pMap, const char* hashMapName)
+/* first empty or deleted slot on hash's probe sequence */
+static int FindInsertSlot(struct HashMap* pMap, u32 hash)
 {
-	printf("HASHMAP: '%s' current size: %i current capacity: %i\n\n", hashMapName, pMap->size, pMap->capacity);
-	struct KVP* pKVP = pMap->pHead;
-	while (pKVP)
+	int groupMask = pMap->capacity / GROUP_WIDTH - 1;
+	int group = H1(hash) & groupMask;
+	for (int probe = 1; ; probe++)
 	{
-		EASSERT(pKVP->pKey);
-		printf("Key: %s hash: %u\n", pKVP->pKey, pKVP->keyHash);
-		pKVP = pKVP->pNext;
+		u64 available = MatchEmptyOrDeleted(LoadGroup(pMap, group));
+		if (available)
+		{
+			return group * GROUP_WIDTH + LowestSetByte(available);
+		}
+		group = (group + probe) & groupMask;
 	}
-	printf("\n");
 }
 
-void HashmapResize(struct HashMap* pMap)
+static void SetSlot(struct HashMap* pMap, int slot, u32 hash, int entry)
 {
-	//printf("RESIZING: current size: %i current capacity: %i\n\n", pMap->size, pMap->capacity);
-	//PrintEntries(pMap);
-	//printf("\n");
-	int newAllocSize = (pMap->capacity * (pMap->valueSize + sizeof(struct KVP))) * 2;
-	char* pNewAlloc = malloc(newAllocSize);
-	memset(pNewAlloc, 0, newAllocSize);
-	pMap->capacity *= 2;
-	struct KVP* pKVP = pMap->pHead;
-	struct KVP* pNewHead = NULL;
-	struct KVP* pNewTail = NULL;
-	while (pKVP)
-	{
-		struct KVP* pKVPDst = InsertKVPIntoNewAlloc(pMap, pKVP, pNewAlloc);
-		if (pNewHead == NULL)
-		{
-			pNewHead = pKVPDst;
-			pNewTail = pNewHead;
-		}
-		else
-		{
-			pNewTail->pNext = pKVPDst;
-			pKVPDst->pPrev = pNewTail;
-			pNewTail = pKVPDst;
-		}
-		EASSERT(pKVP->pKey);
-		free(pKVP->pKey);
-		pKVP = pKVP->pNext;
-	}
-	if (pNewHead && !pNewTail)
+	if (pMap->pCtrl[slot] == CTRL_DELETED)
 	{
-		pNewTail = pNewHead;
+		pMap->numTombstones--;
 	}
-	pMap->pHead = pNewHead;
-	pMap->pEnd = pNewTail;
-	free(pMap->pData);
-	pMap->pData = pNewAlloc;
+	pMap->pCtrl[slot] = H2(hash);
+	pMap->pSlotEntries[slot] = entry;
 }
 
-void* HashmapInsert(struct HashMap* pMap, char* key, void* pVal)
+static void Rehash(struct HashMap* pMap)
 {
-	float newLoad = (float)(pMap->size + 1) / (float)pMap->capacity;
-	if(newLoad > pMap->fLoadFactor)
+	int newCapacity = pMap->capacity;
+	/* only grow if the live entries need it, otherwise this just clears out deleted entries */
+	while ((pMap->size + 1) * 2 > (int)(newCapacity * pMap->fLoadFactor))
 	{
-		HashmapResize(pMap);
+		newCapacity *= 2;
 	}
-	// todo: refactor InsertKVPIntoNewAlloc and from here downwards to use a common helper
-	unsigned int hash = djb2(key);
-	int index = hash % pMap->capacity;
-	void* pAt = (char*)pMap->pData + index * (sizeof(struct KVP) + pMap->valueSize);
-	struct KVP* pKVP = (struct KVP*)pAt;
-	struct KVP* pNewKVP = NULL;
-	bool bAdded = true;
-	while (true)
+
+	char* pOldEntries = pMap->pEntries;
+	int numOldEntries = pMap->numEntries;
+	char* pOldSlab = pMap->pKeySlab;
+	free(pMap->pSlotEntries);
+	free(pMap->pCtrl);
+	AllocTable(pMap, newCapacity);
+
+	pMap->pKeySlab = malloc(pMap->keySlabCapacity);
+	EASSERT(pMap->pKeySlab);
+	pMap->keySlabSize = 0;
+
+	for (int i = 0; i < numOldEntries; i++)
 	{
-		if (pKVP->pKey && pKVP->keyHash != hash)
+		struct HashmapEntry* pOld = (struct HashmapEntry*)(pOldEntries + (size_t)i * pMap->entryStride);
+		if (pOld->keyOffset < 0)
 		{
-			// occupied bucket
-			index = NextIndex(pMap, index);
-			pKVP = BucketAtIndex(pMap, index);
+			continue;
 		}
-		else
+		const char* key = pOldSlab + pOld->keyOffset;
+		int len = (int)strlen(key) + 1;
+		int entry = pMap->numEntries++;
+		struct HashmapEntry* pNew = EntryAt(pMap, entry);
+		memcpy(pNew, pOld, pMap->entryStride);
+		pNew->keyOffset = pMap->keySlabSize;
+		memcpy(pMap->pKeySlab + pMap->keySlabSize, key, len);
+		pMap->keySlabSize += len;
+		SetSlot(pMap, FindInsertSlot(pMap, pNew->hash), pNew->hash, entry);
+	}
+	free(pOldEntries);
+	free(pOldSlab);
+}
+
+static int AddKeyToSlab(struct HashMap* pMap, const char* key)
+{
+	int len = (int)strlen(key) + 1;
+	if (pMap->keySlabSize + len > pMap->keySlabCapacity)
+	{
+		while (pMap->keySlabSize + len > pMap->keySlabCapacity)
 		{
-			if (pKVP->pKey)
-			{
-				bAdded = false;
-			}
-			else
-			{
-				memset(pKVP, 0, sizeof(struct KVP));
-				pKVP->keyHash = hash;
-				pKVP->pKey = malloc(strlen(key) + 1);
-				strcpy(pKVP->pKey, key);
-			}
-			
-			memcpy(pKVP + 1, pVal, pMap->valueSize);
-			pNewKVP = pKVP;
-			break;
+			pMap->keySlabCapacity *= 2;
 		}
+		/* entries refer to keys by offset so the slab can move */
+		pMap->pKeySlab = realloc(pMap->pKeySlab, pMap->keySlabCapacity);
+		EASSERT(pMap->pKeySlab);
 	}
-	EASSERT(pNewKVP);
-	if (!bAdded)
+	int offset = pMap->keySlabSize;
+	memcpy(pMap->pKeySlab + offset, key, len);
+	pMap->keySlabSize += len;
+	return offset;
+}
+
+void* HashmapSearchHashed(struct HashMap* pMap, const char* key, u32 hash)
+{
+	int slot = FindSlot(pMap, key, hash);
+	if (slot < 0)
 	{
 		return NULL;
 	}
-	if (!pMap->pHead)
+	return EntryAt(pMap, pMap->pSlotEntries[slot]) + 1;
+}
+
+void* HashmapSearch(struct HashMap* pMap, const char* key)
+{
+	return HashmapSearchHashed(pMap, key, HashmapHashKey(key));
+}
+
+void HashmapPrintEntries(struct HashMap* pMap, const char* hashMapName)
+{
+	printf("HASHMAP: '%s' current size: %i current capacity: %i\n\n", hashMapName, pMap->size, pMap->capacity);
+	for (int i = 0; i < pMap->numEntries; i++)
+	{
+		struct HashmapEntry* pEntry = EntryAt(pMap, i);
+		if (pEntry->keyOffset >= 0)
+		{
+			printf("Key: %s hash: %u\n", pMap->pKeySlab + pEntry->keyOffset, pEntry->hash);
+		}
+	}
+	printf("\n");
+}
+
+void* HashmapInsertHashed(struct HashMap* pMap, const char* key, u32 hash, void* pVal)
+{
+	int slot = FindSlot(pMap, key, hash);
+	if (slot >= 0)
 	{
-		pMap->pHead = pNewKVP;
-		pMap->pEnd = pMap->pHead;
+		memcpy(EntryAt(pMap, pMap->pSlotEntries[slot]) + 1, pVal, pMap->valueSize);
+		return NULL;
 	}
-	else
+	if (pMap->numEntries + 1 > MaxEntries(pMap))
 	{
-		pMap->pEnd->pNext = pNewKVP;
-		pNewKVP->pPrev = pMap->pEnd;
-		pMap->pEnd = pNewKVP;
+		Rehash(pMap);
 	}
+	int entry = pMap->numEntries++;
+	struct HashmapEntry* pEntry = EntryAt(pMap, entry);
+	pEntry->hash = hash;
+	pEntry->keyOffset = AddKeyToSlab(pMap, key);
+	memcpy(pEntry + 1, pVal, pMap->valueSize);
+	SetSlot(pMap, FindInsertSlot(pMap, hash), hash, entry);
 	pMap->size++;
-	return pNewKVP + 1;
+	return pEntry + 1;
 }
 
-struct KVP* FindMoveableKey(struct KVP* pHole, struct HashMap* pMap)
+void* HashmapInsert(struct HashMap* pMap, const char* key, void* pVal)
 {
-	int firstIndex = GetIndex(pMap, pHole);
-	int next = NextIndex(pMap, firstIndex);
-	struct KVP* pKVP = BucketAtIndex(pMap, next);
-	while (pKVP->pKey)
-	{
-		int hashIndex = pKVP->keyHash % pMap->capacity;
-		if (hashIndex <= firstIndex)
-		{
-			return pKVP;
-		}
-		next = NextIndex(pMap, next);
-		pKVP = BucketAtIndex(pMap, next);
-	}
-	
-	return NULL;
+	return HashmapInsertHashed(pMap, key, HashmapHashKey(key), pVal);
 }
 
-bool HashmapDeleteItem(struct HashMap* pMap, char* key)
+bool HashmapDeleteItem(struct HashMap* pMap, const char* key)
 {
-	struct KVP* pFound = HashmapSearchKVP(pMap, key);
-	if (pFound)
+	int slot = FindSlot(pMap, key, HashmapHashKey(key));
+	if (slot < 0)
 	{
-		if (pFound->pNext)
-		{
-			pFound->pNext->pPrev = pFound->pPrev;
-		}
-		if (pFound->pPrev)
-		{
-			pFound->pPrev->pNext = pFound->pNext;
-		}
-		if (pMap->pHead == pFound)
-		{
-			pMap->pHead = pFound->pNext;
-		}
-		if (pMap->pEnd == pFound)
-		{
-			pMap->pEnd = pFound->pPrev;
-		}
-		free(pFound->pKey);
-		memset(pFound, 0, sizeof(struct KVP));
-		struct KVP* pMoveable = FindMoveableKey(pFound, pMap);
-		while (pMoveable)
-		{
-			if (pMoveable->pNext)
-			{
-				pMoveable->pNext->pPrev = pFound;
-			}
-			if (pMoveable->pPrev)
-			{
-				pMoveable->pPrev->pNext = pFound;
-			}
-			if (pMap->pEnd == pMoveable)
-			{
-				pMap->pEnd = pFound;
-			}
-			if (pMap->pHead == pMoveable)
-			{
-				pMap->pHead = pFound;
-			}
-			memcpy(pFound, pMoveable, sizeof(struct KVP) + pMap->valueSize);
-			memset(pMoveable, 0, sizeof(struct KVP) + pMap->valueSize);
-			pFound = pMoveable;
-			pMoveable = FindMoveableKey(pMoveable, pMap);
-		}
-		pMap->size--;
-		return true;
+		return false;
+	}
+	EntryAt(pMap, pMap->pSlotEntries[slot])->keyOffset = -1;
+	int group = slot / GROUP_WIDTH;
+	if (MatchEmpty(LoadGroup(pMap, group)))
+	{
+		pMap->pCtrl[slot] = CTRL_EMPTY;
+	}
+	else
+	{
+		pMap->pCtrl[slot] = CTRL_DELETED;
+		pMap->numTombstones++;
 	}
-	return false;
+	pMap->size--;
+	return true;
 }
 
 
@@ -372,7 +375,7 @@ struct HashmapKeyIterator GetKeyIterator(struct HashMap* pHashMap)
 {
 	struct HashmapKeyIterator itr = {
 		pHashMap,
-		pHashMap->pHead
+		0
 	};
 	return itr;
 }
@@ -380,23 +383,21 @@ struct HashmapKeyIterator GetKeyIterator(struct HashMap* pHashMap)
 char* NextHashmapKey(struct HashmapKeyIterator* itr)
 {
 	EASSERT(itr->pHashMap);
-	if (!itr->pOnKVP)
+	struct HashMap* pMap = itr->pHashMap;
+	while (itr->onEntry < pMap->numEntries)
 	{
-		return NULL;
+		struct HashmapEntry* pEntry = EntryAt(pMap, itr->onEntry++);
+		if (pEntry->keyOffset >= 0)
+		{
+			return pMap->pKeySlab + pEntry->keyOffset;
+		}
 	}
-	char* r = itr->pOnKVP->pKey;
-	itr->pOnKVP = itr->pOnKVP->pNext;
-	return r;
+	return NULL;
 }
 
 void HashmapDeInit(struct HashMap* pMap)
 {
-	struct KVP* pKVP = pMap->pHead;
-	while (pKVP)
-	{
-		EASSERT(pKVP->pKey);
-		free(pKVP->pKey);
-		pKVP = pKVP->pNext;
-	}
-	free(pMap->pData);
+	FreeTable(pMap);
+	free(pMap->pKeySlab);
+	memset(pMap, 0, sizeof(struct HashMap));
 }
@@ -0,0 +1,310 @@
+#include "WorkerPool.h"
+#include "AssertLib.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+typedef CRITICAL_SECTION PoolMutex;
+typedef CONDITION_VARIABLE PoolCond;
+typedef HANDLE PoolThread;
+
+static void MutexInit(PoolMutex* pMutex)    { InitializeCriticalSection(pMutex); }
+static void MutexDestroy(PoolMutex* pMutex) { DeleteCriticalSection(pMutex); }
+static void MutexLock(PoolMutex* pMutex)    { EnterCriticalSection(pMutex); }
+static void MutexUnlock(PoolMutex* pMutex)  { LeaveCriticalSection(pMutex); }
+static void CondInit(PoolCond* pCond)       { InitializeConditionVariable(pCond); }
+static void CondDestroy(PoolCond* pCond)    { (void)pCond; }
+static void CondWait(PoolCond* pCond, PoolMutex* pMutex) { SleepConditionVariableCS(pCond, pMutex, INFINITE); }
+static void CondSignal(PoolCond* pCond)     { WakeConditionVariable(pCond); }
+static void CondBroadcast(PoolCond* pCond)  { WakeAllConditionVariable(pCond); }
+
+#else
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t PoolMutex;
+typedef pthread_cond_t PoolCond;
+typedef pthread_t PoolThread;
+
+static void MutexInit(PoolMutex* pMutex)    { pthread_mutex_init(pMutex, NULL); }
+static void MutexDestroy(PoolMutex* pMutex) { pthread_mutex_destroy(pMutex); }
+static void MutexLock(PoolMutex* pMutex)    { pthread_mutex_lock(pMutex); }
+static void MutexUnlock(PoolMutex* pMutex)  { pthread_mutex_unlock(pMutex); }
+static void CondInit(PoolCond* pCond)       { pthread_cond_init(pCond, NULL); }
+static void CondDestroy(PoolCond* pCond)    { pthread_cond_destroy(pCond); }
+static void CondWait(PoolCond* pCond, PoolMutex* pMutex) { pthread_cond_wait(pCond, pMutex); }
+static void CondSignal(PoolCond* pCond)     { pthread_cond_signal(pCond); }
+static void CondBroadcast(PoolCond* pCond)  { pthread_cond_broadcast(pCond); }
+
+#endif
+
+struct WorkerJob
+{
+	WorkerJobFn fn;
+	WorkerJobFn onComplete;
+	void* pArg;
+};
+
+/* ring buffer, capacity is a power of 2 */
+struct JobQueue
+{
+	struct WorkerJob* pJobs;
+	int capacity;
+	int head;
+	int size;
+};
+
+struct WorkerPool
+{
+	PoolMutex mutex;
+	/* signalled when a job is queued or the pool is stopping */
+	PoolCond jobQueued;
+	/* signalled when a job finishes */
+	PoolCond jobFinished;
+
+	struct JobQueue queued;
+	/* finished jobs whose onComplete is waiting for WP_RunCompleted */
+	struct JobQueue completed;
+	/* queued plus running */
+	int numOutstanding;
+	bool bStopping;
+
+	PoolThread* pThreads;
+	int numThreads;
+};
+
+static void JobQueueInit(struct JobQueue* pQueue)
+{
+	pQueue->capacity = 64;
+	pQueue->pJobs = malloc(sizeof(struct WorkerJob) * pQueue->capacity);
+	pQueue->head = 0;
+	pQueue->size = 0;
+}
+
+static void JobQueuePush(struct JobQueue* pQueue, const struct WorkerJob* pJob)
+{
+	if (pQueue->size == pQueue->capacity)
+	{
+		int newCapacity = pQueue->capacity * 2;
+		struct WorkerJob* pNewJobs = malloc(sizeof(struct WorkerJob) * newCapacity);
+		for (int i = 0; i < pQueue->size; i++)
+		{
+			pNewJobs[i] = pQueue->pJobs[(pQueue->head + i) & (pQueue->capacity - 1)];
+		}
+		free(pQueue->pJobs);
+		pQueue->pJobs = pNewJobs;
+		pQueue->capacity = newCapacity;
+		pQueue->head = 0;
+	}
+	pQueue->pJobs[(pQueue->head + pQueue->size) & (pQueue->capacity - 1)] = *pJob;
+	pQueue->size++;
+}
+
+static struct WorkerJob JobQueuePop(struct JobQueue* pQueue)
+{
+	struct WorkerJob job = pQueue->pJobs[pQueue->head];
+	pQueue->head = (pQueue->head + 1) & (pQueue->capacity - 1);
+	pQueue->size--;
+	return job;
+}
+
+static void RunJobs(struct WorkerPool* pPool)
+{
+	MutexLock(&pPool->mutex);
+	while (true)
+	{
+		while (pPool->queued.size == 0 && !pPool->bStopping)
+		{
+			CondWait(&pPool->jobQueued, &pPool->mutex);
+		}
+		if (pPool->queued.size == 0)
+		{
+			break;
+		}
+		struct WorkerJob job = JobQueuePop(&pPool->queued);
+		MutexUnlock(&pPool->mutex);
+
+		job.fn(job.pArg);
+
+		MutexLock(&pPool->mutex);
+		if (job.onComplete)
+		{
+			JobQueuePush(&pPool->completed, &job);
+		}
+		pPool->numOutstanding--;
+		CondBroadcast(&pPool->jobFinished);
+	}
+	MutexUnlock(&pPool->mutex);
+}
+
+#if defined(_WIN32)
+
+static DWORD WINAPI WorkerThreadMain(LPVOID pArg)
+{
+	RunJobs(pArg);
+	return 0;
+}
+
+int WP_GetNumCPUs(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+static bool StartThread(PoolThread* pOutThread, struct WorkerPool* pPool)
+{
+	*pOutThread = CreateThread(NULL, 0, &WorkerThreadMain, pPool, 0, NULL);
+	return *pOutThread != NULL;
+}
+
+static void JoinThread(PoolThread thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+#else
+
+static void* WorkerThreadMain(void* pArg)
+{
+	RunJobs(pArg);
+	return NULL;
+}
+
+int WP_GetNumCPUs(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+}
+
+static bool StartThread(PoolThread* pOutThread, struct WorkerPool* pPool)
+{
+	return pthread_create(pOutThread, NULL, &WorkerThreadMain, pPool) == 0;
+}
+
+static void JoinThread(PoolThread thread)
+{
+	pthread_join(thread, NULL);
+}
+
+#endif
+
+struct WorkerPool* WP_Create(int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = WP_GetNumCPUs();
+	}
+	struct WorkerPool* pPool = malloc(sizeof(struct WorkerPool));
+	memset(pPool, 0, sizeof(struct WorkerPool));
+	MutexInit(&pPool->mutex);
+	CondInit(&pPool->jobQueued);
+	CondInit(&pPool->jobFinished);
+	JobQueueInit(&pPool->queued);
+	JobQueueInit(&pPool->completed);
+	pPool->pThreads = malloc(sizeof(PoolThread) * numThreads);
+	for (int i = 0; i < numThreads; i++)
+	{
+		if (!StartThread(&pPool->pThreads[pPool->numThreads], pPool))
+		{
+			break;
+		}
+		pPool->numThreads++;
+	}
+	/* with no threads at all WP_Submit runs jobs itself */
+	return pPool;
+}
+
+void WP_Destroy(struct WorkerPool* pPool)
+{
+	MutexLock(&pPool->mutex);
+	pPool->bStopping = true;
+	CondBroadcast(&pPool->jobQueued);
+	MutexUnlock(&pPool->mutex);
+	for (int i = 0; i < pPool->numThreads; i++)
+	{
+		JoinThread(pPool->pThreads[i]);
+	}
+	CondDestroy(&pPool->jobQueued);
+	CondDestroy(&pPool->jobFinished);
+	MutexDestroy(&pPool->mutex);
+	free(pPool->pThreads);
+	free(pPool->queued.pJobs);
+	free(pPool->completed.pJobs);
+	free(pPool);
+}
+
+void WP_Submit(struct WorkerPool* pPool, WorkerJobFn fn, void* pArg)
+{
+	WP_SubmitWithCompletion(pPool, fn, NULL, pArg);
+}
+
+void WP_SubmitWithCompletion(struct WorkerPool* pPool, WorkerJobFn fn, WorkerJobFn onComplete, void* pArg)
+{
+	EASSERT(fn);
+	struct WorkerJob job = { fn, onComplete, pArg };
+	if (pPool->numThreads == 0)
+	{
+		fn(pArg);
+		if (onComplete)
+		{
+			JobQueuePush(&pPool->completed, &job);
+		}
+		return;
+	}
+	MutexLock(&pPool->mutex);
+	JobQueuePush(&pPool->queued, &job);
+	pPool->numOutstanding++;
+	CondSignal(&pPool->jobQueued);
+	MutexUnlock(&pPool->mutex);
+}
+
+void WP_WaitIdle(struct WorkerPool* pPool)
+{
+	MutexLock(&pPool->mutex);
+	while (pPool->numOutstanding > 0)
+	{
+		CondWait(&pPool->jobFinished, &pPool->mutex);
+	}
+	MutexUnlock(&pPool->mutex);
+}
+
+void WP_WaitCompleted(struct WorkerPool* pPool)
+{
+	MutexLock(&pPool->mutex);
+	while (pPool->completed.size == 0 && pPool->numOutstanding > 0)
+	{
+		CondWait(&pPool->jobFinished, &pPool->mutex);
+	}
+	MutexUnlock(&pPool->mutex);
+}
+
+int WP_RunCompleted(struct WorkerPool* pPool)
+{
+	int numRun = 0;
+	while (true)
+	{
+		/* one at a time so an onComplete can submit more jobs */
+		MutexLock(&pPool->mutex);
+		if (pPool->completed.size == 0)
+		{
+			MutexUnlock(&pPool->mutex);
+			break;
+		}
+		struct WorkerJob job = JobQueuePop(&pPool->completed);
+		MutexUnlock(&pPool->mutex);
+		job.onComplete(job.pArg);
+		numRun++;
+	}
+	return numRun;
+}
+
+int WP_GetNumThreads(const struct WorkerPool* pPool)
+{
+	return pPool->numThreads;
+}
@@ -4,6 +4,7 @@
 #include "DrawContext.h"
 #include "AssertLib.h"
 #include "GameFrameworkEvent.h"
+#include "Profiler.h"
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -70,6 +71,7 @@ void GF_PopGameFrameworkLayer()
 
 void GF_EndFrame(DrawContext* drawContext, InputContext* inputContext)
 {
+	PROFILE_ZONE("GF.DrainEventQueue") Ev_DrainEventQueue();
 	for (int i = 0; i < VectorSize(gLayerChangeQueue); i++)
 	{
 		if (gLayerChangeQueue[i].bIsPush)
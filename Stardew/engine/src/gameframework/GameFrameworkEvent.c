@@ -3,114 +3,202 @@
 #include <string.h>
 #include <stdio.h>
 #include "StringKeyHashMap.h"
+#include "DynArray.h"
 #include "AssertLib.h"
 
-#define EVENT_MAX_NAME_LEN 64
+/* event name -> HEvent */
+static struct HashMap gEventIdMap;
 
-static struct HashMap gEventMap;
+/* indexed by HEvent */
+static VECTOR(struct GameFrameworkEvent) gEvents = NULL;
+
+/* queued events: a struct QueuedEventHeader followed by its args, padded to QUEUED_EVENT_ALIGNMENT */
+static VECTOR(u8) gEventQueue = NULL;
+/* the queue is swapped with this while draining */
+static VECTOR(u8) gDrainingEventQueue = NULL;
+
+#define QUEUED_EVENT_ALIGNMENT 16
 
 struct GameFrameworkEventListener
 {
 	void* userData;
+	HEvent event;
+};
+
+/* copy of the listener's callback, stored contiguously per event so firing doesn't chase pointers */
+struct ListenerEntry
+{
 	EventListenerFn eventFn;
-	struct GameFrameworkEventListener* pNext;
-	struct GameFrameworkEventListener* pPrev;
-	char eventName[EVENT_MAX_NAME_LEN];
+	void* userData;
+	/* NULL if unsubscribed while the event was being fired, removed once it finishes */
+	struct GameFrameworkEventListener* pListener;
 };
 
 struct GameFrameworkEvent
 {
-	struct GameFrameworkEventListener* pListenerHead;
-	struct GameFrameworkEventListener* pListenerTail;
+	VECTOR(struct ListenerEntry) listeners;
+	int firingDepth;
+	bool bHasRemovedListeners;
+};
+
+struct QueuedEventHeader
+{
+	HEvent event;
+	u32 argsSize;
+	u8 _padding[QUEUED_EVENT_ALIGNMENT - 2 * sizeof(u32)];
 };
 
-static struct GameFrameworkEventListener* AddListener(struct GameFrameworkEvent* pEvent, EventListenerFn listenerFn, void* pUser, char* eventName)
+static u32 QueuedArgsStride(u32 argsSize)
+{
+	return (argsSize + QUEUED_EVENT_ALIGNMENT - 1) & ~(QUEUED_EVENT_ALIGNMENT - 1);
+}
+
+HEvent Ev_RegisterEventName(const char* eventName)
+{
+	HEvent* pId = HashmapSearch(&gEventIdMap, eventName);
+	if (pId)
+	{
+		return *pId;
+	}
+	struct GameFrameworkEvent ev;
+	memset(&ev, 0, sizeof(struct GameFrameworkEvent));
+	ev.listeners = NEW_VECTOR(struct ListenerEntry);
+	HEvent id = VectorSize(gEvents);
+	gEvents = VectorPush(gEvents, &ev);
+	HashmapInsert(&gEventIdMap, eventName, &id);
+	return id;
+}
+
+struct GameFrameworkEventListener* Ev_SubscribeEventById(HEvent event, EventListenerFn listenerFn, void* pUser)
 {
+	EASSERT(event >= 0 && event < (HEvent)VectorSize(gEvents));
 	struct GameFrameworkEventListener* pListener = malloc(sizeof(struct GameFrameworkEventListener));
 	EASSERT(pListener);
-	memset(pListener, 0, sizeof(struct GameFrameworkEventListener));
-	strcpy(pListener->eventName, eventName);
-	pListener->eventFn = listenerFn;
 	pListener->userData = pUser;
-	if (!pEvent->pListenerTail)
-	{
-		EASSERT(!pEvent->pListenerHead);
-		pEvent->pListenerTail = pListener;
-		pEvent->pListenerHead = pListener;
-	}
-	else
-	{
-		pEvent->pListenerTail->pNext = pListener;
-		pListener->pPrev = pEvent->pListenerTail;
-		pEvent->pListenerTail = pListener;
-	}
+	pListener->event = event;
+
+	struct ListenerEntry entry = { listenerFn, pUser, pListener };
+	gEvents[event].listeners = VectorPush(gEvents[event].listeners, &entry);
 	return pListener;
 }
 
 struct GameFrameworkEventListener* Ev_SubscribeEvent(char* eventName, EventListenerFn listenerFn, void* pUser)
 {
-	EASSERT(strlen(eventName) < EVENT_MAX_NAME_LEN);
-	struct GameFrameworkEvent* pEvent = HashmapSearch(&gEventMap, eventName);
-	if (pEvent == NULL)
+	return Ev_SubscribeEventById(Ev_RegisterEventName(eventName), listenerFn, pUser);
+}
+
+static void RemoveUnsubscribedListeners(struct GameFrameworkEvent* pEvent)
+{
+	int kept = 0;
+	int size = VectorSize(pEvent->listeners);
+	for (int i = 0; i < size; i++)
 	{
-		struct GameFrameworkEvent ev;
-		memset(&ev, 0, sizeof(struct GameFrameworkEvent));
-		pEvent = HashmapInsert(&gEventMap, eventName, &ev);
+		if (pEvent->listeners[i].pListener)
+		{
+			pEvent->listeners[kept++] = pEvent->listeners[i];
+		}
 	}
-	return AddListener(pEvent, listenerFn, pUser, eventName);
+	for (int i = kept; i < size; i++)
+	{
+		VectorPop(pEvent->listeners);
+	}
+	pEvent->bHasRemovedListeners = false;
 }
 
 bool Ev_UnsubscribeEvent(struct GameFrameworkEventListener* pListener)
 {
-	struct GameFrameworkEvent* pEvent = HashmapSearch(&gEventMap, pListener->eventName);
-	if (pEvent)
+	struct GameFrameworkEvent* pEvent = &gEvents[pListener->event];
+	for (int i = 0; i < VectorSize(pEvent->listeners); i++)
 	{
-		if (pEvent->pListenerHead == pListener)
-		{
-			pEvent->pListenerHead = pListener->pNext;
-		}
-		if (pEvent->pListenerTail == pListener)
+		if (pEvent->listeners[i].pListener == pListener)
 		{
-			pEvent->pListenerTail = pListener->pPrev;
+			/* listeners keep their subscription order, if the event is being fired they're removed once it finishes */
+			pEvent->listeners[i].pListener = NULL;
+			pEvent->bHasRemovedListeners = true;
+			if (pEvent->firingDepth == 0)
+			{
+				RemoveUnsubscribedListeners(pEvent);
+			}
+			free(pListener);
+			return true;
 		}
-		if (pListener->pNext)
-		{
-			pListener->pNext->pPrev = pListener->pPrev;
-		}
-		if (pListener->pPrev)
+	}
+	printf("Ev_UnsubscribeEvent failed. Event id '%i'", pListener->event);
+	return false;
+}
+
+void Ev_FireEventById(HEvent event, void* eventArgs)
+{
+	EASSERT(event >= 0 && event < (HEvent)VectorSize(gEvents));
+	gEvents[event].firingDepth++;
+	/*
+		listeners can subscribe and unsubscribe, or register new events, while this runs,
+		so index rather than hold pointers into gEvents or the listener vector
+	*/
+	for (int i = 0; i < VectorSize(gEvents[event].listeners); i++)
+	{
+		struct ListenerEntry entry = gEvents[event].listeners[i];
+		if (entry.pListener)
 		{
-			pListener->pPrev->pNext = pListener->pNext;
+			entry.eventFn(entry.userData, eventArgs);
 		}
-		free(pListener);
-		return true;
 	}
-	else
+	struct GameFrameworkEvent* pEvent = &gEvents[event];
+	if (--pEvent->firingDepth == 0 && pEvent->bHasRemovedListeners)
 	{
-		printf("Ev_UnsubscribeEvent failed. Event name '%s'", pListener->eventName);
+		RemoveUnsubscribedListeners(pEvent);
 	}
-	return false;
 }
 
 void Ev_FireEvent(char* eventName, void* eventArgs)
 {
-	struct GameFrameworkEvent* pEvent = HashmapSearch(&gEventMap, eventName);
-	if (pEvent)
+	HEvent* pId = HashmapSearch(&gEventIdMap, eventName);
+	if (pId)
 	{
-		struct GameFrameworkEventListener* pListener = pEvent->pListenerHead;
-		while (pListener)
-		{
-			pListener->eventFn(pListener->userData, eventArgs);
-			pListener = pListener->pNext;
-		}
+		Ev_FireEventById(*pId, eventArgs);
 	}
 }
 
+void Ev_QueueEvent(HEvent event, const void* eventArgs, u32 argsSize)
+{
+	EASSERT(event >= 0 && event < (HEvent)VectorSize(gEvents));
+	struct QueuedEventHeader* pHeader = NULL;
+	gEventQueue = VectorEmplaceN(gEventQueue, sizeof(struct QueuedEventHeader) + QueuedArgsStride(argsSize), (void**)&pHeader);
+	pHeader->event = event;
+	pHeader->argsSize = argsSize;
+	if (argsSize)
+	{
+		memcpy(pHeader + 1, eventArgs, argsSize);
+	}
+}
+
+void Ev_DrainEventQueue()
+{
+	VECTOR(u8) pDraining = gEventQueue;
+	gEventQueue = VectorClear(gDrainingEventQueue);
+	u32 offset = 0;
+	while (offset < VectorSize(pDraining))
+	{
+		struct QueuedEventHeader* pHeader = (struct QueuedEventHeader*)(pDraining + offset);
+		Ev_FireEventById(pHeader->event, pHeader->argsSize ? pHeader + 1 : NULL);
+		offset += sizeof(struct QueuedEventHeader) + QueuedArgsStride(pHeader->argsSize);
+	}
+	gDrainingEventQueue = VectorClear(pDraining);
+}
+
 void Ev_Init()
 {
-	HashmapInit(&gEventMap, 16, sizeof(struct GameFrameworkEvent));
+	if (gEvents)
+	{
+		return;
+	}
+	HashmapInit(&gEventIdMap, 16, sizeof(HEvent));
+	gEvents = NEW_VECTOR(struct GameFrameworkEvent);
+	gEventQueue = NEW_VECTOR(u8);
+	gDrainingEventQueue = NEW_VECTOR(u8);
 }
 
 void* Ev_GetUserData(struct GameFrameworkEventListener* pListener)
 {
 	return pListener->userData;
-}
\ No newline at end of file
+}
@@ -5,6 +5,7 @@
 #include "DynArray.h"
 #include "Atlas.h"
 #include "AssertLib.h"
+#include "StringKeyHashMap.h"
 
 void AnimatedSprite_OnInit(struct AnimatedSprite* pAnimatedSprite, struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, float deltaT)
 {
@@ -14,20 +15,30 @@ void AnimatedSprite_OnInit(struct AnimatedSprite* pAnimatedSprite, struct Entity
     pAnimatedSprite->pSprites = pAnim->frames;
     pAnimatedSprite->numSprites = VectorSize(pAnim->frames);
     pAnimatedSprite->fps = pAnim->fps;
+    Et2D_MarkBoundingBoxDirty(pEnt);
+}
 
+void AnimatedSprite_SetAnimation(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt, struct AnimatedSprite* pSpriteComp, const char* animName, bool bResetOnFrame, bool bResetTimer)
+{
+    AnimatedSprite_SetAnimationHashed(pLayer, pEnt, pSpriteComp, animName, HashmapHashKey(animName), bResetOnFrame, bResetTimer);
 }
 
-void AnimatedSprite_SetAnimation(struct GameFrameworkLayer* pLayer, struct AnimatedSprite* pSpriteComp, const char* animName, bool bResetOnFrame, bool bResetTimer)
+void AnimatedSprite_SetAnimationHashed(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt, struct AnimatedSprite* pSpriteComp, const char* animName, u32 animNameHash, bool bResetOnFrame, bool bResetTimer)
 {
     struct GameLayer2DData* pData = pLayer->userData;
     pSpriteComp->animationName = animName;
-    struct AtlasAnimation* pAnim = At_FindAnim(pData->hAtlas, pSpriteComp->animationName);
+    struct AtlasAnimation* pAnim = At_FindAnimHashed(pData->hAtlas, pSpriteComp->animationName, animNameHash);
+    if(pSpriteComp->pSprites != pAnim->frames)
+    {
+        Et2D_MarkBoundingBoxDirty(pEnt);
+    }
     pSpriteComp->pSprites = pAnim->frames;
     pSpriteComp->numSprites = VectorSize(pAnim->frames);
     pSpriteComp->fps = pAnim->fps;
-    if(bResetOnFrame)
+    if(bResetOnFrame && pSpriteComp->onSprite != 0)
     {
         pSpriteComp->onSprite = 0;
+        Et2D_MarkBoundingBoxDirty(pEnt);
     }
     if(bResetTimer)
     {
@@ -62,6 +73,7 @@ void AnimatedSprite_OnUpdate(struct AnimatedSprite* pAnimatedSprite, struct Enti
                 }
             }
             pAnimatedSprite->timer = 0.0f;
+            Et2D_MarkBoundingBoxDirty(pEnt);
         }
     }
 }
@@ -6,10 +6,15 @@
 #include "Game2DLayer.h"
 #include "Sprite.h"
 #include "AnimatedSprite.h"
+#include "Entity2DCollection.h"
+#include "Atlas.h"
+#include "Game2DVertexOutputHelpers.h"
+#include <string.h>
 
 void Co_InitComponents(struct Entity2D* entity, struct GameFrameworkLayer* pLayer)
 {
     struct GameLayer2DData* pGameLayerData = pLayer->userData;
+    struct Entity2DCollection* pCollection = &pGameLayerData->entities;
     for(int i=0; i<entity->numComponents; i++)
     {
         switch(entity->components[i].type)
@@ -17,32 +22,38 @@ void Co_InitComponents(struct Entity2D* entity, struct GameFrameworkLayer* pLaye
         case ETE_Sprite:
             break;
         case ETE_StaticCollider:
-            entity->components[i].data.staticCollider.id = Ph_GetStaticBody2D(
-                pGameLayerData->hPhysicsWorld,
-                &entity->components[i].data.staticCollider.shape, 
-                &entity->transform, 
-                entity->thisEntity,
-                entity->components[i].data.staticCollider.bIsSensor,
-                i,
-                entity->components[i].data.staticCollider.bGenerateSensorEvents
-            );
+            {
+                struct StaticCollider* pCollider = Co_GetStaticCollider(pCollection, entity, i);
+                pCollider->id = Ph_GetStaticBody2D(
+                    pGameLayerData->hPhysicsWorld,
+                    &pCollider->shape, 
+                    &entity->transform, 
+                    entity->thisEntity,
+                    pCollider->bIsSensor,
+                    i,
+                    pCollider->bGenerateSensorEvents
+                );
+            }
             break;
         case ETE_DynamicCollider:
-            entity->components[i].data.dynamicCollider.id = Ph_GetDynamicBody(
-                pGameLayerData->hPhysicsWorld, 
-                &entity->components[i].data.dynamicCollider.shape, 
-                &entity->components[i].data.dynamicCollider.options, 
-                &entity->transform, 
-                entity->thisEntity,
-                entity->components[i].data.dynamicCollider.bIsSensor,
-                i,
-                entity->components[i].data.dynamicCollider.bGenerateSensorEvents
-            );
+            {
+                struct DynamicCollider* pCollider = Co_GetDynamicCollider(pCollection, entity, i);
+                pCollider->id = Ph_GetDynamicBody(
+                    pGameLayerData->hPhysicsWorld, 
+                    &pCollider->shape, 
+                    &pCollider->options, 
+                    &entity->transform, 
+                    entity->thisEntity,
+                    pCollider->bIsSensor,
+                    i,
+                    pCollider->bGenerateSensorEvents
+                );
+            }
             break;
         case ETE_TextSprite:
             break;
         case ETE_SpriteAnimator:
-            AnimatedSprite_OnInit(&entity->components[i].data.spriteAnimator, entity, pLayer, 0.0f);
+            AnimatedSprite_OnInit(Co_GetAnimatedSprite(pCollection, entity, i), entity, pLayer, 0.0f);
             break;
         default:
             EASSERT(false);
@@ -52,6 +63,11 @@ void Co_InitComponents(struct Entity2D* entity, struct GameFrameworkLayer* pLaye
 
 void Co_UpdateComponents(struct Entity2D* entity, struct GameFrameworkLayer* pLayer, float deltaT)
 {
+    if(entity->bComponentsInStore)
+    {
+        /* Co_UpdateComponentStore updates them */
+        return;
+    }
     for(int i=0; i<entity->numComponents; i++)
     {
         switch(entity->components[i].type)
@@ -129,13 +145,15 @@ void Co_DrawComponents(
     VECTOR(VertIndexT)* outIndices,
     VertIndexT* pNextIndex)
 {
+    struct GameLayer2DData* pGameLayerData = pLayer->userData;
+    struct Entity2DCollection* pCollection = &pGameLayerData->entities;
     for(int i=0; i<entity->numComponents; i++)
     {
         switch(entity->components[i].type)
         {
         case ETE_Sprite:
             SpriteComp_Draw(
-                &entity->components[i].data.sprite,
+                Co_GetSprite(pCollection, entity, i),
                 entity,
                 pLayer,
                 pCam,
@@ -152,7 +170,7 @@ void Co_DrawComponents(
             break;
         case ETE_SpriteAnimator:
             AnimatedSprite_Draw(
-                &entity->components[i].data.spriteAnimator,
+                Co_GetAnimatedSprite(pCollection, entity, i),
                 entity,
                 pLayer,
                 pCam,
@@ -165,4 +183,225 @@ void Co_DrawComponents(
             EASSERT(false);
         }
     }
-}
\ No newline at end of file
+}
+
+/* indexed by enum ComponentType */
+static const size_t gComponentSizes[NUM_STORED_COMPONENT_TYPES] =
+{
+    sizeof(struct Sprite),
+    sizeof(struct StaticCollider),
+    sizeof(struct DynamicCollider),
+    sizeof(struct TextSprite),
+    sizeof(struct AnimatedSprite)
+};
+
+void Co_InitComponentStore(struct ComponentStore* pStore, bool bEnabled)
+{
+    EASSERT(ETE_Last == NUM_STORED_COMPONENT_TYPES);
+    memset(pStore, 0, sizeof(struct ComponentStore));
+    pStore->bEnabled = bEnabled;
+    if(!bEnabled)
+    {
+        return;
+    }
+    for(int i=0; i<NUM_STORED_COMPONENT_TYPES; i++)
+    {
+        pStore->pComponents[i] = VectorInit(gComponentSizes[i]);
+        pStore->pOwners[i] = NEW_VECTOR(struct ComponentStoreOwner);
+    }
+}
+
+void Co_DestroyComponentStore(struct ComponentStore* pStore)
+{
+    if(!pStore->bEnabled)
+    {
+        return;
+    }
+    for(int i=0; i<NUM_STORED_COMPONENT_TYPES; i++)
+    {
+        DestoryVector(pStore->pComponents[i]);
+        DestoryVector(pStore->pOwners[i]);
+    }
+    memset(pStore, 0, sizeof(struct ComponentStore));
+}
+
+void Co_StoreComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt)
+{
+    struct ComponentStore* pStore = &pCollection->componentStore;
+    pEnt->bComponentsInStore = false;
+    /* entities with their own update or draw expect to find their components inline */
+    if(!pStore->bEnabled || pEnt->update != &Entity2DUpdate || pEnt->draw != &Entity2DDraw)
+    {
+        return;
+    }
+    for(int i=0; i<pEnt->numComponents; i++)
+    {
+        enum ComponentType type = pEnt->components[i].type;
+        EASSERT(type >= 0 && type < ETE_Last);
+        struct ComponentStoreOwner owner = { pEnt->thisEntity, i };
+        pEnt->componentSlots[i] = VectorSize(pStore->pComponents[type]);
+        pStore->pComponents[type] = VectorPush(pStore->pComponents[type], &pEnt->components[i].data);
+        pStore->pOwners[type] = VectorPush(pStore->pOwners[type], &owner);
+    }
+    pEnt->bComponentsInStore = true;
+}
+
+void Co_RemoveStoredComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt)
+{
+    if(!pEnt->bComponentsInStore)
+    {
+        return;
+    }
+    struct ComponentStore* pStore = &pCollection->componentStore;
+    for(int i=0; i<pEnt->numComponents; i++)
+    {
+        enum ComponentType type = pEnt->components[i].type;
+        char* pComponents = pStore->pComponents[type];
+        struct ComponentStoreOwner* pOwners = pStore->pOwners[type];
+        size_t size = gComponentSizes[type];
+        int slot = pEnt->componentSlots[i];
+        int last = VectorSize(pComponents) - 1;
+        if(slot != last)
+        {
+            /* move the last component into the gap, it may be one of this entities yet to be removed */
+            memcpy(pComponents + slot * size, pComponents + last * size, size);
+            pOwners[slot] = pOwners[last];
+            struct Entity2D* pMoved = Et2D_GetEntity(pCollection, pOwners[slot].hEnt);
+            pMoved->componentSlots[pOwners[slot].componentIndex] = slot;
+        }
+        VectorPop(pComponents);
+        VectorPop(pOwners);
+    }
+    pEnt->bComponentsInStore = false;
+}
+
+void Co_GatherComponents(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, struct Entity2D* pOutEnt)
+{
+    memcpy(pOutEnt, pEnt, sizeof(struct Entity2D));
+    if(!pEnt->bComponentsInStore)
+    {
+        return;
+    }
+    for(int i=0; i<pEnt->numComponents; i++)
+    {
+        memcpy(&pOutEnt->components[i].data, Co_GetComponentData(pCollection, pEnt, i), gComponentSizes[pEnt->components[i].type]);
+    }
+    pOutEnt->bComponentsInStore = false;
+}
+
+void* Co_GetComponentData(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    if(!pEnt->bComponentsInStore)
+    {
+        return &pEnt->components[i].data;
+    }
+    enum ComponentType type = pEnt->components[i].type;
+    char* pComponents = pCollection->componentStore.pComponents[type];
+    return pComponents + pEnt->componentSlots[i] * gComponentSizes[type];
+}
+
+struct Sprite* Co_GetSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    EASSERT(pEnt->components[i].type == ETE_Sprite);
+    return Co_GetComponentData(pCollection, pEnt, i);
+}
+
+struct StaticCollider* Co_GetStaticCollider(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    EASSERT(pEnt->components[i].type == ETE_StaticCollider);
+    return Co_GetComponentData(pCollection, pEnt, i);
+}
+
+struct DynamicCollider* Co_GetDynamicCollider(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    EASSERT(pEnt->components[i].type == ETE_DynamicCollider);
+    return Co_GetComponentData(pCollection, pEnt, i);
+}
+
+struct TextSprite* Co_GetTextSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    EASSERT(pEnt->components[i].type == ETE_TextSprite);
+    return Co_GetComponentData(pCollection, pEnt, i);
+}
+
+struct AnimatedSprite* Co_GetAnimatedSprite(struct Entity2DCollection* pCollection, struct Entity2D* pEnt, int i)
+{
+    EASSERT(pEnt->components[i].type == ETE_SpriteAnimator);
+    return Co_GetComponentData(pCollection, pEnt, i);
+}
+
+void Co_UpdateComponentStore(struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer, float deltaT)
+{
+    struct ComponentStore* pStore = &pCollection->componentStore;
+    if(!pStore->bEnabled)
+    {
+        return;
+    }
+    /* animated sprites are the only built in component that updates */
+    struct AnimatedSprite* pAnimatedSprites = pStore->pComponents[ETE_SpriteAnimator];
+    struct ComponentStoreOwner* pOwners = pStore->pOwners[ETE_SpriteAnimator];
+    for(int i=0; i<VectorSize(pAnimatedSprites); i++)
+    {
+        AnimatedSprite_OnUpdate(&pAnimatedSprites[i], Et2D_GetEntity(pCollection, pOwners[i].hEnt), pLayer, deltaT);
+    }
+}
+
+/* the same as SpriteComp_GetBoundingBox and AnimatedSprite_GetBoundingBox */
+static void GetStoredSpriteBoundingBox(struct Entity2D* pEnt, AtlasSprite* pSprite, struct Transform2D* pComponentTransform, vec2 outTL, vec2 outBR)
+{
+    outTL[0] = pEnt->transform.position[0] + pComponentTransform->position[0];
+    outTL[1] = pEnt->transform.position[1] + pComponentTransform->position[1];
+    outBR[0] = outTL[0] + pSprite->widthPx  * pEnt->transform.scale[0] * pComponentTransform->scale[0];
+    outBR[1] = outTL[1] + pSprite->heightPx * pEnt->transform.scale[1] * pComponentTransform->scale[1];
+}
+
+void Co_DrawComponentStore(
+    struct Entity2DCollection* pCollection,
+    struct GameFrameworkLayer* pLayer,
+    VECTOR(Worldspace2DVert)* outVerts,
+    VECTOR(VertIndexT)* outIndices,
+    VertIndexT* pNextIndex)
+{
+    struct ComponentStore* pStore = &pCollection->componentStore;
+    if(!pStore->bEnabled)
+    {
+        return;
+    }
+    struct GameLayer2DData* pLayerData = pLayer->userData;
+    struct Sprite* pSprites = pStore->pComponents[ETE_Sprite];
+    struct AnimatedSprite* pAnimatedSprites = pStore->pComponents[ETE_SpriteAnimator];
+    int numSprites = VectorSize(pSprites);
+    int numAnimatedSprites = VectorSize(pAnimatedSprites);
+
+    /* room for every quad up front rather than growing the vectors sprite by sprite */
+    Worldspace2DVert* pVerts = NULL;
+    VertIndexT* pIndices = NULL;
+    *outVerts = VectorEmplaceN(*outVerts, (numSprites + numAnimatedSprites) * 4, (void**)&pVerts);
+    *outIndices = VectorEmplaceN(*outIndices, (numSprites + numAnimatedSprites) * 6, (void**)&pIndices);
+
+    struct ComponentStoreOwner* pOwners = pStore->pOwners[ETE_Sprite];
+    for(int i=0; i<numSprites; i++)
+    {
+        struct Entity2D* pEnt = Et2D_GetEntity(pCollection, pOwners[i].hEnt);
+        AtlasSprite* pSprite = At_GetSprite(pSprites[i].sprite, pLayerData->hAtlas);
+        vec2 tl, br;
+        GetStoredSpriteBoundingBox(pEnt, pSprite, &pSprites[i].transform, tl, br);
+        WriteSpriteQuad(pSprite, pVerts, pIndices, *pNextIndex, tl, br);
+        pVerts += 4;
+        pIndices += 6;
+        *pNextIndex += 4;
+    }
+    pOwners = pStore->pOwners[ETE_SpriteAnimator];
+    for(int i=0; i<numAnimatedSprites; i++)
+    {
+        struct AnimatedSprite* pAnimatedSprite = &pAnimatedSprites[i];
+        struct Entity2D* pEnt = Et2D_GetEntity(pCollection, pOwners[i].hEnt);
+        AtlasSprite* pSprite = At_GetSprite(pAnimatedSprite->pSprites[pAnimatedSprite->onSprite], pLayerData->hAtlas);
+        vec2 tl, br;
+        GetStoredSpriteBoundingBox(pEnt, pSprite, &pAnimatedSprite->transform, tl, br);
+        WriteSpriteQuad(pSprite, pVerts, pIndices, *pNextIndex, tl, br);
+        pVerts += 4;
+        pIndices += 6;
+        *pNextIndex += 4;
+    }
+}
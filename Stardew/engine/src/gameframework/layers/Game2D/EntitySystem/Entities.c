@@ -24,8 +24,13 @@ bool DestroyCollectionItr(struct Entity2D* pEnt, int i, void* pUser)
 void Et2D_DestroyCollection(struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer)
 {
     Et2D_IterateEntities(pCollection, &DestroyCollectionItr, pLayer);
+    if(pCollection->componentStore.bEnabled)
+    {
+        pCollection->activeEntities.pDynamicListItemPool = FreeObjectPool(pCollection->activeEntities.pDynamicListItemPool);
+    }
+    Co_DestroyComponentStore(&pCollection->componentStore);
     
-    pCollection->pEntityPool = FreeObjectPool(pCollection->pEntityPool);
+    pCollection->pEntityPool = FreePagedObjectPool(pCollection->pEntityPool);
 }
 
 
@@ -36,23 +41,35 @@ void Et2D_InitCollection(struct Entity2DCollection* pCollection)
     pCollection->dynamicEntities.hDynamicListHead = NULL_HANDLE;
     pCollection->dynamicEntities.hDynamicListTail = NULL_HANDLE;
     pCollection->dynamicEntities.nDynamicListSize = 0;
+    pCollection->activeEntities.hDynamicListHead = NULL_HANDLE;
+    pCollection->activeEntities.hDynamicListTail = NULL_HANDLE;
+    pCollection->activeEntities.nDynamicListSize = 0;
+    pCollection->activeEntities.pDynamicListItemPool = NULL;
     pCollection->gNumEnts = 0;
-    pCollection->pEntityPool = NEW_OBJECT_POOL(struct Entity2D, 512);
+    pCollection->pEntityPool = NEW_PAGED_OBJECT_POOL(struct Entity2D, PAGED_OBJECT_POOL_DEFAULT_BLOCK_SHIFT);
     pCollection->dynamicEntities.pDynamicListItemPool = NEW_OBJECT_POOL(struct DynamicEntityListItem, 256);
+    Co_InitComponentStore(&pCollection->componentStore, false);
+}
+
+void Et2D_UseComponentStore(struct Entity2DCollection* pCollection)
+{
+    EASSERT(pCollection->gNumEnts == 0);
+    Co_DestroyComponentStore(&pCollection->componentStore);
+    Co_InitComponentStore(&pCollection->componentStore, true);
+    pCollection->activeEntities.pDynamicListItemPool = NEW_OBJECT_POOL(struct DynamicEntityListItem, 256);
+}
+
+/* does Et2D_IterateActiveEntities need to visit it, see Entity2DCollection */
+static bool IsActiveEntity(struct Entity2D* pEnt)
+{
+    /* stored entities always have the default update */
+    return !pEnt->bComponentsInStore || pEnt->postPhys != &Entity2DUpdatePostPhysics || pEnt->input != &Entity2DInput;
 }
 
 void Entity2DOnInit(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, DrawContext* pDrawCtx, InputContext* pInputCtx)
 {
     Co_InitComponents(pEnt, pLayer);
-    struct GameLayer2DData* pData = pLayer->userData;
-    if(pEnt->bKeepInQuadtree)
-    {
-        pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&pData->entities, pData->hEntitiesQuadTree, pEnt->thisEntity, pLayer, 0, 6);
-    }
-    if(pEnt->bKeepInDynamicList)
-    {
-        pEnt->hDynamicListRef = DynL_AddEntity(&pData->entities.dynamicEntities, pEnt->thisEntity);
-    }
+    Et2D_AddToBroadphase(pLayer, pEnt);
 }
 
 void Entity2DUpdate(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, float deltaT)
@@ -78,16 +95,13 @@ void Entity2DInput(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, Inp
 void Entity2DOnDestroy(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer)
 {
     Co_DestroyComponents(pEnt);
-    struct GameLayer2DData* pData = pLayer->userData;
-    if(pEnt->bKeepInDynamicList)
-    {
-        DynL_RemoveItem(&pData->entities.dynamicEntities, pEnt->hDynamicListRef);
-    }
+    Et2D_RemoveFromBroadphase(pLayer, pEnt);
 }
 
 
 void Entity2DGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
 {
+    struct GameLayer2DData* pData = pLayer->userData;
     vec2 bbtl  = {99999999999, 9999999999999};
     vec2 bbbr  = {-99999999999, -9999999999999};
     bool bSet = false;
@@ -98,12 +112,12 @@ void Entity2DGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pL
         if(pComponent->type == ETE_Sprite)
         {
             bSet = true;
-            SpriteComp_GetBoundingBox(pEnt, &pComponent->data.sprite, pLayer, tl, br);
+            SpriteComp_GetBoundingBox(pEnt, Co_GetSprite(&pData->entities, pEnt, i), pLayer, tl, br);
         }
         else if(pComponent->type == ETE_SpriteAnimator)
         {
             bSet = true;
-            AnimatedSprite_GetBoundingBox(pEnt,&pComponent->data.spriteAnimator, pLayer, tl, br);
+            AnimatedSprite_GetBoundingBox(pEnt, Co_GetAnimatedSprite(&pData->entities, pEnt, i), pLayer, tl, br);
         }
         if(tl[0] < bbtl[0])
         {
@@ -164,33 +178,37 @@ void Et2D_Init(RegisterGameEntitiesFn registerGameEntities)
 
 void Et2D_DestroyEntity(struct GameFrameworkLayer* pLayer, struct Entity2DCollection* pCollection, HEntity2D hEnt)
 {
-    struct Entity2D* pEnt = &pCollection->pEntityPool[hEnt];
+    struct Entity2D* pEnt = Et2D_GetEntity(pCollection, hEnt);
 
     if(pCollection->gEntityListHead == hEnt)
     {
-        pCollection->gEntityListTail = pEnt->nextSibling;
+        pCollection->gEntityListHead = pEnt->nextSibling;
     }
     if(pCollection->gEntityListTail == hEnt)
     {
-        pCollection->gEntityListHead = pEnt->previousSibling;
+        pCollection->gEntityListTail = pEnt->previousSibling;
     }
 
     if(pEnt->nextSibling != NULL_HANDLE)
     {
-        struct Entity2D* pNext = &pCollection->pEntityPool[pEnt->nextSibling];
+        struct Entity2D* pNext = Et2D_GetEntity(pCollection, pEnt->nextSibling);
         pNext->previousSibling = pEnt->previousSibling;
 
     }
     if(pEnt->previousSibling != NULL_HANDLE)
     {
-        struct Entity2D* pPrev = &pCollection->pEntityPool[pEnt->previousSibling];
+        struct Entity2D* pPrev = Et2D_GetEntity(pCollection, pEnt->previousSibling);
         pPrev->nextSibling = pEnt->nextSibling;
     }
 
     pEnt->onDestroy(pEnt, pLayer);
+    Co_RemoveStoredComponents(pCollection, pEnt);
+    if(pEnt->hActiveListRef != NULL_HANDLE)
+    {
+        DynL_RemoveItem(&pCollection->activeEntities, pEnt->hActiveListRef);
+    }
     pCollection->gNumEnts--;
-    FreeObjectPoolIndex(pCollection->pEntityPool, hEnt);
-    FreeObjectPool(pCollection->dynamicEntities.pDynamicListItemPool);
+    FreePagedObjectPoolIndex(pCollection->pEntityPool, hEnt);
 }
 
 HEntity2D Et2D_AddEntity(struct Entity2DCollection* pCollection, struct Entity2D* pEnt)
@@ -198,11 +216,19 @@ HEntity2D Et2D_AddEntity(struct Entity2DCollection* pCollection, struct Entity2D
     HEntity2D hEnt = NULL_HANDLE;
     pEnt->nextSibling = NULL_HANDLE;
     pEnt->previousSibling = NULL_HANDLE;
-    pCollection->pEntityPool = GetObjectPoolIndex(pCollection->pEntityPool, &hEnt);
+    hEnt = GetPagedObjectPoolIndex(pCollection->pEntityPool);
     EASSERT(hEnt != NULL_HANDLE);
-    memcpy(&pCollection->pEntityPool[hEnt], pEnt, sizeof(struct Entity2D));
-    pEnt = &pCollection->pEntityPool[hEnt];
+    memcpy(Et2D_GetEntity(pCollection, hEnt), pEnt, sizeof(struct Entity2D));
+    pEnt = Et2D_GetEntity(pCollection, hEnt);
     pEnt->thisEntity = hEnt;
+    pEnt->bBBDirty = true;
+    pEnt->bGridStale = true;
+    Co_StoreComponents(pCollection, pEnt);
+    pEnt->hActiveListRef = NULL_HANDLE;
+    if(pCollection->componentStore.bEnabled && IsActiveEntity(pEnt))
+    {
+        pEnt->hActiveListRef = DynL_AddEntity(&pCollection->activeEntities, hEnt);
+    }
     if(pCollection->gEntityListHead == NULL_HANDLE)
     {
         pCollection->gEntityListHead = hEnt;
@@ -210,7 +236,7 @@ HEntity2D Et2D_AddEntity(struct Entity2DCollection* pCollection, struct Entity2D
     }
     else
     {
-        struct Entity2D* pLast = &pCollection->pEntityPool[pCollection->gEntityListTail];
+        struct Entity2D* pLast = Et2D_GetEntity(pCollection, pCollection->gEntityListTail);
         pLast->nextSibling = hEnt;
         pEnt->previousSibling = pCollection->gEntityListTail;
         pEnt->nextSibling = NULL_HANDLE;
@@ -277,7 +303,7 @@ static u32 NumEntsToSerialize(struct Entity2DCollection* pCollection)
     HEntity2D hOn = pCollection->gEntityListHead;
     while(hOn != NULL_HANDLE)
     {
-        struct Entity2D* pOn = &pCollection->pEntityPool[hOn];
+        struct Entity2D* pOn = Et2D_GetEntity(pCollection, hOn);
         if(pOn->bSerialize)
         {
             i++;
@@ -291,17 +317,25 @@ static void SaveEntities(struct Entity2DCollection* pCollection, struct BinarySe
 {
     EASSERT(bs->bSaving);
     BS_SerializeU32(NumEntsToSerialize(pCollection), bs);
+    struct Entity2D gathered;
     HEntity2D hOn = pCollection->gEntityListHead;
     while(hOn != NULL_HANDLE)
     {
-        struct Entity2D* pOn = &pCollection->pEntityPool[hOn];
+        struct Entity2D* pOn = Et2D_GetEntity(pCollection, hOn);
         if(pOn->bSerialize)
         {
             BS_SerializeU32(pOn->type, bs);
             Et2D_SerializeCommon(bs, pOn);
             if(pOn->type < VectorSize(pSerializers))
             {
-                pSerializers[pOn->type].serialize(bs, pOn, pData);
+                /* serializers read the components inline */
+                struct Entity2D* pSerialize = pOn;
+                if(pOn->bComponentsInStore)
+                {
+                    Co_GatherComponents(pCollection, pOn, &gathered);
+                    pSerialize = &gathered;
+                }
+                pSerializers[pOn->type].serialize(bs, pSerialize, pData);
             }
             else 
             {
@@ -317,7 +351,7 @@ void Et2D_SerializeEntities(struct Entity2DCollection* pCollection, struct Binar
 {
     if(bs->bSaving)
     {
-        SaveEntities(bs, pData, pCollection);
+        SaveEntities(pCollection, bs, pData);
     }
     else
     {
@@ -369,7 +403,7 @@ void Et2D_SerializeCommon(struct BinarySerializer* bs, struct Entity2D* pInEnt)
 
 struct Entity2D* Et2D_GetEntity(struct Entity2DCollection* pCollection, HEntity2D hEnt)
 {
-    return &pCollection->pEntityPool[hEnt];
+    return PagedObjectPoolAt(struct Entity2D, pCollection->pEntityPool, hEnt);
 }
 
 void Et2D_IterateEntities(struct Entity2DCollection* pCollection, Entity2DIterator itr, void* pUser)
@@ -386,11 +420,114 @@ void Et2D_IterateEntities(struct Entity2DCollection* pCollection, Entity2DIterat
     volatile int e = 0;
 }
 
+void Et2D_IterateActiveEntities(struct Entity2DCollection* pCollection, Entity2DIterator itr, void* pUser)
+{
+    if(!pCollection->componentStore.bEnabled)
+    {
+        Et2D_IterateEntities(pCollection, itr, pUser);
+        return;
+    }
+    struct DynamicEnt2DList* pList = &pCollection->activeEntities;
+    HDynamicEntityListItem hOn = pList->hDynamicListHead;
+    int i = 0;
+    while(hOn != NULL_HANDLE)
+    {
+        /* read before calling, in case the entity destroys itself */
+        HDynamicEntityListItem hNext = pList->pDynamicListItemPool[hOn].hNext;
+        struct Entity2D* pEntity = Et2D_GetEntity(pCollection, pList->pDynamicListItemPool[hOn].hEnt);
+        if(!itr(pEntity, i++, pUser))
+            break;
+        hOn = hNext;
+    }
+}
+
 float Entity2DGetSortVal(struct Entity2D* pEnt)
 {
     return pEnt->transform.position[1];
 }
 
+void Et2D_GetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+{
+    if(pEnt->bBBDirty)
+    {
+        pEnt->getBB(pEnt, pLayer, pEnt->bbTL, pEnt->bbBR);
+        pEnt->bBBDirty = false;
+    }
+    outTL[0] = pEnt->bbTL[0];
+    outTL[1] = pEnt->bbTL[1];
+    outBR[0] = pEnt->bbBR[0];
+    outBR[1] = pEnt->bbBR[1];
+}
+
+void Et2D_MarkBoundingBoxDirty(struct Entity2D* pEnt)
+{
+    pEnt->bBBDirty = true;
+    pEnt->bGridStale = true;
+}
+
+void Et2D_BroadphaseMove(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt)
+{
+    struct GameLayer2DData* pData = pLayer->userData;
+    pEnt->bBBDirty = true;
+    if(pData->broadphase == G2DBP_SpatialGrid)
+    {
+        EASSERT(pEnt->hSpatialGridRef != NULL_HANDLE);
+        vec2 tl, br;
+        Et2D_GetBoundingBox(pEnt, pLayer, tl, br);
+        SG_Move(&pData->entityGrid, pEnt->hSpatialGridRef, tl, br);
+        pEnt->bGridStale = false;
+    }
+    else
+    {
+        EASSERT(pEnt->hQuadTreeRef != NULL_HANDLE);
+        Entity2DQuadTree_Move(pEnt->hQuadTreeRef, &pData->entities, pLayer);
+    }
+}
+
+void Et2D_AddToBroadphase(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt)
+{
+    struct GameLayer2DData* pData = pLayer->userData;
+    if(pData->broadphase == G2DBP_SpatialGrid)
+    {
+        if(pEnt->bKeepInQuadtree || pEnt->bKeepInDynamicList)
+        {
+            vec2 tl, br;
+            Et2D_GetBoundingBox(pEnt, pLayer, tl, br);
+            pEnt->hSpatialGridRef = SG_Insert(&pData->entityGrid, pEnt->thisEntity, tl, br);
+            pEnt->bGridStale = false;
+        }
+    }
+    else if(pEnt->bKeepInQuadtree)
+    {
+        pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&pData->entities, pData->hEntitiesQuadTree, pEnt->thisEntity, pLayer);
+    }
+    if(pEnt->bKeepInDynamicList)
+    {
+        /* with the spatial grid too - the list is what's checked for moved entities before queries */
+        pEnt->hDynamicListRef = DynL_AddEntity(&pData->entities.dynamicEntities, pEnt->thisEntity);
+    }
+}
+
+void Et2D_RemoveFromBroadphase(struct GameFrameworkLayer* pLayer, struct Entity2D* pEnt)
+{
+    struct GameLayer2DData* pData = pLayer->userData;
+    if(pData->broadphase == G2DBP_SpatialGrid)
+    {
+        if(pEnt->bKeepInQuadtree || pEnt->bKeepInDynamicList)
+        {
+            SG_Remove(&pData->entityGrid, pEnt->hSpatialGridRef);
+        }
+    }
+    else if(pEnt->bKeepInQuadtree)
+    {
+        Entity2DQuadTree_Remove(pData->hEntitiesQuadTree, pEnt->hQuadTreeRef);
+    }
+    if(pEnt->bKeepInDynamicList)
+    {
+        DynL_RemoveItem(&pData->entities.dynamicEntities, pEnt->hDynamicListRef);
+    }
+}
+
 void Et2D_PopulateCommonHandlers(struct Entity2D* pEnt)
 {
     pEnt->init = &Entity2DOnInit;
@@ -44,6 +44,7 @@ void DynL_RemoveItem(struct DynamicEnt2DList* pDynList, HDynamicEntityListItem h
         pDynList->pDynamicListItemPool[pItem->hNext].hPrev = pItem->hPrev;
     }
     pDynList->nDynamicListSize--;
+    FreeObjectPoolIndex(pDynList->pDynamicListItemPool, hListItem);
 }
 
 int DynL_GetSize(struct DynamicEnt2DList* pDynList)
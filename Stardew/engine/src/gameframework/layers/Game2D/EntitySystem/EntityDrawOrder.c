@@ -0,0 +1,186 @@
+#include "EntityDrawOrder.h"
+#include "Entities.h"
+#include "DynArray.h"
+#include "AssertLib.h"
+#include <math.h>
+#include <string.h>
+
+void EDO_Init(struct EntityDrawOrder* pOrder)
+{
+    memset(pOrder, 0, sizeof(struct EntityDrawOrder));
+    pOrder->pKeys = NEW_VECTOR(struct EntitySortKey);
+    pOrder->pScratch = NEW_VECTOR(struct EntitySortKey);
+    pOrder->pSlots = NEW_VECTOR(struct EntityDrawOrderSlot);
+}
+
+void EDO_Destroy(struct EntityDrawOrder* pOrder)
+{
+    if(pOrder->pKeys)
+    {
+        DestoryVector(pOrder->pKeys);
+        DestoryVector(pOrder->pScratch);
+        DestoryVector(pOrder->pSlots);
+        pOrder->pKeys = NULL;
+        pOrder->pScratch = NULL;
+        pOrder->pSlots = NULL;
+    }
+}
+
+u32 EDO_MakeKey(int drawLayer, float sortPos)
+{
+    const i64 maxSortPos = (1 << EDO_KEY_SORT_POS_BITS) - 1;
+    const int maxLayer = (1 << EDO_KEY_LAYER_BITS) - 1;
+    /* biased so negative positions sort before positive ones */
+    i64 quantised = (i64)floorf(sortPos * EDO_SORT_POS_STEPS_PER_PX) + (1 << (EDO_KEY_SORT_POS_BITS - 1));
+    quantised = quantised < 0 ? 0 : quantised;
+    quantised = quantised > maxSortPos ? maxSortPos : quantised;
+    drawLayer = drawLayer < 0 ? 0 : drawLayer;
+    drawLayer = drawLayer > maxLayer ? maxLayer : drawLayer;
+    return ((u32)drawLayer << EDO_KEY_SORT_POS_BITS) | (u32)quantised;
+}
+
+static u32 EntityKey(struct Entity2D* pEnt)
+{
+    return EDO_MakeKey(pEnt->inDrawLayer, pEnt->getSortPos(pEnt));
+}
+
+VECTOR(struct EntitySortKey) EDO_PushKeys(struct Entity2DCollection* pCollection, HEntity2D* pEnts, int numEnts, VECTOR(struct EntitySortKey) pOutKeys)
+{
+    struct EntitySortKey* pNewKeys = NULL;
+    pOutKeys = VectorEmplaceN(pOutKeys, numEnts, (void**)&pNewKeys);
+    for(int i=0; i<numEnts; i++)
+    {
+        pNewKeys[i].hEnt = pEnts[i];
+        pNewKeys[i].key = EntityKey(Et2D_GetEntity(pCollection, pEnts[i]));
+    }
+    return pOutKeys;
+}
+
+void EDO_RadixSort(struct EntitySortKey* pKeys, struct EntitySortKey* pScratch, int numKeys)
+{
+    struct EntitySortKey* pFrom = pKeys;
+    struct EntitySortKey* pTo = pScratch;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+        int counts[256];
+        memset(counts, 0, sizeof(counts));
+        for(int i=0; i<numKeys; i++)
+        {
+            counts[(pFrom[i].key >> shift) & 0xff]++;
+        }
+        if(numKeys == 0 || counts[(pFrom[0].key >> shift) & 0xff] == numKeys)
+        {
+            /* every key has the same byte here - typically the draw layer and the high bits of the sort position */
+            continue;
+        }
+        int offset = 0;
+        for(int i=0; i<256; i++)
+        {
+            int count = counts[i];
+            counts[i] = offset;
+            offset += count;
+        }
+        for(int i=0; i<numKeys; i++)
+        {
+            pTo[counts[(pFrom[i].key >> shift) & 0xff]++] = pFrom[i];
+        }
+        struct EntitySortKey* pTemp = pFrom;
+        pFrom = pTo;
+        pTo = pTemp;
+    }
+    if(pFrom != pKeys)
+    {
+        memcpy(pKeys, pFrom, sizeof(struct EntitySortKey) * numKeys);
+    }
+}
+
+bool EDO_InsertionSort(struct EntitySortKey* pKeys, int numKeys, int maxShifts)
+{
+    int numShifts = 0;
+    for(int i=1; i<numKeys; i++)
+    {
+        struct EntitySortKey key = pKeys[i];
+        int j = i - 1;
+        while(j >= 0 && pKeys[j].key > key.key)
+        {
+            pKeys[j + 1] = pKeys[j];
+            j--;
+        }
+        pKeys[j + 1] = key;
+        numShifts += i - 1 - j;
+        if(numShifts > maxShifts)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void StampVisibleEntities(struct EntityDrawOrder* pOrder, struct Entity2DCollection* pCollection, HEntity2D* pEnts, int numEnts, u32 visibleStamp)
+{
+    for(int i=0; i<numEnts; i++)
+    {
+        HEntity2D hEnt = pEnts[i];
+        EASSERT(hEnt >= 0);
+        if(hEnt >= (int)VectorSize(pOrder->pSlots))
+        {
+            struct EntityDrawOrderSlot* pNewSlots = NULL;
+            int numNew = hEnt + 1 - VectorSize(pOrder->pSlots);
+            pOrder->pSlots = VectorEmplaceN(pOrder->pSlots, numNew, (void**)&pNewSlots);
+            memset(pNewSlots, 0, sizeof(struct EntityDrawOrderSlot) * numNew);
+        }
+        struct EntityDrawOrderSlot* pSlot = &pOrder->pSlots[hEnt];
+        pSlot->stamp = visibleStamp;
+        pSlot->key = EntityKey(Et2D_GetEntity(pCollection, hEnt));
+    }
+}
+
+void EDO_Sort(struct EntityDrawOrder* pOrder, struct Entity2DCollection* pCollection, VECTOR(HEntity2D) pEnts)
+{
+    int numEnts = VectorSize(pEnts);
+    u32 visibleStamp = ++pOrder->frame * 2;
+    StampVisibleEntities(pOrder, pCollection, pEnts, numEnts, visibleStamp);
+
+    /* the entities that are still visible in the last order, then the newly visible ones */
+    struct EntitySortKey* pKeys = NULL;
+    pOrder->pScratch = VectorClear(pOrder->pScratch);
+    pOrder->pScratch = VectorEmplaceN(pOrder->pScratch, numEnts, (void**)&pKeys);
+    int numKeys = 0;
+    for(int i=0; i<VectorSize(pOrder->pKeys); i++)
+    {
+        HEntity2D hEnt = pOrder->pKeys[i].hEnt;
+        struct EntityDrawOrderSlot* pSlot = &pOrder->pSlots[hEnt];
+        if(pSlot->stamp == visibleStamp)
+        {
+            pSlot->stamp = visibleStamp + 1;
+            pKeys[numKeys].hEnt = hEnt;
+            pKeys[numKeys++].key = pSlot->key;
+        }
+    }
+    for(int i=0; i<numEnts; i++)
+    {
+        struct EntityDrawOrderSlot* pSlot = &pOrder->pSlots[pEnts[i]];
+        if(pSlot->stamp == visibleStamp)
+        {
+            pSlot->stamp = visibleStamp + 1;
+            pKeys[numKeys].hEnt = pEnts[i];
+            pKeys[numKeys++].key = pSlot->key;
+        }
+    }
+    EASSERT(numKeys == numEnts);
+
+    /* the scratch vector now holds this frame's order */
+    VECTOR(struct EntitySortKey) pTemp = pOrder->pKeys;
+    pOrder->pKeys = pOrder->pScratch;
+    pOrder->pScratch = VectorReserve(pTemp, numKeys);
+
+    pOrder->bLastSortCoherent = EDO_InsertionSort(pOrder->pKeys, numKeys, numKeys * EDO_MAX_INSERTION_SHIFTS_PER_KEY);
+    if(!pOrder->bLastSortCoherent)
+    {
+        EDO_RadixSort(pOrder->pKeys, pOrder->pScratch, numKeys);
+    }
+    for(int i=0; i<numKeys; i++)
+    {
+        pEnts[i] = pOrder->pKeys[i].hEnt;
+    }
+}
@@ -6,6 +6,9 @@
 #include "Game2DLayer.h"
 #include "GameFramework.h"
 
+/* a query pushes at most 4 children for every node it pops */
+#define QUERY_STACK_SIZE (3 * ENTITY2DQUADTREE_MAX_DEPTH + 4)
+
 enum Entity2DQuadtreeQuadrant
 {
     Quadtree_TL,
@@ -24,9 +27,18 @@ struct Entity2DQuadTreeEntityRef
 
 struct Entity2DQuadtreeNode
 {
+    /* the nodes quadrant of its parent */
     vec2 tl;
     float w, h;
 
+    /* the quadrant grown by half its size on every side, entities are kept in the deepest node whose loose bounds contain them */
+    vec2 looseTL;
+    vec2 looseBR;
+
+    HEntity2DQuadtreeNode hParent;
+    int depth;
+    int maxDepth;
+
     HEntity2DQuadtreeEntityRef entityListHead;
     HEntity2DQuadtreeEntityRef entityListTail;
     int numEntities;
@@ -71,6 +83,26 @@ static void GetQuadtreeNodeQuadrant(struct Entity2DQuadtreeNode* pNode, enum Ent
     }
 }
 
+/* the quadrant the centre of a box is in */
+static enum Entity2DQuadtreeQuadrant GetQuadrantOfBox(struct Entity2DQuadtreeNode* pNode, vec2 tl, vec2 br)
+{
+    float centerX = (tl[0] + br[0]) * 0.5f;
+    float centerY = (tl[1] + br[1]) * 0.5f;
+    int right = centerX >= pNode->tl[0] + pNode->w / 2.0f;
+    int bottom = centerY >= pNode->tl[1] + pNode->h / 2.0f;
+    return (enum Entity2DQuadtreeQuadrant)(right + bottom * 2);
+}
+
+static void GetLooseBounds(vec2 tl, vec2 br, vec2 outLooseTL, vec2 outLooseBR)
+{
+    float halfW = (br[0] - tl[0]) * 0.5f;
+    float halfH = (br[1] - tl[1]) * 0.5f;
+    outLooseTL[0] = tl[0] - halfW;
+    outLooseTL[1] = tl[1] - halfH;
+    outLooseBR[0] = br[0] + halfW;
+    outLooseBR[1] = br[1] + halfH;
+}
+
 static bool IsContainedWithin(vec2 quadrantTL, vec2 quadrantBR, vec2 rectTL, vec2 rectBR)
 {
     if(rectTL[0] >= quadrantTL[0])
@@ -89,12 +121,17 @@ static bool IsContainedWithin(vec2 quadrantTL, vec2 quadrantBR, vec2 rectTL, vec
     return false;
 }
 
-static void NewQuadtreeNode(int x, int y, int w, int h, struct Entity2DQuadtreeNode* pNode)
+static void NewQuadtreeNode(float x, float y, float w, float h, struct Entity2DQuadtreeNode* pNode)
 {
     pNode->tl[0] = x;
     pNode->tl[1] = y;
     pNode->w = w;
     pNode->h = h;
+    vec2 br = { x + w, y + h };
+    GetLooseBounds(pNode->tl, br, pNode->looseTL, pNode->looseBR);
+    pNode->hParent = NULL_HANDLE;
+    pNode->depth = 0;
+    pNode->maxDepth = ENTITY2DQUADTREE_DEFAULT_MAX_DEPTH;
     pNode->entityListHead = NULL_HANDLE;
     pNode->entityListTail = NULL_HANDLE;
 
@@ -124,7 +161,13 @@ HEntity2DQuadtreeNode GetEntity2DQuadTree(struct Entity2DQuadTreeInitArgs* args)
     HEntity2DQuadtreeNode hOutNode;
     gNodePool = GetObjectPoolIndex(gNodePool, &hOutNode);
 
-    NewQuadtreeNode(args->x, args->y, args->w, args->h, &gNodePool[hOutNode]);
+    struct Entity2DQuadtreeNode* pNode = &gNodePool[hOutNode];
+    NewQuadtreeNode(args->x, args->y, args->w, args->h, pNode);
+    if(args->maxDepth)
+    {
+        EASSERT(args->maxDepth <= ENTITY2DQUADTREE_MAX_DEPTH);
+        pNode->maxDepth = args->maxDepth;
+    }
     return hOutNode;
 }
 
@@ -138,106 +181,155 @@ void DestroyEntity2DQuadTree(HEntity2DQuadtreeNode quadTree)
             DestroyEntity2DQuadTree(child);
         }
     }
+    HEntity2DQuadtreeEntityRef ref = gNodePool[quadTree].entityListHead;
+    while(ref != NULL_HANDLE)
+    {
+        HEntity2DQuadtreeEntityRef next = gEntityRefPool[ref].hNextSibling;
+        FreeObjectPoolIndex(gEntityRefPool, ref);
+        ref = next;
+    }
     FreeObjectPoolIndex(gNodePool, quadTree);
 }
 
-HEntity2DQuadtreeEntityRef Entity2DQuadTree_Insert(struct Entity2DCollection* pCollection, HEntity2DQuadtreeNode quadTree, HEntity2D hEnt, struct GameFrameworkLayer* pLayer, int depth, int maxDepth)
+/* the deepest node under hNode whose loose bounds contain the box, creating nodes on the way down */
+static HEntity2DQuadtreeNode FindNodeForBox(HEntity2DQuadtreeNode hNode, vec2 bbtl, vec2 bbbr)
 {
-    struct GameLayer2DData* pData = pLayer->userData;
-
-    struct Entity2D* pEnt = Et2D_GetEntity(pCollection, hEnt);
-    struct Entity2DQuadtreeNode* pNode = &gNodePool[quadTree];
-    vec2 bbtl, bbbr;
-    pEnt->getBB(pEnt, pLayer, bbtl, bbbr);
-    HEntity2DQuadtreeEntityRef ref = NULL_HANDLE;
-    for(int i=0; i<4; i++)
+    while(gNodePool[hNode].depth < gNodePool[hNode].maxDepth)
     {
-        vec2 quadrantTL, quadrantBR;
-        GetQuadtreeNodeQuadrant(pNode, (enum Entity2DQuadtreeQuadrant)i, quadrantTL, quadrantBR);
-        if(IsContainedWithin(quadrantTL, quadrantBR, bbtl, bbbr) && depth < maxDepth)
+        struct Entity2DQuadtreeNode* pNode = &gNodePool[hNode];
+        enum Entity2DQuadtreeQuadrant quadrant = GetQuadrantOfBox(pNode, bbtl, bbbr);
+        vec2 quadrantTL, quadrantBR, looseTL, looseBR;
+        GetQuadtreeNodeQuadrant(pNode, quadrant, quadrantTL, quadrantBR);
+        GetLooseBounds(quadrantTL, quadrantBR, looseTL, looseBR);
+        if(!IsContainedWithin(looseTL, looseBR, bbtl, bbbr))
         {
-            if(pNode->children[i] == NULL_HANDLE)
-            {
-                HEntity2DQuadtreeNode hNode;
-                gNodePool = GetObjectPoolIndex(gNodePool, &hNode);
-                struct Entity2DQuadtreeNode* pChildNode = &gNodePool[hNode];
-                NewQuadtreeNode(quadrantTL[0], quadrantTL[1], quadrantBR[0] - quadrantTL[0], quadrantBR[1] - quadrantTL[1], pChildNode);
-                pNode->children[i] = hNode;
-            }
-            ref = Entity2DQuadTree_Insert(pCollection, pNode->children[i], hEnt, pLayer, depth + 1, maxDepth);
+            break;
         }
-        
-    }
-    if(ref == NULL_HANDLE)
-    {
-        gEntityRefPool = GetObjectPoolIndex(gEntityRefPool, &ref);
-        struct Entity2DQuadTreeEntityRef* pRef = &gEntityRefPool[ref];
-        NewQuadTreeEntityRef(hEnt, pRef);
-        if(pNode->numEntities == 0)
+        if(pNode->children[quadrant] == NULL_HANDLE)
         {
-            pNode->entityListHead = ref;
-            pNode->entityListTail = ref;
+            HEntity2DQuadtreeNode hChild;
+            gNodePool = GetObjectPoolIndex(gNodePool, &hChild);
+            /* the pool may have moved */
+            pNode = &gNodePool[hNode];
+            struct Entity2DQuadtreeNode* pChildNode = &gNodePool[hChild];
+            NewQuadtreeNode(quadrantTL[0], quadrantTL[1], quadrantBR[0] - quadrantTL[0], quadrantBR[1] - quadrantTL[1], pChildNode);
+            pChildNode->hParent = hNode;
+            pChildNode->depth = pNode->depth + 1;
+            pChildNode->maxDepth = pNode->maxDepth;
+            pNode->children[quadrant] = hChild;
         }
-        else
-        {
-            struct Entity2DQuadTreeEntityRef* pTail = &gEntityRefPool[pNode->entityListTail];
-            pTail->hNextSibling = ref;
-            pRef->hPrevSibling = pNode->entityListTail;
-            pNode->entityListTail = ref;
-        }
-        pNode->numEntities++;
+        hNode = pNode->children[quadrant];
     }
-    return ref;
+    return hNode;
 }
 
-void Entity2DQuadTree_Remove(HEntity2DQuadtreeNode quadTree, HEntity2DQuadtreeEntityRef ent)
+static void LinkEntityRef(HEntity2DQuadtreeNode hNode, HEntity2DQuadtreeEntityRef ref)
 {
-    struct Entity2DQuadtreeNode* pNode = &gNodePool[gEntityRefPool[ent].hParentNode];
-
-    pNode->numEntities--;
-
-    if(pNode->entityListHead == ent)
+    struct Entity2DQuadtreeNode* pNode = &gNodePool[hNode];
+    struct Entity2DQuadTreeEntityRef* pRef = &gEntityRefPool[ref];
+    pRef->hParentNode = hNode;
+    pRef->hNextSibling = NULL_HANDLE;
+    pRef->hPrevSibling = pNode->entityListTail;
+    if(pNode->entityListTail == NULL_HANDLE)
     {
-        pNode->entityListHead = NULL_HANDLE;
+        pNode->entityListHead = ref;
     }
-
-    if(pNode->entityListTail == ent)
+    else
     {
-        pNode->entityListTail = gEntityRefPool[ent].hPrevSibling;
+        gEntityRefPool[pNode->entityListTail].hNextSibling = ref;
     }
+    pNode->entityListTail = ref;
+    pNode->numEntities++;
+}
 
-    if(gEntityRefPool[ent].hPrevSibling != NULL_HANDLE)
+static void UnlinkEntityRef(HEntity2DQuadtreeEntityRef ref)
+{
+    struct Entity2DQuadTreeEntityRef* pRef = &gEntityRefPool[ref];
+    struct Entity2DQuadtreeNode* pNode = &gNodePool[pRef->hParentNode];
+    if(pRef->hPrevSibling != NULL_HANDLE)
+    {
+        gEntityRefPool[pRef->hPrevSibling].hNextSibling = pRef->hNextSibling;
+    }
+    else
+    {
+        pNode->entityListHead = pRef->hNextSibling;
+    }
+    if(pRef->hNextSibling != NULL_HANDLE)
     {
-        struct Entity2DQuadTreeEntityRef* pPrev = &gEntityRefPool[gEntityRefPool[ent].hPrevSibling];
-        pPrev->hNextSibling = gEntityRefPool[ent].hNextSibling;
+        gEntityRefPool[pRef->hNextSibling].hPrevSibling = pRef->hPrevSibling;
     }
+    else
+    {
+        pNode->entityListTail = pRef->hPrevSibling;
+    }
+    pNode->numEntities--;
+    pRef->hParentNode = NULL_HANDLE;
+}
+
+HEntity2DQuadtreeEntityRef Entity2DQuadTree_Insert(struct Entity2DCollection* pCollection, HEntity2DQuadtreeNode quadTree, HEntity2D hEnt, struct GameFrameworkLayer* pLayer)
+{
+    struct Entity2D* pEnt = Et2D_GetEntity(pCollection, hEnt);
+    vec2 bbtl, bbbr;
+    Et2D_GetBoundingBox(pEnt, pLayer, bbtl, bbbr);
+    HEntity2DQuadtreeNode hNode = FindNodeForBox(quadTree, bbtl, bbbr);
+
+    HEntity2DQuadtreeEntityRef ref = NULL_HANDLE;
+    gEntityRefPool = GetObjectPoolIndex(gEntityRefPool, &ref);
+    NewQuadTreeEntityRef(hEnt, &gEntityRefPool[ref]);
+    LinkEntityRef(hNode, ref);
+    return ref;
+}
+
+void Entity2DQuadTree_Move(HEntity2DQuadtreeEntityRef ref, struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer)
+{
+    struct Entity2DQuadTreeEntityRef* pRef = &gEntityRefPool[ref];
+    struct Entity2D* pEnt = Et2D_GetEntity(pCollection, pRef->hEntity);
+    vec2 bbtl, bbbr;
+    Et2D_GetBoundingBox(pEnt, pLayer, bbtl, bbbr);
 
-    if(gEntityRefPool[ent].hNextSibling)
+    HEntity2DQuadtreeNode hNode = pRef->hParentNode;
+    struct Entity2DQuadtreeNode* pNode = &gNodePool[hNode];
+    if(pNode->hParent == NULL_HANDLE || IsContainedWithin(pNode->looseTL, pNode->looseBR, bbtl, bbbr))
     {
-        struct Entity2DQuadTreeEntityRef* pNext = &gEntityRefPool[gEntityRefPool[ent].hNextSibling];
-        pNext->hPrevSibling = gEntityRefPool[ent].hPrevSibling;
+        /* hasn't crossed the loose bounds (or is in the root, where anything outside the tree is kept) */
+        return;
     }
+    UnlinkEntityRef(ref);
+    /* up to the first node that contains it, then down as deep as it will go */
+    do
+    {
+        hNode = gNodePool[hNode].hParent;
+        pNode = &gNodePool[hNode];
+    }
+    while(pNode->hParent != NULL_HANDLE && !IsContainedWithin(pNode->looseTL, pNode->looseBR, bbtl, bbbr));
+    LinkEntityRef(FindNodeForBox(hNode, bbtl, bbbr), ref);
+}
 
+void Entity2DQuadTree_Remove(HEntity2DQuadtreeNode quadTree, HEntity2DQuadtreeEntityRef ent)
+{
+    UnlinkEntityRef(ent);
     FreeObjectPoolIndex(gEntityRefPool, ent);
 }
 
 VECTOR(HEntity2D) Entity2DQuadTree_Query(HEntity2DQuadtreeNode quadTree, vec2 regionTL, vec2 regionBR, VECTOR(HEntity2D) outEntities, struct Entity2DCollection* pCollection, struct GameFrameworkLayer* pLayer)
 {
-    /* Implement me next! */
-    struct Entity2DQuadtreeNode* pNode = &gNodePool[quadTree];
-    vec2 nodeBr = {
-        pNode->tl[0] + pNode->w,
-        pNode->tl[1] + pNode->h
-    };
-    if(Ge_AABBIntersect(pNode->tl, nodeBr, regionTL, regionBR))
+    HEntity2DQuadtreeNode stack[QUERY_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = quadTree;
+    while(stackSize)
     {
+        struct Entity2DQuadtreeNode* pNode = &gNodePool[stack[--stackSize]];
+        if(!Ge_AABBIntersect(pNode->looseTL, pNode->looseBR, regionTL, regionBR))
+        {
+            continue;
+        }
         HEntity2DQuadtreeEntityRef ref = pNode->entityListHead;
         while(ref != NULL_HANDLE)
         {
             struct Entity2DQuadTreeEntityRef* pRef = &gEntityRefPool[ref];
             struct Entity2D* pEnt = Et2D_GetEntity(pCollection, pRef->hEntity);
             vec2 etl, ebr;
-            pEnt->getBB(pEnt, pLayer, etl, ebr);
+            Et2D_GetBoundingBox(pEnt, pLayer, etl, ebr);
             if(Ge_AABBIntersect(regionTL, regionBR, etl, ebr))
             {
                 outEntities = VectorPush(outEntities, &pRef->hEntity);
@@ -246,14 +338,13 @@ VECTOR(HEntity2D) Entity2DQuadTree_Query(HEntity2DQuadtreeNode quadTree, vec2 re
         }
         for(int i=0; i<4; i++)
         {
-            HEntity2DQuadtreeNode child = pNode->children[i];
-            if(child != NULL_HANDLE)
+            if(pNode->children[i] != NULL_HANDLE)
             {
-                outEntities = Entity2DQuadTree_Query(child, regionTL, regionBR, outEntities, pCollection, pLayer);
+                EASSERT(stackSize < QUERY_STACK_SIZE);
+                stack[stackSize++] = pNode->children[i];
             }
         }
     }
-    
     return outEntities;
 }
 
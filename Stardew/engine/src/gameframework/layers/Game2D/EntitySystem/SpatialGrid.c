@@ -0,0 +1,240 @@
+#include "SpatialGrid.h"
+#include "DynArray.h"
+#include "ObjectPool.h"
+#include "AssertLib.h"
+#include "Geometry.h"
+#include <stdlib.h>
+#include <string.h>
+
+void SG_Init(struct SpatialGrid* pGrid, vec2 tl, float w, float h, float cellSize)
+{
+    EASSERT(cellSize > 0.0f);
+    memset(pGrid, 0, sizeof(struct SpatialGrid));
+    pGrid->tl[0] = tl[0];
+    pGrid->tl[1] = tl[1];
+    pGrid->cellSize = cellSize;
+    pGrid->cols = (int)ceilf(w / cellSize);
+    pGrid->rows = (int)ceilf(h / cellSize);
+    if(pGrid->cols < 1)
+    {
+        pGrid->cols = 1;
+    }
+    if(pGrid->rows < 1)
+    {
+        pGrid->rows = 1;
+    }
+    pGrid->pCells = calloc(pGrid->cols * pGrid->rows, sizeof(VECTOR(HSpatialGridItem)));
+    pGrid->pItems = NEW_OBJECT_POOL(struct SpatialGridItem, 256);
+}
+
+void SG_Destroy(struct SpatialGrid* pGrid)
+{
+    if(!pGrid->pCells)
+    {
+        return;
+    }
+    for(int i=0; i<pGrid->cols * pGrid->rows; i++)
+    {
+        if(pGrid->pCells[i])
+        {
+            DestoryVector(pGrid->pCells[i]);
+        }
+    }
+    free(pGrid->pCells);
+    pGrid->pCells = NULL;
+    pGrid->pItems = FreeObjectPool(pGrid->pItems);
+}
+
+static int CellCoord(float pos, float gridTL, float cellSize, int numCells)
+{
+    int cell = (int)floorf((pos - gridTL) / cellSize);
+    if(cell < 0)
+    {
+        return 0;
+    }
+    if(cell >= numCells)
+    {
+        return numCells - 1;
+    }
+    return cell;
+}
+
+static void GetCellRange(struct SpatialGrid* pGrid, vec2 tl, vec2 br, int* pTLX, int* pTLY, int* pBRX, int* pBRY)
+{
+    *pTLX = CellCoord(tl[0], pGrid->tl[0], pGrid->cellSize, pGrid->cols);
+    *pTLY = CellCoord(tl[1], pGrid->tl[1], pGrid->cellSize, pGrid->rows);
+    *pBRX = CellCoord(br[0], pGrid->tl[0], pGrid->cellSize, pGrid->cols);
+    *pBRY = CellCoord(br[1], pGrid->tl[1], pGrid->cellSize, pGrid->rows);
+}
+
+static void LinkItem(struct SpatialGrid* pGrid, HSpatialGridItem hItem)
+{
+    struct SpatialGridItem* pItem = &pGrid->pItems[hItem];
+    for(int y = pItem->cellTLY; y <= pItem->cellBRY; y++)
+    {
+        for(int x = pItem->cellTLX; x <= pItem->cellBRX; x++)
+        {
+            VECTOR(HSpatialGridItem)* ppCell = &pGrid->pCells[y * pGrid->cols + x];
+            if(!*ppCell)
+            {
+                *ppCell = NEW_VECTOR(HSpatialGridItem);
+            }
+            *ppCell = VectorPush(*ppCell, &hItem);
+        }
+    }
+}
+
+static void UnlinkItem(struct SpatialGrid* pGrid, HSpatialGridItem hItem)
+{
+    struct SpatialGridItem* pItem = &pGrid->pItems[hItem];
+    for(int y = pItem->cellTLY; y <= pItem->cellBRY; y++)
+    {
+        for(int x = pItem->cellTLX; x <= pItem->cellBRX; x++)
+        {
+            VECTOR(HSpatialGridItem) pCell = pGrid->pCells[y * pGrid->cols + x];
+            int size = VectorSize(pCell);
+            for(int i=0; i<size; i++)
+            {
+                if(pCell[i] == hItem)
+                {
+                    pCell[i] = pCell[size - 1];
+                    VectorPop(pCell);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+HSpatialGridItem SG_Insert(struct SpatialGrid* pGrid, HEntity2D hEnt, vec2 tl, vec2 br)
+{
+    HSpatialGridItem hItem = NULL_HANDLE;
+    pGrid->pItems = GetObjectPoolIndex(pGrid->pItems, &hItem);
+    struct SpatialGridItem* pItem = &pGrid->pItems[hItem];
+    pItem->hEnt = hEnt;
+    glm_vec2_copy(tl, pItem->tl);
+    glm_vec2_copy(br, pItem->br);
+    pItem->lastQuery = pGrid->queryCounter;
+    GetCellRange(pGrid, tl, br, &pItem->cellTLX, &pItem->cellTLY, &pItem->cellBRX, &pItem->cellBRY);
+    LinkItem(pGrid, hItem);
+    return hItem;
+}
+
+void SG_Move(struct SpatialGrid* pGrid, HSpatialGridItem hItem, vec2 tl, vec2 br)
+{
+    struct SpatialGridItem* pItem = &pGrid->pItems[hItem];
+    glm_vec2_copy(tl, pItem->tl);
+    glm_vec2_copy(br, pItem->br);
+    int tlx, tly, brx, bry;
+    GetCellRange(pGrid, tl, br, &tlx, &tly, &brx, &bry);
+    if(tlx == pItem->cellTLX && tly == pItem->cellTLY && brx == pItem->cellBRX && bry == pItem->cellBRY)
+    {
+        return;
+    }
+    UnlinkItem(pGrid, hItem);
+    pItem->cellTLX = tlx;
+    pItem->cellTLY = tly;
+    pItem->cellBRX = brx;
+    pItem->cellBRY = bry;
+    LinkItem(pGrid, hItem);
+}
+
+void SG_Remove(struct SpatialGrid* pGrid, HSpatialGridItem hItem)
+{
+    UnlinkItem(pGrid, hItem);
+    FreeObjectPoolIndex(pGrid->pItems, hItem);
+}
+
+/* the shape a query is for, the cells its bounding box covers are searched and the test is given each item in them */
+struct SpatialGridQuery
+{
+    vec2 tl;
+    vec2 br;
+    vec2 center;
+    float radius;
+    /* for SG_QueryCells */
+    SpatialGridTestFn fnTest;
+    void* pUser;
+};
+
+typedef bool(*SpatialGridIntersectFn)(struct SpatialGridQuery* pQuery, struct SpatialGridItem* pItem);
+
+static bool RectIntersectsItem(struct SpatialGridQuery* pQuery, struct SpatialGridItem* pItem)
+{
+    return Ge_AABBIntersect(pQuery->tl, pQuery->br, pItem->tl, pItem->br);
+}
+
+static bool CircleIntersectsItem(struct SpatialGridQuery* pQuery, struct SpatialGridItem* pItem)
+{
+    return Ge_CircleAABBIntersect(pQuery->center, pQuery->radius, pItem->tl, pItem->br);
+}
+
+static bool CallerTestsItem(struct SpatialGridQuery* pQuery, struct SpatialGridItem* pItem)
+{
+    return pQuery->fnTest(pItem->hEnt, pQuery->pUser);
+}
+
+static VECTOR(HEntity2D) QueryCells(struct SpatialGrid* pGrid, struct SpatialGridQuery* pQuery, SpatialGridIntersectFn fnIntersects, VECTOR(HEntity2D) pOutEntities)
+{
+    u32 query = ++pGrid->queryCounter;
+    int tlx, tly, brx, bry;
+    GetCellRange(pGrid, pQuery->tl, pQuery->br, &tlx, &tly, &brx, &bry);
+    for(int y = tly; y <= bry; y++)
+    {
+        for(int x = tlx; x <= brx; x++)
+        {
+            VECTOR(HSpatialGridItem) pCell = pGrid->pCells[y * pGrid->cols + x];
+            if(!pCell)
+            {
+                continue;
+            }
+            for(int i=0; i<VectorSize(pCell); i++)
+            {
+                struct SpatialGridItem* pItem = &pGrid->pItems[pCell[i]];
+                if(pItem->lastQuery == query)
+                {
+                    continue;
+                }
+                pItem->lastQuery = query;
+                if(fnIntersects(pQuery, pItem))
+                {
+                    pOutEntities = VectorPush(pOutEntities, &pItem->hEnt);
+                }
+            }
+        }
+    }
+    return pOutEntities;
+}
+
+VECTOR(HEntity2D) SG_QueryRect(struct SpatialGrid* pGrid, vec2 tl, vec2 br, VECTOR(HEntity2D) pOutEntities)
+{
+    struct SpatialGridQuery query;
+    memset(&query, 0, sizeof(struct SpatialGridQuery));
+    glm_vec2_copy(tl, query.tl);
+    glm_vec2_copy(br, query.br);
+    return QueryCells(pGrid, &query, &RectIntersectsItem, pOutEntities);
+}
+
+VECTOR(HEntity2D) SG_QueryRadius(struct SpatialGrid* pGrid, vec2 center, float radius, VECTOR(HEntity2D) pOutEntities)
+{
+    struct SpatialGridQuery query;
+    memset(&query, 0, sizeof(struct SpatialGridQuery));
+    query.tl[0] = center[0] - radius;
+    query.tl[1] = center[1] - radius;
+    query.br[0] = center[0] + radius;
+    query.br[1] = center[1] + radius;
+    glm_vec2_copy(center, query.center);
+    query.radius = radius;
+    return QueryCells(pGrid, &query, &CircleIntersectsItem, pOutEntities);
+}
+
+VECTOR(HEntity2D) SG_QueryCells(struct SpatialGrid* pGrid, vec2 tl, vec2 br, SpatialGridTestFn fnTest, void* pUser, VECTOR(HEntity2D) pOutEntities)
+{
+    struct SpatialGridQuery query;
+    memset(&query, 0, sizeof(struct SpatialGridQuery));
+    glm_vec2_copy(tl, query.tl);
+    glm_vec2_copy(br, query.br);
+    query.fnTest = fnTest;
+    query.pUser = pUser;
+    return QueryCells(pGrid, &query, &CallerTestsItem, pOutEntities);
+}
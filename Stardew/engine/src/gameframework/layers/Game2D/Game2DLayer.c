@@ -13,27 +13,209 @@
 #include "XMLUIGameLayer.h"
 #include "FreeLookCameraMode.h"
 #include "EntityQuadTree.h"
-#include "FloatingPointLib.h"
 #include "Camera2D.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+#include "TilemapChunks.h"
+#include "Lz4Block.h"
+#include "Components.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define TILES_BIG_ENDIAN_HOST
+#endif
 
 int gTilesRendered = 0;
 
-static void LoadTilesUncompressedV1(struct TileMapLayer* pLayer, struct BinarySerializer* pBS)
+void TilemapLayer_GetTLBR(vec2 tl, vec2 br, struct TileMapLayer* pTMLayer)
 {
-	int allocSize = pLayer->heightTiles * pLayer->widthTiles * sizeof(TileIndex);
-	pLayer->Tiles = malloc(allocSize);
-	BS_BytesRead(pBS, allocSize, (char*)pLayer->Tiles);
+
 }
 
+#define RLE_MAX_RUN_LENGTH 0xffff
 
-void TilemapLayer_GetTLBR(vec2 tl, vec2 br, struct TileMapLayer* pTMLayer)
+static bool LoadTilesRLEV1(TileIndex* pTiles, int numTiles, struct BinarySerializer* pBS)
+{
+	int onTile = 0;
+	while (true)
+	{
+		u16 runLength = 0, tile = 0;
+		BS_DeSerializeU16(&runLength, pBS);
+		BS_DeSerializeU16(&tile, pBS);
+		if (pBS->bError)
+		{
+			return false;
+		}
+		if (runLength == 0)
+		{
+			break;
+		}
+		if (runLength > numTiles - onTile)
+		{
+			return false;
+		}
+		for (int i = 0; i < runLength; i++)
+		{
+			pTiles[onTile++] = tile;
+		}
+	}
+	return onTile == numTiles;
+}
+
+static bool LoadTilesLZ4V1(TileIndex* pTiles, int numTiles, struct BinarySerializer* pBS)
+{
+	u32 compressedSize = 0;
+	BS_DeSerializeU32(&compressedSize, pBS);
+	const u8* pCompressed = BS_BytesReadInPlace(pBS, compressedSize);
+	if (!pCompressed)
+	{
+		return false;
+	}
+	size_t uncompressedSize = numTiles * sizeof(TileIndex);
+	if (Lz_DecompressBlock(pCompressed, compressedSize, (u8*)pTiles, uncompressedSize) != (i64)uncompressedSize)
+	{
+		return false;
+	}
+#ifdef TILES_BIG_ENDIAN_HOST
+	for (int i = 0; i < numTiles; i++)
+	{
+		pTiles[i] = (TileIndex)((pTiles[i] >> 8) | (pTiles[i] << 8));
+	}
+#endif
+	return true;
+}
+
+bool TilemapLayer_DeserializeTiles(struct TileMapLayer* pLayer, struct BinarySerializer* pBS)
+{
+	int numTiles = pLayer->heightTiles * pLayer->widthTiles;
+	pLayer->Tiles = malloc(numTiles * sizeof(TileIndex));
+	u32 compression = 0;
+	BS_DeSerializeU32(&compression, pBS);
+	bool bSuccess = false;
+	switch (compression)
+	{
+	case TLC_RLE:
+		bSuccess = LoadTilesRLEV1(pLayer->Tiles, numTiles, pBS);
+		break;
+	case TLC_Uncompressed:
+		BS_DeSerializeU16Array(pLayer->Tiles, numTiles, pBS);
+		bSuccess = !pBS->bError;
+		break;
+	case TLC_LZ4:
+		bSuccess = LoadTilesLZ4V1(pLayer->Tiles, numTiles, pBS);
+		break;
+	default:
+		printf("unexpected value for compression enum %i\n", compression);
+		break;
+	}
+	if (!bSuccess)
+	{
+		printf("malformed tiles for %ix%i tile layer, compression %i\n", pLayer->widthTiles, pLayer->heightTiles, compression);
+		memset(pLayer->Tiles, 0, numTiles * sizeof(TileIndex));
+	}
+	return bSuccess;
+}
+
+static size_t GetRLESize(const TileIndex* pTiles, int numTiles)
 {
+	/* the terminating run */
+	size_t size = 2 * sizeof(u16);
+	int i = 0;
+	while (i < numTiles)
+	{
+		int runLength = 1;
+		while (i + runLength < numTiles && pTiles[i + runLength] == pTiles[i] && runLength < RLE_MAX_RUN_LENGTH)
+		{
+			runLength++;
+		}
+		size += 2 * sizeof(u16);
+		i += runLength;
+	}
+	return size;
+}
 
+static void SaveTilesRLE(const TileIndex* pTiles, int numTiles, struct BinarySerializer* pBS)
+{
+	int i = 0;
+	while (i < numTiles)
+	{
+		int runLength = 1;
+		while (i + runLength < numTiles && pTiles[i + runLength] == pTiles[i] && runLength < RLE_MAX_RUN_LENGTH)
+		{
+			runLength++;
+		}
+		BS_SerializeU16((u16)runLength, pBS);
+		BS_SerializeU16(pTiles[i], pBS);
+		i += runLength;
+	}
+	BS_SerializeU16(0, pBS);
+	BS_SerializeU16(0, pBS);
 }
 
-static void LoadTilesRLEV1(struct TileMapLayer* pTileMap, struct BinarySerializer* pBS)
+/* returns a malloc'd LZ4 block of the little endian tiles */
+static u8* CompressTilesLZ4(const TileIndex* pTiles, int numTiles, size_t* pOutSize)
 {
-	EASSERT(false);
+	size_t uncompressedSize = numTiles * sizeof(TileIndex);
+	const u8* pSrc = (const u8*)pTiles;
+#ifdef TILES_BIG_ENDIAN_HOST
+	TileIndex* pSwapped = malloc(uncompressedSize);
+	for (int i = 0; i < numTiles; i++)
+	{
+		pSwapped[i] = (TileIndex)((pTiles[i] >> 8) | (pTiles[i] << 8));
+	}
+	pSrc = (const u8*)pSwapped;
+#endif
+	size_t capacity = Lz_CompressBound(uncompressedSize);
+	u8* pCompressed = malloc(capacity);
+	*pOutSize = Lz_CompressBlock(pSrc, uncompressedSize, pCompressed, capacity);
+#ifdef TILES_BIG_ENDIAN_HOST
+	free(pSwapped);
+#endif
+	return pCompressed;
+}
+
+void TilemapLayer_SerializeTiles(const struct TileMapLayer* pLayer, enum TileLayerCompression compression, struct BinarySerializer* pBS)
+{
+	int numTiles = pLayer->heightTiles * pLayer->widthTiles;
+	u8* pCompressed = NULL;
+	size_t compressedSize = 0;
+	if (compression == TLC_LZ4 || compression == TLC_Smallest)
+	{
+		pCompressed = CompressTilesLZ4(pLayer->Tiles, numTiles, &compressedSize);
+	}
+	if (compression == TLC_Smallest)
+	{
+		size_t uncompressedSize = numTiles * sizeof(TileIndex);
+		size_t rleSize = GetRLESize(pLayer->Tiles, numTiles);
+		size_t lz4Size = sizeof(u32) + compressedSize;
+		compression = TLC_Uncompressed;
+		if (rleSize < uncompressedSize && rleSize <= lz4Size)
+		{
+			compression = TLC_RLE;
+		}
+		else if (lz4Size < uncompressedSize)
+		{
+			compression = TLC_LZ4;
+		}
+	}
+
+	BS_SerializeU32(compression, pBS);
+	switch (compression)
+	{
+	case TLC_RLE:
+		SaveTilesRLE(pLayer->Tiles, numTiles, pBS);
+		break;
+	case TLC_Uncompressed:
+		BS_SerializeU16Array(pLayer->Tiles, numTiles, pBS);
+		break;
+	case TLC_LZ4:
+		BS_SerializeU32((u32)compressedSize, pBS);
+		BS_SerializeU8Array(pCompressed, compressedSize, pBS);
+		break;
+	default:
+		EASSERT(false);
+		break;
+	}
+	free(pCompressed);
 }
 
 static void LoadLevelDataV1(struct TileMap* pTileMap, struct BinarySerializer* pBS, struct GameLayer2DData* pData)
@@ -49,6 +231,11 @@ static void LoadLevelDataV1(struct TileMap* pTileMap, struct BinarySerializer* p
 		.h = bry - tly
 	};
 	pData->hEntitiesQuadTree = GetEntity2DQuadTree(&initArgs);
+	if(pData->broadphase == G2DBP_SpatialGrid)
+	{
+		vec2 gridTL = { tlx, tly };
+		SG_Init(&pData->entityGrid, gridTL, brx - tlx, bry - tly, pData->spatialGridCellSize);
+	}
 
 	u32 numLayers = 0;
 	u32 objectLayer = 0;
@@ -57,20 +244,20 @@ static void LoadLevelDataV1(struct TileMap* pTileMap, struct BinarySerializer* p
 	for (int i = 0; i < numLayers; i++)
 	{
 		struct TileMapLayer layer;
+		memset(&layer, 0, sizeof(struct TileMapLayer));
 		u32 type = 0;
 		BS_DeSerializeU32(&type, pBS);
 		layer.type = type;
 		switch(type)
 		{
 		case 1: // tile layer
-			u32 width, height, x, y, compression, tw, th;
+			u32 width, height, x, y, tw, th;
 			BS_DeSerializeU32(&width, pBS);
 			BS_DeSerializeU32(&height, pBS);
 			BS_DeSerializeU32(&x, pBS);
 			BS_DeSerializeU32(&y, pBS);
 			BS_DeSerializeU32(&tw, pBS);
 			BS_DeSerializeU32(&th, pBS);
-			BS_DeSerializeU32(&compression, pBS);
 			layer.widthTiles = width;
 			layer.heightTiles = height;
 			layer.transform.position[0] = x;
@@ -78,18 +265,7 @@ static void LoadLevelDataV1(struct TileMap* pTileMap, struct BinarySerializer* p
 			layer.tileWidthPx = tw;
 			layer.tileHeightPx = th;
 			layer.bIsObjectLayer = false;
-			switch (compression)
-			{
-			case 1:         // RLE
-				LoadTilesRLEV1(&layer, pBS);
-				break;
-			case 2:         // uncompressed
-				LoadTilesUncompressedV1(&layer, pBS);
-				break;
-			default:
-				printf("unexpected value for compression enum %i\n", compression);
-				break;
-			}
+			TilemapLayer_DeserializeTiles(&layer, pBS);
 			break;
 		case 2: // object layer
 			layer.bIsObjectLayer = true;
@@ -137,22 +313,32 @@ static void LoadLevelData(struct TileMap* pTileMap, const char* tilemapFilePath,
 	}
 	BS_Finish(&bs);
 
+	for (int i = 0; i < VectorSize(pTileMap->layers); i++)
+	{
+		if (!pTileMap->layers[i].bIsObjectLayer)
+		{
+			TilemapLayer_BuildChunks(&pTileMap->layers[i], atlas, pDC);
+		}
+	}
+
 }
 
 static void PublishDebugMessage(struct GameLayer2DData* pData)
 {
 	vec2 tl, br;
 	GetViewportWorldspaceTLBR(tl, br, &pData->camera, pData->windowW, pData->windowH);
-	sprintf(pData->debugMsg, "Tiles: %i zoom:%.2f tlx:%.2f tly:%.2f brx:%.2f bry:%.2f",
+	struct FrameArenaStats arenaStats = Ar_GetFrameArenaStats();
+	sprintf(pData->debugMsg, "Tiles: %i zoom:%.2f tlx:%.2f tly:%.2f brx:%.2f bry:%.2f arena:%uKB peak:%uKB",
 		gTilesRendered, pData->camera.scale[0],
 		tl[0], tl[1],
-		br[0], br[1]
+		br[0], br[1],
+		(unsigned int)(arenaStats.bytesUsedLastFrame / 1024), (unsigned int)(arenaStats.highWaterMark / 1024)
 	);
 	struct ScriptCallArgument arg;
 	arg.type = SCA_string;
 	arg.val.string = pData->debugMsg;
 	struct LuaListenedEventArgs args = { .numArgs = 1, .args = &arg };
-	Ev_FireEvent("DebugMessage", &args);
+	Ev_FireEventById(pData->debugMessageEvent, &args);
 }
 
 struct UpdateEntityContext
@@ -178,6 +364,7 @@ static bool UpdateEntities(struct Entity2D* pEnt, int i, void* pUser)
 {
 	struct UpdateEntityContext* pCTX = pUser;
 	pEnt->update(pEnt, pCTX->pLayer, pCTX->deltaT);
+	PROFILE_COUNTER_ADD(PC_EntitiesUpdated, 1);
 	return true;
 }
 
@@ -194,15 +381,16 @@ static void Update(struct GameFrameworkLayer* pLayer, float deltaT)
 		.pLayer = pLayer
 	};
 
-	Et2D_IterateEntities(&pData->entities, &UpdateEntities, &ctx);
-	Ph_PhysicsWorldStep(pData->hPhysicsWorld, deltaT, 4);
+	PROFILE_ZONE("Game2D.UpdateComponentStore") Co_UpdateComponentStore(&pData->entities, pLayer, deltaT);
+	PROFILE_ZONE("Game2D.UpdateEntities") Et2D_IterateActiveEntities(&pData->entities, &UpdateEntities, &ctx);
+	PROFILE_ZONE("Game2D.PhysicsStep") Ph_PhysicsWorldStep(pData->hPhysicsWorld, deltaT, 4);
 	struct PostPhysEntityContext postPhysCtx = 
 	{
 		.deltaT =deltaT,
 		.pLayer = pLayer
 	};
-	Ph_PhysicsWorldDoCollisionEvents(pLayer);
-	Et2D_IterateEntities(&pData->entities, &PostPhysicsEntities, &postPhysCtx);
+	PROFILE_ZONE("Game2D.CollisionEvents") Ph_PhysicsWorldDoCollisionEvents(pLayer);
+	PROFILE_ZONE("Game2D.PostPhysics") Et2D_IterateActiveEntities(&pData->entities, &PostPhysicsEntities, &postPhysCtx);
 	
 	if(pData->cameraClampedToTilemapLayer >= 0)
 		UpdateCameraClamp(pData);
@@ -245,83 +433,67 @@ void OutputSpriteVertices(
 		topLeft[0],
 		topLeft[1] + pSprite->heightPx
 	};
-	Worldspace2DVert vert = {
-		topLeft[0], topLeft[1],
-		pSprite->topLeftUV_U, pSprite->topLeftUV_V
-	};
+	Worldspace2DVert* pVerts = NULL;
+	outVert = VectorEmplaceN(outVert, 4, (void**)&pVerts);
 
 	// top left
 	VertIndexT tl = base;
-	outVert = VectorPush(outVert, &vert);
-	
-	vert.x = topRight[0]; 
-	vert.y = topRight[1];
-	vert.u = pSprite->bottomRightUV_U;
-	vert.v = pSprite->topLeftUV_V;
-	
+	pVerts[0].x = topLeft[0];
+	pVerts[0].y = topLeft[1];
+	pVerts[0].u = pSprite->topLeftUV_U;
+	pVerts[0].v = pSprite->topLeftUV_V;
+
 	// top right
 	VertIndexT tr = base + 1;
-	outVert = VectorPush(outVert, &vert);
-
-	vert.x = bottomLeft[0];
-	vert.y = bottomLeft[1];
-	vert.u = pSprite->topLeftUV_U;
-	vert.v = pSprite->bottomRightUV_V;
+	pVerts[1].x = topRight[0];
+	pVerts[1].y = topRight[1];
+	pVerts[1].u = pSprite->bottomRightUV_U;
+	pVerts[1].v = pSprite->topLeftUV_V;
 
 	// bottom left
 	VertIndexT bl = base + 2;
-	outVert = VectorPush(outVert, &vert);
-
-	vert.x = bottomRight[0];
-	vert.y = bottomRight[1];
-	vert.u = pSprite->bottomRightUV_U;
-	vert.v = pSprite->bottomRightUV_V;
+	pVerts[2].x = bottomLeft[0];
+	pVerts[2].y = bottomLeft[1];
+	pVerts[2].u = pSprite->topLeftUV_U;
+	pVerts[2].v = pSprite->bottomRightUV_V;
 
 	// bottom right
 	VertIndexT br = base + 3;
-	outVert = VectorPush(outVert, &vert);
+	pVerts[3].x = bottomRight[0];
+	pVerts[3].y = bottomRight[1];
+	pVerts[3].u = pSprite->bottomRightUV_U;
+	pVerts[3].v = pSprite->bottomRightUV_V;
 
-	outInd = VectorPush(outInd, &tl);
-	outInd = VectorPush(outInd, &tr);
-	outInd = VectorPush(outInd, &bl);
-	outInd = VectorPush(outInd, &tr);
-	outInd = VectorPush(outInd, &br);
-	outInd = VectorPush(outInd, &bl);
+	const VertIndexT indices[6] = { tl, tr, bl, tr, br, bl };
+	outInd = VectorPushN(outInd, indices, 6);
 
 	*pOutVert = outVert;
 	*pOutInd = outInd;
 }
 
-static void OutputTilemapLayerVertices(
+int OutputTilemapLayerTileRange(
 	hAtlas atlas,
 	struct TileMapLayer* pLayer,
 	VECTOR(Worldspace2DVert)* outVerts,
 	VECTOR(VertIndexT)* outInds,
 	VertIndexT* pNextIndex,
-	vec2 viewportTL,
-	vec2 viewportBR
+	int startCol,
+	int endCol,
+	int startRow,
+	int endRow
 )
 {
 	VECTOR(Worldspace2DVert) outVert = *outVerts;
 	VECTOR(VertIndexT) outInd = *outInds;
+	int numTiles = 0;
 
-	/*
-		Only draw those tiles that are in the viewport:
-		TODO: make this work for layers that are transformed
-	*/
-
-	int startCol = ((int)viewportTL[0]) / pLayer->tileWidthPx;
-	startCol = startCol < 0 ? 0 : startCol;
-	int endCol = ((int)viewportBR[0]) / pLayer->tileWidthPx;
-	endCol++;
-	endCol = endCol > pLayer->widthTiles ? pLayer->widthTiles : endCol;
-
-
-	int startRow = ((int)viewportTL[1]) / pLayer->tileHeightPx;
-	startRow = startRow < 0 ? 0 : startRow;
-	int endRow = ((int)viewportBR[1]) / pLayer->tileHeightPx;
-	endRow++;
-	endRow = endRow > pLayer->heightTiles ? pLayer->heightTiles : endRow;
+	/* reserve for every tile up front so the per tile pushes never reallocate */
+	if (endRow > startRow && endCol > startCol)
+	{
+		u32 numRangeTiles = (endRow - startRow) * (endCol - startCol);
+		outVert = VectorReserve(outVert, VectorSize(outVert) + numRangeTiles * 4);
+		outInd = VectorReserve(outInd, VectorSize(outInd) + numRangeTiles * 6);
+	}
 
 	for (int row = startRow; row < endRow; row++)
 	{
@@ -335,35 +507,49 @@ static void OutputTilemapLayerVertices(
 			hSprite sprite = At_TilemapIndexToSprite(atlas, tile);
 			AtlasSprite* pSprite = At_GetSprite(sprite, atlas);
 			OutputSpriteVertices(pSprite, &outVert, &outInd, pNextIndex, col, row, &pLayer->transform);
-			gTilesRendered++;
+			numTiles++;
 		}
 	}
 
 	*outVerts = outVert;
 	*outInds = outInd;
+	return numTiles;
 }
 
-/* Hack */
-static struct Entity2DCollection* gEntityCollectionCurrent = NULL;
-
-static int EntityDrawOrderCompare(const void* a, const void* b)
+void OutputTilemapLayerVertices(
+	hAtlas atlas,
+	struct TileMapLayer* pLayer,
+	VECTOR(Worldspace2DVert)* outVerts,
+	VECTOR(VertIndexT)* outInds,
+	VertIndexT* pNextIndex,
+	vec2 viewportTL,
+	vec2 viewportBR
+)
 {
-	HEntity2D entA = *((HEntity2D*)a);
-	HEntity2D entB = *((HEntity2D*)b);
-	struct Entity2D* pEntA = Et2D_GetEntity(gEntityCollectionCurrent, entA);
-	struct Entity2D* pEntB = Et2D_GetEntity(gEntityCollectionCurrent, entB);
+	/*
+		Only draw those tiles that are in the viewport:
+		TODO: make this work for layers that are transformed
+	*/
 
-	float aval = pEntA->getSortPos(pEntA);
-	float bval =  pEntB->getSortPos(pEntB);
-	if(CompareFloat(aval, bval))
-	{
-		return 0;
-	}
-	if(aval < bval)
-	{
-		return -1; /* place first argument before second */
-	}
-	return 1;      /* place second argument before first */
+	int startCol = ((int)viewportTL[0]) / pLayer->tileWidthPx;
+	startCol = startCol < 0 ? 0 : startCol;
+	int endCol = ((int)viewportBR[0]) / pLayer->tileWidthPx;
+	endCol++;
+	endCol = endCol > pLayer->widthTiles ? pLayer->widthTiles : endCol;
+
+
+	int startRow = ((int)viewportTL[1]) / pLayer->tileHeightPx;
+	startRow = startRow < 0 ? 0 : startRow;
+	int endRow = ((int)viewportBR[1]) / pLayer->tileHeightPx;
+	endRow++;
+	endRow = endRow > pLayer->heightTiles ? pLayer->heightTiles : endRow;
+
+	gTilesRendered += OutputTilemapLayerTileRange(atlas, pLayer, outVerts, outInds, pNextIndex, startCol, endCol, startRow, endRow);
+}
+
+void Game2DLayer_SortEntitiesByDrawOrder(struct GameLayer2DData* pData, VECTOR(HEntity2D) pEnts)
+{
+	EDO_Sort(&pData->drawOrder, &pData->entities, pEnts);
 }
 
 static VECTOR(HEntity2D) QueryVisibleDynEntities(struct GameFrameworkLayer* pLayer, struct Entity2DCollection* pCollection, vec2 viewportTL, vec2 viewportBR, VECTOR(HEntity2D) pOutEntities)
@@ -376,7 +562,7 @@ static VECTOR(HEntity2D) QueryVisibleDynEntities(struct GameFrameworkLayer* pLay
 		struct DynamicEntityListItem* pItem = &pList->pDynamicListItemPool[hOn];
 		struct Entity2D* pEnt = Et2D_GetEntity(pCollection, pItem->hEnt);
 		vec2 entTL, entBR;
-		pEnt->getBB(pEnt, pLayer, entTL, entBR);
+		Et2D_GetBoundingBox(pEnt, pLayer, entTL, entBR);
 		if(Ge_AABBIntersect(viewportTL, viewportBR, entTL, entBR))
 		{
 			pOutEntities = VectorPush(pOutEntities, &pItem->hEnt);
@@ -386,72 +572,151 @@ static VECTOR(HEntity2D) QueryVisibleDynEntities(struct GameFrameworkLayer* pLay
 	return pOutEntities;
 } 
 
-static void OutputVertices(
-	struct TileMap* pData, 
-	struct Transform2D* pCam, 
-	VECTOR(Worldspace2DVert)* outVerts,
-	VECTOR(VertIndexT)* outIndices,
-	struct GameLayer2DData* pLayerData,
-	struct GameFrameworkLayer* pLayer
-)
+/* move the dynamic list entities whose bounding boxes have changed since they were last moved in the spatial grid */
+static void MoveStaleDynEntitiesInGrid(struct GameLayer2DData* pData)
 {
-	VECTOR(Worldspace2DVert) verts = *outVerts;
-	VECTOR(VertIndexT) inds = *outIndices;
-	static VECTOR(HEntity2D) sFoundEnts = NULL;
-	if(!sFoundEnts)
+	struct DynamicEnt2DList* pList = &pData->entities.dynamicEntities;
+	HDynamicEntityListItem hOn = pList->hDynamicListHead;
+	while(hOn != NULL_HANDLE)
 	{
-		sFoundEnts = NEW_VECTOR(HEntity2D);
+		struct DynamicEntityListItem* pItem = &pList->pDynamicListItemPool[hOn];
+		struct Entity2D* pEnt = Et2D_GetEntity(&pData->entities, pItem->hEnt);
+		if(pEnt->bGridStale)
+		{
+			vec2 entTL, entBR;
+			Et2D_GetBoundingBox(pEnt, pData->pLayer, entTL, entBR);
+			SG_Move(&pData->entityGrid, pEnt->hSpatialGridRef, entTL, entBR);
+			pEnt->bGridStale = false;
+		}
+		hOn = pItem->hNext;
 	}
-	sFoundEnts = VectorClear(sFoundEnts);
-	int foundEnts = VectorSize(sFoundEnts);
+}
 
-	vec2 tl, br;
-	GetViewportWorldspaceTLBR(tl, br, pCam, pLayerData->windowW, pLayerData->windowH);
+struct GridCandidateTest
+{
+	struct GameLayer2DData* pData;
+	vec2 tl;
+	vec2 br;
+	vec2 center;
+	float radius;
+};
+
+/*
+	the grid's candidates are tested against the entities cached bounding boxes like the quadtree's are, not the box in the grid item -
+	static entities aren't moved in the grid when their boxes change, an animation frame for example
+*/
+static bool GridCandidateInRect(HEntity2D hEnt, void* pUser)
+{
+	struct GridCandidateTest* pTest = pUser;
+	vec2 entTL, entBR;
+	Et2D_GetBoundingBox(Et2D_GetEntity(&pTest->pData->entities, hEnt), pTest->pData->pLayer, entTL, entBR);
+	return Ge_AABBIntersect(pTest->tl, pTest->br, entTL, entBR);
+}
+
+static bool GridCandidateInCircle(HEntity2D hEnt, void* pUser)
+{
+	struct GridCandidateTest* pTest = pUser;
+	vec2 entTL, entBR;
+	Et2D_GetBoundingBox(Et2D_GetEntity(&pTest->pData->entities, hEnt), pTest->pData->pLayer, entTL, entBR);
+	return Ge_CircleAABBIntersect(pTest->center, pTest->radius, entTL, entBR);
+}
+
+VECTOR(HEntity2D) Game2DLayer_CullEntities(struct GameLayer2DData* pData, vec2 regionTL, vec2 regionBR, VECTOR(HEntity2D) pOutEntities)
+{
+	if(pData->broadphase == G2DBP_SpatialGrid)
+	{
+		MoveStaleDynEntitiesInGrid(pData);
+		struct GridCandidateTest test = { .pData = pData };
+		glm_vec2_copy(regionTL, test.tl);
+		glm_vec2_copy(regionBR, test.br);
+		return SG_QueryCells(&pData->entityGrid, regionTL, regionBR, &GridCandidateInRect, &test, pOutEntities);
+	}
 	/* query the quadtree for entities here */
-	sFoundEnts = Entity2DQuadTree_Query(pLayerData->hEntitiesQuadTree, tl, br, sFoundEnts, &pLayerData->entities, pLayer);
+	pOutEntities = Entity2DQuadTree_Query(pData->hEntitiesQuadTree, regionTL, regionBR, pOutEntities, &pData->entities, pData->pLayer);
 	/* query dynamic entities */
-	sFoundEnts = QueryVisibleDynEntities(pLayer, &pLayerData->entities, tl, br, sFoundEnts);
-	/* sort the entities */
-	gEntityCollectionCurrent = &pLayerData->entities;
-	foundEnts = VectorSize(sFoundEnts);
+	return QueryVisibleDynEntities(pData->pLayer, &pData->entities, regionTL, regionBR, pOutEntities);
+}
 
-	qsort(sFoundEnts, foundEnts, sizeof(HEntity2D), &EntityDrawOrderCompare);
-	gTilesRendered = 0;
-	VertIndexT nextIndexVal = 0;
-	int onObjectLayer = 0;
-	for (int i = 0; i < VectorSize(pData->layers); i++)
+VECTOR(HEntity2D) Game2DLayer_QueryEntitiesInRadius(struct GameLayer2DData* pData, vec2 center, float radius, VECTOR(HEntity2D) pOutEntities)
+{
+	if(pData->broadphase == G2DBP_SpatialGrid)
 	{
-		if(pData->layers[i].bIsObjectLayer)
+		MoveStaleDynEntitiesInGrid(pData);
+		struct GridCandidateTest test = { .pData = pData, .radius = radius };
+		glm_vec2_copy(center, test.center);
+		vec2 tl = { center[0] - radius, center[1] - radius };
+		vec2 br = { center[0] + radius, center[1] + radius };
+		return SG_QueryCells(&pData->entityGrid, tl, br, &GridCandidateInCircle, &test, pOutEntities);
+	}
+	/* the entities in the circles bounding box, then the ones that aren't in the circle are removed */
+	vec2 tl = { center[0] - radius, center[1] - radius };
+	vec2 br = { center[0] + radius, center[1] + radius };
+	int start = VectorSize(pOutEntities);
+	pOutEntities = Game2DLayer_CullEntities(pData, tl, br, pOutEntities);
+	int numKept = start;
+	for(int i = start; i < VectorSize(pOutEntities); i++)
+	{
+		struct Entity2D* pEnt = Et2D_GetEntity(&pData->entities, pOutEntities[i]);
+		vec2 entTL, entBR;
+		Et2D_GetBoundingBox(pEnt, pData->pLayer, entTL, entBR);
+		if(Ge_CircleAABBIntersect(center, radius, entTL, entBR))
 		{
-			/* from the entities we've found from the quad tree, draw the ones that are in this layer */
-			for(int j=0; j<VectorSize(sFoundEnts); j++)
-			{
-				struct Entity2D* pEnt = Et2D_GetEntity(&pLayerData->entities, sFoundEnts[j]);
-				if(onObjectLayer == pEnt->inDrawLayer)
-				{
-					pEnt->draw(pEnt, pLayer, &pEnt->transform, &verts, &inds, &nextIndexVal);
-				}
-			}
-			onObjectLayer++;
+			pOutEntities[numKept++] = pOutEntities[i];
 		}
-		else
+	}
+	while(VectorSize(pOutEntities) > numKept)
+	{
+		VectorPop(pOutEntities);
+	}
+	return pOutEntities;
+}
+
+static VECTOR(HEntity2D) QueryVisibleEntities(struct GameLayer2DData* pLayerData, struct GameFrameworkLayer* pLayer, vec2 tl, vec2 br)
+{
+	VECTOR(HEntity2D) sFoundEnts = NEW_FRAME_VECTOR(HEntity2D);
+	PROFILE_ZONE("Game2D.QueryVisibleEntities") sFoundEnts = Game2DLayer_CullEntities(pLayerData, tl, br, sFoundEnts);
+	/* sort the entities */
+	PROFILE_ZONE("Game2D.SortEntities") Game2DLayer_SortEntitiesByDrawOrder(pLayerData, sFoundEnts);
+	return sFoundEnts;
+}
+
+static void OutputObjectLayerVertices(
+	struct GameLayer2DData* pLayerData,
+	struct GameFrameworkLayer* pLayer,
+	VECTOR(HEntity2D) pVisibleEnts,
+	int objectLayer
+)
+{
+	VECTOR(Worldspace2DVert) verts = VectorClear(pLayerData->pWorldspaceVertices);
+	VECTOR(VertIndexT) inds = VectorClear(pLayerData->pWorldspaceIndices);
+	VertIndexT nextIndexVal = 0;
+	/* from the entities we've found from the quad tree, draw the ones that are in this layer */
+	for(int j=0; j<VectorSize(pVisibleEnts); j++)
+	{
+		struct Entity2D* pEnt = Et2D_GetEntity(&pLayerData->entities, pVisibleEnts[j]);
+		if(objectLayer == pEnt->inDrawLayer)
 		{
-			OutputTilemapLayerVertices(pLayerData->hAtlas, pData->layers + i, &verts, &inds, &nextIndexVal, tl, br);
+			pEnt->draw(pEnt, pLayer, &pEnt->transform, &verts, &inds, &nextIndexVal);
 		}
 	}
+	pLayerData->pWorldspaceVertices = verts;
+	pLayerData->pWorldspaceIndices = inds;
+}
 
-	*outVerts = verts;
-	*outIndices = inds;
+static H2DWorldspaceVertexBuffer GetObjectLayerVertexBuffer(struct GameLayer2DData* pData, int objectLayer, DrawContext* pDC)
+{
+	while(VectorSize(pData->objectLayerVertexBuffers) <= objectLayer)
+	{
+		H2DWorldspaceVertexBuffer hBuf = pDC->NewWorldspaceVertBuffer(256);
+		pData->objectLayerVertexBuffers = VectorPush(pData->objectLayerVertexBuffers, &hBuf);
+	}
+	return pData->objectLayerVertexBuffers[objectLayer];
 }
 
 static void Draw(struct GameFrameworkLayer* pLayer, DrawContext* context)
 {
 	struct GameLayer2DData* pData = pLayer->userData;
 	At_SetCurrent(pData->hAtlas, context);
-	pData->pWorldspaceVertices = VectorClear(pData->pWorldspaceVertices);
-	pData->pWorldspaceIndices = VectorClear(pData->pWorldspaceIndices);
-	OutputVertices(&pData->tilemap, &pData->camera, &pData->pWorldspaceVertices, &pData->pWorldspaceIndices, pData, pLayer);
-	context->WorldspaceVertexBufferData(pData->vertexBuffer, pData->pWorldspaceVertices, VectorSize(pData->pWorldspaceVertices), pData->pWorldspaceIndices, VectorSize(pData->pWorldspaceIndices));
 	mat4 view;
 	glm_mat4_identity(view);
 	// TODO: set here based on camera
@@ -469,7 +734,40 @@ static void Draw(struct GameFrameworkLayer* pLayer, DrawContext* context)
 	glm_scale(view, scale);
 	glm_translate(view, translate);
 
-	context->DrawWorldspaceVertexBuffer(pData->vertexBuffer, VectorSize(pData->pWorldspaceIndices), view);
+	vec2 tl, br;
+	GetViewportWorldspaceTLBR(tl, br, &pData->camera, pData->windowW, pData->windowH);
+	VECTOR(HEntity2D) pVisibleEnts = QueryVisibleEntities(pData, pLayer, tl, br);
+
+	/*
+		Layers are drawn in order. Tile layers draw their visible chunks from static buffers, 
+		object layers output their entities vertices into a buffer of their own each frame
+	*/
+	gTilesRendered = 0;
+	int onObjectLayer = 0;
+	for (int i = 0; i < VectorSize(pData->tilemap.layers); i++)
+	{
+		struct TileMapLayer* pTMLayer = &pData->tilemap.layers[i];
+		if(pTMLayer->bIsObjectLayer)
+		{
+			PROFILE_ZONE("Game2D.OutputVertices") OutputObjectLayerVertices(pData, pLayer, pVisibleEnts, onObjectLayer);
+			u32 numIndices = VectorSize(pData->pWorldspaceIndices);
+			if(numIndices)
+			{
+				H2DWorldspaceVertexBuffer hBuf = GetObjectLayerVertexBuffer(pData, onObjectLayer, context);
+				PROFILE_ZONE("Game2D.UploadVertices") context->WorldspaceVertexBufferData(hBuf, pData->pWorldspaceVertices, VectorSize(pData->pWorldspaceVertices), pData->pWorldspaceIndices, numIndices);
+				context->DrawWorldspaceVertexBuffer(hBuf, numIndices, view);
+			}
+			onObjectLayer++;
+		}
+		else
+		{
+			PROFILE_ZONE("Game2D.DrawTilemapChunks")
+			{
+				TilemapLayer_RebuildDirtyChunks(pTMLayer, pData->hAtlas, context);
+				gTilesRendered += TilemapLayer_DrawVisibleChunks(pTMLayer, context, tl, br, view);
+			}
+		}
+	}
 }
 
 
@@ -498,16 +796,12 @@ static void Input(struct GameFrameworkLayer* pLayer, InputContext* context)
 		.pLayer = pLayer,
 		.inputCtx = context
 	};
-	Et2D_IterateEntities(&pData->entities, &InputEntities, &ctx);
+	Et2D_IterateActiveEntities(&pData->entities, &InputEntities, &ctx);
 }
 
 static void LoadLayerAssets(struct GameLayer2DData* pData, DrawContext* pDC)
 {
-	struct BinarySerializer bs;
-	memset(&bs, 0, sizeof(struct BinarySerializer));
-	BS_CreateForLoad(pData->atlasFilePath, &bs);
-	At_SerializeAtlas(&bs, &pData->hAtlas, pDC);
-	BS_Finish(&bs);
+	pData->hAtlas = At_LoadAtlasFile(pData->atlasFilePath, pDC);
 	LoadLevelData(&pData->tilemap, pData->tilemapFilePath, pDC, pData->hAtlas, pData);
 	pData->bLoaded = true;
 }
@@ -528,6 +822,11 @@ void GameLayer2D_OnPush(struct GameFrameworkLayer* pLayer, DrawContext* drawCont
 {
 	struct GameLayer2DData* pData = pLayer->userData;
 	Et2D_InitCollection(&pData->entities);
+	EDO_Init(&pData->drawOrder);
+	if(pData->bUseComponentStore)
+	{
+		Et2D_UseComponentStore(&pData->entities);
+	}
 	pData->hPhysicsWorld = Ph_GetPhysicsWorld(0, 0, 32.0f); // todo - pass these arguments in somehow
 	BindFreeLookControls(inputContext, pData);
 	ActivateFreeLookMode(inputContext, pData);
@@ -558,8 +857,21 @@ void Game2DLayer_OnPop(struct GameFrameworkLayer* pLayer, DrawContext* drawConte
 	struct GameLayer2DData* pData = pLayer->userData;
 	EASSERT(pData->pDebugListener);
 	Et2D_DestroyCollection(&pData->entities, pLayer);
+	EDO_Destroy(&pData->drawOrder);
+	DestroyEntity2DQuadTree(pData->hEntitiesQuadTree);
+	SG_Destroy(&pData->entityGrid);
 	Ev_UnsubscribeEvent(pData->pDebugListener);
 	Ph_DestroyPhysicsWorld(pData->hPhysicsWorld);
+	for (int i = 0; i < VectorSize(pData->tilemap.layers); i++)
+	{
+		TilemapLayer_DestroyChunks(&pData->tilemap.layers[i], drawContext);
+	}
+	for (int i = 0; i < VectorSize(pData->objectLayerVertexBuffers); i++)
+	{
+		drawContext->DestroyWorldspaceVertexBuffer(pData->objectLayerVertexBuffers[i]);
+	}
+	DestoryVector(pData->objectLayerVertexBuffers);
+	pData->objectLayerVertexBuffers = NULL;
 }
 
 static void OnWindowDimsChange(struct GameFrameworkLayer* pLayer, int newW, int newH)
@@ -577,12 +889,16 @@ void Game2DLayer_Get(struct GameFrameworkLayer* pLayer, struct Game2DLayerOption
 
 	pData->pLayer = pLayer;
 	pData->cameraClampedToTilemapLayer = -1;
+	pData->debugMessageEvent = Ev_RegisterEventName("DebugMessage");
 	pData->tilemap.layers = NEW_VECTOR(struct TileMapLayer);
 
 	EASSERT(strlen(pData->tilemapFilePath) < 128);
 	EASSERT(strlen(pData->atlasFilePath) < 128);
 	strcpy(pData->tilemapFilePath, pOptions->levelFilePath);
 	strcpy(pData->atlasFilePath, pOptions->atlasFilePath);
+	pData->bUseComponentStore = pOptions->bUseComponentStore;
+	pData->broadphase = pOptions->broadphase;
+	pData->spatialGridCellSize = pOptions->spatialGridCellSize ? pOptions->spatialGridCellSize : SPATIAL_GRID_DEFAULT_CELL_SIZE;
 
 	pLayer->update = &Update;
 	pLayer->draw = &Draw;
@@ -594,7 +910,7 @@ void Game2DLayer_Get(struct GameFrameworkLayer* pLayer, struct Game2DLayerOption
 	pData->camera.scale[0] = 1;
 	pData->camera.scale[1] = 1;
 
-	pData->vertexBuffer = pDC->NewWorldspaceVertBuffer(256);
+	pData->objectLayerVertexBuffers = NEW_VECTOR(H2DWorldspaceVertexBuffer);
 	pData->pWorldspaceVertices = NEW_VECTOR(Worldspace2DVert);
 	pData->pWorldspaceIndices = NEW_VECTOR(VertIndexT);
 
@@ -602,6 +918,33 @@ void Game2DLayer_Get(struct GameFrameworkLayer* pLayer, struct Game2DLayerOption
 	pData->windowW = pDC->screenWidth;
 }
 
+static struct TileMapLayer* GetTileLayer(struct GameLayer2DData* pData, int layerIndex, int col, int row)
+{
+	EASSERT(layerIndex >= 0 && layerIndex < VectorSize(pData->tilemap.layers));
+	struct TileMapLayer* pLayer = &pData->tilemap.layers[layerIndex];
+	EASSERT(!pLayer->bIsObjectLayer);
+	EASSERT(col >= 0 && col < pLayer->widthTiles);
+	EASSERT(row >= 0 && row < pLayer->heightTiles);
+	return pLayer;
+}
+
+void Game2DLayer_SetTile(struct GameLayer2DData* pData, int layerIndex, int col, int row, TileIndex tile)
+{
+	struct TileMapLayer* pLayer = GetTileLayer(pData, layerIndex, col, row);
+	TileIndex* pTile = &pLayer->Tiles[row * pLayer->widthTiles + col];
+	if (*pTile != tile)
+	{
+		*pTile = tile;
+		TilemapLayer_MarkTileDirty(pLayer, col, row);
+	}
+}
+
+TileIndex Game2DLayer_GetTile(struct GameLayer2DData* pData, int layerIndex, int col, int row)
+{
+	struct TileMapLayer* pLayer = GetTileLayer(pData, layerIndex, col, row);
+	return pLayer->Tiles[row * pLayer->widthTiles + col];
+}
+
 void Game2DLayer_SaveLevelFile(struct GameLayer2DData* pData, const char* outputFilePath)
 {
 	struct BinarySerializer bs;
@@ -610,11 +953,11 @@ void Game2DLayer_SaveLevelFile(struct GameLayer2DData* pData, const char* output
 	BS_SerializeU32(1, &bs);
 
 	vec2 tl, br;
-	vec3 dims;
-	glm_vec2_add(tl, dims, br);
-	Entity2DQuadTree_GetDims(pData->hEntitiesQuadTree, tl, &dims[0], &dims[1]);
-	
-	
+	float w, h;
+	Entity2DQuadTree_GetDims(pData->hEntitiesQuadTree, tl, &w, &h);
+	br[0] = tl[0] + w;
+	br[1] = tl[1] + h;
+
 	/* data needed to init quadtree */
 	BS_SerializeFloat(tl[0], &bs);
 	BS_SerializeFloat(tl[1], &bs);
@@ -632,15 +975,12 @@ void Game2DLayer_SaveLevelFile(struct GameLayer2DData* pData, const char* output
 		{
 		case 1: // tile layer
 			BS_SerializeU32(pLayer->widthTiles, &bs);
-			BS_SerializeU32(&pLayer->heightTiles, &bs);
-			BS_SerializeU32(&pLayer->transform.position[1], &bs);
-			BS_SerializeU32(&pLayer->transform.position[1], &bs);
-			BS_SerializeU32(&pLayer->tileWidthPx, &bs);
-			BS_SerializeU32(&pLayer->tileWidthPx, &bs);
-			BS_SerializeU32(2, &bs); // no compression
-
-			// serialize the layer tiles
-			BS_SerializeBytes(pLayer->Tiles, pLayer->widthTiles * pLayer->heightTiles * sizeof(TileIndex), &bs);
+			BS_SerializeU32(pLayer->heightTiles, &bs);
+			BS_SerializeU32((u32)pLayer->transform.position[0], &bs);
+			BS_SerializeU32((u32)pLayer->transform.position[1], &bs);
+			BS_SerializeU32(pLayer->tileWidthPx, &bs);
+			BS_SerializeU32(pLayer->tileHeightPx, &bs);
+			TilemapLayer_SerializeTiles(pLayer, TLC_Smallest, &bs);
 			break;
 		case 2: // object layer
 			BS_SerializeU32(pLayer->drawOrder, &bs);
@@ -650,4 +990,8 @@ void Game2DLayer_SaveLevelFile(struct GameLayer2DData* pData, const char* output
 			EASSERT(false);
 		}
 	}
+	if (!BS_Finish(&bs))
+	{
+		printf("error saving level file %s\n", outputFilePath);
+	}
 }
@@ -3,71 +3,64 @@
 #include "DynArray.h"
 #include "DrawContext.h"
 
-void OutputSpriteVerticesBase(
+void WriteSpriteQuad(
 	AtlasSprite* pSprite,
-	VECTOR(Worldspace2DVert)* pOutVert,
-	VECTOR(VertIndexT)* pOutInd,
-	VertIndexT* pNextIndex,
+	Worldspace2DVert* pVerts,
+	VertIndexT* pIndices,
+	VertIndexT base,
 	vec2 tlPos,
 	vec2 brPos
 )
 {
-	VECTOR(Worldspace2DVert) outVert = *pOutVert;
-	VECTOR(VertIndexT) outInd = *pOutInd;
-
-	VertIndexT base = *pNextIndex;
-	*pNextIndex += 4;
-	ivec2 dims = {
-		brPos[0] - tlPos[0],
-		brPos[1] - tlPos[1]
-	};
-
-	vec2 trPos = {brPos[0], tlPos[1]};
-	vec2 blPos = {tlPos[0], brPos[1]};
-
-	Worldspace2DVert vert = {
-		tlPos[0], tlPos[1],
-		pSprite->topLeftUV_U, pSprite->topLeftUV_V
-	};
-
 	// top left
 	VertIndexT tl = base;
-	outVert = VectorPush(outVert, &vert);
-	
-	vert.x = trPos[0]; 
-	vert.y = trPos[1];
-	vert.u = pSprite->bottomRightUV_U;
-	vert.v = pSprite->topLeftUV_V;
-	
+	pVerts[0].x = tlPos[0];
+	pVerts[0].y = tlPos[1];
+	pVerts[0].u = pSprite->topLeftUV_U;
+	pVerts[0].v = pSprite->topLeftUV_V;
+
 	// top right
 	VertIndexT tr = base + 1;
-	outVert = VectorPush(outVert, &vert);
-
-	vert.x = blPos[0];
-	vert.y = blPos[1];
-	vert.u = pSprite->topLeftUV_U;
-	vert.v = pSprite->bottomRightUV_V;
+	pVerts[1].x = brPos[0];
+	pVerts[1].y = tlPos[1];
+	pVerts[1].u = pSprite->bottomRightUV_U;
+	pVerts[1].v = pSprite->topLeftUV_V;
 
 	// bottom left
 	VertIndexT bl = base + 2;
-	outVert = VectorPush(outVert, &vert);
-
-	vert.x = brPos[0];
-	vert.y = brPos[1];
-	vert.u = pSprite->bottomRightUV_U;
-	vert.v = pSprite->bottomRightUV_V;
+	pVerts[2].x = tlPos[0];
+	pVerts[2].y = brPos[1];
+	pVerts[2].u = pSprite->topLeftUV_U;
+	pVerts[2].v = pSprite->bottomRightUV_V;
 
 	// bottom right
 	VertIndexT br = base + 3;
-	outVert = VectorPush(outVert, &vert);
+	pVerts[3].x = brPos[0];
+	pVerts[3].y = brPos[1];
+	pVerts[3].u = pSprite->bottomRightUV_U;
+	pVerts[3].v = pSprite->bottomRightUV_V;
 
-	outInd = VectorPush(outInd, &tl);
-	outInd = VectorPush(outInd, &tr);
-	outInd = VectorPush(outInd, &bl);
-	outInd = VectorPush(outInd, &tr);
-	outInd = VectorPush(outInd, &br);
-	outInd = VectorPush(outInd, &bl);
+	pIndices[0] = tl;
+	pIndices[1] = tr;
+	pIndices[2] = bl;
+	pIndices[3] = tr;
+	pIndices[4] = br;
+	pIndices[5] = bl;
+}
 
-	*pOutVert = outVert;
-	*pOutInd = outInd;
-}
\ No newline at end of file
+void OutputSpriteVerticesBase(
+	AtlasSprite* pSprite,
+	VECTOR(Worldspace2DVert)* pOutVert,
+	VECTOR(VertIndexT)* pOutInd,
+	VertIndexT* pNextIndex,
+	vec2 tlPos,
+	vec2 brPos
+)
+{
+	Worldspace2DVert* pVerts = NULL;
+	VertIndexT* pIndices = NULL;
+	*pOutVert = VectorEmplaceN(*pOutVert, 4, (void**)&pVerts);
+	*pOutInd = VectorEmplaceN(*pOutInd, 6, (void**)&pIndices);
+	WriteSpriteQuad(pSprite, pVerts, pIndices, *pNextIndex, tlPos, brPos);
+	*pNextIndex += 4;
+}
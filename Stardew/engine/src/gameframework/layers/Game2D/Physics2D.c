@@ -5,6 +5,7 @@
 #include "AssertLib.h"
 #include "GameFramework.h"
 #include "Entities.h"
+#include "Components.h"
 
 struct Phys2dWorld
 {
@@ -88,13 +89,15 @@ void Ph_PhysicsWorldDoCollisionEvents(struct GameFrameworkLayer* pLayer)
         
         if(sensorComponentType == b2_dynamicBody)
         {
-            if(pSensorEnt->components[sensorComponentIndex].data.dynamicCollider.onSensorOverlapBegin)
-                pSensorEnt->components[sensorComponentIndex].data.dynamicCollider.onSensorOverlapBegin(pLayer, hVisitor, pSensorEnt->thisEntity);
+            struct DynamicCollider* pCollider = Co_GetDynamicCollider(pEntCollection, pSensorEnt, sensorComponentIndex);
+            if(pCollider->onSensorOverlapBegin)
+                pCollider->onSensorOverlapBegin(pLayer, hVisitor, pSensorEnt->thisEntity);
         }
         else if(sensorComponentType == b2_staticBody)
         {
-            if(pSensorEnt->components[sensorComponentIndex].data.staticCollider.onSensorOverlapBegin)
-                pSensorEnt->components[sensorComponentIndex].data.staticCollider.onSensorOverlapBegin(pLayer, hVisitor, pSensorEnt->thisEntity);
+            struct StaticCollider* pCollider = Co_GetStaticCollider(pEntCollection, pSensorEnt, sensorComponentIndex);
+            if(pCollider->onSensorOverlapBegin)
+                pCollider->onSensorOverlapBegin(pLayer, hVisitor, pSensorEnt->thisEntity);
         }
     }
     for(int i=0; i < sensorEvents.endCount; i++)
@@ -109,13 +112,15 @@ void Ph_PhysicsWorldDoCollisionEvents(struct GameFrameworkLayer* pLayer)
         
         if(sensorComponentType == b2_dynamicBody)
         {
-            if(pSensorEnt->components[sensorComponentIndex].data.dynamicCollider.onSensorOverlapEnd)
-                pSensorEnt->components[sensorComponentIndex].data.dynamicCollider.onSensorOverlapEnd(pLayer, hVisitor, pSensorEnt);
+            struct DynamicCollider* pCollider = Co_GetDynamicCollider(pEntCollection, pSensorEnt, sensorComponentIndex);
+            if(pCollider->onSensorOverlapEnd)
+                pCollider->onSensorOverlapEnd(pLayer, hVisitor, pSensorEnt->thisEntity);
         }
         else if(sensorComponentType == b2_staticBody)
         {
-            if(pSensorEnt->components[sensorComponentIndex].data.staticCollider.onSensorOverlapEnd)
-                pSensorEnt->components[sensorComponentIndex].data.staticCollider.onSensorOverlapEnd(pLayer, hVisitor, pSensorEnt);
+            struct StaticCollider* pCollider = Co_GetStaticCollider(pEntCollection, pSensorEnt, sensorComponentIndex);
+            if(pCollider->onSensorOverlapEnd)
+                pCollider->onSensorOverlapEnd(pLayer, hVisitor, pSensorEnt->thisEntity);
         }
     }
 }
@@ -0,0 +1,263 @@
+#include "TilemapChunks.h"
+#include "Game2DLayer.h"
+#include "DrawContext.h"
+#include "Atlas.h"
+#include "DynArray.h"
+#include "AssertLib.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* chunks are built into these then uploaded, reused so building a chunk doesn't allocate */
+static VECTOR(Worldspace2DVert) gChunkVerts = NULL;
+static VECTOR(VertIndexT) gChunkIndices = NULL;
+
+static float gUVTable[TILEMAP_UV_TABLE_MAX_TILES * 4];
+
+static u32 CountTiles(struct TileMapLayer* pLayer, int startCol, int endCol, int startRow, int endRow)
+{
+	u32 numTiles = 0;
+	for (int row = startRow; row < endRow; row++)
+	{
+		for (int col = startCol; col < endCol; col++)
+		{
+			numTiles += pLayer->Tiles[row * pLayer->widthTiles + col] != 0;
+		}
+	}
+	return numTiles;
+}
+
+static void BuildChunk(struct TileMapLayer* pLayer, int chunkX, int chunkY, hAtlas atlas, DrawContext* pDC)
+{
+	struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+	struct TilemapChunk* pChunk = &pRenderData->pChunks[chunkY * pRenderData->widthChunks + chunkX];
+
+	int startCol = chunkX * TILEMAP_CHUNK_TILES;
+	int startRow = chunkY * TILEMAP_CHUNK_TILES;
+	int endCol = startCol + TILEMAP_CHUNK_TILES;
+	int endRow = startRow + TILEMAP_CHUNK_TILES;
+	endCol = endCol > pLayer->widthTiles ? pLayer->widthTiles : endCol;
+	endRow = endRow > pLayer->heightTiles ? pLayer->heightTiles : endRow;
+
+	if (pRenderData->bVertexPulled)
+	{
+		/* nothing to build, the tiles are already in the texture */
+		pChunk->numTiles = CountTiles(pLayer, startCol, endCol, startRow, endRow);
+		pChunk->bDirty = false;
+		return;
+	}
+
+	if (!gChunkVerts)
+	{
+		gChunkVerts = NEW_VECTOR(Worldspace2DVert);
+		gChunkIndices = NEW_VECTOR(VertIndexT);
+	}
+	gChunkVerts = VectorClear(gChunkVerts);
+	gChunkIndices = VectorClear(gChunkIndices);
+
+	VertIndexT nextIndex = 0;
+	pChunk->numTiles = OutputTilemapLayerTileRange(atlas, pLayer, &gChunkVerts, &gChunkIndices, &nextIndex, startCol, endCol, startRow, endRow);
+	pChunk->numIndices = VectorSize(gChunkIndices);
+	pChunk->bDirty = false;
+
+	if (pChunk->numIndices == 0)
+	{
+		/* keep the old buffer if there is one, the chunk just won't be drawn */
+		return;
+	}
+	if (pChunk->hVertexBuffer == NULL_HANDLE)
+	{
+		pChunk->hVertexBuffer = pDC->NewWorldspaceVertBuffer(VectorSize(gChunkVerts));
+	}
+	pDC->WorldspaceVertexBufferData(pChunk->hVertexBuffer, gChunkVerts, VectorSize(gChunkVerts), gChunkIndices, pChunk->numIndices);
+}
+
+int TilemapLayer_BuildUVTable(hAtlas atlas, int tileWidthPx, int tileHeightPx, float* outUVs)
+{
+	int numTiles = At_GetNumTilesetTiles(atlas);
+	/* + 1 for the empty tile */
+	if (numTiles == 0 || numTiles + 1 > TILEMAP_UV_TABLE_MAX_TILES)
+	{
+		return 0;
+	}
+	memset(outUVs, 0, 4 * sizeof(float));
+	for (int i = 1; i <= numTiles; i++)
+	{
+		AtlasSprite* pSprite = At_GetSprite(At_TilemapIndexToSprite(atlas, (TileIndex)i), atlas);
+		/* the shader sizes tiles by the layers tile size, OutputSpriteVertices by the sprites size */
+		if (pSprite->widthPx != tileWidthPx || pSprite->heightPx != tileHeightPx)
+		{
+			return 0;
+		}
+		float* pUV = &outUVs[i * 4];
+		pUV[0] = pSprite->topLeftUV_U;
+		pUV[1] = pSprite->topLeftUV_V;
+		pUV[2] = pSprite->bottomRightUV_U;
+		pUV[3] = pSprite->bottomRightUV_V;
+	}
+	return numTiles + 1;
+}
+
+void TilemapLayer_BuildChunks(struct TileMapLayer* pLayer, hAtlas atlas, DrawContext* pDC)
+{
+	EASSERT(!pLayer->bIsObjectLayer);
+	EASSERT(!pLayer->pRenderData);
+	struct TilemapLayerRenderData* pRenderData = malloc(sizeof(struct TilemapLayerRenderData));
+	pRenderData->widthChunks = (pLayer->widthTiles + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+	pRenderData->heightChunks = (pLayer->heightTiles + TILEMAP_CHUNK_TILES - 1) / TILEMAP_CHUNK_TILES;
+	pRenderData->numDirtyChunks = 0;
+	pRenderData->bVertexPulled = false;
+	pRenderData->hTileIndexTexture = NULL_HANDLE;
+	pRenderData->hUVTable = NULL_HANDLE;
+	pRenderData->pDirtyTiles = NULL;
+	if (pDC->NewTileIndexTexture)
+	{
+		int numUVs = TilemapLayer_BuildUVTable(atlas, pLayer->tileWidthPx, pLayer->tileHeightPx, gUVTable);
+		if (numUVs > 0)
+		{
+			pRenderData->bVertexPulled = true;
+			pRenderData->hTileIndexTexture = pDC->NewTileIndexTexture(pLayer->Tiles, pLayer->widthTiles, pLayer->heightTiles);
+			pRenderData->hUVTable = pDC->NewTilemapUVTable(gUVTable, numUVs);
+			pRenderData->pDirtyTiles = NEW_VECTOR(int);
+		}
+	}
+	int numChunks = pRenderData->widthChunks * pRenderData->heightChunks;
+	pRenderData->pChunks = malloc(numChunks * sizeof(struct TilemapChunk));
+	for (int i = 0; i < numChunks; i++)
+	{
+		pRenderData->pChunks[i].hVertexBuffer = NULL_HANDLE;
+		pRenderData->pChunks[i].numIndices = 0;
+		pRenderData->pChunks[i].numTiles = 0;
+		pRenderData->pChunks[i].bDirty = false;
+	}
+	pLayer->pRenderData = pRenderData;
+
+	for (int y = 0; y < pRenderData->heightChunks; y++)
+	{
+		for (int x = 0; x < pRenderData->widthChunks; x++)
+		{
+			BuildChunk(pLayer, x, y, atlas, pDC);
+		}
+	}
+}
+
+void TilemapLayer_DestroyChunks(struct TileMapLayer* pLayer, DrawContext* pDC)
+{
+	struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+	if (!pRenderData)
+	{
+		return;
+	}
+	for (int i = 0; i < pRenderData->widthChunks * pRenderData->heightChunks; i++)
+	{
+		if (pRenderData->pChunks[i].hVertexBuffer != NULL_HANDLE)
+		{
+			pDC->DestroyWorldspaceVertexBuffer(pRenderData->pChunks[i].hVertexBuffer);
+		}
+	}
+	if (pRenderData->bVertexPulled)
+	{
+		pDC->DestroyTexture(pRenderData->hTileIndexTexture);
+		pDC->DestroyTilemapUVTable(pRenderData->hUVTable);
+		DestoryVector(pRenderData->pDirtyTiles);
+	}
+	free(pRenderData->pChunks);
+	free(pRenderData);
+	pLayer->pRenderData = NULL;
+}
+
+void TilemapLayer_MarkTileDirty(struct TileMapLayer* pLayer, int col, int row)
+{
+	struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+	if (!pRenderData)
+	{
+		return;
+	}
+	EASSERT(col >= 0 && col < pLayer->widthTiles);
+	EASSERT(row >= 0 && row < pLayer->heightTiles);
+	if (pRenderData->bVertexPulled)
+	{
+		int tile = row * pLayer->widthTiles + col;
+		pRenderData->pDirtyTiles = VectorPush(pRenderData->pDirtyTiles, &tile);
+	}
+	struct TilemapChunk* pChunk = &pRenderData->pChunks[(row / TILEMAP_CHUNK_TILES) * pRenderData->widthChunks + col / TILEMAP_CHUNK_TILES];
+	if (!pChunk->bDirty)
+	{
+		pChunk->bDirty = true;
+		pRenderData->numDirtyChunks++;
+	}
+}
+
+void TilemapLayer_RebuildDirtyChunks(struct TileMapLayer* pLayer, hAtlas atlas, DrawContext* pDC)
+{
+	struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+	if (!pRenderData || pRenderData->numDirtyChunks == 0)
+	{
+		return;
+	}
+	if (pRenderData->bVertexPulled)
+	{
+		for (int i = 0; i < VectorSize(pRenderData->pDirtyTiles); i++)
+		{
+			int tile = pRenderData->pDirtyTiles[i];
+			pDC->TileIndexTextureSetTile(pRenderData->hTileIndexTexture, tile % pLayer->widthTiles, tile / pLayer->widthTiles, pLayer->Tiles[tile]);
+		}
+		pRenderData->pDirtyTiles = VectorClear(pRenderData->pDirtyTiles);
+	}
+	for (int y = 0; y < pRenderData->heightChunks; y++)
+	{
+		for (int x = 0; x < pRenderData->widthChunks; x++)
+		{
+			if (pRenderData->pChunks[y * pRenderData->widthChunks + x].bDirty)
+			{
+				BuildChunk(pLayer, x, y, atlas, pDC);
+			}
+		}
+	}
+	pRenderData->numDirtyChunks = 0;
+}
+
+static int ClampInt(int val, int min, int max)
+{
+	return val < min ? min : (val > max ? max : val);
+}
+
+int TilemapLayer_DrawVisibleChunks(struct TileMapLayer* pLayer, DrawContext* pDC, vec2 viewportTL, vec2 viewportBR, mat4 view)
+{
+	struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+	EASSERT(pRenderData);
+	float chunkW = (float)(pLayer->tileWidthPx * TILEMAP_CHUNK_TILES);
+	float chunkH = (float)(pLayer->tileHeightPx * TILEMAP_CHUNK_TILES);
+	int startX = ClampInt((int)floorf((viewportTL[0] - pLayer->transform.position[0]) / chunkW), 0, pRenderData->widthChunks);
+	int endX = ClampInt((int)floorf((viewportBR[0] - pLayer->transform.position[0]) / chunkW) + 1, 0, pRenderData->widthChunks);
+	int startY = ClampInt((int)floorf((viewportTL[1] - pLayer->transform.position[1]) / chunkH), 0, pRenderData->heightChunks);
+	int endY = ClampInt((int)floorf((viewportBR[1] - pLayer->transform.position[1]) / chunkH) + 1, 0, pRenderData->heightChunks);
+
+	vec2 tileSize = { (float)pLayer->tileWidthPx, (float)pLayer->tileHeightPx };
+	int numTiles = 0;
+	for (int y = startY; y < endY; y++)
+	{
+		for (int x = startX; x < endX; x++)
+		{
+			struct TilemapChunk* pChunk = &pRenderData->pChunks[y * pRenderData->widthChunks + x];
+			if (pChunk->numTiles == 0)
+			{
+				continue;
+			}
+			if (pRenderData->bVertexPulled)
+			{
+				int startCol = x * TILEMAP_CHUNK_TILES;
+				int startRow = y * TILEMAP_CHUNK_TILES;
+				int numCols = ClampInt(pLayer->widthTiles - startCol, 0, TILEMAP_CHUNK_TILES);
+				int numRows = ClampInt(pLayer->heightTiles - startRow, 0, TILEMAP_CHUNK_TILES);
+				pDC->DrawTilemapChunk(pRenderData->hTileIndexTexture, pRenderData->hUVTable, startCol, startRow, numCols, numRows, tileSize, pLayer->transform.position, view);
+			}
+			else
+			{
+				pDC->DrawWorldspaceVertexBuffer(pChunk->hVertexBuffer, pChunk->numIndices, view);
+			}
+			numTiles += pChunk->numTiles;
+		}
+	}
+	return numTiles;
+}
@@ -164,16 +164,18 @@ void* OutputWidgetQuad(VECTOR(WidgetVertex) pOutVerts, const WidgetQuad* pQuad)
 		VL_BR,
 		VL_BL
 	};
+	WidgetVertex* pDst = NULL;
+	pOutVerts = VectorEmplaceN(pOutVerts, numIndices, (void**)&pDst);
 	for (int i = 0; i < numIndices; i++)
 	{
-		int index = indices[i];
-		pOutVerts = VectorPush(pOutVerts, &cpy.v[index]);
+		pDst[i] = cpy.v[indices[i]];
 	}
 	return pOutVerts;
 }
 
 void* OutputWidgetQuads(VECTOR(WidgetVertex) pOutVerts, const WidgetQuad* pQuads, int num)
 {
+	pOutVerts = VectorReserve(pOutVerts, VectorSize(pOutVerts) + num * 6);
 	for (int i = 0; i < num; i++)
 	{
 		pOutVerts = OutputWidgetQuad(pOutVerts, &pQuads[i]);
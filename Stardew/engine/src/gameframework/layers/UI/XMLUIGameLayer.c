@@ -28,6 +28,7 @@
 #include "CanvasWidget.h"
 #include "TextEntryWidget.h"
 #include "DataNode.h"
+#include "Profiler.h"
 #include "StringKeyHashMap.h"
 #include "GameFrameworkEvent.h"
 #include <libxml/parser.h>
@@ -203,27 +204,35 @@ static void UpdateRootWidget(XMLUIData* pData, DrawContext* dc)
 {
 	VectorClear(pData->pWidgetVertices);
 	struct UIWidget* pRootWidget = UI_GetWidget(pData->rootWidget);
-	pRootWidget->fnLayoutChildren(pRootWidget, NULL);
-	pData->pWidgetVertices = pRootWidget->fnOutputVertices(pRootWidget, pData->pWidgetVertices);
-	dc->UIVertexBufferData(pData->hVertexBuffer, pData->pWidgetVertices, VectorSize(pData->pWidgetVertices));
+	PROFILE_ZONE("UI.Layout") pRootWidget->fnLayoutChildren(pRootWidget, NULL);
+	PROFILE_ZONE("UI.OutputVertices") pData->pWidgetVertices = pRootWidget->fnOutputVertices(pRootWidget, pData->pWidgetVertices);
+	PROFILE_ZONE("UI.UploadVertices") dc->UIVertexBufferData(pData->hVertexBuffer, pData->pWidgetVertices, VectorSize(pData->pWidgetVertices));
 	SetRootWidgetIsDirty(pData->rootWidget, false);
 }
 
 static void Draw(struct GameFrameworkLayer* pLayer, DrawContext* dc)
 {
 	XMLUIData* pData = pLayer->userData;
-	At_SetCurrent(pData->atlas, dc);
 	struct UIWidget* pRootWidget = UI_GetWidget(pData->rootWidget);
 	if (!pRootWidget)
 	{
+		At_SetCurrent(pData->atlas, dc);
 		printf("something wrong\n");
 		return;
 	}
 
+	/* glyphs the vertices use may have been evicted from the atlas's glyph cache to make room for another layers */
+	if (At_GetGlyphCacheGeneration(pData->atlas) != pData->glyphCacheGeneration)
+	{
+		SetRootWidgetIsDirty(pData->rootWidget, true);
+	}
 	if (GetRootWidgetIsDirty(pData->rootWidget))
 	{
 		UpdateRootWidget(pData, dc);
+		pData->glyphCacheGeneration = At_GetGlyphCacheGeneration(pData->atlas);
 	}
+	/* after outputting the vertices, so glyphs they rasterised are uploaded before drawing */
+	At_SetCurrent(pData->atlas, dc);
 	int size = VectorSize(pData->pWidgetVertices);
 
 	dc->DrawUIVertexBuffer(pData->hVertexBuffer, size);
@@ -290,11 +299,9 @@ static bool SendMouseDownAndFocus(struct WidgetMouseInfo* info, HWidget hWidget,
 
 static void Input(struct GameFrameworkLayer* pLayer, InputContext* ctx)
 {
+	/* persist between calls, swapped each call rather than copied */
 	static VECTOR(HWidget) pWidgetsHovverred = NULL;
 	static VECTOR(HWidget) pWidgetsHovverredLastFrame = NULL;
-	static VECTOR(HWidget) pWidgetsEntered = NULL;
-	static VECTOR(HWidget) pWidgetsLeft = NULL;
-	static VECTOR(HWidget) pWidgetsRemained = NULL;
 
 	static bool bLastLeftClick = false;
 	static bool bThisLeftClick = false;
@@ -309,29 +316,15 @@ static void Input(struct GameFrameworkLayer* pLayer, InputContext* ctx)
 	{
 		pWidgetsHovverredLastFrame = NEW_VECTOR(HWidget);
 	}
-	if (!pWidgetsEntered)
-	{
-		pWidgetsEntered = NEW_VECTOR(HWidget);
-	}
-	if (!pWidgetsLeft)
-	{
-		pWidgetsLeft = NEW_VECTOR(HWidget);
-	}
-	if (!pWidgetsRemained)
-	{
-		pWidgetsRemained = NEW_VECTOR(HWidget);
-	}
 
-	pWidgetsHovverredLastFrame = VectorClear(pWidgetsHovverredLastFrame);
-	for (int i = 0; i < VectorSize(pWidgetsHovverred); i++)
-	{
-		pWidgetsHovverredLastFrame = VectorPush(pWidgetsHovverredLastFrame, &pWidgetsHovverred[i]);
-	}
+	VECTOR(HWidget) pSwap = pWidgetsHovverredLastFrame;
+	pWidgetsHovverredLastFrame = pWidgetsHovverred;
+	pWidgetsHovverred = VectorClear(pSwap);
 
-	pWidgetsHovverred = VectorClear(pWidgetsHovverred);
-	pWidgetsEntered = VectorClear(pWidgetsEntered);
-	pWidgetsLeft = VectorClear(pWidgetsLeft);
-	pWidgetsRemained = VectorClear(pWidgetsRemained);
+	/* scratch, only needed for the rest of this function */
+	VECTOR(HWidget) pWidgetsEntered = NEW_FRAME_VECTOR(HWidget);
+	VECTOR(HWidget) pWidgetsLeft = NEW_FRAME_VECTOR(HWidget);
+	VECTOR(HWidget) pWidgetsRemained = NEW_FRAME_VECTOR(HWidget);
 
 	XMLUIData* pUIData = pLayer->userData;
 	//pUIData->pChildrenChangeRequests = VectorClear(pUIData->pChildrenChangeRequests);
@@ -214,7 +214,7 @@ static int GetWhitespaceStrippedLengthAndStart(char* inString, char** outStrippe
 	// find end
 	int len = strlen(inString);
 	strippedEnd = inString + (len - 1);
-	while(IsWhitespaceChar(*strippedEnd))
+	while(strippedEnd >= strippedStart && IsWhitespaceChar(*strippedEnd))
 	{
 		strippedEnd--;
 	}
@@ -8,6 +8,11 @@
 #include "Atlas.h"
 #include "Widget.h"
 #include "Scripting.h"
+#include "FrameArena.h"
+#include "NullDrawContext.h"
+#include "Profiler.h"
+#include "Clock.h"
+#include "main.h"
 #include <string.h>
 #include "PlatformDefs.h"
 #include <libxml/parser.h>
@@ -15,6 +20,7 @@
 #define SCR_WIDTH 640
 #define SCR_HEIGHT 480
 #define TARGET_FPS 60
+#define PROFILER_EXPORT_KEY GLFW_KEY_F9
 
 InputContext gInputContext;
 DrawContext gDrawContext;
@@ -54,6 +60,12 @@ void MouseBtnCallback(GLFWwindow* window, int button, int action, int mods)
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+#ifdef STARDEW_PROFILER
+    if (key == PROFILER_EXPORT_KEY && action == GLFW_PRESS)
+    {
+        Prof_RequestExport();
+    }
+#endif
     In_RecieveKeyboardKey(&gInputContext, key, scancode, action, mods);
 }
 
@@ -86,7 +98,45 @@ static void GLAPIENTRY MessageCallback(GLenum source,
     }
 }
 
-typedef void(*GameInitFn)(InputContext*,DrawContext*);
+static void InitEngineSystems()
+{
+#ifdef STARDEW_PROFILER
+    Prof_Init();
+#endif
+    printf("initial screen dims change\n");
+    Dr_OnScreenDimsChange(&gDrawContext, SCR_WIDTH, SCR_HEIGHT);
+    printf("done\n");
+    printf("initialising input context\n");
+    gInputContext = In_InitInputContext();
+    printf("done\n");
+    printf("Initialising game framework\n");
+    GF_InitGameFramework();
+    printf("done\n");
+    printf("initialising image registry\n");
+    IR_InitImageRegistry(NULL);
+    printf("done\n");
+    printf("initialising atlas\n");
+    At_Init();
+    printf("done\n");
+    printf("initialising UI\n");
+    UI_Init();
+    printf("done\n");
+    printf("initialising scripting\n");
+    Sc_InitScripting();
+    printf("done\n");
+}
+
+static void DestroyEngineSystems()
+{
+    Sc_DeInitScripting();
+    IR_DestroyImageRegistry();
+    GF_DestroyGameFramework();
+    Ar_DestroyFrameArenas();
+#ifdef STARDEW_PROFILER
+    Prof_ExportChromeTrace(PROFILER_TRACE_PATH);
+    Prof_Shutdown();
+#endif
+}
 
 int EngineStart(int argc, char** argv, GameInitFn init)
 {
@@ -172,27 +222,7 @@ int EngineStart(int argc, char** argv, GameInitFn init)
     printf("initialising draw context\n");
     gDrawContext = Dr_InitDrawContext();
     printf("done\n");
-    printf("initial screen dims change\n");
-    Dr_OnScreenDimsChange(&gDrawContext, SCR_WIDTH, SCR_HEIGHT);
-    printf("done\n");
-    printf("initialising input context\n");
-    gInputContext = In_InitInputContext();
-    printf("done\n");
-    printf("Initialising game framework\n");
-    GF_InitGameFramework();
-    printf("done\n");
-    printf("initialising image registry\n");
-    IR_InitImageRegistry(NULL);
-    printf("done\n");
-    printf("initialising atlas\n");
-    At_Init();
-    printf("done\n");
-    printf("initialising UI\n");
-    UI_Init();
-    printf("done\n");
-    printf("initialising scripting\n");
-    Sc_InitScripting();
-    printf("done\n");
+    InitEngineSystems();
 
     init(&gInputContext, &gDrawContext);
     
@@ -207,19 +237,25 @@ int EngineStart(int argc, char** argv, GameInitFn init)
         accumulator += delta;
         while (accumulator > slice)
         {
-            glfwPollEvents();
-            GF_InputGameFramework(&gInputContext);
-            GF_UpdateGameFramework((float)slice);
-            In_EndFrame(&gInputContext);
+            PROFILE_ZONE("Main.Update")
+            {
+                glfwPollEvents();
+                GF_InputGameFramework(&gInputContext);
+                GF_UpdateGameFramework((float)slice);
+                In_EndFrame(&gInputContext);
+            }
             accumulator -= slice;
         }
+        PROFILE_ZONE("Main.ImageLoads") IR_PollImageLoads();
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        GF_DrawGameFramework(&gDrawContext);
-        glfwSwapBuffers(window);
+        PROFILE_ZONE("Main.Draw") GF_DrawGameFramework(&gDrawContext);
+        Ar_EndFrame();
+        PROFILE_ZONE("Main.SwapBuffers") glfwSwapBuffers(window);
         GF_EndFrame(&gDrawContext, &gInputContext);
+        PROFILE_FRAME_MARK();
         frameTimeTotal += delta;
         onCount++;
         if(onCount == numCounts)
@@ -230,13 +266,65 @@ int EngineStart(int argc, char** argv, GameInitFn init)
         }
     }
 
-    Sc_DeInitScripting();
-    IR_DestroyImageRegistry();
-    GF_DestroyGameFramework();
+    DestroyEngineSystems();
 
     glfwTerminate();
 }
 
+int EngineStartHeadless(int numFrames, GameInitFn init, struct HeadlessRunStats* pOutStats)
+{
+    LIBXML_TEST_VERSION
+    memset(pOutStats, 0, sizeof(struct HeadlessRunStats));
+    double slice = 1.0 / TARGET_FPS;
+
+    double initStart = Clk_NowMs();
+    gDrawContext = Dr_InitNullDrawContext();
+    InitEngineSystems();
+    init(&gInputContext, &gDrawContext);
+    /* apply the layer pushes queued by init, in the windowed loop this happens at the end of the first frame */
+    GF_EndFrame(&gDrawContext, &gInputContext);
+    Dr_NullDrawContextEndFrame();
+    pOutStats->initMs = Clk_NowMs() - initStart;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        /* one fixed timestep update per frame, as fast as possible */
+        double updateStart = Clk_NowMs();
+        PROFILE_ZONE("Main.Update")
+        {
+            GF_InputGameFramework(&gInputContext);
+            GF_UpdateGameFramework((float)slice);
+            In_EndFrame(&gInputContext);
+        }
+        PROFILE_ZONE("Main.ImageLoads") IR_PollImageLoads();
+        double drawStart = Clk_NowMs();
+        PROFILE_ZONE("Main.Draw") GF_DrawGameFramework(&gDrawContext);
+        Ar_EndFrame();
+        GF_EndFrame(&gDrawContext, &gInputContext);
+        Dr_NullDrawContextEndFrame();
+        PROFILE_FRAME_MARK();
+        double end = Clk_NowMs();
+
+        struct NullDrawCounters frameCounters = Dr_GetNullDrawStats().lastFrame;
+        pOutStats->drawTotals.drawCalls += frameCounters.drawCalls;
+        pOutStats->drawTotals.verticesDrawn += frameCounters.verticesDrawn;
+        pOutStats->drawTotals.bytesUploaded += frameCounters.bytesUploaded;
+
+        double updateMs = drawStart - updateStart;
+        double drawMs = end - drawStart;
+        pOutStats->updateMsTotal += updateMs;
+        pOutStats->drawMsTotal += drawMs;
+        pOutStats->updateMsMax = updateMs > pOutStats->updateMsMax ? updateMs : pOutStats->updateMsMax;
+        pOutStats->drawMsMax = drawMs > pOutStats->drawMsMax ? drawMs : pOutStats->drawMsMax;
+        pOutStats->numFrames++;
+    }
+    pOutStats->drawStats = Dr_GetNullDrawStats();
+
+    DestroyEngineSystems();
+    Dr_DestroyNullDrawContext();
+    return 0;
+}
+
 void GameInit(InputContext* pIC, DrawContext* pDC)
 {
     struct GameFrameworkLayer testLayer;
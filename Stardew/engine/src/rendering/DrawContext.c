@@ -8,6 +8,7 @@
 #include "AssertLib.h"
 #include "PlatformDefs.h"
 #include "Game2DLayer.h"
+#include "Profiler.h"
 
 const char* uiVert =
 #if GAME_GL_API_TYPE == GAME_GL_API_TYPE_CORE
@@ -97,9 +98,40 @@ const char* worldspaceFrag =
 "}\n"
 ;
 
-//
-//const char* tilemapVert = 
-//"#version 330 core\n"
+/*
+	Vertex pulled tilemap chunks, see Assets/shaders/Tilemap.vert.
+	Six vertices per tile, the tile index comes from the tile index texture and its uvs from the uv table.
+	Empty tiles (index 0) are moved outside the clip volume.
+*/
+const char* tilemapVert =
+"#version 300 es\n"
+"precision highp float;\n"
+"precision highp int;\n"
+"precision highp usampler2D;\n"
+"out vec2 UV;\n"
+"uniform mat4 vp;\n"
+"uniform ivec2 chunkOffset;\n"
+"uniform ivec2 chunkSize;\n"
+"uniform vec2 tileSize;\n"
+"uniform vec2 origin;\n"
+"uniform usampler2D tileIndices;\n"
+"layout(std140) uniform TilemapUVTable\n"
+"{\n"
+	"vec4 uvs[1024];\n"
+"};\n"
+"const ivec2 corners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 0), ivec2(1, 1), ivec2(0, 1));\n"
+"void main()\n"
+"{\n"
+	"int whichTile = gl_VertexID / 6;\n"
+	"ivec2 corner = corners[gl_VertexID % 6];\n"
+	"ivec2 tileXY = chunkOffset + ivec2(whichTile % chunkSize.x, whichTile / chunkSize.x);\n"
+	"int tile = int(texelFetch(tileIndices, tileXY, 0).r);\n"
+	"vec4 uvTLBR = uvs[tile];\n"
+	"UV = mix(uvTLBR.xy, uvTLBR.zw, vec2(corner));\n"
+	"vec2 pos = origin + vec2(tileXY + corner) * tileSize;\n"
+	"gl_Position = tile == 0 ? vec4(0.0, 0.0, 2.0, 1.0) : vp * vec4(pos, 0.0, 1.0);\n"
+"}\n"
+;
 
 struct IndexedVertexBuffer
 {
@@ -145,6 +177,13 @@ struct Shader gUIShader = {0,0,0};
 
 struct Shader gWorldspace2DShader = { 0,0,0 };
 
+struct Shader gTilemapShader = { 0,0,0 };
+
+/* vertex pulled draws have no attributes but GL still wants a vertex array bound */
+static GLuint gEmptyVAO = 0;
+
+#define TILEMAP_UV_TABLE_BINDING 0
+
 mat4 gScreenspaceOrtho;
 
 OBJECT_POOL(struct VertexBuffer) gVertexBuffersPool = NULL;
@@ -241,12 +280,15 @@ static void CreateShaders()
 {
 	CreateShader(uiVert, uiFrag, &gUIShader);
 	CreateShader(worldspaceVert, worldspaceFrag, &gWorldspace2DShader);
+	CreateShader(tilemapVert, worldspaceFrag, &gTilemapShader);
+	GLuint uvTableIndex = glGetUniformBlockIndex(gTilemapShader.program, "TilemapUVTable");
+	glUniformBlockBinding(gTilemapShader.program, uvTableIndex, TILEMAP_UV_TABLE_BINDING);
 };
 
 static HUIVertexBuffer NewUIVertexBuffer(int size)
 {
 	HUIVertexBuffer buf = -1;
-	GetObjectPoolIndex(gVertexBuffersPool, &buf);
+	gVertexBuffersPool = GetObjectPoolIndex(gVertexBuffersPool, &buf);
 	struct VertexBuffer* pBuf = &gVertexBuffersPool[buf];
 	pBuf->capacity = 0;
 	glGenVertexArrays(1, &pBuf->vao);
@@ -278,6 +320,8 @@ static void DrawUIVertexBuffer(HUIVertexBuffer hBuf, size_t vertexCount)
 	glUniformMatrix4fv(projectionViewUniform, 1, false, &gScreenspaceOrtho[0][0]);
 
 	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, vertexCount);
 }
 
 static void DestroyUIVertexBuffer(HUIVertexBuffer hBuf)
@@ -285,6 +329,7 @@ static void DestroyUIVertexBuffer(HUIVertexBuffer hBuf)
 	const struct VertexBuffer* vertexBuffer = &gVertexBuffersPool[hBuf];
 	glDeleteBuffers(1, &vertexBuffer->vbo);
 	glDeleteVertexArrays(1, &vertexBuffer->vao);
+	FreeObjectPoolIndex(gVertexBuffersPool, hBuf);
 }
 
 static hTexture UploadTexture(void* src, int channels, int pxWidth, int pxHeight)
@@ -295,6 +340,52 @@ static hTexture UploadTexture(void* src, int channels, int pxWidth, int pxHeight
 	return txture;
 }
 
+static GLuint gTextureUploadPBO = 0;
+static int gMappedTextureWidth = 0;
+static int gMappedTextureHeight = 0;
+
+static void* MapTextureUploadBuffer(int channels, int pxWidth, int pxHeight)
+{
+	EASSERT(channels == 4);
+	if (!gTextureUploadPBO)
+	{
+		glGenBuffers(1, &gTextureUploadPBO);
+	}
+	GLsizeiptr size = (GLsizeiptr)channels * pxWidth * pxHeight;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gTextureUploadPBO);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	void* pMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	gMappedTextureWidth = pxWidth;
+	gMappedTextureHeight = pxHeight;
+	return pMapped;
+}
+
+static hTexture UploadMappedTexture()
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gTextureUploadPBO);
+	if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+	{
+		/* the buffer's contents were lost while it was mapped, this is rare and we can't recover them */
+		printf("texture upload buffer was corrupted\n");
+	}
+	hTexture txture = 0;
+	/* with a pixel unpack buffer bound the data pointer is an offset into it */
+	OpenGlGPULoadTexture(NULL, gMappedTextureWidth, gMappedTextureHeight, &txture);
+	/* let the driver free the memory once the copy's done, it's only needed while loading */
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, 0, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return txture;
+}
+
+static void UpdateTextureRegion(hTexture tex, const void* src, int channels, int x, int y, int pxWidth, int pxHeight)
+{
+	EASSERT(channels == 4);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pxWidth, pxHeight, GL_RGBA, GL_UNSIGNED_BYTE, src);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 static void SetCurrentAtlas(hTexture atlas)
 {
 	glActiveTexture(GL_TEXTURE0);
@@ -310,7 +401,7 @@ static void DestroyTexture(hTexture tex)
 static HWorldspaceVertexBuffer NewWorldspaceVertexBuffer(int size)
 {
 	HWorldspaceVertexBuffer buf = -1;
-	GetObjectPoolIndex(gIndexedVertexBuffersPool, &buf);
+	gIndexedVertexBuffersPool = GetObjectPoolIndex(gIndexedVertexBuffersPool, &buf);
 	struct IndexedVertexBuffer* pBuf = &gIndexedVertexBuffersPool[buf];
 	pBuf->capacity = 0;
 	pBuf->eboCapacity = 0;
@@ -339,7 +430,7 @@ void WorldspaceVertexBufferData(HUIVertexBuffer hBuf, Worldspace2DVert* src, siz
 	if (size * sizeof(Worldspace2DVert) > pBuf->capacity)
 	{
 		glBufferData(GL_ARRAY_BUFFER, size * sizeof(Worldspace2DVert), src, GL_DYNAMIC_DRAW);
-		pBuf->capacity = size;
+		pBuf->capacity = size * sizeof(Worldspace2DVert);
 	}
 	else
 	{
@@ -353,7 +444,7 @@ void WorldspaceVertexBufferData(HUIVertexBuffer hBuf, Worldspace2DVert* src, siz
 	}
 	else
 	{
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size * sizeof(VertIndexT), indices);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, numIndices * sizeof(VertIndexT), indices);
 	}
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -372,6 +463,8 @@ void DrawWorldspaceVertexBuffer(H2DWorldspaceVertexBuffer hBuf, size_t indexCoun
 	glm_mat4_mul(&gScreenspaceOrtho[0][0], view, m);
 	glUniformMatrix4fv(projectionViewUniform, 1, false, &m[0][0]);
 	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, indexCount);
 }
 
 void DestroyWorldspaceVertexBuffer(H2DWorldspaceVertexBuffer hBuf)
@@ -380,6 +473,78 @@ void DestroyWorldspaceVertexBuffer(H2DWorldspaceVertexBuffer hBuf)
 	glDeleteBuffers(1, &vertexBuffer->vbo);
 	glDeleteBuffers(1, &vertexBuffer->ebo);
 	glDeleteVertexArrays(1, &vertexBuffer->vao);
+	FreeObjectPoolIndex(gIndexedVertexBuffersPool, hBuf);
+}
+
+static hTexture NewTileIndexTexture(const TileIndex* tiles, int widthTiles, int heightTiles)
+{
+	GLuint tex = 0;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	/* integer textures can't be filtered, they're only read with texelFetch */
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	/* rows of an odd width layer aren't 4 byte aligned */
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, widthTiles, heightTiles, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, tiles);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return tex;
+}
+
+static void TileIndexTextureSetTile(hTexture tex, int col, int row, TileIndex tile)
+{
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, col, row, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_SHORT, &tile);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static HTilemapUVTable NewTilemapUVTable(const float* uvs, int numTiles)
+{
+	EASSERT(numTiles <= TILEMAP_UV_TABLE_MAX_TILES);
+	GLuint ubo = 0;
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	/* the whole block is allocated, the shader declares all TILEMAP_UV_TABLE_MAX_TILES entries */
+	glBufferData(GL_UNIFORM_BUFFER, TILEMAP_UV_TABLE_MAX_TILES * 4 * sizeof(float), NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, numTiles * 4 * sizeof(float), uvs);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return ubo;
+}
+
+static void DestroyTilemapUVTable(HTilemapUVTable hTable)
+{
+	GLuint ubo = hTable;
+	glDeleteBuffers(1, &ubo);
+}
+
+static void DrawTilemapChunk(hTexture tileIndices, HTilemapUVTable hTable, int startCol, int startRow, int numCols, int numRows, vec2 tileSizePx, vec2 origin, mat4 view)
+{
+	glUseProgram(gTilemapShader.program);
+	glBindVertexArray(gEmptyVAO);
+	mat4 m;
+	glm_mat4_mul(gScreenspaceOrtho, view, m);
+	glUniformMatrix4fv(glGetUniformLocation(gTilemapShader.program, "vp"), 1, false, &m[0][0]);
+	glUniform2i(glGetUniformLocation(gTilemapShader.program, "chunkOffset"), startCol, startRow);
+	glUniform2i(glGetUniformLocation(gTilemapShader.program, "chunkSize"), numCols, numRows);
+	glUniform2f(glGetUniformLocation(gTilemapShader.program, "tileSize"), tileSizePx[0], tileSizePx[1]);
+	glUniform2f(glGetUniformLocation(gTilemapShader.program, "origin"), origin[0], origin[1]);
+
+	/* the atlas stays bound to unit 0 */
+	glUniform1i(glGetUniformLocation(gTilemapShader.program, "ourTexture"), 0);
+	glUniform1i(glGetUniformLocation(gTilemapShader.program, "tileIndices"), 1);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, tileIndices);
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, TILEMAP_UV_TABLE_BINDING, hTable);
+
+	int numVerts = numCols * numRows * 6;
+	glDrawArrays(GL_TRIANGLES, 0, numVerts);
+	glBindVertexArray(0);
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, numVerts);
 }
 
 DrawContext Dr_InitDrawContext()
@@ -393,16 +558,27 @@ DrawContext Dr_InitDrawContext()
 
 	d.SetCurrentAtlas = &SetCurrentAtlas;
 	d.UploadTexture = &UploadTexture;
+	d.DestroyTexture = &DestroyTexture;
+	d.UpdateTextureRegion = &UpdateTextureRegion;
+	d.MapTextureUploadBuffer = &MapTextureUploadBuffer;
+	d.UploadMappedTexture = &UploadMappedTexture;
 
 	d.NewWorldspaceVertBuffer = &NewWorldspaceVertexBuffer;
 	d.WorldspaceVertexBufferData = &WorldspaceVertexBufferData;
 	d.DrawWorldspaceVertexBuffer = &DrawWorldspaceVertexBuffer;
 	d.DestroyWorldspaceVertexBuffer = &DestroyWorldspaceVertexBuffer;
 
+	d.NewTileIndexTexture = &NewTileIndexTexture;
+	d.TileIndexTextureSetTile = &TileIndexTextureSetTile;
+	d.NewTilemapUVTable = &NewTilemapUVTable;
+	d.DestroyTilemapUVTable = &DestroyTilemapUVTable;
+	d.DrawTilemapChunk = &DrawTilemapChunk;
+
 	gVertexBuffersPool = NEW_OBJECT_POOL(struct VertexBuffer, 256);
 	gIndexedVertexBuffersPool = NEW_OBJECT_POOL(struct IndexedVertexBuffer, 256);
 	glm_mat4_identity(gScreenspaceOrtho);
 	CreateShaders();
+	glGenVertexArrays(1, &gEmptyVAO);
 	return d;
 }
 
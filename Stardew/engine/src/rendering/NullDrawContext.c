@@ -0,0 +1,209 @@
+#include "NullDrawContext.h"
+#include <string.h>
+#include <stdlib.h>
+#include "DynArray.h"
+#include "AssertLib.h"
+#include "Profiler.h"
+
+struct NullBuffer
+{
+	bool bLive;
+	/* grows like the GL buffers do, never shrinks */
+	size_t vertexCapacityBytes;
+	size_t indexCapacityBytes;
+};
+
+/* UI and worldspace buffers share the handle space, handle == index */
+static VECTOR(struct NullBuffer) gBuffers = NULL;
+static struct NullDrawCounters gThisFrame;
+static struct NullDrawStats gStats;
+
+static HGeneric NewBuffer()
+{
+	struct NullBuffer buf;
+	memset(&buf, 0, sizeof(struct NullBuffer));
+	buf.bLive = true;
+	gBuffers = VectorPush(gBuffers, &buf);
+	gStats.numLiveBuffers++;
+	return VectorSize(gBuffers) - 1;
+}
+
+static void DestroyBuffer(HGeneric hBuf)
+{
+	struct NullBuffer* pBuf = &gBuffers[hBuf];
+	EASSERT(pBuf->bLive);
+	pBuf->bLive = false;
+	gStats.numLiveBuffers--;
+	gStats.liveBufferBytes -= pBuf->vertexCapacityBytes + pBuf->indexCapacityBytes;
+}
+
+static void RecordUpload(size_t* pCapacity, size_t bytes)
+{
+	if (bytes > *pCapacity)
+	{
+		gStats.liveBufferBytes += bytes - *pCapacity;
+		*pCapacity = bytes;
+	}
+	gThisFrame.bytesUploaded += bytes;
+}
+
+static HUIVertexBuffer NewUIVertexBuffer(int size)
+{
+	return NewBuffer();
+}
+
+static void UIVertexBufferData(HUIVertexBuffer hBuf, WidgetVertex* src, size_t size)
+{
+	RecordUpload(&gBuffers[hBuf].vertexCapacityBytes, size * sizeof(WidgetVertex));
+}
+
+static void DrawUIVertexBuffer(HUIVertexBuffer hBuf, size_t vertexCount)
+{
+	gThisFrame.drawCalls++;
+	gThisFrame.verticesDrawn += vertexCount;
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, vertexCount);
+}
+
+static void SetCurrentAtlas(hTexture atlas)
+{
+}
+
+static hTexture UploadTexture(void* src, int channels, int pxWidth, int pxHeight)
+{
+	gThisFrame.bytesUploaded += (u64)channels * pxWidth * pxHeight;
+	return ++gStats.numTexturesUploaded;
+}
+
+static void DestroyTexture(hTexture tex)
+{
+}
+
+static void UpdateTextureRegion(hTexture tex, const void* src, int channels, int x, int y, int pxWidth, int pxHeight)
+{
+	gThisFrame.bytesUploaded += (u64)channels * pxWidth * pxHeight;
+}
+
+/* stands in for the mapped GL buffer, only one is mapped at a time */
+static void* gpMappedTexture = NULL;
+static u64 gMappedTextureBytes = 0;
+
+static void* MapTextureUploadBuffer(int channels, int pxWidth, int pxHeight)
+{
+	EASSERT(!gpMappedTexture);
+	gMappedTextureBytes = (u64)channels * pxWidth * pxHeight;
+	gpMappedTexture = malloc(gMappedTextureBytes);
+	return gpMappedTexture;
+}
+
+static hTexture UploadMappedTexture()
+{
+	EASSERT(gpMappedTexture);
+	free(gpMappedTexture);
+	gpMappedTexture = NULL;
+	gThisFrame.bytesUploaded += gMappedTextureBytes;
+	return ++gStats.numTexturesUploaded;
+}
+
+static H2DWorldspaceVertexBuffer NewWorldspaceVertexBuffer(int size)
+{
+	return NewBuffer();
+}
+
+static void WorldspaceVertexBufferData(H2DWorldspaceVertexBuffer hBuf, Worldspace2DVert* src, size_t size, VertIndexT* indices, u32 numIndices)
+{
+	RecordUpload(&gBuffers[hBuf].vertexCapacityBytes, size * sizeof(Worldspace2DVert));
+	RecordUpload(&gBuffers[hBuf].indexCapacityBytes, numIndices * sizeof(VertIndexT));
+}
+
+static void DrawWorldspaceVertexBuffer(H2DWorldspaceVertexBuffer hBuf, size_t indexCount, mat4 view)
+{
+	gThisFrame.drawCalls++;
+	gThisFrame.verticesDrawn += indexCount;
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, indexCount);
+}
+
+static hTexture NewTileIndexTexture(const TileIndex* tiles, int widthTiles, int heightTiles)
+{
+	gThisFrame.bytesUploaded += (u64)widthTiles * heightTiles * sizeof(TileIndex);
+	return ++gStats.numTexturesUploaded;
+}
+
+static void TileIndexTextureSetTile(hTexture tex, int col, int row, TileIndex tile)
+{
+	gThisFrame.bytesUploaded += sizeof(TileIndex);
+}
+
+static HTilemapUVTable NewTilemapUVTable(const float* uvs, int numTiles)
+{
+	EASSERT(numTiles <= TILEMAP_UV_TABLE_MAX_TILES);
+	HTilemapUVTable hTable = NewBuffer();
+	/* GL allocates the whole uniform block */
+	gBuffers[hTable].vertexCapacityBytes = TILEMAP_UV_TABLE_MAX_TILES * 4 * sizeof(float);
+	gStats.liveBufferBytes += gBuffers[hTable].vertexCapacityBytes;
+	gThisFrame.bytesUploaded += numTiles * 4 * sizeof(float);
+	return hTable;
+}
+
+static void DrawTilemapChunk(hTexture tileIndices, HTilemapUVTable hTable, int startCol, int startRow, int numCols, int numRows, vec2 tileSizePx, vec2 origin, mat4 view)
+{
+	u32 numVerts = numCols * numRows * 6;
+	gThisFrame.drawCalls++;
+	gThisFrame.verticesDrawn += numVerts;
+	PROFILE_COUNTER_ADD(PC_DrawCalls, 1);
+	PROFILE_COUNTER_ADD(PC_VerticesDrawn, numVerts);
+}
+
+DrawContext Dr_InitNullDrawContext()
+{
+	DrawContext d;
+	memset(&d, 0, sizeof(DrawContext));
+	d.DestroyVertexBuffer = &DestroyBuffer;
+	d.DrawUIVertexBuffer = &DrawUIVertexBuffer;
+	d.NewUIVertexBuffer = &NewUIVertexBuffer;
+	d.UIVertexBufferData = &UIVertexBufferData;
+
+	d.SetCurrentAtlas = &SetCurrentAtlas;
+	d.UploadTexture = &UploadTexture;
+	d.DestroyTexture = &DestroyTexture;
+	d.MapTextureUploadBuffer = &MapTextureUploadBuffer;
+	d.UploadMappedTexture = &UploadMappedTexture;
+	d.UpdateTextureRegion = &UpdateTextureRegion;
+
+	d.NewWorldspaceVertBuffer = &NewWorldspaceVertexBuffer;
+	d.WorldspaceVertexBufferData = &WorldspaceVertexBufferData;
+	d.DrawWorldspaceVertexBuffer = &DrawWorldspaceVertexBuffer;
+	d.DestroyWorldspaceVertexBuffer = &DestroyBuffer;
+
+	d.NewTileIndexTexture = &NewTileIndexTexture;
+	d.TileIndexTextureSetTile = &TileIndexTextureSetTile;
+	d.NewTilemapUVTable = &NewTilemapUVTable;
+	d.DestroyTilemapUVTable = &DestroyBuffer;
+	d.DrawTilemapChunk = &DrawTilemapChunk;
+
+	gBuffers = NEW_VECTOR(struct NullBuffer);
+	memset(&gThisFrame, 0, sizeof(struct NullDrawCounters));
+	memset(&gStats, 0, sizeof(struct NullDrawStats));
+	return d;
+}
+
+void Dr_DestroyNullDrawContext()
+{
+	DestoryVector(gBuffers);
+	gBuffers = NULL;
+}
+
+void Dr_NullDrawContextEndFrame()
+{
+	gStats.lastFrame = gThisFrame;
+	gStats.total.drawCalls += gThisFrame.drawCalls;
+	gStats.total.verticesDrawn += gThisFrame.verticesDrawn;
+	gStats.total.bytesUploaded += gThisFrame.bytesUploaded;
+	memset(&gThisFrame, 0, sizeof(struct NullDrawCounters));
+}
+
+struct NullDrawStats Dr_GetNullDrawStats()
+{
+	return gStats;
+}
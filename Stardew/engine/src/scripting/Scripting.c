@@ -11,6 +11,7 @@
 #include "AssertLib.h"
 #include "GameFrameworkEvent.h"
 #include "DataNode.h"
+#include "Profiler.h"
 
 #define GAME_LUA_MINOR_VERSION 1
 
@@ -198,6 +199,61 @@ static int L_OnPropertyChanged(lua_State* L)
 	return 0;
 }
 
+#ifdef STARDEW_PROFILER
+
+static int L_GetProfilerZones(lua_State* L)
+{
+	// returns: array of { name, depth, ms, avgMs, maxMs, calls } in the order the zones were first seen
+	int numZones = 0;
+	const struct ProfileZoneStats* pZones = Prof_GetZoneStats(&numZones);
+	lua_createtable(L, numZones, 0);
+	for (int i = 0; i < numZones; i++)
+	{
+		lua_createtable(L, 0, 6);
+		lua_pushstring(L, pZones[i].name);
+		lua_setfield(L, -2, "name");
+		lua_pushinteger(L, pZones[i].depth);
+		lua_setfield(L, -2, "depth");
+		lua_pushnumber(L, pZones[i].lastFrameMs);
+		lua_setfield(L, -2, "ms");
+		lua_pushnumber(L, pZones[i].avgMs);
+		lua_setfield(L, -2, "avgMs");
+		lua_pushnumber(L, pZones[i].maxMs);
+		lua_setfield(L, -2, "maxMs");
+		lua_pushinteger(L, pZones[i].lastFrameCalls);
+		lua_setfield(L, -2, "calls");
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+static int L_GetProfilerFrameStats(lua_State* L)
+{
+	// returns: { frame, frameMs, <counter name> = value ... } for the last frame
+	struct ProfileFrameStats stats = Prof_GetLastFrameStats();
+	lua_createtable(L, 0, 2 + PC_NumCounters);
+	lua_pushinteger(L, (lua_Integer)stats.frameIndex);
+	lua_setfield(L, -2, "frame");
+	lua_pushnumber(L, stats.frameMs);
+	lua_setfield(L, -2, "frameMs");
+	for (int i = 0; i < PC_NumCounters; i++)
+	{
+		lua_pushinteger(L, stats.counters[i]);
+		lua_setfield(L, -2, Prof_GetCounterName(i));
+	}
+	return 1;
+}
+
+static int L_ExportProfilerTrace(lua_State* L)
+{
+	// args: (optional string) path
+	const char* path = lua_isstring(L, 1) ? lua_tostring(L, 1) : PROFILER_TRACE_PATH;
+	lua_pushboolean(L, Prof_ExportChromeTrace(path));
+	return 1;
+}
+
+#endif
+
 void Sc_RegisterCFunction(const char* name, int(*fn)(lua_State*))
 {
 	lua_pushcfunction(gL, fn);
@@ -214,6 +270,12 @@ void Sc_InitScripting()
 	Sc_RegisterCFunction("SubscribeGameFrameworkEvent", &L_SubscribeToGameFrameworkEvent);
 	Sc_RegisterCFunction("UnsubscribeGameFrameworkEvent", &L_UnSubscribeToGameFrameworkEvent);
 	Sc_RegisterCFunction("FireGameFrameworkEvent", &L_FireGameFrameworkEvent);
+#ifdef STARDEW_PROFILER
+	/* not registered when the profiler is compiled out, scripts should check they exist */
+	Sc_RegisterCFunction("GetProfilerZones", &L_GetProfilerZones);
+	Sc_RegisterCFunction("GetProfilerFrameStats", &L_GetProfilerFrameStats);
+	Sc_RegisterCFunction("ExportProfilerTrace", &L_ExportProfilerTrace);
+#endif
 }
 
 void Sc_DeInitScripting()
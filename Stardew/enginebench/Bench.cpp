@@ -0,0 +1,251 @@
+#include "Bench.h"
+#include "StringKeyHashMap.h"
+extern "C" {
+#include "FileHelpers.h"
+}
+#include "cJSON.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+std::vector<BenchRegistration>& Bench_GetRegisteredBenchmarks()
+{
+    static std::vector<BenchRegistration> sBenchmarks;
+    return sBenchmarks;
+}
+
+BenchRegistrar::BenchRegistrar(const char* name, BenchFn fn)
+{
+    Bench_GetRegisteredBenchmarks().push_back({ name, fn });
+}
+
+/* nearest rank */
+static double Percentile(const std::vector<double>& sorted, double percent)
+{
+    size_t rank = (size_t)std::ceil(percent / 100.0 * (double)sorted.size());
+    rank = rank < 1 ? 1 : rank;
+    return sorted[rank - 1];
+}
+
+static void ComputeStats(BenchResult& result)
+{
+    if (result.samplesNs.empty())
+    {
+        return;
+    }
+    std::vector<double> sorted = result.samplesNs;
+    std::sort(sorted.begin(), sorted.end());
+    result.minNs = sorted.front();
+    result.medianNs = Percentile(sorted, 50.0);
+    result.p99Ns = Percentile(sorted, 99.0);
+    double total = 0.0;
+    for (double sample : sorted)
+    {
+        total += sample;
+    }
+    result.meanNs = total / (double)sorted.size();
+}
+
+/* at the median time, MB being 10^6 bytes */
+static double MBPerSec(const BenchResult& result)
+{
+    return result.medianNs > 0.0 ? (double)result.bytesPerIteration * 1000.0 / result.medianNs : 0.0;
+}
+
+static bool WriteResultsJSON(const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+    cJSON* pRoot = cJSON_CreateObject();
+    cJSON_AddNumberToObject(pRoot, "seed", options.seed);
+    cJSON_AddNumberToObject(pRoot, "iterations", options.numIterations);
+    cJSON_AddNumberToObject(pRoot, "warmupIterations", options.numWarmupIterations);
+    cJSON* pBenchmarks = cJSON_AddArrayToObject(pRoot, "benchmarks");
+    for (const BenchResult& result : results)
+    {
+        cJSON* pBench = cJSON_CreateObject();
+        cJSON_AddStringToObject(pBench, "name", result.name.c_str());
+        if (result.bSkipped)
+        {
+            cJSON_AddStringToObject(pBench, "skipped", result.skipReason.c_str());
+        }
+        else
+        {
+            cJSON_AddNumberToObject(pBench, "itemsPerIteration", (double)result.itemsPerIteration);
+            cJSON_AddNumberToObject(pBench, "numSamples", (double)result.samplesNs.size());
+            cJSON_AddNumberToObject(pBench, "minNs", result.minNs);
+            cJSON_AddNumberToObject(pBench, "medianNs", result.medianNs);
+            cJSON_AddNumberToObject(pBench, "p99Ns", result.p99Ns);
+            cJSON_AddNumberToObject(pBench, "meanNs", result.meanNs);
+            if (result.bytes)
+            {
+                cJSON_AddNumberToObject(pBench, "bytes", (double)result.bytes);
+            }
+            if (result.bytesPerIteration)
+            {
+                cJSON_AddNumberToObject(pBench, "bytesPerIteration", (double)result.bytesPerIteration);
+                cJSON_AddNumberToObject(pBench, "medianMBPerSec", MBPerSec(result));
+            }
+            /* each timed iteration in the order they ran, for plotting or other statistics */
+            cJSON_AddItemToObject(pBench, "samplesNs", cJSON_CreateDoubleArray(result.samplesNs.data(), (int)result.samplesNs.size()));
+        }
+        cJSON_AddItemToArray(pBenchmarks, pBench);
+    }
+
+    char* pText = cJSON_Print(pRoot);
+    cJSON_Delete(pRoot);
+    FILE* pFile = fopen(options.outPath.c_str(), "w");
+    if (!pFile)
+    {
+        printf("can't open %s for writing\n", options.outPath.c_str());
+        free(pText);
+        return false;
+    }
+    fputs(pText, pFile);
+    fputc('\n', pFile);
+    fclose(pFile);
+    free(pText);
+    return true;
+}
+
+/* benchmark name -> median ns */
+static bool LoadBaseline(const char* path, std::map<std::string, double>& outBaseline)
+{
+    int size = 0;
+    char* pText = LoadFile(path, &size);
+    if (!pText)
+    {
+        printf("can't load baseline %s\n", path);
+        return false;
+    }
+    cJSON* pRoot = cJSON_ParseWithLength(pText, size);
+    free(pText);
+    if (!pRoot)
+    {
+        printf("can't parse baseline %s\n", path);
+        return false;
+    }
+    cJSON* pBenchmarks = cJSON_GetObjectItemCaseSensitive(pRoot, "benchmarks");
+    cJSON* pBench = NULL;
+    cJSON_ArrayForEach(pBench, pBenchmarks)
+    {
+        cJSON* pName = cJSON_GetObjectItemCaseSensitive(pBench, "name");
+        cJSON* pMedian = cJSON_GetObjectItemCaseSensitive(pBench, "medianNs");
+        if (!cJSON_IsString(pName) || !cJSON_IsNumber(pMedian))
+        {
+            /* skipped when the baseline was recorded */
+            continue;
+        }
+        outBaseline[pName->valuestring] = pMedian->valuedouble;
+    }
+    cJSON_Delete(pRoot);
+    return true;
+}
+
+/* returns the number of benchmarks whose median got slower than the baseline by more than the threshold */
+static int CompareWithBaseline(const BenchOptions& options, const std::vector<BenchResult>& results, const std::map<std::string, double>& baseline)
+{
+    int numRegressions = 0;
+    printf("\ncomparison with %s (median, regression threshold %.0f%%)\n", options.comparePath.c_str(), options.regressionThreshold * 100.0);
+    printf("%-36s %14s %14s %8s\n", "benchmark", "baseline ns", "current ns", "ratio");
+    for (const BenchResult& result : results)
+    {
+        if (result.bSkipped)
+        {
+            continue;
+        }
+        auto itr = baseline.find(result.name);
+        if (itr == baseline.end())
+        {
+            printf("%-36s %14s %14.0f %8s\n", result.name.c_str(), "-", result.medianNs, "new");
+            continue;
+        }
+        double ratio = itr->second > 0.0 ? result.medianNs / itr->second : 1.0;
+        const char* verdict = "";
+        if (ratio > 1.0 + options.regressionThreshold)
+        {
+            verdict = "  REGRESSED";
+            numRegressions++;
+        }
+        else if (ratio < 1.0 - options.regressionThreshold)
+        {
+            verdict = "  improved";
+        }
+        printf("%-36s %14.0f %14.0f %8.3f%s\n", result.name.c_str(), itr->second, result.medianNs, ratio, verdict);
+    }
+    return numRegressions;
+}
+
+int Bench_RunAll(const BenchOptions& options)
+{
+    std::vector<BenchRegistration> benchmarks = Bench_GetRegisteredBenchmarks();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](const BenchRegistration& a, const BenchRegistration& b) { return strcmp(a.name, b.name) < 0; });
+
+    std::vector<BenchResult> results;
+    for (const BenchRegistration& bench : benchmarks)
+    {
+        if (!options.filter.empty() && !strstr(bench.name, options.filter.c_str()))
+        {
+            continue;
+        }
+        BenchResult result;
+        result.name = bench.name;
+        BenchState state(&result, options.seed ^ HashmapHashKey(bench.name), options.numIterations, options.numWarmupIterations);
+        bench.fn(state);
+        ComputeStats(result);
+        results.push_back(result);
+    }
+
+    printf("\n%-36s %10s %14s %14s %14s %12s %10s %10s\n", "benchmark", "items", "min ns", "median ns", "p99 ns", "ns/item", "bytes", "MB/s");
+    for (const BenchResult& result : results)
+    {
+        if (result.bSkipped)
+        {
+            printf("%-36s skipped: %s\n", result.name.c_str(), result.skipReason.c_str());
+            continue;
+        }
+        printf("%-36s %10llu %14.0f %14.0f %14.0f %12.2f",
+            result.name.c_str(),
+            (unsigned long long)result.itemsPerIteration,
+            result.minNs,
+            result.medianNs,
+            result.p99Ns,
+            result.medianNs / (double)result.itemsPerIteration);
+        if (result.bytes)
+        {
+            printf(" %10llu", (unsigned long long)result.bytes);
+        }
+        else if (result.bytesPerIteration)
+        {
+            printf(" %10s", "");
+        }
+        if (result.bytesPerIteration)
+        {
+            printf(" %10.1f", MBPerSec(result));
+        }
+        printf("\n");
+    }
+
+    if (!WriteResultsJSON(options, results))
+    {
+        return 1;
+    }
+    printf("\nresults written to %s\n", options.outPath.c_str());
+
+    if (!options.comparePath.empty())
+    {
+        std::map<std::string, double> baseline;
+        if (!LoadBaseline(options.comparePath.c_str(), baseline))
+        {
+            return 1;
+        }
+        int numRegressions = CompareWithBaseline(options, results, baseline);
+        if (numRegressions)
+        {
+            printf("\n%i benchmark(s) regressed\n", numRegressions);
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#ifndef ENGINE_BENCH_H
+#define ENGINE_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+    Minimal microbenchmark harness for StardewEngineBench.
+
+    Each benchmark is a function registered with ENGINE_BENCH. It builds whatever it needs, then calls
+    state.Measure once with the code to time. Every benchmark gets its own random number generator seeded from
+    the run seed and its name, so results are repeatable, and don't change when other benchmarks are filtered out.
+*/
+
+struct BenchResult
+{
+    std::string name;
+    /* how many things one timed call processes - lets results be read as ns per item */
+    uint64_t itemsPerIteration = 1;
+    /* size of the data made by the benchmark when that's a result too, like a compressed size. 0 for none */
+    uint64_t bytes = 0;
+    /* how many bytes one timed call processes, for a MB/s throughput. 0 for none */
+    uint64_t bytesPerIteration = 0;
+    std::vector<double> samplesNs;
+    double minNs = 0.0;
+    double medianNs = 0.0;
+    double p99Ns = 0.0;
+    double meanNs = 0.0;
+    bool bSkipped = false;
+    std::string skipReason;
+};
+
+class BenchState
+{
+public:
+    BenchState(BenchResult* pResult, uint32_t seed, int numIterations, int numWarmupIterations)
+        : pResult(pResult), rng(seed), numIterations(numIterations), numWarmupIterations(numWarmupIterations)
+    {
+    }
+
+    /* mt19937's output sequence is fixed by the standard, unlike the std distributions, so these are the same everywhere */
+    uint32_t RandU32() { return (uint32_t)rng(); }
+    /* [minInclusive, maxExclusive) */
+    int RandInt(int minInclusive, int maxExclusive) { return minInclusive + (int)(RandU32() % (uint32_t)(maxExclusive - minInclusive)); }
+    float RandFloat(float min, float max) { return min + (max - min) * ((float)(RandU32() >> 8) / (float)(1u << 24)); }
+
+    template<typename T>
+    void Shuffle(T* pData, size_t size)
+    {
+        for (size_t i = size; i > 1; i--)
+        {
+            size_t j = RandU32() % i;
+            T tmp = pData[i - 1];
+            pData[i - 1] = pData[j];
+            pData[j] = tmp;
+        }
+    }
+
+    void SetItemsPerIteration(uint64_t items) { pResult->itemsPerIteration = items; }
+    void SetBytes(uint64_t bytes) { pResult->bytes = bytes; }
+    void SetBytesPerIteration(uint64_t bytes) { pResult->bytesPerIteration = bytes; }
+
+    /* call instead of Measure if the benchmark can't run, for example if assets are missing */
+    void Skip(const std::string& reason)
+    {
+        pResult->bSkipped = true;
+        pResult->skipReason = reason;
+    }
+
+    /*
+        Calls fn numWarmupIterations times untimed, then numIterations times timing each call.
+        setup is called before every call to fn and isn't timed, use it to reset state fn changes
+    */
+    template<typename SetupFn, typename Fn>
+    void Measure(SetupFn setup, Fn fn)
+    {
+        for (int i = 0; i < numWarmupIterations; i++)
+        {
+            setup();
+            fn();
+        }
+        pResult->samplesNs.reserve(numIterations);
+        for (int i = 0; i < numIterations; i++)
+        {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto end = std::chrono::steady_clock::now();
+            pResult->samplesNs.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+    }
+
+    template<typename Fn>
+    void Measure(Fn fn)
+    {
+        Measure([]() {}, fn);
+    }
+
+private:
+    BenchResult* pResult;
+    std::mt19937 rng;
+    int numIterations;
+    int numWarmupIterations;
+};
+
+inline volatile char gBenchResultSink;
+
+/* stops the compiler optimising away a result that's otherwise unused */
+template<typename T>
+inline void Bench_KeepResult(const T& val)
+{
+    const volatile char* p = (const volatile char*)&val;
+    for (size_t i = 0; i < sizeof(T); i++)
+    {
+        gBenchResultSink = p[i];
+    }
+}
+
+typedef void (*BenchFn)(BenchState& state);
+
+struct BenchRegistrar
+{
+    BenchRegistrar(const char* name, BenchFn fn);
+};
+
+#define ENGINE_BENCH(benchName) \
+    static void benchName(BenchState& state); \
+    static BenchRegistrar benchName##_registrar(#benchName, &benchName); \
+    static void benchName(BenchState& state)
+
+struct BenchRegistration
+{
+    const char* name;
+    BenchFn fn;
+};
+
+std::vector<BenchRegistration>& Bench_GetRegisteredBenchmarks();
+
+struct BenchOptions
+{
+    /* only run benchmarks whose name contains this */
+    std::string filter;
+    uint32_t seed = 1234;
+    int numIterations = 100;
+    int numWarmupIterations = 5;
+    std::string outPath = "StardewEngineBench.json";
+    /* results of a previous run to compare against, empty for none */
+    std::string comparePath;
+    /* a median more than this fraction slower than the baseline counts as a regression */
+    double regressionThreshold = 0.1;
+};
+
+/* returns the process exit code: 0 success, 1 error, 2 if compared against a baseline and something regressed */
+int Bench_RunAll(const BenchOptions& options);
+
+#endif
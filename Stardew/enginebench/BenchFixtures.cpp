@@ -0,0 +1,160 @@
+#include "BenchFixtures.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <libxml/parser.h>
+#include "Widget.h"
+#include "NullDrawContext.h"
+#include "Game2DLayerIncludes.h"
+extern "C" {
+#include "Atlas.h"
+#include "ImageFileRegstry.h"
+}
+
+#define BENCH_IMAGE_REGISTRY_PATH "./Assets/ImageFiles.json"
+#define BENCH_IMAGE_PATH "./Assets/Image/example.png"
+#define BENCH_FONT_PATH "./Assets/ComicMono.ttf"
+
+static bool gbEngineInitialised = false;
+static DrawContext gDrawContext;
+
+static bool gbAtlasAttempted = false;
+static hAtlas gAtlas = NULL_HANDLE;
+static std::string gAtlasError;
+
+static bool gbImageRegistryInitialised = false;
+static std::map<std::string, hAtlas> gXMLAtlases;
+
+static bool FileExists(const char* path)
+{
+    FILE* pFile = fopen(path, "rb");
+    if (!pFile)
+    {
+        return false;
+    }
+    fclose(pFile);
+    return true;
+}
+
+void BenchFixture_InitEngine()
+{
+    if (gbEngineInitialised)
+    {
+        return;
+    }
+    gbEngineInitialised = true;
+    gDrawContext = Dr_InitNullDrawContext();
+    InitEntity2DQuadtreeSystem();
+    UI_Init();
+    At_Init();
+}
+
+DrawContext* BenchFixture_GetDrawContext()
+{
+    BenchFixture_InitEngine();
+    return &gDrawContext;
+}
+
+bool BenchFixture_InitImageRegistry()
+{
+    if (!FileExists(BENCH_IMAGE_REGISTRY_PATH))
+    {
+        return false;
+    }
+    if (!gbImageRegistryInitialised)
+    {
+        gbImageRegistryInitialised = true;
+        IR_InitImageRegistry(NULL);
+    }
+    return true;
+}
+
+hAtlas BenchFixture_GetAtlas(std::string& outError)
+{
+    if (gbAtlasAttempted)
+    {
+        outError = gAtlasError;
+        return gAtlas;
+    }
+    gbAtlasAttempted = true;
+    BenchFixture_InitEngine();
+
+    const char* requiredFiles[] = { BENCH_IMAGE_REGISTRY_PATH, BENCH_IMAGE_PATH, BENCH_FONT_PATH };
+    for (const char* path : requiredFiles)
+    {
+        if (!FileExists(path))
+        {
+            gAtlasError = std::string("can't find ") + path + ", run from the Stardew folder";
+            outError = gAtlasError;
+            return NULL_HANDLE;
+        }
+    }
+
+    BenchFixture_InitImageRegistry();
+
+    At_BeginAtlas();
+    /* tilemap index n maps to the sprite added n-1th */
+    At_BeginTileset(0);
+    for (int i = 0; i < BENCH_TILESET_SIZE; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "bench_tile_%i", i);
+        At_AddSprite(BENCH_IMAGE_PATH, (i % 2) * BENCH_TILE_SIZE_PX, (i / 2) * BENCH_TILE_SIZE_PX, BENCH_TILE_SIZE_PX, BENCH_TILE_SIZE_PX, name);
+    }
+    At_EndTileset(BENCH_TILESET_SIZE);
+    At_AddSprite(BENCH_IMAGE_PATH, 0, 0, 32, 32, BENCH_WIDGET_SPRITE_NAME);
+
+    struct FontAtlasAdditionSpec fontSpec;
+    memset(&fontSpec, 0, sizeof(struct FontAtlasAdditionSpec));
+    fontSpec.fontOptions = FontAtlasAdditionSpec::FS_Normal;
+    strcpy(fontSpec.name, BENCH_FONT_NAME);
+    strcpy(fontSpec.path, BENCH_FONT_PATH);
+    fontSpec.fontSizes[0].type = FontSize::FOS_Pts;
+    fontSpec.fontSizes[0].val = BENCH_FONT_SIZE_PTS;
+    fontSpec.numFontSizes = 1;
+    At_AddFont(&fontSpec);
+
+    gAtlas = At_EndAtlas(&gDrawContext);
+    if (gAtlas == NULL_HANDLE)
+    {
+        gAtlasError = "At_EndAtlas failed";
+        outError = gAtlasError;
+    }
+    return gAtlas;
+}
+
+hAtlas BenchFixture_GetXMLAtlas(const char* xmlPath, std::string& outError)
+{
+    auto itr = gXMLAtlases.find(xmlPath);
+    if (itr != gXMLAtlases.end())
+    {
+        return itr->second;
+    }
+    BenchFixture_InitEngine();
+    if (!FileExists(xmlPath) || !FileExists(BENCH_IMAGE_REGISTRY_PATH))
+    {
+        outError = std::string("can't find ") + xmlPath + ", run from the Stardew folder";
+        return NULL_HANDLE;
+    }
+    BenchFixture_InitImageRegistry();
+    xmlDoc* pDoc = xmlReadFile(xmlPath, NULL, 0);
+    if (!pDoc)
+    {
+        outError = std::string("can't parse ") + xmlPath;
+        return NULL_HANDLE;
+    }
+    /* AtlasTool's defaults */
+    struct EndAtlasOptions options;
+    memset(&options, 0, sizeof(struct EndAtlasOptions));
+    options.initialAtlasWidth = 512;
+    options.initialAtlasHeight = 512;
+    hAtlas atlas = At_LoadAtlasEx(xmlDocGetRootElement(pDoc), &gDrawContext, &options);
+    xmlFreeDoc(pDoc);
+    if (atlas == NULL_HANDLE)
+    {
+        outError = std::string("can't build an atlas from ") + xmlPath;
+        return NULL_HANDLE;
+    }
+    gXMLAtlases[xmlPath] = atlas;
+    return atlas;
+}
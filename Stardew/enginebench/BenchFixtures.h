@@ -0,0 +1,41 @@
+#ifndef ENGINE_BENCH_FIXTURES_H
+#define ENGINE_BENCH_FIXTURES_H
+
+#include <string>
+#include "HandleDefs.h"
+
+/*
+    Engine state shared between benchmarks, created the first time a benchmark asks for it.
+    Everything uses a null DrawContext so no window or GL context is needed.
+*/
+
+#define BENCH_TILESET_SIZE 4
+#define BENCH_TILE_SIZE_PX 16
+#define BENCH_WIDGET_SPRITE_NAME "bench_widget"
+#define BENCH_FONT_NAME "bench"
+#define BENCH_FONT_SIZE_PTS 16.0f
+
+struct DrawContext;
+
+/* UI, quadtree and atlas systems, and the null draw context */
+void BenchFixture_InitEngine();
+
+struct DrawContext* BenchFixture_GetDrawContext();
+
+/* ./Assets/ImageFiles.json, false if it can't be found */
+bool BenchFixture_InitImageRegistry();
+
+/*
+    An atlas with a BENCH_TILESET_SIZE tile tileset, a sprite for widgets and a font.
+    Built from files in ./Assets so the working directory needs to be the Stardew folder like the game's.
+    Returns NULL_HANDLE and sets outError if the assets can't be loaded.
+*/
+hAtlas BenchFixture_GetAtlas(std::string& outError);
+
+/*
+    An atlas built from one of the game's atlas xml files, the same way AtlasTool builds them. Cached by path.
+    Returns NULL_HANDLE and sets outError if it can't be loaded.
+*/
+hAtlas BenchFixture_GetXMLAtlas(const char* xmlPath, std::string& outError);
+
+#endif
@@ -0,0 +1,501 @@
+#include "Bench.h"
+#include "BenchFixtures.h"
+#include "StringKeyHashMap.h"
+#include "DynArray.h"
+#include "BinarySerializer.h"
+#include "Game2DLayer.h"
+#include "cJSON.h"
+extern "C" {
+#include "FileHelpers.h"
+#include "Atlas.h"
+#include "ImageFileRegstry.h"
+}
+#include <filesystem>
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define NUM_HASHMAP_KEYS 10000
+#define NUM_SERIALIZED_RECORDS 10000
+/* a 256x256 tile layer */
+#define NUM_SERIALIZED_TILES (256 * 256)
+
+static void InitBenchHashmap(BenchState& state, struct HashMap* pMap, std::vector<std::string>& outKeys)
+{
+    HashmapInit(pMap, 16, sizeof(int));
+    for (int i = 0; i < NUM_HASHMAP_KEYS; i++)
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "bench_key_%u_%i", state.RandU32() % 100000, i);
+        outKeys.push_back(key);
+        HashmapInsert(pMap, key, &i);
+    }
+}
+
+ENGINE_BENCH(HashmapSearchHit)
+{
+    struct HashMap map;
+    std::vector<std::string> keys;
+    InitBenchHashmap(state, &map, keys);
+    state.Shuffle(keys.data(), keys.size());
+
+    state.SetItemsPerIteration(keys.size());
+    state.Measure([&]()
+    {
+        int total = 0;
+        for (const std::string& key : keys)
+        {
+            total += *(int*)HashmapSearch(&map, key.c_str());
+        }
+        Bench_KeepResult(total);
+    });
+    HashmapDeInit(&map);
+}
+
+ENGINE_BENCH(HashmapSearchMiss)
+{
+    struct HashMap map;
+    std::vector<std::string> keys;
+    InitBenchHashmap(state, &map, keys);
+    std::vector<std::string> missingKeys;
+    for (int i = 0; i < NUM_HASHMAP_KEYS; i++)
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "missing_key_%u_%i", state.RandU32() % 100000, i);
+        missingKeys.push_back(key);
+    }
+
+    state.SetItemsPerIteration(missingKeys.size());
+    state.Measure([&]()
+    {
+        int numFound = 0;
+        for (const std::string& key : missingKeys)
+        {
+            numFound += HashmapSearch(&map, key.c_str()) != NULL;
+        }
+        Bench_KeepResult(numFound);
+    });
+    HashmapDeInit(&map);
+}
+
+/* roughly the shape of what entities write when a level is saved */
+struct BenchRecord
+{
+    u32 type;
+    float x, y;
+    i32 layer;
+    bool bFlag;
+    char name[32];
+};
+
+static std::vector<BenchRecord> MakeBenchRecords(BenchState& state)
+{
+    std::vector<BenchRecord> records(NUM_SERIALIZED_RECORDS);
+    for (BenchRecord& record : records)
+    {
+        record.type = state.RandU32() % 16;
+        record.x = state.RandFloat(0.0f, 4096.0f);
+        record.y = state.RandFloat(0.0f, 4096.0f);
+        record.layer = state.RandInt(0, 8);
+        record.bFlag = state.RandU32() & 1;
+        snprintf(record.name, sizeof(record.name), "entity_%u", state.RandU32() % 100000);
+    }
+    return records;
+}
+
+static void SerializeBenchRecords(const std::vector<BenchRecord>& records, struct BinarySerializer* pBS)
+{
+    BS_SerializeU32((u32)records.size(), pBS);
+    for (const BenchRecord& record : records)
+    {
+        BS_SerializeU32(record.type, pBS);
+        BS_SerializeFloat(record.x, pBS);
+        BS_SerializeFloat(record.y, pBS);
+        BS_SerializeI32(record.layer, pBS);
+        BS_SerializeBool(record.bFlag, pBS);
+        BS_SerializeString(record.name, pBS);
+    }
+}
+
+ENGINE_BENCH(BinarySerializerSerialize)
+{
+    std::vector<BenchRecord> records = MakeBenchRecords(state);
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+
+    state.SetItemsPerIteration(records.size());
+    state.Measure(
+        [&]()
+        {
+            BS_Finish(&bs);
+            BS_CreateForSaveToMemory(&bs);
+        },
+        [&]()
+        {
+            SerializeBenchRecords(records, &bs);
+        });
+    BS_Finish(&bs);
+}
+
+ENGINE_BENCH(BinarySerializerDeserialize)
+{
+    std::vector<BenchRecord> records = MakeBenchRecords(state);
+    struct BinarySerializer saveBS;
+    BS_CreateForSaveToMemory(&saveBS);
+    SerializeBenchRecords(records, &saveBS);
+    size_t savedSize = 0;
+    const char* pSaved = BS_GetSavedData(&saveBS, &savedSize);
+
+    struct BinarySerializer loadBS;
+
+    std::vector<BenchRecord> loaded(records.size());
+    state.SetItemsPerIteration(records.size());
+    state.Measure(
+        [&]()
+        {
+            BS_CreateForLoadFromMemory(pSaved, savedSize, &loadBS);
+        },
+        [&]()
+        {
+            u32 numRecords = 0;
+            BS_DeSerializeU32(&numRecords, &loadBS);
+            for (u32 i = 0; i < numRecords; i++)
+            {
+                BenchRecord& record = loaded[i];
+                BS_DeSerializeU32(&record.type, &loadBS);
+                BS_DeSerializeFloat(&record.x, &loadBS);
+                BS_DeSerializeFloat(&record.y, &loadBS);
+                BS_DeSerializeI32(&record.layer, &loadBS);
+                BS_DeSerializeBool(&record.bFlag, &loadBS);
+                BS_DeSerializeStringInto(record.name, &loadBS);
+            }
+        });
+    Bench_KeepResult(loaded.back().x);
+    BS_Finish(&saveBS);
+}
+
+ENGINE_BENCH(BinarySerializerTileLayer)
+{
+    std::vector<TileIndex> tiles(NUM_SERIALIZED_TILES);
+    for (TileIndex& tile : tiles)
+    {
+        tile = (TileIndex)state.RandInt(0, 1024);
+    }
+    std::vector<TileIndex> loaded(tiles.size());
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+
+    state.SetItemsPerIteration(tiles.size());
+    state.Measure(
+        [&]()
+        {
+            BS_Finish(&bs);
+            BS_CreateForSaveToMemory(&bs);
+        },
+        [&]()
+        {
+            BS_SerializeU16Array(tiles.data(), tiles.size(), &bs);
+            size_t savedSize = 0;
+            const char* pSaved = BS_GetSavedData(&bs, &savedSize);
+            struct BinarySerializer loadBS;
+            BS_CreateForLoadFromMemory(pSaved, savedSize, &loadBS);
+            BS_DeSerializeU16Array(loaded.data(), loaded.size(), &loadBS);
+            BS_Finish(&loadBS);
+        });
+    Bench_KeepResult(loaded.back());
+    BS_Finish(&bs);
+}
+
+/*
+    The tile layers of a map made with Tiled, from its json file in ./Assets. Tile ids are renumbered from 1 in the
+    order they're first used, close to what engine/scripts/ConvertTiled.py does, without needing the whole tileset setup
+*/
+static bool LoadBenchTiledMap(const char* path, std::vector<struct TileMapLayer>& outLayers, std::vector<std::vector<TileIndex>>& outTiles)
+{
+    int size = 0;
+    char* pText = LoadFile(path, &size);
+    if (!pText)
+    {
+        return false;
+    }
+    cJSON* pRoot = cJSON_ParseWithLength(pText, size);
+    free(pText);
+    if (!pRoot)
+    {
+        return false;
+    }
+    std::map<double, TileIndex> renumbered;
+    const cJSON* pLayer = NULL;
+    cJSON_ArrayForEach(pLayer, cJSON_GetObjectItem(pRoot, "layers"))
+    {
+        const cJSON* pData = cJSON_GetObjectItem(pLayer, "data");
+        if (!pData)
+        {
+            continue;
+        }
+        struct TileMapLayer layer;
+        memset(&layer, 0, sizeof(struct TileMapLayer));
+        layer.widthTiles = cJSON_GetObjectItem(pLayer, "width")->valueint;
+        layer.heightTiles = cJSON_GetObjectItem(pLayer, "height")->valueint;
+        std::vector<TileIndex> tiles;
+        const cJSON* pTile = NULL;
+        cJSON_ArrayForEach(pTile, pData)
+        {
+            if (pTile->valuedouble == 0.0)
+            {
+                tiles.push_back(0);
+                continue;
+            }
+            auto itr = renumbered.find(pTile->valuedouble);
+            if (itr == renumbered.end())
+            {
+                itr = renumbered.insert({ pTile->valuedouble, (TileIndex)(renumbered.size() + 1) }).first;
+            }
+            tiles.push_back(itr->second);
+        }
+        outLayers.push_back(layer);
+        outTiles.push_back(tiles);
+    }
+    cJSON_Delete(pRoot);
+    for (size_t i = 0; i < outLayers.size(); i++)
+    {
+        outLayers[i].Tiles = outTiles[i].data();
+    }
+    return !outLayers.empty();
+}
+
+/* times loading every tile layer of the map saved with compression, the bytes are the size of the tile data */
+static void BenchTilemapLoad(BenchState& state, const char* path, enum TileLayerCompression compression)
+{
+    std::vector<struct TileMapLayer> layers;
+    std::vector<std::vector<TileIndex>> tiles;
+    if (!LoadBenchTiledMap(path, layers, tiles))
+    {
+        state.Skip(std::string("can't load ") + path + ", run from the Stardew folder");
+        return;
+    }
+    struct BinarySerializer saveBS;
+    BS_CreateForSaveToMemory(&saveBS);
+    uint64_t numTiles = 0;
+    for (const struct TileMapLayer& layer : layers)
+    {
+        TilemapLayer_SerializeTiles(&layer, compression, &saveBS);
+        numTiles += layer.widthTiles * layer.heightTiles;
+    }
+    size_t savedSize = 0;
+    const char* pSaved = BS_GetSavedData(&saveBS, &savedSize);
+    std::vector<struct TileMapLayer> loaded = layers;
+
+    state.SetItemsPerIteration(numTiles);
+    state.SetBytes(savedSize);
+    state.Measure([&]()
+    {
+        struct BinarySerializer loadBS;
+        BS_CreateForLoadFromMemory(pSaved, savedSize, &loadBS);
+        for (struct TileMapLayer& layer : loaded)
+        {
+            TilemapLayer_DeserializeTiles(&layer, &loadBS);
+            Bench_KeepResult(layer.Tiles[0]);
+            free(layer.Tiles);
+        }
+        BS_Finish(&loadBS);
+    });
+    BS_Finish(&saveBS);
+}
+
+#define TILEMAP_LOAD_BENCH(map, compression) \
+    ENGINE_BENCH(TilemapLoad##map##compression) \
+    { \
+        BenchTilemapLoad(state, "./Assets/" #map ".json", TLC_##compression); \
+    }
+
+TILEMAP_LOAD_BENCH(Farm, Uncompressed)
+TILEMAP_LOAD_BENCH(Farm, RLE)
+TILEMAP_LOAD_BENCH(Farm, LZ4)
+TILEMAP_LOAD_BENCH(Farm, Smallest)
+TILEMAP_LOAD_BENCH(House, Uncompressed)
+TILEMAP_LOAD_BENCH(House, RLE)
+TILEMAP_LOAD_BENCH(House, LZ4)
+TILEMAP_LOAD_BENCH(House, Smallest)
+TILEMAP_LOAD_BENCH(RoadToTown, Uncompressed)
+TILEMAP_LOAD_BENCH(RoadToTown, RLE)
+TILEMAP_LOAD_BENCH(RoadToTown, LZ4)
+TILEMAP_LOAD_BENCH(RoadToTown, Smallest)
+
+static void BenchAtlasFileLoad(BenchState& state, hAtlas atlas, const struct AtlasSaveOptions& options)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "bench.atlas").string();
+    struct BinarySerializer bs;
+    BS_CreateForSave(path.c_str(), &bs);
+    At_SaveAtlasEx(&bs, atlas, &options);
+    BS_Finish(&bs);
+    state.SetBytes(std::filesystem::file_size(path));
+
+    struct DrawContext* pDC = BenchFixture_GetDrawContext();
+    state.Measure([&]()
+    {
+        hAtlas loaded = At_LoadAtlasFile(path.c_str(), pDC);
+        Bench_KeepResult(loaded);
+        At_DestroyAtlas(loaded, pDC);
+    });
+    std::filesystem::remove(path);
+}
+
+static void BenchAtlasLoad(BenchState& state, u32 version)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    struct AtlasSaveOptions options;
+    options.fileVersion = version;
+    options.pixelEncoding = APE_Raw;
+    BenchAtlasFileLoad(state, atlas, options);
+}
+
+ENGINE_BENCH(AtlasLoadV1)
+{
+    BenchAtlasLoad(state, 1);
+}
+
+ENGINE_BENCH(AtlasLoadV2)
+{
+    BenchAtlasLoad(state, 2);
+}
+
+/*
+    The game's atlases saved with each pixel encoding. bytes is the file size and MB/s is how fast compressed
+    pixels decode - raw pixels aren't decoded or even read, the null draw context doesn't touch them
+*/
+static void BenchAtlasLoadEncoded(BenchState& state, const char* xmlPath, enum AtlasPixelEncoding encoding)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetXMLAtlas(xmlPath, error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    struct AtlasSaveOptions options;
+    options.fileVersion = 2;
+    options.pixelEncoding = encoding;
+    if (encoding != APE_Raw)
+    {
+        int width = 0, height = 0;
+        At_GetAtlasTextureDims(atlas, &width, &height);
+        state.SetBytesPerIteration((uint64_t)width * height * 4);
+    }
+    BenchAtlasFileLoad(state, atlas, options);
+}
+
+#define ATLAS_LOAD_ENCODED_BENCH(atlasName, xmlPath, encoding) \
+    ENGINE_BENCH(AtlasLoad##atlasName##encoding) \
+    { \
+        BenchAtlasLoadEncoded(state, xmlPath, APE_##encoding); \
+    }
+
+ATLAS_LOAD_ENCODED_BENCH(Main, "./Assets/out/atlascombined.xml", Raw)
+ATLAS_LOAD_ENCODED_BENCH(Main, "./Assets/out/atlascombined.xml", QOI)
+ATLAS_LOAD_ENCODED_BENCH(UI, "./Assets/ui_atlas.xml", Raw)
+ATLAS_LOAD_ENCODED_BENCH(UI, "./Assets/ui_atlas.xml", QOI)
+/* the only shipped atlas with few enough colours for a palette */
+ATLAS_LOAD_ENCODED_BENCH(Sprites, "./Assets/out/expanded_named_sprites.xml", Raw)
+ATLAS_LOAD_ENCODED_BENCH(Sprites, "./Assets/out/expanded_named_sprites.xml", QOI)
+ATLAS_LOAD_ENCODED_BENCH(Sprites, "./Assets/out/expanded_named_sprites.xml", Palette)
+
+/* every path in ImageFiles.json, as the atlas looks up each sprite's image */
+ENGINE_BENCH(ImageLookupByPath)
+{
+    if (!BenchFixture_InitImageRegistry())
+    {
+        state.Skip("can't load ./Assets/ImageFiles.json, run from the Stardew folder");
+        return;
+    }
+    std::vector<std::string> paths;
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        paths.push_back(IR_GetImageFile(i)->path);
+    }
+    state.Shuffle(paths.data(), paths.size());
+    state.SetItemsPerIteration(paths.size());
+    state.Measure([&]()
+    {
+        for (const std::string& path : paths)
+        {
+            Bench_KeepResult(IR_LookupHandleByPath(path.c_str()));
+        }
+    });
+}
+
+static void UnloadAllImages()
+{
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        IR_UnloadImage(i);
+    }
+}
+
+/*
+    Decoding every image in ImageFiles.json: numThreads 0 loads them one after another with IR_LoadImageSync,
+    otherwise they're all queued with IR_LoadImageAsync on that many decode threads. Every image is unloaded
+    before each call, the files themselves will be in the OS cache after the first.
+*/
+static void BenchImageLoadAll(BenchState& state, int numThreads)
+{
+    if (!BenchFixture_InitImageRegistry())
+    {
+        state.Skip("can't load ./Assets/ImageFiles.json, run from the Stardew folder");
+        return;
+    }
+    uint64_t fileBytes = 0;
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(IR_GetImageFile(i)->path, error);
+        fileBytes += error ? 0 : size;
+    }
+    state.SetItemsPerIteration(IR_GetNumImages());
+    state.SetBytesPerIteration(fileBytes);
+    if (numThreads)
+    {
+        IR_SetNumDecodeThreads(numThreads);
+    }
+    state.Measure(&UnloadAllImages, [&]()
+    {
+        for (int i = 0; i < IR_GetNumImages(); i++)
+        {
+            if (numThreads)
+            {
+                IR_LoadImageAsync(i, NULL, NULL);
+            }
+            else
+            {
+                IR_LoadImageSync(i, NULL);
+            }
+        }
+        IR_WaitForAllImages();
+    });
+    UnloadAllImages();
+    IR_SetNumDecodeThreads(0);
+}
+
+ENGINE_BENCH(ImageLoadAllSerial)
+{
+    BenchImageLoadAll(state, 0);
+}
+
+#define IMAGE_LOAD_ALL_BENCH(numThreads) \
+    ENGINE_BENCH(ImageLoadAll##numThreads##Threads) \
+    { \
+        BenchImageLoadAll(state, numThreads); \
+    }
+
+IMAGE_LOAD_ALL_BENCH(1)
+IMAGE_LOAD_ALL_BENCH(2)
+IMAGE_LOAD_ALL_BENCH(4)
+IMAGE_LOAD_ALL_BENCH(8)
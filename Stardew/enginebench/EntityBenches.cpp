@@ -0,0 +1,912 @@
+#include "Bench.h"
+#include "BenchFixtures.h"
+#include "Game2DEntityFixture.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+extern "C" {
+#include "SpatialGrid.h"
+#include "EntityDrawOrder.h"
+#include "Components.h"
+#include "Atlas.h"
+}
+
+#define NUM_BENCH_ENTITIES 10000
+#define BENCH_WORLD_SIZE_PX 4096
+#define BENCH_ENTITY_SIZE_PX GAME2D_FIXTURE_ENTITY_SIZE_PX
+#define BENCH_QUADTREE_MAX_DEPTH 6
+#define NUM_BENCH_QUADTREE_QUERIES 100
+#define BENCH_VIEWPORT_W 640.0f
+#define BENCH_VIEWPORT_H 360.0f
+#define NUM_BENCH_TREES 10000
+#define NUM_BENCH_ANIMATED_ENTITIES 1000
+#define BENCH_FRAME_DELTA_T (1.0f / 60.0f)
+
+/* a Game2D layers entities, without the rest of the layer */
+struct BenchEntityWorld : Game2DEntityFixture
+{
+    BenchEntityWorld(BenchState& state, int numEntities)
+    {
+        BenchFixture_InitEngine();
+        InitEntities();
+        EDO_Init(&layerData.drawOrder);
+
+        for (int i = 0; i < numEntities; i++)
+        {
+            float x = state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX);
+            float y = state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX);
+            /* without components, so they're given a fixed size bounding box */
+            entities.push_back(AddEntity(x, y, &SquareGetBoundingBox));
+        }
+    }
+
+    ~BenchEntityWorld()
+    {
+        DestroyEntities();
+        DestroyQuadTree();
+        SG_Destroy(&layerData.entityGrid);
+        EDO_Destroy(&layerData.drawOrder);
+    }
+
+    void NewQuadTree()
+    {
+        DestroyQuadTree();
+        struct Entity2DQuadTreeInitArgs args = { 0, 0, BENCH_WORLD_SIZE_PX, BENCH_WORLD_SIZE_PX, BENCH_QUADTREE_MAX_DEPTH };
+        layerData.hEntitiesQuadTree = GetEntity2DQuadTree(&args);
+    }
+
+    void DestroyQuadTree()
+    {
+        if (layerData.hEntitiesQuadTree != NULL_HANDLE)
+        {
+            DestroyEntity2DQuadTree(layerData.hEntitiesQuadTree);
+            layerData.hEntitiesQuadTree = NULL_HANDLE;
+        }
+    }
+
+    void InsertAllIntoQuadTree()
+    {
+        for (HEntity2D hEnt : entities)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&layerData.entities, layerData.hEntitiesQuadTree, hEnt, &layer);
+        }
+    }
+
+    /* the spatial grid becomes the layers broadphase */
+    void NewSpatialGrid(float cellSize)
+    {
+        SG_Destroy(&layerData.entityGrid);
+        vec2 tl = { 0.0f, 0.0f };
+        SG_Init(&layerData.entityGrid, tl, BENCH_WORLD_SIZE_PX, BENCH_WORLD_SIZE_PX, cellSize);
+        layerData.broadphase = G2DBP_SpatialGrid;
+    }
+
+    void InsertAllIntoSpatialGrid()
+    {
+        for (HEntity2D hEnt : entities)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            vec2 tl, br;
+            Et2D_GetBoundingBox(pEnt, &layer, tl, br);
+            pEnt->hSpatialGridRef = SG_Insert(&layerData.entityGrid, hEnt, tl, br);
+        }
+    }
+
+    std::vector<HEntity2D> entities;
+};
+
+static bool SumEntityPositionsItr(struct Entity2D* pEnt, int i, void* pUser)
+{
+    float* pSum = (float*)pUser;
+    *pSum += pEnt->transform.position[1];
+    return true;
+}
+
+ENGINE_BENCH(Et2D_IterateEntities)
+{
+    BenchEntityWorld world(state, NUM_BENCH_ENTITIES);
+    state.SetItemsPerIteration(NUM_BENCH_ENTITIES);
+    state.Measure([&]()
+    {
+        float sum = 0.0f;
+        Et2D_IterateEntities(&world.layerData.entities, &SumEntityPositionsItr, &sum);
+        Bench_KeepResult(sum);
+    });
+}
+
+ENGINE_BENCH(QuadtreeInsert)
+{
+    BenchEntityWorld world(state, NUM_BENCH_ENTITIES);
+    state.SetItemsPerIteration(NUM_BENCH_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            world.NewQuadTree();
+        },
+        [&]()
+        {
+            world.InsertAllIntoQuadTree();
+        });
+}
+
+ENGINE_BENCH(QuadtreeQuery)
+{
+    BenchEntityWorld world(state, NUM_BENCH_ENTITIES);
+    world.NewQuadTree();
+    world.InsertAllIntoQuadTree();
+
+    std::vector<float> queryTLs;
+    for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+    {
+        queryTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_W));
+        queryTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_H));
+    }
+
+    VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure([&]()
+    {
+        int numFound = 0;
+        for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+        {
+            vec2 tl = { queryTLs[i * 2], queryTLs[i * 2 + 1] };
+            vec2 br = { tl[0] + BENCH_VIEWPORT_W, tl[1] + BENCH_VIEWPORT_H };
+            pFound = (HEntity2D*)VectorClear(pFound);
+            pFound = Entity2DQuadTree_Query(world.layerData.hEntitiesQuadTree, tl, br, pFound, &world.layerData.entities, &world.layer);
+            numFound += VectorSize(pFound);
+        }
+        Bench_KeepResult(numFound);
+    });
+    DestoryVector(pFound);
+}
+
+ENGINE_BENCH(EntityDrawOrderSort)
+{
+    BenchEntityWorld world(state, NUM_BENCH_ENTITIES);
+    std::vector<HEntity2D> unsorted = world.entities;
+    state.Shuffle(unsorted.data(), unsorted.size());
+
+    VECTOR(HEntity2D) pEnts = NEW_VECTOR(HEntity2D);
+    pEnts = (HEntity2D*)VectorPushN(pEnts, unsorted.data(), unsorted.size());
+    state.SetItemsPerIteration(unsorted.size());
+    state.Measure(
+        [&]()
+        {
+            memcpy(pEnts, unsorted.data(), unsorted.size() * sizeof(HEntity2D));
+        },
+        [&]()
+        {
+            Game2DLayer_SortEntitiesByDrawOrder(&world.layerData, pEnts);
+        });
+    DestoryVector(pEnts);
+}
+
+#define NUM_BENCH_DRAW_ORDER_ENTITIES 50000
+#define BENCH_DRAW_ORDER_STEP_PX 1.0f
+
+/* how entities were sorted before they had sort keys - getSortPos called through a global in every comparison */
+static struct Entity2DCollection* gBenchSortCollection = NULL;
+
+static int BenchGetSortPosCompare(const void* a, const void* b)
+{
+    struct Entity2D* pEntA = Et2D_GetEntity(gBenchSortCollection, *((HEntity2D*)a));
+    struct Entity2D* pEntB = Et2D_GetEntity(gBenchSortCollection, *((HEntity2D*)b));
+    float aval = pEntA->getSortPos(pEntA);
+    float bval = pEntB->getSortPos(pEntB);
+    return (aval > bval) - (aval < bval);
+}
+
+/* NUM_BENCH_DRAW_ORDER_ENTITIES visible entities in the order culling finds them, shuffled */
+struct BenchDrawOrder
+{
+    BenchDrawOrder(BenchState& state)
+        : world(state, NUM_BENCH_DRAW_ORDER_ENTITIES), unsorted(world.entities)
+    {
+        state.Shuffle(unsorted.data(), unsorted.size());
+        pEnts = NEW_VECTOR(HEntity2D);
+        pEnts = (HEntity2D*)VectorPushN(pEnts, unsorted.data(), unsorted.size());
+        pKeys = NEW_VECTOR(struct EntitySortKey);
+        pScratch = NEW_VECTOR(struct EntitySortKey);
+        pScratch = (struct EntitySortKey*)VectorResize(pScratch, unsorted.size());
+    }
+
+    ~BenchDrawOrder()
+    {
+        DestoryVector(pEnts);
+        DestoryVector(pKeys);
+        DestoryVector(pScratch);
+    }
+
+    void ResetEnts()
+    {
+        memcpy(pEnts, unsorted.data(), unsorted.size() * sizeof(HEntity2D));
+    }
+
+    /* every entity moves up or down a little between frames */
+    void MoveEntities(BenchState& state)
+    {
+        for (HEntity2D hEnt : world.entities)
+        {
+            Et2D_GetEntity(&world.layerData.entities, hEnt)->transform.position[1] += state.RandFloat(-BENCH_DRAW_ORDER_STEP_PX, BENCH_DRAW_ORDER_STEP_PX);
+        }
+    }
+
+    BenchEntityWorld world;
+    std::vector<HEntity2D> unsorted;
+    VECTOR(HEntity2D) pEnts;
+    VECTOR(struct EntitySortKey) pKeys;
+    VECTOR(struct EntitySortKey) pScratch;
+};
+
+ENGINE_BENCH(DrawOrderSortQsort)
+{
+    BenchDrawOrder order(state);
+    gBenchSortCollection = &order.world.layerData.entities;
+    state.SetItemsPerIteration(NUM_BENCH_DRAW_ORDER_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            order.MoveEntities(state);
+            order.ResetEnts();
+        },
+        [&]()
+        {
+            qsort(order.pEnts, VectorSize(order.pEnts), sizeof(HEntity2D), &BenchGetSortPosCompare);
+        });
+}
+
+/* a key per entity then a radix sort, without the last frame's order */
+ENGINE_BENCH(DrawOrderSortRadix)
+{
+    BenchDrawOrder order(state);
+    state.SetItemsPerIteration(NUM_BENCH_DRAW_ORDER_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            order.MoveEntities(state);
+            order.ResetEnts();
+        },
+        [&]()
+        {
+            order.pKeys = (struct EntitySortKey*)VectorClear(order.pKeys);
+            order.pKeys = EDO_PushKeys(&order.world.layerData.entities, order.pEnts, VectorSize(order.pEnts), order.pKeys);
+            EDO_RadixSort(order.pKeys, order.pScratch, VectorSize(order.pKeys));
+            for (unsigned int i = 0; i < VectorSize(order.pKeys); i++)
+            {
+                order.pEnts[i] = order.pKeys[i].hEnt;
+            }
+        });
+}
+
+/* what the layer does each frame - insertion sorting the last frame's order, as the entities only move a little */
+ENGINE_BENCH(DrawOrderSortCoherentInsertion)
+{
+    BenchDrawOrder order(state);
+    order.ResetEnts();
+    Game2DLayer_SortEntitiesByDrawOrder(&order.world.layerData, order.pEnts);
+    state.SetItemsPerIteration(NUM_BENCH_DRAW_ORDER_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            order.MoveEntities(state);
+            order.ResetEnts();
+        },
+        [&]()
+        {
+            Game2DLayer_SortEntitiesByDrawOrder(&order.world.layerData, order.pEnts);
+        });
+}
+
+/*
+    A forest - NUM_BENCH_TREES entities with a trunk and top sprite and a collider like the games trees,
+    and NUM_BENCH_ANIMATED_ENTITIES with an animated sprite, with or without the component store
+*/
+struct BenchForest : Game2DEntityFixture
+{
+    BenchForest(BenchState& state, hAtlas atlas, bool bUseComponentStore)
+    {
+        BenchFixture_InitEngine();
+        InitEntities(bUseComponentStore);
+        layerData.hAtlas = atlas;
+        for (int i = 0; i < BENCH_TILESET_SIZE; i++)
+        {
+            std::string name = "bench_tile_" + std::to_string(i);
+            frames.push_back(At_FindSprite(name.c_str(), atlas));
+        }
+
+        for (int i = 0; i < NUM_BENCH_TREES; i++)
+        {
+            struct Entity2D ent;
+            InitEntity(state, &ent);
+            struct Component2D* pTrunk = &ent.components[ent.numComponents++];
+            struct Component2D* pTop = &ent.components[ent.numComponents++];
+            struct Component2D* pCollider = &ent.components[ent.numComponents++];
+            InitSprite(pTrunk, frames[0]);
+            pTrunk->data.sprite.transform.position[1] = BENCH_ENTITY_SIZE_PX;
+            InitSprite(pTop, frames[1]);
+            pCollider->type = ETE_StaticCollider;
+            pCollider->data.staticCollider.shape.type = PBT_Circle;
+            pCollider->data.staticCollider.shape.data.circle.radius = 6.0f;
+            Et2D_AddEntity(&layerData.entities, &ent);
+        }
+        for (int i = 0; i < NUM_BENCH_ANIMATED_ENTITIES; i++)
+        {
+            struct Entity2D ent;
+            InitEntity(state, &ent);
+            struct Component2D* pComponent = &ent.components[ent.numComponents++];
+            pComponent->type = ETE_SpriteAnimator;
+            struct AnimatedSprite* pAnimatedSprite = &pComponent->data.spriteAnimator;
+            pAnimatedSprite->pSprites = frames.data();
+            pAnimatedSprite->numSprites = (int)frames.size();
+            pAnimatedSprite->fps = state.RandFloat(4.0f, 12.0f);
+            pAnimatedSprite->bRepeat = true;
+            pAnimatedSprite->bIsAnimating = true;
+            pAnimatedSprite->transform.scale[0] = 1.0f;
+            pAnimatedSprite->transform.scale[1] = 1.0f;
+            Et2D_AddEntity(&layerData.entities, &ent);
+        }
+        pVerts = NEW_VECTOR(Worldspace2DVert);
+        pIndices = NEW_VECTOR(VertIndexT);
+    }
+
+    ~BenchForest()
+    {
+        DestroyEntities();
+        DestoryVector(pVerts);
+        DestoryVector(pIndices);
+    }
+
+    static void InitEntity(BenchState& state, struct Entity2D* pEnt)
+    {
+        memset(pEnt, 0, sizeof(struct Entity2D));
+        Et2D_PopulateCommonHandlers(pEnt);
+        pEnt->transform.position[0] = state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX);
+        pEnt->transform.position[1] = state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX);
+        pEnt->transform.scale[0] = 1.0f;
+        pEnt->transform.scale[1] = 1.0f;
+        pEnt->hQuadTreeRef = NULL_HANDLE;
+        pEnt->hDynamicListRef = NULL_HANDLE;
+    }
+
+    static void InitSprite(struct Component2D* pComponent, hSprite sprite)
+    {
+        pComponent->type = ETE_Sprite;
+        pComponent->data.sprite.sprite = sprite;
+        pComponent->data.sprite.transform.scale[0] = 1.0f;
+        pComponent->data.sprite.transform.scale[1] = 1.0f;
+    }
+
+    void ClearVertices()
+    {
+        pVerts = (Worldspace2DVert*)VectorClear(pVerts);
+        pIndices = (VertIndexT*)VectorClear(pIndices);
+        nextIndex = 0;
+    }
+
+    std::vector<hSprite> frames;
+    VECTOR(Worldspace2DVert) pVerts;
+    VECTOR(VertIndexT) pIndices;
+    VertIndexT nextIndex = 0;
+};
+
+static bool UpdateForestEntity(struct Entity2D* pEnt, int i, void* pUser)
+{
+    BenchForest* pForest = (BenchForest*)pUser;
+    pEnt->update(pEnt, &pForest->layer, BENCH_FRAME_DELTA_T);
+    return true;
+}
+
+static bool DrawForestEntity(struct Entity2D* pEnt, int i, void* pUser)
+{
+    BenchForest* pForest = (BenchForest*)pUser;
+    pEnt->draw(pEnt, &pForest->layer, &pEnt->transform, &pForest->pVerts, &pForest->pIndices, &pForest->nextIndex);
+    return true;
+}
+
+/* every entity updated and drawn through its handlers, components inline */
+ENGINE_BENCH(ForestUpdateAndDrawInline)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    BenchForest forest(state, atlas, false);
+    state.SetItemsPerIteration(NUM_BENCH_TREES + NUM_BENCH_ANIMATED_ENTITIES);
+    state.Measure([&]()
+    {
+        forest.ClearVertices();
+        Et2D_IterateEntities(&forest.layerData.entities, &UpdateForestEntity, &forest);
+        Et2D_IterateEntities(&forest.layerData.entities, &DrawForestEntity, &forest);
+        Bench_KeepResult(VectorSize(forest.pVerts));
+    });
+}
+
+/* the same entities with their components in the component store, updated and drawn by its systems like the Game2D layer does */
+ENGINE_BENCH(ForestUpdateAndDrawComponentStore)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    BenchForest forest(state, atlas, true);
+    state.SetItemsPerIteration(NUM_BENCH_TREES + NUM_BENCH_ANIMATED_ENTITIES);
+    state.Measure([&]()
+    {
+        forest.ClearVertices();
+        Co_UpdateComponentStore(&forest.layerData.entities, &forest.layer, BENCH_FRAME_DELTA_T);
+        Et2D_IterateActiveEntities(&forest.layerData.entities, &UpdateForestEntity, &forest);
+        Co_DrawComponentStore(&forest.layerData.entities, &forest.layer, &forest.pVerts, &forest.pIndices, &forest.nextIndex);
+        Bench_KeepResult(VectorSize(forest.pVerts));
+    });
+}
+
+#define NUM_BENCH_CULL_STATIC_ENTITIES 20000
+#define NUM_BENCH_CULL_DYNAMIC_ENTITIES 2000
+#define NUM_BENCH_CULL_VIEWPORTS 64
+
+/*
+    A level to cull - NUM_BENCH_CULL_STATIC_ENTITIES with a trunk and top sprite in the quadtree
+    and NUM_BENCH_CULL_DYNAMIC_ENTITIES with an animated sprite in the dynamic list, moved every frame
+*/
+struct BenchCullLevel : Game2DEntityFixture
+{
+    BenchCullLevel(BenchState& state, hAtlas atlas)
+    {
+        BenchFixture_InitEngine();
+        InitEntities();
+        layerData.hAtlas = atlas;
+        struct Entity2DQuadTreeInitArgs args = { 0, 0, BENCH_WORLD_SIZE_PX, BENCH_WORLD_SIZE_PX, BENCH_QUADTREE_MAX_DEPTH };
+        layerData.hEntitiesQuadTree = GetEntity2DQuadTree(&args);
+        for (int i = 0; i < BENCH_TILESET_SIZE; i++)
+        {
+            std::string name = "bench_tile_" + std::to_string(i);
+            frames.push_back(At_FindSprite(name.c_str(), atlas));
+        }
+
+        for (int i = 0; i < NUM_BENCH_CULL_STATIC_ENTITIES; i++)
+        {
+            struct Entity2D ent;
+            BenchForest::InitEntity(state, &ent);
+            struct Component2D* pTrunk = &ent.components[ent.numComponents++];
+            struct Component2D* pTop = &ent.components[ent.numComponents++];
+            BenchForest::InitSprite(pTrunk, frames[0]);
+            pTrunk->data.sprite.transform.position[1] = BENCH_ENTITY_SIZE_PX;
+            BenchForest::InitSprite(pTop, frames[1]);
+            HEntity2D hEnt = Et2D_AddEntity(&layerData.entities, &ent);
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&layerData.entities, layerData.hEntitiesQuadTree, hEnt, &layer);
+            entities.push_back(hEnt);
+        }
+        for (int i = 0; i < NUM_BENCH_CULL_DYNAMIC_ENTITIES; i++)
+        {
+            struct Entity2D ent;
+            BenchForest::InitEntity(state, &ent);
+            struct Component2D* pComponent = &ent.components[ent.numComponents++];
+            pComponent->type = ETE_SpriteAnimator;
+            struct AnimatedSprite* pAnimatedSprite = &pComponent->data.spriteAnimator;
+            pAnimatedSprite->pSprites = frames.data();
+            pAnimatedSprite->numSprites = (int)frames.size();
+            pAnimatedSprite->transform.scale[0] = 1.0f;
+            pAnimatedSprite->transform.scale[1] = 1.0f;
+            HEntity2D hEnt = Et2D_AddEntity(&layerData.entities, &ent);
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            pEnt->hDynamicListRef = DynL_AddEntity(&layerData.entities.dynamicEntities, hEnt);
+            entities.push_back(hEnt);
+            dynamicEntities.push_back(hEnt);
+        }
+        for (int i = 0; i < NUM_BENCH_CULL_VIEWPORTS; i++)
+        {
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_W));
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_H));
+        }
+        pFound = NEW_VECTOR(HEntity2D);
+    }
+
+    ~BenchCullLevel()
+    {
+        DestroyEntities();
+        DestroyEntity2DQuadTree(layerData.hEntitiesQuadTree);
+        DestoryVector(pFound);
+    }
+
+    /* what the dynamic entities do between frames */
+    void MoveDynamicEntities()
+    {
+        for (HEntity2D hEnt : dynamicEntities)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            pEnt->transform.position[0] = fmodf(pEnt->transform.position[0] + 1.0f, BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX);
+            Et2D_MarkBoundingBoxDirty(pEnt);
+        }
+    }
+
+    /* a frames culling, for the next viewport */
+    void Cull()
+    {
+        float* pTL = &viewportTLs[(onViewport++ % NUM_BENCH_CULL_VIEWPORTS) * 2];
+        vec2 tl = { pTL[0], pTL[1] };
+        vec2 br = { tl[0] + BENCH_VIEWPORT_W, tl[1] + BENCH_VIEWPORT_H };
+        pFound = (HEntity2D*)VectorClear(pFound);
+        pFound = Game2DLayer_CullEntities(&layerData, tl, br, pFound);
+        Bench_KeepResult(VectorSize(pFound));
+    }
+
+    std::vector<hSprite> frames;
+    std::vector<HEntity2D> entities;
+    std::vector<HEntity2D> dynamicEntities;
+    std::vector<float> viewportTLs;
+    int onViewport = 0;
+    VECTOR(HEntity2D) pFound;
+};
+
+/* a frame of culling with only the dynamic entities bounding boxes dirty */
+ENGINE_BENCH(CullLevelCachedBoundingBoxes)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    BenchCullLevel level(state, atlas);
+    state.SetItemsPerIteration(NUM_BENCH_CULL_STATIC_ENTITIES + NUM_BENCH_CULL_DYNAMIC_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            level.MoveDynamicEntities();
+        },
+        [&]()
+        {
+            level.Cull();
+        });
+}
+
+/* every bounding box dirty, so culling calls getBB for every entity it tests like it did before they were cached */
+ENGINE_BENCH(CullLevelEveryBoundingBoxDirty)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    BenchCullLevel level(state, atlas);
+    state.SetItemsPerIteration(NUM_BENCH_CULL_STATIC_ENTITIES + NUM_BENCH_CULL_DYNAMIC_ENTITIES);
+    state.Measure(
+        [&]()
+        {
+            level.MoveDynamicEntities();
+            for (HEntity2D hEnt : level.entities)
+            {
+                Et2D_MarkBoundingBoxDirty(Et2D_GetEntity(&level.layerData.entities, hEnt));
+            }
+        },
+        [&]()
+        {
+            level.Cull();
+        });
+}
+
+#define NUM_BENCH_WANDERERS 5000
+#define BENCH_WANDER_SPEED_PX 120.0f
+
+enum BenchWanderersKeptIn
+{
+    BWKI_Quadtree,
+    BWKI_DynamicList,
+    BWKI_SpatialGrid
+};
+
+/* NUM_BENCH_WANDERERS NPC like entities walking around the world, kept in the quadtree, the dynamic list or the spatial grid */
+struct BenchWanderers
+{
+    BenchWanderers(BenchState& state, enum BenchWanderersKeptIn keptIn)
+        : world(state, NUM_BENCH_WANDERERS), bInQuadTree(keptIn != BWKI_DynamicList)
+    {
+        world.NewQuadTree();
+        if (keptIn == BWKI_Quadtree)
+        {
+            world.InsertAllIntoQuadTree();
+        }
+        else if (keptIn == BWKI_SpatialGrid)
+        {
+            world.NewSpatialGrid(SPATIAL_GRID_DEFAULT_CELL_SIZE);
+            world.InsertAllIntoSpatialGrid();
+        }
+        for (HEntity2D hEnt : world.entities)
+        {
+            if (!bInQuadTree)
+            {
+                struct Entity2D* pEnt = Et2D_GetEntity(&world.layerData.entities, hEnt);
+                pEnt->hDynamicListRef = DynL_AddEntity(&world.layerData.entities.dynamicEntities, hEnt);
+            }
+            velocities.push_back(state.RandFloat(-BENCH_WANDER_SPEED_PX, BENCH_WANDER_SPEED_PX));
+            velocities.push_back(state.RandFloat(-BENCH_WANDER_SPEED_PX, BENCH_WANDER_SPEED_PX));
+        }
+        for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+        {
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_W));
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_H));
+        }
+        pFound = NEW_VECTOR(HEntity2D);
+    }
+
+    ~BenchWanderers()
+    {
+        DestoryVector(pFound);
+    }
+
+    /* a frame of walking, turning back at the edges of the world */
+    void Step()
+    {
+        for (size_t i = 0; i < world.entities.size(); i++)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&world.layerData.entities, world.entities[i]);
+            for (int axis = 0; axis < 2; axis++)
+            {
+                float* pVelocity = &velocities[i * 2 + axis];
+                float newPos = pEnt->transform.position[axis] + *pVelocity * BENCH_FRAME_DELTA_T;
+                if (newPos < 0.0f || newPos > BENCH_WORLD_SIZE_PX - BENCH_ENTITY_SIZE_PX)
+                {
+                    *pVelocity = -*pVelocity;
+                }
+                else
+                {
+                    pEnt->transform.position[axis] = newPos;
+                }
+            }
+            if (bInQuadTree)
+            {
+                Et2D_BroadphaseMove(&world.layer, pEnt);
+            }
+            else
+            {
+                Et2D_MarkBoundingBoxDirty(pEnt);
+            }
+        }
+    }
+
+    int Query()
+    {
+        int numFound = 0;
+        for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+        {
+            vec2 tl = { viewportTLs[i * 2], viewportTLs[i * 2 + 1] };
+            vec2 br = { tl[0] + BENCH_VIEWPORT_W, tl[1] + BENCH_VIEWPORT_H };
+            pFound = (HEntity2D*)VectorClear(pFound);
+            pFound = Game2DLayer_CullEntities(&world.layerData, tl, br, pFound);
+            numFound += VectorSize(pFound);
+        }
+        return numFound;
+    }
+
+    BenchEntityWorld world;
+    /* in the layers broadphase rather than the dynamic list */
+    bool bInQuadTree;
+    std::vector<float> velocities;
+    std::vector<float> viewportTLs;
+    VECTOR(HEntity2D) pFound;
+};
+
+ENGINE_BENCH(WanderersQuadtreeMove)
+{
+    BenchWanderers wanderers(state, BWKI_Quadtree);
+    state.SetItemsPerIteration(NUM_BENCH_WANDERERS);
+    state.Measure([&]()
+    {
+        wanderers.Step();
+    });
+}
+
+ENGINE_BENCH(WanderersDynamicListMove)
+{
+    BenchWanderers wanderers(state, BWKI_DynamicList);
+    state.SetItemsPerIteration(NUM_BENCH_WANDERERS);
+    state.Measure([&]()
+    {
+        wanderers.Step();
+    });
+}
+
+ENGINE_BENCH(WanderersQuadtreeQuery)
+{
+    BenchWanderers wanderers(state, BWKI_Quadtree);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure(
+        [&]()
+        {
+            wanderers.Step();
+        },
+        [&]()
+        {
+            Bench_KeepResult(wanderers.Query());
+        });
+}
+
+ENGINE_BENCH(WanderersDynamicListQuery)
+{
+    BenchWanderers wanderers(state, BWKI_DynamicList);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure(
+        [&]()
+        {
+            wanderers.Step();
+        },
+        [&]()
+        {
+            Bench_KeepResult(wanderers.Query());
+        });
+}
+
+ENGINE_BENCH(WanderersSpatialGridMove)
+{
+    BenchWanderers wanderers(state, BWKI_SpatialGrid);
+    state.SetItemsPerIteration(NUM_BENCH_WANDERERS);
+    state.Measure([&]()
+    {
+        wanderers.Step();
+    });
+}
+
+ENGINE_BENCH(WanderersSpatialGridQuery)
+{
+    BenchWanderers wanderers(state, BWKI_SpatialGrid);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure(
+        [&]()
+        {
+            wanderers.Step();
+        },
+        [&]()
+        {
+            Bench_KeepResult(wanderers.Query());
+        });
+}
+
+#define BENCH_PIXELS_PER_METER 32.0f
+#define BENCH_WOODED_AREA_DENSITY 1.0f
+#define BENCH_TREE_W_PX 32.0f
+#define BENCH_TREE_H_PX 48.0f
+#define BENCH_TOOL_RADIUS_PX 24.0f
+#define NUM_BENCH_TOOL_SWINGS 1000
+
+/* a tree, trunk and top */
+static void BenchTreeGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+{
+    outTL[0] = pEnt->transform.position[0];
+    outTL[1] = pEnt->transform.position[1];
+    outBR[0] = pEnt->transform.position[0] + BENCH_TREE_W_PX;
+    outBR[1] = pEnt->transform.position[1] + BENCH_TREE_H_PX;
+}
+
+/*
+    A dense forest over the whole world, the way the games WfWoodedArea makes one - its area in square
+    meters times a density of trees, at uniformly random positions (the game isn't linked into the benchmarks
+    so its generation is repeated here)
+*/
+struct BenchWoodedArea
+{
+    static int NumTrees()
+    {
+        float mSize = BENCH_WORLD_SIZE_PX / BENCH_PIXELS_PER_METER;
+        return (int)(mSize * mSize * BENCH_WOODED_AREA_DENSITY);
+    }
+
+    BenchWoodedArea(BenchState& state, enum Game2DBroadphase broadphase)
+        : world(state, NumTrees())
+    {
+        for (HEntity2D hEnt : world.entities)
+        {
+            Et2D_GetEntity(&world.layerData.entities, hEnt)->getBB = &BenchTreeGetBoundingBox;
+        }
+        world.NewQuadTree();
+        if (broadphase == G2DBP_SpatialGrid)
+        {
+            world.NewSpatialGrid(SPATIAL_GRID_DEFAULT_CELL_SIZE);
+            world.InsertAllIntoSpatialGrid();
+        }
+        else
+        {
+            world.InsertAllIntoQuadTree();
+        }
+        for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+        {
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_W));
+            viewportTLs.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX - BENCH_VIEWPORT_H));
+        }
+        for (int i = 0; i < NUM_BENCH_TOOL_SWINGS; i++)
+        {
+            swingCenters.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX));
+            swingCenters.push_back(state.RandFloat(0.0f, BENCH_WORLD_SIZE_PX));
+        }
+        pFound = NEW_VECTOR(HEntity2D);
+    }
+
+    ~BenchWoodedArea()
+    {
+        DestoryVector(pFound);
+    }
+
+    int Cull()
+    {
+        int numFound = 0;
+        for (int i = 0; i < NUM_BENCH_QUADTREE_QUERIES; i++)
+        {
+            vec2 tl = { viewportTLs[i * 2], viewportTLs[i * 2 + 1] };
+            vec2 br = { tl[0] + BENCH_VIEWPORT_W, tl[1] + BENCH_VIEWPORT_H };
+            pFound = (HEntity2D*)VectorClear(pFound);
+            pFound = Game2DLayer_CullEntities(&world.layerData, tl, br, pFound);
+            numFound += VectorSize(pFound);
+        }
+        return numFound;
+    }
+
+    /* an axe hitting whatever trees are in reach */
+    int SwingTools()
+    {
+        int numHit = 0;
+        for (int i = 0; i < NUM_BENCH_TOOL_SWINGS; i++)
+        {
+            vec2 center = { swingCenters[i * 2], swingCenters[i * 2 + 1] };
+            pFound = (HEntity2D*)VectorClear(pFound);
+            pFound = Game2DLayer_QueryEntitiesInRadius(&world.layerData, center, BENCH_TOOL_RADIUS_PX, pFound);
+            numHit += VectorSize(pFound);
+        }
+        return numHit;
+    }
+
+    BenchEntityWorld world;
+    std::vector<float> viewportTLs;
+    std::vector<float> swingCenters;
+    VECTOR(HEntity2D) pFound;
+};
+
+ENGINE_BENCH(WoodedAreaQuadtreeCull)
+{
+    BenchWoodedArea forest(state, G2DBP_Quadtree);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure([&]()
+    {
+        Bench_KeepResult(forest.Cull());
+    });
+}
+
+ENGINE_BENCH(WoodedAreaSpatialGridCull)
+{
+    BenchWoodedArea forest(state, G2DBP_SpatialGrid);
+    state.SetItemsPerIteration(NUM_BENCH_QUADTREE_QUERIES);
+    state.Measure([&]()
+    {
+        Bench_KeepResult(forest.Cull());
+    });
+}
+
+ENGINE_BENCH(WoodedAreaQuadtreeToolRadius)
+{
+    BenchWoodedArea forest(state, G2DBP_Quadtree);
+    state.SetItemsPerIteration(NUM_BENCH_TOOL_SWINGS);
+    state.Measure([&]()
+    {
+        Bench_KeepResult(forest.SwingTools());
+    });
+}
+
+ENGINE_BENCH(WoodedAreaSpatialGridToolRadius)
+{
+    BenchWoodedArea forest(state, G2DBP_SpatialGrid);
+    state.SetItemsPerIteration(NUM_BENCH_TOOL_SWINGS);
+    state.Measure([&]()
+    {
+        Bench_KeepResult(forest.SwingTools());
+    });
+}
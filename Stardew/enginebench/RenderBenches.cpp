@@ -0,0 +1,428 @@
+#include "Bench.h"
+#include "BenchFixtures.h"
+#include "DynArray.h"
+#include "DrawContext.h"
+#include "Game2DLayer.h"
+#include "TilemapChunks.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define BENCH_TILEMAP_LAYER_SIZE 256
+#define NUM_BENCH_STRINGS 1000
+#define BENCH_MAX_STRING_LEN 64
+
+static void InitBenchTileLayer(BenchState& state, struct TileMapLayer* pLayer, std::vector<TileIndex>& tiles)
+{
+    memset(pLayer, 0, sizeof(struct TileMapLayer));
+    pLayer->transform.scale[0] = 1.0f;
+    pLayer->transform.scale[1] = 1.0f;
+    pLayer->tileWidthPx = BENCH_TILE_SIZE_PX;
+    pLayer->tileHeightPx = BENCH_TILE_SIZE_PX;
+    pLayer->widthTiles = BENCH_TILEMAP_LAYER_SIZE;
+    pLayer->heightTiles = BENCH_TILEMAP_LAYER_SIZE;
+    tiles.resize(BENCH_TILEMAP_LAYER_SIZE * BENCH_TILEMAP_LAYER_SIZE);
+    for (TileIndex& tile : tiles)
+    {
+        /* roughly one in ten tiles empty */
+        tile = state.RandInt(0, 10) == 0 ? 0 : (TileIndex)state.RandInt(1, BENCH_TILESET_SIZE + 1);
+    }
+    pLayer->Tiles = tiles.data();
+}
+
+/* a 1920x1080 view in the middle of the layer */
+static void GetBenchScreenViewport(vec2 outTL, vec2 outBR)
+{
+    float layerSizePx = (float)(BENCH_TILEMAP_LAYER_SIZE * BENCH_TILE_SIZE_PX);
+    outTL[0] = layerSizePx / 2.0f - 960.0f;
+    outTL[1] = layerSizePx / 2.0f - 540.0f;
+    outBR[0] = outTL[0] + 1920.0f;
+    outBR[1] = outTL[1] + 1080.0f;
+}
+
+ENGINE_BENCH(OutputTilemapLayerVertices256)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+
+    /* the whole layer is in view */
+    vec2 viewportTL = { 0.0f, 0.0f };
+    vec2 viewportBR = { (float)(BENCH_TILEMAP_LAYER_SIZE * BENCH_TILE_SIZE_PX), (float)(BENCH_TILEMAP_LAYER_SIZE * BENCH_TILE_SIZE_PX) };
+
+    VECTOR(Worldspace2DVert) pVerts = NEW_VECTOR(Worldspace2DVert);
+    VECTOR(VertIndexT) pInds = NEW_VECTOR(VertIndexT);
+    VertIndexT nextIndex = 0;
+    state.SetItemsPerIteration(tiles.size());
+    state.Measure(
+        [&]()
+        {
+            pVerts = (Worldspace2DVert*)VectorClear(pVerts);
+            pInds = (VertIndexT*)VectorClear(pInds);
+            nextIndex = 0;
+        },
+        [&]()
+        {
+            OutputTilemapLayerVertices(atlas, &layer, &pVerts, &pInds, &nextIndex, viewportTL, viewportBR);
+        });
+    DestoryVector(pVerts);
+    DestoryVector(pInds);
+}
+
+/* what a tile layer used to cost per frame: output the visible tiles and upload them */
+ENGINE_BENCH(TilemapLayerPerFrameVerticesScreen)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    struct DrawContext* pDC = BenchFixture_GetDrawContext();
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+    vec2 viewportTL, viewportBR;
+    GetBenchScreenViewport(viewportTL, viewportBR);
+    mat4 view;
+    glm_mat4_identity(view);
+
+    H2DWorldspaceVertexBuffer hBuf = pDC->NewWorldspaceVertBuffer(256);
+    VECTOR(Worldspace2DVert) pVerts = NEW_VECTOR(Worldspace2DVert);
+    VECTOR(VertIndexT) pInds = NEW_VECTOR(VertIndexT);
+    state.Measure([&]()
+    {
+        pVerts = (Worldspace2DVert*)VectorClear(pVerts);
+        pInds = (VertIndexT*)VectorClear(pInds);
+        VertIndexT nextIndex = 0;
+        OutputTilemapLayerVertices(atlas, &layer, &pVerts, &pInds, &nextIndex, viewportTL, viewportBR);
+        pDC->WorldspaceVertexBufferData(hBuf, pVerts, VectorSize(pVerts), pInds, VectorSize(pInds));
+        pDC->DrawWorldspaceVertexBuffer(hBuf, VectorSize(pInds), view);
+    });
+    pDC->DestroyWorldspaceVertexBuffer(hBuf);
+    DestoryVector(pVerts);
+    DestoryVector(pInds);
+}
+
+/* the draw context without vertex pulled tilemaps, so tile layers are drawn from chunk vertex buffers */
+static DrawContext GetVertexBufferTilemapDrawContext()
+{
+    DrawContext dc = *BenchFixture_GetDrawContext();
+    dc.NewTileIndexTexture = NULL;
+    return dc;
+}
+
+ENGINE_BENCH(TilemapChunksDrawScreen)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    DrawContext dc = GetVertexBufferTilemapDrawContext();
+    struct DrawContext* pDC = &dc;
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+    TilemapLayer_BuildChunks(&layer, atlas, pDC);
+    vec2 viewportTL, viewportBR;
+    GetBenchScreenViewport(viewportTL, viewportBR);
+    mat4 view;
+    glm_mat4_identity(view);
+
+    state.Measure([&]()
+    {
+        TilemapLayer_RebuildDirtyChunks(&layer, atlas, pDC);
+        Bench_KeepResult(TilemapLayer_DrawVisibleChunks(&layer, pDC, viewportTL, viewportBR, view));
+    });
+    TilemapLayer_DestroyChunks(&layer, pDC);
+}
+
+/* hoeing a tile: change it and rebuild its chunk */
+ENGINE_BENCH(TilemapChunksSetTile)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    DrawContext dc = GetVertexBufferTilemapDrawContext();
+    struct DrawContext* pDC = &dc;
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+    TilemapLayer_BuildChunks(&layer, atlas, pDC);
+
+    state.Measure([&]()
+    {
+        int col = state.RandInt(0, BENCH_TILEMAP_LAYER_SIZE);
+        int row = state.RandInt(0, BENCH_TILEMAP_LAYER_SIZE);
+        tiles[row * BENCH_TILEMAP_LAYER_SIZE + col] = (TileIndex)state.RandInt(1, BENCH_TILESET_SIZE + 1);
+        TilemapLayer_MarkTileDirty(&layer, col, row);
+        TilemapLayer_RebuildDirtyChunks(&layer, atlas, pDC);
+    });
+    TilemapLayer_DestroyChunks(&layer, pDC);
+}
+
+ENGINE_BENCH(TilemapVertexPulledDrawScreen)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    struct DrawContext* pDC = BenchFixture_GetDrawContext();
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+    TilemapLayer_BuildChunks(&layer, atlas, pDC);
+    if (!layer.pRenderData->bVertexPulled)
+    {
+        TilemapLayer_DestroyChunks(&layer, pDC);
+        state.Skip("bench tileset can't be vertex pulled");
+        return;
+    }
+    vec2 viewportTL, viewportBR;
+    GetBenchScreenViewport(viewportTL, viewportBR);
+    mat4 view;
+    glm_mat4_identity(view);
+
+    state.Measure([&]()
+    {
+        TilemapLayer_RebuildDirtyChunks(&layer, atlas, pDC);
+        Bench_KeepResult(TilemapLayer_DrawVisibleChunks(&layer, pDC, viewportTL, viewportBR, view));
+    });
+    TilemapLayer_DestroyChunks(&layer, pDC);
+}
+
+/* hoeing a tile with vertex pulling: one texel write and a recount of its chunk */
+ENGINE_BENCH(TilemapVertexPulledSetTile)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    struct DrawContext* pDC = BenchFixture_GetDrawContext();
+
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitBenchTileLayer(state, &layer, tiles);
+    TilemapLayer_BuildChunks(&layer, atlas, pDC);
+
+    state.Measure([&]()
+    {
+        int col = state.RandInt(0, BENCH_TILEMAP_LAYER_SIZE);
+        int row = state.RandInt(0, BENCH_TILEMAP_LAYER_SIZE);
+        tiles[row * BENCH_TILEMAP_LAYER_SIZE + col] = (TileIndex)state.RandInt(1, BENCH_TILESET_SIZE + 1);
+        TilemapLayer_MarkTileDirty(&layer, col, row);
+        TilemapLayer_RebuildDirtyChunks(&layer, atlas, pDC);
+    });
+    TilemapLayer_DestroyChunks(&layer, pDC);
+}
+
+ENGINE_BENCH(Fo_StringWidth)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+    HFont font = Fo_FindFont(atlas, BENCH_FONT_NAME, BENCH_FONT_SIZE_PTS);
+
+    std::vector<std::string> strings;
+    for (int i = 0; i < NUM_BENCH_STRINGS; i++)
+    {
+        int len = state.RandInt(1, BENCH_MAX_STRING_LEN + 1);
+        std::string str;
+        for (int j = 0; j < len; j++)
+        {
+            /* printable ascii */
+            str.push_back((char)state.RandInt(' ', '~' + 1));
+        }
+        strings.push_back(str);
+    }
+
+    state.SetItemsPerIteration(strings.size());
+    state.Measure([&]()
+    {
+        float total = 0.0f;
+        for (const std::string& str : strings)
+        {
+            total += Fo_StringWidth(atlas, font, str.c_str());
+        }
+        Bench_KeepResult(total);
+    });
+}
+
+/* the game's two fonts at the sizes a UI is likely to use */
+static const char* gBenchFontPaths[] = { "./Assets/ComicMono.ttf", "./Assets/Starzy_Darzy_lowercase_letters.ttf" };
+static const float gBenchFontSizesPts[] = { 8.0f, 12.0f, 16.0f, 24.0f, 32.0f, 48.0f };
+#define BENCH_GLYPH_CACHE_FONT_SIZE_PTS 32.0f
+
+static bool BenchFontsExist(BenchState& state)
+{
+    for (const char* path : gBenchFontPaths)
+    {
+        FILE* pFile = fopen(path, "rb");
+        if (!pFile)
+        {
+            state.Skip(std::string("can't find ") + path + ", run from the Stardew folder");
+            return false;
+        }
+        fclose(pFile);
+    }
+    return true;
+}
+
+static void AddBenchFont(const char* path, const float* sizesPts, int numSizes, bool bDynamic)
+{
+    struct FontAtlasAdditionSpec fontSpec;
+    memset(&fontSpec, 0, sizeof(struct FontAtlasAdditionSpec));
+    fontSpec.fontOptions = FontAtlasAdditionSpec::FS_Normal;
+    strcpy(fontSpec.name, path);
+    strcpy(fontSpec.path, path);
+    for (int i = 0; i < numSizes; i++)
+    {
+        fontSpec.fontSizes[i].type = FontSize::FOS_Pts;
+        fontSpec.fontSizes[i].val = sizesPts[i];
+    }
+    fontSpec.numFontSizes = numSizes;
+    fontSpec.bDynamic = bDynamic;
+    At_AddFont(&fontSpec);
+}
+
+/*
+    Building an atlas of both fonts at all six sizes - static fonts rasterise and pack glyphs 0 to 255 of
+    every size, dynamic ones just open the font. bytes is the atlas texture's size.
+    Packed with MaxRects, the default packer takes tens of seconds over this many glyphs
+*/
+static void BenchFontAtlasStartup(BenchState& state, bool bDynamic)
+{
+    if (!BenchFontsExist(state))
+    {
+        return;
+    }
+    DrawContext* pDC = BenchFixture_GetDrawContext();
+    int numSizes = sizeof(gBenchFontSizesPts) / sizeof(float);
+    hAtlas atlas = NULL_HANDLE;
+    auto destroyAtlas = [&]()
+    {
+        if (atlas != NULL_HANDLE)
+        {
+            At_DestroyAtlas(atlas, pDC);
+            atlas = NULL_HANDLE;
+        }
+    };
+    state.Measure(destroyAtlas, [&]()
+    {
+        At_BeginAtlas();
+        for (const char* path : gBenchFontPaths)
+        {
+            AddBenchFont(path, gBenchFontSizesPts, numSizes, bDynamic);
+        }
+        struct EndAtlasOptions options;
+        memset(&options, 0, sizeof(struct EndAtlasOptions));
+        options.initialAtlasWidth = 512;
+        options.initialAtlasHeight = 512;
+        options.packer = APT_MaxRectsBSSF;
+        atlas = At_EndAtlasEx(pDC, &options);
+    });
+    int width = 0, height = 0;
+    At_GetAtlasTextureDims(atlas, &width, &height);
+    state.SetBytes((uint64_t)width * height * 4);
+    destroyAtlas();
+}
+
+ENGINE_BENCH(FontAtlasStartupStatic)
+{
+    BenchFontAtlasStartup(state, false);
+}
+
+ENGINE_BENCH(FontAtlasStartupDynamic)
+{
+    BenchFontAtlasStartup(state, true);
+}
+
+/*
+    Drawing glyphs from a dynamic font, binding the atlas after each as a frame would. With a cache too small for
+    the glyphs cycled through every glyph misses - it's rasterised again, shelf packed (evicting a shelf) and uploaded.
+    With only the glyphs of a short string every one is a hit
+*/
+static void BenchDynamicGlyphs(BenchState& state, int glyphCacheSize, const std::vector<u32>& codepoints)
+{
+    if (!BenchFontsExist(state))
+    {
+        return;
+    }
+    DrawContext* pDC = BenchFixture_GetDrawContext();
+    At_BeginAtlas();
+    At_SetGlyphCacheSize(glyphCacheSize, glyphCacheSize);
+    float size = BENCH_GLYPH_CACHE_FONT_SIZE_PTS;
+    AddBenchFont(gBenchFontPaths[0], &size, 1, true);
+    hAtlas atlas = At_EndAtlas(pDC);
+    HFont font = Fo_FindFont(atlas, gBenchFontPaths[0], size);
+
+    size_t onCodepoint = 0;
+    state.SetItemsPerIteration(codepoints.size());
+    state.Measure([&]()
+    {
+        for (size_t i = 0; i < codepoints.size(); i++)
+        {
+            Bench_KeepResult(Fo_GetGlyphSprite(atlas, font, codepoints[onCodepoint])->topLeftUV_U);
+            At_SetCurrent(atlas, pDC);
+            onCodepoint = (onCodepoint + 1) % codepoints.size();
+        }
+    });
+    At_DestroyAtlas(atlas, pDC);
+}
+
+ENGINE_BENCH(DynamicGlyphMiss)
+{
+    /* printable latin 1, far more than fit in 128 x 128 at 32pt */
+    std::vector<u32> codepoints;
+    for (u32 c = '!'; c <= '~'; c++)
+    {
+        codepoints.push_back(c);
+    }
+    for (u32 c = 0xa1; c <= 0xff; c++)
+    {
+        codepoints.push_back(c);
+    }
+    BenchDynamicGlyphs(state, 128, codepoints);
+}
+
+ENGINE_BENCH(DynamicGlyphHit)
+{
+    std::vector<u32> codepoints;
+    for (const char* c = "Hello world!"; *c; c++)
+    {
+        codepoints.push_back((u8)*c);
+    }
+    BenchDynamicGlyphs(state, ATLAS_DEFAULT_GLYPH_CACHE_SIZE, codepoints);
+}
@@ -0,0 +1,217 @@
+#include "Bench.h"
+#include "BenchFixtures.h"
+#include "Widget.h"
+#include "XMLUIGameLayer.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+extern "C" {
+#include "DataNode.h"
+#include "RootWidget.h"
+#include "StackPanelWidget.h"
+#include "StaticWidget.h"
+#include "TextWidget.h"
+}
+
+/* 1 column + 40 rows + 960 static widgets */
+#define NUM_BENCH_UI_ROWS 40
+#define NUM_BENCH_UI_WIDGETS_PER_ROW 24
+#define BENCH_WINDOW_W 1920
+#define BENCH_WINDOW_H 1080
+
+/* a DataNode for properties set from code, rather than from xml or a lua table */
+struct BenchDataNodeProp
+{
+    enum DNPropValType type;
+    std::string stringVal;
+    float floatVal;
+};
+
+typedef std::map<std::string, BenchDataNodeProp> BenchDataNodeProps;
+
+static const BenchDataNodeProp* FindProp(struct DataNode* pNode, const char* propName)
+{
+    BenchDataNodeProps* pProps = (BenchDataNodeProps*)pNode->pData;
+    auto itr = pProps->find(propName);
+    return itr == pProps->end() ? NULL : &itr->second;
+}
+
+static enum DNPropValType BenchDN_GetPropType(struct DataNode* pNode, const char* propName)
+{
+    const BenchDataNodeProp* pProp = FindProp(pNode, propName);
+    return pProp ? pProp->type : DN_PROP_NOT_FOUND;
+}
+
+static float BenchDN_GetFloat(struct DataNode* pNode, const char* propName)
+{
+    const BenchDataNodeProp* pProp = FindProp(pNode, propName);
+    return pProp ? pProp->floatVal : 0.0f;
+}
+
+static int BenchDN_GetInt(struct DataNode* pNode, const char* propName)
+{
+    return (int)BenchDN_GetFloat(pNode, propName);
+}
+
+static bool BenchDN_GetBool(struct DataNode* pNode, const char* propName)
+{
+    return BenchDN_GetFloat(pNode, propName) != 0.0f;
+}
+
+static size_t BenchDN_GetStrlen(struct DataNode* pNode, const char* propName)
+{
+    const BenchDataNodeProp* pProp = FindProp(pNode, propName);
+    return pProp ? pProp->stringVal.size() : 0;
+}
+
+static void BenchDN_GetStrcpy(struct DataNode* pNode, const char* propName, char* dest)
+{
+    const BenchDataNodeProp* pProp = FindProp(pNode, propName);
+    strcpy(dest, pProp ? pProp->stringVal.c_str() : "");
+}
+
+static bool BenchDN_StrCmp(struct DataNode* pNode, const char* propName, const char* cmpTo)
+{
+    const BenchDataNodeProp* pProp = FindProp(pNode, propName);
+    return pProp && pProp->type == DN_String && pProp->stringVal == cmpTo;
+}
+
+static size_t BenchDN_GetContentStrlen(struct DataNode* pNode)
+{
+    return BenchDN_GetStrlen(pNode, "content");
+}
+
+static void BenchDN_GetContentStrcpy(struct DataNode* pNode, char* dest)
+{
+    BenchDN_GetStrcpy(pNode, "content", dest);
+}
+
+static bool BenchDN_ContentStrCmp(struct DataNode* pNode, const char* cmpTo)
+{
+    return BenchDN_StrCmp(pNode, "content", cmpTo);
+}
+
+static void InitBenchDataNode(struct DataNode* pOutNode, BenchDataNodeProps* pProps)
+{
+    pOutNode->fnGetPropType = &BenchDN_GetPropType;
+    pOutNode->fnGetFloat = &BenchDN_GetFloat;
+    pOutNode->fnGetInt = &BenchDN_GetInt;
+    pOutNode->fnGetBool = &BenchDN_GetBool;
+    pOutNode->fnGetStrlen = &BenchDN_GetStrlen;
+    pOutNode->fnGetStrcpy = &BenchDN_GetStrcpy;
+    pOutNode->fnStrCmp = &BenchDN_StrCmp;
+    pOutNode->fnGetContentStrlen = &BenchDN_GetContentStrlen;
+    pOutNode->fnGetContentStrcpy = &BenchDN_GetContentStrcpy;
+    pOutNode->fnContentStrCmp = &BenchDN_ContentStrCmp;
+    pOutNode->pData = pProps;
+}
+
+static BenchDataNodeProp StringProp(const char* val)
+{
+    return { DN_String, val, 0.0f };
+}
+
+static BenchDataNodeProp FloatProp(float val)
+{
+    return { DN_Float, "", val };
+}
+
+/* the same steps AddNodeChildren takes for each xml node */
+static HWidget AddBenchWidget(HWidget hParent, AddChildFn ctor, BenchDataNodeProps& props, XMLUIData* pUIData)
+{
+    struct DataNode node;
+    InitBenchDataNode(&node, &props);
+    HWidget hWidget = ctor(hParent, &node, pUIData);
+    UI_WidgetCommonInit(&node, UI_GetWidget(hWidget));
+    UI_AddChild(hParent, hWidget);
+    return hWidget;
+}
+
+ENGINE_BENCH(UILayout1000Widgets)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+
+    XMLUIData uiData;
+    memset(&uiData, 0, sizeof(XMLUIData));
+    uiData.atlas = atlas;
+    uiData.rootWidget = NewRootWidget();
+    RootWidget_OnWindowSizeChanged(uiData.rootWidget, BENCH_WINDOW_W, BENCH_WINDOW_H);
+
+    BenchDataNodeProps columnProps = { { "orientation", StringProp("vertical") }, { "dockPoint", StringProp("centre") } };
+    HWidget hColumn = AddBenchWidget(uiData.rootWidget, &StackPanelWidgetNew, columnProps, &uiData);
+    int numWidgets = 1;
+    for (int row = 0; row < NUM_BENCH_UI_ROWS; row++)
+    {
+        BenchDataNodeProps rowProps = { { "orientation", StringProp("horizontal") } };
+        HWidget hRow = AddBenchWidget(hColumn, &StackPanelWidgetNew, rowProps, &uiData);
+        numWidgets++;
+        for (int i = 0; i < NUM_BENCH_UI_WIDGETS_PER_ROW; i++)
+        {
+            /* varied sizes so children get aligned within their rows and the column */
+            BenchDataNodeProps staticProps = {
+                { "sprite", StringProp(BENCH_WIDGET_SPRITE_NAME) },
+                { "scaleX", FloatProp(state.RandFloat(0.25f, 1.25f)) },
+                { "scaleY", FloatProp(state.RandFloat(0.25f, 1.25f)) }
+            };
+            AddBenchWidget(hRow, &StaticWidgetNew, staticProps, &uiData);
+            numWidgets++;
+        }
+    }
+
+    struct UIWidget* pRootWidget = UI_GetWidget(uiData.rootWidget);
+    state.SetItemsPerIteration(numWidgets);
+    state.Measure([&]()
+    {
+        pRootWidget->fnLayoutChildren(pRootWidget, NULL);
+    });
+}
+
+/* a console's worth of log lines, most layout time goes on measuring text */
+#define NUM_BENCH_CONSOLE_LINES 200
+
+ENGINE_BENCH(UILayoutTextConsole)
+{
+    std::string error;
+    hAtlas atlas = BenchFixture_GetAtlas(error);
+    if (atlas == NULL_HANDLE)
+    {
+        state.Skip(error);
+        return;
+    }
+
+    XMLUIData uiData;
+    memset(&uiData, 0, sizeof(XMLUIData));
+    uiData.atlas = atlas;
+    uiData.rootWidget = NewRootWidget();
+    RootWidget_OnWindowSizeChanged(uiData.rootWidget, BENCH_WINDOW_W, BENCH_WINDOW_H);
+
+    BenchDataNodeProps consoleProps = { { "orientation", StringProp("vertical") }, { "dockPoint", StringProp("topLeft") } };
+    HWidget hConsole = AddBenchWidget(uiData.rootWidget, &StackPanelWidgetNew, consoleProps, &uiData);
+    static const char* levels[] = { "info", "warning", "error" };
+    char line[128];
+    for (int i = 0; i < NUM_BENCH_CONSOLE_LINES; i++)
+    {
+        snprintf(line, sizeof(line), "[%05i] %s: entity %i moved to (%.2f, %.2f)",
+            i, levels[state.RandInt(0, 3)], state.RandInt(0, 4096), state.RandFloat(0.0f, 1024.0f), state.RandFloat(0.0f, 1024.0f));
+        BenchDataNodeProps textProps = {
+            { "content", StringProp(line) },
+            { "font", StringProp(BENCH_FONT_NAME) },
+            { "fontSize", StringProp("16") }
+        };
+        AddBenchWidget(hConsole, &TextWidgetNew, textProps, &uiData);
+    }
+
+    struct UIWidget* pRootWidget = UI_GetWidget(uiData.rootWidget);
+    state.SetItemsPerIteration(NUM_BENCH_CONSOLE_LINES);
+    state.Measure([&]()
+    {
+        pRootWidget->fnLayoutChildren(pRootWidget, NULL);
+    });
+}
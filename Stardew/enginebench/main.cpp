@@ -0,0 +1,86 @@
+#include "Bench.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage()
+{
+    printf(
+        "usage: StardewEngineBench [options]\n"
+        "  --filter <text>        only run benchmarks whose name contains text\n"
+        "  --seed <n>             seed for generated benchmark data, default 1234\n"
+        "  --iterations <n>       timed iterations per benchmark, default 100\n"
+        "  --warmup <n>           untimed iterations before timing, default 5\n"
+        "  --out <path>           where to write the json results, default StardewEngineBench.json\n"
+        "  --compare <path>       compare medians against results saved by a previous run\n"
+        "  --threshold <percent>  slowdown that counts as a regression when comparing, default 10\n"
+        "  --list                 list benchmark names\n"
+        "run from the Stardew folder, some benchmarks load files from ./Assets\n"
+        "exits with 2 if a benchmark regressed against the --compare baseline\n");
+}
+
+static bool ParseCmdLineArgs(int argc, char** argv, BenchOptions& options, bool& bOutList)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        bool bHasValue = i + 1 < argc;
+        if (strcmp(arg, "--list") == 0)
+        {
+            bOutList = true;
+        }
+        else if (strcmp(arg, "--filter") == 0 && bHasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(arg, "--seed") == 0 && bHasValue)
+        {
+            options.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--iterations") == 0 && bHasValue)
+        {
+            options.numIterations = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--warmup") == 0 && bHasValue)
+        {
+            options.numWarmupIterations = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--out") == 0 && bHasValue)
+        {
+            options.outPath = argv[++i];
+        }
+        else if (strcmp(arg, "--compare") == 0 && bHasValue)
+        {
+            options.comparePath = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0 && bHasValue)
+        {
+            options.regressionThreshold = atof(argv[++i]) / 100.0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.numIterations > 0 && options.numWarmupIterations >= 0;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    bool bList = false;
+    if (!ParseCmdLineArgs(argc, argv, options, bList))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (bList)
+    {
+        for (const BenchRegistration& bench : Bench_GetRegisteredBenchmarks())
+        {
+            printf("%s\n", bench.name);
+        }
+        return 0;
+    }
+    return Bench_RunAll(options);
+}
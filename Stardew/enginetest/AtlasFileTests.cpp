@@ -0,0 +1,371 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "BinarySerializer.h"
+#include "NullDrawContext.h"
+#include "TestData.h"
+#include <libxml/parser.h>
+extern "C" {
+#include "Atlas.h"
+#include "ImageFileRegstry.h"
+}
+
+#define TEST_ATLAS_XML \
+    "<atlas tilesetStart=\"0\" tilesetEnd=\"1\">" \
+    "<sprite source=\"" TEST_DATA_IMAGE_PATH "\" top=\"0\" left=\"0\" width=\"16\" height=\"16\" name=\"test_tile\"/>" \
+    "<sprite source=\"" TEST_DATA_IMAGE_PATH "\" top=\"16\" left=\"0\" width=\"17\" height=\"16\" name=\"test_sprite\"/>" \
+    "<animation-frames name=\"test_animation\" fps=\"8.0\">" \
+    "<sprite source=\"" TEST_DATA_IMAGE_PATH "\" top=\"0\" left=\"16\" width=\"16\" height=\"16\" name=\"test_animation0\"/>" \
+    "<sprite source=\"" TEST_DATA_IMAGE_PATH "\" top=\"16\" left=\"16\" width=\"16\" height=\"16\" name=\"test_animation1\"/>" \
+    "</animation-frames>" \
+    "</atlas>"
+
+static DrawContext gAtlasTestDC;
+
+static hAtlas GetTestAtlas()
+{
+    static bool bAttempted = false;
+    static hAtlas atlas = NULL_HANDLE;
+    if (bAttempted)
+    {
+        return atlas;
+    }
+    bAttempted = true;
+    FILE* pFile = fopen(TEST_DATA_IMAGE_PATH, "rb");
+    if (!pFile)
+    {
+        return NULL_HANDLE;
+    }
+    fclose(pFile);
+
+    gAtlasTestDC = Dr_InitNullDrawContext();
+    At_Init();
+    IR_InitImageRegistry(TEST_DATA_REGISTRY_PATH);
+    xmlDoc* pDoc = xmlReadMemory(TEST_ATLAS_XML, (int)strlen(TEST_ATLAS_XML), NULL, NULL, 0);
+    atlas = At_LoadAtlas(xmlDocGetRootElement(pDoc), &gAtlasTestDC);
+    xmlFreeDoc(pDoc);
+    return atlas;
+}
+
+static std::vector<u8> SaveAtlas(hAtlas atlas, u32 version)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    At_SaveAtlasWithVersion(&bs, atlas, version);
+    size_t size = 0;
+    const char* pData = BS_GetSavedData(&bs, &size);
+    std::vector<u8> saved(pData, pData + size);
+    BS_Finish(&bs);
+    return saved;
+}
+
+static std::vector<u8> SaveAtlasEncoded(hAtlas atlas, enum AtlasPixelEncoding encoding)
+{
+    struct AtlasSaveOptions options;
+    options.fileVersion = 2;
+    options.pixelEncoding = encoding;
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    At_SaveAtlasEx(&bs, atlas, &options);
+    size_t size = 0;
+    const char* pData = BS_GetSavedData(&bs, &size);
+    std::vector<u8> saved(pData, pData + size);
+    BS_Finish(&bs);
+    return saved;
+}
+
+static std::string WriteTempFile(const char* name, const std::vector<u8>& data)
+{
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    FILE* pFile = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return path;
+}
+
+static u32 ReadU32(const std::vector<u8>& data, size_t offset)
+{
+    u32 val;
+    memcpy(&val, data.data() + offset, sizeof(u32));
+    return val;
+}
+
+TEST(AtlasFile, LoadsBothVersions)
+{
+    hAtlas atlas = GetTestAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't load " TEST_DATA_IMAGE_PATH;
+    std::vector<u8> v1 = SaveAtlas(atlas, 1);
+    std::vector<u8> v2 = SaveAtlas(atlas, 2);
+    ASSERT_EQ(ReadU32(v1, 0), 1u);
+    ASSERT_EQ(ReadU32(v2, 0), 2u);
+
+    /* whichever version is loaded it re-saves as the same v1 file */
+    for (u32 version = 1; version <= 2; version++)
+    {
+        std::string path = WriteTempFile(version == 1 ? "atlas_test_v1.atlas" : "atlas_test_v2.atlas", version == 1 ? v1 : v2);
+        hAtlas loaded = At_LoadAtlasFile(path.c_str(), &gAtlasTestDC);
+        ASSERT_NE(loaded, NULL_HANDLE);
+        ASSERT_EQ(SaveAtlas(loaded, 1), v1);
+        ASSERT_NE(At_FindSprite("test_sprite", loaded), NULL_HANDLE);
+        ASSERT_NE(At_FindAnim(loaded, "test_animation"), nullptr);
+        ASSERT_EQ(At_GetNumTilesetTiles(loaded), At_GetNumTilesetTiles(atlas));
+        At_DestroyAtlas(loaded, &gAtlasTestDC);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(AtlasFile, V2SectionsAreAligned)
+{
+    hAtlas atlas = GetTestAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't load " TEST_DATA_IMAGE_PATH;
+    std::vector<u8> v2 = SaveAtlas(atlas, 2);
+    u32 numSections = ReadU32(v2, 4);
+    ASSERT_GT(numSections, 0u);
+    /* 32 byte header then a 24 byte entry per section: type, num records, u64 offset, u64 size */
+    for (u32 i = 0; i < numSections; i++)
+    {
+        size_t entry = 32 + i * 24;
+        u64 offset, size;
+        memcpy(&offset, v2.data() + entry + 8, sizeof(u64));
+        memcpy(&size, v2.data() + entry + 16, sizeof(u64));
+        ASSERT_EQ(offset % 16, 0u);
+        ASSERT_LE(offset + size, v2.size());
+    }
+}
+
+TEST(AtlasFile, RejectsMalformedV2)
+{
+    hAtlas atlas = GetTestAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't load " TEST_DATA_IMAGE_PATH;
+    std::vector<u8> v2 = SaveAtlas(atlas, 2);
+
+    std::vector<u8> truncated(v2.begin(), v2.begin() + v2.size() / 2);
+    std::string path = WriteTempFile("atlas_test_truncated.atlas", truncated);
+    ASSERT_EQ(At_LoadAtlasFile(path.c_str(), &gAtlasTestDC), NULL_HANDLE);
+    std::filesystem::remove(path);
+
+    /* first section's offset past the end of the file */
+    std::vector<u8> badOffset = v2;
+    u64 offset = v2.size() + 16;
+    memcpy(badOffset.data() + 32 + 8, &offset, sizeof(u64));
+    path = WriteTempFile("atlas_test_bad_offset.atlas", badOffset);
+    ASSERT_EQ(At_LoadAtlasFile(path.c_str(), &gAtlasTestDC), NULL_HANDLE);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(At_LoadAtlasFile("./does_not_exist.atlas", &gAtlasTestDC), NULL_HANDLE);
+}
+
+TEST(AtlasFile, LoadsCompressedPixels)
+{
+    hAtlas atlas = GetTestAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't load " TEST_DATA_IMAGE_PATH;
+    std::vector<u8> v1 = SaveAtlas(atlas, 1);
+    std::vector<u8> raw = SaveAtlas(atlas, 2);
+    DrawContext noUploadBufferDC = gAtlasTestDC;
+    noUploadBufferDC.MapTextureUploadBuffer = NULL;
+    noUploadBufferDC.UploadMappedTexture = NULL;
+    for (enum AtlasPixelEncoding encoding : { APE_QOI, APE_Palette })
+    {
+        std::vector<u8> compressed = SaveAtlasEncoded(atlas, encoding);
+        ASSERT_LT(compressed.size(), raw.size());
+        std::string path = WriteTempFile("atlas_test_compressed.atlas", compressed);
+        /* decoded straight into the upload buffer, then decoded again from the mapping to save */
+        for (DrawContext* pDC : { &gAtlasTestDC, &noUploadBufferDC })
+        {
+            hAtlas loaded = At_LoadAtlasFile(path.c_str(), pDC);
+            ASSERT_NE(loaded, NULL_HANDLE);
+            ASSERT_EQ(SaveAtlas(loaded, 1), v1);
+            At_DestroyAtlas(loaded, pDC);
+        }
+        /* and from memory rather than a mapped file */
+        struct BinarySerializer bs;
+        BS_CreateForLoadFromMemory((const char*)compressed.data(), compressed.size(), &bs);
+        hAtlas loaded = NULL_HANDLE;
+        At_SerializeAtlas(&bs, &loaded, &gAtlasTestDC);
+        BS_Finish(&bs);
+        ASSERT_NE(loaded, NULL_HANDLE);
+        ASSERT_EQ(SaveAtlas(loaded, 1), v1);
+        At_DestroyAtlas(loaded, &gAtlasTestDC);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(AtlasFile, RejectsMalformedCompressedPixels)
+{
+    hAtlas atlas = GetTestAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't load " TEST_DATA_IMAGE_PATH;
+    std::vector<u8> compressed = SaveAtlasEncoded(atlas, APE_QOI);
+    /* the pixels are the last section, cutting them short still leaves a valid section table */
+    u32 numSections = ReadU32(compressed, 4);
+    size_t lastEntry = 32 + (numSections - 1) * 24;
+    u64 size;
+    memcpy(&size, compressed.data() + lastEntry + 16, sizeof(u64));
+    size /= 2;
+    memcpy(compressed.data() + lastEntry + 16, &size, sizeof(u64));
+    std::string path = WriteTempFile("atlas_test_bad_pixels.atlas", compressed);
+    ASSERT_EQ(At_LoadAtlasFile(path.c_str(), &gAtlasTestDC), NULL_HANDLE);
+    /* the upload buffer was given back, so loading still works */
+    std::vector<u8> good = SaveAtlasEncoded(atlas, APE_QOI);
+    path = WriteTempFile("atlas_test_bad_pixels.atlas", good);
+    hAtlas loaded = At_LoadAtlasFile(path.c_str(), &gAtlasTestDC);
+    ASSERT_NE(loaded, NULL_HANDLE);
+    At_DestroyAtlas(loaded, &gAtlasTestDC);
+    std::filesystem::remove(path);
+}
+
+#define TEST_DYNAMIC_FONT_PATH TEST_DATA_PATH("ComicMono.ttf")
+#define TEST_DYNAMIC_FONT_ATLAS_XML \
+    "<atlas glyphCacheWidth=\"64\" glyphCacheHeight=\"64\">" \
+    "<sprite source=\"" TEST_DATA_IMAGE_PATH "\" top=\"0\" left=\"0\" width=\"16\" height=\"16\" name=\"test_tile\"/>" \
+    "<font source=\"" TEST_DYNAMIC_FONT_PATH "\" name=\"dynamic\" dynamic=\"true\">" \
+    "<size type=\"pts\" val=\"12\"/>" \
+    "<size type=\"pts\" val=\"32\"/>" \
+    "</font>" \
+    "</atlas>"
+
+static hAtlas LoadDynamicFontAtlas()
+{
+    if (GetTestAtlas() == NULL_HANDLE)
+    {
+        return NULL_HANDLE;
+    }
+    xmlDoc* pDoc = xmlReadMemory(TEST_DYNAMIC_FONT_ATLAS_XML, (int)strlen(TEST_DYNAMIC_FONT_ATLAS_XML), NULL, NULL, 0);
+    hAtlas atlas = At_LoadAtlas(xmlDocGetRootElement(pDoc), &gAtlasTestDC);
+    xmlFreeDoc(pDoc);
+    return atlas;
+}
+
+TEST(AtlasFile, DynamicFontsRasteriseGlyphsWhenUsed)
+{
+    hAtlas atlas = LoadDynamicFontAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE);
+    struct AtlasGlyphCacheStats stats;
+    At_GetGlyphCacheStats(atlas, &stats);
+    ASSERT_EQ(stats.widthPx, 64);
+    ASSERT_EQ(stats.heightPx, 64);
+    ASSERT_EQ(stats.glyphsRasterised, 0u);
+
+    HFont small = Fo_FindFont(atlas, "dynamic", 12.0f);
+    HFont big = Fo_FindFont(atlas, "dynamic", 32.0f);
+    ASSERT_NE(small, NULL_HANDLE);
+    ASSERT_NE(big, NULL_HANDLE);
+    ASSERT_GT(Fo_GetLineHeight(atlas, big), Fo_GetLineHeight(atlas, small));
+
+    /* measuring rasterises but doesn't need room in the cache */
+    ASSERT_GT(Fo_StringWidth(atlas, small, "hello"), 0.0f);
+    At_GetGlyphCacheStats(atlas, &stats);
+    ASSERT_EQ(stats.glyphsRasterised, 4u);
+
+    AtlasSprite* pSprite = Fo_GetGlyphSprite(atlas, small, 'h');
+    ASSERT_TRUE(pSprite->bSet);
+    ASSERT_GT(pSprite->widthPx, 0);
+    AtlasSprite sprite = *pSprite;
+    int w, h;
+    At_GetAtlasTextureDims(atlas, &w, &h);
+    ASSERT_GT(sprite.bottomRightUV_U, sprite.topLeftUV_U);
+    ASSERT_LE(sprite.bottomRightUV_U, 1.0f);
+    ASSERT_LE(sprite.atlasTopLeftXPx + sprite.widthPx, w);
+
+    /* beyond latin 1 */
+    vec2 bearing;
+    float advance = 0.0f;
+    ASSERT_TRUE(Fo_TryGetGlyphAdvance(atlas, small, 0x2014 /* em dash */, &advance));
+    ASSERT_GT(advance, 0.0f);
+    ASSERT_TRUE(Fo_TryGetGlyphBearing(atlas, small, 0x2014, bearing));
+
+    /* drawing every printable ascii char at 32pt doesn't fit in 64 x 64, later frames evict earlier ones */
+    u32 generation = At_GetGlyphCacheGeneration(atlas);
+    for (int c = 33; c < 127; c++)
+    {
+        Fo_GetGlyphSprite(atlas, big, c);
+        At_SetCurrent(atlas, &gAtlasTestDC);
+    }
+    At_GetGlyphCacheStats(atlas, &stats);
+    ASSERT_GT(stats.glyphsEvicted, 0u);
+    ASSERT_GT(stats.bytesUploaded, 0u);
+    ASSERT_NE(At_GetGlyphCacheGeneration(atlas), generation);
+
+    /* an evicted glyph is rasterised again, in the same frame it can't be evicted */
+    u64 rasterised = stats.glyphsRasterised;
+    pSprite = Fo_GetGlyphSprite(atlas, big, '!');
+    ASSERT_TRUE(pSprite->bSet);
+    ASSERT_GT(pSprite->widthPx, 0);
+    At_GetGlyphCacheStats(atlas, &stats);
+    ASSERT_EQ(stats.glyphsRasterised, rasterised + 1);
+    At_DestroyAtlas(atlas, &gAtlasTestDC);
+}
+
+TEST(AtlasFile, GlyphThatMissesTheCacheIsResidentNextFrame)
+{
+    hAtlas atlas = LoadDynamicFontAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE);
+    HFont big = Fo_FindFont(atlas, "dynamic", 32.0f);
+    ASSERT_NE(big, NULL_HANDLE);
+
+    /* fill the cache in one frame with glyphs about the same height, glyphs used this frame can't be evicted so one misses */
+    const char* fill = "ABCDEFGHIKLMNOPRSTUVWXYZ0123456789";
+    int missed = 0;
+    for (const char* c = fill; *c && !missed; c++)
+    {
+        if (!Fo_GetGlyphSprite(atlas, big, *c)->bSet)
+        {
+            missed = *c;
+        }
+    }
+    ASSERT_NE(missed, 0);
+
+    /* as XMLUIGameLayer does, the generation is read after outputting the frame's vertices */
+    u32 generation = At_GetGlyphCacheGeneration(atlas);
+    At_SetCurrent(atlas, &gAtlasTestDC);
+    ASSERT_NE(At_GetGlyphCacheGeneration(atlas), generation);
+
+    /* so the next frame outputs the vertices again, and the glyph evicts last frames */
+    AtlasSprite* pSprite = Fo_GetGlyphSprite(atlas, big, missed);
+    ASSERT_TRUE(pSprite->bSet);
+    ASSERT_GT(pSprite->widthPx, 0);
+    At_SetCurrent(atlas, &gAtlasTestDC);
+
+    /* resident, drawing it again doesn't need another frame */
+    generation = At_GetGlyphCacheGeneration(atlas);
+    ASSERT_TRUE(Fo_GetGlyphSprite(atlas, big, missed)->bSet);
+    At_SetCurrent(atlas, &gAtlasTestDC);
+    ASSERT_EQ(At_GetGlyphCacheGeneration(atlas), generation);
+    At_DestroyAtlas(atlas, &gAtlasTestDC);
+}
+
+TEST(AtlasFile, DynamicFontsSurviveV2)
+{
+    hAtlas atlas = LoadDynamicFontAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE);
+    std::vector<u8> v2 = SaveAtlas(atlas, 2);
+    std::string path = WriteTempFile("atlas_test_dynamic.atlas", v2);
+    hAtlas loaded = At_LoadAtlasFile(path.c_str(), &gAtlasTestDC);
+    ASSERT_NE(loaded, NULL_HANDLE);
+    ASSERT_EQ(SaveAtlas(loaded, 2), v2);
+
+    HFont font = Fo_FindFont(loaded, "dynamic", 32.0f);
+    ASSERT_NE(font, NULL_HANDLE);
+    ASSERT_EQ(Fo_StringWidth(loaded, font, "abc"), Fo_StringWidth(atlas, Fo_FindFont(atlas, "dynamic", 32.0f), "abc"));
+    struct AtlasGlyphCacheStats stats;
+    At_GetGlyphCacheStats(loaded, &stats);
+    ASSERT_EQ(stats.widthPx, 64);
+    ASSERT_TRUE(Fo_GetGlyphSprite(loaded, font, 'a')->bSet);
+
+    /* version 1 can't store them */
+    hAtlas loadedV1 = NULL_HANDLE;
+    std::vector<u8> v1 = SaveAtlas(atlas, 1);
+    struct BinarySerializer bs;
+    BS_CreateForLoadFromMemory((const char*)v1.data(), v1.size(), &bs);
+    At_SerializeAtlas(&bs, &loadedV1, &gAtlasTestDC);
+    BS_Finish(&bs);
+    ASSERT_NE(loadedV1, NULL_HANDLE);
+    ASSERT_EQ(Fo_FindFont(loadedV1, "dynamic", 32.0f), NULL_HANDLE);
+
+    At_DestroyAtlas(loadedV1, &gAtlasTestDC);
+    At_DestroyAtlas(loaded, &gAtlasTestDC);
+    At_DestroyAtlas(atlas, &gAtlasTestDC);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "AtlasPacker.h"
+#include <cstdlib>
+#include <vector>
+
+static bool Overlaps(const AtlasPackerRect& a, const AtlasPackerRect& b)
+{
+    return a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+}
+
+static void ExpectValidPacking(const std::vector<AtlasPackerRect>& rects, int w, int h)
+{
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        ASSERT_GE(rects[i].x, 0);
+        ASSERT_GE(rects[i].y, 0);
+        ASSERT_LE(rects[i].x + rects[i].w, w);
+        ASSERT_LE(rects[i].y + rects[i].h, h);
+        for (size_t j = i + 1; j < rects.size(); j++)
+        {
+            ASSERT_FALSE(Overlaps(rects[i], rects[j])) << "rects " << i << " and " << j << " overlap";
+        }
+    }
+}
+
+static std::vector<AtlasPackerRect> RandomRects(int num, int maxSide)
+{
+    std::vector<AtlasPackerRect> rects(num);
+    for (AtlasPackerRect& r : rects)
+    {
+        r.w = 1 + rand() % maxSide;
+        r.h = 1 + rand() % maxSide;
+        r.x = r.y = -1;
+    }
+    return rects;
+}
+
+TEST(AtlasPacker, PacksWithoutOverlapping)
+{
+    for (int packer = 0; packer < APT_NumPackerTypes; packer++)
+    {
+        srand(1234);
+        std::vector<AtlasPackerRect> rects = RandomRects(150, 40);
+        int w = 64, h = 64;
+        AtlasPackStats stats;
+        AtP_Pack((AtlasPackerType)packer, rects.data(), (int)rects.size(), &w, &h, &stats);
+        SCOPED_TRACE(AtP_PackerName((AtlasPackerType)packer));
+        ExpectValidPacking(rects, w, h);
+        ASSERT_EQ(stats.packer, packer);
+        ASSERT_EQ(stats.width, w);
+        ASSERT_EQ(stats.height, h);
+        ASSERT_GT(stats.occupancyPercent, 0.0f);
+        ASSERT_LE(stats.occupancyPercent, 100.0f);
+    }
+}
+
+TEST(AtlasPacker, GrowsToFitLargeRect)
+{
+    for (int packer = 0; packer < APT_NumPackerTypes; packer++)
+    {
+        std::vector<AtlasPackerRect> rects = { { 100, 30, 0, 0 }, { 10, 10, 0, 0 } };
+        int w = 32, h = 32;
+        AtP_Pack((AtlasPackerType)packer, rects.data(), (int)rects.size(), &w, &h, NULL);
+        SCOPED_TRACE(AtP_PackerName((AtlasPackerType)packer));
+        ASSERT_EQ(w, 128);
+        ASSERT_EQ(h, 64);
+        ExpectValidPacking(rects, w, h);
+    }
+}
+
+TEST(AtlasPacker, FillsBinWithEqualSquares)
+{
+    /* 64 16x16 squares exactly fill 128x128 */
+    for (int packer = APT_MaxRectsBSSF; packer < APT_NumPackerTypes; packer++)
+    {
+        std::vector<AtlasPackerRect> rects(64, AtlasPackerRect{ 16, 16, 0, 0 });
+        int w = 128, h = 128;
+        AtlasPackStats stats;
+        AtP_Pack((AtlasPackerType)packer, rects.data(), (int)rects.size(), &w, &h, &stats);
+        SCOPED_TRACE(AtP_PackerName((AtlasPackerType)packer));
+        ASSERT_EQ(w, 128);
+        ASSERT_EQ(h, 128);
+        ASSERT_FLOAT_EQ(stats.occupancyPercent, 100.0f);
+        ExpectValidPacking(rects, w, h);
+    }
+}
+
+TEST(AtlasPacker, PackerNamesRoundTrip)
+{
+    for (int packer = 0; packer < APT_NumPackerTypes; packer++)
+    {
+        AtlasPackerType parsed;
+        ASSERT_TRUE(AtP_PackerFromName(AtP_PackerName((AtlasPackerType)packer), &parsed));
+        ASSERT_EQ(parsed, packer);
+    }
+    AtlasPackerType parsed;
+    ASSERT_FALSE(AtP_PackerFromName("guillotine", &parsed));
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "BinarySerializer.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static std::vector<char> SavedData(struct BinarySerializer* pBS)
+{
+    size_t size = 0;
+    const char* pData = BS_GetSavedData(pBS, &size);
+    return std::vector<char>(pData, pData + size);
+}
+
+TEST(BinarySerializer, ScalarsRoundTrip)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    BS_SerializeI64(-1234567890123ll, &bs);
+    BS_SerializeU64(0xfedcba9876543210ull, &bs);
+    BS_SerializeI32(-42, &bs);
+    BS_SerializeU32(0xdeadbeef, &bs);
+    BS_SerializeI16(-7, &bs);
+    BS_SerializeU16(0xbeef, &bs);
+    BS_SerializeI8(-3, &bs);
+    BS_SerializeU8(200, &bs);
+    BS_SerializeBool(true, &bs);
+    BS_SerializeFloat(3.5f, &bs);
+    BS_SerializeDouble(-0.1, &bs);
+    BS_SerializeString("hello", &bs);
+    std::vector<char> saved = SavedData(&bs);
+    ASSERT_EQ(saved.size(), 8 + 8 + 4 + 4 + 2 + 2 + 1 + 1 + 1 + 4 + 8 + 4 + 5);
+    ASSERT_TRUE(BS_Finish(&bs));
+
+    BS_CreateForLoadFromMemory(saved.data(), saved.size(), &bs);
+    i64 i64Val; u64 u64Val; i32 i32Val; u32 u32Val; i16 i16Val; u16 u16Val; i8 i8Val; u8 u8Val;
+    bool boolVal; float floatVal; double doubleVal; char* str = nullptr;
+    BS_DeSerializeI64(&i64Val, &bs);
+    BS_DeSerializeU64(&u64Val, &bs);
+    BS_DeSerializeI32(&i32Val, &bs);
+    BS_DeSerializeU32(&u32Val, &bs);
+    BS_DeSerializeI16(&i16Val, &bs);
+    BS_DeSerializeU16(&u16Val, &bs);
+    BS_DeSerializeI8(&i8Val, &bs);
+    BS_DeSerializeU8(&u8Val, &bs);
+    BS_DeSerializeBool(&boolVal, &bs);
+    BS_DeSerializeFloat(&floatVal, &bs);
+    BS_DeSerializeDouble(&doubleVal, &bs);
+    BS_DeSerializeString(&str, &bs);
+    ASSERT_EQ(i64Val, -1234567890123ll);
+    ASSERT_EQ(u64Val, 0xfedcba9876543210ull);
+    ASSERT_EQ(i32Val, -42);
+    ASSERT_EQ(u32Val, 0xdeadbeef);
+    ASSERT_EQ(i16Val, -7);
+    ASSERT_EQ(u16Val, 0xbeef);
+    ASSERT_EQ(i8Val, -3);
+    ASSERT_EQ(u8Val, 200);
+    ASSERT_TRUE(boolVal);
+    ASSERT_EQ(floatVal, 3.5f);
+    ASSERT_EQ(doubleVal, -0.1);
+    ASSERT_STREQ(str, "hello");
+    ASSERT_EQ(BS_BytesRemaining(&bs), 0);
+    free(str);
+    ASSERT_TRUE(BS_Finish(&bs));
+}
+
+TEST(BinarySerializer, StoredLittleEndian)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    BS_SerializeU32(0x04030201, &bs);
+    BS_SerializeU16(0x0605, &bs);
+    u16 tiles[2] = { 0x0807, 0x0a09 };
+    BS_SerializeU16Array(tiles, 2, &bs);
+    BS_SerializeFloat(1.0f, &bs); // 0x3f800000
+    std::vector<char> saved = SavedData(&bs);
+    BS_Finish(&bs);
+
+    const unsigned char expected[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0x00, 0x00, 0x80, 0x3f };
+    ASSERT_EQ(saved.size(), sizeof(expected));
+    ASSERT_EQ(memcmp(saved.data(), expected, sizeof(expected)), 0);
+}
+
+TEST(BinarySerializer, UnalignedReads)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    BS_SerializeU8(1, &bs);
+    BS_SerializeU32(0x12345678, &bs);
+    float floats[3] = { 1.0f, -2.5f, 1e10f };
+    BS_SerializeF32Array(floats, 3, &bs);
+    std::vector<char> saved = SavedData(&bs);
+    BS_Finish(&bs);
+
+    /* offset by one so none of the values are aligned */
+    std::vector<char> shifted(saved.size() + 1);
+    memcpy(shifted.data() + 1, saved.data(), saved.size());
+    BS_CreateForLoadFromMemory(shifted.data() + 1, saved.size(), &bs);
+    u8 u8Val; u32 u32Val; float loaded[3];
+    BS_DeSerializeU8(&u8Val, &bs);
+    BS_DeSerializeU32(&u32Val, &bs);
+    BS_DeSerializeF32Array(loaded, 3, &bs);
+    ASSERT_EQ(u32Val, 0x12345678);
+    ASSERT_EQ(memcmp(loaded, floats, sizeof(floats)), 0);
+    ASSERT_TRUE(BS_Finish(&bs));
+}
+
+TEST(BinarySerializer, StreamsToFileInChunks)
+{
+    const char* path = "BinarySerializerTest.bin";
+    std::vector<u16> tiles(BS_STREAM_CHUNK_SIZE); // twice the chunk size in bytes
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        tiles[i] = (u16)(i * 31);
+    }
+
+    struct BinarySerializer bs;
+    BS_CreateForSave(path, &bs);
+    for (u32 i = 0; i < 20000; i++)
+    {
+        BS_SerializeU32(i, &bs);
+    }
+    /* only a chunk is buffered at a time */
+    ASSERT_LE(bs.dataSize, BS_STREAM_CHUNK_SIZE);
+    BS_SerializeU16Array(tiles.data(), tiles.size(), &bs);
+    BS_SerializeString("end", &bs);
+    ASSERT_EQ(bs.totalBytesWritten, 20000 * 4 + tiles.size() * 2 + 4 + 3);
+    ASSERT_TRUE(BS_Finish(&bs));
+
+    BS_CreateForLoad(path, &bs);
+    ASSERT_EQ(bs.dataSize, 20000 * 4 + tiles.size() * 2 + 4 + 3);
+    for (u32 i = 0; i < 20000; i++)
+    {
+        u32 val = 0;
+        BS_DeSerializeU32(&val, &bs);
+        ASSERT_EQ(val, i);
+    }
+    std::vector<u16> loaded(tiles.size());
+    BS_DeSerializeU16Array(loaded.data(), loaded.size(), &bs);
+    ASSERT_EQ(loaded, tiles);
+    char end[8];
+    BS_DeSerializeStringInto(end, &bs);
+    ASSERT_STREQ(end, "end");
+    ASSERT_TRUE(BS_Finish(&bs));
+    remove(path);
+}
+
+TEST(BinarySerializer, FailedOpenDoesntBufferTheSave)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSave("./no_such_directory/BinarySerializerTest.bin", &bs);
+    ASSERT_TRUE(bs.bError);
+    for (u32 i = 0; i < 20000; i++)
+    {
+        BS_SerializeU32(i, &bs);
+    }
+    ASSERT_EQ(bs.dataSize, 0);
+    ASSERT_LE(bs.capacity, BS_STREAM_CHUNK_SIZE);
+    ASSERT_FALSE(BS_Finish(&bs));
+}
+
+TEST(BinarySerializer, ReadPastEndIsAnError)
+{
+    const char data[] = { 1, 0, 0 };
+    struct BinarySerializer bs;
+    BS_CreateForLoadFromMemory(data, sizeof(data), &bs);
+    u16 u16Val = 0;
+    BS_DeSerializeU16(&u16Val, &bs);
+    ASSERT_EQ(u16Val, 1);
+    ASSERT_FALSE(bs.bError);
+
+    u32 u32Val = 123;
+    BS_DeSerializeU32(&u32Val, &bs);
+    ASSERT_EQ(u32Val, 0);
+    ASSERT_TRUE(bs.bError);
+
+    u16 tiles[4] = { 1, 1, 1, 1 };
+    BS_DeSerializeU16Array(tiles, 4, &bs);
+    ASSERT_EQ(tiles[0], 0);
+    ASSERT_FALSE(BS_Finish(&bs));
+
+    /* a string length longer than the data */
+    const char badString[] = { 100, 0, 0, 0, 'a' };
+    BS_CreateForLoadFromMemory(badString, sizeof(badString), &bs);
+    char* str = nullptr;
+    BS_DeSerializeString(&str, &bs);
+    ASSERT_STREQ(str, "");
+    free(str);
+    ASSERT_FALSE(BS_Finish(&bs));
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "Game2DEntityFixture.h"
+extern "C" {
+#include "Components.h"
+}
+
+/* a Game2D layers entity collection, without the rest of the layer */
+class ComponentStoreTest : public ::testing::Test, protected Game2DEntityFixture
+{
+protected:
+    void SetUp() override
+    {
+        InitEntities(true);
+    }
+
+    void TearDown() override
+    {
+        DestroyEntities();
+    }
+
+    struct ComponentStore* Store()
+    {
+        return &layerData.entities.componentStore;
+    }
+};
+
+static void AddSprite(struct Entity2D* pEnt, hSprite sprite)
+{
+    struct Component2D* pComponent = &pEnt->components[pEnt->numComponents++];
+    pComponent->type = ETE_Sprite;
+    pComponent->data.sprite.sprite = sprite;
+    pComponent->data.sprite.transform.scale[0] = 1.0f;
+    pComponent->data.sprite.transform.scale[1] = 1.0f;
+}
+
+static hSprite gAnimationFrames[] = { 0, 1, 2, 3 };
+
+static void AddAnimatedSprite(struct Entity2D* pEnt)
+{
+    struct Component2D* pComponent = &pEnt->components[pEnt->numComponents++];
+    pComponent->type = ETE_SpriteAnimator;
+    pComponent->data.spriteAnimator.pSprites = gAnimationFrames;
+    pComponent->data.spriteAnimator.numSprites = 4;
+    pComponent->data.spriteAnimator.fps = 10.0f;
+    pComponent->data.spriteAnimator.bRepeat = true;
+    pComponent->data.spriteAnimator.bIsAnimating = true;
+}
+
+static void CustomUpdate(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, float deltaT)
+{
+    Entity2DUpdate(pEnt, pLayer, deltaT);
+}
+
+TEST_F(ComponentStoreTest, OnlyEntitiesWithDefaultUpdateAndDrawAreStored)
+{
+    struct Entity2D ent;
+    InitEntity(&ent);
+    AddSprite(&ent, 10);
+    AddSprite(&ent, 11);
+    struct Component2D* pCollider = &ent.components[ent.numComponents++];
+    pCollider->type = ETE_StaticCollider;
+    pCollider->data.staticCollider.shape.type = PBT_Circle;
+    pCollider->data.staticCollider.shape.data.circle.radius = 6.0f;
+    HEntity2D hStored = Et2D_AddEntity(&layerData.entities, &ent);
+
+    InitEntity(&ent);
+    AddSprite(&ent, 12);
+    ent.update = &CustomUpdate;
+    HEntity2D hInline = Et2D_AddEntity(&layerData.entities, &ent);
+
+    struct Entity2D* pStored = Et2D_GetEntity(&layerData.entities, hStored);
+    struct Entity2D* pInline = Et2D_GetEntity(&layerData.entities, hInline);
+    ASSERT_TRUE(pStored->bComponentsInStore);
+    ASSERT_FALSE(pInline->bComponentsInStore);
+    ASSERT_EQ(VectorSize(Store()->pComponents[ETE_Sprite]), 2u);
+    ASSERT_EQ(VectorSize(Store()->pComponents[ETE_StaticCollider]), 1u);
+
+    ASSERT_EQ(Co_GetSprite(&layerData.entities, pStored, 0)->sprite, 10);
+    ASSERT_EQ(Co_GetSprite(&layerData.entities, pStored, 1)->sprite, 11);
+    ASSERT_EQ(Co_GetStaticCollider(&layerData.entities, pStored, 2)->shape.data.circle.radius, 6.0f);
+    ASSERT_EQ(Co_GetSprite(&layerData.entities, pInline, 0), &pInline->components[0].data.sprite);
+    ASSERT_EQ(Co_GetSprite(&layerData.entities, pInline, 0)->sprite, 12);
+}
+
+TEST_F(ComponentStoreTest, DestroyingAnEntityKeepsTheOthersComponents)
+{
+    HEntity2D hEnts[4];
+    for (int i = 0; i < 4; i++)
+    {
+        struct Entity2D ent;
+        InitEntity(&ent);
+        AddSprite(&ent, i * 2);
+        AddSprite(&ent, i * 2 + 1);
+        hEnts[i] = Et2D_AddEntity(&layerData.entities, &ent);
+    }
+    Et2D_DestroyEntity(&layer, &layerData.entities, hEnts[0]);
+    Et2D_DestroyEntity(&layer, &layerData.entities, hEnts[2]);
+
+    ASSERT_EQ(VectorSize(Store()->pComponents[ETE_Sprite]), 4u);
+    for (int i : { 1, 3 })
+    {
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnts[i]);
+        ASSERT_EQ(Co_GetSprite(&layerData.entities, pEnt, 0)->sprite, i * 2);
+        ASSERT_EQ(Co_GetSprite(&layerData.entities, pEnt, 1)->sprite, i * 2 + 1);
+    }
+    ASSERT_EQ(layerData.entities.gEntityListHead, hEnts[1]);
+    ASSERT_EQ(layerData.entities.gEntityListTail, hEnts[3]);
+}
+
+TEST_F(ComponentStoreTest, StoredAnimatedSpritesAreUpdatedOnce)
+{
+    struct Entity2D ent;
+    InitEntity(&ent);
+    AddAnimatedSprite(&ent);
+    HEntity2D hStored = Et2D_AddEntity(&layerData.entities, &ent);
+    ent.update = &CustomUpdate;
+    HEntity2D hInline = Et2D_AddEntity(&layerData.entities, &ent);
+
+    /* what the Game2D layer does each frame */
+    Co_UpdateComponentStore(&layerData.entities, &layer, 0.11f);
+    for (HEntity2D hEnt : { hStored, hInline })
+    {
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+        pEnt->update(pEnt, &layer, 0.11f);
+    }
+
+    for (HEntity2D hEnt : { hStored, hInline })
+    {
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+        ASSERT_EQ(Co_GetAnimatedSprite(&layerData.entities, pEnt, 0)->onSprite, 1);
+    }
+}
+
+static bool CountEntity(struct Entity2D* pEnt, int i, void* pUser)
+{
+    (*(int*)pUser)++;
+    return true;
+}
+
+TEST_F(ComponentStoreTest, IterateActiveEntitiesSkipsEntitiesTheStoreUpdates)
+{
+    struct Entity2D ent;
+    InitEntity(&ent);
+    AddSprite(&ent, 1);
+    HEntity2D hPassive = Et2D_AddEntity(&layerData.entities, &ent);
+    ent.input = &Entity2DInput;
+    ent.postPhys = [](struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, float deltaT) {};
+    Et2D_AddEntity(&layerData.entities, &ent);
+    InitEntity(&ent);
+    ent.update = &CustomUpdate;
+    HEntity2D hCustom = Et2D_AddEntity(&layerData.entities, &ent);
+
+    int numActive = 0;
+    Et2D_IterateActiveEntities(&layerData.entities, &CountEntity, &numActive);
+    ASSERT_EQ(numActive, 2);
+
+    Et2D_DestroyEntity(&layer, &layerData.entities, hCustom);
+    Et2D_DestroyEntity(&layer, &layerData.entities, hPassive);
+    numActive = 0;
+    Et2D_IterateActiveEntities(&layerData.entities, &CountEntity, &numActive);
+    ASSERT_EQ(numActive, 1);
+}
+
+TEST_F(ComponentStoreTest, GatheredEntityHasItsComponentsInline)
+{
+    struct Entity2D ent;
+    InitEntity(&ent);
+    AddSprite(&ent, 5);
+    AddAnimatedSprite(&ent);
+    HEntity2D hEnt = Et2D_AddEntity(&layerData.entities, &ent);
+    struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+    Co_GetSprite(&layerData.entities, pEnt, 0)->sprite = 6;
+    Co_GetAnimatedSprite(&layerData.entities, pEnt, 1)->onSprite = 3;
+
+    struct Entity2D gathered;
+    Co_GatherComponents(&layerData.entities, pEnt, &gathered);
+    ASSERT_FALSE(gathered.bComponentsInStore);
+    ASSERT_EQ(gathered.components[0].data.sprite.sprite, 6);
+    ASSERT_EQ(gathered.components[1].data.spriteAnimator.onSprite, 3);
+    ASSERT_EQ(gathered.thisEntity, hEnt);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "DynArray.h"
+#include <chrono>
+#include <cstdio>
 
 TEST(Vector, VectorPush)
 {
@@ -107,7 +109,7 @@ TEST(Vector, VectorInit)
     VECTOR(char) test = NEW_VECTOR(char);
 
     VectorData* vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 1);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
     ASSERT_EQ(vd->size, 0);
     ASSERT_EQ(vd->itemSize, sizeof(char));
 
@@ -115,14 +117,14 @@ TEST(Vector, VectorInit)
     VECTOR(short) test2 = NEW_VECTOR(short);
 
     vd = VectorData_DEBUG(test2);
-    ASSERT_EQ(vd->capacity, 1);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
     ASSERT_EQ(vd->size, 0);
     ASSERT_EQ(vd->itemSize, sizeof(short));
 
     VECTOR(double) test3 = NEW_VECTOR(double);
 
     vd = VectorData_DEBUG(test3);
-    ASSERT_EQ(vd->capacity, 1);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
     ASSERT_EQ(vd->size, 0);
     ASSERT_EQ(vd->itemSize, sizeof(double));
 
@@ -136,66 +138,155 @@ TEST(Vector, VectorCapacityDoublesWhenFull)
     VECTOR(char) test = NEW_VECTOR(char);
     VectorData* vd = VectorData_DEBUG(test);
 
-    ASSERT_EQ(vd->capacity, 1);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
     char val = 'j';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 1);
+    for(int i=0; i<VECTOR_INITIAL_CAPACITY; i++)
+    {
+        test = (char*)VectorPush(test, &val);
+        vd = VectorData_DEBUG(test);
+        ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
+    }
 
-    val = 'i';
     test = (char*)VectorPush(test, &val);
     vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 2);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY * 2);
 
-    val = 'm';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 4);
+    for(int i=0; i<VECTOR_INITIAL_CAPACITY - 1; i++)
+    {
+        test = (char*)VectorPush(test, &val);
+        vd = VectorData_DEBUG(test);
+        ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY * 2);
+    }
 
-    val = 'M';
     test = (char*)VectorPush(test, &val);
     vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 4);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY * 4);
 
-    val = 'M';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 8);
+    DestoryVector(test);
+}
 
-    val = 'a';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 8);
+TEST(Vector, VectorPushN)
+{
+    VECTOR(int) test = NEW_VECTOR(int);
+    int values[100];
+    for(int i=0; i<100; i++)
+    {
+        values[i] = i;
+    }
+    test = (int*)VectorPushN(test, values, 3);
+    test = (int*)VectorPushN(test, values + 3, 97);
+    ASSERT_EQ(VectorSize(test), 100);
+    for(int i=0; i<100; i++)
+    {
+        ASSERT_EQ(test[i], i);
+    }
+    DestoryVector(test);
+}
 
-    val = 'r';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 8);
+TEST(Vector, VectorEmplaceN)
+{
+    VECTOR(int) test = NEW_VECTOR(int);
+    int first = 7;
+    test = (int*)VectorPush(test, &first);
+    int* pSlots = nullptr;
+    test = (int*)VectorEmplaceN(test, 50, (void**)&pSlots);
+    ASSERT_EQ(VectorSize(test), 51);
+    ASSERT_EQ(pSlots, test + 1);
+    for(int i=0; i<50; i++)
+    {
+        pSlots[i] = i * 2;
+    }
+    ASSERT_EQ(test[0], 7);
+    ASSERT_EQ(test[50], 98);
+    DestoryVector(test);
+}
 
-    val = 's';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 8);
+TEST(Vector, VectorReserve)
+{
+    VECTOR(int) test = NEW_VECTOR(int);
+    int val = 3;
+    test = (int*)VectorPush(test, &val);
 
-    val = 'h';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 16);
+    test = (int*)VectorReserve(test, 4);
+    VectorData* vd = VectorData_DEBUG(test);
+    ASSERT_EQ(vd->capacity, VECTOR_INITIAL_CAPACITY);
 
-    val = 'a';
-    test = (char*)VectorPush(test, &val);
+    /* grows geometrically, never to less than was asked for */
+    test = (int*)VectorReserve(test, 100);
     vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 16);
+    ASSERT_EQ(vd->capacity, 128);
+    ASSERT_EQ(vd->size, 1);
+    ASSERT_EQ(test[0], 3);
 
-    val = 'l';
-    test = (char*)VectorPush(test, &val);
+    test = (int*)VectorReserve(test, 129);
     vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 16);
+    ASSERT_EQ(vd->capacity, 256);
+    DestoryVector(test);
+}
 
-    val = 'l';
-    test = (char*)VectorPush(test, &val);
-    vd = VectorData_DEBUG(test);
-    ASSERT_EQ(vd->capacity, 16);
+/*
+    Not a correctness test - 1M vertices pushed as quads (4 verts + 6 indices),
+    one item at a time versus VectorEmplaceN/VectorPushN.
+*/
+struct BenchVert
+{
+    float x, y, u, v;
+};
 
-    DestoryVector(test);
-}
\ No newline at end of file
+TEST(Vector, QuadPushBenchmark)
+{
+    const int numQuads = 250000;
+    const int numRuns = 5;
+    double singleMs = 0.0;
+    double bulkMs = 0.0;
+    for(int run=0; run<numRuns; run++)
+    {
+        VECTOR(BenchVert) verts = NEW_VECTOR(BenchVert);
+        VECTOR(unsigned int) inds = NEW_VECTOR(unsigned int);
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int q=0; q<numQuads; q++)
+        {
+            unsigned int base = q * 4;
+            for(int v=0; v<4; v++)
+            {
+                BenchVert vert = { (float)q, (float)v, 0.0f, 1.0f };
+                verts = (BenchVert*)VectorPush(verts, &vert);
+            }
+            const unsigned int quadInds[6] = { base, base + 1, base + 2, base + 1, base + 3, base + 2 };
+            for(int i=0; i<6; i++)
+            {
+                inds = (unsigned int*)VectorPush(inds, (void*)&quadInds[i]);
+            }
+        }
+        auto mid = std::chrono::high_resolution_clock::now();
+        DestoryVector(verts);
+        DestoryVector(inds);
+
+        verts = NEW_VECTOR(BenchVert);
+        inds = NEW_VECTOR(unsigned int);
+        auto bulkStart = std::chrono::high_resolution_clock::now();
+        for(int q=0; q<numQuads; q++)
+        {
+            unsigned int base = q * 4;
+            BenchVert* pVerts = nullptr;
+            verts = (BenchVert*)VectorEmplaceN(verts, 4, (void**)&pVerts);
+            for(int v=0; v<4; v++)
+            {
+                pVerts[v] = { (float)q, (float)v, 0.0f, 1.0f };
+            }
+            const unsigned int quadInds[6] = { base, base + 1, base + 2, base + 1, base + 3, base + 2 };
+            inds = (unsigned int*)VectorPushN(inds, quadInds, 6);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        EXPECT_EQ(VectorSize(verts), numQuads * 4);
+        EXPECT_EQ(VectorSize(inds), numQuads * 6);
+        DestoryVector(verts);
+        DestoryVector(inds);
+
+        singleMs += std::chrono::duration<double, std::milli>(mid - start).count();
+        bulkMs += std::chrono::duration<double, std::milli>(end - bulkStart).count();
+    }
+    printf("%i vertices pushed as quads, mean of %i runs:\n", numQuads * 4, numRuns);
+    printf("    VectorPush per item:        %.2f ms\n", singleMs / numRuns);
+    printf("    VectorEmplaceN/VectorPushN: %.2f ms\n", bulkMs / numRuns);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "Game2DEntityFixture.h"
+extern "C" {
+#include "AnimatedSprite.h"
+}
+
+static int gNumGetBBCalls = 0;
+
+static void CountingGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+{
+    gNumGetBBCalls++;
+    Game2DEntityFixture::SquareGetBoundingBox(pEnt, pLayer, outTL, outBR);
+}
+
+/* a Game2D layers entities and quadtree, without the rest of the layer */
+class EntityBoundingBoxTest : public ::testing::Test, protected Game2DEntityFixture
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        InitQuadtreeSystem();
+    }
+
+    void SetUp() override
+    {
+        gNumGetBBCalls = 0;
+        InitEntities();
+        struct Entity2DQuadTreeInitArgs args = { 0, 0, 1024, 1024 };
+        layerData.hEntitiesQuadTree = GetEntity2DQuadTree(&args);
+    }
+
+    void TearDown() override
+    {
+        DestroyEntities();
+        DestroyEntity2DQuadTree(layerData.hEntitiesQuadTree);
+    }
+
+    struct Entity2D* AddEntity(float x, float y)
+    {
+        HEntity2D hEnt = Game2DEntityFixture::AddEntity(x, y, &CountingGetBoundingBox);
+        return Et2D_GetEntity(&layerData.entities, hEnt);
+    }
+
+    int NumCulled(float x, float y, float w, float h)
+    {
+        vec2 tl = { x, y };
+        vec2 br = { x + w, y + h };
+        VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+        pFound = Game2DLayer_CullEntities(&layerData, tl, br, pFound);
+        int numFound = VectorSize(pFound);
+        DestoryVector(pFound);
+        return numFound;
+    }
+};
+
+TEST_F(EntityBoundingBoxTest, BoundingBoxIsOnlyRecalculatedWhenDirty)
+{
+    struct Entity2D* pEnt = AddEntity(100.0f, 200.0f);
+    ASSERT_TRUE(pEnt->bBBDirty);
+
+    vec2 tl, br;
+    for (int i = 0; i < 3; i++)
+    {
+        Et2D_GetBoundingBox(pEnt, &layer, tl, br);
+    }
+    ASSERT_EQ(gNumGetBBCalls, 1);
+    ASSERT_EQ(tl[0], 100.0f);
+    ASSERT_EQ(br[1], 216.0f);
+
+    pEnt->transform.position[0] = 300.0f;
+    Et2D_GetBoundingBox(pEnt, &layer, tl, br);
+    ASSERT_EQ(tl[0], 100.0f);
+
+    Et2D_MarkBoundingBoxDirty(pEnt);
+    Et2D_GetBoundingBox(pEnt, &layer, tl, br);
+    ASSERT_EQ(gNumGetBBCalls, 2);
+    ASSERT_EQ(tl[0], 300.0f);
+    ASSERT_EQ(br[0], 316.0f);
+}
+
+TEST_F(EntityBoundingBoxTest, CullingReadsTheCachedBoundingBoxes)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        struct Entity2D* pEnt = AddEntity(i * 64.0f, 0.0f);
+        pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&layerData.entities, layerData.hEntitiesQuadTree, pEnt->thisEntity, &layer);
+    }
+    struct Entity2D* pDynamic = AddEntity(0.0f, 512.0f);
+    pDynamic->hDynamicListRef = DynL_AddEntity(&layerData.entities.dynamicEntities, pDynamic->thisEntity);
+    ASSERT_EQ(gNumGetBBCalls, 8);
+
+    ASSERT_EQ(NumCulled(0.0f, 0.0f, 1024.0f, 1024.0f), 9);
+    ASSERT_EQ(NumCulled(0.0f, 0.0f, 100.0f, 100.0f), 2);
+    ASSERT_EQ(NumCulled(0.0f, 500.0f, 100.0f, 100.0f), 1);
+    /* only the dynamic entity hadn't been queried yet */
+    ASSERT_EQ(gNumGetBBCalls, 9);
+
+    pDynamic->transform.position[0] = 600.0f;
+    Et2D_MarkBoundingBoxDirty(pDynamic);
+    ASSERT_EQ(NumCulled(0.0f, 500.0f, 100.0f, 100.0f), 0);
+    ASSERT_EQ(NumCulled(600.0f, 500.0f, 100.0f, 100.0f), 1);
+    ASSERT_EQ(gNumGetBBCalls, 10);
+}
+
+TEST_F(EntityBoundingBoxTest, AnimationFrameChangesMarkTheBoundingBoxDirty)
+{
+    static hSprite frames[] = { 0, 1 };
+    struct Entity2D* pEnt = AddEntity(0.0f, 0.0f);
+    struct AnimatedSprite sprite;
+    memset(&sprite, 0, sizeof(struct AnimatedSprite));
+    sprite.pSprites = frames;
+    sprite.numSprites = 2;
+    sprite.fps = 10.0f;
+    sprite.bRepeat = true;
+    sprite.bIsAnimating = true;
+
+    vec2 tl, br;
+    Et2D_GetBoundingBox(pEnt, &layer, tl, br);
+    AnimatedSprite_OnUpdate(&sprite, pEnt, &layer, 0.05f);
+    ASSERT_FALSE(pEnt->bBBDirty);
+    AnimatedSprite_OnUpdate(&sprite, pEnt, &layer, 0.05f);
+    ASSERT_EQ(sprite.onSprite, 1);
+    ASSERT_TRUE(pEnt->bBBDirty);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+#include "Game2DEntityFixture.h"
+extern "C" {
+#include "EntityDrawOrder.h"
+}
+
+static bool KeyLess(const EntitySortKey& a, const EntitySortKey& b)
+{
+    return a.key < b.key;
+}
+
+TEST(EntityDrawOrder, KeysOrderByLayerThenSortPosition)
+{
+    EXPECT_LT(EDO_MakeKey(0, -10.0f), EDO_MakeKey(0, 10.0f));
+    EXPECT_LT(EDO_MakeKey(0, 10.0f), EDO_MakeKey(0, 10.5f));
+    EXPECT_EQ(EDO_MakeKey(0, 10.0f), EDO_MakeKey(0, 10.1f));
+    EXPECT_LT(EDO_MakeKey(0, 100000.0f), EDO_MakeKey(1, -100000.0f));
+    /* out of range positions clamp rather than wrapping into another layer */
+    EXPECT_LT(EDO_MakeKey(0, 1e9f), EDO_MakeKey(1, -1e9f));
+    EXPECT_LT(EDO_MakeKey(1, 1e9f), EDO_MakeKey(2, -1e9f));
+}
+
+TEST(EntityDrawOrder, RadixAndInsertionSortsMatchStableSort)
+{
+    std::mt19937 rng(7);
+    for (int numKeys : { 0, 1, 2, 100, 5000 })
+    {
+        /* a few layers and a narrow range of positions, so some bytes are the same in every key */
+        std::uniform_int_distribution<int> layer(0, 3);
+        std::uniform_real_distribution<float> pos(-500.0f, 500.0f);
+        std::vector<EntitySortKey> keys(numKeys);
+        for (int i = 0; i < numKeys; i++)
+        {
+            keys[i].key = EDO_MakeKey(layer(rng), pos(rng));
+            keys[i].hEnt = i;
+        }
+        std::vector<EntitySortKey> expected = keys;
+        std::stable_sort(expected.begin(), expected.end(), &KeyLess);
+
+        std::vector<EntitySortKey> radix = keys;
+        std::vector<EntitySortKey> scratch(numKeys);
+        EDO_RadixSort(radix.data(), scratch.data(), numKeys);
+        std::vector<EntitySortKey> insertion = keys;
+        ASSERT_TRUE(EDO_InsertionSort(insertion.data(), numKeys, INT32_MAX));
+        for (int i = 0; i < numKeys; i++)
+        {
+            ASSERT_EQ(radix[i].key, expected[i].key);
+            ASSERT_EQ(radix[i].hEnt, expected[i].hEnt);
+            ASSERT_EQ(insertion[i].key, expected[i].key);
+            ASSERT_EQ(insertion[i].hEnt, expected[i].hEnt);
+        }
+    }
+}
+
+TEST(EntityDrawOrder, InsertionSortGivesUpOnUnsortedKeys)
+{
+    std::vector<EntitySortKey> keys(1000);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        keys[i].key = (u32)(keys.size() - i);
+        keys[i].hEnt = (HEntity2D)i;
+    }
+    ASSERT_FALSE(EDO_InsertionSort(keys.data(), (int)keys.size(), (int)keys.size() * EDO_MAX_INSERTION_SHIFTS_PER_KEY));
+}
+
+static int gNumSortPosCalls = 0;
+
+static float CountingGetSortPos(struct Entity2D* pEnt)
+{
+    gNumSortPosCalls++;
+    return pEnt->transform.position[1];
+}
+
+class EntityDrawOrderSortTest : public ::testing::Test, protected Game2DEntityFixture
+{
+protected:
+    void SetUp() override
+    {
+        InitEntities();
+        EDO_Init(&layerData.drawOrder);
+    }
+
+    void TearDown() override
+    {
+        DestroyEntities();
+        EDO_Destroy(&layerData.drawOrder);
+    }
+
+    HEntity2D AddEntity(float y, int drawLayer)
+    {
+        HEntity2D hEnt = Game2DEntityFixture::AddEntity(0.0f, y, &SquareGetBoundingBox);
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+        pEnt->getSortPos = &CountingGetSortPos;
+        pEnt->inDrawLayer = drawLayer;
+        return hEnt;
+    }
+
+    /* sort the visible entities and check they're the same entities, in order */
+    void SortAndCheck(const std::vector<HEntity2D>& visible)
+    {
+        VECTOR(HEntity2D) pEnts = NEW_VECTOR(HEntity2D);
+        pEnts = (HEntity2D*)VectorPushN(pEnts, visible.data(), (unsigned int)visible.size());
+        gNumSortPosCalls = 0;
+        Game2DLayer_SortEntitiesByDrawOrder(&layerData, pEnts);
+        EXPECT_EQ(gNumSortPosCalls, (int)visible.size());
+        ASSERT_EQ(VectorSize(pEnts), visible.size());
+        ASSERT_EQ(std::set<HEntity2D>(pEnts, pEnts + VectorSize(pEnts)), std::set<HEntity2D>(visible.begin(), visible.end()));
+        for (size_t i = 1; i < visible.size(); i++)
+        {
+            struct Entity2D* pPrev = Et2D_GetEntity(&layerData.entities, pEnts[i - 1]);
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, pEnts[i]);
+            ASSERT_LE(EDO_MakeKey(pPrev->inDrawLayer, pPrev->transform.position[1]), EDO_MakeKey(pEnt->inDrawLayer, pEnt->transform.position[1]));
+        }
+        DestoryVector(pEnts);
+    }
+};
+
+TEST_F(EntityDrawOrderSortTest, SortsFromTheLastOrderAsEntitiesMoveAppearAndAreDestroyed)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(0.0f, 2000.0f);
+    std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+    std::vector<HEntity2D> entities;
+    for (int i = 0; i < 2000; i++)
+    {
+        entities.push_back(AddEntity(pos(rng), i % 3));
+    }
+
+    /* the first sort has nothing to start from */
+    std::vector<HEntity2D> visible(entities.begin(), entities.begin() + 1000);
+    SortAndCheck(visible);
+    ASSERT_FALSE(layerData.drawOrder.bLastSortCoherent);
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+        for (HEntity2D hEnt : entities)
+        {
+            Et2D_GetEntity(&layerData.entities, hEnt)->transform.position[1] += step(rng);
+        }
+        /* some come into view and some go out of it */
+        visible.erase(visible.begin(), visible.begin() + 10);
+        visible.insert(visible.end(), entities.begin() + 1000 + frame * 10, entities.begin() + 1010 + frame * 10);
+        std::shuffle(visible.begin(), visible.end(), rng);
+        SortAndCheck(visible);
+        ASSERT_TRUE(layerData.drawOrder.bLastSortCoherent);
+    }
+
+    /* destroyed entities in the last order are skipped, and a new entity reusing one's slot is sorted */
+    for (int i = 0; i < 50; i++)
+    {
+        HEntity2D hDestroyed = visible.back();
+        visible.pop_back();
+        Et2D_DestroyEntity(&layer, &layerData.entities, hDestroyed);
+    }
+    visible.push_back(AddEntity(pos(rng), 1));
+    SortAndCheck(visible);
+}
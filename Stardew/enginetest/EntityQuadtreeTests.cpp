@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+#include "Game2DEntityFixture.h"
+extern "C" {
+#include "Geometry.h"
+}
+
+#define TEST_WORLD_SIZE_PX 1024.0f
+
+/* boxes of different sizes so entities end up at different depths */
+static void SizedGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+{
+    float size = 4.0f + (pEnt->thisEntity % 8) * 16.0f;
+    outTL[0] = pEnt->transform.position[0];
+    outTL[1] = pEnt->transform.position[1];
+    outBR[0] = pEnt->transform.position[0] + size;
+    outBR[1] = pEnt->transform.position[1] + size;
+}
+
+class EntityQuadtreeTest : public ::testing::Test, protected Game2DEntityFixture
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        InitQuadtreeSystem();
+    }
+
+    void SetUp() override
+    {
+        InitEntities();
+        struct Entity2DQuadTreeInitArgs args = { 0, 0, (int)TEST_WORLD_SIZE_PX, (int)TEST_WORLD_SIZE_PX };
+        layerData.hEntitiesQuadTree = GetEntity2DQuadTree(&args);
+    }
+
+    void TearDown() override
+    {
+        DestroyEntities();
+        DestroyEntity2DQuadTree(layerData.hEntitiesQuadTree);
+    }
+
+    HEntity2D AddEntity(float x, float y)
+    {
+        HEntity2D hEnt = Game2DEntityFixture::AddEntity(x, y, &SizedGetBoundingBox);
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+        pEnt->hQuadTreeRef = Entity2DQuadTree_Insert(&layerData.entities, layerData.hEntitiesQuadTree, hEnt, &layer);
+        return hEnt;
+    }
+
+    std::set<HEntity2D> Query(vec2 tl, vec2 br)
+    {
+        VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+        pFound = Entity2DQuadTree_Query(layerData.hEntitiesQuadTree, tl, br, pFound, &layerData.entities, &layer);
+        std::set<HEntity2D> found(pFound, pFound + VectorSize(pFound));
+        EXPECT_EQ(found.size(), VectorSize(pFound)) << "an entity was found twice";
+        DestoryVector(pFound);
+        return found;
+    }
+
+    std::set<HEntity2D> BruteForceQuery(const std::vector<HEntity2D>& entities, vec2 tl, vec2 br)
+    {
+        std::set<HEntity2D> found;
+        for (HEntity2D hEnt : entities)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            vec2 etl, ebr;
+            Et2D_GetBoundingBox(pEnt, &layer, etl, ebr);
+            if (Ge_AABBIntersect(tl, br, etl, ebr))
+            {
+                found.insert(hEnt);
+            }
+        }
+        return found;
+    }
+
+    void ExpectQueriesMatchBruteForce(std::mt19937& rng, const std::vector<HEntity2D>& entities)
+    {
+        std::uniform_real_distribution<float> pos(-100.0f, TEST_WORLD_SIZE_PX);
+        std::uniform_real_distribution<float> size(1.0f, 300.0f);
+        for (int i = 0; i < 20; i++)
+        {
+            vec2 tl = { pos(rng), pos(rng) };
+            vec2 br = { tl[0] + size(rng), tl[1] + size(rng) };
+            ASSERT_EQ(Query(tl, br), BruteForceQuery(entities, tl, br));
+        }
+    }
+};
+
+TEST_F(EntityQuadtreeTest, QueriesFindMovingEntities)
+{
+    std::mt19937 rng(1234);
+    /* some start and wander outside the tree */
+    std::uniform_real_distribution<float> pos(-50.0f, TEST_WORLD_SIZE_PX + 50.0f);
+    std::uniform_real_distribution<float> step(-40.0f, 40.0f);
+    std::vector<HEntity2D> entities;
+    for (int i = 0; i < 500; i++)
+    {
+        entities.push_back(AddEntity(pos(rng), pos(rng)));
+    }
+    ExpectQueriesMatchBruteForce(rng, entities);
+
+    for (int frame = 0; frame < 20; frame++)
+    {
+        for (HEntity2D hEnt : entities)
+        {
+            struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+            pEnt->transform.position[0] += step(rng);
+            pEnt->transform.position[1] += step(rng);
+            Et2D_BroadphaseMove(&layer, pEnt);
+        }
+        ExpectQueriesMatchBruteForce(rng, entities);
+    }
+}
+
+TEST_F(EntityQuadtreeTest, RemovedEntitiesArentFound)
+{
+    std::vector<HEntity2D> entities;
+    for (int i = 0; i < 64; i++)
+    {
+        entities.push_back(AddEntity((i % 8) * 128.0f, (i / 8) * 128.0f));
+    }
+    vec2 tl = { 0.0f, 0.0f };
+    vec2 br = { TEST_WORLD_SIZE_PX, TEST_WORLD_SIZE_PX };
+    ASSERT_EQ(Query(tl, br).size(), 64u);
+
+    std::vector<HEntity2D> kept;
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, entities[i]);
+        if (i % 3 == 0)
+        {
+            Entity2DQuadTree_Remove(layerData.hEntitiesQuadTree, pEnt->hQuadTreeRef);
+        }
+        else
+        {
+            kept.push_back(entities[i]);
+        }
+    }
+    ASSERT_EQ(Query(tl, br), std::set<HEntity2D>(kept.begin(), kept.end()));
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "FrameArena.h"
+#include "DynArray.h"
+#include <cstdint>
+
+struct ScopedLinearArena
+{
+    ScopedLinearArena(size_t capacity)
+    {
+        Ar_InitArena(&arena, capacity);
+    }
+    ~ScopedLinearArena()
+    {
+        Ar_DestroyArena(&arena);
+    }
+    struct LinearArena arena;
+};
+
+TEST(FrameArena, AllocationsAligned)
+{
+    ScopedLinearArena a{1024};
+    for(int i=1; i<20; i++)
+    {
+        void* p = Ar_Alloc(&a.arena, i);
+        ASSERT_EQ((uintptr_t)p % FRAME_ARENA_ALIGNMENT, 0);
+    }
+}
+
+TEST(FrameArena, ResetReusesMemory)
+{
+    ScopedLinearArena a{1024};
+    void* pFirst = Ar_Alloc(&a.arena, 100);
+    Ar_Alloc(&a.arena, 100);
+    ASSERT_EQ(a.arena.used, 224);
+    Ar_Reset(&a.arena);
+    ASSERT_EQ(a.arena.used, 0);
+    ASSERT_EQ(Ar_Alloc(&a.arena, 100), pFirst);
+    ASSERT_EQ(a.arena.highWaterMark, 224);
+}
+
+TEST(FrameArena, OverflowFallsBackThenGrows)
+{
+    ScopedLinearArena a{64};
+    for(int i=0; i<10; i++)
+    {
+        int* p = (int*)Ar_Alloc(&a.arena, 32);
+        *p = i;
+    }
+    ASSERT_EQ(a.arena.numHeapFallbacks, 8);
+    Ar_Reset(&a.arena);
+    ASSERT_GE(a.arena.capacity, 320);
+
+    /* same workload next frame fits without touching the heap */
+    for(int i=0; i<10; i++)
+    {
+        Ar_Alloc(&a.arena, 32);
+    }
+    ASSERT_EQ(a.arena.numHeapFallbacks, 0);
+}
+
+TEST(FrameArena, ZeroCapacityGrows)
+{
+    ScopedLinearArena a{0};
+    Ar_Alloc(&a.arena, 100);
+    ASSERT_EQ(a.arena.numHeapFallbacks, 1);
+    Ar_Reset(&a.arena);
+    ASSERT_GE(a.arena.capacity, 112);
+    Ar_Alloc(&a.arena, 100);
+    ASSERT_EQ(a.arena.numHeapFallbacks, 0);
+}
+
+TEST(FrameArena, TwoFrameAllocationOutlivesOneFrame)
+{
+    int* pTwoFrame = (int*)Ar_TwoFrameAlloc(sizeof(int) * 4);
+    for(int i=0; i<4; i++)
+    {
+        pTwoFrame[i] = i * 7;
+    }
+    Ar_EndFrame();
+
+    /* allocations made in the next frame must not overwrite it */
+    int* pNext = (int*)Ar_TwoFrameAlloc(sizeof(int) * 4);
+    ASSERT_NE(pNext, pTwoFrame);
+    for(int i=0; i<4; i++)
+    {
+        pNext[i] = -1;
+    }
+    for(int i=0; i<4; i++)
+    {
+        ASSERT_EQ(pTwoFrame[i], i * 7);
+    }
+    Ar_EndFrame();
+    ASSERT_EQ(Ar_TwoFrameAlloc(sizeof(int) * 4), pTwoFrame);
+    Ar_EndFrame();
+}
+
+TEST(FrameArena, FrameVectorGrows)
+{
+    Ar_EndFrame();
+    VECTOR(int) v = NEW_FRAME_VECTOR(int);
+    for(int i=0; i<1000; i++)
+    {
+        v = (int*)VectorPush(v, &i);
+    }
+    ASSERT_EQ(VectorSize(v), 1000);
+    for(int i=0; i<1000; i++)
+    {
+        ASSERT_EQ(v[i], i);
+    }
+    /* no-op for frame vectors, the memory goes back when the frame ends */
+    DestoryVector(v);
+    Ar_EndFrame();
+    struct FrameArenaStats stats = Ar_GetFrameArenaStats();
+    ASSERT_GE(stats.bytesUsedLastFrame, 1000 * sizeof(int));
+    ASSERT_GT(stats.allocationsLastFrame, 1);
+}
@@ -0,0 +1,84 @@
+#ifndef GAME2D_ENTITY_FIXTURE_H
+#define GAME2D_ENTITY_FIXTURE_H
+
+#include <cstring>
+#include "DynArray.h"
+#include "GameFramework.h"
+#include "Game2DLayerIncludes.h"
+
+#define GAME2D_FIXTURE_ENTITY_SIZE_PX 16.0f
+
+/*
+    A Game2D layers entities, without the rest of the layer. Shared by the entity tests and benchmarks.
+    The user creates whichever broadphase and draw order they need, and destroys them after DestroyEntities.
+*/
+struct Game2DEntityFixture
+{
+    /* the quadtree system has no deinit, so it's initialised once for the whole process */
+    static void InitQuadtreeSystem()
+    {
+        static bool bQuadtreeSystemInitialised = false;
+        if (!bQuadtreeSystemInitialised)
+        {
+            InitEntity2DQuadtreeSystem();
+            bQuadtreeSystemInitialised = true;
+        }
+    }
+
+    /* a GAME2D_FIXTURE_ENTITY_SIZE_PX square at the entities position */
+    static void SquareGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+    {
+        outTL[0] = pEnt->transform.position[0];
+        outTL[1] = pEnt->transform.position[1];
+        outBR[0] = pEnt->transform.position[0] + GAME2D_FIXTURE_ENTITY_SIZE_PX;
+        outBR[1] = pEnt->transform.position[1] + GAME2D_FIXTURE_ENTITY_SIZE_PX;
+    }
+
+    /* an entity with the common handlers and no components, in no broadphase or dynamic list */
+    static void InitEntity(struct Entity2D* pEnt)
+    {
+        memset(pEnt, 0, sizeof(struct Entity2D));
+        Et2D_PopulateCommonHandlers(pEnt);
+        pEnt->transform.scale[0] = 1.0f;
+        pEnt->transform.scale[1] = 1.0f;
+        pEnt->hQuadTreeRef = NULL_HANDLE;
+        pEnt->hDynamicListRef = NULL_HANDLE;
+        pEnt->hSpatialGridRef = NULL_HANDLE;
+    }
+
+    void InitEntities(bool bUseComponentStore = false)
+    {
+        memset(&layerData, 0, sizeof(struct GameLayer2DData));
+        memset(&layer, 0, sizeof(struct GameFrameworkLayer));
+        layer.userData = &layerData;
+        layerData.pLayer = &layer;
+        layerData.hEntitiesQuadTree = NULL_HANDLE;
+        Et2D_InitCollection(&layerData.entities);
+        if (bUseComponentStore)
+        {
+            Et2D_UseComponentStore(&layerData.entities);
+        }
+    }
+
+    /* destroys the entities as the layer does, they remove themselves from the broadphase so it has to still exist */
+    void DestroyEntities()
+    {
+        Et2D_DestroyCollection(&layerData.entities, &layer);
+        layerData.entities.dynamicEntities.pDynamicListItemPool = (struct DynamicEntityListItem*)FreeObjectPool(layerData.entities.dynamicEntities.pDynamicListItemPool);
+    }
+
+    HEntity2D AddEntity(float x, float y, Entity2DGetBoundingBoxFn getBB)
+    {
+        struct Entity2D ent;
+        InitEntity(&ent);
+        ent.getBB = getBB;
+        ent.transform.position[0] = x;
+        ent.transform.position[1] = y;
+        return Et2D_AddEntity(&layerData.entities, &ent);
+    }
+
+    struct GameLayer2DData layerData;
+    struct GameFrameworkLayer layer;
+};
+
+#endif
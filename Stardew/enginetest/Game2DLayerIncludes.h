@@ -0,0 +1,15 @@
+#ifndef GAME2D_LAYER_INCLUDES_H
+#define GAME2D_LAYER_INCLUDES_H
+
+/*
+    The Game2D layer and entity headers for the tests and benchmarks.
+    box2d has C++ only parts so is included before the extern "C" block that would otherwise include it.
+*/
+#include <box2d/box2d.h>
+extern "C" {
+#include "Game2DLayer.h"
+#include "Entities.h"
+#include "EntityQuadTree.h"
+}
+
+#endif
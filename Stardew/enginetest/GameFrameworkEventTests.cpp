@@ -1,11 +1,14 @@
 #include <gtest/gtest.h>
 #include <filesystem>
+#include <chrono>
+#include <vector>
 #include "GameFramework.h"
 #include "XMLUIGameLayer.h"
 #include "Scripting.h"
 #include "DrawContext.h"
 #include "GameFrameworkEvent.h"
 #include "DataNode.h"
+#include "TestData.h"
 #include "lua.h"
 #include <lualib.h>
 #include <lauxlib.h>
@@ -93,7 +96,7 @@ TEST(Events, EventsIntegrationTest)
     memset(&testLayer, 0, sizeof(struct GameFrameworkLayer));
     struct XMLUIGameLayerOptions options;
     options.bLoadImmediately = false;
-    options.xmlPath = "./data/GameFrameworkEventTestUILayer.xml";
+    options.xmlPath = TEST_DATA_PATH("GameFrameworkEventTestUILayer.xml");
     options.pDc = NULL;
     testLayer.flags |= (EnableOnPush | EnableOnPop);
     XMLUIGameLayer_Get(&testLayer, &options);
@@ -119,4 +122,135 @@ TEST(Events, EventsIntegrationTest)
 
     // todo: add tests to verify unsubscription
     Sc_DeInitScripting();
-}
\ No newline at end of file
+}
+
+static void CountingListener(void* pUserData, void* pEventData)
+{
+    (*(int*)pUserData)++;
+}
+
+TEST(Events, RegisterEventNameIsInterned)
+{
+    Ev_Init();
+    HEvent a = Ev_RegisterEventName("TestInternedA");
+    HEvent b = Ev_RegisterEventName("TestInternedB");
+    ASSERT_NE(a, NULL_HEVENT);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(Ev_RegisterEventName("TestInternedA"), a);
+}
+
+struct OrderRecorder
+{
+    std::vector<int>* pOrder;
+    int id;
+};
+
+static void RecordOrderListener(void* pUserData, void* pEventData)
+{
+    OrderRecorder* pRecorder = (OrderRecorder*)pUserData;
+    pRecorder->pOrder->push_back(pRecorder->id);
+}
+
+TEST(Events, FireByIdAndByNameCallListenersInOrder)
+{
+    Ev_Init();
+    std::vector<int> order;
+    OrderRecorder recorders[3] = { {&order, 0}, {&order, 1}, {&order, 2} };
+    HEvent ev = Ev_RegisterEventName("TestOrder");
+    struct GameFrameworkEventListener* pListeners[3];
+    for (int i = 0; i < 3; i++)
+    {
+        pListeners[i] = Ev_SubscribeEventById(ev, &RecordOrderListener, &recorders[i]);
+    }
+    Ev_FireEventById(ev, NULL);
+    Ev_FireEvent("TestOrder", NULL);
+    std::vector<int> expected = { 0, 1, 2, 0, 1, 2 };
+    ASSERT_EQ(order, expected);
+
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pListeners[1]));
+    order.clear();
+    Ev_FireEventById(ev, NULL);
+    expected = { 0, 2 };
+    ASSERT_EQ(order, expected);
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pListeners[0]));
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pListeners[2]));
+}
+
+static struct GameFrameworkEventListener* gSelfUnsubscribingListener = NULL;
+
+static void SelfUnsubscribingListener(void* pUserData, void* pEventData)
+{
+    (*(int*)pUserData)++;
+    Ev_UnsubscribeEvent(gSelfUnsubscribingListener);
+}
+
+TEST(Events, UnsubscribeWhileFiring)
+{
+    Ev_Init();
+    int selfCount = 0;
+    int otherCount = 0;
+    HEvent ev = Ev_RegisterEventName("TestUnsubscribeWhileFiring");
+    gSelfUnsubscribingListener = Ev_SubscribeEventById(ev, &SelfUnsubscribingListener, &selfCount);
+    struct GameFrameworkEventListener* pOther = Ev_SubscribeEventById(ev, &CountingListener, &otherCount);
+    Ev_FireEventById(ev, NULL);
+    Ev_FireEventById(ev, NULL);
+    ASSERT_EQ(selfCount, 1);
+    ASSERT_EQ(otherCount, 2);
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pOther));
+}
+
+static void SumArgsListener(void* pUserData, void* pEventData)
+{
+    *(int*)pUserData += *(int*)pEventData;
+}
+
+TEST(Events, QueuedEventsFireOnDrain)
+{
+    Ev_Init();
+    int sum = 0;
+    HEvent ev = Ev_RegisterEventName("TestQueued");
+    struct GameFrameworkEventListener* pListener = Ev_SubscribeEventById(ev, &SumArgsListener, &sum);
+    for (int i = 1; i <= 100; i++)
+    {
+        Ev_QueueEvent(ev, &i, sizeof(int));
+    }
+    ASSERT_EQ(sum, 0);
+    Ev_DrainEventQueue();
+    ASSERT_EQ(sum, 5050);
+    Ev_DrainEventQueue();
+    ASSERT_EQ(sum, 5050);
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pListener));
+}
+
+/*
+    Per frame events should cost next to nothing - 1M fires, by id and queued, must each take well under a second.
+*/
+TEST(Events, Throughput1MFires)
+{
+    Ev_Init();
+    const int numFires = 1000000;
+    int count = 0;
+    HEvent ev = Ev_RegisterEventName("TestThroughput");
+    struct GameFrameworkEventListener* pListener = Ev_SubscribeEventById(ev, &CountingListener, &count);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numFires; i++)
+    {
+        Ev_FireEventById(ev, NULL);
+    }
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numFires; i++)
+    {
+        Ev_QueueEvent(ev, &i, sizeof(int));
+    }
+    Ev_DrainEventQueue();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    ASSERT_EQ(count, 2 * numFires);
+    double byIdMs = std::chrono::duration<double, std::milli>(mid - start).count();
+    double queuedMs = std::chrono::duration<double, std::milli>(end - mid).count();
+    printf("%i fires: by id %.2f ms, queued and drained %.2f ms\n", numFires, byIdMs, queuedMs);
+    ASSERT_LT(byIdMs, 1000.0);
+    ASSERT_LT(queuedMs, 1000.0);
+    ASSERT_TRUE(Ev_UnsubscribeEvent(pListener));
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "GlyphRunCache.h"
+#include <string.h>
+#include <stdio.h>
+
+static struct GlyphRun MakeRun(float width)
+{
+    struct GlyphRun run;
+    run.width = width;
+    run.maxYBearing = 10.0f;
+    run.minBelowBaseline = -2.0f;
+    run.height = 12.0f;
+    return run;
+}
+
+static void Insert(hAtlas atlas, HFont font, const char* str, float width)
+{
+    struct GlyphRun run = MakeRun(width);
+    size_t len = strlen(str);
+    GRC_Insert(atlas, font, str, len, GRC_HashString(str, len), &run);
+}
+
+static const struct GlyphRun* Find(hAtlas atlas, HFont font, const char* str)
+{
+    size_t len = strlen(str);
+    return GRC_Find(atlas, font, str, len, GRC_HashString(str, len));
+}
+
+TEST(GlyphRunCache, FindsWhatWasInserted)
+{
+    GRC_Clear();
+    ASSERT_EQ(Find(0, 0, "hello"), nullptr);
+    Insert(0, 0, "hello", 40.0f);
+    const struct GlyphRun* pRun = Find(0, 0, "hello");
+    ASSERT_NE(pRun, nullptr);
+    ASSERT_EQ(pRun->width, 40.0f);
+    ASSERT_EQ(pRun->height, 12.0f);
+
+    /* the same string in another font or atlas is a different run */
+    ASSERT_EQ(Find(0, 1, "hello"), nullptr);
+    ASSERT_EQ(Find(1, 0, "hello"), nullptr);
+    ASSERT_EQ(Find(0, 0, "hell"), nullptr);
+    ASSERT_EQ(Find(0, 0, ""), nullptr);
+
+    struct GlyphRunCacheStats stats = GRC_GetStats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 5u);
+    GRC_Clear();
+}
+
+TEST(GlyphRunCache, ComparesStringsNotJustHashes)
+{
+    GRC_Clear();
+    /* force two different strings to share a hash */
+    struct GlyphRun run = MakeRun(1.0f);
+    GRC_Insert(0, 0, "abc", 3, 1234, &run);
+    ASSERT_NE(GRC_Find(0, 0, "abc", 3, 1234), nullptr);
+    ASSERT_EQ(GRC_Find(0, 0, "abd", 3, 1234), nullptr);
+    ASSERT_EQ(GRC_Find(0, 0, "abcd", 4, 1234), nullptr);
+    GRC_Clear();
+}
+
+TEST(GlyphRunCache, EvictsLeastRecentlyUsed)
+{
+    GRC_Clear();
+    char str[32];
+    for (int i = 0; i < GLYPH_RUN_CACHE_SIZE; i++)
+    {
+        snprintf(str, sizeof(str), "line %i", i);
+        Insert(0, 0, str, (float)i);
+    }
+    /* touch the oldest so the second oldest is evicted instead */
+    ASSERT_NE(Find(0, 0, "line 0"), nullptr);
+    Insert(0, 0, "one too many", 0.0f);
+
+    ASSERT_EQ(GRC_GetStats().evictions, 1u);
+    ASSERT_EQ(Find(0, 0, "line 1"), nullptr);
+    const struct GlyphRun* pRun = Find(0, 0, "line 0");
+    ASSERT_NE(pRun, nullptr);
+    ASSERT_EQ(pRun->width, 0.0f);
+    pRun = Find(0, 0, "line 2");
+    ASSERT_NE(pRun, nullptr);
+    ASSERT_EQ(pRun->width, 2.0f);
+    ASSERT_NE(Find(0, 0, "one too many"), nullptr);
+    GRC_Clear();
+}
+
+TEST(GlyphRunCache, InvalidatingAnAtlasKeepsOtherAtlases)
+{
+    GRC_Clear();
+    Insert(0, 0, "kept", 1.0f);
+    Insert(1, 0, "dropped", 2.0f);
+    Insert(1, 3, "also dropped", 3.0f);
+    GRC_InvalidateAtlas(1);
+    ASSERT_NE(Find(0, 0, "kept"), nullptr);
+    ASSERT_EQ(Find(1, 0, "dropped"), nullptr);
+    ASSERT_EQ(Find(1, 3, "also dropped"), nullptr);
+
+    /* the freed entries are reused */
+    Insert(1, 0, "dropped", 5.0f);
+    const struct GlyphRun* pRun = Find(1, 0, "dropped");
+    ASSERT_NE(pRun, nullptr);
+    ASSERT_EQ(pRun->width, 5.0f);
+    GRC_Clear();
+}
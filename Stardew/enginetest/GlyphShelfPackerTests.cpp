@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "GlyphShelfPacker.h"
+
+struct PlacedGlyph
+{
+    int x, y, w, h;
+};
+
+static void RecordEvicted(void* pUser, u64 glyph)
+{
+    std::vector<u64>* pEvicted = (std::vector<u64>*)pUser;
+    pEvicted->push_back(glyph);
+}
+
+static bool Overlaps(const PlacedGlyph& a, const PlacedGlyph& b)
+{
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+TEST(GlyphShelfPacker, PlacesGlyphsInsideTheRegionWithoutOverlapping)
+{
+    std::vector<u64> evicted;
+    struct GlyphShelfPacker packer;
+    GSP_Init(&packer, 100, 50, 128, 128, &RecordEvicted, &evicted);
+    std::vector<PlacedGlyph> placed;
+    for (int i = 0; i < 200; i++)
+    {
+        PlacedGlyph glyph = { 0, 0, 3 + (i * 7) % 11, 5 + (i * 5) % 13 };
+        if (GSP_Alloc(&packer, glyph.w, glyph.h, 1, i, &glyph.x, &glyph.y) == GLYPH_SHELF_NONE)
+        {
+            break;
+        }
+        ASSERT_GE(glyph.x, 100);
+        ASSERT_GE(glyph.y, 50);
+        ASSERT_LE(glyph.x + glyph.w, 100 + 128);
+        ASSERT_LE(glyph.y + glyph.h, 50 + 128);
+        for (const PlacedGlyph& other : placed)
+        {
+            ASSERT_FALSE(Overlaps(glyph, other));
+        }
+        placed.push_back(glyph);
+    }
+    ASSERT_GT(placed.size(), 100u);
+    ASSERT_TRUE(evicted.empty());
+    GSP_DeInit(&packer);
+}
+
+TEST(GlyphShelfPacker, EvictsTheLeastRecentlyUsedShelf)
+{
+    std::vector<u64> evicted;
+    struct GlyphShelfPacker packer;
+    /* room for 4 shelves of 4 glyphs */
+    GSP_Init(&packer, 0, 0, 32, 32, &RecordEvicted, &evicted);
+    int shelves[4];
+    for (int i = 0; i < 16; i++)
+    {
+        int x, y;
+        int shelf = GSP_Alloc(&packer, 8, 8, 1 + i / 4, i, &x, &y);
+        ASSERT_NE(shelf, GLYPH_SHELF_NONE);
+        shelves[i / 4] = shelf;
+    }
+    /* the first shelf is used again, so the second is the oldest */
+    GSP_Touch(&packer, shelves[0], 10);
+
+    int x, y;
+    ASSERT_EQ(GSP_Alloc(&packer, 8, 8, 11, 100, &x, &y), shelves[1]);
+    ASSERT_EQ(evicted, (std::vector<u64>{ 4, 5, 6, 7 }));
+    ASSERT_EQ(packer.numEvictedShelves, 1u);
+    ASSERT_EQ(packer.numEvictedGlyphs, 4u);
+
+    /* the emptied shelf is refilled before anything else is evicted */
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(GSP_Alloc(&packer, 8, 8, 11, 101 + i, &x, &y), shelves[1]);
+    }
+    ASSERT_EQ(evicted.size(), 4u);
+    GSP_DeInit(&packer);
+}
+
+TEST(GlyphShelfPacker, DoesntEvictShelvesUsedThisFrame)
+{
+    std::vector<u64> evicted;
+    struct GlyphShelfPacker packer;
+    GSP_Init(&packer, 0, 0, 16, 16, &RecordEvicted, &evicted);
+    int x, y;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_NE(GSP_Alloc(&packer, 8, 8, 5, i, &x, &y), GLYPH_SHELF_NONE);
+    }
+    ASSERT_EQ(GSP_Alloc(&packer, 8, 8, 5, 4, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_TRUE(evicted.empty());
+
+    /* next frame they can go */
+    ASSERT_NE(GSP_Alloc(&packer, 8, 8, 6, 4, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_EQ(evicted.size(), 2u);
+    GSP_DeInit(&packer);
+}
+
+TEST(GlyphShelfPacker, RejectsGlyphsBiggerThanTheRegion)
+{
+    std::vector<u64> evicted;
+    struct GlyphShelfPacker packer;
+    GSP_Init(&packer, 0, 0, 16, 16, &RecordEvicted, &evicted);
+    int x, y;
+    ASSERT_EQ(GSP_Alloc(&packer, 17, 4, 1, 0, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_EQ(GSP_Alloc(&packer, 4, 17, 1, 0, &x, &y), GLYPH_SHELF_NONE);
+    /* a short shelf can't be evicted to fit a taller glyph */
+    ASSERT_NE(GSP_Alloc(&packer, 16, 12, 1, 1, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_NE(GSP_Alloc(&packer, 16, 4, 1, 2, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_EQ(GSP_Alloc(&packer, 4, 13, 2, 3, &x, &y), GLYPH_SHELF_NONE);
+    ASSERT_TRUE(evicted.empty());
+    GSP_DeInit(&packer);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "TestData.h"
+extern "C" {
+#include "ImageFileRegstry.h"
+}
+
+#define TEST_NUM_IMAGES 8
+
+static void InitTestRegistry()
+{
+    IR_InitImageRegistry(TEST_DATA_REGISTRY_PATH);
+}
+
+struct LoadedCallbackRecord
+{
+    int numCalls = 0;
+    HImage hImage = NULL_HIMAGE;
+    bool bLoaded = false;
+};
+
+static void OnImageLoaded(HImage hImage, bool bLoaded, void* pUser)
+{
+    LoadedCallbackRecord* pRecord = (LoadedCallbackRecord*)pUser;
+    pRecord->numCalls++;
+    pRecord->hImage = hImage;
+    pRecord->bLoaded = bLoaded;
+}
+
+TEST(ImageRegistry, LooksUpRegisteredPaths)
+{
+    InitTestRegistry();
+    ASSERT_EQ(IR_GetNumImages(), TEST_NUM_IMAGES);
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        HImage found = IR_LookupHandleByPath(IR_GetImageFile(i)->path);
+        ASSERT_NE(found, NULL_HIMAGE);
+        ASSERT_STREQ(IR_GetImageFile(found)->path, IR_GetImageFile(i)->path);
+        ASSERT_LE(found, (HImage)i);
+    }
+    ASSERT_EQ(IR_LookupHandleByPath(TEST_DATA_PATH("Image/not_registered.png")), NULL_HIMAGE);
+    IR_DestroyImageRegistry();
+}
+
+TEST(ImageRegistry, AsyncLoadCallsBackFromPoll)
+{
+    InitTestRegistry();
+    HImage hImage = IR_LookupHandleByPath(TEST_DATA_IMAGE_PATH);
+    ASSERT_NE(hImage, NULL_HIMAGE);
+    ASSERT_EQ(IR_GetImageLoadState(hImage), ILS_Unloaded);
+
+    LoadedCallbackRecord record;
+    ASSERT_TRUE(IR_LoadImageAsync(hImage, &OnImageLoaded, &record));
+    ASSERT_TRUE(IR_WaitForImage(hImage));
+    ASSERT_EQ(IR_GetImageLoadState(hImage), ILS_Loaded);
+    ASSERT_EQ(record.numCalls, 0);
+
+    IR_PollImageLoads();
+    ASSERT_EQ(record.numCalls, 1);
+    ASSERT_EQ(record.hImage, hImage);
+    ASSERT_TRUE(record.bLoaded);
+    IR_PollImageLoads();
+    ASSERT_EQ(record.numCalls, 1);
+
+    int w = 0, h = 0;
+    u8* pExpected = IR_DecodeImageFile(TEST_DATA_IMAGE_PATH, &w, &h);
+    ASSERT_NE(pExpected, nullptr);
+    const struct ImageFile* pImage = IR_GetImageFile(hImage);
+    ASSERT_EQ(pImage->width, w);
+    ASSERT_EQ(pImage->height, h);
+    ASSERT_EQ(memcmp(pImage->pData, pExpected, (size_t)w * h * CHANNELS_PER_PIXEL), 0);
+    IR_FreeDecodedImage(pExpected);
+
+    /* already loaded, the callback still comes from the next poll */
+    LoadedCallbackRecord secondRecord;
+    ASSERT_TRUE(IR_LoadImageAsync(hImage, &OnImageLoaded, &secondRecord));
+    ASSERT_EQ(secondRecord.numCalls, 0);
+    IR_PollImageLoads();
+    ASSERT_EQ(secondRecord.numCalls, 1);
+    ASSERT_TRUE(secondRecord.bLoaded);
+    IR_DestroyImageRegistry();
+}
+
+TEST(ImageRegistry, GetImageDataWaitsForAsyncLoad)
+{
+    InitTestRegistry();
+    HImage hImage = IR_LookupHandleByPath(TEST_DATA_IMAGE_PATH);
+    ASSERT_NE(hImage, NULL_HIMAGE);
+    IR_SetNumDecodeThreads(2);
+    ASSERT_EQ(IR_GetNumImages(), TEST_NUM_IMAGES);
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        IR_LoadImageAsync(i, NULL, NULL);
+    }
+    IR_LoadImageAsync(hImage, NULL, NULL);
+    ASSERT_NE(IR_GetImageData(hImage), nullptr);
+    ASSERT_TRUE(IR_IsImageLoaded(hImage));
+    IR_WaitForAllImages();
+    for (int i = 0; i < IR_GetNumImages(); i++)
+    {
+        ASSERT_EQ(IR_GetImageLoadState(i), ILS_Loaded);
+    }
+    IR_SetNumDecodeThreads(0);
+    IR_DestroyImageRegistry();
+}
+
+TEST(ImageRegistry, AsyncLoadOfMissingFileFails)
+{
+    InitTestRegistry();
+    HImage hImage = IR_RegisterImagePath("Image/does_not_exist.png");
+    LoadedCallbackRecord record;
+    ASSERT_TRUE(IR_LoadImageAsync(hImage, &OnImageLoaded, &record));
+    ASSERT_FALSE(IR_WaitForImage(hImage));
+    ASSERT_EQ(IR_GetImageLoadState(hImage), ILS_Failed);
+    IR_PollImageLoads();
+    ASSERT_EQ(record.numCalls, 1);
+    ASSERT_FALSE(record.bLoaded);
+    IR_DestroyImageRegistry();
+}
@@ -0,0 +1,190 @@
+#include "LegacyStringKeyHashMap.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+	Insert and search of the old StringKeyHashMap.c, unchanged apart from names.
+	Delete and key iteration aren't benchmarked so they're left out.
+*/
+
+struct LegacyKVP
+{
+	struct LegacyKVP* pNext;
+	struct LegacyKVP* pPrev;
+	char* pKey;
+	unsigned int keyHash;
+};
+
+static unsigned int LegacyDjb2(const char* str)
+{
+	unsigned int hash = 5381;
+	int c;
+
+	while ((c = *(const unsigned char*)str++))
+	{
+		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+	}
+
+	return hash;
+}
+
+void LegacyHashmapInit(struct LegacyHashMap* pMap, int capacity, int valSize)
+{
+	memset(pMap, 0, sizeof(struct LegacyHashMap));
+	pMap->capacity = capacity;
+	pMap->size = 0;
+	pMap->valueSize = valSize;
+	pMap->pData = malloc(capacity * (sizeof(struct LegacyKVP) + valSize));
+	memset(pMap->pData, 0, capacity * (sizeof(struct LegacyKVP) + valSize));
+	pMap->fLoadFactor = 0.75f;
+}
+
+static struct LegacyKVP* BucketAtIndex(struct LegacyHashMap* pMap, int i)
+{
+	return (struct LegacyKVP*)((char*)pMap->pData + i * (sizeof(struct LegacyKVP) + pMap->valueSize));
+}
+
+static int NextIndex(struct LegacyHashMap* pMap, int i)
+{
+	if (++i >= pMap->capacity)
+	{
+		return 0;
+	}
+	return i;
+}
+
+void* LegacyHashmapSearch(struct LegacyHashMap* pMap, const char* key)
+{
+	unsigned int hash = LegacyDjb2(key);
+	int index = hash % pMap->capacity;
+	/* linear probe */
+	struct LegacyKVP* pKVP = BucketAtIndex(pMap, index);
+
+	while (true)
+	{
+		if (pKVP->pKey && pKVP->keyHash == hash)
+		{
+			return pKVP + 1;
+		}
+		else if (pKVP->pKey) // pKey set == "there's something in this bucket"
+		{
+			index = NextIndex(pMap, index);
+			pKVP = BucketAtIndex(pMap, index);
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+static struct LegacyKVP* InsertKVPIntoNewAlloc(struct LegacyHashMap* pMap, struct LegacyKVP* pKVPsrc, char* pNewAlloc)
+{
+	unsigned int hash = pKVPsrc->keyHash;
+	int index = hash % pMap->capacity;
+	struct LegacyKVP* pKVP = (struct LegacyKVP*)(pNewAlloc + index * (sizeof(struct LegacyKVP) + pMap->valueSize));
+
+	while (pKVP->pKey && pKVP->keyHash != hash)
+	{
+		// occupied bucket
+		index = NextIndex(pMap, index);
+		pKVP = (struct LegacyKVP*)(pNewAlloc + index * (sizeof(struct LegacyKVP) + pMap->valueSize));
+	}
+	assert(!pKVP->pKey);
+	memset(pKVP, 0, sizeof(struct LegacyKVP));
+	pKVP->keyHash = hash;
+	pKVP->pKey = malloc(strlen(pKVPsrc->pKey) + 1);
+	strcpy(pKVP->pKey, pKVPsrc->pKey);
+	memcpy(pKVP + 1, pKVPsrc + 1, pMap->valueSize);
+	return pKVP;
+}
+
+static void LegacyHashmapResize(struct LegacyHashMap* pMap)
+{
+	int newAllocSize = (pMap->capacity * (pMap->valueSize + sizeof(struct LegacyKVP))) * 2;
+	char* pNewAlloc = malloc(newAllocSize);
+	memset(pNewAlloc, 0, newAllocSize);
+	pMap->capacity *= 2;
+	struct LegacyKVP* pKVP = pMap->pHead;
+	struct LegacyKVP* pNewHead = NULL;
+	struct LegacyKVP* pNewTail = NULL;
+	while (pKVP)
+	{
+		struct LegacyKVP* pKVPDst = InsertKVPIntoNewAlloc(pMap, pKVP, pNewAlloc);
+		if (pNewHead == NULL)
+		{
+			pNewHead = pKVPDst;
+			pNewTail = pNewHead;
+		}
+		else
+		{
+			pNewTail->pNext = pKVPDst;
+			pKVPDst->pPrev = pNewTail;
+			pNewTail = pKVPDst;
+		}
+		free(pKVP->pKey);
+		pKVP = pKVP->pNext;
+	}
+	pMap->pHead = pNewHead;
+	pMap->pEnd = pNewTail;
+	free(pMap->pData);
+	pMap->pData = pNewAlloc;
+}
+
+void* LegacyHashmapInsert(struct LegacyHashMap* pMap, const char* key, void* pVal)
+{
+	float newLoad = (float)(pMap->size + 1) / (float)pMap->capacity;
+	if (newLoad > pMap->fLoadFactor)
+	{
+		LegacyHashmapResize(pMap);
+	}
+	unsigned int hash = LegacyDjb2(key);
+	int index = hash % pMap->capacity;
+	struct LegacyKVP* pKVP = BucketAtIndex(pMap, index);
+	while (pKVP->pKey && pKVP->keyHash != hash)
+	{
+		// occupied bucket
+		index = NextIndex(pMap, index);
+		pKVP = BucketAtIndex(pMap, index);
+	}
+	bool bAdded = pKVP->pKey == NULL;
+	if (bAdded)
+	{
+		memset(pKVP, 0, sizeof(struct LegacyKVP));
+		pKVP->keyHash = hash;
+		pKVP->pKey = malloc(strlen(key) + 1);
+		strcpy(pKVP->pKey, key);
+	}
+	memcpy(pKVP + 1, pVal, pMap->valueSize);
+	if (!bAdded)
+	{
+		return NULL;
+	}
+	if (!pMap->pHead)
+	{
+		pMap->pHead = pKVP;
+		pMap->pEnd = pMap->pHead;
+	}
+	else
+	{
+		pMap->pEnd->pNext = pKVP;
+		pKVP->pPrev = pMap->pEnd;
+		pMap->pEnd = pKVP;
+	}
+	pMap->size++;
+	return pKVP + 1;
+}
+
+void LegacyHashmapDeInit(struct LegacyHashMap* pMap)
+{
+	struct LegacyKVP* pKVP = pMap->pHead;
+	while (pKVP)
+	{
+		free(pKVP->pKey);
+		pKVP = pKVP->pNext;
+	}
+	free(pMap->pData);
+}
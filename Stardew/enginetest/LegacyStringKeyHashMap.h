@@ -0,0 +1,36 @@
+#ifndef LEGACY_STRING_KEY_HASH_MAP_H
+#define LEGACY_STRING_KEY_HASH_MAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	The linear probing djb2 StringKeyHashMap the swiss table replaced, kept only so
+	HashMap.Benchmark100k can time the new map against it. Lookups compare hashes only,
+	so don't use it for anything else.
+*/
+
+struct LegacyKVP;
+
+struct LegacyHashMap
+{
+	int capacity;
+	int size;
+	int valueSize;
+	void* pData;
+	struct LegacyKVP* pHead;
+	struct LegacyKVP* pEnd;
+	float fLoadFactor;
+};
+
+void LegacyHashmapInit(struct LegacyHashMap* pMap, int capacity, int valSize);
+void* LegacyHashmapSearch(struct LegacyHashMap* pMap, const char* key);
+void* LegacyHashmapInsert(struct LegacyHashMap* pMap, const char* key, void* pVal);
+void LegacyHashmapDeInit(struct LegacyHashMap* pMap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
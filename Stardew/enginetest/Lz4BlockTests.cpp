@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "Lz4Block.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static std::vector<u8> Compress(const std::vector<u8>& src)
+{
+    std::vector<u8> compressed(Lz_CompressBound(src.size()));
+    size_t size = Lz_CompressBlock(src.data(), src.size(), compressed.data(), compressed.size());
+    compressed.resize(size);
+    return compressed;
+}
+
+static void ExpectRoundTrip(const std::vector<u8>& src)
+{
+    std::vector<u8> compressed = Compress(src);
+    ASSERT_GT(compressed.size(), 0u);
+    ASSERT_LE(compressed.size(), Lz_CompressBound(src.size()));
+    std::vector<u8> decompressed(src.size() + 1);
+    ASSERT_EQ(Lz_DecompressBlock(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()), (i64)src.size());
+    decompressed.resize(src.size());
+    ASSERT_EQ(decompressed, src);
+}
+
+TEST(Lz4Block, RoundTripsEmptyAndTiny)
+{
+    ExpectRoundTrip({});
+    ExpectRoundTrip({ 7 });
+    ExpectRoundTrip({ 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1 });
+}
+
+TEST(Lz4Block, RoundTripsRunsAndNoise)
+{
+    srand(4321);
+    std::vector<u8> src;
+    for (int i = 0; i < 300000; i++)
+    {
+        switch ((i / 1000) % 3)
+        {
+        case 0: src.push_back(0); break;
+        case 1: src.push_back((u8)(rand() & 0xff)); break;
+        case 2: src.push_back((u8)(i % 7)); break;
+        }
+    }
+    ExpectRoundTrip(src);
+
+    /* incompressible data grows by at most the bound */
+    std::vector<u8> noise(70000);
+    for (u8& b : noise)
+    {
+        b = (u8)(rand() & 0xff);
+    }
+    ExpectRoundTrip(noise);
+}
+
+TEST(Lz4Block, CompressesRuns)
+{
+    std::vector<u8> src(20000, 0xab);
+    ASSERT_LT(Compress(src).size(), 100u);
+}
+
+TEST(Lz4Block, RejectsSmallDestination)
+{
+    std::vector<u8> src(100, 1);
+    std::vector<u8> dst(Lz_CompressBound(src.size()) - 1);
+    ASSERT_EQ(Lz_CompressBlock(src.data(), src.size(), dst.data(), dst.size()), 0u);
+
+    std::vector<u8> compressed = Compress(src);
+    std::vector<u8> decompressed(src.size() - 1);
+    ASSERT_EQ(Lz_DecompressBlock(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()), -1);
+}
+
+TEST(Lz4Block, DecompressesReferenceBlock)
+{
+    /* "abcabcabcabcabcabc!!!!!" as a reference LZ4 implementation writes it: 3 literals, offset 3 match of 15, 5 literals */
+    const u8 block[] = { 0x3b, 'a', 'b', 'c', 0x03, 0x00, 0x50, '!', '!', '!', '!', '!' };
+    const char* expected = "abcabcabcabcabcabc!!!!!";
+    std::vector<u8> out(64);
+    ASSERT_EQ(Lz_DecompressBlock(block, sizeof(block), out.data(), out.size()), (i64)strlen(expected));
+    ASSERT_EQ(memcmp(out.data(), expected, strlen(expected)), 0);
+}
+
+TEST(Lz4Block, RejectsMalformedBlocks)
+{
+    std::vector<u8> out(64);
+    /* literal length runs past the end of the block */
+    const u8 shortLiterals[] = { 0x50, 'a', 'b' };
+    ASSERT_EQ(Lz_DecompressBlock(shortLiterals, sizeof(shortLiterals), out.data(), out.size()), -1);
+    /* offset of 0 */
+    const u8 zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    ASSERT_EQ(Lz_DecompressBlock(zeroOffset, sizeof(zeroOffset), out.data(), out.size()), -1);
+    /* offset before the start of the output */
+    const u8 farOffset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    ASSERT_EQ(Lz_DecompressBlock(farOffset, sizeof(farOffset), out.data(), out.size()), -1);
+    /* truncated extra length bytes */
+    const u8 truncatedLength[] = { 0xf0, 0xff };
+    ASSERT_EQ(Lz_DecompressBlock(truncatedLength, sizeof(truncatedLength), out.data(), out.size()), -1);
+    /* truncated offset */
+    const u8 truncatedOffset[] = { 0x10, 'a', 0x01 };
+    ASSERT_EQ(Lz_DecompressBlock(truncatedOffset, sizeof(truncatedOffset), out.data(), out.size()), -1);
+}
@@ -1,11 +1,16 @@
 #include <gtest/gtest.h>
 #include "ObjectPool.h"
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
 
 template<typename T>
 struct ScopedObjectPool
 {
-    ScopedObjectPool(int size)
-        :pPool(NEW_OBJECT_POOL(T, size))
+    ScopedObjectPool(int size, bool bGenerational = false)
+        :pPool(bGenerational ? NEW_GENERATIONAL_OBJECT_POOL(T, size) : NEW_OBJECT_POOL(T, size))
     {
 
     }
@@ -120,4 +125,183 @@ TEST(ObjectPool, FreeObjectPoolIndex)
 
     ASSERT_EQ(ObjectPoolCapacity(pool.pPool), 5);
     
-}
\ No newline at end of file
+}
+
+TEST(ObjectPool, DoubleFreeIgnored)
+{
+    ScopedObjectPool<int> pool{4};
+    int indices[4];
+    for(int i=0; i<4; i++)
+    {
+        pool.pPool = (int*)GetObjectPoolIndex(pool.pPool, &indices[i]);
+    }
+    ASSERT_EQ(ObjectPoolFreeArraySize(pool.pPool), 0);
+    FreeObjectPoolIndex(pool.pPool, indices[1]);
+    ASSERT_EQ(ObjectPoolFreeArraySize(pool.pPool), 1);
+    ASSERT_FALSE(ObjectPoolIndexOccupied(pool.pPool, indices[1]));
+    FreeObjectPoolIndex(pool.pPool, indices[1]);
+    ASSERT_EQ(ObjectPoolFreeArraySize(pool.pPool), 1);
+}
+
+TEST(ObjectPool, OccupancySurvivesRealloc)
+{
+    ScopedObjectPool<int> pool{2};
+    int indices[5];
+    for(int i=0; i<5; i++)
+    {
+        pool.pPool = (int*)GetObjectPoolIndex(pool.pPool, &indices[i]);
+    }
+    ASSERT_EQ(ObjectPoolCapacity(pool.pPool), 8);
+    for(int i=0; i<5; i++)
+    {
+        ASSERT_TRUE(ObjectPoolIndexOccupied(pool.pPool, indices[i]));
+    }
+    int numOccupied = 0;
+    for(int i=0; i<8; i++)
+    {
+        numOccupied += ObjectPoolIndexOccupied(pool.pPool, i) ? 1 : 0;
+    }
+    ASSERT_EQ(numOccupied, 5);
+    ASSERT_FALSE(ObjectPoolIndexOccupied(pool.pPool, -1));
+    ASSERT_FALSE(ObjectPoolIndexOccupied(pool.pPool, 8));
+}
+
+TEST(ObjectPool, InternalArraysAlignedForOddObjectSize)
+{
+    struct ThreeBytes { char c[3]; };
+    ScopedObjectPool<ThreeBytes> pool{3, true};
+    for(int i=0; i<7; i++)
+    {
+        int index;
+        pool.pPool = (ThreeBytes*)GetObjectPoolIndex(pool.pPool, &index);
+        struct ObjectPoolData* pData = ((struct ObjectPoolData*)pool.pPool) - 1;
+        ASSERT_EQ((uintptr_t)pData->freeObjectIndicessArray % alignof(u64), 0u);
+        ASSERT_EQ((uintptr_t)pData->occupancyBits % alignof(u64), 0u);
+        ASSERT_TRUE(ObjectPoolIndexOccupied(pool.pPool, index));
+    }
+}
+
+TEST(ObjectPool, GenerationalHandleValid)
+{
+    ScopedObjectPool<int> pool{4, true};
+    HGeneric handles[4];
+    for(int i=0; i<4; i++)
+    {
+        pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &handles[i]);
+        *ObjectPoolAtHandle(pool.pPool, handles[i]) = i * 10;
+    }
+    for(int i=0; i<4; i++)
+    {
+        ASSERT_TRUE(ObjectPoolHandleValid(pool.pPool, handles[i]));
+        ASSERT_EQ(*ObjectPoolAtHandle(pool.pPool, handles[i]), i * 10);
+    }
+    ASSERT_FALSE(ObjectPoolHandleValid(pool.pPool, NULL_HANDLE));
+}
+
+TEST(ObjectPool, GenerationalStaleHandleRejected)
+{
+    ScopedObjectPool<int> pool{1, true};
+    HGeneric hFirst = NULL_HANDLE;
+    pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &hFirst);
+    ASSERT_TRUE(FreeObjectPoolHandle(pool.pPool, hFirst));
+    ASSERT_FALSE(ObjectPoolHandleValid(pool.pPool, hFirst));
+
+    /* the recycled slot has the same index but a new generation */
+    HGeneric hSecond = NULL_HANDLE;
+    pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &hSecond);
+    ASSERT_EQ(ObjectPoolHandleIndex(hFirst), ObjectPoolHandleIndex(hSecond));
+    ASSERT_NE(hFirst, hSecond);
+    ASSERT_TRUE(ObjectPoolHandleValid(pool.pPool, hSecond));
+    ASSERT_FALSE(ObjectPoolHandleValid(pool.pPool, hFirst));
+
+    /* freeing through the stale handle must not free the new occupant */
+    ASSERT_FALSE(FreeObjectPoolHandle(pool.pPool, hFirst));
+    ASSERT_TRUE(ObjectPoolHandleValid(pool.pPool, hSecond));
+    ASSERT_EQ(ObjectPoolFreeArraySize(pool.pPool), 0);
+}
+
+TEST(ObjectPool, GenerationalDoubleFree)
+{
+    ScopedObjectPool<int> pool{4, true};
+    HGeneric h = NULL_HANDLE;
+    pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &h);
+    ASSERT_TRUE(FreeObjectPoolHandle(pool.pPool, h));
+    ASSERT_FALSE(FreeObjectPoolHandle(pool.pPool, h));
+    ASSERT_EQ(ObjectPoolFreeArraySize(pool.pPool), 4);
+}
+
+TEST(ObjectPool, GenerationalHandlesSurviveRealloc)
+{
+    ScopedObjectPool<int> pool{2, true};
+    HGeneric hStale = NULL_HANDLE;
+    pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &hStale);
+    FreeObjectPoolHandle(pool.pPool, hStale);
+
+    std::vector<HGeneric> handles;
+    for(int i=0; i<9; i++)
+    {
+        HGeneric h = NULL_HANDLE;
+        pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &h);
+        *ObjectPoolAtHandle(pool.pPool, h) = i;
+        handles.push_back(h);
+    }
+    ASSERT_EQ(ObjectPoolCapacity(pool.pPool), 16);
+    for(int i=0; i<9; i++)
+    {
+        ASSERT_TRUE(ObjectPoolHandleValid(pool.pPool, handles[i]));
+        ASSERT_EQ(*ObjectPoolAtHandle(pool.pPool, handles[i]), i);
+    }
+    ASSERT_FALSE(ObjectPoolHandleValid(pool.pPool, hStale));
+}
+
+/*
+    Not a correctness test - times alloc/free churn on a 100k slot pool.
+    With the old linear free list scan each free was O(free slots), so this took seconds.
+*/
+template<bool bGenerational>
+static double ChurnNsPerOp(int numSlots, int numOps)
+{
+    ScopedObjectPool<int> pool{numSlots, bGenerational};
+    std::vector<HGeneric> live;
+    live.reserve(numSlots);
+    /* fill half the pool so the free list is long */
+    for(int i=0; i<numSlots / 2; i++)
+    {
+        HGeneric h;
+        if(bGenerational)
+            pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &h);
+        else
+            pool.pPool = (int*)GetObjectPoolIndex(pool.pPool, &h);
+        live.push_back(h);
+    }
+    srand(1234);
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int i=0; i<numOps; i++)
+    {
+        int victim = rand() % live.size();
+        if(bGenerational)
+        {
+            FreeObjectPoolHandle(pool.pPool, live[victim]);
+            pool.pPool = (int*)GetObjectPoolHandle(pool.pPool, &live[victim]);
+        }
+        else
+        {
+            FreeObjectPoolIndex(pool.pPool, live[victim]);
+            pool.pPool = (int*)GetObjectPoolIndex(pool.pPool, &live[victim]);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_EQ(ObjectPoolCapacity(pool.pPool), numSlots);
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)numOps;
+}
+
+TEST(ObjectPool, ChurnBenchmark100k)
+{
+    const int numSlots = 100000;
+    const int numOps = 1000000;
+    double plain = ChurnNsPerOp<false>(numSlots, numOps);
+    double generational = ChurnNsPerOp<true>(numSlots, numOps);
+    printf("ObjectPool churn, %i slots, %i free+alloc pairs:\n", numSlots, numOps);
+    printf("    index pool:        %.2f ns/op\n", plain);
+    printf("    generational pool: %.2f ns/op\n", generational);
+}
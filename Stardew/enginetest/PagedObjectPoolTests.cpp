@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "PagedObjectPool.h"
+#include "ObjectPool.h"
+#include <chrono>
+#include <vector>
+#include <cstdio>
+
+struct ScopedPagedObjectPool
+{
+    ScopedPagedObjectPool(int objectSize, int blockShift)
+        :pPool(InitPagedObjectPool(objectSize, blockShift))
+    {
+
+    }
+    ~ScopedPagedObjectPool()
+    {
+        FreePagedObjectPool(pPool);
+    }
+    struct PagedObjectPool* pPool;
+};
+
+TEST(PagedObjectPool, GetIndex)
+{
+    ScopedPagedObjectPool pool{sizeof(int), 3};
+    int indices[5];
+    int testValues[5] = {
+        42,
+        53,
+        6342,
+        4,
+        754
+    };
+    for(int i=0; i<5; i++)
+    {
+        indices[i] = GetPagedObjectPoolIndex(pool.pPool);
+        *PagedObjectPoolAt(int, pool.pPool, indices[i]) = testValues[i];
+    }
+    for(int i=0; i<5; i++)
+    {
+        ASSERT_EQ(*PagedObjectPoolAt(int, pool.pPool, indices[i]), testValues[i]);
+    }
+    ASSERT_EQ(PagedObjectPoolCapacity(pool.pPool), 8);
+}
+
+TEST(PagedObjectPool, PointersStableAcrossGrowth)
+{
+    ScopedPagedObjectPool pool{sizeof(double), 2};
+    int first = GetPagedObjectPoolIndex(pool.pPool);
+    double* pFirst = PagedObjectPoolAt(double, pool.pPool, first);
+    *pFirst = 3.5;
+    std::vector<double*> pointers;
+    for(int i=0; i<100; i++)
+    {
+        int index = GetPagedObjectPoolIndex(pool.pPool);
+        double* p = PagedObjectPoolAt(double, pool.pPool, index);
+        *p = (double)i;
+        pointers.push_back(p);
+    }
+    ASSERT_EQ(PagedObjectPoolCapacity(pool.pPool), 104);
+    ASSERT_EQ(pFirst, PagedObjectPoolAt(double, pool.pPool, first));
+    ASSERT_EQ(*pFirst, 3.5);
+    for(int i=0; i<100; i++)
+    {
+        ASSERT_EQ(*pointers[i], (double)i);
+    }
+}
+
+TEST(PagedObjectPool, FreeAndReuse)
+{
+    ScopedPagedObjectPool pool{sizeof(int), 2};
+    int indices[4];
+    for(int i=0; i<4; i++)
+    {
+        indices[i] = GetPagedObjectPoolIndex(pool.pPool);
+    }
+    ASSERT_EQ(pool.pPool->numAllocated, 4);
+    FreePagedObjectPoolIndex(pool.pPool, indices[2]);
+    ASSERT_FALSE(PagedObjectPoolIndexOccupied(pool.pPool, indices[2]));
+    ASSERT_EQ(pool.pPool->numAllocated, 3);
+
+    /* double free is ignored */
+    FreePagedObjectPoolIndex(pool.pPool, indices[2]);
+    ASSERT_EQ(pool.pPool->numAllocated, 3);
+
+    int reused = GetPagedObjectPoolIndex(pool.pPool);
+    ASSERT_EQ(reused, indices[2]);
+    ASSERT_TRUE(PagedObjectPoolIndexOccupied(pool.pPool, reused));
+    ASSERT_EQ(PagedObjectPoolCapacity(pool.pPool), 4);
+}
+
+TEST(PagedObjectPool, SmallObjectsPaddedForFreeList)
+{
+    ScopedPagedObjectPool pool{sizeof(char), 4};
+    ASSERT_EQ(pool.pPool->objectStride, (int)sizeof(int));
+    for(int i=0; i<40; i++)
+    {
+        int index = GetPagedObjectPoolIndex(pool.pPool);
+        *PagedObjectPoolAt(char, pool.pPool, index) = (char)i;
+    }
+    for(int i=0; i<40; i++)
+    {
+        ASSERT_EQ(*PagedObjectPoolAt(char, pool.pPool, i), (char)i);
+    }
+}
+
+/*
+    Not a correctness test - grows each pool kind from 512 to 65536 entity sized objects,
+    the pattern seen when a wooded area spawns its trees.
+*/
+struct FakeEntity
+{
+    char bytes[1024];
+};
+
+TEST(PagedObjectPool, GrowthBenchmark)
+{
+    const int numObjects = 65536;
+    const int numRuns = 5;
+    double pooledMs = 0.0;
+    double pagedMs = 0.0;
+    for(int run=0; run<numRuns; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        OBJECT_POOL(FakeEntity) pPool = NEW_OBJECT_POOL(FakeEntity, 512);
+        for(int i=0; i<numObjects; i++)
+        {
+            int index = 0;
+            pPool = (FakeEntity*)GetObjectPoolIndex(pPool, &index);
+            pPool[index].bytes[0] = (char)i;
+        }
+        FreeObjectPool(pPool);
+        auto mid = std::chrono::high_resolution_clock::now();
+
+        struct PagedObjectPool* pPaged = NEW_PAGED_OBJECT_POOL(FakeEntity, PAGED_OBJECT_POOL_DEFAULT_BLOCK_SHIFT);
+        for(int i=0; i<numObjects; i++)
+        {
+            int index = GetPagedObjectPoolIndex(pPaged);
+            PagedObjectPoolAt(FakeEntity, pPaged, index)->bytes[0] = (char)i;
+        }
+        FreePagedObjectPool(pPaged);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        pooledMs += std::chrono::duration<double, std::milli>(mid - start).count();
+        pagedMs += std::chrono::duration<double, std::milli>(end - mid).count();
+    }
+    printf("Growth 512 -> %i objects of %i bytes, mean of %i runs:\n", numObjects, (int)sizeof(FakeEntity), numRuns);
+    printf("    OBJECT_POOL (doubling realloc): %.2f ms\n", pooledMs / numRuns);
+    printf("    PAGED_OBJECT_POOL:              %.2f ms\n", pagedMs / numRuns);
+}
@@ -0,0 +1,197 @@
+#include "Profiler.h"
+
+#ifdef STARDEW_PROFILER
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "cJSON.h"
+
+class Profiler : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Prof_Init();
+    }
+
+    void TearDown() override
+    {
+        Prof_Shutdown();
+    }
+
+    const struct ProfileZoneStats* FindZone(const char* name)
+    {
+        int numZones = 0;
+        const struct ProfileZoneStats* pZones = Prof_GetZoneStats(&numZones);
+        for (int i = 0; i < numZones; i++)
+        {
+            if (strcmp(pZones[i].name, name) == 0)
+            {
+                return &pZones[i];
+            }
+        }
+        return nullptr;
+    }
+
+    cJSON* ExportAndParse()
+    {
+        const char* path = "ProfilerTestTrace.json";
+        EXPECT_TRUE(Prof_ExportChromeTrace(path));
+        std::ifstream file(path);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return cJSON_Parse(ss.str().c_str());
+    }
+
+    int CountEvents(cJSON* pTrace, const char* name, const char* phase, int tid = -1)
+    {
+        int count = 0;
+        cJSON* pEvent = nullptr;
+        cJSON_ArrayForEach(pEvent, cJSON_GetObjectItem(pTrace, "traceEvents"))
+        {
+            if (strcmp(cJSON_GetObjectItem(pEvent, "name")->valuestring, name) != 0 ||
+                strcmp(cJSON_GetObjectItem(pEvent, "ph")->valuestring, phase) != 0)
+            {
+                continue;
+            }
+            if (tid >= 0 && cJSON_GetObjectItem(pEvent, "tid")->valueint != tid)
+            {
+                continue;
+            }
+            count++;
+        }
+        return count;
+    }
+};
+
+TEST_F(Profiler, ZonesTotalledAtFrameMark)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        Prof_BeginZone("Outer");
+        Prof_BeginZone("Inner");
+        Prof_EndZone();
+        Prof_EndZone();
+    }
+    Prof_FrameMark();
+
+    const struct ProfileZoneStats* pOuter = FindZone("Outer");
+    const struct ProfileZoneStats* pInner = FindZone("Inner");
+    ASSERT_NE(pOuter, nullptr);
+    ASSERT_NE(pInner, nullptr);
+    ASSERT_EQ(pOuter->lastFrameCalls, 3);
+    ASSERT_EQ(pInner->lastFrameCalls, 3);
+    ASSERT_EQ(pOuter->depth, 0);
+    ASSERT_EQ(pInner->depth, 1);
+    ASSERT_GE(pOuter->lastFrameMs, pInner->lastFrameMs);
+
+    // a frame without the zones
+    Prof_FrameMark();
+    ASSERT_EQ(FindZone("Outer")->lastFrameCalls, 0);
+    ASSERT_EQ(FindZone("Outer")->lastFrameMs, 0.0);
+}
+
+TEST_F(Profiler, ZoneMacroTimesFollowingBlock)
+{
+    int ran = 0;
+    PROFILE_ZONE("Block")
+    {
+        ran++;
+        PROFILE_ZONE("Statement") ran++;
+    }
+    Prof_FrameMark();
+    ASSERT_EQ(ran, 2);
+    ASSERT_EQ(FindZone("Block")->lastFrameCalls, 1);
+    ASSERT_EQ(FindZone("Statement")->lastFrameCalls, 1);
+    ASSERT_EQ(FindZone("Statement")->depth, 1);
+}
+
+TEST_F(Profiler, CountersResetEachFrame)
+{
+    Prof_AddCounter(PC_DrawCalls, 2);
+    Prof_AddCounter(PC_VerticesDrawn, 600);
+    Prof_AddCounter(PC_DrawCalls, 1);
+    Prof_FrameMark();
+    struct ProfileFrameStats stats = Prof_GetLastFrameStats();
+    ASSERT_EQ(stats.frameIndex, 0);
+    ASSERT_EQ(stats.counters[PC_DrawCalls], 3);
+    ASSERT_EQ(stats.counters[PC_VerticesDrawn], 600);
+    ASSERT_EQ(stats.counters[PC_EntitiesUpdated], 0);
+
+    Prof_FrameMark();
+    stats = Prof_GetLastFrameStats();
+    ASSERT_EQ(stats.frameIndex, 1);
+    ASSERT_EQ(stats.counters[PC_DrawCalls], 0);
+}
+
+TEST_F(Profiler, RingBufferKeepsNewestZones)
+{
+    const int numZones = PROFILER_RING_BUFFER_SIZE + 100;
+    for (int i = 0; i < numZones; i++)
+    {
+        Prof_BeginZone("Many");
+        Prof_EndZone();
+    }
+    Prof_FrameMark();
+    ASSERT_EQ(FindZone("Many")->lastFrameCalls, PROFILER_RING_BUFFER_SIZE);
+
+    cJSON* pTrace = ExportAndParse();
+    ASSERT_NE(pTrace, nullptr);
+    ASSERT_EQ(CountEvents(pTrace, "Many", "X"), PROFILER_RING_BUFFER_SIZE);
+    cJSON_Delete(pTrace);
+}
+
+TEST_F(Profiler, ExportsChromeTrace)
+{
+    Prof_BeginZone("Game2D.OutputVertices");
+    Prof_EndZone();
+    Prof_AddCounter(PC_EntitiesUpdated, 7);
+    Prof_FrameMark();
+    Prof_FrameMark();
+
+    cJSON* pTrace = ExportAndParse();
+    ASSERT_NE(pTrace, nullptr);
+    ASSERT_EQ(CountEvents(pTrace, "Game2D.OutputVertices", "X", 0), 1);
+    ASSERT_EQ(CountEvents(pTrace, "Frame", "i"), 2);
+    ASSERT_EQ(CountEvents(pTrace, "EntitiesUpdated", "C"), 2);
+    ASSERT_EQ(CountEvents(pTrace, "thread_name", "M"), 1);
+
+    cJSON* pEvent = nullptr;
+    cJSON_ArrayForEach(pEvent, cJSON_GetObjectItem(pTrace, "traceEvents"))
+    {
+        if (strcmp(cJSON_GetObjectItem(pEvent, "name")->valuestring, "Game2D.OutputVertices") == 0)
+        {
+            ASSERT_GE(cJSON_GetObjectItem(pEvent, "ts")->valuedouble, 0.0);
+            ASSERT_GE(cJSON_GetObjectItem(pEvent, "dur")->valuedouble, 0.0);
+        }
+    }
+    cJSON_Delete(pTrace);
+}
+
+TEST_F(Profiler, EachThreadHasItsOwnBuffer)
+{
+    Prof_BeginZone("MainThreadZone");
+    std::thread worker([]()
+    {
+        Prof_BeginZone("WorkerZone");
+        Prof_EndZone();
+    });
+    worker.join();
+    Prof_EndZone();
+    Prof_FrameMark();
+
+    ASSERT_EQ(FindZone("WorkerZone")->lastFrameCalls, 1);
+    ASSERT_EQ(FindZone("MainThreadZone")->lastFrameCalls, 1);
+
+    cJSON* pTrace = ExportAndParse();
+    ASSERT_NE(pTrace, nullptr);
+    ASSERT_EQ(CountEvents(pTrace, "WorkerZone", "X", 1), 1);
+    ASSERT_EQ(CountEvents(pTrace, "MainThreadZone", "X", 0), 1);
+    cJSON_Delete(pTrace);
+}
+
+#endif
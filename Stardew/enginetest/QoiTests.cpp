@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "Qoi.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static std::vector<u8> Encode(const std::vector<u8>& rgba)
+{
+    std::vector<u8> encoded(Qoi_EncodeBound(rgba.size() / 4));
+    size_t size = Qoi_Encode(rgba.data(), rgba.size() / 4, encoded.data(), encoded.size());
+    encoded.resize(size);
+    return encoded;
+}
+
+static void ExpectRoundTrip(const std::vector<u8>& rgba)
+{
+    std::vector<u8> encoded = Encode(rgba);
+    std::vector<u8> decoded(rgba.size());
+    ASSERT_TRUE(Qoi_Decode(encoded.data(), encoded.size(), decoded.data(), rgba.size() / 4));
+    ASSERT_EQ(decoded, rgba);
+}
+
+TEST(Qoi, RoundTripsEmptyAndTiny)
+{
+    ExpectRoundTrip({});
+    ExpectRoundTrip({ 0, 0, 0, 255 });
+    ExpectRoundTrip({ 1, 2, 3, 4 });
+}
+
+TEST(Qoi, RoundTripsEveryOp)
+{
+    srand(1234);
+    std::vector<u8> rgba;
+    u8 px[4] = { 10, 20, 30, 255 };
+    for (int i = 0; i < 20000; i++)
+    {
+        switch ((i / 100) % 6)
+        {
+        case 0: /* runs, longer than the longest run op */
+            break;
+        case 1: /* small differences */
+            px[0] += rand() % 3 - 1; px[1] += rand() % 3 - 1; px[2] += rand() % 3 - 1;
+            break;
+        case 2: /* luma sized differences */
+            px[1] += rand() % 40 - 20; px[0] = px[1] + rand() % 10; px[2] = px[1] - rand() % 10;
+            break;
+        case 3: /* new rgb */
+            px[0] = rand(); px[1] = rand(); px[2] = rand();
+            break;
+        case 4: /* new alpha */
+            px[0] = rand(); px[3] = rand();
+            break;
+        case 5: /* a few colours repeating, for the index op */
+            px[0] = (i % 5) * 40; px[1] = 7; px[2] = (i % 5); px[3] = 255;
+            break;
+        }
+        rgba.insert(rgba.end(), px, px + 4);
+    }
+    ExpectRoundTrip(rgba);
+}
+
+TEST(Qoi, CompressesRuns)
+{
+    std::vector<u8> rgba(256 * 256 * 4, 0);
+    /* 62 pixels per run op */
+    ASSERT_LE(Encode(rgba).size(), (size_t)(256 * 256 / 62 + 2));
+}
+
+TEST(Qoi, RejectsSmallDestination)
+{
+    std::vector<u8> rgba(100 * 4, 1);
+    std::vector<u8> dst(Qoi_EncodeBound(100) - 1);
+    ASSERT_EQ(Qoi_Encode(rgba.data(), 100, dst.data(), dst.size()), 0u);
+}
+
+TEST(Qoi, DecodesReferenceOps)
+{
+    /* RGB, DIFF +1 +0 -1, LUMA green +4, INDEX of the first pixel, RUN of 2 */
+    const u8 ops[] = { 0xfe, 100, 150, 200, 0x40 | 3 << 4 | 2 << 2 | 1, 0x80 | 36, 0x88, 7, 0xc1 };
+    const u8 expected[] = {
+        100, 150, 200, 255,
+        101, 150, 199, 255,
+        105, 154, 203, 255,
+        100, 150, 200, 255,
+        100, 150, 200, 255,
+        100, 150, 200, 255,
+    };
+    ASSERT_EQ((100 * 3 + 150 * 5 + 200 * 7 + 255 * 11) % 64, 7);
+    std::vector<u8> out(sizeof(expected));
+    ASSERT_TRUE(Qoi_Decode(ops, sizeof(ops), out.data(), sizeof(expected) / 4));
+    ASSERT_EQ(memcmp(out.data(), expected, sizeof(expected)), 0);
+}
+
+TEST(Qoi, RejectsMalformedStreams)
+{
+    std::vector<u8> out(64 * 4);
+    /* truncated RGB op */
+    const u8 truncatedRGB[] = { 0xfe, 1, 2 };
+    ASSERT_FALSE(Qoi_Decode(truncatedRGB, sizeof(truncatedRGB), out.data(), 1));
+    /* truncated RGBA op */
+    const u8 truncatedRGBA[] = { 0xff, 1, 2, 3 };
+    ASSERT_FALSE(Qoi_Decode(truncatedRGBA, sizeof(truncatedRGBA), out.data(), 1));
+    /* truncated LUMA op */
+    const u8 truncatedLuma[] = { 0x80 };
+    ASSERT_FALSE(Qoi_Decode(truncatedLuma, sizeof(truncatedLuma), out.data(), 1));
+    /* run past the end of the image */
+    const u8 longRun[] = { 0xc0 | 9 };
+    ASSERT_FALSE(Qoi_Decode(longRun, sizeof(longRun), out.data(), 4));
+    /* too few pixels, then too many ops */
+    const u8 twoPixels[] = { 0xc1 };
+    ASSERT_FALSE(Qoi_Decode(twoPixels, sizeof(twoPixels), out.data(), 3));
+    const u8 extraOps[] = { 0xc0, 0xc0 };
+    ASSERT_FALSE(Qoi_Decode(extraOps, sizeof(extraOps), out.data(), 1));
+}
@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+extern "C" {
+#include "SharedPtr.h"
+}
+
+static int gDestroyedValue = 0;
+static int gNumDestroyed = 0;
+
+static void RecordDestroyed(void* pVal)
+{
+    gDestroyedValue = *(int*)pVal;
+    gNumDestroyed++;
+}
+
+TEST(SharedPtr, DestructorGetsTheValueWhenTheLastReferenceGoes)
+{
+    gDestroyedValue = 0;
+    gNumDestroyed = 0;
+    SHARED_PTR(int) pVal = (int*)SHARED_PTR_NEW(int, &RecordDestroyed);
+    *pVal = 1234;
+    Sptr_AddRef(pVal);
+    Sptr_RemoveRef(pVal);
+    ASSERT_EQ(gNumDestroyed, 0);
+    Sptr_RemoveRef(pVal);
+    ASSERT_EQ(gNumDestroyed, 1);
+    ASSERT_EQ(gDestroyedValue, 1234);
+}
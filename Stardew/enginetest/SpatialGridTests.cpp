@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+#include "Game2DEntityFixture.h"
+extern "C" {
+#include "SpatialGrid.h"
+#include "Geometry.h"
+}
+
+#define TEST_WORLD_SIZE_PX 1000.0f
+
+struct TestBox
+{
+    vec2 tl;
+    vec2 br;
+    HSpatialGridItem hItem;
+};
+
+static void RandomBox(std::mt19937& rng, TestBox* pBox)
+{
+    /* some outside the grid */
+    std::uniform_real_distribution<float> pos(-100.0f, TEST_WORLD_SIZE_PX + 100.0f);
+    std::uniform_real_distribution<float> size(1.0f, 200.0f);
+    pBox->tl[0] = pos(rng);
+    pBox->tl[1] = pos(rng);
+    pBox->br[0] = pBox->tl[0] + size(rng);
+    pBox->br[1] = pBox->tl[1] + size(rng);
+}
+
+static std::set<HEntity2D> ToSet(VECTOR(HEntity2D) pFound)
+{
+    std::set<HEntity2D> found(pFound, pFound + VectorSize(pFound));
+    EXPECT_EQ(found.size(), VectorSize(pFound)) << "an entity was found twice";
+    return found;
+}
+
+static void ExpectQueriesMatchBruteForce(std::mt19937& rng, struct SpatialGrid* pGrid, std::vector<TestBox>& boxes, std::vector<bool>& alive)
+{
+    VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+    std::uniform_real_distribution<float> radius(0.0f, 150.0f);
+    for (int i = 0; i < 20; i++)
+    {
+        TestBox region;
+        RandomBox(rng, &region);
+        std::set<HEntity2D> expected;
+        for (size_t j = 0; j < boxes.size(); j++)
+        {
+            if (alive[j] && Ge_AABBIntersect(region.tl, region.br, boxes[j].tl, boxes[j].br))
+            {
+                expected.insert((HEntity2D)j);
+            }
+        }
+        pFound = (HEntity2D*)VectorClear(pFound);
+        pFound = SG_QueryRect(pGrid, region.tl, region.br, pFound);
+        ASSERT_EQ(ToSet(pFound), expected);
+
+        float r = radius(rng);
+        expected.clear();
+        for (size_t j = 0; j < boxes.size(); j++)
+        {
+            if (alive[j] && Ge_CircleAABBIntersect(region.tl, r, boxes[j].tl, boxes[j].br))
+            {
+                expected.insert((HEntity2D)j);
+            }
+        }
+        pFound = (HEntity2D*)VectorClear(pFound);
+        pFound = SG_QueryRadius(pGrid, region.tl, r, pFound);
+        ASSERT_EQ(ToSet(pFound), expected);
+    }
+    DestoryVector(pFound);
+}
+
+TEST(SpatialGrid, QueriesMatchBruteForceAsItemsMoveAndAreRemoved)
+{
+    std::mt19937 rng(99);
+    struct SpatialGrid grid;
+    vec2 tl = { 0.0f, 0.0f };
+    SG_Init(&grid, tl, TEST_WORLD_SIZE_PX, TEST_WORLD_SIZE_PX, 64.0f);
+    std::vector<TestBox> boxes(400);
+    std::vector<bool> alive(boxes.size(), true);
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        RandomBox(rng, &boxes[i]);
+        boxes[i].hItem = SG_Insert(&grid, (HEntity2D)i, boxes[i].tl, boxes[i].br);
+    }
+    ExpectQueriesMatchBruteForce(rng, &grid, boxes, alive);
+
+    std::uniform_real_distribution<float> step(-30.0f, 30.0f);
+    for (int frame = 0; frame < 10; frame++)
+    {
+        for (TestBox& box : boxes)
+        {
+            float dx = step(rng), dy = step(rng);
+            box.tl[0] += dx;
+            box.br[0] += dx;
+            box.tl[1] += dy;
+            box.br[1] += dy;
+            SG_Move(&grid, box.hItem, box.tl, box.br);
+        }
+        ExpectQueriesMatchBruteForce(rng, &grid, boxes, alive);
+    }
+
+    for (size_t i = 0; i < boxes.size(); i += 2)
+    {
+        SG_Remove(&grid, boxes[i].hItem);
+        alive[i] = false;
+    }
+    ExpectQueriesMatchBruteForce(rng, &grid, boxes, alive);
+    SG_Destroy(&grid);
+}
+
+/* a Game2D layers entities with either broadphase, without the rest of the layer */
+class Game2DBroadphaseTest : public ::testing::TestWithParam<enum Game2DBroadphase>, protected Game2DEntityFixture
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        InitQuadtreeSystem();
+    }
+
+    void SetUp() override
+    {
+        InitEntities();
+        layerData.broadphase = GetParam();
+        struct Entity2DQuadTreeInitArgs args = { 0, 0, (int)TEST_WORLD_SIZE_PX, (int)TEST_WORLD_SIZE_PX };
+        layerData.hEntitiesQuadTree = GetEntity2DQuadTree(&args);
+        vec2 tl = { 0.0f, 0.0f };
+        SG_Init(&layerData.entityGrid, tl, TEST_WORLD_SIZE_PX, TEST_WORLD_SIZE_PX, 100.0f);
+    }
+
+    void TearDown() override
+    {
+        DestroyEntities();
+        DestroyEntity2DQuadTree(layerData.hEntitiesQuadTree);
+        SG_Destroy(&layerData.entityGrid);
+    }
+
+    struct Entity2D* AddEntity(float x, float y, bool bDynamic)
+    {
+        HEntity2D hEnt = Game2DEntityFixture::AddEntity(x, y, &SquareGetBoundingBox);
+        struct Entity2D* pEnt = Et2D_GetEntity(&layerData.entities, hEnt);
+        pEnt->bKeepInQuadtree = !bDynamic;
+        pEnt->bKeepInDynamicList = bDynamic;
+        Et2D_AddToBroadphase(&layer, pEnt);
+        return pEnt;
+    }
+
+    std::set<HEntity2D> Cull(float x, float y, float w, float h)
+    {
+        vec2 tl = { x, y };
+        vec2 br = { x + w, y + h };
+        VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+        pFound = Game2DLayer_CullEntities(&layerData, tl, br, pFound);
+        std::set<HEntity2D> found = ToSet(pFound);
+        DestoryVector(pFound);
+        return found;
+    }
+
+    std::set<HEntity2D> InRadius(float x, float y, float radius)
+    {
+        vec2 center = { x, y };
+        VECTOR(HEntity2D) pFound = NEW_VECTOR(HEntity2D);
+        pFound = Game2DLayer_QueryEntitiesInRadius(&layerData, center, radius, pFound);
+        std::set<HEntity2D> found = ToSet(pFound);
+        DestoryVector(pFound);
+        return found;
+    }
+};
+
+TEST_P(Game2DBroadphaseTest, FindsStaticAndMovingEntities)
+{
+    HEntity2D hTree = AddEntity(100.0f, 100.0f, false)->thisEntity;
+    struct Entity2D* pWalker = AddEntity(500.0f, 500.0f, true);
+    HEntity2D hWalker = pWalker->thisEntity;
+    struct Entity2D* pMover = AddEntity(800.0f, 100.0f, false);
+    HEntity2D hMover = pMover->thisEntity;
+
+    ASSERT_EQ(Cull(0.0f, 0.0f, 200.0f, 200.0f), std::set<HEntity2D>({ hTree }));
+    ASSERT_EQ(Cull(450.0f, 450.0f, 100.0f, 100.0f), std::set<HEntity2D>({ hWalker }));
+
+    /* dynamic list entities only need their bounding box marking dirty */
+    pWalker->transform.position[0] = 120.0f;
+    pWalker->transform.position[1] = 120.0f;
+    Et2D_MarkBoundingBoxDirty(pWalker);
+    pMover->transform.position[0] = 90.0f;
+    Et2D_BroadphaseMove(&layer, pMover);
+    ASSERT_EQ(Cull(0.0f, 0.0f, 200.0f, 200.0f), std::set<HEntity2D>({ hTree, hWalker, hMover }));
+    ASSERT_TRUE(Cull(450.0f, 450.0f, 100.0f, 100.0f).empty());
+
+    /* from (80, 80) the closest points of the boxes are about 22.4 (mover), 28.3 (tree) and 56.6 (walker) away */
+    ASSERT_EQ(InRadius(80.0f, 80.0f, 20.0f), std::set<HEntity2D>());
+    ASSERT_EQ(InRadius(80.0f, 80.0f, 25.0f), std::set<HEntity2D>({ hMover }));
+    ASSERT_EQ(InRadius(80.0f, 80.0f, 29.0f), std::set<HEntity2D>({ hTree, hMover }));
+    ASSERT_EQ(InRadius(80.0f, 80.0f, 57.0f), std::set<HEntity2D>({ hTree, hWalker, hMover }));
+
+    Et2D_DestroyEntity(&layer, &layerData.entities, hTree);
+    ASSERT_EQ(Cull(0.0f, 0.0f, 200.0f, 200.0f), std::set<HEntity2D>({ hWalker, hMover }));
+}
+
+/* the bottom right quarter of the fixture's square */
+static void BottomRightQuarterGetBoundingBox(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, vec2 outTL, vec2 outBR)
+{
+    Game2DEntityFixture::SquareGetBoundingBox(pEnt, pLayer, outTL, outBR);
+    outTL[0] += GAME2D_FIXTURE_ENTITY_SIZE_PX / 2.0f;
+    outTL[1] += GAME2D_FIXTURE_ENTITY_SIZE_PX / 2.0f;
+}
+
+TEST_P(Game2DBroadphaseTest, QueriesUseTheCachedBoundingBoxes)
+{
+    struct Entity2D* pWalker = AddEntity(500.0f, 500.0f, true);
+    HEntity2D hWalker = pWalker->thisEntity;
+    struct Entity2D* pTree = AddEntity(100.0f, 100.0f, false);
+    HEntity2D hTree = pTree->thisEntity;
+
+    /* reading the bounding box before the cull, as drawing or collision might, doesn't lose the move */
+    pWalker->transform.position[0] = 120.0f;
+    pWalker->transform.position[1] = 120.0f;
+    Et2D_MarkBoundingBoxDirty(pWalker);
+    vec2 tl, br;
+    Et2D_GetBoundingBox(pWalker, &layer, tl, br);
+    ASSERT_EQ(Cull(137.0f, 137.0f, 5.0f, 5.0f), std::set<HEntity2D>());
+    ASSERT_EQ(Cull(130.0f, 130.0f, 5.0f, 5.0f), std::set<HEntity2D>({ hWalker }));
+    ASSERT_TRUE(Cull(450.0f, 450.0f, 100.0f, 100.0f).empty());
+
+    /* a static entity whose box changes without being moved in the broadphase, like an animation frame */
+    pTree->getBB = &BottomRightQuarterGetBoundingBox;
+    Et2D_MarkBoundingBoxDirty(pTree);
+    ASSERT_EQ(Cull(101.0f, 101.0f, 3.0f, 3.0f), std::set<HEntity2D>());
+    ASSERT_EQ(Cull(110.0f, 110.0f, 2.0f, 2.0f), std::set<HEntity2D>({ hTree }));
+    ASSERT_EQ(InRadius(104.0f, 104.0f, 2.0f), std::set<HEntity2D>());
+    ASSERT_EQ(InRadius(110.0f, 110.0f, 1.0f), std::set<HEntity2D>({ hTree }));
+}
+
+INSTANTIATE_TEST_SUITE_P(Broadphases, Game2DBroadphaseTest, ::testing::Values(G2DBP_Quadtree, G2DBP_SpatialGrid));
@@ -1,11 +1,14 @@
 #include <gtest/gtest.h>
 #include "StringKeyHashMap.h"
+#include "LegacyStringKeyHashMap.h"
 #include <iostream>
 #include <vector>
 #include <list>
 #include <string>
 #include <cstdlib>
 #include <cstdio>
+#include <chrono>
+#include <unordered_map>
 
 bool gOverrideFuzzTestSeed = false;
 unsigned int gFuzzTestSeed = 0;
@@ -277,6 +280,173 @@ TEST(HashMap, HashmapKeyIterator)
 	HashmapDeInit(&hashMap);
 }
 
+TEST(HashMap, KeysWithEqualHashesAreDistinct)
+{
+	struct HashMap hashMap;
+	HashmapInit(&hashMap, 10, sizeof(int));
+
+	/* force every key onto the same hash to exercise the full key compare */
+	const u32 hash = 42;
+	const char* keys[] = { "apple", "banana", "cherry", "damson", "elderberry", "fig", "grape", "huckleberry", "kiwi", "lemon" };
+	const int numKeys = sizeof(keys) / sizeof(keys[0]);
+	for (int i = 0; i < numKeys; i++)
+	{
+		ASSERT_NE(HashmapInsertHashed(&hashMap, keys[i], hash, &i), nullptr);
+	}
+	ASSERT_EQ(hashMap.size, numKeys);
+	for (int i = 0; i < numKeys; i++)
+	{
+		int* pInt = (int*)HashmapSearchHashed(&hashMap, keys[i], hash);
+		ASSERT_NE(pInt, nullptr);
+		ASSERT_EQ(*pInt, i) << keys[i];
+	}
+	ASSERT_EQ(HashmapSearchHashed(&hashMap, "mango", hash), nullptr);
+
+	/* overwrite only touches the matching key */
+	int overwritten = 100;
+	ASSERT_EQ(HashmapInsertHashed(&hashMap, "cherry", hash, &overwritten), nullptr);
+	ASSERT_EQ(*(int*)HashmapSearchHashed(&hashMap, "cherry", hash), 100);
+	ASSERT_EQ(*(int*)HashmapSearchHashed(&hashMap, "banana", hash), 1);
+	HashmapDeInit(&hashMap);
+}
+
+TEST(HashMap, Djb2CollidingKeys)
+{
+	/* "aA" and "b " have the same djb2 hash, the map used to compare hashes only and return the wrong value */
+	struct HashMap hashMap;
+	HashmapInit(&hashMap, 10, sizeof(int));
+	int i = 1;
+	HashmapInsert(&hashMap, "aA", &i);
+	ASSERT_EQ(HashmapSearch(&hashMap, "b "), nullptr);
+	i = 2;
+	ASSERT_NE(HashmapInsert(&hashMap, "b ", &i), nullptr);
+	ASSERT_EQ(hashMap.size, 2);
+	ASSERT_EQ(*(int*)HashmapSearch(&hashMap, "aA"), 1);
+	ASSERT_EQ(*(int*)HashmapSearch(&hashMap, "b "), 2);
+	ASSERT_TRUE(HashmapDeleteItem(&hashMap, "aA"));
+	ASSERT_EQ(HashmapSearch(&hashMap, "aA"), nullptr);
+	ASSERT_EQ(*(int*)HashmapSearch(&hashMap, "b "), 2);
+	HashmapDeInit(&hashMap);
+}
+
+TEST(HashMap, PrecomputedHashMatchesSearch)
+{
+	struct HashMap hashMap;
+	HashmapInit(&hashMap, 10, sizeof(int));
+	int i = 7;
+	HashmapInsert(&hashMap, "walk-base-male-up", &i);
+	u32 hash = HashmapHashKey("walk-base-male-up");
+	ASSERT_EQ(HashmapSearchHashed(&hashMap, "walk-base-male-up", hash), HashmapSearch(&hashMap, "walk-base-male-up"));
+	HashmapDeInit(&hashMap);
+}
+
+TEST(HashMap, ChurnReusesDeletedSlots)
+{
+	struct HashMap hashMap;
+	HashmapInit(&hashMap, 64, sizeof(int));
+	char key[32];
+	for (int round = 0; round < 1000; round++)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			sprintf(key, "key%i_%i", round, i);
+			int v = round * 16 + i;
+			HashmapInsert(&hashMap, key, &v);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			sprintf(key, "key%i_%i", round, i);
+			ASSERT_EQ(*(int*)HashmapSearch(&hashMap, key), round * 16 + i);
+			ASSERT_TRUE(HashmapDeleteItem(&hashMap, key));
+		}
+	}
+	ASSERT_EQ(hashMap.size, 0);
+	/* deleted entries are dropped on rehash rather than growing the table */
+	ASSERT_EQ(hashMap.capacity, 64);
+	HashmapDeInit(&hashMap);
+}
+
+/*
+	Not a correctness test - 100k inserts then 100k lookups of keys that look like
+	animation and event names. The map this one replaced (LegacyStringKeyHashMap.c) is
+	timed on the same keys, std::unordered_map given for reference.
+*/
+TEST(HashMap, Benchmark100k)
+{
+	const int numKeys = 100000;
+	const int numRuns = 5;
+	vector<string> keys;
+	keys.reserve(numKeys);
+	for (int i = 0; i < numKeys; i++)
+	{
+		keys.push_back("walk-base-" + to_string(i) + "-" + convertToWords(i % 1000));
+	}
+	double insertMs = 0.0, searchMs = 0.0, legacyInsertMs = 0.0, legacySearchMs = 0.0, stdInsertMs = 0.0, stdSearchMs = 0.0;
+	long long checksum = 0;
+	/* the legacy map only compares hashes, so djb2 collisions can return the wrong value - kept out of checksum */
+	long long legacyChecksum = 0;
+	for (int run = 0; run < numRuns; run++)
+	{
+		auto t0 = std::chrono::high_resolution_clock::now();
+		struct HashMap hashMap;
+		HashmapInit(&hashMap, 16, sizeof(int));
+		for (int i = 0; i < numKeys; i++)
+		{
+			HashmapInsert(&hashMap, keys[i].c_str(), &i);
+		}
+		auto t1 = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < numKeys; i++)
+		{
+			checksum += *(int*)HashmapSearch(&hashMap, keys[i].c_str());
+		}
+		auto t2 = std::chrono::high_resolution_clock::now();
+		HashmapDeInit(&hashMap);
+
+		auto t3 = std::chrono::high_resolution_clock::now();
+		unordered_map<string, int> stdMap;
+		for (int i = 0; i < numKeys; i++)
+		{
+			stdMap[keys[i]] = i;
+		}
+		auto t4 = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < numKeys; i++)
+		{
+			checksum -= stdMap.find(keys[i])->second;
+		}
+		auto t5 = std::chrono::high_resolution_clock::now();
+
+		struct LegacyHashMap legacyMap;
+		LegacyHashmapInit(&legacyMap, 16, sizeof(int));
+		for (int i = 0; i < numKeys; i++)
+		{
+			LegacyHashmapInsert(&legacyMap, keys[i].c_str(), &i);
+		}
+		auto t6 = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < numKeys; i++)
+		{
+			legacyChecksum += *(int*)LegacyHashmapSearch(&legacyMap, keys[i].c_str());
+		}
+		auto t7 = std::chrono::high_resolution_clock::now();
+		LegacyHashmapDeInit(&legacyMap);
+
+		insertMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+		searchMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+		legacyInsertMs += std::chrono::duration<double, std::milli>(t6 - t5).count();
+		legacySearchMs += std::chrono::duration<double, std::milli>(t7 - t6).count();
+		stdInsertMs += std::chrono::duration<double, std::milli>(t4 - t3).count();
+		stdSearchMs += std::chrono::duration<double, std::milli>(t5 - t4).count();
+	}
+	ASSERT_EQ(checksum, 0);
+	(void)legacyChecksum;
+	printf("%i keys, mean of %i runs:\n", numKeys, numRuns);
+	printf("    HashMap insert:            %.2f ms\n", insertMs / numRuns);
+	printf("    HashMap search:            %.2f ms\n", searchMs / numRuns);
+	printf("    legacy HashMap insert:     %.2f ms\n", legacyInsertMs / numRuns);
+	printf("    legacy HashMap search:     %.2f ms\n", legacySearchMs / numRuns);
+	printf("    std::unordered_map insert: %.2f ms\n", stdInsertMs / numRuns);
+	printf("    std::unordered_map search: %.2f ms\n", stdSearchMs / numRuns);
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef TEST_DATA_H
+#define TEST_DATA_H
+
+/*
+    enginetest/data is copied next to StardewEngineTest by Build_Internal.sh, so tests that
+    read files have to be run from there. Paths are string literals so they can be pasted
+    into other literals, e.g. TEST_DATA_PATH("Image/example.png").
+*/
+#define TEST_DATA_DIR "./data/"
+#define TEST_DATA_PATH(relativePath) TEST_DATA_DIR relativePath
+
+/* the image registry and the image it lists that the atlas and tilemap tests pack */
+#define TEST_DATA_REGISTRY_PATH TEST_DATA_PATH("ImageFiles.json")
+#define TEST_DATA_IMAGE_PATH TEST_DATA_PATH("Image/example.png")
+
+#endif
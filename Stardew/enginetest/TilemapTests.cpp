@@ -0,0 +1,494 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "DynArray.h"
+#include "BinarySerializer.h"
+#include "NullDrawContext.h"
+#include "TilemapChunks.h"
+#include "TestData.h"
+#include "Game2DLayerIncludes.h"
+extern "C" {
+#include "Atlas.h"
+#include "ImageFileRegstry.h"
+}
+
+/* a copy of Assets/Saves/Dev/Farm.tilemap, its tile layers are LZ4, RLE and LZ4 */
+#define TEST_TILEMAP_PATH TEST_DATA_PATH("Farm.tilemap")
+#define TEST_TILEMAP_NUM_TILE_LAYERS 3
+#define TEST_TILESET_SIZE 4
+#define TEST_TILE_SIZE_PX 16
+
+static DrawContext gTestDC;
+
+static hAtlas GetTestTilesetAtlas()
+{
+    static bool bAttempted = false;
+    static hAtlas atlas = NULL_HANDLE;
+    if (bAttempted)
+    {
+        return atlas;
+    }
+    bAttempted = true;
+    FILE* pFile = fopen(TEST_DATA_IMAGE_PATH, "rb");
+    if (!pFile)
+    {
+        return NULL_HANDLE;
+    }
+    fclose(pFile);
+
+    gTestDC = Dr_InitNullDrawContext();
+    At_Init();
+    IR_InitImageRegistry(TEST_DATA_REGISTRY_PATH);
+    At_BeginAtlas();
+    At_BeginTileset(0);
+    for (int i = 0; i < TEST_TILESET_SIZE; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "test_tile_%i", i);
+        At_AddSprite(TEST_DATA_IMAGE_PATH, (i % 2) * TEST_TILE_SIZE_PX, (i / 2) * TEST_TILE_SIZE_PX, TEST_TILE_SIZE_PX, TEST_TILE_SIZE_PX, name);
+    }
+    At_EndTileset(TEST_TILESET_SIZE);
+    atlas = At_EndAtlas(&gTestDC);
+    return atlas;
+}
+
+static void InitTestTileLayer(struct TileMapLayer* pLayer, std::vector<TileIndex>& tiles, int width, int height)
+{
+    memset(pLayer, 0, sizeof(struct TileMapLayer));
+    pLayer->transform.scale[0] = 1.0f;
+    pLayer->transform.scale[1] = 1.0f;
+    pLayer->transform.position[0] = 100.0f;
+    pLayer->transform.position[1] = -48.0f;
+    pLayer->tileWidthPx = TEST_TILE_SIZE_PX;
+    pLayer->tileHeightPx = TEST_TILE_SIZE_PX;
+    pLayer->widthTiles = width;
+    pLayer->heightTiles = height;
+    tiles.resize(width * height);
+    srand(12345);
+    for (TileIndex& tile : tiles)
+    {
+        tile = (TileIndex)(rand() % (TEST_TILESET_SIZE + 1));
+    }
+    pLayer->Tiles = tiles.data();
+}
+
+static int CountLayerTiles(const struct TileMapLayer* pLayer, int startCol, int endCol, int startRow, int endRow)
+{
+    int numTiles = 0;
+    for (int row = startRow; row < endRow; row++)
+    {
+        for (int col = startCol; col < endCol; col++)
+        {
+            numTiles += pLayer->Tiles[row * pLayer->widthTiles + col] != 0;
+        }
+    }
+    return numTiles;
+}
+
+TEST(Tilemap, UVTableMatchesTileVertices)
+{
+    hAtlas atlas = GetTestTilesetAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't find " TEST_DATA_IMAGE_PATH;
+    /* not a multiple of the chunk size */
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitTestTileLayer(&layer, tiles, 41, 35);
+
+    std::vector<float> uvTable(TILEMAP_UV_TABLE_MAX_TILES * 4);
+    ASSERT_EQ(TilemapLayer_BuildUVTable(atlas, TEST_TILE_SIZE_PX, TEST_TILE_SIZE_PX, uvTable.data()), TEST_TILESET_SIZE + 1);
+
+    VECTOR(Worldspace2DVert) pVerts = NEW_VECTOR(Worldspace2DVert);
+    VECTOR(VertIndexT) pInds = NEW_VECTOR(VertIndexT);
+    VertIndexT nextIndex = 0;
+    vec2 viewportTL = { 0.0f, 0.0f };
+    vec2 viewportBR = { 41.0f * TEST_TILE_SIZE_PX, 35.0f * TEST_TILE_SIZE_PX };
+    OutputTilemapLayerVertices(atlas, &layer, &pVerts, &pInds, &nextIndex, viewportTL, viewportBR);
+
+    /* what Tilemap.vert does for each of a tiles six vertices */
+    const int corners[6][2] = { {0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1} };
+    u32 onIndex = 0;
+    for (int row = 0; row < layer.heightTiles; row++)
+    {
+        for (int col = 0; col < layer.widthTiles; col++)
+        {
+            TileIndex tile = tiles[row * layer.widthTiles + col];
+            if (tile == 0)
+            {
+                continue;
+            }
+            const float* pUV = &uvTable[tile * 4];
+            for (int v = 0; v < 6; v++)
+            {
+                ASSERT_LT(onIndex, VectorSize(pInds));
+                const Worldspace2DVert& vert = pVerts[pInds[onIndex++]];
+                float x = layer.transform.position[0] + (col + corners[v][0]) * (float)layer.tileWidthPx;
+                float y = layer.transform.position[1] + (row + corners[v][1]) * (float)layer.tileHeightPx;
+                float u = corners[v][0] ? pUV[2] : pUV[0];
+                float uvV = corners[v][1] ? pUV[3] : pUV[1];
+                ASSERT_FLOAT_EQ(vert.x, x);
+                ASSERT_FLOAT_EQ(vert.y, y);
+                ASSERT_FLOAT_EQ(vert.u, u);
+                ASSERT_FLOAT_EQ(vert.v, uvV);
+            }
+        }
+    }
+    ASSERT_EQ(onIndex, VectorSize(pInds));
+    DestoryVector(pVerts);
+    DestoryVector(pInds);
+}
+
+TEST(Tilemap, UVTableRejectsMismatchedTileSize)
+{
+    hAtlas atlas = GetTestTilesetAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't find " TEST_DATA_IMAGE_PATH;
+    std::vector<float> uvTable(TILEMAP_UV_TABLE_MAX_TILES * 4, 1.0f);
+    ASSERT_EQ(TilemapLayer_BuildUVTable(atlas, TEST_TILE_SIZE_PX, TEST_TILE_SIZE_PX, uvTable.data()), TEST_TILESET_SIZE + 1);
+    /* the empty tile */
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(uvTable[i], 0.0f);
+    }
+    ASSERT_EQ(TilemapLayer_BuildUVTable(atlas, TEST_TILE_SIZE_PX * 2, TEST_TILE_SIZE_PX, uvTable.data()), 0);
+}
+
+TEST(Tilemap, VertexPulledTileEditIsOneTexelWrite)
+{
+    hAtlas atlas = GetTestTilesetAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't find " TEST_DATA_IMAGE_PATH;
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitTestTileLayer(&layer, tiles, 64, 64);
+    TilemapLayer_BuildChunks(&layer, atlas, &gTestDC);
+    ASSERT_TRUE(layer.pRenderData->bVertexPulled);
+    Dr_NullDrawContextEndFrame();
+
+    tiles[5 * 64 + 7] = 0;
+    TilemapLayer_MarkTileDirty(&layer, 7, 5);
+    tiles[40 * 64 + 33] = 0;
+    TilemapLayer_MarkTileDirty(&layer, 33, 40);
+    TilemapLayer_RebuildDirtyChunks(&layer, atlas, &gTestDC);
+
+    /* everything in view, one draw per chunk and no vertex data */
+    vec2 viewportTL = { 0.0f, -48.0f };
+    vec2 viewportBR = { 100.0f + 64.0f * TEST_TILE_SIZE_PX, 64.0f * TEST_TILE_SIZE_PX };
+    mat4 view;
+    glm_mat4_identity(view);
+    int numTilesDrawn = TilemapLayer_DrawVisibleChunks(&layer, &gTestDC, viewportTL, viewportBR, view);
+    Dr_NullDrawContextEndFrame();
+
+    struct NullDrawStats stats = Dr_GetNullDrawStats();
+    ASSERT_EQ(stats.lastFrame.bytesUploaded, 2 * sizeof(TileIndex));
+    ASSERT_EQ(stats.lastFrame.drawCalls, 4);
+    int numTiles = 0;
+    for (TileIndex tile : tiles)
+    {
+        numTiles += tile != 0;
+    }
+    ASSERT_EQ(numTilesDrawn, numTiles);
+    TilemapLayer_DestroyChunks(&layer, &gTestDC);
+}
+
+/* a draw context without vertex pulling, so layers get a static vertex buffer per chunk */
+static DrawContext GetChunkBufferDrawContext()
+{
+    DrawContext dc = gTestDC;
+    dc.NewTileIndexTexture = NULL;
+    return dc;
+}
+
+TEST(Tilemap, ChunksOutsideViewportAreCulled)
+{
+    hAtlas atlas = GetTestTilesetAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't find " TEST_DATA_IMAGE_PATH;
+    DrawContext dc = GetChunkBufferDrawContext();
+    /* 2 x 2 chunks, all full */
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitTestTileLayer(&layer, tiles, 2 * TILEMAP_CHUNK_TILES, 2 * TILEMAP_CHUNK_TILES);
+    std::fill(tiles.begin(), tiles.end(), 1);
+    TilemapLayer_BuildChunks(&layer, atlas, &dc);
+    ASSERT_FALSE(layer.pRenderData->bVertexPulled);
+    Dr_NullDrawContextEndFrame();
+
+    const float chunkPx = (float)(TILEMAP_CHUNK_TILES * TEST_TILE_SIZE_PX);
+    const float x = layer.transform.position[0];
+    const float y = layer.transform.position[1];
+    mat4 view;
+    glm_mat4_identity(view);
+    struct
+    {
+        vec2 tl;
+        vec2 br;
+        int numChunks;
+    } viewports[] = {
+        /* inside the top left chunk */
+        { { x + 10.0f, y + 10.0f }, { x + 100.0f, y + 100.0f }, 1 },
+        /* across the right hand chunks */
+        { { x + chunkPx + 10.0f, y + 10.0f }, { x + chunkPx + 100.0f, y + chunkPx + 10.0f }, 2 },
+        /* where all four chunks meet */
+        { { x + chunkPx - 10.0f, y + chunkPx - 10.0f }, { x + chunkPx + 10.0f, y + chunkPx + 10.0f }, 4 },
+        /* above and to the left of the layer */
+        { { x - 1000.0f, y - 1000.0f }, { x - 10.0f, y - 10.0f }, 0 },
+        /* below and to the right of the layer */
+        { { x + 2 * chunkPx + 10.0f, y + 2 * chunkPx + 10.0f }, { x + 3 * chunkPx, y + 3 * chunkPx }, 0 },
+    };
+    for (const auto& viewport : viewports)
+    {
+        int numTilesDrawn = TilemapLayer_DrawVisibleChunks(&layer, &dc, (float*)viewport.tl, (float*)viewport.br, view);
+        Dr_NullDrawContextEndFrame();
+        struct NullDrawStats stats = Dr_GetNullDrawStats();
+        ASSERT_EQ(stats.lastFrame.drawCalls, (u32)viewport.numChunks);
+        ASSERT_EQ(numTilesDrawn, viewport.numChunks * TILEMAP_CHUNK_TILES * TILEMAP_CHUNK_TILES);
+        ASSERT_EQ(stats.lastFrame.bytesUploaded, 0u);
+    }
+    TilemapLayer_DestroyChunks(&layer, &dc);
+}
+
+TEST(Tilemap, SetTileRebuildsOnlyItsChunk)
+{
+    hAtlas atlas = GetTestTilesetAtlas();
+    ASSERT_NE(atlas, NULL_HANDLE) << "can't find " TEST_DATA_IMAGE_PATH;
+    DrawContext dc = GetChunkBufferDrawContext();
+    struct GameLayer2DData data;
+    memset(&data, 0, sizeof(struct GameLayer2DData));
+    data.tilemap.layers = (struct TileMapLayer*)NEW_VECTOR(struct TileMapLayer);
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitTestTileLayer(&layer, tiles, 2 * TILEMAP_CHUNK_TILES, 2 * TILEMAP_CHUNK_TILES);
+    data.tilemap.layers = (struct TileMapLayer*)VectorPush(data.tilemap.layers, &layer);
+    struct TileMapLayer* pLayer = &data.tilemap.layers[0];
+    TilemapLayer_BuildChunks(pLayer, atlas, &dc);
+    struct TilemapLayerRenderData* pRenderData = pLayer->pRenderData;
+    ASSERT_FALSE(pRenderData->bVertexPulled);
+    Dr_NullDrawContextEndFrame();
+
+    /* a tile in the top right chunk */
+    const int col = TILEMAP_CHUNK_TILES + 3;
+    const int row = 5;
+    const int changedChunk = 1;
+    TileIndex oldTile = tiles[row * pLayer->widthTiles + col];
+    Game2DLayer_SetTile(&data, 0, col, row, oldTile);
+    ASSERT_EQ(pRenderData->numDirtyChunks, 0);
+
+    std::vector<struct TilemapChunk> chunksBefore(pRenderData->pChunks, pRenderData->pChunks + 4);
+    TileIndex newTile = oldTile == 0 ? 1 : 0;
+    Game2DLayer_SetTile(&data, 0, col, row, newTile);
+    ASSERT_EQ(Game2DLayer_GetTile(&data, 0, col, row), newTile);
+    ASSERT_EQ(pRenderData->numDirtyChunks, 1);
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(pRenderData->pChunks[i].bDirty, i == changedChunk);
+    }
+    /* a second edit to the same chunk doesn't count it twice */
+    TileIndex neighbour = Game2DLayer_GetTile(&data, 0, col + 1, row);
+    Game2DLayer_SetTile(&data, 0, col + 1, row, neighbour == 2 ? 3 : 2);
+    ASSERT_EQ(pRenderData->numDirtyChunks, 1);
+
+    TilemapLayer_RebuildDirtyChunks(pLayer, atlas, &dc);
+    Dr_NullDrawContextEndFrame();
+    ASSERT_EQ(pRenderData->numDirtyChunks, 0);
+    const struct TilemapChunk* pChanged = &pRenderData->pChunks[changedChunk];
+    ASSERT_FALSE(pChanged->bDirty);
+    ASSERT_EQ(pChanged->numTiles, (u32)CountLayerTiles(pLayer, TILEMAP_CHUNK_TILES, 2 * TILEMAP_CHUNK_TILES, 0, TILEMAP_CHUNK_TILES));
+    ASSERT_EQ(pChanged->numIndices, pChanged->numTiles * 6);
+    /* only the changed chunks vertices were uploaded again */
+    struct NullDrawStats stats = Dr_GetNullDrawStats();
+    ASSERT_EQ(stats.lastFrame.bytesUploaded, pChanged->numTiles * 4 * sizeof(Worldspace2DVert) + pChanged->numIndices * sizeof(VertIndexT));
+    for (int i = 0; i < 4; i++)
+    {
+        if (i == changedChunk)
+        {
+            continue;
+        }
+        ASSERT_EQ(pRenderData->pChunks[i].numTiles, chunksBefore[i].numTiles);
+        ASSERT_EQ(pRenderData->pChunks[i].numIndices, chunksBefore[i].numIndices);
+        ASSERT_EQ(pRenderData->pChunks[i].hVertexBuffer, chunksBefore[i].hVertexBuffer);
+    }
+    /* nothing left to rebuild */
+    TilemapLayer_RebuildDirtyChunks(pLayer, atlas, &dc);
+    Dr_NullDrawContextEndFrame();
+    ASSERT_EQ(Dr_GetNullDrawStats().lastFrame.bytesUploaded, 0u);
+
+    TilemapLayer_DestroyChunks(pLayer, &dc);
+    DestoryVector(data.tilemap.layers);
+}
+
+/* saves the layers tiles with TilemapLayer_SerializeTiles and loads them back, returns the compression used */
+static u32 RoundTripTiles(struct TileMapLayer* pLayer, enum TileLayerCompression compression, size_t* pOutSize)
+{
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    TilemapLayer_SerializeTiles(pLayer, compression, &bs);
+    size_t size = 0;
+    const char* pData = BS_GetSavedData(&bs, &size);
+    std::vector<char> saved(pData, pData + size);
+    EXPECT_TRUE(BS_Finish(&bs));
+    *pOutSize = size - sizeof(u32);
+
+    u32 savedCompression = 0;
+    memcpy(&savedCompression, saved.data(), sizeof(u32));
+    struct TileMapLayer loaded;
+    memset(&loaded, 0, sizeof(struct TileMapLayer));
+    loaded.widthTiles = pLayer->widthTiles;
+    loaded.heightTiles = pLayer->heightTiles;
+    BS_CreateForLoadFromMemory(saved.data(), saved.size(), &bs);
+    EXPECT_TRUE(TilemapLayer_DeserializeTiles(&loaded, &bs));
+    EXPECT_EQ(BS_BytesRemaining(&bs), 0u);
+    EXPECT_TRUE(BS_Finish(&bs));
+    EXPECT_EQ(memcmp(loaded.Tiles, pLayer->Tiles, pLayer->widthTiles * pLayer->heightTiles * sizeof(TileIndex)), 0);
+    free(loaded.Tiles);
+    return savedCompression;
+}
+
+TEST(Tilemap, TileLayerCompressionRoundTrips)
+{
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    InitTestTileLayer(&layer, tiles, 100, 100);
+    /* some runs amongst the noise */
+    for (int i = 2000; i < 6000; i++)
+    {
+        tiles[i] = i < 4000 ? 0 : 3;
+    }
+    const enum TileLayerCompression compressions[] = { TLC_RLE, TLC_Uncompressed, TLC_LZ4, TLC_Smallest };
+    for (enum TileLayerCompression compression : compressions)
+    {
+        size_t size = 0;
+        u32 saved = RoundTripTiles(&layer, compression, &size);
+        if (compression != TLC_Smallest)
+        {
+            ASSERT_EQ(saved, (u32)compression);
+        }
+    }
+
+    /* a run longer than an RLE run can be */
+    InitTestTileLayer(&layer, tiles, 300, 300);
+    std::fill(tiles.begin(), tiles.end(), 1);
+    size_t size = 0;
+    ASSERT_EQ(RoundTripTiles(&layer, TLC_RLE, &size), (u32)TLC_RLE);
+    ASSERT_EQ(size, 3 * 2 * sizeof(u16));
+}
+
+TEST(Tilemap, SmallestTileLayerCompressionIsPicked)
+{
+    struct TileMapLayer layer;
+    std::vector<TileIndex> tiles;
+    size_t size = 0;
+
+    /* noise doesn't compress */
+    InitTestTileLayer(&layer, tiles, 64, 64);
+    for (TileIndex& tile : tiles)
+    {
+        tile = (TileIndex)rand();
+    }
+    ASSERT_EQ(RoundTripTiles(&layer, TLC_Smallest, &size), (u32)TLC_Uncompressed);
+
+    /* long runs are best as RLE */
+    InitTestTileLayer(&layer, tiles, 64, 64);
+    std::fill(tiles.begin(), tiles.end(), 0);
+    std::fill(tiles.begin() + 1000, tiles.begin() + 3000, 2);
+    ASSERT_EQ(RoundTripTiles(&layer, TLC_Smallest, &size), (u32)TLC_RLE);
+
+    /* a repeating pattern has no runs but LZ4 finds it */
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        tiles[i] = (TileIndex)(i % 3 + 1);
+    }
+    ASSERT_EQ(RoundTripTiles(&layer, TLC_Smallest, &size), (u32)TLC_LZ4);
+    ASSERT_LT(size, tiles.size());
+}
+
+TEST(Tilemap, MalformedTileLayerIsEmpty)
+{
+    struct TileMapLayer layer;
+    memset(&layer, 0, sizeof(struct TileMapLayer));
+    layer.widthTiles = 4;
+    layer.heightTiles = 4;
+
+    /* runs add up to more tiles than the layer has */
+    struct BinarySerializer bs;
+    BS_CreateForSaveToMemory(&bs);
+    BS_SerializeU32(TLC_RLE, &bs);
+    BS_SerializeU16(10, &bs);
+    BS_SerializeU16(1, &bs);
+    BS_SerializeU16(10, &bs);
+    BS_SerializeU16(1, &bs);
+    BS_SerializeU16(0, &bs);
+    BS_SerializeU16(0, &bs);
+    size_t size = 0;
+    const char* pData = BS_GetSavedData(&bs, &size);
+    std::vector<char> overflowingRuns(pData, pData + size);
+    BS_Finish(&bs);
+
+    BS_CreateForLoadFromMemory(overflowingRuns.data(), overflowingRuns.size(), &bs);
+    ASSERT_FALSE(TilemapLayer_DeserializeTiles(&layer, &bs));
+    BS_Finish(&bs);
+    for (int i = 0; i < 16; i++)
+    {
+        ASSERT_EQ(layer.Tiles[i], 0);
+    }
+    free(layer.Tiles);
+
+    /* LZ4 block cut short */
+    std::vector<TileIndex> tiles(16, 5);
+    layer.Tiles = tiles.data();
+    BS_CreateForSaveToMemory(&bs);
+    TilemapLayer_SerializeTiles(&layer, TLC_LZ4, &bs);
+    pData = BS_GetSavedData(&bs, &size);
+    std::vector<char> truncated(pData, pData + size - 1);
+    BS_Finish(&bs);
+
+    BS_CreateForLoadFromMemory(truncated.data(), truncated.size(), &bs);
+    ASSERT_FALSE(TilemapLayer_DeserializeTiles(&layer, &bs));
+    BS_Finish(&bs);
+    for (int i = 0; i < 16; i++)
+    {
+        ASSERT_EQ(layer.Tiles[i], 0);
+    }
+    free(layer.Tiles);
+}
+
+TEST(Tilemap, ConvertedTilemapTileLayersDecode)
+{
+    /* the tile layers at the start of a file written by engine/scripts/ConvertTiled.py */
+    struct BinarySerializer bs;
+    FILE* pFile = fopen(TEST_TILEMAP_PATH, "rb");
+    ASSERT_NE(pFile, nullptr) << "can't find " TEST_TILEMAP_PATH;
+    fclose(pFile);
+    BS_CreateForLoad(TEST_TILEMAP_PATH, &bs);
+    u32 version = 0, numLayers = 0, type = 0;
+    float quadTreeTLBR[4];
+    BS_DeSerializeU32(&version, &bs);
+    ASSERT_EQ(version, 1u);
+    BS_DeSerializeF32Array(quadTreeTLBR, 4, &bs);
+    BS_DeSerializeU32(&numLayers, &bs);
+    int numTileLayers = 0;
+    for (u32 i = 0; i < numLayers; i++)
+    {
+        BS_DeSerializeU32(&type, &bs);
+        if (type != 1)
+        {
+            /* object layers need the games entity types to load */
+            break;
+        }
+        u32 header[6];
+        BS_DeSerializeU32Array(header, 6, &bs);
+        struct TileMapLayer layer;
+        memset(&layer, 0, sizeof(struct TileMapLayer));
+        layer.widthTiles = header[0];
+        layer.heightTiles = header[1];
+        ASSERT_TRUE(TilemapLayer_DeserializeTiles(&layer, &bs));
+        int numTiles = 0;
+        for (int j = 0; j < layer.widthTiles * layer.heightTiles; j++)
+        {
+            numTiles += layer.Tiles[j] != 0;
+        }
+        ASSERT_GT(numTiles, 0);
+        free(layer.Tiles);
+        numTileLayers++;
+    }
+    ASSERT_EQ(numTileLayers, TEST_TILEMAP_NUM_TILE_LAYERS);
+    BS_Finish(&bs);
+}
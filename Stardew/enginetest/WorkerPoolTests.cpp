@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "WorkerPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static void AddOne(void* pArg)
+{
+    ((std::atomic<int>*)pArg)->fetch_add(1);
+}
+
+static void Square(void* pArg)
+{
+    int* pVal = (int*)pArg;
+    *pVal = *pVal * *pVal;
+}
+
+TEST(WorkerPool, RunsEverySubmittedJob)
+{
+    for (int numThreads = 1; numThreads <= 4; numThreads++)
+    {
+        struct WorkerPool* pPool = WP_Create(numThreads);
+        ASSERT_EQ(WP_GetNumThreads(pPool), numThreads);
+        std::atomic<int> count(0);
+        /* more than the initial queue capacity so it has to grow */
+        for (int i = 0; i < 1000; i++)
+        {
+            WP_Submit(pPool, &AddOne, &count);
+        }
+        WP_WaitIdle(pPool);
+        ASSERT_EQ(count.load(), 1000);
+        WP_Destroy(pPool);
+    }
+}
+
+TEST(WorkerPool, JobsWriteTheirOwnResults)
+{
+    struct WorkerPool* pPool = WP_Create(3);
+    std::vector<int> vals(256);
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < (int)vals.size(); i++)
+        {
+            vals[i] = i;
+            WP_Submit(pPool, &Square, &vals[i]);
+        }
+        WP_WaitIdle(pPool);
+        for (int i = 0; i < (int)vals.size(); i++)
+        {
+            ASSERT_EQ(vals[i], i * i);
+        }
+    }
+    WP_Destroy(pPool);
+}
+
+TEST(WorkerPool, WaitIdleWithNoJobsReturns)
+{
+    struct WorkerPool* pPool = WP_Create(0);
+    ASSERT_EQ(WP_GetNumThreads(pPool), WP_GetNumCPUs());
+    WP_WaitIdle(pPool);
+    WP_WaitIdle(pPool);
+    WP_Destroy(pPool);
+}
+
+TEST(WorkerPool, DestroyFinishesQueuedJobs)
+{
+    struct WorkerPool* pPool = WP_Create(2);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 100; i++)
+    {
+        WP_Submit(pPool, &AddOne, &count);
+    }
+    WP_Destroy(pPool);
+    ASSERT_EQ(count.load(), 100);
+}
+
+struct CompletionRecord
+{
+    int val = 0;
+    bool bCompleted = false;
+    std::thread::id completedOn;
+};
+
+static void Double(void* pArg)
+{
+    ((CompletionRecord*)pArg)->val *= 2;
+}
+
+static void MarkCompleted(void* pArg)
+{
+    CompletionRecord* pRecord = (CompletionRecord*)pArg;
+    pRecord->bCompleted = true;
+    pRecord->completedOn = std::this_thread::get_id();
+}
+
+TEST(WorkerPool, RunsCompletionsOnTheCallingThread)
+{
+    for (int numThreads = 1; numThreads <= 3; numThreads++)
+    {
+        struct WorkerPool* pPool = WP_Create(numThreads);
+        std::vector<CompletionRecord> records(100);
+        for (int i = 0; i < (int)records.size(); i++)
+        {
+            records[i].val = i;
+            WP_SubmitWithCompletion(pPool, &Double, &MarkCompleted, &records[i]);
+        }
+        WP_WaitIdle(pPool);
+        for (const CompletionRecord& record : records)
+        {
+            ASSERT_FALSE(record.bCompleted);
+        }
+        ASSERT_EQ(WP_RunCompleted(pPool), (int)records.size());
+        ASSERT_EQ(WP_RunCompleted(pPool), 0);
+        for (int i = 0; i < (int)records.size(); i++)
+        {
+            ASSERT_EQ(records[i].val, i * 2);
+            ASSERT_TRUE(records[i].bCompleted);
+            ASSERT_EQ(records[i].completedOn, std::this_thread::get_id());
+        }
+        WP_Destroy(pPool);
+    }
+}
+
+TEST(WorkerPool, WaitCompletedReturnsOnceAJobIsDone)
+{
+    struct WorkerPool* pPool = WP_Create(2);
+    WP_WaitCompleted(pPool);
+    CompletionRecord record;
+    record.val = 21;
+    WP_SubmitWithCompletion(pPool, &Double, &MarkCompleted, &record);
+    WP_WaitCompleted(pPool);
+    ASSERT_EQ(WP_RunCompleted(pPool), 1);
+    ASSERT_EQ(record.val, 42);
+    WP_Destroy(pPool);
+}
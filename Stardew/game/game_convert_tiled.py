@@ -15,20 +15,20 @@ from ConvertTiled import main, register_entity_serializer, get_tiled_object_cust
 
 def serialize_string(file, string):
     print(f"SERIALIZING STRING {string}")
-    file.write(struct.pack("I", len(string)))
+    file.write(struct.pack("<I", len(string)))
     for c in string:
         print(c.encode())
-        file.write(struct.pack("c", c.encode()))
+        file.write(struct.pack("<c", c.encode()))
 
 ########################################### wooded area
 
 def serialize_WoodedArea(file, obj):
-    file.write(struct.pack("I", 1)) # version
-    file.write(struct.pack("f", get_tiled_object_custom_prop(obj, "ConiferousPercentage")["value"]))
-    file.write(struct.pack("f", get_tiled_object_custom_prop(obj, "DeciduousPercentage")["value"]))
-    file.write(struct.pack("f", get_tiled_object_custom_prop(obj, "PerMeterDensity")["value"]))
-    file.write(struct.pack("f", obj["width"]))
-    file.write(struct.pack("f", obj["height"]))
+    file.write(struct.pack("<I", 1)) # version
+    file.write(struct.pack("<f", get_tiled_object_custom_prop(obj, "ConiferousPercentage")["value"]))
+    file.write(struct.pack("<f", get_tiled_object_custom_prop(obj, "DeciduousPercentage")["value"]))
+    file.write(struct.pack("<f", get_tiled_object_custom_prop(obj, "PerMeterDensity")["value"]))
+    file.write(struct.pack("<f", obj["width"]))
+    file.write(struct.pack("<f", obj["height"]))
 
 def get_type_WoodedArea(obj):
     return 6
@@ -36,7 +36,7 @@ def get_type_WoodedArea(obj):
 ########################################### player start
 
 def serialize_PlayerStart(file, obj):
-    file.write(struct.pack("I", 1)) # version
+    file.write(struct.pack("<I", 1)) # version
     stringVal = get_tiled_object_custom_prop(obj, "from")["value"]
     serialize_string(file, stringVal)
     stringVal = get_tiled_object_custom_prop(obj, "thisLocation")["value"]
@@ -48,9 +48,9 @@ def get_type_PlayerStart(obj):
 ########################################### exit
 
 def serialize_Exit(file, obj):
-    file.write(struct.pack("I", 1)) # version
-    file.write(struct.pack("f", obj["width"]))
-    file.write(struct.pack("f", obj["height"]))
+    file.write(struct.pack("<I", 1)) # version
+    file.write(struct.pack("<f", obj["width"]))
+    file.write(struct.pack("<f", obj["height"]))
     stringVal = get_tiled_object_custom_prop(obj, "to")["value"]
     serialize_string(file, stringVal)
 
@@ -1,6 +1,12 @@
 #ifndef WF_INIT_H
 #define WF_INIT_H
 
+/* initialises the engine systems the game uses */
+void WfEngineInit();
+
+/* as WfEngineInit, but seeds the random number generator with a fixed seed so runs repeat */
+void WfEngineInitSeeded(unsigned int seed);
+
 void WfInit();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "main.h"
+#include "WfInit.h"
+#include "WfGame.h"
+#include "WfGameLayer.h"
+#include "WfItem.h"
+#include "WfHUD.h"
+#include "DynArray.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+	StardewBench - runs a level and the HUD for a fixed number of frames without a window
+	and reports the CPU time spent updating and drawing per frame.
+
+	usage: StardewBench [numFrames] [tilemapFile] [seed]
+
+	The random number generator gets a fixed seed rather than the time so runs can be
+	compared against each other.
+*/
+
+#define BENCH_DEFAULT_NUM_FRAMES 600
+#define BENCH_DEFAULT_TILEMAP "./Assets/out/Farm.tilemap"
+#define BENCH_DEFAULT_SEED 1
+
+static const char* gTilemapPath = BENCH_DEFAULT_TILEMAP;
+static unsigned int gSeed = BENCH_DEFAULT_SEED;
+
+static void BenchInit(InputContext* pIC, DrawContext* pDC)
+{
+    WfGameInit();
+    WfEngineInitSeeded(gSeed);
+    WfInit();
+    WfRegisterItemScriptFunctions();
+    VECTOR(struct WfGameSave) pSaves = WfGameGetSaves();
+    WfSetCurrentSaveGame(&pSaves[0]);
+    WfPushGameLayer(pDC, gTilemapPath);
+    WfPushHUD(pDC);
+}
+
+int main(int argc, char** argv)
+{
+    int numFrames = BENCH_DEFAULT_NUM_FRAMES;
+    if (argc > 1)
+    {
+        numFrames = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        gTilemapPath = argv[2];
+    }
+    if (argc > 3)
+    {
+        gSeed = (unsigned int)strtoul(argv[3], NULL, 10);
+    }
+
+    struct HeadlessRunStats stats;
+    EngineStartHeadless(numFrames, &BenchInit, &stats);
+    if (stats.numFrames == 0)
+    {
+        printf("no frames run\n");
+        return 1;
+    }
+
+    const struct NullDrawStats* pDraw = &stats.drawStats;
+    printf("\nStardewBench: %s, %i frames, seed %u\n", gTilemapPath, stats.numFrames, gSeed);
+    printf("    init:                 %.2f ms\n", stats.initMs);
+    printf("    update per frame:     %.3f ms mean, %.3f ms max\n", stats.updateMsTotal / stats.numFrames, stats.updateMsMax);
+    printf("    draw per frame:       %.3f ms mean, %.3f ms max\n", stats.drawMsTotal / stats.numFrames, stats.drawMsMax);
+    printf("    draw calls per frame: %.1f\n", (double)stats.drawTotals.drawCalls / stats.numFrames);
+    printf("    vertices per frame:   %.1f\n", (double)stats.drawTotals.verticesDrawn / stats.numFrames);
+    printf("    uploaded per frame:   %.1f KB\n", (double)stats.drawTotals.bytesUploaded / 1024.0 / stats.numFrames);
+    printf("    live buffers:         %u (%.1f KB)\n", pDraw->numLiveBuffers, (double)pDraw->liveBufferBytes / 1024.0);
+    return 0;
+}
@@ -15,6 +15,8 @@
 #include "GameFrameworkEvent.h"
 #include "WfPersistantGameData.h"
 
+static HEvent gInventoryChangedEvent = NULL_HEVENT;
+
 static void WfPublishInventoryChangedEvent()
 {
     struct WfInventory* pInv = WfGetInventory();
@@ -35,7 +37,7 @@ static void WfPublishInventoryChangedEvent()
 
     arg.val.table = tableRef;
     struct LuaListenedEventArgs args = { .numArgs = 1, .args = &arg };
-    Ev_FireEvent("InventoryChanged", &args);
+    Ev_FireEventById(gInventoryChangedEvent, &args);
     Sc_UnRefTable(tableRef);
 	
 
@@ -54,6 +56,7 @@ void WfGameLayerOnPush(struct GameFrameworkLayer* pLayer, DrawContext* drawConte
     GameLayer2D_OnPush(pLayer, drawContext, inputContext);
     struct WfGameLayerData* pWfData = pEngineLayer->pUserData;
     pWfData->HUDPushedEventListener = Ev_SubscribeEvent("onHUDLayerPushed", &WfOnHUDLayerPushed, pLayer);
+    gInventoryChangedEvent = Ev_RegisterEventName("InventoryChanged");
 }
 
 void WfPreFirstInit(struct GameLayer2DData* pEngineLayer)
@@ -79,6 +82,7 @@ void WfPushGameLayer(DrawContext* pDC, const char* lvlFilePath)
     memset(&options, 0, sizeof(struct Game2DLayerOptions));
     options.atlasFilePath = "./Assets/out/main.atlas";
     options.levelFilePath = lvlFilePath;
+    options.bUseComponentStore = true;
     Game2DLayer_Get(&testLayer, &options, pDC);
     testLayer.onPush = &WfGameLayerOnPush;
     testLayer.onPop = &WfGameLayerOnPop;
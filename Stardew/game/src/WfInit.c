@@ -6,6 +6,33 @@
 #include "WfExit.h"
 #include "WfItem.h"
 #include "WfPersistantGameData.h"
+#include "WfEntities.h"
+#include "Entities.h"
+#include "EntityQuadTree.h"
+#include "Physics2D.h"
+#include "Random.h"
+#include <stdio.h>
+
+static void EngineSystemsInit()
+{
+    Ph_Init();
+    InitEntity2DQuadtreeSystem();
+    Et2D_Init(&WfRegisterEntityTypes);
+}
+
+void WfEngineInit()
+{
+    unsigned int seed = Ra_SeedFromTime();
+    printf("seed: %u\n", seed);
+    EngineSystemsInit();
+}
+
+void WfEngineInitSeeded(unsigned int seed)
+{
+    Ra_Seed(seed);
+    printf("seed: %u\n", seed);
+    EngineSystemsInit();
+}
 
 void WfInit()
 {
@@ -9,6 +9,7 @@
 #include "AnimatedSprite.h"
 #include "Camera2D.h"
 #include "WfEntities.h"
+#include "StringKeyHashMap.h"
 #include <string.h>
 
 #define WALKING_UP_MALE "walk-base-male-up"
@@ -49,9 +50,19 @@ struct WfPlayerEntData
 
 static OBJECT_POOL(struct WfPlayerEntData) gPlayerEntDataPool = NULL;
 
+/* the walk animation is set every frame, so hash the names once */
+static u32 gWalkingUpMaleHash;
+static u32 gWalkingDownMaleHash;
+static u32 gWalkingLeftMaleHash;
+static u32 gWalkingRightMaleHash;
+
 void WfInitPlayer()
 {
     gPlayerEntDataPool = NEW_OBJECT_POOL(struct WfPlayerEntData, 4);
+    gWalkingUpMaleHash = HashmapHashKey(WALKING_UP_MALE);
+    gWalkingDownMaleHash = HashmapHashKey(WALKING_DOWN_MALE);
+    gWalkingLeftMaleHash = HashmapHashKey(WALKING_LEFT_MALE);
+    gWalkingRightMaleHash = HashmapHashKey(WALKING_RIGHT_MALE);
 }
 
 static void OnInitPlayer(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer, DrawContext* pDrawCtx, InputContext* pInputCtx)
@@ -88,29 +99,30 @@ static void SetPlayerAnimation(struct GameFrameworkLayer* pLayer, struct WfPlaye
     if(!pPlayerEntData->bMovingThisFrame && pPlayerEntData->bMovingLastFrame)
     {
         pSprite->onSprite = 0;
+        Et2D_MarkBoundingBoxDirty(pEnt);
     }
     if(pPlayerEntData->movementVector[1] > 1e-5f)
     {
         // moving down
-        AnimatedSprite_SetAnimation(pLayer, pSprite, WALKING_DOWN_MALE, false, false);
+        AnimatedSprite_SetAnimationHashed(pLayer, pEnt, pSprite, WALKING_DOWN_MALE, gWalkingDownMaleHash, false, false);
         pSprite->fps *= pPlayerEntData->speedMultiplier;
     }
     else if(pPlayerEntData->movementVector[1] < -1e-5f)
     {
         // moving up
-        AnimatedSprite_SetAnimation(pLayer, pSprite, WALKING_UP_MALE, false, false);
+        AnimatedSprite_SetAnimationHashed(pLayer, pEnt, pSprite, WALKING_UP_MALE, gWalkingUpMaleHash, false, false);
         pSprite->fps *= pPlayerEntData->speedMultiplier;
     }
     else if(pPlayerEntData->movementVector[0] > 1e-5f)
     {
         // moving right
-        AnimatedSprite_SetAnimation(pLayer, pSprite, WALKING_RIGHT_MALE, false, false);
+        AnimatedSprite_SetAnimationHashed(pLayer, pEnt, pSprite, WALKING_RIGHT_MALE, gWalkingRightMaleHash, false, false);
         pSprite->fps *= pPlayerEntData->speedMultiplier;
     }
     else if(pPlayerEntData->movementVector[0] < -1e-5f)
     {
         // moving left
-        AnimatedSprite_SetAnimation(pLayer, pSprite, WALKING_LEFT_MALE, false, false);
+        AnimatedSprite_SetAnimationHashed(pLayer, pEnt, pSprite, WALKING_LEFT_MALE, gWalkingLeftMaleHash, false, false);
         pSprite->fps *= pPlayerEntData->speedMultiplier;
     }
 }
@@ -188,6 +200,7 @@ void WfPlayerPostPhys(struct Entity2D* pEnt, struct GameFrameworkLayer* pLayer,
     Ph_GetDymaicBodyPosition(pCollider->id, physPos);
     Ph_PhysicsCoords2PixelCoords(pLayerData->hPhysicsWorld, physPos, pixelsPos);
     glm_vec2_add(pixelsPos, pPlayerEntData->groundColliderCenter2EntTransform, pEnt->transform.position);
+    Et2D_BroadphaseMove(pLayer, pEnt);
 
     CenterCameraAt(pixelsPos[0], pixelsPos[1], &pLayerData->camera, pLayerData->windowW, pLayerData->windowH);
 }
@@ -241,7 +254,7 @@ void WfMakeIntoPlayerEntity(struct Entity2D* pEnt, struct GameLayer2DData* pData
     pEnt->getSortPos = &WfGetPlayerSortPosition;
     pEnt->postPhys = &WfPlayerPostPhys;
     pEnt->input = &OnInputPlayer;
-    pEnt->bKeepInQuadtree = false;
-    pEnt->bKeepInDynamicList = true;
+    pEnt->bKeepInQuadtree = true;
+    pEnt->bKeepInDynamicList = false;
     pEnt->bSerialize = false;
 }
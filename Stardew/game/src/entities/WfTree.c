@@ -6,6 +6,7 @@
 #include "Atlas.h"
 #include "WfGameLayerData.h"
 #include "WfEntities.h"
+#include "PagedObjectPool.h"
 
 struct WfTreeEntityData
 {
@@ -13,11 +14,11 @@ struct WfTreeEntityData
     vec2 groundContactPoint;
 };
 
-static OBJECT_POOL(struct WfTreeEntityData) gTreeDataObjectPool;
+static PAGED_OBJECT_POOL(struct WfTreeEntityData) gTreeDataObjectPool;
 
 void WfTreeInit()
 {
-    gTreeDataObjectPool = NEW_OBJECT_POOL(struct WfTreeEntityData, 512);
+    gTreeDataObjectPool = NEW_PAGED_OBJECT_POOL(struct WfTreeEntityData, PAGED_OBJECT_POOL_DEFAULT_BLOCK_SHIFT);
 }
 
 void WfDeSerializeTreeEntity(struct BinarySerializer* bs, struct Entity2D* pOutEnt, struct GameLayer2DData* pData)
@@ -48,13 +49,13 @@ void WfDeSerializeTreeEntity(struct BinarySerializer* bs, struct Entity2D* pOutE
 
 static void TreeOnDestroy(struct Entity2D* pEnt, struct GameFrameworkLayer* pData)
 {
-    FreeObjectPoolIndex(gTreeDataObjectPool, pEnt->user.hData);
+    FreePagedObjectPoolIndex(gTreeDataObjectPool, pEnt->user.hData);
     Entity2DOnDestroy(pEnt, pData);
 }
 
 static float TreeGetPreDrawSortValue(struct Entity2D* pEnt)
 {
-    struct WfTreeEntityData* pData = &gTreeDataObjectPool[pEnt->user.hData];
+    struct WfTreeEntityData* pData = PagedObjectPoolAt(struct WfTreeEntityData, gTreeDataObjectPool, pEnt->user.hData);
     return pData->groundContactPoint[1];
 }
 
@@ -130,11 +131,11 @@ void WfMakeEntityIntoTreeBasedAt(struct Entity2D* pEnt, float x, float y, struct
     pComponent3->data.staticCollider.onSensorOverlapEnd = NULL;
     pComponent3->data.staticCollider.bGenerateSensorEvents = false;
 
-    HGeneric hTreeData = NULL_HANDLE;
-    gTreeDataObjectPool = GetObjectPoolIndex(gTreeDataObjectPool, &hTreeData);
-    gTreeDataObjectPool[hTreeData].def = *def;
-    gTreeDataObjectPool[hTreeData].groundContactPoint[0] = x;
-    gTreeDataObjectPool[hTreeData].groundContactPoint[1] = y;
+    HGeneric hTreeData = GetPagedObjectPoolIndex(gTreeDataObjectPool);
+    struct WfTreeEntityData* pTreeData = PagedObjectPoolAt(struct WfTreeEntityData, gTreeDataObjectPool, hTreeData);
+    pTreeData->def = *def;
+    pTreeData->groundContactPoint[0] = x;
+    pTreeData->groundContactPoint[1] = y;
     pEnt->user.hData = hTreeData;
     Et2D_PopulateCommonHandlers(pEnt);
     pEnt->onDestroy = &TreeOnDestroy;
@@ -143,7 +144,7 @@ void WfMakeEntityIntoTreeBasedAt(struct Entity2D* pEnt, float x, float y, struct
 
 void WfSerializeTreeEntity(struct BinarySerializer* bs, struct Entity2D* pInEnt, struct GameLayer2DData* pData)
 {
-    struct WfTreeEntityData* pEntData = &gTreeDataObjectPool[pInEnt->user.hData];
+    struct WfTreeEntityData* pEntData = PagedObjectPoolAt(struct WfTreeEntityData, gTreeDataObjectPool, pInEnt->user.hData);
     BS_SerializeU32(1, bs); // version
     BS_SerializeI32((i32)pEntData->def.season, bs);
     BS_SerializeI32((i32)pEntData->def.type, bs);
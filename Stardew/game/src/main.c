@@ -19,15 +19,6 @@
 #include "WfHUD.h"
 
 
-void WfEngineInit()
-{
-    unsigned int seed = Ra_SeedFromTime();
-    printf("seed: %u\n", seed);
-    Ph_Init();
-    InitEntity2DQuadtreeSystem();
-    Et2D_Init(&WfRegisterEntityTypes);
-}
-
 void GameInit(InputContext* pIC, DrawContext* pDC)
 {
     WfGameInit();